@@ -310,3 +310,130 @@ cmMsfRC_t cmMidiScoreFollowMain(
   
   return rc;
 }
+
+typedef struct
+{
+  const cmChar_t* label;
+  unsigned        failN;    // count of failed cmScMatcherExec() calls
+  unsigned        matchN;   // count of true positive matches
+  unsigned        scanN;    // count of resync. scans
+  double          avgNs;    // average processing time per note
+  unsigned        maxNs;    // max. processing time per note
+  unsigned*       evtIdxV;  // evtIdxV[noteN] score event index matched to each note or cmInvalidIdx
+} _cmMsf_Bench_t;
+
+cmMsfRC_t _cmMsf_BenchReplay( cmErr_t* err, cmCtx* prCtx, cmScH_t scH, double srate, const cmMidiTrackMsg_t** m, unsigned mN, unsigned noteN, bool incrFl, _cmMsf_Bench_t* b )
+{
+  cmScMatcher* smp      = NULL;
+  unsigned     scWndN   = 10;
+  unsigned     midiWndN = 7;
+  unsigned     scLocIdx = 0;
+  unsigned     i;
+
+  if((smp = cmScMatcherAlloc(prCtx, NULL, srate, scH, scWndN, midiWndN, NULL, NULL)) == NULL )
+    return cmErrMsg(err,kFailMsfRC,"cmScMatcherAlloc() failed.");
+
+  smp->incrFl = incrFl;
+  
+  for(i=0; i<mN; ++i)
+    if( (m[i]!=NULL) && cmMidiIsChStatus(m[i]->status) && cmMidiIsNoteOn(m[i]->status) && (m[i]->u.chMsgPtr->d1>0) )          
+      if( cmScMatcherExec( smp, m[i]->amicro * srate / 1000000.0, m[i]->uid, m[i]->status, m[i]->u.chMsgPtr->d0, m[i]->u.chMsgPtr->d1, &scLocIdx ) != cmOkRC )
+        b->failN += 1;
+  
+  b->scanN = smp->scanCnt;
+  b->avgNs = smp->latCnt==0 ? 0 : smp->latSumNs / smp->latCnt;
+  b->maxNs = smp->latMaxNs;
+
+  for(i=0; i<noteN; ++i)
+    b->evtIdxV[i] = cmInvalidIdx;
+  
+  for(i=0; i<smp->ri; ++i)
+    if( cmIsFlag(smp->res[i].flags,kSmTruePosFl) && smp->res[i].mni < noteN )
+    {
+      b->evtIdxV[ smp->res[i].mni ] = smp->res[i].scEvtIdx;
+      b->matchN += 1;
+    }
+  
+  cmScMatcherFree(&smp);
+
+  return kOkMsfRC;
+}
+
+cmMsfRC_t cmMidiScoreFollowBench( cmCtx_t* ctx, const cmChar_t* scoreCsvFn, const cmChar_t* midiFn )
+{
+  cmMsfRC_t                rc       = kOkMsfRC;  
+  double                   srate    = 96000.0;
+  cmScH_t                  scH      = cmScNullHandle;
+  cmMidiFileH_t            mfH      = cmMidiFileNullHandle;
+  const cmMidiTrackMsg_t** m        = NULL;
+  unsigned                 mN       = 0;
+  unsigned                 noteN    = 0;
+  unsigned                 agreeN   = 0;
+  unsigned                 i,j;
+  cmErr_t                  err;
+  _cmMsf_Bench_t           b[2];
+  memset(b,0,sizeof(b));
+
+  cmErrSetup(&err,&ctx->rpt,"cmMidiScoreFollow");
+
+  cmCtx* prCtx   = cmCtxAlloc(NULL, err.rpt, cmLHeapNullHandle, cmSymTblNullHandle );
+  
+  // initialize the score
+  if( cmScoreInitialize( ctx, &scH, scoreCsvFn, srate, NULL, 0, NULL, NULL, cmSymTblNullHandle) != kOkScRC )
+  {
+    rc = cmErrMsg(&err,kFailMsfRC,"cmScoreInitialize() failed on %s",cmStringNullGuard(scoreCsvFn));
+    goto errLabel;
+  }
+
+  // open the MIDI file
+  if( cmMidiFileOpen(ctx, &mfH, midiFn ) != kOkMfRC )
+  {
+    rc = cmErrMsg(&err,kFailMsfRC,"The MIDI file object could not be opened from '%s'.",cmStringNullGuard(midiFn));
+    goto errLabel;
+  }
+
+  // get a pointer to the MIDI msg array
+  if( (m = cmMidiFileMsgArray(mfH)) == NULL || (mN = cmMidiFileMsgCount(mfH)) == 0 )
+  {
+    rc = cmErrMsg(&err,kFailMsfRC,"The MIDI file object appears to be empty.");
+    goto errLabel;
+  }
+
+  // count the note-on msgs
+  for(i=0; i<mN; ++i)
+    if( (m[i]!=NULL) && cmMidiIsChStatus(m[i]->status) && cmMidiIsNoteOn(m[i]->status) && (m[i]->u.chMsgPtr->d1>0) )          
+      noteN += 1;
+
+  b[0].label = "step/scan";
+  b[1].label = "incremental";
+  
+  for(j=0; j<2; ++j)
+  {
+    b[j].evtIdxV = cmMemAllocZ(unsigned,noteN);
+    
+    if((rc = _cmMsf_BenchReplay(&err, prCtx, scH, srate, m, mN, noteN, j==1, b + j )) != kOkMsfRC )
+      goto errLabel;
+  }
+
+  for(i=0; i<noteN; ++i)
+    if( b[0].evtIdxV[i] != cmInvalidIdx && b[0].evtIdxV[i] == b[1].evtIdxV[i] )
+      agreeN += 1;
+
+  cmRptPrintf(&ctx->rpt,"MIDI notes:%i Score Events:%i\n",noteN,cmScoreEvtCount(scH));
+  cmRptPrintf(&ctx->rpt,"%-12s %7s %7s %5s %10s %10s\n","matcher","matched","failed","scans","avg us","max us");
+  
+  for(j=0; j<2; ++j)
+    cmRptPrintf(&ctx->rpt,"%-12s %7i %7i %5i %10.3f %10.3f\n",b[j].label,b[j].matchN,b[j].failN,b[j].scanN,b[j].avgNs/1000.0,b[j].maxNs/1000.0);
+
+  cmRptPrintf(&ctx->rpt,"notes matched to the same score event by both matchers:%i\n",agreeN);
+  
+ errLabel:
+  for(j=0; j<2; ++j)
+    cmMemFree(b[j].evtIdxV);
+  
+  cmMidiFileClose(&mfH);
+  cmScoreFinalize(&scH);
+  cmCtxFree(&prCtx);
+
+  return rc;
+}
@@ -37,6 +37,16 @@ extern "C" {
     const cmChar_t* midiOutFn,       // (optional) midiFn with apply sostenuto and velocities from the score to the MIDI file
     const cmChar_t* tlBarOutFn       // (optional) bar positions sutiable for use in a cmTimeLine description file.
                                   );
+
+  // Replay the note-on messages in 'midiFn' through the step/scan score matcher
+  // and the incremental score matcher (cmScMatcher.incrFl) and report the
+  // count of matched notes, the count of resync. scans, the average and
+  // maximum cmScMatcherExec() processing time per note and the count of notes
+  // which both matchers assigned to the same score event.
+  cmMsfRC_t cmMidiScoreFollowBench(
+    cmCtx_t*        ctx,
+    const cmChar_t* scoreCsvFn,      // score CSV file as generated from cmXScoreTest().
+    const cmChar_t* midiFn );        // MIDI file to replay
   //)
   
 #ifdef __cplusplus
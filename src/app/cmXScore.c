@@ -35,6 +35,9 @@
 
 #include "cmSvgWriter.h"
 
+#include <sys/wait.h>
+#include <sys/resource.h>
+
 
 
 cmXsH_t cmXsNullHandle = cmSTATIC_NULL_HANDLE;
@@ -123,8 +126,6 @@ typedef struct cmXsNote_str
   struct cmXsVoice_str*       voice;    // voice this note belongs to
   struct cmXsMeas_str*        meas;     // measure this note belongs to
 
-  const cmXmlNode_t*          xmlNode;  // note xml ptr
-
   struct cmXsNote_str*        tied;     // subsequent note tied to this note
   struct cmXsNote_str*        grace;    // grace note groups link backward in time from the anchor note
  
@@ -176,7 +177,6 @@ typedef struct cmXsPart_str
 typedef struct
 {
   cmErr_t     err;
-  cmXmlH_t    xmlH;
   cmLHeapH_t  lhH;
   cmXsPart_t* partL;
   cmCsvH_t    csvH;
@@ -200,9 +200,6 @@ cmXsRC_t _cmXScoreFinalize( cmXScore_t* p )
 {
   cmXsRC_t rc = kOkXsRC;
 
-  // release the XML file
-  cmXmlFree( &p->xmlH );
-
   // release the local linked heap memory
   cmLHeapDestroy(&p->lhH);
 
@@ -214,14 +211,14 @@ cmXsRC_t _cmXScoreFinalize( cmXScore_t* p )
   return rc;
 }
 
-cmXsRC_t _cmXScoreMissingNode( cmXScore_t* p, const cmXmlNode_t* parent, const cmChar_t* label )
+cmXsRC_t _cmXScoreMissingNode( cmXScore_t* p, unsigned parentLine, const cmChar_t* label )
 {
-  return cmErrMsg(&p->err,kSyntaxErrorXsRC,"Missing XML node '%s'. Parent line:%i",label,parent->line);
+  return cmErrMsg(&p->err,kSyntaxErrorXsRC,"Missing XML node '%s'. Parent line:%i",label,parentLine);
 }
 
-cmXsRC_t _cmXScoreMissingAttribute( cmXScore_t* p, const cmXmlNode_t* np, const cmChar_t* attrLabel )
+cmXsRC_t _cmXScoreMissingAttribute( cmXScore_t* p, const cmChar_t* nodeLabel, const cmChar_t* attrLabel )
 {
-  return cmErrMsg(&p->err,kSyntaxErrorXsRC,"Missing XML attribute '%s' from node '%s'.",attrLabel,np->label);
+  return cmErrMsg(&p->err,kSyntaxErrorXsRC,"Missing XML attribute '%s' from node '%s'.",attrLabel,nodeLabel);
 }
 
 cmXsVoice_t* _cmXScoreIdToVoice( cmXsMeas_t* meas, unsigned voiceId )
@@ -437,73 +434,20 @@ void _cmXScoreInsertNoteAfter( cmXsNote_t* note, cmXsNote_t* nn )
 }
 
 
-cmXsRC_t _cmXScoreParsePartList( cmXScore_t* p )
-{
-  cmXsRC_t           rc          = kOkXsRC;
-  cmXsPart_t*        lastPartPtr = NULL;
-  const cmXmlNode_t* xnp;
-
-  // find the 'part-list'
-  if((xnp = cmXmlSearch( cmXmlRoot(p->xmlH), "part-list", NULL, 0)) == NULL )
-    return _cmXScoreMissingNode(p,cmXmlRoot(p->xmlH),"part-list");
-
-  const cmXmlNode_t* cnp = xnp->children;
-
-  // for each child of the 'part-list'
-  for(; cnp!=NULL; cnp=cnp->sibling)
-    if( cmTextCmp( cnp->label, "score-part" ) == 0 )
-    {
-      const cmXmlAttr_t* a;
-
-      // find the 'score-part' id
-      if((a = cmXmlFindAttrib(cnp,"id")) == NULL )
-        return _cmXScoreMissingAttribute(p,cnp,"id");
-
-      // allocate a new part record
-      cmXsPart_t* pp = cmLhAllocZ(p->lhH,cmXsPart_t,1);
-
-      pp->idStr = a->value;  // set the part id
-
-      // link the new part record to the end of the part list
-      if(lastPartPtr == NULL)
-        p->partL = pp;
-      else
-        lastPartPtr->link = pp;
-
-      lastPartPtr = pp;
-    }
-
-  return rc;
-}
-
-cmXsRC_t  _cmXScoreParsePitch( cmXScore_t* p, const cmXmlNode_t* nnp, cmXsNote_t* np )
+void _cmXScoreSetPitch( cmXsNote_t* np, cmChar_t step, unsigned octave, double alter )
 {
-  cmXsRC_t        rc     = kOkXsRC;
-  unsigned        octave = 0;
-  double          alter  = 0;
-  const cmChar_t* step   = NULL;
-
-  if((step = cmXmlNodeValue(nnp,"pitch","step",NULL)) == NULL )
-    return _cmXScoreMissingNode(p,nnp,"step");
-
-  if((rc = cmXmlNodeUInt( nnp,&octave,"pitch","octave",NULL)) != kOkXmlRC )
-    return _cmXScoreMissingNode(p,nnp,"octave");
-
-  cmXmlNodeDouble( nnp,&alter,"pitch","alter",NULL);
-
   int acc = alter;
-  unsigned midi = cmSciPitchToMidiPitch(*step,acc,octave);
+  unsigned midi = cmSciPitchToMidiPitch(step,acc,octave);
 
   np->pitch  = midi;
-  np->step   = *step;
+  np->step   = step;
   np->octave = octave;
   np->alter  = alter;
   np->flags |= kOnsetXsFl;
-
-  return rc;
 }
 
-cmXsRC_t  _cmXScoreParseNoteRValue( cmXScore_t* p, const cmXmlNode_t* nnp, const cmChar_t* label, double* rvalueRef )
+// Convert a MusicXML note type label (e.g. 'quarter') to an rvalue.
+cmXsRC_t  _cmXScoreRValue( cmXScore_t* p, const cmChar_t* str, double* rvalueRef )
 {
   typedef struct map_str
   {
@@ -526,23 +470,6 @@ cmXsRC_t  _cmXScoreParseNoteRValue( cmXScore_t* p, const cmXmlNode_t* nnp, const
    {  0.0, ""        }
   };
 
-  const cmChar_t* str;
-  // get the XML rvalue label
-  if((str = cmXmlNodeValue(nnp,label,NULL)) == NULL)
-  {
-    if((nnp = cmXmlSearch(nnp,"rest",NULL,0)) != NULL )
-    {
-      const cmXmlAttr_t* a;
-      if((a = cmXmlFindAttrib(nnp,"measure")) != NULL && cmTextCmp(a->value,"yes")==0)
-      {
-        *rvalueRef = -1;
-        return kOkXsRC;
-      }
-    }
-
-    return cmErrMsg(&p->err,kSyntaxErrorXsRC,"The 'beat-unit' metronome value is missing on line %i.",nnp->line);
-  }
-
   unsigned i;
   // lookup the rvalue numeric value from the mapV[] table
   for(i=0; mapV[i].rvalue!=0; ++i)
@@ -556,107 +483,1007 @@ cmXsRC_t  _cmXScoreParseNoteRValue( cmXScore_t* p, const cmXmlNode_t* nnp, const
   return cmErrMsg(&p->err,kSyntaxErrorXsRC,"Unknown rvalue type='%s'.",str);
 }
 
-cmXsRC_t  _cmXScoreParseColor( cmXScore_t* p, const cmXmlNode_t* nnp, cmXsNote_t* note )
-{
-  cmXsRC_t rc = kOkXsRC;
-  const cmXmlAttr_t* a;
+// Set the color coded flags of 'note' from the value of a MusicXML 'color' attribute.
+cmXsRC_t  _cmXScoreSetColor( cmXScore_t* p, const cmChar_t* color, unsigned line, cmXsNote_t* note )
+{
+  cmXsRC_t rc = kOkXsRC;
+
+   typedef struct map_str
+  {
+    unsigned long long        value;
+    const cmChar_t* label;
+  } map_t;
+
+  map_t mapV[] =
+  {
+    { kEvenXsFl,                                       "#FF0000FF" },  // blue (even)
+    { kEvenXsFl  | kEvenEndXsFl,                       "#FF0000FE" },  // blue (even end)
+    { kEvenXsFl  | kEvenEndXsFl,                       "#FF0000FD" },  // blue (even end)
+    { kTempoXsFl,                                      "#FF00FF00" },  // green (tempo)
+    { kTempoXsFl | kTempoEndXsFl,                      "#FF00FE00" },  // green (tempo end)
+    { kDynXsFl,                                        "#FFFF0000" },  // red   (dynamics)
+    { kDynXsFl   | kDynEndXsFl,                        "#FFFE0000" },  // red   (dynamics end)
+    { kDynXsFl   | kDynEndXsFl,                        "#FFFD0000" },  // red   (dynamics end)
+    { kTempoXsFl | kEvenXsFl,                          "#FF00FFFF" },  // green + blue (turquoise)
+    { kTempoXsFl | kEvenXsFl | kEvenEndXsFl,           "#FF00FFFE" },  // green + blue (turquoise) (end)    
+    { kDynXsFl   | kEvenXsFl,                          "#FFFF00FF" },  // red   + blue
+    { kDynXsFl   | kEvenXsFl | kEvenEndXsFl,           "#FFFF00FE" },  // red   + blue (end)
+    { kDynXsFl   | kEvenXsFl | kEvenEndXsFl,           "#FFFF00FD" },  // red   + blue (end)    
+    { kDynXsFl   | kEvenXsFl,                          "#FFFF0CF7" },  // magenta (even+dyn)
+    { kDynXsFl   | kTempoXsFl,                         "#FFFF7F00" },  // red   + green (brown)
+    { kDynXsFl   | kTempoXsFl,                         "#FFFE7F00" },  // red   + green (brown)    (end)
+    { kDynXsFl   | kTempoXsFl,                         "#FFFD7F00" },  // red   + green (brown)    (end)
+    { kDynXsFl   | kTempoXsFl | kTempoEndXsFl,         "#FFFF7E00" },  //
+    { kDynXsFl   | kDynEndXsFl | kEvenXsFl | kEvenEndXsFl, "#FFFE00FE" }, //
+    { kDynXsFl   | kDynEndXsFl | kEvenXsFl,            "#FFFE00FF" },
+    { kTempoXsFl | kEvenXsFl | kDynXsFl,               "#FF996633" },  // (purple)
+    { kTempoXsFl | kEvenXsFl | kDynXsFl | kDynEndXsFl, "#FF996632" },  // (purple)
+    { kDynXsFl,                                        "#FFFF6A03" },  //   176 orange  (dynamics)
+    { kEvenXsFl,                                       "#FF2F00E8" },  //  1001 blue (even)
+    { kTempoXsFl,                                      "#FF01CD1F" },  //  1196 green   (tempo)
+    { kEvenXsFl,                                       "#FF3600E8" },  //  1627 blue (even)
+    { kDynXsFl | kTempoXsFl,                           "#FF9E8F15" },  //  8827 brown (dyn + tempo)
+    { kEvenXsFl,                                       "#FF2E00E6" },  //  5393 blue (even)
+    { kEvenXsFl,                                       "#FF2C00DD" },  //  5895 blue (even)
+    { kDynXsFl,                                        "#FFFF5B03" },  //  6498 orange (dyn)
+    { kDynXsFl,                                        "#FFFF6104" },  //  6896 orange
+    { kEvenXsFl,                                       "#FF2A00E6" },  //  7781 blue
+    { kEvenXsFl,                                       "#FF2300DD" },  //  8300 blue (even)
+    { kTempoXsFl,                                      "#FF03CD22" },  // 10820 green (tempo)
+    { kEvenXsFl,                                       "#FF3400DB" },  // 11627 blue (dyn)
+    { -1, "" }
+  };
+
+  /*
+    orange  #FF6A03
+    magenta #FF0CF7
+    blue    #2F00E8
+    green   #01CD1F
+    gold    #9E8F15
+    green   #03CD22
+   */
+
+  unsigned i;
+  for(i=0; mapV[i].value != -1; ++i)
+    if( cmTextCmp(color,mapV[i].label) == 0 )
+    {
+      note->flags += mapV[i].value;
+      break;
+    }
+
+  if( mapV[i].value == -1 )
+    cmErrMsg(&p->err,kSyntaxErrorXsRC,"The note color '%s' was not found on line %i.",color,line);
+
+  return rc;
+}
+
+cmXsRC_t _cmXScorePushNonNote( cmXScore_t* p, cmXsMeas_t* meas, unsigned tick, unsigned duration, unsigned staff, double rvalue, const cmChar_t* tvalue, unsigned flags )
+{
+  cmXsNote_t* note    = cmLhAllocZ(p->lhH,cmXsNote_t,1);
+  unsigned    voiceId = 0;    // non-note's are always assigned to voiceId=0;
+
+  note->pitch    = kInvalidMidiPitch;
+  note->tick     = tick;
+  note->staff    = staff;
+  note->flags    = flags;
+  note->rvalue   = rvalue;
+  note->tvalue   = tvalue;
+  note->duration = duration;
+  note->tied_dur = duration;
+  note->meas     = meas;
+
+  return _cmXScorePushNote(p, meas, voiceId, note );
+}
+
+cmXsSpan_t* _cmXScoreFindOpenOctaveShift( cmXScore_t* p, unsigned staff, unsigned number )
+{
+  cmXsSpan_t* s = p->spanL;
+  for(; s!=NULL; s=s->link)
+    if( s->tick1 == -1 && s->staff == staff && s->number == number )
+      return s;
+
+  return NULL;
+}
+
+cmXsRC_t _cmXScorePushOctaveShift(cmXScore_t* p, cmXsMeas_t* meas, unsigned staff, unsigned span_number, const cmChar_t* type_str, unsigned tick)
+{
+  assert( meas != NULL);
+
+  cmXsSpan_t* s;
+  if( cmTextCmp(type_str,"stop") == 0 )
+  {
+    if((s = _cmXScoreFindOpenOctaveShift(p,staff,span_number)) == NULL )
+      return cmErrWarnMsg(&p->err,kUnterminatedOctaveShiftXsrRC,"An illegal octave shift was encounted in meas %i.\n",meas->number);
+
+    s->tick1 = tick;
+  }
+  else
+  {
+    s               = cmLhAllocZ(p->lhH,cmXsSpan_t,1);
+    s->staff        = staff;
+    s->meas         = meas;
+    s->number       = span_number;
+    s->tick0        = tick;
+    s->tick1        = -1;
+    s->pitch_offset = cmTextCmp(type_str,"up")==0 ? -12 : 12;
+    s->link         = p->spanL;
+    p->spanL        = s;
+  }
+
+  return kOkXsRC;
+}
+
+
+//-------------------------------------------------------------------------------------------
+// Single pass parser
+//
+// The _cmXsRdXXX() functions build the part, measure and note records
+// while reading the MusicXML file as a cmXmlRd event stream. The file is
+// never held in memory as an XML tree.
+// Each function is called with the begin tag of its element as the
+// current event and returns after the element's end tag has been read.
+// Where an element may contain more than one child with the same label
+// only the first child is used.
+
+enum
+{
+  kVoiceXsRdFl     = 0x00001,
+  kPitchXsRdFl     = 0x00002,
+  kDurationXsRdFl  = 0x00004,
+  kStaffXsRdFl     = 0x00008,
+  kTypeXsRdFl      = 0x00010,
+  kNotationsXsRdFl = 0x00020,
+  kRestXsRdFl      = 0x00040,
+  kStepXsRdFl      = 0x00080,
+  kOctaveXsRdFl    = 0x00100,
+  kAlterXsRdFl     = 0x00200,
+  kTechnicalXsRdFl = 0x00400,
+  kOffsetXsRdFl    = 0x00800,
+  kPerMinuteXsRdFl = 0x01000,
+  kBeatUnitXsRdFl  = 0x02000,
+  kDivisionsXsRdFl = 0x04000,
+  kTimeXsRdFl      = 0x08000,
+  kBeatsXsRdFl     = 0x10000,
+  kBeatTypeXsRdFl  = 0x20000
+};
+
+typedef struct
+{
+  cmXScore_t*  p;
+  cmXmlRdH_t   h;
+  cmXmlEvent_t e;    // current event
+  cmXsRC_t     rc;   // first error
+} cmXsRd_t;
+
+cmXsRC_t _cmXsRdNext( cmXsRd_t* r )
+{
+  if( r->rc == kOkXsRC && cmXmlRdNext(r->h,&r->e) != kOkXmlRC )
+    r->rc = cmErrMsg(&r->p->err,kXmlFailXsRC,"MusicXML read failed.");
+
+  return r->rc;
+}
+
+// Read to the begin tag of the next child of the element at 'depth'.
+// Returns false when the element's end tag has been read or an error occurs.
+bool _cmXsRdChild( cmXsRd_t* r, unsigned depth )
+{
+  while( _cmXsRdNext(r) == kOkXsRC && r->e.typeId != kEofXmlRdId )
+  {
+    if( r->e.typeId == kBegXmlRdId && r->e.depth == depth+1 )
+      return true;
+
+    if( r->e.typeId == kEndXmlRdId && r->e.depth == depth )
+      break;
+  }
+
+  return false;
+}
+
+// Return true if the current element is labeled 'label' and is the first such child of its parent.
+// 'flag' identifies 'label' in *seenRef.
+bool _cmXsRdIsFirst( cmXsRd_t* r, const cmChar_t* label, unsigned flag, unsigned* seenRef )
+{
+  if( cmIsFlag(*seenRef,flag) || cmTextCmp(r->e.label,label) != 0 )
+    return false;
+
+  *seenRef |= flag;
+  return true;
+}
+
+// Read the remainder of the current element and return its data text or NULL if it has no data text.
+const cmChar_t* _cmXsRdText( cmXsRd_t* r )
+{
+  const cmChar_t* text = NULL;
+
+  if( cmXmlRdText(r->h,&text) != kOkXmlRC )
+    r->rc = cmErrMsg(&r->p->err,kXmlFailXsRC,"MusicXML read failed.");
+
+  return text;
+}
+
+// Read the data text of the current element as a number.
+// As with cmXmlNodeInt() *vRef is unchanged and false is returned if the element has no data text.
+bool _cmXsRdInt( cmXsRd_t* r, int* vRef )
+{
+  const cmChar_t* text;
+  if((text = _cmXsRdText(r)) == NULL )
+    return false;
+
+  *vRef = strtol(text,NULL,10);
+  return true;
+}
+
+bool _cmXsRdUInt( cmXsRd_t* r, unsigned* vRef )
+{ return _cmXsRdInt(r,(int*)vRef); }
+
+bool _cmXsRdDouble( cmXsRd_t* r, double* vRef )
+{
+  const cmChar_t* text;
+  if((text = _cmXsRdText(r)) == NULL )
+    return false;
+
+  *vRef = strtod(text,NULL);
+  return true;
+}
+
+cmXsRC_t _cmXsRdPartList( cmXsRd_t* r )
+{
+  cmXScore_t*     p           = r->p;
+  unsigned        depth       = r->e.depth;
+  cmXsPart_t*     lastPartPtr = NULL;
+  const cmChar_t* id;
+
+  // for each child of the 'part-list'
+  while( _cmXsRdChild(r,depth) )
+    if( cmTextCmp( r->e.label, "score-part" ) == 0 )
+    {
+      // find the 'score-part' id
+      if((id = cmXmlRdAttrValue(&r->e,"id")) == NULL )
+        return r->rc = _cmXScoreMissingAttribute(p,r->e.label,"id");
+
+      // allocate a new part record
+      cmXsPart_t* pp = cmLhAllocZ(p->lhH,cmXsPart_t,1);
+
+      // an empty id is stored as NULL
+      pp->idStr = *id ? cmLhAllocStr(p->lhH,id) : NULL;
+
+      // link the new part record to the end of the part list
+      if(lastPartPtr == NULL)
+        p->partL = pp;
+      else
+        lastPartPtr->link = pp;
+
+      lastPartPtr = pp;
+    }
+
+  return r->rc;
+}
+
+// Read the 'pitch' element of a note.
+void _cmXsRdPitch( cmXsRd_t* r, cmChar_t* stepRef, bool* octaveFlRef, unsigned* octaveRef, double* alterRef )
+{
+  unsigned        depth = r->e.depth;
+  unsigned        seen  = 0;
+  const cmChar_t* text;
+
+  while( _cmXsRdChild(r,depth) )
+  {
+    if( _cmXsRdIsFirst(r,"step",kStepXsRdFl,&seen) )
+    {
+      if((text = _cmXsRdText(r)) != NULL )
+        *stepRef = *text;
+    }
+    else
+      if( _cmXsRdIsFirst(r,"octave",kOctaveXsRdFl,&seen) )
+        *octaveFlRef = _cmXsRdUInt(r,octaveRef);
+      else
+        if( _cmXsRdIsFirst(r,"alter",kAlterXsRdFl,&seen) )
+          _cmXsRdDouble(r,alterRef);
+  }
+}
+
+// Return true if the 'notations' element of a note contains a 'technical/heel' element.
+bool _cmXsRdHeel( cmXsRd_t* r )
+{
+  unsigned depth  = r->e.depth;
+  unsigned seen   = 0;
+  bool     heelFl = false;
+
+  while( _cmXsRdChild(r,depth) )
+    if( _cmXsRdIsFirst(r,"technical",kTechnicalXsRdFl,&seen) )
+    {
+      unsigned tdepth = r->e.depth;
+
+      while( _cmXsRdChild(r,tdepth) )
+        if( cmTextCmp(r->e.label,"heel") == 0 )
+          heelFl = true;
+    }
+
+  return heelFl;
+}
+
+// Read a 'note' element and append the note to 'meas'.
+cmXsRC_t _cmXsRdNote( cmXsRd_t* r, cmXsMeas_t* meas, unsigned* tick0Ref, unsigned* tickRef )
+{
+  cmXScore_t*     p          = r->p;
+  unsigned        depth      = r->e.depth;
+  unsigned        line       = r->e.line;
+  unsigned        seen       = 0;
+  cmXsNote_t*     note       = cmLhAllocZ(p->lhH,cmXsNote_t,1);
+  unsigned        voiceId    = 0;
+  bool            voiceFl    = false;
+  bool            typeFl     = false;
+  bool            measRestFl = false;
+  cmChar_t        step       = 0;
+  bool            octaveFl   = false;
+  unsigned        octave     = 0;
+  double          alter      = 0;
+  const cmChar_t* text;
+
+  note->pitch = kInvalidMidiPitch;
+  note->meas  = meas;
+
+  // set color coded flags
+  if((text = cmXmlRdAttrValue(&r->e,"color")) != NULL )
+    _cmXScoreSetColor(p,text,line,note);
+
+  // for each child of the 'note'
+  while( _cmXsRdChild(r,depth) )
+  {
+    const cmChar_t* label = r->e.label;
+
+    if( _cmXsRdIsFirst(r,"voice",kVoiceXsRdFl,&seen) )
+      voiceFl = _cmXsRdUInt(r,&voiceId);
+    else
+    if( _cmXsRdIsFirst(r,"pitch",kPitchXsRdFl,&seen) )
+      _cmXsRdPitch(r,&step,&octaveFl,&octave,&alter);
+    else
+    if( _cmXsRdIsFirst(r,"duration",kDurationXsRdFl,&seen) )
+      _cmXsRdUInt(r,&note->duration);
+    else
+    if( _cmXsRdIsFirst(r,"staff",kStaffXsRdFl,&seen) )
+      _cmXsRdUInt(r,&note->staff);
+    else
+    if( _cmXsRdIsFirst(r,"type",kTypeXsRdFl,&seen) )
+    {
+      // get the note's rythmic value
+      if((text = _cmXsRdText(r)) != NULL )
+      {
+        typeFl = true;
+        if((r->rc = _cmXScoreRValue(p,text,&note->rvalue)) != kOkXsRC )
+          return r->rc;
+      }
+    }
+    else
+    if( _cmXsRdIsFirst(r,"notations",kNotationsXsRdFl,&seen) )
+    {
+      if( _cmXsRdHeel(r) )
+        note->flags |= kHeelXsFl;
+    }
+    else
+    if( cmTextCmp(label,"rest") == 0 )
+    {
+      note->flags |= kRestXsFl;
+
+      // a whole measure rest is marked on the first 'rest'
+      if( cmIsNotFlag(seen,kRestXsRdFl) )
+        measRestFl = cmTextCmp(cmXmlRdAttrValue(&r->e,"measure"),"yes") == 0;
+
+      seen |= kRestXsRdFl;
+    }
+    else
+    if( cmTextCmp(label,"grace") == 0 )
+      note->flags |= kGraceXsFl;
+    else
+    if( cmTextCmp(label,"dot") == 0 )
+      note->flags |= kDotXsFl;
+    else
+    if( cmTextCmp(label,"chord") == 0 )
+      note->flags |= kChordXsFl;
+    else
+    if( cmTextCmp(label,"tie") == 0 )
+    {
+      const cmChar_t* type = cmXmlRdAttrValue(&r->e,"type");
+
+      // is this is first or second note in a tied pair
+      if( cmTextCmp(type,"start") == 0 )
+        note->flags |= kTieBegXsFl;
+      else
+        if( cmTextCmp(type,"stop") == 0 )
+          note->flags |= kTieEndXsFl;
+    }
+  }
+
+  if( r->rc != kOkXsRC )
+    return r->rc;
+
+  if( !voiceFl )
+    return r->rc = _cmXScoreMissingNode(p,line,"voice");
+
+  // if this note has a pitch
+  if( cmIsFlag(seen,kPitchXsRdFl) )
+  {
+    if( step == 0 )
+      return r->rc = _cmXScoreMissingNode(p,line,"step");
+
+    if( !octaveFl )
+      return r->rc = _cmXScoreMissingNode(p,line,"octave");
+
+    _cmXScoreSetPitch(note,step,octave,alter);
+  }
+
+  // a note without a 'type' must be a whole measure rest
+  if( !typeFl )
+  {
+    if( !measRestFl )
+      return r->rc = cmErrMsg(&p->err,kSyntaxErrorXsRC,"The 'beat-unit' metronome value is missing on line %i.",line);
+
+    note->rvalue = -1;
+  }
+
+  // if this is a chord note
+  if( cmIsFlag(note->flags,kChordXsFl) )
+  {
+    note->tick = *tick0Ref; // then use the onset time from the previous note and do not advance time
+  }
+  else
+  {
+    *tick0Ref  = *tickRef;
+    note->tick = *tickRef;
+
+    *tickRef += note->duration;
+  }
+
+  return r->rc = _cmXScorePushNote(p, meas, voiceId, note );
+}
+
+// Read a 'direction' element.
+// The direction type is chosen after the whole element has been read because
+// a 'metronome' takes precedence over a 'pedal', 'words' or 'octave-shift'
+// regardless of their order in the file.
+cmXsRC_t _cmXsRdDirection( cmXsRd_t* r, cmXsMeas_t* meas, unsigned tick )
+{
+  cmXScore_t*     p          = r->p;
+  unsigned        depth      = r->e.depth;
+  unsigned        seen       = 0;
+  unsigned        flags      = 0;
+  int             offset     = 0;
+  double          rvalue     = 0;
+  const cmChar_t* tvalue     = NULL;
+  unsigned        duration   = 0;
+  bool            pushFl     = true;
+  unsigned        staff      = 0;
+  unsigned        metroDepth = 0;     // depth of the 'metronome' while it is being read
+  unsigned        metroLine  = 0;
+  bool            metroFl    = false;
+  bool            perMinFl   = false;
+  const cmChar_t* beatUnit   = NULL;
+  bool            measRestFl = false;
+  bool            pedalFl    = false;
+  const cmChar_t* pedalType  = NULL;
+  bool            wordsFl    = false;
+  bool            sectionFl  = false;
+  unsigned        wordsLine  = 0;
+  bool            octFl      = false;
+  const cmChar_t* octNumb    = NULL;
+  const cmChar_t* octType    = NULL;
+  const cmChar_t* s;
+
+  while( _cmXsRdNext(r) == kOkXsRC && r->e.typeId != kEofXmlRdId )
+  {
+    if( r->e.typeId == kEndXmlRdId )
+    {
+      if( r->e.depth == depth )
+        break;
+
+      if( r->e.depth == metroDepth )
+        metroDepth = 0;
+
+      continue;
+    }
+
+    if( r->e.typeId != kBegXmlRdId )
+      continue;
+
+    // children of the 'metronome'
+    if( metroDepth != 0 )
+    {
+      if( r->e.depth == metroDepth+1 )
+      {
+        if( _cmXsRdIsFirst(r,"per-minute",kPerMinuteXsRdFl,&seen) )
+          perMinFl = _cmXsRdUInt(r,&duration);
+        else
+          if( _cmXsRdIsFirst(r,"beat-unit",kBeatUnitXsRdFl,&seen) )
+          {
+            if((s = _cmXsRdText(r)) != NULL )
+              beatUnit = cmLhAllocStr(p->lhH,s);
+          }
+          else
+            if( _cmXsRdIsFirst(r,"rest",kRestXsRdFl,&seen) )
+              measRestFl = cmTextCmp(cmXmlRdAttrValue(&r->e,"measure"),"yes") == 0;
+      }
+      continue;
+    }
+
+    if( r->e.depth == depth+1 && _cmXsRdIsFirst(r,"offset",kOffsetXsRdFl,&seen) )
+      _cmXsRdInt(r,&offset);
+    else
+    if( r->e.depth == depth+1 && _cmXsRdIsFirst(r,"staff",kStaffXsRdFl,&seen) )
+      _cmXsRdUInt(r,&staff);
+    else
+    if( !metroFl && cmTextCmp(r->e.label,"metronome") == 0 )
+    {
+      metroFl    = true;
+      metroDepth = r->e.depth;
+      metroLine  = r->e.line;
+    }
+    else
+    if( !pedalFl && cmTextCmp(r->e.label,"pedal") == 0 )
+    {
+      pedalFl = true;
+      if((s = cmXmlRdAttrValue(&r->e,"type")) != NULL )
+        pedalType = cmLhAllocStr(p->lhH,s);
+    }
+    else
+    if( !wordsFl && cmTextCmp(r->e.label,"words") == 0 )
+    {
+      wordsFl   = true;
+      wordsLine = r->e.line;
+
+      // we only care about 'words' in 'enclosures'
+      if( (sectionFl = cmTextCmp(cmXmlRdAttrValue(&r->e,"enclosure"),"rectangle")==0) )
+        if((s = _cmXsRdText(r)) != NULL )
+          tvalue = cmLhAllocStr(p->lhH,s);
+    }
+    else
+    if( !octFl && cmTextCmp(r->e.label,"octave-shift") == 0 )
+    {
+      octFl = true;
+      if((s = cmXmlRdAttrValue(&r->e,"number")) != NULL )
+        octNumb = cmLhAllocStr(p->lhH,s);
+
+      if((s = cmXmlRdAttrValue(&r->e,"type")) != NULL )
+        octType = cmLhAllocStr(p->lhH,s);
+    }
+  }
+
+  if( r->rc != kOkXsRC )
+    return r->rc;
+
+  // if this is a metronome direction
+  if( metroFl )
+  {
+    if( !perMinFl )
+      cmErrWarnMsg(&p->err,kSyntaxErrorXsRC,"The 'per-minute' metronome value is missing on line %i.",metroLine);
+    else
+    {
+      if( beatUnit != NULL )
+      {
+        if((r->rc = _cmXScoreRValue(p,beatUnit,&rvalue)) != kOkXsRC )
+          return r->rc;
+      }
+      else
+      {
+        if( !measRestFl )
+          return r->rc = cmErrMsg(&p->err,kSyntaxErrorXsRC,"The 'beat-unit' metronome value is missing on line %i.",metroLine);
+
+        rvalue = -1;
+      }
+
+      flags = kMetronomeXsFl;
+    }
+  }
+  else
+
+  // if this is a pedal direction
+  if( pedalFl )
+  {
+    if( pedalType == NULL )
+      return r->rc = _cmXScoreMissingAttribute(p, "pedal", "type" );
+
+    if( cmTextCmp(pedalType,"start") == 0 )
+      flags = kDampDnXsFl;
+    else
+      if( cmTextCmp(pedalType,"change") == 0 )
+        flags = kDampUpDnXsFl;
+      else
+        if( cmTextCmp(pedalType,"stop") == 0 )
+          flags = kDampUpXsFl;
+        else
+          return r->rc = cmErrMsg(&p->err,kSyntaxErrorXsRC,"Unrecognized pedal type:'%s'.",pedalType);
+  }
+  else
+
+  // if this is a 'words' direction
+  if( wordsFl )
+  {
+    if( sectionFl )
+    {
+      if( cmTextIsEmpty( tvalue ) )
+        return r->rc = cmErrMsg(&p->err,kSyntaxErrorXsRC,"Section number is blank or missing on line %i.",wordsLine);
+
+      flags = kSectionXsFl;
+    }
+    else
+    {
+      pushFl = false;
+    }
+  }
+  else
+
+  // if this is an 'octave-shift' direction
+  if( octFl )
+  {
+    if( octNumb == NULL )
+      return r->rc = cmErrMsg(&p->err,kSyntaxErrorXsRC,"Octave-shift is missing a 'number' attribute.");
+
+    if( octType == NULL )
+      return r->rc = cmErrMsg(&p->err,kSyntaxErrorXsRC,"Octave-shift is missing a 'type' attribute.");
+
+    r->rc = _cmXScorePushOctaveShift(p,meas,staff,strtol(octNumb,NULL,10),octType,tick+offset);
+
+    pushFl = false;
+  }
+  else
+  {
+    pushFl = false;
+  }
+
+  if( pushFl )
+    r->rc = _cmXScorePushNonNote(p,meas,tick+offset,duration,staff,rvalue,tvalue,flags);
+
+  return r->rc;
+}
+
+// Read the first 'attributes' element of a measure.
+void _cmXsRdAttributes( cmXsRd_t* r, cmXsMeas_t* meas )
+{
+  unsigned depth = r->e.depth;
+  unsigned seen  = 0;
+
+  while( _cmXsRdChild(r,depth) )
+    if( _cmXsRdIsFirst(r,"divisions",kDivisionsXsRdFl,&seen) )
+      _cmXsRdUInt(r,&meas->divisions);
+    else
+      if( _cmXsRdIsFirst(r,"time",kTimeXsRdFl,&seen) )
+      {
+        unsigned tdepth = r->e.depth;
+
+        while( _cmXsRdChild(r,tdepth) )
+          if( _cmXsRdIsFirst(r,"beats",kBeatsXsRdFl,&seen) )
+            _cmXsRdUInt(r,&meas->beats);
+          else
+            if( _cmXsRdIsFirst(r,"beat-type",kBeatTypeXsRdFl,&seen) )
+              _cmXsRdUInt(r,&meas->beat_type);
+      }
+}
+
+// Read a 'measure' element and append the measure to 'pp'.
+cmXsRC_t _cmXsRdMeasure( cmXsRd_t* r, cmXsPart_t* pp, unsigned* tickRef )
+{
+  cmXScore_t*     p      = r->p;
+  unsigned        depth  = r->e.depth;
+  unsigned        tick   = *tickRef;
+  unsigned        tick0  = 0;
+  bool            attrFl = false;
+  cmXsMeas_t*     m      = NULL;
+  const cmChar_t* numb;
+
+  // allocate the 'measure' record
+  cmXsMeas_t* meas = cmLhAllocZ(p->lhH,cmXsMeas_t,1);
+
+  // get measure number
+  if((numb = cmXmlRdAttrValue(&r->e,"number")) == NULL )
+    return r->rc = _cmXScoreMissingAttribute(p,r->e.label,"number");
+
+  meas->number = strtol(numb,NULL,10);
+
+  if( pp->measL == NULL )
+    pp->measL = meas;
+  else
+  {
+    m = pp->measL;
+    while( m->link != NULL )
+      m = m->link;
+
+    m->link         = meas;
+    meas->divisions = m->divisions;
+    meas->beats     = m->beats;
+    meas->beat_type = m->beat_type;
+  }
+
+  // store the bar line
+  if((r->rc = _cmXScorePushNonNote(p,meas,tick,0,0,0,NULL,kBarXsFl)) != kOkXsRC )
+    return r->rc;
+
+  // for each child of the 'measure'
+  while( _cmXsRdChild(r,depth) )
+  {
+    // if this is a 'note' node
+    if( cmTextCmp(r->e.label,"note") == 0 )
+      _cmXsRdNote(r,meas,&tick0,&tick);
+    else
+      // if this is a 'backup' node
+      if( cmTextCmp(r->e.label,"backup") == 0 )
+      {
+        unsigned bdepth = r->e.depth;
+        unsigned backup = 0;
+        unsigned seen   = 0;
+
+        while( _cmXsRdChild(r,bdepth) )
+          if( _cmXsRdIsFirst(r,"duration",kDurationXsRdFl,&seen) )
+            _cmXsRdUInt(r,&backup);
+
+        if( backup > tick )
+          tick = 0;
+        else
+          tick -= backup;
+
+        tick0 = tick;
+      }
+      else
+        // if this is a 'direction' node
+        if( cmTextCmp(r->e.label,"direction") == 0 )
+          _cmXsRdDirection(r,meas,tick);
+        else
+          // measure attributes apply to the whole measure
+          if( !attrFl && cmTextCmp(r->e.label,"attributes") == 0 )
+          {
+            attrFl = true;
+            _cmXsRdAttributes(r,meas);
+          }
+  }
+
+  *tickRef = tick;
+  return r->rc;
+}
+
+cmXsRC_t _cmXsRdPart( cmXsRd_t* r, cmXsPart_t* pp )
+{
+  unsigned depth   = r->e.depth;
+  unsigned barTick = 0;
+
+  // for each child of this part - find each measure
+  while( _cmXsRdChild(r,depth) )
+    if( cmTextCmp(r->e.label,"measure") == 0 )
+      if( _cmXsRdMeasure(r,pp,&barTick) != kOkXsRC )
+        break;
+
+  return r->rc;
+}
+
+// Build p->partL from the MusicXML file 'xmlFn'.
+// 'bufCharCnt' is passed to cmXmlRdOpen() (0=default).
+// Parts are read in 'part-list' order so that the note uid's do not depend
+// on the order of the 'part' elements in the file. When the two orders agree,
+// which is the normal case, the file is read once. Otherwise the file is
+// re-read from the beginning for each part which was passed over.
+// A part whose id does not occur in the 'part-list' is ignored and only
+// the first occurrence of a part is read.
+cmXsRC_t _cmXScoreParseStream( cmXScore_t* p, cmCtx_t* ctx, const cmChar_t* xmlFn, unsigned bufCharCnt )
+{
+  cmXsRd_t        r;
+  cmXsPart_t*     pp         = NULL;   // next part to read
+  bool*           skipV      = NULL;   // skipV[i] is set when part-list part 'i' was passed over on this pass
+  unsigned        partIdx    = 0;      // part-list index of 'pp'
+  unsigned        partN      = 0;
+  unsigned        readCnt    = 1;      // count of part-list and part elements read on this pass
+  bool            partListFl = false;
+
+  memset(&r,0,sizeof(r));
+  r.p = p;
+  r.h = cmXmlRdNullHandle;
+
+  while( r.rc == kOkXsRC && readCnt > 0 )
+  {
+    readCnt = 0;
+
+    if( cmXmlRdOpen(ctx, &r.h, xmlFn, bufCharCnt) != kOkXmlRC )
+    {
+      r.rc = cmErrMsg(&p->err,kXmlFailXsRC,"Unable to open the MusicXML file '%s'.",cmStringNullGuard(xmlFn));
+      break;
+    }
+
+    if( skipV != NULL )
+      memset(skipV,0,partN*sizeof(skipV[0]));
+
+    while( _cmXsRdNext(&r) == kOkXsRC && r.e.typeId != kEofXmlRdId )
+    {
+      if( r.e.typeId != kBegXmlRdId )
+        continue;
+
+      // parse the first part-list
+      if( !partListFl && cmTextCmp(r.e.label,"part-list") == 0 )
+      {
+        partListFl = true;
+
+        if( _cmXsRdPartList(&r) != kOkXsRC )
+          break;
+
+        for(pp=p->partL; pp!=NULL; pp=pp->link)
+          ++partN;
+
+        pp    = p->partL;
+        skipV = cmMemAllocZ(bool,partN);
+
+        // any parts which preceded the part-list are read on the next pass
+        ++readCnt;
+      }
+      else
+        if( pp != NULL && cmTextCmp(r.e.label,"part") == 0 )
+        {
+          const cmChar_t* id = cmXmlRdAttrValue(&r.e,"id");
+          cmXsPart_t*     xp = pp;
+          unsigned        i  = partIdx;
+
+          // find the part record for this 'part' - parts which precede 'pp' have already been read
+          for(; xp!=NULL; xp=xp->link,++i)
+            if( cmTextCmp(xp->idStr, id!=NULL && *id==0 ? NULL : id) == 0 )
+              break;
+
+          if( xp == NULL )
+            continue;
+
+          // a later part, or a later occurrence of 'pp', must wait for the next pass
+          if( xp != pp || skipV[i] )
+          {
+            skipV[i] = true;
+            continue;
+          }
+
+          if( _cmXsRdPart(&r,pp) != kOkXsRC )
+            break;
+
+          ++readCnt;
+          ++partIdx;
+
+          // stop reading once all the parts have been read
+          if((pp = pp->link) == NULL )
+            break;
+        }
+    }
+
+    cmXmlRdClose(&r.h);
+
+    if( r.rc != kOkXsRC )
+      break;
+
+    if( !partListFl )
+    {
+      r.rc = _cmXScoreMissingNode(p,1,"part-list");
+      break;
+    }
+
+    if( pp == NULL )
+      break;
+
+    // a pass over the entire file which read nothing means 'pp' does not exist
+    if( readCnt == 0 )
+      r.rc = cmErrMsg(&p->err,kSyntaxErrorXsRC,"The part '%s' was not found.",pp->idStr);
+  }
+
+  cmMemFree(skipV);
+
+  return r.rc;
+}
+
+//-------------------------------------------------------------------------------------------
+// XML tree parser
+//
+// The _cmXsTreeXXX() functions build the same part, measure and note records
+// as the single pass parser by loading the MusicXML file into a cmXml tree and
+// searching it. This is the parser which the single pass parser replaced. It is
+// only used by cmXScoreParseBench() as a reference for load time, memory use
+// and the resulting score.
+// Strings are copied to p->lhH so that the tree can be released once the
+// parts have been read.
+
+cmXsRC_t _cmXsTreePartList( cmXScore_t* p, cmXmlH_t xmlH )
+{
+  cmXsRC_t           rc          = kOkXsRC;
+  cmXsPart_t*        lastPartPtr = NULL;
+  const cmXmlNode_t* xnp;
+
+  // find the 'part-list'
+  if((xnp = cmXmlSearch( cmXmlRoot(xmlH), "part-list", NULL, 0)) == NULL )
+    return _cmXScoreMissingNode(p,cmXmlRoot(xmlH)->line,"part-list");
+
+  const cmXmlNode_t* cnp = xnp->children;
+
+  // for each child of the 'part-list'
+  for(; cnp!=NULL; cnp=cnp->sibling)
+    if( cmTextCmp( cnp->label, "score-part" ) == 0 )
+    {
+      const cmXmlAttr_t* a;
+
+      // find the 'score-part' id
+      if((a = cmXmlFindAttrib(cnp,"id")) == NULL )
+        return _cmXScoreMissingAttribute(p,cnp->label,"id");
+
+      // allocate a new part record
+      cmXsPart_t* pp = cmLhAllocZ(p->lhH,cmXsPart_t,1);
+
+      // an empty id is stored as NULL
+      pp->idStr = cmTextIsEmpty(a->value) ? NULL : cmLhAllocStr(p->lhH,a->value);
+
+      // link the new part record to the end of the part list
+      if(lastPartPtr == NULL)
+        p->partL = pp;
+      else
+        lastPartPtr->link = pp;
+
+      lastPartPtr = pp;
+    }
+
+  return rc;
+}
+
+cmXsRC_t  _cmXsTreePitch( cmXScore_t* p, const cmXmlNode_t* nnp, cmXsNote_t* np )
+{
+  cmXsRC_t        rc     = kOkXsRC;
+  unsigned        octave = 0;
+  double          alter  = 0;
+  const cmChar_t* step   = NULL;
+
+  if((step = cmXmlNodeValue(nnp,"pitch","step",NULL)) == NULL )
+    return _cmXScoreMissingNode(p,nnp->line,"step");
+
+  if((rc = cmXmlNodeUInt( nnp,&octave,"pitch","octave",NULL)) != kOkXmlRC )
+    return _cmXScoreMissingNode(p,nnp->line,"octave");
 
-   typedef struct map_str
-  {
-    unsigned long long        value;
-    const cmChar_t* label;
-  } map_t;
+  cmXmlNodeDouble( nnp,&alter,"pitch","alter",NULL);
 
-  map_t mapV[] =
-  {
-    { kEvenXsFl,                                       "#FF0000FF" },  // blue (even)
-    { kEvenXsFl  | kEvenEndXsFl,                       "#FF0000FE" },  // blue (even end)
-    { kEvenXsFl  | kEvenEndXsFl,                       "#FF0000FD" },  // blue (even end)
-    { kTempoXsFl,                                      "#FF00FF00" },  // green (tempo)
-    { kTempoXsFl | kTempoEndXsFl,                      "#FF00FE00" },  // green (tempo end)
-    { kDynXsFl,                                        "#FFFF0000" },  // red   (dynamics)
-    { kDynXsFl   | kDynEndXsFl,                        "#FFFE0000" },  // red   (dynamics end)
-    { kDynXsFl   | kDynEndXsFl,                        "#FFFD0000" },  // red   (dynamics end)
-    { kTempoXsFl | kEvenXsFl,                          "#FF00FFFF" },  // green + blue (turquoise)
-    { kTempoXsFl | kEvenXsFl | kEvenEndXsFl,           "#FF00FFFE" },  // green + blue (turquoise) (end)    
-    { kDynXsFl   | kEvenXsFl,                          "#FFFF00FF" },  // red   + blue
-    { kDynXsFl   | kEvenXsFl | kEvenEndXsFl,           "#FFFF00FE" },  // red   + blue (end)
-    { kDynXsFl   | kEvenXsFl | kEvenEndXsFl,           "#FFFF00FD" },  // red   + blue (end)    
-    { kDynXsFl   | kEvenXsFl,                          "#FFFF0CF7" },  // magenta (even+dyn)
-    { kDynXsFl   | kTempoXsFl,                         "#FFFF7F00" },  // red   + green (brown)
-    { kDynXsFl   | kTempoXsFl,                         "#FFFE7F00" },  // red   + green (brown)    (end)
-    { kDynXsFl   | kTempoXsFl,                         "#FFFD7F00" },  // red   + green (brown)    (end)
-    { kDynXsFl   | kTempoXsFl | kTempoEndXsFl,         "#FFFF7E00" },  //
-    { kDynXsFl   | kDynEndXsFl | kEvenXsFl | kEvenEndXsFl, "#FFFE00FE" }, //
-    { kDynXsFl   | kDynEndXsFl | kEvenXsFl,            "#FFFE00FF" },
-    { kTempoXsFl | kEvenXsFl | kDynXsFl,               "#FF996633" },  // (purple)
-    { kTempoXsFl | kEvenXsFl | kDynXsFl | kDynEndXsFl, "#FF996632" },  // (purple)
-    { kDynXsFl,                                        "#FFFF6A03" },  //   176 orange  (dynamics)
-    { kEvenXsFl,                                       "#FF2F00E8" },  //  1001 blue (even)
-    { kTempoXsFl,                                      "#FF01CD1F" },  //  1196 green   (tempo)
-    { kEvenXsFl,                                       "#FF3600E8" },  //  1627 blue (even)
-    { kDynXsFl | kTempoXsFl,                           "#FF9E8F15" },  //  8827 brown (dyn + tempo)
-    { kEvenXsFl,                                       "#FF2E00E6" },  //  5393 blue (even)
-    { kEvenXsFl,                                       "#FF2C00DD" },  //  5895 blue (even)
-    { kDynXsFl,                                        "#FFFF5B03" },  //  6498 orange (dyn)
-    { kDynXsFl,                                        "#FFFF6104" },  //  6896 orange
-    { kEvenXsFl,                                       "#FF2A00E6" },  //  7781 blue
-    { kEvenXsFl,                                       "#FF2300DD" },  //  8300 blue (even)
-    { kTempoXsFl,                                      "#FF03CD22" },  // 10820 green (tempo)
-    { kEvenXsFl,                                       "#FF3400DB" },  // 11627 blue (dyn)
-    { -1, "" }
-  };
+  _cmXScoreSetPitch(np,*step,octave,alter);
 
-  /*
-    orange  #FF6A03
-    magenta #FF0CF7
-    blue    #2F00E8
-    green   #01CD1F
-    gold    #9E8F15
-    green   #03CD22
-   */
+  return rc;
+}
 
-  if((a = cmXmlFindAttrib(nnp, "color" )) != NULL )
+// Convert a MusicXML note type label (e.g. 'quarter') to an rvalue.
+cmXsRC_t  _cmXsTreeNoteRValue( cmXScore_t* p, const cmXmlNode_t* nnp, const cmChar_t* label, double* rvalueRef )
+{
+  const cmChar_t* str;
+  // get the XML rvalue label
+  if((str = cmXmlNodeValue(nnp,label,NULL)) == NULL)
   {
-    unsigned i;
-    for(i=0; mapV[i].value != -1; ++i)
-      if( cmTextCmp(a->value,mapV[i].label) == 0 )
+    if((nnp = cmXmlSearch(nnp,"rest",NULL,0)) != NULL )
+    {
+      const cmXmlAttr_t* a;
+      if((a = cmXmlFindAttrib(nnp,"measure")) != NULL && cmTextCmp(a->value,"yes")==0)
       {
-        note->flags += mapV[i].value;
-        break;
+        *rvalueRef = -1;
+        return kOkXsRC;
       }
+    }
 
-    if( mapV[i].value == -1 )
-      cmErrMsg(&p->err,kSyntaxErrorXsRC,"The note color '%s' was not found on line %i.",a->value,nnp->line);
+    return cmErrMsg(&p->err,kSyntaxErrorXsRC,"The 'beat-unit' metronome value is missing on line %i.",nnp->line);
   }
 
-  return rc;
+  return _cmXScoreRValue(p,str,rvalueRef);
 }
 
 // On input tick0Ref is set to the tick of the previous event.
 // On input tickRef is set to the tick of this event.
 // On output tick0Ref is set to the tick of this event.
 // On output tickRef is set to the tick of the next event.
-cmXsRC_t _cmXScoreParseNote(cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNode_t* nnp, unsigned* tick0Ref, unsigned* tickRef )
+cmXsRC_t _cmXsTreeNote(cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNode_t* nnp, unsigned* tick0Ref, unsigned* tickRef )
 {
-  cmXsRC_t    rc   = kOkXsRC;
-  cmXsNote_t* note = cmLhAllocZ(p->lhH,cmXsNote_t,1);
-  unsigned    voiceId;
+  cmXsRC_t           rc   = kOkXsRC;
+  cmXsNote_t*        note = cmLhAllocZ(p->lhH,cmXsNote_t,1);
+  const cmXmlAttr_t* a;
+  unsigned           voiceId;
 
   note->pitch   = kInvalidMidiPitch;
   note->meas    = meas;
-  note->xmlNode = nnp;
 
   // get the voice id for this node
   if( cmXmlNodeUInt(nnp,&voiceId,"voice",NULL) != kOkXmlRC )
-    return _cmXScoreMissingNode(p,nnp,"voice");
+    return _cmXScoreMissingNode(p,nnp->line,"voice");
 
   // if this note has a pitch
   if( cmXmlNodeHasChild(nnp,"pitch",NULL) )
-    if((rc = _cmXScoreParsePitch(p,nnp,note)) != kOkXsRC )
+    if((rc = _cmXsTreePitch(p,nnp,note)) != kOkXsRC )
       return rc;
 
-
   cmXmlNodeUInt(nnp,&note->duration,"duration",NULL);  // get the note duration
   cmXmlNodeUInt(nnp,&note->staff,"staff",NULL);        // get th staff number
 
@@ -689,14 +1516,14 @@ cmXsRC_t _cmXScoreParseNote(cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNode_t*
     note->flags |= kHeelXsFl;
 
   // set color coded flags
-  if((rc = _cmXScoreParseColor(p, nnp, note )) != kOkXsRC )
-    return rc;
+  if((a = cmXmlFindAttrib(nnp, "color" )) != NULL )
+    if((rc = _cmXScoreSetColor(p,a->value,nnp->line,note)) != kOkXsRC )
+      return rc;
 
   // get the note's rythmic value
-  if((rc =  _cmXScoreParseNoteRValue(p,nnp,"type",&note->rvalue)) != kOkXsRC )
+  if((rc =  _cmXsTreeNoteRValue(p,nnp,"type",&note->rvalue)) != kOkXsRC )
     return rc;
 
-
   // if this is a chord note
   if( cmIsFlag(note->flags,kChordXsFl) )
   {
@@ -713,65 +1540,7 @@ cmXsRC_t _cmXScoreParseNote(cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNode_t*
   return _cmXScorePushNote(p, meas, voiceId, note );
 }
 
-cmXsRC_t _cmXScorePushNonNote( cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNode_t* noteXmlNode, unsigned tick, unsigned duration, unsigned staff, double rvalue, const cmChar_t* tvalue, unsigned flags )
-{
-  cmXsNote_t* note    = cmLhAllocZ(p->lhH,cmXsNote_t,1);
-  unsigned    voiceId = 0;    // non-note's are always assigned to voiceId=0;
-
-  note->pitch    = kInvalidMidiPitch;
-  note->tick     = tick;
-  note->staff    = staff;
-  note->flags    = flags;
-  note->rvalue   = rvalue;
-  note->tvalue   = tvalue;
-  note->duration = duration;
-  note->tied_dur = duration;
-  note->meas     = meas;
-  note->xmlNode  = noteXmlNode;
-
-  return _cmXScorePushNote(p, meas, voiceId, note );
-}
-
-cmXsSpan_t* _cmXScoreFindOpenOctaveShift( cmXScore_t* p, unsigned staff, unsigned number )
-{
-  cmXsSpan_t* s = p->spanL;
-  for(; s!=NULL; s=s->link)
-    if( s->tick1 == -1 && s->staff == staff && s->number == number )
-      return s;
-
-  return NULL;
-}
-
-cmXsRC_t _cmXScorePushOctaveShift(cmXScore_t* p, cmXsMeas_t* meas, unsigned staff, unsigned span_number, const cmChar_t* type_str, unsigned tick)
-{
-  assert( meas != NULL);
-
-  cmXsSpan_t* s;
-  if( cmTextCmp(type_str,"stop") == 0 )
-  {
-    if((s = _cmXScoreFindOpenOctaveShift(p,staff,span_number)) == NULL )
-      return cmErrWarnMsg(&p->err,kUnterminatedOctaveShiftXsrRC,"An illegal octave shift was encounted in meas %i.\n",meas->number);
-
-    s->tick1 = tick;
-  }
-  else
-  {
-    s               = cmLhAllocZ(p->lhH,cmXsSpan_t,1);
-    s->staff        = staff;
-    s->meas         = meas;
-    s->number       = span_number;
-    s->tick0        = tick;
-    s->tick1        = -1;
-    s->pitch_offset = cmTextCmp(type_str,"up")==0 ? -12 : 12;
-    s->link         = p->spanL;
-    p->spanL        = s;
-  }
-
-  return kOkXsRC;
-}
-
-
-cmXsRC_t  _cmXScoreParseDirection(cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNode_t* dnp, unsigned tick)
+cmXsRC_t  _cmXsTreeDirection(cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNode_t* dnp, unsigned tick)
 {
   cmXsRC_t           rc       = kOkXsRC;
   const cmXmlNode_t* np       = NULL;
@@ -795,7 +1564,7 @@ cmXsRC_t  _cmXScoreParseDirection(cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNo
       cmErrWarnMsg(&p->err,kSyntaxErrorXsRC,"The 'per-minute' metronome value is missing on line %i.",np->line);
     else
     {
-      if((rc = _cmXScoreParseNoteRValue(p,np,"beat-unit",&rvalue)) != kOkXsRC )
+      if((rc = _cmXsTreeNoteRValue(p,np,"beat-unit",&rvalue)) != kOkXsRC )
         return rc;
 
       flags = kMetronomeXsFl;
@@ -808,7 +1577,7 @@ cmXsRC_t  _cmXScoreParseDirection(cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNo
   {
 
     if((a = cmXmlFindAttrib(np,"type")) == NULL )
-      return _cmXScoreMissingAttribute(p, np, "type" );
+      return _cmXScoreMissingAttribute(p, np->label, "type" );
 
     if( cmTextCmp(a->value,"start") == 0 )
       flags = kDampDnXsFl;
@@ -828,10 +1597,11 @@ cmXsRC_t  _cmXScoreParseDirection(cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNo
   {
     if((a = cmXmlFindAttrib(np,"enclosure")) != NULL && cmTextCmp(a->value,"rectangle")==0 )
     {
-      if( cmTextIsEmpty( tvalue = np->dataStr ) )
+      if( cmTextIsEmpty( np->dataStr ) )
         return cmErrMsg(&p->err,kSyntaxErrorXsRC,"Section number is blank or missing on line %i.",np->line);
 
-      flags = kSectionXsFl;
+      tvalue = cmLhAllocStr(p->lhH,np->dataStr);
+      flags  = kSectionXsFl;
     }
     else
     {
@@ -863,15 +1633,14 @@ cmXsRC_t  _cmXScoreParseDirection(cmXScore_t* p, cmXsMeas_t* meas, const cmXmlNo
   }
 
   if( pushFl )
-    rc = _cmXScorePushNonNote(p,meas,dnp,tick+offset,duration,staff,rvalue,tvalue,flags);
+    rc = _cmXScorePushNonNote(p,meas,tick+offset,duration,staff,rvalue,tvalue,flags);
 
   return rc;
 }
 
-
 // On input tickRef is set to the absolute tick of the bar line and on output it is set
 // to the absolute tick of the next bar line.
-cmXsRC_t _cmXScoreParseMeasure(cmXScore_t* p, cmXsPart_t* pp, const cmXmlNode_t* mnp, unsigned* tickRef)
+cmXsRC_t _cmXsTreeMeasure(cmXScore_t* p, cmXsPart_t* pp, const cmXmlNode_t* mnp, unsigned* tickRef)
 {
   cmXsRC_t           rc   = kOkXsRC;
   const cmXmlNode_t* np   = NULL;
@@ -884,7 +1653,7 @@ cmXsRC_t _cmXScoreParseMeasure(cmXScore_t* p, cmXsPart_t* pp, const cmXmlNode_t*
 
   // get measure number
   if( cmXmlAttrUInt(mnp,"number", &meas->number) != kOkXmlRC )
-    return _cmXScoreMissingAttribute(p,mnp,"number");
+    return _cmXScoreMissingAttribute(p,mnp->label,"number");
 
   if( pp->measL == NULL )
     pp->measL = meas;
@@ -909,7 +1678,7 @@ cmXsRC_t _cmXScoreParseMeasure(cmXScore_t* p, cmXsPart_t* pp, const cmXmlNode_t*
   }
 
   // store the bar line
-  if((rc = _cmXScorePushNonNote(p,meas,mnp,tick,0,0,0,NULL,kBarXsFl)) != kOkXsRC )
+  if((rc = _cmXScorePushNonNote(p,meas,tick,0,0,0,NULL,kBarXsFl)) != kOkXsRC )
     return rc;
 
   np = mnp->children;
@@ -920,7 +1689,7 @@ cmXsRC_t _cmXScoreParseMeasure(cmXScore_t* p, cmXsPart_t* pp, const cmXmlNode_t*
     // if this is a 'note' node
     if( cmTextCmp(np->label,"note") == 0 )
     {
-      rc = _cmXScoreParseNote(p,meas,np,&tick0,&tick);
+      rc = _cmXsTreeNote(p,meas,np,&tick0,&tick);
     }
     else
       // if this is a 'backup' node
@@ -939,7 +1708,7 @@ cmXsRC_t _cmXScoreParseMeasure(cmXScore_t* p, cmXsPart_t* pp, const cmXmlNode_t*
         // if this is a 'direction' node
         if( cmTextCmp(np->label,"direction") == 0 )
         {
-          rc = _cmXScoreParseDirection(p,meas,np,tick);
+          rc = _cmXsTreeDirection(p,meas,np,tick);
         }
 
   }
@@ -948,26 +1717,53 @@ cmXsRC_t _cmXScoreParseMeasure(cmXScore_t* p, cmXsPart_t* pp, const cmXmlNode_t*
   return rc;
 }
 
-cmXsRC_t _cmXScoreParsePart( cmXScore_t* p, cmXsPart_t* pp )
+cmXsRC_t _cmXsTreePart( cmXScore_t* p, cmXmlH_t xmlH, cmXsPart_t* pp )
 {
   cmXsRC_t           rc       = kOkXsRC;
   const cmXmlNode_t* xnp;
   cmXmlAttr_t        partAttr  = { "id", pp->idStr };
   unsigned           barTick   = 0;
+
   // find the 'part'
-  if((xnp = cmXmlSearch( cmXmlRoot(p->xmlH), "part", &partAttr, 1)) == NULL )
+  if((xnp = cmXmlSearch( cmXmlRoot(xmlH), "part", &partAttr, 1)) == NULL )
     return cmErrMsg(&p->err,kSyntaxErrorXsRC,"The part '%s' was not found.",pp->idStr);
 
   // for each child of this part - find each measure
   const cmXmlNode_t* cnp = xnp->children;
   for(; cnp!=NULL; cnp=cnp->sibling)
     if( cmTextCmp(cnp->label,"measure") == 0 )
-      if((rc = _cmXScoreParseMeasure(p,pp,cnp,&barTick)) != kOkXsRC )
+      if((rc = _cmXsTreeMeasure(p,pp,cnp,&barTick)) != kOkXsRC )
         return rc;
 
   return rc;
 }
 
+// Build p->partL from the MusicXML file 'xmlFn' by way of a cmXml tree.
+cmXsRC_t _cmXScoreParseTree( cmXScore_t* p, cmCtx_t* ctx, const cmChar_t* xmlFn )
+{
+  cmXsRC_t    rc   = kOkXsRC;
+  cmXmlH_t    xmlH = cmXmlNullHandle;
+  cmXsPart_t* pp;
+
+  // open the music xml file
+  if( cmXmlAlloc(ctx, &xmlH, xmlFn) != kOkXmlRC )
+    return cmErrMsg(&p->err,kXmlFailXsRC,"Unable to open the MusicXML file '%s'.",cmStringNullGuard(xmlFn));
+
+  // parse the part-list
+  if((rc = _cmXsTreePartList( p, xmlH )) != kOkXsRC )
+    goto errLabel;
+
+  // parse each score 'part'
+  for(pp=p->partL; pp!=NULL; pp=pp->link)
+    if((rc = _cmXsTreePart(p,xmlH,pp)) != kOkXsRC )
+      goto errLabel;
+
+ errLabel:
+  cmXmlFree(&xmlH);
+
+  return rc;
+}
+
 // Insert note 'np' into the sorted note list based at 's0'.
 // Return a pointer to the base of the list after the insertion.
 cmXsNote_t*  _cmXScoreInsertSortedNote( cmXsNote_t* s0, cmXsNote_t* np )
@@ -3136,7 +3932,9 @@ cmXsRC_t cmXScoreAlloc( cmCtx_t* ctx, cmXsH_t* hp )
   return rc;
 }
 
-cmXsRC_t cmXScoreInitialize( cmCtx_t* ctx, cmXsH_t* hp, const cmChar_t* xmlFn, const cmChar_t* editFn, bool damperRptFl )
+// If 'treeFl' is set the MusicXML file is parsed with the XML tree parser (see cmXScoreParseBench())
+// otherwise it is parsed in a single pass with a reader buffer of 'bufCharCnt' characters (0=default).
+cmXsRC_t _cmXScoreInitialize( cmCtx_t* ctx, cmXsH_t* hp, const cmChar_t* xmlFn, const cmChar_t* editFn, bool damperRptFl, bool treeFl, unsigned bufCharCnt )
 {
   cmXsRC_t rc;
   cmXScore_t* p = NULL;
@@ -3145,26 +3943,16 @@ cmXsRC_t cmXScoreInitialize( cmCtx_t* ctx, cmXsH_t* hp, const cmChar_t* xmlFn, c
     goto errLabel;
 
   p  = _cmXScoreHandleToPtr(*hp);
-    
-  // open the music xml file
-  if( cmXmlAlloc(ctx, &p->xmlH, xmlFn) != kOkXmlRC )
-  {
-    rc = cmErrMsg(&p->err,kXmlFailXsRC,"Unable to open the MusicXML file '%s'.",cmStringNullGuard(xmlFn));
-    goto errLabel;
-  }
 
-  //cmXmlPrint(p->xmlH,&ctx->rpt);
+  // parse the music xml file
+  if( treeFl )
+    rc = _cmXScoreParseTree(p,ctx,xmlFn);
+  else
+    rc = _cmXScoreParseStream(p,ctx,xmlFn,bufCharCnt);
 
-  // parse the part-list
-  if((rc = _cmXScoreParsePartList( p )) != kOkXsRC )
+  if( rc != kOkXsRC )
     goto errLabel;
 
-  // parse each score 'part'
-  cmXsPart_t* pp = p->partL;
-  for(; pp!=NULL; pp=pp->link)
-    if((rc = _cmXScoreParsePart(p,pp)) != kOkXsRC )
-      goto errLabel;
-
   // fill in the note->slink chain to link the notes in each measure in time order
   _cmXScoreSort(p);
 
@@ -3210,6 +3998,9 @@ cmXsRC_t cmXScoreInitialize( cmCtx_t* ctx, cmXsH_t* hp, const cmChar_t* xmlFn, c
   return rc;
 }
 
+cmXsRC_t cmXScoreInitialize( cmCtx_t* ctx, cmXsH_t* hp, const cmChar_t* xmlFn, const cmChar_t* editFn, bool damperRptFl )
+{ return _cmXScoreInitialize(ctx,hp,xmlFn,editFn,damperRptFl,false,0); }
+
 cmXsRC_t cmXScoreFinalize( cmXsH_t* hp )
 {
   cmXsRC_t rc = kOkXsRC;
@@ -4587,3 +5378,216 @@ cmXsRC_t cmXScoreMergeEditFiles( cmCtx_t* ctx, const cmChar_t* xmlFn, const cmCh
 
   return rc;
 }
+
+bool _cmXScoreIsEqualNote( const cmXsNote_t* n0, const cmXsNote_t* n1 )
+{
+  return n0->uid          == n1->uid
+    &&   n0->flags        == n1->flags
+    &&   n0->pitch        == n1->pitch
+    &&   n0->step         == n1->step
+    &&   n0->octave       == n1->octave
+    &&   n0->alter        == n1->alter
+    &&   n0->staff        == n1->staff
+    &&   n0->tick         == n1->tick
+    &&   n0->duration     == n1->duration
+    &&   n0->tied_dur     == n1->tied_dur
+    &&   n0->secs         == n1->secs
+    &&   n0->locIdx       == n1->locIdx
+    &&   n0->rvalue       == n1->rvalue
+    &&   n0->evenGroupId  == n1->evenGroupId
+    &&   n0->dynGroupId   == n1->dynGroupId
+    &&   n0->tempoGroupId == n1->tempoGroupId
+    &&   n0->voice->id    == n1->voice->id
+    &&   cmTextCmp(n0->tvalue,n1->tvalue) == 0
+    &&   (n0->tied == NULL) == (n1->tied == NULL)
+    &&   (n0->tied == NULL || n0->tied->uid == n1->tied->uid);
+}
+
+// Return true if the scores 'p0' and 'p1' have identical parts, measures, voices and notes.
+bool _cmXScoreIsEqual( cmXScore_t* p0, cmXScore_t* p1 )
+{
+  const cmXsPart_t* pp0 = p0->partL;
+  const cmXsPart_t* pp1 = p1->partL;
+
+  for(; pp0!=NULL && pp1!=NULL; pp0=pp0->link, pp1=pp1->link)
+  {
+    const cmXsMeas_t* m0 = pp0->measL;
+    const cmXsMeas_t* m1 = pp1->measL;
+
+    if( cmTextCmp(pp0->idStr,pp1->idStr) != 0 )
+      return false;
+
+    for(; m0!=NULL && m1!=NULL; m0=m0->link, m1=m1->link)
+    {
+      const cmXsNote_t*  n0 = m0->noteL;
+      const cmXsNote_t*  n1 = m1->noteL;
+      const cmXsVoice_t* v0 = m0->voiceL;
+      const cmXsVoice_t* v1 = m1->voiceL;
+
+      if( m0->number!=m1->number || m0->divisions!=m1->divisions || m0->beats!=m1->beats || m0->beat_type!=m1->beat_type )
+        return false;
+
+      // compare the time sorted note lists
+      for(; n0!=NULL && n1!=NULL; n0=n0->slink, n1=n1->slink)
+        if( !_cmXScoreIsEqualNote(n0,n1) )
+          return false;
+
+      if( n0!=NULL || n1!=NULL )
+        return false;
+
+      // compare the voice note lists
+      for(; v0!=NULL && v1!=NULL; v0=v0->link, v1=v1->link)
+      {
+        if( v0->id != v1->id )
+          return false;
+
+        for(n0=v0->noteL, n1=v1->noteL; n0!=NULL && n1!=NULL; n0=n0->mlink, n1=n1->mlink)
+          if( n0->uid != n1->uid )
+            return false;
+
+        if( n0!=NULL || n1!=NULL )
+          return false;
+      }
+
+      if( v0!=NULL || v1!=NULL )
+        return false;
+    }
+
+    if( m0!=NULL || m1!=NULL )
+      return false;
+  }
+
+  return pp0==NULL && pp1==NULL;
+}
+
+// Initialize a score from 'xmlFn' with the XML tree parser (treeFl=true) or the
+// single pass parser (treeFl=false) in a child process and return the peak
+// resident set size (in kilobytes) of the child in *maxRssRef.
+// If 'xmlFn' is NULL the child exits immediately.
+cmXsRC_t _cmXScorePeakRss( cmCtx_t* ctx, const cmChar_t* xmlFn, bool treeFl, long* maxRssRef )
+{
+  struct rusage ru;
+  int           status = 0;
+  pid_t         pid;
+
+  *maxRssRef = 0;
+
+  switch( pid = fork() )
+  {
+    case -1:
+      return cmErrSysMsg(&ctx->err,kFileFailXsRC,errno,"fork() failed.");
+
+    case 0:
+      {
+        cmXsH_t  h  = cmXsNullHandle;
+        cmXsRC_t rc = kOkXsRC;
+
+        if( xmlFn != NULL )
+          rc = _cmXScoreInitialize(ctx,&h,xmlFn,NULL,false,treeFl,0);
+
+        _exit( rc==kOkXsRC ? 0 : 1 );
+      }
+  }
+
+  if( wait4(pid,&status,0,&ru) == -1 )
+    return cmErrSysMsg(&ctx->err,kFileFailXsRC,errno,"wait4() failed.");
+
+  if( !WIFEXITED(status) || WEXITSTATUS(status) != 0 )
+    return cmErrMsg(&ctx->err,kXmlFailXsRC,"The parse of '%s' failed in the child process.",cmStringNullGuard(xmlFn));
+
+  *maxRssRef = ru.ru_maxrss;
+
+  return kOkXsRC;
+}
+
+cmXsRC_t cmXScoreParseBench( cmCtx_t* ctx, const cmChar_t* xmlFn, unsigned iterCnt )
+{
+  cmXsRC_t     rc      = kOkXsRC;
+  cmXsH_t      h0      = cmXsNullHandle;
+  cmXsH_t      h1      = cmXsNullHandle;
+  cmRpt_t*     rpt     = &ctx->rpt;
+  unsigned     fileN   = 0;
+  unsigned     treeUs  = 0;
+  unsigned     strmUs  = 0;
+  long         baseRss = 0;
+  long         treeRss = 0;
+  long         strmRss = 0;
+  unsigned     i;
+  cmTimeSpec_t t0,t1;
+
+  if( iterCnt == 0 )
+    iterCnt = 1;
+
+  // measure the peak memory use of each parser in a separate process
+  // (before this process has grown - a child inherits the parent's resident pages)
+  if((rc = _cmXScorePeakRss(ctx,NULL,false,&baseRss)) != kOkXsRC )
+    goto errLabel;
+
+  if((rc = _cmXScorePeakRss(ctx,xmlFn,true,&treeRss)) != kOkXsRC )
+    goto errLabel;
+
+  if((rc = _cmXScorePeakRss(ctx,xmlFn,false,&strmRss)) != kOkXsRC )
+    goto errLabel;
+
+  // verify that the score does not depend on where the reader's buffer boundaries fall
+  if((rc = _cmXScoreInitialize(ctx,&h0,xmlFn,NULL,false,false,0)) != kOkXsRC )
+    goto errLabel;
+
+  if((rc = _cmXScoreInitialize(ctx,&h1,xmlFn,NULL,false,false,16)) != kOkXsRC )
+    goto errLabel;
+
+  if( !_cmXScoreIsEqual(_cmXScoreHandleToPtr(h0),_cmXScoreHandleToPtr(h1)) )
+  {
+    rc = cmErrMsg(&ctx->err,kSyntaxErrorXsRC,"The parse of '%s' depends on the XML reader buffer size.",cmStringNullGuard(xmlFn));
+    goto errLabel;
+  }
+
+  cmXScoreFinalize(&h1);
+
+  // verify that the single pass parser produces the same score as the XML tree parser
+  if((rc = _cmXScoreInitialize(ctx,&h1,xmlFn,NULL,false,true,0)) != kOkXsRC )
+    goto errLabel;
+
+  if( !_cmXScoreIsEqual(_cmXScoreHandleToPtr(h0),_cmXScoreHandleToPtr(h1)) )
+  {
+    rc = cmErrMsg(&ctx->err,kSyntaxErrorXsRC,"The single pass and XML tree parsers produced different scores from '%s'.",cmStringNullGuard(xmlFn));
+    goto errLabel;
+  }
+
+  cmXScoreFinalize(&h0);
+  cmXScoreFinalize(&h1);
+
+  for(i=0; i<iterCnt; ++i)
+  {
+    cmTimeGetMonotonic(&t0);
+
+    if((rc = _cmXScoreInitialize(ctx,&h0,xmlFn,NULL,false,true,0)) != kOkXsRC )
+      goto errLabel;
+
+    cmXScoreFinalize(&h0);
+
+    cmTimeGetMonotonic(&t1);
+    treeUs += cmTimeElapsedMicros(&t0,&t1);
+
+    cmTimeGetMonotonic(&t0);
+
+    if((rc = _cmXScoreInitialize(ctx,&h0,xmlFn,NULL,false,false,0)) != kOkXsRC )
+      goto errLabel;
+
+    cmXScoreFinalize(&h0);
+
+    cmTimeGetMonotonic(&t1);
+    strmUs += cmTimeElapsedMicros(&t0,&t1);
+  }
+
+  cmFileByteCountFn(xmlFn,rpt,&fileN);
+
+  cmRptPrintf(rpt,"%s : %i bytes  %i iterations\n",xmlFn,fileN,iterCnt);
+  cmRptPrintf(rpt,"xml tree:    %10.3f ms/load peak RSS: %8li KB\n",treeUs/1000.0/iterCnt,treeRss-baseRss);
+  cmRptPrintf(rpt,"single pass: %10.3f ms/load peak RSS: %8li KB\n",strmUs/1000.0/iterCnt,strmRss-baseRss);
+
+ errLabel:
+  cmXScoreFinalize(&h0);
+  cmXScoreFinalize(&h1);
+  return rc;
+}
@@ -89,6 +89,12 @@ extern "C" {
   cmXsRC_t cmXScoreTest( cmCtx_t* ctx, const cmChar_t* xmlFn, const cmChar_t* reorderFn, const cmChar_t* csvOutFn, const cmChar_t* midiOutFn, const cmChar_t* svgOutFn, bool reportFl, int begMeasNumb, int begBPM, bool svgStandAloneFl, bool svgPanZoomFl, bool damperRptFl );
 
   cmXsRC_t cmXScoreMergeEditFiles( cmCtx_t* ctx, const cmChar_t* xmlFn, const cmChar_t* refEditFn,  unsigned refBegMeasNumb, const cmChar_t* editFn, unsigned keyMeasNumb, const cmChar_t* outFn );
+
+  // Verify that the single pass MusicXML parser used by cmXScoreInitialize()
+  // produces the same score from 'xmlFn' with the default and a minimal XML reader
+  // buffer and the same score as the XML tree parser which it replaced. Then
+  // compare the average load time and peak memory use of the two parsers.
+  cmXsRC_t cmXScoreParseBench( cmCtx_t* ctx, const cmChar_t* xmlFn, unsigned iterCnt );
   
   //)
   
@@ -7,10 +7,16 @@
 #include "cmMem.h"
 #include "cmMallocDebug.h"
 #include "cmTime.h"
+#include "cmFloatTypes.h"
 #include "cmAudioPort.h"
+#include "cmResample.h"
 #include "cmApBuf.h"
 #include "cmThread.h"
 
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
 /*
   This API is in general called by two types of threads:
   audio devices threads and the client thread.  There
@@ -60,7 +66,7 @@ typedef struct
   cmApSample_t* m;    // m[mn] meter sample sum  
   unsigned      mn;   // length of m[]
   unsigned      mi;   // next ele of m[] to rcv sum
-  cmApSample_t  s0;   // buffered sample used for srate conversion
+  cmRsmp_t*     rsmp; // sample rate converter (NULL if the device and internal sample rates are the same)
 } cmApCh;
 
 typedef struct
@@ -98,6 +104,8 @@ typedef struct
   unsigned      zeroBufCnt; // max of all dspFrameCnt for all devices.
 
 
+  bool          blockXferFl; // use the block transfer path in cmApBufUpdate() when possible
+
   unsigned     abufIdx;
   cmApSample_t abuf[ 16384 ];
 } cmApBuf;
@@ -105,59 +113,44 @@ typedef struct
 cmApBuf _cmApBuf;
 
 
-// Copy the source channel (srcChIdx) to the destination buffer and apply up-sampling.
+// Copy the source channel (srcChIdx) to the destination buffer and apply sample rate conversion.
 // 'src' is an interleaved buffer with 'srcN' samples per channel and 'srcChN' channels (total size in samples = srcN*srcChN)
 // 'dst' is a non-interleaved (single channel) circular buffer of length 'dstN' where 'dstIdx' is the index of the first dst slot to receive a sample..
+// 'rsmp' is the channel sample rate converter or NULL if no conversion is necessary.
 // Return the index into dst[] of the next location to receive an incoming sample.
-unsigned  _cmApCopyInUpSample( const cmApSample_t* src, unsigned srcN, unsigned srcChN, unsigned srcChIdx, cmApSample_t* dst, unsigned dstN, unsigned dstIdx, unsigned mult, double gain, cmApSample_t* s0_Ref )
+// The count of samples written to dst[] is returned in *dstCntRef. Note that
+// this count may be zero when a sample rate converter is used.
+unsigned  _cmApCopyInSamples( const cmApSample_t* src, unsigned srcN, unsigned srcChN, unsigned srcChIdx, cmApSample_t* dst, unsigned dstN, unsigned dstIdx, cmRsmp_t* rsmp, double gain, unsigned* dstCntRef )
 {
-  cmApSample_t s0 = *s0_Ref;
-  unsigned si,k,di=dstIdx;
-  
-  for(si=0; si<srcN; ++si)
+  const cmApSample_t* sp = src + srcChIdx;
+  unsigned            si,di=dstIdx;
+
+  *dstCntRef = 0;
+
+  if( rsmp == NULL )
   {
-    cmApSample_t s1 = src[si*srcChN+srcChIdx];
-    
-    for(k=1; k<mult; ++k)
+    for(si=0; si<srcN; ++si)
     {
-      dst[di] = gain * (s0 + (s1 - s0) * k / mult );
-      di = (di+1) % dstN;
+      dst[di] = gain * sp[si*srcChN];
+      di      = (di+1) % dstN;
     }
-
-    dst[di] = gain * s1;
-    di      = (di+1) % dstN;
-    s0     = s1;    
+    *dstCntRef = srcN;
+    return di;
   }
-  
-  *s0_Ref = s0;
-  
-  return di;
-}
 
-// Copy the source channel (srcChIdx) to the destination buffer and apply down-sampling.
-// 'src' is an interleaved linear buffer with 'srcN' samples per channel and 'srcChN' channels,
-// 'dst' is a non-interleaved circular buffer of length 'dstN' where 'dstIdx' is the index of the first dst slot to receive a sample..
-// Return the index into dst[] of the next location to receive an incoming sample.
-unsigned  _cmApCopyInDnSample( const cmApSample_t* src, unsigned srcN, unsigned srcChN, unsigned srcChIdx, cmApSample_t* dst, unsigned dstN, unsigned dstIdx, unsigned div, double gain )
-{
-  unsigned si,di=dstIdx;
-  
-  for(si=0; si<srcN; si+=div)
+  // convert into the circular buffer in up to two segments
+  while( srcN > 0 )
   {
-    dst[di] = gain * src[si*srcChN+srcChIdx];
-    di      = (di+1) % dstN;
-  }
-  return di;
-}
+    unsigned xn = 0;
+    unsigned yn = cmRsmpExec(rsmp, sp, srcN, srcChN, &xn, dst + di, dstN - di, 1, gain );
 
+    di    = (di + yn) % dstN;
+    sp   += xn * srcChN;
+    srcN -= xn;
+    *dstCntRef += yn;
+  }
 
-// Copy samples from an interleaved src buffer to a non-interleaved dst buffer with sample rate conversion
-unsigned  _cmApCopyInSamples( const cmApSample_t* src, unsigned srcN, unsigned srcChN, unsigned srcChIdx, cmApSample_t* dst, unsigned dstN, unsigned dstIdx, int srateMult, double gain, cmApSample_t* s0_Ref )
-{
-  if( srateMult < 1 )
-    return _cmApCopyInDnSample( src, srcN, srcChN, srcChIdx, dst, dstN, dstIdx, -srateMult, gain );
-
-  return _cmApCopyInUpSample( src, srcN, srcChN, srcChIdx, dst, dstN, dstIdx, srateMult, gain, s0_Ref );
+  return di;
 }
 
 void printBuf( const cmApSample_t* src, unsigned srcN, unsigned bi, unsigned n )
@@ -172,69 +165,47 @@ void printBuf( const cmApSample_t* src, unsigned srcN, unsigned bi, unsigned n )
 }
 
 
-// Copy 
-// 'src' is a non-interleaved circular buf of total length 'srcN', with the first sample coming at 'srcIdx'.
-// 'dst' is an interleaved buffer of length 'dstN' with 'dstChN' channels
-// Return the index of the next src sample.
-unsigned _cmApCopyOutUpSample( const cmApSample_t* src, unsigned srcN, unsigned srcIdx, cmApSample_t* dst, unsigned dstN, unsigned dstChN, unsigned dstChIdx, int mult, double gain, cmApSample_t* s0_Ref )
-{
-  unsigned di,si=srcIdx;
-  cmApSample_t s0 = *s0_Ref;
-  
-  for(di=0; di<dstN; ++di)
-  {
-    cmApSample_t s1 = src[si];
-    unsigned     k;
-    for(k=1; k<mult && di<dstN; ++di,++k)
-    {
-      dst[di*dstChN+dstChIdx] = gain * (s0 + (s1 - s0) * k / mult );      
-    }
-
-    if( di < dstN )
-    {
-      dst[di*dstChN+dstChIdx] = gain * s1;
-      ++di;
-    }
-
-    si = (si + 1) % srcN;
-    
-    s0 = s1;
-  }
-
-  *s0_Ref = s0;
-  return si;
-}
-
+// Copy samples from a non-interleaved src buffer to an interleaved dst buffer with sample rate conversion.
 // 'src' is a non-interleaved (single channel) circular buf of total length 'srcN', with the first sample coming at 'srcIdx'.
 // 'dst' is an interleaved buffer of length 'dstN' with 'dstChN' channels
+// 'rsmp' is the channel sample rate converter or NULL if no conversion is necessary.
 // Return the index of the next src sample.
-unsigned _cmApCopyOutDnSample( const cmApSample_t* src, unsigned srcN, unsigned srcIdx, cmApSample_t* dst, unsigned dstN, unsigned dstChN, unsigned dstChIdx, int div, double gain )
+// The count of samples taken from src[] is returned in *srcCntRef. Note that
+// this count may be zero when a sample rate converter is used.
+unsigned   _cmApCopyOutSamples( const cmApSample_t* src, unsigned srcN, unsigned srcIdx, cmApSample_t* dst, unsigned dstN, unsigned dstChN, unsigned dstChIdx, cmRsmp_t* rsmp, double gain, unsigned* srcCntRef )
 {
-  unsigned di,si;
+  cmApSample_t* dp = dst + dstChIdx;
+  unsigned      di,si=srcIdx;
 
-  // The total count of output samples is determined by 'dstN'
-  // Downsampling is acheived by advancing the src index by 'div' samples.
+  *srcCntRef = 0;
 
-  for(di=0,si=srcIdx; di<dstN; ++di)
+  if( rsmp == NULL )
   {
-    dst[di*dstChN+dstChIdx] = gain * src[si];
-    si = (si + div) % srcN;
+    for(di=0; di<dstN; ++di)
+    {
+      dp[di*dstChN] = gain * src[si];
+      si = (si + 1) % srcN;
+    }
+    *srcCntRef = dstN;
+    return si;
   }
 
-  return si;  
-}
-
+  // The total count of output samples is determined by 'dstN'.
+  // The converter pulls as many samples from the circular src buffer as it needs.
+  while( dstN > 0 )
+  {
+    unsigned xn = 0;
+    unsigned yn = cmRsmpExec(rsmp, src + si, srcN - si, 1, &xn, dp, dstN, dstChN, gain );
 
-// Copy samples from a non-interleaved src buffer to an interleaved dst buffer with sample rate conversion
-unsigned   _cmApCopyOutSamples( const cmApSample_t* src, unsigned srcN, unsigned srcIdx, cmApSample_t* dst, unsigned dstN, unsigned dstChN, unsigned dstChIdx, int srateMult, double gain, cmApSample_t* s0_Ref )
-{
-  if( srateMult > 0  )
-    return _cmApCopyOutDnSample(src, srcN, srcIdx, dst, dstN, dstChN, dstChIdx, srateMult, gain );
+    si    = (si + xn) % srcN;
+    dp   += yn * dstChN;
+    dstN -= yn;
+    *srcCntRef += xn;
+  }
 
-  return _cmApCopyOutUpSample( src, srcN, srcIdx, dst, dstN, dstChN, dstChIdx, -srateMult, gain, s0_Ref );
+  return si;
 }
 
-
 cmApSample_t _cmApMeterValue( const cmApCh* cp )
 {
   double sum = 0;
@@ -274,9 +245,10 @@ unsigned  _cmApSine( cmApCh* cp, cmApSample_t* dst, unsigned dstN, unsigned dstI
 }
 
 
+// Return the mean square of 'bn' samples taken every 'stride' samples from 'b'.
 cmApSample_t _cmApMeter( const cmApSample_t* b, unsigned bn, unsigned stride )
 {
-  const cmApSample_t* ep  = b + bn;
+  const cmApSample_t* ep  = b + bn*stride;
   cmApSample_t        sum = 0;
 
   for(; b<ep; b+=stride)
@@ -285,14 +257,267 @@ cmApSample_t _cmApMeter( const cmApSample_t* b, unsigned bn, unsigned stride )
   return sum / bn;
 }
 
+// Deinterleave 'frmN' frames of the 'chN' channel interleaved buffer 'src' into
+// the contiguous channel buffers dV[chN]. Each channel is scaled by gV[chN] and
+// the sum of squares of the (unscaled) source samples is accumulated into mV[chN].
+// The SSE path transposes 4 frame x 4 channel tiles so that the packet
+// is read sequentially and each channel buffer is written 4 samples at a time.
+void _cmApDeinterleave( const cmApSample_t* src, unsigned frmN, unsigned chN, cmApSample_t* dV[], const cmApSample_t* gV, cmApSample_t* mV )
+{
+  unsigned fi = 0, ci;
+
+#ifdef __SSE__
+  for(; fi+4<=frmN; fi+=4)
+  {
+    const cmApSample_t* sp = src + fi*chN;
+
+    for(ci=0; ci+4<=chN; ci+=4)
+    {
+      __m128 r0 = _mm_loadu_ps(sp         + ci);
+      __m128 r1 = _mm_loadu_ps(sp +   chN + ci);
+      __m128 r2 = _mm_loadu_ps(sp + 2*chN + ci);
+      __m128 r3 = _mm_loadu_ps(sp + 3*chN + ci);
+      __m128 s0 = _mm_add_ps(_mm_mul_ps(r0,r0),_mm_mul_ps(r1,r1));
+      __m128 s1 = _mm_add_ps(_mm_mul_ps(r2,r2),_mm_mul_ps(r3,r3));
+
+      _mm_storeu_ps(mV+ci, _mm_add_ps(_mm_loadu_ps(mV+ci),_mm_add_ps(s0,s1)));
+
+      _MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+
+      _mm_storeu_ps(dV[ci+0]+fi, _mm_mul_ps(r0,_mm_set1_ps(gV[ci+0])));
+      _mm_storeu_ps(dV[ci+1]+fi, _mm_mul_ps(r1,_mm_set1_ps(gV[ci+1])));
+      _mm_storeu_ps(dV[ci+2]+fi, _mm_mul_ps(r2,_mm_set1_ps(gV[ci+2])));
+      _mm_storeu_ps(dV[ci+3]+fi, _mm_mul_ps(r3,_mm_set1_ps(gV[ci+3])));
+    }
+
+    // remaining channels of this 4 frame tile
+    for(; ci<chN; ++ci)
+    {
+      unsigned k;
+      for(k=0; k<4; ++k)
+      {
+        cmApSample_t v = sp[k*chN+ci];
+        dV[ci][fi+k] = gV[ci] * v;
+        mV[ci]      += v * v;
+      }
+    }
+  }
+#endif
+
+  // remaining frames
+  for(; fi<frmN; ++fi)
+  {
+    const cmApSample_t* sp = src + fi*chN;
+    for(ci=0; ci<chN; ++ci)
+    {
+      dV[ci][fi] = gV[ci] * sp[ci];
+      mV[ci]    += sp[ci] * sp[ci];
+    }
+  }
+}
+
+// Interleave 'frmN' frames from the contiguous channel buffers sV[chN] into the 
+// 'chN' channel interleaved buffer 'dst'. Each channel is scaled by gV[chN] and
+// the sum of squares of the (scaled) output samples is accumulated into mV[chN].
+void _cmApInterleave( cmApSample_t* const sV[], unsigned frmN, unsigned chN, cmApSample_t* dst, const cmApSample_t* gV, cmApSample_t* mV )
+{
+  unsigned fi = 0, ci;
+
+#ifdef __SSE__
+  for(; fi+4<=frmN; fi+=4)
+  {
+    cmApSample_t* dp = dst + fi*chN;
+
+    for(ci=0; ci+4<=chN; ci+=4)
+    {
+      __m128 r0 = _mm_mul_ps(_mm_loadu_ps(sV[ci+0]+fi),_mm_set1_ps(gV[ci+0]));
+      __m128 r1 = _mm_mul_ps(_mm_loadu_ps(sV[ci+1]+fi),_mm_set1_ps(gV[ci+1]));
+      __m128 r2 = _mm_mul_ps(_mm_loadu_ps(sV[ci+2]+fi),_mm_set1_ps(gV[ci+2]));
+      __m128 r3 = _mm_mul_ps(_mm_loadu_ps(sV[ci+3]+fi),_mm_set1_ps(gV[ci+3]));
+
+      _MM_TRANSPOSE4_PS(r0,r1,r2,r3);
+
+      __m128 s0 = _mm_add_ps(_mm_mul_ps(r0,r0),_mm_mul_ps(r1,r1));
+      __m128 s1 = _mm_add_ps(_mm_mul_ps(r2,r2),_mm_mul_ps(r3,r3));
+
+      _mm_storeu_ps(mV+ci, _mm_add_ps(_mm_loadu_ps(mV+ci),_mm_add_ps(s0,s1)));
+
+      _mm_storeu_ps(dp         + ci, r0);
+      _mm_storeu_ps(dp +   chN + ci, r1);
+      _mm_storeu_ps(dp + 2*chN + ci, r2);
+      _mm_storeu_ps(dp + 3*chN + ci, r3);
+    }
+
+    // remaining channels of this 4 frame tile
+    for(; ci<chN; ++ci)
+    {
+      unsigned k;
+      for(k=0; k<4; ++k)
+      {
+        cmApSample_t v = gV[ci] * sV[ci][fi+k];
+        dp[k*chN+ci] = v;
+        mV[ci]      += v * v;
+      }
+    }
+  }
+#endif
+
+  // remaining frames
+  for(; fi<frmN; ++fi)
+  {
+    cmApSample_t* dp = dst + fi*chN;
+    for(ci=0; ci<chN; ++ci)
+    {
+      cmApSample_t v = gV[ci] * sV[ci][fi];
+      dp[ci]  = v;
+      mV[ci] += v * v;
+    }
+  }
+}
+
+// Move an incoming packet into the input channel buffers in a single pass.
+// This path is only used when the device runs at the native sample rate, all packet 
+// channels share the same buffer index and none of the channels would overflow or have the
+// test tone enabled.  Returns false if the packet must be handled by the per-channel path.
+bool _cmApBlockXferIn( cmApIO* ip, const cmApAudioPacket_t* pp )
+{
+  unsigned chN  = pp->chCnt;
+  unsigned frmN = pp->audioFramesCnt;
+  cmApCh*  cV   = ip->chArray + pp->begChIdx;
+  unsigned ii;
+  unsigned j;
+
+  if( ip->srateMult != 1 || chN == 0 || frmN == 0 || frmN > ip->n )
+    return false;
+
+  assert( pp->begChIdx + chN <= ip->chCnt );
+
+  ii = cV[0].ii;
+
+  for(j=0; j<chN; ++j)
+    if( cV[j].ii != ii || cmIsFlag(cV[j].fl,kToneApFl) || cV[j].fn + frmN > ip->n )
+      return false;
+
+  const cmApSample_t* sp = (const cmApSample_t*)pp->audioBytesPtr;
+  unsigned            n0 = cmMin(frmN, ip->n - ii);  // samples before the end of the channel buffers
+  unsigned            n1 = frmN - n0;                // samples which wrap to the start of the channel buffers
+  cmApSample_t*       dV[ chN ];
+  cmApSample_t        gV[ chN ];
+  cmApSample_t        mV[ chN ];
+
+  // disabled and muted channels are filled with zeros 
+  for(j=0; j<chN; ++j)
+  {
+    bool enaFl = cmIsFlag(cV[j].fl,kChApFl) && cmIsFlag(cV[j].fl,kMuteApFl)==false;
+    dV[j] = cV[j].b + ii;
+    gV[j] = enaFl ? cV[j].gain : 0;
+    mV[j] = 0;
+  }
+
+  _cmApDeinterleave( sp, n0, chN, dV, gV, mV );
+
+  if( n1 > 0 )
+  {
+    for(j=0; j<chN; ++j)
+      dV[j] = cV[j].b;
+
+    _cmApDeinterleave( sp + n0*chN, n1, chN, dV, gV, mV );
+  }
+
+  for(j=0; j<chN; ++j)
+  {
+    cmApCh* cp = cV + j;
+
+    if( cmIsFlag(cp->fl,kMeterApFl) )
+    {
+      bool enaFl = cmIsFlag(cp->fl,kChApFl) && cmIsFlag(cp->fl,kMuteApFl)==false;
+      cp->m[cp->mi] = enaFl ? mV[j] / frmN : 0;
+      cp->mi        = (cp->mi + 1) % cp->mn;
+    }
+
+    cp->ii = (ii + frmN) % ip->n;
+    cmThUIntIncr(&cp->fn,frmN);
+  }
+
+  return true;
+}
+
+// Fill an outgoing packet from the output channel buffers in a single pass.
+// The conditions for using this path are the same as _cmApBlockXferIn() 
+// with the additional requirement that none of the channels would underflow.
+// Returns false if the packet must be handled by the per-channel path.
+bool _cmApBlockXferOut( cmApIO* op, cmApAudioPacket_t* pp )
+{
+  unsigned chN  = pp->chCnt;
+  unsigned frmN = pp->audioFramesCnt;
+  cmApCh*  cV   = op->chArray + pp->begChIdx;
+  unsigned oi;
+  unsigned j;
+
+  if( op->srateMult != 1 || chN == 0 || frmN == 0 || frmN > op->n )
+    return false;
+
+  assert( pp->begChIdx + chN <= op->chCnt );
+
+  oi = cV[0].oi;
+
+  // Note that 'fn' may only be increased by the client thread while this function is
+  // running therefore checking it once here is sufficient to prevent an underflow.
+  for(j=0; j<chN; ++j)
+    if( cV[j].oi != oi || cmIsFlag(cV[j].fl,kToneApFl) || cV[j].fn < frmN )
+      return false;
+
+  cmApSample_t* dp = (cmApSample_t*)pp->audioBytesPtr;
+  unsigned      n0 = cmMin(frmN, op->n - oi);
+  unsigned      n1 = frmN - n0;
+  cmApSample_t* sV[ chN ];
+  cmApSample_t  gV[ chN ];
+  cmApSample_t  mV[ chN ];
+
+  for(j=0; j<chN; ++j)
+  {
+    bool enaFl = cmIsFlag(cV[j].fl,kChApFl) && cmIsFlag(cV[j].fl,kMuteApFl)==false;
+    sV[j] = cV[j].b + oi;
+    gV[j] = enaFl ? cV[j].gain : 0;
+    mV[j] = 0;
+  }
+
+  _cmApInterleave( sV, n0, chN, dp, gV, mV );
+
+  if( n1 > 0 )
+  {
+    for(j=0; j<chN; ++j)
+      sV[j] = cV[j].b;
+
+    _cmApInterleave( sV, n1, chN, dp + n0*chN, gV, mV );
+  }
+
+  for(j=0; j<chN; ++j)
+  {
+    cmApCh* cp = cV + j;
+
+    if( cmIsFlag(cp->fl,kMeterApFl) )
+    {
+      cp->m[cp->mi] = mV[j] / frmN;
+      cp->mi        = (cp->mi + 1) % cp->mn;
+    }
+
+    cp->oi = (oi + frmN) % op->n;
+    cmThUIntDecr(&cp->fn,frmN);
+  }
+  
+  return true;
+}
+
 void _cmApChFinalize( cmApCh* chPtr )
 {
   cmMemPtrFree( &chPtr->b );
   cmMemPtrFree( &chPtr->m );
+  cmRsmpFree( &chPtr->rsmp );
 }
 
-// n=buf sample cnt mn=meter buf smp cnt
-void _cmApChInitialize( cmApCh* chPtr, unsigned n, unsigned mn )
+// n=buf sample cnt mn=meter buf smp cnt upFact/dnFact=device to internal (input) or internal to device (output) srate conversion
+void _cmApChInitialize( cmApCh* chPtr, unsigned n, unsigned mn, unsigned upFact, unsigned dnFact )
 {
   _cmApChFinalize(chPtr);
 
@@ -306,7 +531,7 @@ void _cmApChInitialize( cmApCh* chPtr, unsigned n, unsigned mn )
   chPtr->mn   = mn;
   chPtr->m    = cmMemAllocZ(cmApSample_t,mn);
   chPtr->mi   = 0;
-
+  chPtr->rsmp = upFact==dnFact ? NULL : cmRsmpAlloc(upFact,dnFact,kMedRsmpQ);
 }
 
 void _cmApIoFinalize( cmApIO* ioPtr )
@@ -320,9 +545,10 @@ void _cmApIoFinalize( cmApIO* ioPtr )
   ioPtr->n     = 0;
 }
 
-void _cmApIoInitialize( cmApIO* ioPtr, double srate, unsigned framesPerCycle, unsigned chCnt, unsigned n, unsigned meterBufN, unsigned dspFrameCnt, int srateMult )
+void _cmApIoInitialize( cmApIO* ioPtr, bool inFl, double srate, unsigned framesPerCycle, unsigned chCnt, unsigned n, unsigned meterBufN, unsigned dspFrameCnt, int srateMult )
 {
   unsigned i;
+  unsigned devFact,intFact;
 
   if( srateMult == 0 )
     srateMult = 1;
@@ -343,8 +569,12 @@ void _cmApIoInitialize( cmApIO* ioPtr, double srate, unsigned framesPerCycle, un
   ioPtr->timeStamp.tv_nsec = 0;
   ioPtr->ioFrameCnt        = 0;
 
+  // relative device and internal sample rates
+  devFact = srateMult<0 ? -srateMult : 1;
+  intFact = srateMult<0 ? 1 : srateMult;
+
   for(i=0; i<chCnt; ++i )
-    _cmApChInitialize( ioPtr->chArray + i, ioPtr->n, meterBufN );
+    _cmApChInitialize( ioPtr->chArray + i, ioPtr->n, meterBufN, inFl ? intFact : devFact, inFl ? devFact : intFact );
 
 }
 
@@ -366,7 +596,7 @@ void _cmApDevInitialize( cmApDev* dp, double srate, unsigned iFpC, unsigned iChC
     unsigned chCnt = i==kInApIdx ? iChCnt     : oChCnt;
     unsigned bufN  = i==kInApIdx ? iBufN      : oBufN;
     unsigned fpc   = i==kInApIdx ? iFpC       : oFpC;
-    _cmApIoInitialize( dp->ioArray+i, srate, fpc, chCnt, bufN, meterBufN, dspFrameCnt, srateMult );
+    _cmApIoInitialize( dp->ioArray+i, i==kInApIdx, srate, fpc, chCnt, bufN, meterBufN, dspFrameCnt, srateMult );
 
   }
       
@@ -381,6 +611,7 @@ cmAbRC_t cmApBufInitialize( unsigned devCnt, unsigned meterMs )
 
   _cmApBuf.devArray        = cmMemAllocZ( cmApDev, devCnt );
   _cmApBuf.devCnt          = devCnt;
+  _cmApBuf.blockXferFl     = true;
   cmApBufSetMeterMs(meterMs);
 
   return kOkAbRC;
@@ -499,6 +730,10 @@ cmAbRC_t cmApBufUpdate(
       if( ip->timeStamp.tv_sec==0 && ip->timeStamp.tv_nsec==0 )
         ip->timeStamp = pp->timeStamp;
 
+      // transfer all channels of the packet in one pass if possible
+      if( _cmApBuf.blockXferFl && _cmApBlockXferIn(ip,pp) )
+        continue;
+
       // for each source packet channel and enabled dest channel
       for(j=0; j<pp->chCnt; ++j)
       {
@@ -516,8 +751,10 @@ cmAbRC_t cmApBufUpdate(
         // if the incoming samples would go off the end of the buffer then 
         // copy in the samples in two segments (one at the end and another at begin of dest channel)
         
+        // disabled and muted channels are filled with zeros (see _cmApBlockXferIn())
         bool                enaFl = cmIsFlag(cp->fl,kChApFl) && cmIsFlag(cp->fl,kMuteApFl)==false;
-        const cmApSample_t* sp    = enaFl ? ((cmApSample_t*)pp->audioBytesPtr) + j : _cmApBuf.zeroBuf;
+        const cmApSample_t* sp    = ((cmApSample_t*)pp->audioBytesPtr) + j;
+        double              gain  = enaFl ? cp->gain : 0;
         //unsigned            ssn   = enaFl ? pp->chCnt : 1;  // stride (packet samples are interleaved)
         //cmApSample_t*       dp    = cp->b + cp->ii;
         //const cmApSample_t* ep    = dp    + n0;
@@ -526,7 +763,7 @@ cmAbRC_t cmApBufUpdate(
         // update the meter
         if( cmIsFlag(cp->fl,kMeterApFl) )
         {
-          cp->m[cp->mi] = _cmApMeter(sp,pp->audioFramesCnt,pp->chCnt);
+          cp->m[cp->mi] = enaFl ? _cmApMeter(sp,pp->audioFramesCnt,pp->chCnt) : 0;
           cp->mi = (cp->mi + 1) % cp->mn;
         }
 
@@ -545,7 +782,7 @@ cmAbRC_t cmApBufUpdate(
 
           unsigned pi = cp->ii;
           
-          cp->ii =  _cmApCopyInSamples( (cmApSample_t*)pp->audioBytesPtr, pp->audioFramesCnt, pp->chCnt, j, cp->b, ip->n, cp->ii, ip->srateMult, cp->gain, &cp->s0 );
+          cp->ii =  _cmApCopyInSamples( (cmApSample_t*)pp->audioBytesPtr, pp->audioFramesCnt, pp->chCnt, j, cp->b, ip->n, cp->ii, cp->rsmp, gain, &incrSmpN );
 
           if( false )
             if( j == 2 && _cmApBuf.abufIdx < 16384 )
@@ -559,9 +796,6 @@ cmAbRC_t cmApBufUpdate(
 
             }
 
-
-          incrSmpN = cp->ii > pi ? cp->ii-pi : (ip->n-pi) + cp->ii;
-                    
         }
 
         cmThUIntIncr(&cp->fn,incrSmpN);
@@ -581,6 +815,10 @@ cmAbRC_t cmApBufUpdate(
       if( op->timeStamp.tv_sec==0 && op->timeStamp.tv_nsec==0 )
         op->timeStamp = pp->timeStamp;
 
+      // transfer all channels of the packet in one pass if possible
+      if( _cmApBuf.blockXferFl && _cmApBlockXferOut(op,pp) )
+        continue;
+
       // for each dest packet channel and enabled source channel
       for(j=0; j<pp->chCnt; ++j)
       {
@@ -629,10 +867,7 @@ cmAbRC_t cmApBufUpdate(
           //const cmApSample_t* sp = enaFl ? cp->b + cp->oi : _cmApBuf.zeroBuf;
           //const cmApSample_t* ep = sp + n0;
 
-          unsigned pi = cp->oi;
-          cp->oi = _cmApCopyOutSamples( enaFl ? cp->b : _cmApBuf.zeroBuf, op->n, cp->oi, (cmApSample_t*)pp->audioBytesPtr, pp->audioFramesCnt, pp->chCnt, j, op->srateMult, cp->gain, &cp->s0 );
-
-          decrSmpN = cp->oi>pi ? cp->oi-pi : (op->n-pi) + cp->oi;
+          cp->oi = _cmApCopyOutSamples( cp->b, op->n, cp->oi, (cmApSample_t*)pp->audioBytesPtr, pp->audioFramesCnt, pp->chCnt, j, cp->rsmp, enaFl ? cp->gain : 0, &decrSmpN );
 
           /*
           if( false )
@@ -1073,6 +1308,103 @@ void cmApBufReport( cmRpt_t* rpt )
   }
 }
 
+// Time the per-channel and block transfer paths of cmApBufUpdate() 
+// for a range of channel counts and verify that they produce the same output
+// and meter values. Input channel 0 is muted and output channel 1 is disabled
+// to verify that both paths apply the same channel gain.
+void _cmApBufXferBenchmark( cmRpt_t* rpt )
+{
+  unsigned chCntV[]       = { 2, 8, 16, 32, 64, 128 };
+  unsigned chCntN         = sizeof(chCntV)/sizeof(chCntV[0]);
+  unsigned devIdx         = 0;
+  unsigned framesPerCycle = 128;
+  unsigned cycleCnt       = 3;
+  unsigned iterCnt        = 2000;
+  double   srate          = 96000.0;
+  unsigned i,j,k;
+
+  cmRptPrintf(rpt,"cmApBufUpdate() frames/cycle:%i srate:%f\n",framesPerCycle,srate);
+
+  for(i=0; i<chCntN; ++i)
+  {
+    unsigned          chCnt = chCntV[i];
+    unsigned          smpN  = framesPerCycle * chCnt;
+    cmApSample_t*     iSig  = cmMemAllocZ(cmApSample_t,smpN);
+    cmApSample_t*     oSig  = cmMemAllocZ(cmApSample_t,2*smpN);
+    cmApSample_t*     mtrV  = cmMemAllocZ(cmApSample_t,4*chCnt); // mtrV[path][in/out][chCnt]
+    unsigned          usV[2];
+    cmApAudioPacket_t ipkt, opkt;
+
+    for(j=0; j<smpN; ++j)
+      iSig[j] = (cmApSample_t)sin(2.0*M_PI*j/(smpN-1));
+
+    memset(&ipkt,0,sizeof(ipkt));
+    ipkt.chCnt          = chCnt;
+    ipkt.audioFramesCnt = framesPerCycle;
+    ipkt.bitsPerSample  = 32;
+    ipkt.flags          = kInterleavedApFl | kFloatApFl;
+    ipkt.audioBytesPtr  = iSig;
+    opkt = ipkt;
+
+    // k==0 per-channel path k==1 block path
+    for(k=0; k<2; ++k)
+    {
+      cmTimeSpec_t t0,t1;
+
+      cmApBufInitialize(1,50);
+      cmApBufSetup(devIdx,srate,framesPerCycle,cycleCnt,chCnt,framesPerCycle,chCnt,framesPerCycle,1);
+      cmApBufEnableMeter(devIdx,-1,kInApFl  | kEnableApFl);
+      cmApBufEnableMeter(devIdx,-1,kOutApFl | kEnableApFl);
+      cmApBufSetGain(devIdx,-1,kInApFl,0.5);
+      cmApBufEnableMute(devIdx,0,kInApFl | kEnableApFl);
+      cmApBufEnableChannel(devIdx,1,kOutApFl);
+      cmApBufPrimeOutput(devIdx,1);
+
+      _cmApBuf.blockXferFl = k==1;
+      opkt.audioBytesPtr   = oSig + k*smpN;
+
+      cmTimeGet(&t0);
+      for(j=0; j<iterCnt; ++j)
+      {
+        opkt.audioFramesCnt = framesPerCycle;
+        cmApBufUpdate(&ipkt,1,&opkt,1);
+        cmApBufInputToOutput(devIdx,devIdx);
+      }
+      cmTimeGet(&t1);
+
+      usV[k] = cmTimeElapsedMicros(&t0,&t1);
+
+      for(j=0; j<chCnt; ++j)
+      {
+        mtrV[ (2*k+0)*chCnt + j ] = cmApBufMeter(devIdx,j,kInApFl);
+        mtrV[ (2*k+1)*chCnt + j ] = cmApBufMeter(devIdx,j,kOutApFl);
+      }
+
+      cmApBufFinalize();
+    }
+
+    cmApSample_t maxErr = 0;
+    for(j=0; j<smpN; ++j)
+      maxErr = cmMax(maxErr,fabsf(oSig[j]-oSig[smpN+j]));
+
+    cmApSample_t maxMtrErr = 0;
+    for(j=0; j<2*chCnt; ++j)
+      maxMtrErr = cmMax(maxMtrErr,fabsf(mtrV[j]-mtrV[2*chCnt+j]));
+
+    // the muted input and the disabled output channel must be silent in both paths
+    for(k=0; k<2; ++k)
+      if( mtrV[(2*k+0)*chCnt+0] != 0 || mtrV[(2*k+1)*chCnt+1] != 0 || oSig[k*smpN+1] != 0 || oSig[k*smpN+chCnt] != 0 )
+        cmRptPrintf(rpt,"ch:%4i %s path: muted or disabled channel is not silent.\n",chCnt, k==0 ? "per-ch" : "block");
+
+    cmRptPrintf(rpt,"ch:%4i per-ch:%8.3f us/cycle  block:%8.3f us/cycle  speedup:%6.2f  max err:%g  max meter err:%g\n",
+      chCnt, (double)usV[0]/iterCnt, (double)usV[1]/iterCnt, usV[1]==0 ? 0.0 : (double)usV[0]/usV[1], maxErr, maxMtrErr );
+
+    cmMemFree(mtrV);
+    cmMemFree(iSig);
+    cmMemFree(oSig);
+  }
+}
+
 //{ { label:cmApBufExample }
 //(
 // cmApBufTest() demonstrates the audio buffer usage.
@@ -1177,6 +1509,8 @@ void cmApBufTest( cmRpt_t* rpt )
   cmRptPrintf(rpt,"\n");
 
   cmApBufFinalize();
+
+  _cmApBufXferBenchmark(rpt);
 }
 
 //)
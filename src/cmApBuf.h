@@ -64,7 +64,7 @@ extern "C" {
     unsigned inFramesPerCycle,    //< maximum number of incoming sample frames on an audio port cycle
     unsigned outChCnt,            //< output channel count on this device
     unsigned outFramesPerCycle,   //< maximum number of outgoing sample frames in an audio port cycle
-    int      srateMult );         //< sample rate cvt (positive for upsample, negative for downsample)
+    int      srateMult );         //< sample rate cvt (positive for upsample, negative for downsample) using a polyphase FIR (see cmResample.h)
 
   // Prime the buffer with 'audioCycleCnt' * outFramesPerCycle samples ready to be played
   cmAbRC_t cmApBufPrimeOutput( unsigned devIdx, unsigned audioCycleCnt );
@@ -12,6 +12,8 @@
 #include "cmSymTbl.h"
 #include "cmJson.h"
 #include "cmFileSys.h"
+#include "cmComplexTypes.h"
+#include "cmFftPlanCache.h"
 #include "cmPrefs.h"
 #include "cmTime.h"
 #include "cmAudioPort.h"
@@ -85,6 +87,7 @@ typedef struct
   void*              cbDataPtr;
   cmJsonH_t          sysJsH;
   const cmChar_t*    sysJsFn;
+  cmFileSysH_t       fpcFsH;    // locates the FFTW wisdom files (see cmFpcInitialize())
   cmUdpNetH_t        netH; 
   cmDspSysH_t        dsH;
   cmAudioSysH_t      asH;
@@ -643,6 +646,15 @@ cmAdRC_t _cmAudDspFree( cmAd_t* p )
     goto errLabel;
   }
 
+  // save the FFTW wisdom gathered by the DSP programs and release the cached plans
+  if( cmFileSysIsValid(p->fpcFsH) )
+  {
+    if( cmFpcFinalize() != kOkFpcRC )
+      cmErrWarnMsg(&p->err,kFileSysFailAdRC,"The FFT plan cache finalization failed.");
+
+    cmFileSysFinalize(&p->fpcFsH);
+  }
+
   if( cmUdpNetFree(&p->netH) != kOkUnRC )
   {
     rc = cmErrMsg(&p->err,kNetSysFailAdRC,"UDP Network finalization failed.");
@@ -814,6 +826,15 @@ cmAdRC_t cmAudDspAlloc( cmCtx_t* ctx, cmAdH_t* hp, cmMsgSendFuncPtr_t cbFunc, vo
   if((rc = _cmAdSetup(p)) != kOkAdRC )
     goto errLabel;
 
+  // Load the FFTW wisdom from the application prefs. directory. The DSP programs
+  // create their FFT plans when they are loaded - which happens outside of the
+  // audio thread - therefore the plans may be measured.
+  if( cmFileSysInitialize(&p->fpcFsH,ctx,cmFsAppName()) != kOkFsRC )
+    cmErrWarnMsg(&p->err,kFileSysFailAdRC,"The FFT plan cache file system initialization failed. FFTW wisdom will not be used.");
+  else
+    if( cmFpcInitialize(ctx,p->fpcFsH,kMeasureFpcFl) != kOkFpcRC )
+      cmErrWarnMsg(&p->err,kFileSysFailAdRC,"The FFT plan cache initialization failed.");
+
   // initialize the DSP system
   if( cmDspSysInitialize(ctx,&p->dsH,p->netH,p->serialPortH) )
   {
@@ -1174,6 +1195,80 @@ cmAdRC_t _cmAudDspPrintPgm( cmAd_t* p, unsigned asSubSysIdx, const cmChar_t* fn
   return rc;
 }
 
+cmAdRC_t _cmAudDspEnableProfile( cmAd_t* p, unsigned asSubSysIdx, bool enableFl, unsigned reportCycleCnt )
+{
+  cmAdRC_t rc = kOkAdRC;
+  unsigned i;
+
+  if((rc = _cmAdIsAudioSysLoaded(p)) != kOkAdRC )
+    return cmErrMsg(&p->err,rc,"The audio system is not configured. DSP profile enable failed.");
+
+  if( asSubSysIdx!=cmInvalidIdx && asSubSysIdx >= p->dsSsCnt )
+    return cmErrMsg(&p->err,kInvalidSubSysIdxAdRC,"The sub-system index %i is invalid. DSP profile enable failed.",asSubSysIdx);
+
+  for(i=0; i<p->dsSsCnt; ++i)
+    if(  i==asSubSysIdx || asSubSysIdx==cmInvalidIdx )
+      if( cmDspSysProfileEnable(p->dsSsArray[i].dsH,enableFl,reportCycleCnt) != kOkDspRC )
+        rc = cmErrMsg(&p->err,kDspSysFailAdRC,"The DSP profile enable failed on sub-system %i.",i);
+
+  return rc;
+}
+
+// Form the file name <dir>/<fn>_<ssIdx>.<ext> from 'fn'. Release the returned file name with cmFsFreeFn().
+const cmChar_t* _cmAudDspSubSysFn( const cmChar_t* fn, unsigned ssIdx )
+{
+  cmFileSysPathPart_t* pp;
+  const cmChar_t*      ssFn;
+  cmChar_t*            s;
+  unsigned             sn;
+
+  if((pp = cmFsPathParts(fn)) == NULL )
+    return NULL;
+
+  sn   = strlen(cmStringNullGuard(pp->fnStr)) + 16;
+  s    = cmMemAlloc(cmChar_t,sn);
+  snprintf(s,sn,"%s_%i",cmStringNullGuard(pp->fnStr),ssIdx);
+  ssFn = cmFsMakeFn(pp->dirStr,s,pp->extStr,NULL);
+
+  cmMemFree(s);
+  cmFsFreePathParts(pp);
+  return ssFn;
+}
+
+cmAdRC_t _cmAudDspWriteProfile( cmAd_t* p, unsigned asSubSysIdx, const cmChar_t* fn )
+{
+  cmAdRC_t rc = kOkAdRC;
+  unsigned i;
+
+  if((rc = _cmAdIsAudioSysLoaded(p)) != kOkAdRC )
+    return cmErrMsg(&p->err,rc,"The audio system is not configured. DSP profile write failed.");
+
+  if( asSubSysIdx!=cmInvalidIdx && asSubSysIdx >= p->dsSsCnt )
+    return cmErrMsg(&p->err,kInvalidSubSysIdxAdRC,"The sub-system index %i is invalid. DSP profile write failed.",asSubSysIdx);
+
+  for(i=0; i<p->dsSsCnt; ++i)
+    if(  i==asSubSysIdx || asSubSysIdx==cmInvalidIdx )
+    {
+      const cmChar_t* ssFn = fn;
+
+      // when the profile of every sub-system is written the sub-system index is appended to each file name
+      if( asSubSysIdx==cmInvalidIdx && p->dsSsCnt > 1 )
+        if((ssFn = _cmAudDspSubSysFn(fn,i)) == NULL )
+        {
+          rc = cmErrMsg(&p->err,kFileSysFailAdRC,"The DSP profile file name for sub-system %i could not be formed from '%s'.",i,cmStringNullGuard(fn));
+          continue;
+        }
+
+      if( cmDspSysProfileWrite(p->dsSsArray[i].dsH,ssFn) != kOkDspRC )
+        rc = cmErrMsg(&p->err,kDspSysFailAdRC,"The DSP profile write failed on sub-system %i.",i);
+
+      if( ssFn != fn )
+        cmFsFreeFn(ssFn);
+    }
+
+  return rc;
+}
+
 cmAdRC_t _cmAdReinitAudioSys( cmAd_t* p )
 {
   cmAdRC_t rc = kOkAdRC;
@@ -1492,6 +1587,14 @@ cmAdRC_t cmAudDspReceiveClientMsg( cmAdH_t h, unsigned msgByteCnt, const void* m
       _cmAudDspPrintPgm(p,m->asSubIdx,cmDsvStrcz(&m->value));
       break;
 
+    case kDspProfileDuiId:
+      rc = _cmAudDspEnableProfile(p,m->asSubIdx,m->flags,cmDsvUInt(&m->value));
+      break;
+
+    case kDspProfileWriteDuiId:
+      rc = _cmAudDspWriteProfile(p,m->asSubIdx,cmDsvStrcz(&m->value));
+      break;
+
     default:
       if( cmAudioSysDeliverMsg(p->asH,msg,msgByteCnt,cmInvalidId) != kOkAsRC )
         rc = cmErrMsg(&p->err,kSendMsgFailAdRC,"Message delivery to the audio system failed.");
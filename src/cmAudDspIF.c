@@ -65,6 +65,17 @@ cmRC_t _cmAiDispatchMsgToClient(void* cbDataPtr, unsigned msgByteCnt, const void
       }
       break;
 
+    case kDspProfileSelAsId:
+      {
+        // handle a DSP profile message
+        const char*                       base = (const char*)msgDataPtr;
+        const cmAudioSysDspProfile_t*     r    = (const cmAudioSysDspProfile_t*)(base + (2 * sizeof(unsigned)));
+        const cmAudioSysDspProfileInst_t* ia   = (const cmAudioSysDspProfileInst_t*)(r + 1);
+        if( p->parms.dispatchRecd.profileFunc != NULL )
+          rc = p->parms.dispatchRecd.profileFunc(p->parms.dispatchRecd.cbDataPtr, r, ia );
+      }
+      break;
+
     case kUiSelAsId:
       {
         bool          jsFl = false;
@@ -274,6 +285,12 @@ cmAiRC_t        cmAdIfEnableAudio( cmAiH_t h, bool enableFl )
 cmAiRC_t        cmAdIfEnableStatusNotify( cmAiH_t h, bool enableFl )
 { return _cmAdIfSendIntMsg(h,kSetNotifyEnableDuiId,cmInvalidIdx,enableFl,cmInvalidIdx,0.0,NULL); }
 
+cmAiRC_t        cmAdIfEnableDspProfile( cmAiH_t h, unsigned asSubIdx, bool enableFl, unsigned reportCycleCnt )
+{ return _cmAdIfSendIntMsg(h,kDspProfileDuiId,asSubIdx,enableFl,reportCycleCnt,0.0,NULL); }
+
+cmAiRC_t        cmAdIfWriteDspProfile(  cmAiH_t h, unsigned asSubIdx, const cmChar_t* fn )
+{ return _cmAdIfSendIntMsg(h,kDspProfileWriteDuiId,asSubIdx,0,cmInvalidIdx,0.0,fn); }
+
 cmAiRC_t        cmAdIfSendMsgToAudioDSP( 
   cmAiH_t             h, 
   unsigned            asSubIdx,
@@ -77,6 +77,7 @@ extern "C" {
     cmRC_t (*ssInitFunc)( void* cbDataPtr, const cmAudioSysSsInitMsg_t* r, const char* iDevLabel, const char* oDevLabel );
     cmRC_t (*statusFunc)( void* cbDataPtr, const cmAudioSysStatus_t* r, const double* iMeterArray, const double* oMeterArray );
     cmRC_t (*uiFunc)(     void* cbDataPtr, const cmDspUiHdr_t* r );
+    cmRC_t (*profileFunc)(void* cbDataPtr, const cmAudioSysDspProfile_t* r, const cmAudioSysDspProfileInst_t* instArray ); // optional - may be NULL
   } cmAdIfDispatch_t;
 
   typedef struct
@@ -146,6 +147,17 @@ extern "C" {
 
   // Enable/disable periodic audio system status notifications.
   cmAiRC_t        cmAdIfEnableStatusNotify( cmAiH_t h, bool enableFl );
+
+  // Enable/disable DSP instance execution profiling. If reportCycleCnt is 
+  // non-zero then profile messages are delivered to cmAdIfDispatch_t.profileFunc
+  // every reportCycleCnt DSP cycles. See cmDspSysProfileEnable().
+  cmAiRC_t        cmAdIfEnableDspProfile( cmAiH_t h, unsigned asSubIdx, bool enableFl, unsigned reportCycleCnt );
+
+  // Write the DSP instance execution profile to a CSV (.csv) or JSON file.
+  // If asSubIdx is cmInvalidIdx and the audio system has more than one
+  // sub-system then the profile of each sub-system is written to
+  // <dir>/<fn>_<asSubIdx>.<ext>.
+  cmAiRC_t        cmAdIfWriteDspProfile(  cmAiH_t h, unsigned asSubIdx, const cmChar_t* fn );
   
   // Send a kUiSelAsId style message to the audio DSP system.
   cmAiRC_t        cmAdIfSendMsgToAudioDSP( 
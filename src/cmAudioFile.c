@@ -12,15 +12,10 @@
 #include "cmMath.h"
 #include "cmFileSys.h"
 #include "cmRptFile.h"
+#include "cmThread.h"
+#include "cmVectOpsSimd.h"
 
 
-// #define _24to32_aif( p ) ((int)( ((p[0]>127?255:0) << 24) + (((int)p[0]) << 16) +  (((int)p[1]) <<8) + p[2]))  // no-swap equivalent
-// See note in:_cmAudioFileReadFileHdr()
-// Note that this code byte swaps as it converts - this is to counter the byte swap that occurs in cmAudioFileReadInt().
-#define _24to32_aif( p ) ((int)( ((p[0]>127?255:0) <<  0) + (((int)p[2]) << 24) +  (((int)p[1]) <<16) + (((int)p[0]) << 8)))
-
-#define _24to32_wav( p ) ((int)( ((p[2]>127?255:0) << 24) + (((int)p[2]) << 16) +  (((int)p[1]) <<8) + p[0]))
-
 #define _cmAfSwap16(v)  cmSwap16(v)
 #define _cmAfSwap32(v)  cmSwap32(v)
 
@@ -46,13 +41,48 @@ enum
 
 enum { kWriteAudioGutsFl=0x01 };
 
+enum
+{
+  kAfConvPartByteCnt = 256*1024,  // raw sample bytes converted by each partition per chunk (L2 sized)
+  kAfConvTmpSmpCnt   = 2048,      // minimum count of samples in the interleaved sample buffer of each partition
+  kAfConvMinFrmCnt   = 4096       // minimum count of frames in a partition converted by a worker thread
+};
+
+struct cmAf_str;
+
+// Sample conversion state for one partition of a chunk.
+// Each partition is run as one task on cmAf_t.poolH.
+typedef struct _cmAfConv_str
+{
+  struct cmAf_str* p;
+  unsigned         begFrmIdx;  // first chunk frame in this partition
+  unsigned         frmCnt;     // count of frames in this partition
+  double*          tV;         // tV[tN] interleaved float or double samples
+  unsigned         tN;         // always at least one frame of the file (see _cmAudioFileConvSetup())
+} _cmAfConv_t;
+
+// Conversion request shared by all partitions of a chunk.
+typedef struct
+{
+  bool           wrFl;      // convert fbuf/dbuf to rawV (write) or rawV to fbuf/dbuf (read)
+  unsigned       fmtId;     // kXXXPcmVsId sample format
+  unsigned       rawChCnt;  // count of channels in each frame of rawV[]
+  unsigned       chIdx;     // first raw channel to read
+  unsigned       chCnt;     // count of channels in fbuf[] or dbuf[]
+  unsigned       bufFrmIdx; // index into fbuf[]/dbuf[] of the first chunk frame
+  float**        fbuf;      // fbuf[chCnt][] or NULL
+  double**       dbuf;      // dbuf[chCnt][] or NULL
+  double         scale;     // read: sample = scale * PCM value, write: PCM value = sample * scale
+  bool           sumFl;     // read: sum into fbuf/dbuf
+} _cmAfConvReq_t;
+
 typedef struct 
 {
   unsigned    rc;
   const char* msg;
 } cmAudioErrRecd;
 
-typedef struct
+typedef struct cmAf_str
 {
   cmErr_t              err;
   FILE*                fp;          // file handle
@@ -63,6 +93,13 @@ typedef struct
   cmAudioFileMarker_t* markArray;
   unsigned             flags;
   cmChar_t*            fn;
+
+  _cmAfConv_t*         convV;       // convV[convCnt] sample conversion partitions
+  unsigned             convCnt;
+  cmThreadPoolH_t      poolH;       // convCnt-1 worker threads (not used when convCnt==1)
+  _cmAfConvReq_t       req;         // current conversion request
+  unsigned char*       rawV;        // rawV[rawByteCnt] raw sample chunk
+  unsigned             rawByteCnt;
 } cmAf_t;
 
 cmAudioErrRecd _cmAudioFileErrArray[] = 
@@ -78,11 +115,15 @@ cmAudioErrRecd _cmAudioFileErrArray[] =
   { kInvalidFileModeAfRC, "Invalid audio file mode."},
   { kInvalidHandleAfRC,   "Invalid audio file handle."},
   { kInvalidChCountAfRC,  "Invalid channel index or count."},
+  { kRptFileFailAfRC,     "Report file create failed."},
+  { kThreadFailAfRC,      "Sample conversion thread failed."},
   { kUnknownErrAfRC,      "Uknown audio file error."}
 };
 
 cmAudioFileH_t cmNullAudioFileH = { NULL };
 
+void _cmAudioFileConvFree( cmAf_t* p );
+
 cmAf_t* _cmAudioFileHandleToPtr( cmAudioFileH_t h )
 {
   cmAf_t* p = (cmAf_t*)h.h;
@@ -854,6 +895,8 @@ cmRC_t     cmAudioFileClose( cmAudioFileH_t* h )
     p->fp = NULL;
 
     cmMemPtrFree( &(p->info.markerArray));
+    cmMemPtrFree( &p->rawV );
+    p->rawByteCnt = 0;
 
     memset(&p->info,0,sizeof(p->info));
   }
@@ -878,6 +921,8 @@ cmRC_t     cmAudioFileDelete( cmAudioFileH_t* h)
 
   cmMemPtrFree(&p->fn);
 
+  _cmAudioFileConvFree(p);
+
   cmMemPtrFree(&(h->h));
 
   return rc; 
@@ -926,6 +971,22 @@ cmRC_t     cmAudioFileSeek(       cmAudioFileH_t h, unsigned frmIdx )
 
 }
 
+// Return the kXXXPcmVsId format id of the samples in the file.
+unsigned _cmAudioFilePcmFormatId( cmAf_t* p )
+{
+  // 8 bit AIF files use 'signed char' and WAV files use 'unsigned char' for the sample data type. 
+  if( p->info.bits == 8 )
+    return cmIsFlag(p->info.flags,kAiffAfFl) ? kS8PcmVsId : kU8PcmVsId;
+
+#ifdef cmBIG_ENDIAN
+  bool beFl = !cmIsFlag(p->info.flags,kSwapSamplesAfFl);
+#else
+  bool beFl =  cmIsFlag(p->info.flags,kSwapSamplesAfFl);
+#endif
+
+  return kS16LePcmVsId + 2*(p->info.bits/8 - 2) + (beFl ? 1 : 0);
+}
+
 cmRC_t _cmAudioFileReadInt( cmAudioFileH_t h, unsigned totalFrmCnt, unsigned chIdx, unsigned chCnt, int* buf[], unsigned* actualFrmCntPtr, bool sumFl )
 {
   cmRC_t           rc  = kOkAfRC;
@@ -942,6 +1003,7 @@ cmRC_t _cmAudioFileReadInt( cmAudioFileH_t h, unsigned totalFrmCnt, unsigned chI
 
   unsigned       bps            = p->info.bits / 8;       // bytes per sample
   unsigned       bpf            = bps * p->info.chCnt;    // bytes per file frame
+  unsigned       fmtId          = _cmAudioFilePcmFormatId(p);
   unsigned       bufFrmCnt      = cmMin(totalFrmCnt,cmAudioFile_MAX_FRAME_READ_CNT);
   unsigned       bytesPerBuf    = bufFrmCnt * bpf;
   unsigned char  fbuf[ bytesPerBuf ];                     // raw bytes buffer 
@@ -971,127 +1033,254 @@ cmRC_t _cmAudioFileReadInt( cmAudioFileH_t h, unsigned totalFrmCnt, unsigned chI
     assert( chIdx+chCnt <= p->info.chCnt );
 
 
+    // decode each channel with the same PCM conversion used by the float and double read functions
     for(ci=0; ci<chCnt; ++ci)
     {
-      unsigned char* sp = fbuf + (ci+chIdx)*bps;
-      int*           dp = ptrBuf[ci];
-      int*           ep = dp + frmCnt;
+      cmVsI_FromPcm(ptrBuf[ci],frmCnt,fbuf + (ci+chIdx)*bps,bpf,fmtId,sumFl);
+      ptrBuf[ci] += frmCnt;
+    }
+
+    p->curFrmIdx += frmCnt;
+  }
+
+  if( totalReadFrmCnt < totalFrmCnt  )
+  {
+    for(ci=0; ci<chCnt; ++ci)
+      memset(buf[ci] + frmCnt,0,(totalFrmCnt-totalReadFrmCnt)*sizeof(int));
+  }
+
+
+
+  //if( actualFrmCntPtr != NULL )
+  //  *actualFrmCntPtr = totalReadFrmCnt;
+
+  //printf("SUM: %f %f swap:%i\n", sum, sum/(totalFrmCnt*chCnt), cmIsFlag(p->info.flags,kSwapAfFl));
+
+  return rc;  
+}
+
+//-----------------------------------------------------------------------------
+// Real sample conversion
+//
+// The float and double read and write functions transfer L2 cache sized chunks
+// of raw samples between the file and rawV[] and convert each chunk with the
+// cmVsF_FromPcm()/cmVsF_ToPcm() (float) or cmVsD_FromPcm()/cmVsD_ToPcm() (double) kernels.
+// Large chunks are split into partitions which are converted concurrently
+// (see cmAudioFileSetConvertThreadCount()).
+
+void _cmAudioFileDeinterleaveF( float* dp, const float* sp, unsigned n, unsigned stride, bool sumFl )
+{
+  unsigned i;
+  if( sumFl )
+    for(i=0; i<n; ++i) dp[i] += sp[i*stride];
+  else
+    for(i=0; i<n; ++i) dp[i]  = sp[i*stride];
+}
+
+void _cmAudioFileDeinterleaveD( double* dp, const double* sp, unsigned n, unsigned stride, bool sumFl )
+{
+  unsigned i;
+  if( sumFl )
+    for(i=0; i<n; ++i) dp[i] += sp[i*stride];
+  else
+    for(i=0; i<n; ++i) dp[i]  = sp[i*stride];
+}
+
+// Convert the frames of partition 't'. 
+void _cmAudioFileConvPartition( _cmAfConv_t* t )
+{
+  cmAf_t*               p   = t->p;
+  const _cmAfConvReq_t* r   = &p->req;
+  unsigned              bps = p->info.bits / 8;
+  unsigned              rcn = r->rawChCnt;
+  unsigned              bpf = bps * rcn;
+  unsigned              tfn = t->tN / rcn;  // count of frames which fit in tV[]
+  float*                tf  = (float*)t->tV;
+  double*               td  = t->tV;
+  unsigned              i,j,ci,n;
 
-      if( !sumFl )
-        memset(dp,0,frmCnt*sizeof(int));
+  for(i=0; i<t->frmCnt; i+=n)
+  {
+    unsigned       fi = t->begFrmIdx + i;  // chunk frame index
+    unsigned       bi = r->bufFrmIdx + fi; // client buffer frame index
+    unsigned char* sp = p->rawV + fi*bpf;
 
-      // 8 bit AIF files use 'signed char' and WAV files use 'unsigned char' for the sample data type. 
-      if( p->info.bits == 8 )
+    n = cmMin(t->frmCnt - i, tfn);
+
+    if( r->wrFl )
+    {
+      // interleave the channels into tV[] and encode the frames into rawV[]
+      if( r->dbuf != NULL )
       {
-        if( cmIsFlag(p->info.flags,kAiffAfFl) )
-        {
-          for(; dp<ep; sp+=bpf,++dp)
-            *dp +=  *(char*)sp;
-        }
-        else
-        {
-          for(; dp<ep; sp+=bpf,++dp)
-          {
-            int v = *(unsigned char*)sp;
-            *dp +=  v -= 128;
-          }
-        }
+        for(ci=0; ci<rcn; ++ci)
+          for(j=0; j<n; ++j)
+            td[ j*rcn + ci ] = r->dbuf[ci][bi+j];
 
+        cmVsD_ToPcm(sp,td,n*rcn,r->fmtId,r->scale);
       }
+      else
+      {
+        for(ci=0; ci<rcn; ++ci)
+          for(j=0; j<n; ++j)
+            tf[ j*rcn + ci ] = r->fbuf[ci][bi+j];
+
+        cmVsF_ToPcm(sp,tf,n*rcn,r->fmtId,r->scale);
+      }
+      continue;
+    }
 
-      // handle non-8 bit files here
-      if( cmIsFlag(p->info.flags,kSwapSamplesAfFl) )
+    // When most of the channels are read decode the frames into tV[] and deinterleave
+    // the selected channels - otherwise decode each selected channel directly.
+    if( rcn > 1 && r->chCnt*4 >= rcn )
+    {
+      if( r->dbuf != NULL )
       {
-        switch( p->info.bits )
-        {
-          case 8:
-            break;
-
-          case 16:
-            for(; dp<ep; sp+=bpf,++dp)
-              *dp += (short)_cmAfSwap16(*(short*)sp);
-            break;
-
-          case 24:
-            if( cmIsFlag(p->info.flags,kAiffAfFl) )
-            {
-              for(; dp<ep; sp+=bpf,++dp)
-                *dp += (int)(_cmAfSwap32(_24to32_aif(sp)));
-            }
-            else
-            {
-              for(; dp<ep; sp+=bpf,++dp)
-                *dp += (int)(_cmAfSwap32(_24to32_wav(sp)));
-            }
-            break;
-
-          case 32:
-            for(; dp<ep; sp+=bpf,++dp)
-              *dp += (int)_cmAfSwap32(*(int*)sp  );
-            break;
-        }
+        cmVsD_FromPcm(td,n*rcn,sp,bps,r->fmtId,r->scale);
+        for(ci=0; ci<r->chCnt; ++ci)
+          _cmAudioFileDeinterleaveD(r->dbuf[ci]+bi, td + r->chIdx + ci, n, rcn, r->sumFl );
       }
       else
       {
-        switch(p->info.bits)
+        cmVsF_FromPcm(tf,n*rcn,sp,bps,r->fmtId,r->scale);
+        for(ci=0; ci<r->chCnt; ++ci)
+          _cmAudioFileDeinterleaveF(r->fbuf[ci]+bi, tf + r->chIdx + ci, n, rcn, r->sumFl );
+      }
+    }
+    else
+    {
+      for(ci=0; ci<r->chCnt; ++ci)
+      {
+        const unsigned char* csp = sp + (r->chIdx+ci)*bps;
+
+        if( r->dbuf != NULL )
         {
-          case 8:
-            break;
-
-          case 16:
-            for(; dp<ep; sp+=bpf,++dp)
-              *dp += *(short*)sp;
-            break;
-
-          case 24:
-            if( cmIsFlag(p->info.flags,kAiffAfFl) )
-            {
-              for(; dp<ep; sp+=bpf,++dp)
-                *dp +=  _24to32_aif(sp);
-            }
-            else
-            {
-              for(; dp<ep; sp+=bpf,++dp)
-                *dp +=  _24to32_wav(sp);
-            }
-            break;
-
-          case 32:
-            for(; dp<ep; sp+=bpf,++dp)
-              *dp += *(int*)sp;
-
-
-            break;
+          if( r->sumFl )
+          {
+            cmVsD_FromPcm(td,n,csp,bpf,r->fmtId,r->scale);
+            _cmAudioFileDeinterleaveD(r->dbuf[ci]+bi, td, n, 1, true );
+          }
+          else
+            cmVsD_FromPcm(r->dbuf[ci]+bi,n,csp,bpf,r->fmtId,r->scale);
+        }
+        else
+        {
+          if( r->sumFl )
+          {
+            cmVsF_FromPcm(tf,n,csp,bpf,r->fmtId,r->scale);
+            _cmAudioFileDeinterleaveF(r->fbuf[ci]+bi, tf, n, 1, true );
+          }
+          else
+            cmVsF_FromPcm(r->fbuf[ci]+bi,n,csp,bpf,r->fmtId,r->scale);
         }
-
-        ptrBuf[ci] = dp;
-        assert( dp <= buf[ci] + totalFrmCnt );
       }
-      /*
-      dp = ptrBuf[ci];
-      ep = dp + frmCnt;
-      while(dp<ep)
-        sum += (double)*dp++;
-      */
     }
-
-    p->curFrmIdx += frmCnt;
   }
+}
 
-  if( totalReadFrmCnt < totalFrmCnt  )
+void _cmAudioFileConvTask( void* arg, unsigned taskIdx )
+{
+  cmAf_t* p = (cmAf_t*)arg;
+  _cmAudioFileConvPartition(p->convV + taskIdx);
+}
+
+void _cmAudioFileConvFree( cmAf_t* p )
+{
+  unsigned i;
+
+  if( cmThreadPoolIsValid(p->poolH) )
+    cmThreadPoolDestroy(&p->poolH);
+
+  for(i=0; i<p->convCnt; ++i)
+    cmMemPtrFree(&p->convV[i].tV);
+
+  cmMemPtrFree(&p->convV);
+  p->convCnt = 0;
+}
+
+// Allocate 'thCnt' partitions and a pool of thCnt-1 worker threads.
+cmRC_t _cmAudioFileConvAlloc( cmAf_t* p, unsigned thCnt )
+{
+  unsigned i;
+
+  _cmAudioFileConvFree(p);
+
+  p->convCnt = cmMax(1,thCnt);
+  p->convV   = cmMemAllocZ(_cmAfConv_t,p->convCnt);
+
+  for(i=0; i<p->convCnt; ++i)
+    p->convV[i].p = p;
+
+  if( p->convCnt > 1 )
+    if( cmThreadPoolCreate(&p->poolH,p->convCnt-1,p->err.rpt) != kOkThRC )
+      goto errLabel;
+
+  return kOkAfRC;
+
+ errLabel:
+  _cmAudioFileConvFree(p);
+  return _cmAudioFileError(p,kThreadFailAfRC);
+}
+
+// Prepare to convert chunks of frames of 'bpf' bytes and return the count of frames in a chunk.
+unsigned _cmAudioFileConvSetup( cmAf_t* p, unsigned bpf, cmRC_t* rcPtr )
+{
+  *rcPtr = kOkAfRC;
+
+  if( p->convV == NULL )
+    if((*rcPtr = _cmAudioFileConvAlloc(p,1)) != kOkAfRC )
+      return 0;
+
+  unsigned chunkFrmCnt = p->convCnt * cmMax(1,kAfConvPartByteCnt / bpf);
+  unsigned tN          = cmMax(kAfConvTmpSmpCnt,p->info.chCnt);
+  unsigned i;
+
+  // the interleaved sample buffers must hold at least one frame
+  for(i=0; i<p->convCnt; ++i)
+    if( p->convV[i].tN < tN )
+    {
+      p->convV[i].tN = tN;
+      p->convV[i].tV = cmMemResize(double,p->convV[i].tV,tN);
+    }
+
+  if( p->rawByteCnt < chunkFrmCnt * bpf )
   {
-    for(ci=0; ci<chCnt; ++ci)
-      memset(buf[ci] + frmCnt,0,(totalFrmCnt-totalReadFrmCnt)*sizeof(int));
+    p->rawByteCnt = chunkFrmCnt * bpf;
+    p->rawV       = cmMemResize(unsigned char,p->rawV,p->rawByteCnt);
   }
 
+  return chunkFrmCnt;
+}
 
+// Convert the first 'frmCnt' frames of the chunk according to p->req.
+void _cmAudioFileConvRun( cmAf_t* p, unsigned frmCnt )
+{
+  unsigned thCnt  = cmMax(1,cmMin(p->convCnt,frmCnt / kAfConvMinFrmCnt));
+  unsigned begIdx = 0;
+  unsigned i;
 
-  //if( actualFrmCntPtr != NULL )
-  //  *actualFrmCntPtr = totalReadFrmCnt;
+  for(i=0; i<thCnt; ++i)
+  {
+    _cmAfConv_t* t = p->convV + i;
 
-  //printf("SUM: %f %f swap:%i\n", sum, sum/(totalFrmCnt*chCnt), cmIsFlag(p->info.flags,kSwapAfFl));
+    t->begFrmIdx = begIdx;
+    t->frmCnt    = (frmCnt - begIdx) / (thCnt - i);
+    begIdx      += t->frmCnt;
+  }
 
-  return rc;  
+  if( thCnt == 1 )
+    _cmAudioFileConvPartition(p->convV);
+  else
+    cmThreadPoolRun(p->poolH,_cmAudioFileConvTask,p,thCnt);
+}
+
+cmRC_t     cmAudioFileSetConvertThreadCount( cmAudioFileH_t h, unsigned thCnt )
+{
+  cmAf_t* p = _cmAudioFileHandleToPtr(h);
+
+  if( p->convCnt == cmMax(1,thCnt) )
+    return kOkAfRC;
+
+  return _cmAudioFileConvAlloc(p,thCnt);
 }
 
 cmRC_t _cmAudioFileReadRealSamples(  cmAudioFileH_t h, unsigned totalFrmCnt, unsigned chIdx, unsigned chCnt, float**  fbuf, double** dbuf, unsigned* actualFrmCntPtr, bool sumFl )
@@ -1102,112 +1291,59 @@ cmRC_t _cmAudioFileReadRealSamples(  cmAudioFileH_t h, unsigned totalFrmCnt, uns
   if( rc != kOkAfRC )
     return rc;
 
+  if( chIdx+chCnt > p->info.chCnt )
+    return _cmAudioFileError(p,kInvalidChCountAfRC);
+
   if( actualFrmCntPtr != NULL )
     *actualFrmCntPtr = 0;
 
-
   unsigned         totalReadCnt = 0;
-  unsigned         bufFrmCnt    = cmMin( totalFrmCnt, cmAudioFile_MAX_FRAME_READ_CNT );
-  unsigned         bufSmpCnt    = bufFrmCnt * chCnt;
-  float            fltMaxSmpVal = 0;  
-
-  int              buf[ bufSmpCnt ];
-  int*             ptrBuf[ chCnt ];
-  float*           fPtrBuf[ chCnt ];
-  double*          dPtrBuf[ chCnt ];
-  unsigned         i;
-  unsigned         frmCnt = 0;
+  unsigned         frmCnt       = 0;
+  unsigned         bpf          = (p->info.bits/8) * p->info.chCnt;  // bytes per file frame
+  unsigned         chunkFrmCnt;
+  double           maxSmpVal    = 0;
 
   switch( p->info.bits )
   {
-    case 8:   fltMaxSmpVal = 0x80;       break;
-    case 16:  fltMaxSmpVal = 0x8000;     break;
-    case 24:  fltMaxSmpVal = 0x800000;   break;
-    case 32:  fltMaxSmpVal = 0x80000000; break;
+    case 8:   maxSmpVal = 0x80;       break;
+    case 16:  maxSmpVal = 0x8000;     break;
+    case 24:  maxSmpVal = 0x800000;   break;
+    case 32:  maxSmpVal = 0x80000000; break;
     default:
       return _cmAudioFileError(p,kInvalidBitWidthAfRC);
   }
 
-  double         dblMaxSmpVal = fltMaxSmpVal;
-
-  // initialize the audio ptr buffers
-  for(i=0; i<chCnt; ++i)
-  {
-    ptrBuf[i] = buf + (i*bufFrmCnt);
-
-    if( dbuf != NULL )
-      dPtrBuf[i] = dbuf[i];
-
-    if( fbuf != NULL )
-      fPtrBuf[i] = fbuf[i];
+  if((chunkFrmCnt = _cmAudioFileConvSetup(p,bpf,&rc)) == 0 )
+    return rc;
 
-  }
+  p->req.wrFl     = false;
+  p->req.fmtId    = _cmAudioFilePcmFormatId(p);
+  p->req.rawChCnt = p->info.chCnt;
+  p->req.chIdx    = chIdx;
+  p->req.chCnt    = chCnt;
+  p->req.fbuf     = fbuf;
+  p->req.dbuf     = dbuf;
+  p->req.scale    = 1.0 / maxSmpVal;
+  p->req.sumFl    = sumFl;
 
-  // 
   for(totalReadCnt=0; totalReadCnt<totalFrmCnt && p->curFrmIdx < p->info.frameCnt; totalReadCnt+=frmCnt)
   {
-    unsigned actualReadFrmCnt = 0;
-    frmCnt = cmMin( p->info.frameCnt - p->curFrmIdx, cmMin( totalFrmCnt-totalReadCnt, bufFrmCnt ) );
+    frmCnt = cmMin( p->info.frameCnt - p->curFrmIdx, cmMin( totalFrmCnt-totalReadCnt, chunkFrmCnt ) );
 
-    // fill the integer audio buffer from the file
-    if((rc = _cmAudioFileReadInt( h, frmCnt, chIdx, chCnt, ptrBuf, &actualReadFrmCnt, false )) != kOkAfRC )
+    // read the raw samples
+    if((rc = _cmAudioFileRead(p,p->rawV,frmCnt*bpf,1)) != kOkAfRC )
       return rc;
 
-    if( actualFrmCntPtr != NULL )
-      *actualFrmCntPtr += actualReadFrmCnt;
-
-    // convert the integer buffer to floating point
-    for(i=0; i<chCnt; ++i)
-    {
-
-      int* sp = ptrBuf[i];
-
-      if( fbuf != NULL )
-      {
-
-        float* dp  = fPtrBuf[i];
-        float* ep = dp + frmCnt;
+    // convert them into the client buffers
+    p->req.bufFrmIdx = totalReadCnt;
+    _cmAudioFileConvRun(p,frmCnt);
 
-        if( sumFl )
-        {
-          for(; dp<ep; ++dp,++sp)
-            *dp += ((float)*sp) / fltMaxSmpVal;
-
-        }
-        else
-        {
-          for(; dp<ep; ++dp,++sp)
-            *dp = ((float)*sp) / fltMaxSmpVal;
-        }
-
-        assert( dp <= fbuf[i] + totalFrmCnt );
-
-        fPtrBuf[i] = dp;
-      }
-      else
-      {
-        double* dp = dPtrBuf[i];
-        double* ep = dp + frmCnt;
-
-        if( sumFl )
-        {
-          for(; dp<ep; ++dp,++sp)
-            *dp += ((double)*sp) / dblMaxSmpVal;                
-        }
-        else
-        {
-          for(; dp<ep; ++dp,++sp)
-            *dp = ((double)*sp) / dblMaxSmpVal;      
-        }
+    p->curFrmIdx += frmCnt;
 
-        assert( dp <= dbuf[i] + totalFrmCnt );
-        dPtrBuf[i] = dp;
-      }
-      
-    }
+    if( actualFrmCntPtr != NULL )
+      *actualFrmCntPtr += frmCnt;
   }
 
-
   return rc;
 }
 
@@ -1336,112 +1472,29 @@ cmRC_t    cmAudioFileWriteInt(    cmAudioFileH_t h, unsigned frmCnt, unsigned ch
     return rc;
 
   unsigned bytesPerSmp = p->info.bits / 8;
+  unsigned fmtId       = _cmAudioFilePcmFormatId(p);
   unsigned bufFrmCnt   = 1024;
   unsigned bufByteCnt  = bufFrmCnt * bytesPerSmp;
-  unsigned ci;
+  unsigned ci,j;
   unsigned wrFrmCnt    = 0;
   char     buf[ bufByteCnt * chCnt ];
+  int      ibuf[ bufFrmCnt * chCnt ];
   
   while( wrFrmCnt < frmCnt )
   {
     unsigned n = cmMin( frmCnt-wrFrmCnt, bufFrmCnt );
 
-    // interleave each channel into buf[]
+    // interleave each channel into ibuf[]
     for(ci=0; ci<chCnt; ++ci)
     {
-      // get the begin and end source pointers
       const int* sbp = srcPtrPtr[ci] + wrFrmCnt;
-      const int* sep = sbp + n;
 
-      // 8 bit samples can't be byte swapped
-      if( p->info.bits == 8 )
-      {
-        char*  dbp = buf + ci;
-        for(; sbp < sep; dbp+=chCnt )
-          *dbp = (char)*sbp++;             
-      }
-      else
-      {
-        // if the samples do need to be byte swapped
-        if( cmIsFlag(p->info.flags,kSwapSamplesAfFl) )
-        {
-          switch( p->info.bits )
-          {
-            case 16:
-              {
-                short*  dbp = (short*)buf;
-                for(dbp+=ci; sbp < sep; dbp+=chCnt, ++sbp )
-                  *dbp = _cmAfSwap16((short)*sbp);
-              }
-              break;
-
-            case 24:
-              {
-                unsigned char* dbp = (unsigned char*)buf;
-                for( dbp+=(ci*3); sbp < sep; dbp+=(3*chCnt), ++sbp)
-                {
-                  unsigned char* s = (unsigned char*)sbp;
-                  dbp[0] = s[2];
-                  dbp[1] = s[1];
-                  dbp[2] = s[0];
-                }
-              }
-              break;
-          
-
-            case 32:
-              {
-                int*  dbp = (int*)buf;
-                for(dbp+=ci; sbp < sep; dbp+=chCnt, ++sbp )
-                  *dbp = _cmAfSwap32(*sbp);
-              }
-              break;
-
-            default:
-              { assert(0);}
-          } 
+      for(j=0; j<n; ++j)
+        ibuf[ j*chCnt + ci ] = sbp[j];
+    }
 
-        }
-        else // interleave without byte swapping
-        {
-          switch( p->info.bits )
-          {
-            case 16:
-              {
-                short*  dbp = (short*)buf;
-                for(dbp+=ci; sbp < sep; dbp+=chCnt, ++sbp )
-                  *dbp = (short)*sbp;
-              }
-              break;
-              
-            case 24:
-              {
-                unsigned char* dbp = (unsigned char*)buf;
-                for( dbp+=(ci*3); sbp < sep; dbp+=(3*chCnt), ++sbp)
-                {
-                  unsigned char* s = (unsigned char*)sbp;
-                  dbp[0] = s[0];
-                  dbp[1] = s[1];
-                  dbp[2] = s[2];
-                }
-              }
-              break;
-          
-
-            case 32:
-              {
-                int*  dbp = (int*)buf;
-                for(dbp+=ci; sbp < sep; dbp+=chCnt, ++sbp )
-                  *dbp = *sbp;
-              }
-              break;
-
-            default:
-              { assert(0);}
-          } // switch
-        } // don't swap
-      } // 8 bits
-    } // ch
+    // encode the samples with the same PCM conversion used by the float and double write functions
+    cmVsI_ToPcm(buf,ibuf,n*chCnt,fmtId);
 
     // advance the source pointer index
     wrFrmCnt+=n;
@@ -1467,17 +1520,11 @@ cmRC_t    _cmAudioFileWriteRealSamples( cmAudioFileH_t h, unsigned frmCnt, unsig
   if( rc != kOkAfRC )
     return rc;
 
-  unsigned         bufFrmCnt = 1024;
+  unsigned         bpf       = (p->info.bits/8) * chCnt;  // bytes per file frame
   unsigned         wrFrmCnt  = 0;
-  unsigned         i         = 0;
+  unsigned         chunkFrmCnt;
   int              maxSmpVal = 0;
 
-  int              buf[   chCnt * bufFrmCnt ];
-  int*             srcCh[ chCnt ];
-  
-  for(i=0; i<chCnt; ++i)
-    srcCh[i] = buf + (i*bufFrmCnt);
-
   switch( p->info.bits )
   {
     case 8:   maxSmpVal = 0x7f;       break;
@@ -1485,62 +1532,40 @@ cmRC_t    _cmAudioFileWriteRealSamples( cmAudioFileH_t h, unsigned frmCnt, unsig
     case 24:  maxSmpVal = 0x7fffff;   break;
     case 32:  maxSmpVal = 0x7fffffb0; break; // Note: the full range is not used for 32 bit numbers
     default:                                 // because it was found to cause difficult to detect overflows
-      { assert(0); }                         // when the signal approached full scale. 
+      return _cmAudioFileError(p,kInvalidBitWidthAfRC); // when the signal approached full scale. 
   }
 
-  // duplicate the audio buffer ptr array - this will allow the buffer ptr's to be changed
-  // during the float to int conversion without changing the ptrs passed in from the client
-  const void* ptrArray[ chCnt ];
-  memcpy(ptrArray,srcPtrPtr,sizeof(ptrArray));
+  if((chunkFrmCnt = _cmAudioFileConvSetup(p,bpf,&rc)) == 0 )
+    return rc;
 
-  const float**  sfpp = (const float**)ptrArray;
-  const double** sdpp = (const double**)ptrArray;
+  p->req.wrFl     = true;
+  p->req.fmtId    = _cmAudioFilePcmFormatId(p);
+  p->req.rawChCnt = chCnt;
+  p->req.chIdx    = 0;
+  p->req.chCnt    = chCnt;
+  p->req.fbuf     = realSmpByteCnt == sizeof(float)  ? (float**)srcPtrPtr  : NULL;
+  p->req.dbuf     = realSmpByteCnt == sizeof(double) ? (double**)srcPtrPtr : NULL;
+  p->req.scale    = realSmpByteCnt == sizeof(float)  ? (float)maxSmpVal : (double)maxSmpVal;
+  p->req.sumFl    = false;
 
   while( wrFrmCnt < frmCnt )
   {
-    unsigned n = cmMin( frmCnt - wrFrmCnt, bufFrmCnt );
-
-    for(i=0; i<chCnt; ++i)
-    {
-      int*       obp = srcCh[i];
-
-      switch( realSmpByteCnt )
-      {
-        case 4:
-          {
-            const float* sbp = sfpp[i];
-            const float* sep = sbp + n;
-            for(;sbp<sep; ++sbp)
-            {
-              *obp++ = (int)fmaxf(-maxSmpVal,fminf(maxSmpVal, *sbp * maxSmpVal));
-            }
-
-            sfpp[i] = sbp;
-          }
-          break;
- 
-        case 8:
-          {
-            const double* sbp = sdpp[i];
-            const double* sep = sbp + n;
-            for(; sbp<sep; ++sbp)
-            {
-              *obp++ = (int)fmax(-maxSmpVal,fmin(maxSmpVal,*sbp * maxSmpVal));
-            }
-            sdpp[i] = sbp;
-          }
-          break;
+    unsigned n = cmMin( frmCnt - wrFrmCnt, chunkFrmCnt );
 
-        default:
-          { assert(0); }
-      }  
-    }
+    // convert the client samples to raw samples
+    p->req.bufFrmIdx = wrFrmCnt;
+    _cmAudioFileConvRun(p,n);
 
-    if((rc = cmAudioFileWriteInt( h, n, chCnt, srcCh )) != kOkAfRC )
+    if( fwrite( p->rawV, n*bpf, 1, p->fp ) != 1)
+    {
+      rc = _cmAudioFileError(p,kWriteFailAfRC);
       break;
+    }
 
     wrFrmCnt += n;
   }
+
+  p->info.frameCnt += wrFrmCnt;
   
   return rc;
 }
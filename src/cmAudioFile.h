@@ -39,6 +39,7 @@ extern "C" {
     kInvalidHandleAfRC,
     kInvalidChCountAfRC,
     kRptFileFailAfRC,
+    kThreadFailAfRC,
     kUnknownErrAfRC
   };
 
@@ -202,6 +203,12 @@ extern "C" {
   cmRC_t     cmAudioFileGetSumFloat(  const char* fn, unsigned begFrmIdx, unsigned frmCnt, unsigned chIdx, unsigned chCnt, float**  buf, unsigned* actualFrmCntPtr, cmAudioFileInfo_t* afInfoPtr, cmRpt_t* rpt );
   cmRC_t     cmAudioFileGetSumDouble( const char* fn, unsigned begFrmIdx, unsigned frmCnt, unsigned chIdx, unsigned chCnt, double** buf, unsigned* actualFrmCntPtr, cmAudioFileInfo_t* afInfoPtr, cmRpt_t* rpt );
 
+  // Convert the samples of large float and double reads and writes with 'thCnt'
+  // threads (the calling thread and thCnt-1 worker threads). The default is 1.
+  // Conversion is only shared when each thread has at least 4096 frames to convert.
+  // The result of the conversion does not depend on the thread count.
+  cmRC_t     cmAudioFileSetConvertThreadCount( cmAudioFileH_t h, unsigned thCnt );
+
   // Sample Writing Functions
   cmRC_t    cmAudioFileWriteInt(    cmAudioFileH_t h, unsigned frmCnt, unsigned chCnt, int**    bufPtrPtr );
   cmRC_t    cmAudioFileWriteFloat(  cmAudioFileH_t h, unsigned frmCnt, unsigned chCnt, float**  bufPtrPtr );
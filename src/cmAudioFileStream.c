@@ -0,0 +1,890 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+#include "cmGlobal.h"
+#include "cmFloatTypes.h"
+#include "cmRpt.h"
+#include "cmErr.h"
+#include "cmCtx.h"
+#include "cmMem.h"
+#include "cmMallocDebug.h"
+#include "cmAudioFile.h"
+#include "cmThread.h"
+#include "cmVectOpsTemplateMain.h"
+
+#include "cmAudioFileStream.h"
+
+#include <pthread.h>
+
+enum
+{
+  kAfsBlkCnt          = 9,    // count of blocks in each ring (one more than the look-ahead requires)
+  kAfsMinBlkFrmCnt    = 64,   // minimum count of frames per block
+  kAfsDfltPeriodMicros= 1000, // default I/O thread sleep period
+  kAfsCacheLineByteCnt= 64    // used to keep the producer and consumer state on separate cache lines
+};
+
+#define _cmAfsLoadAcquire(addr)   __atomic_load_n((addr),__ATOMIC_ACQUIRE)
+#define _cmAfsStoreRelease(addr,v) __atomic_store_n((addr),(v),__ATOMIC_RELEASE)
+
+struct cmAfs_str;
+
+// Ring block header. The block samples are stored in cmAfsStream_t.blkMem[].
+typedef struct
+{
+  unsigned gen;     // seek generation this block was read for
+  unsigned frmIdx;  // file frame index of the first frame in the block
+  unsigned frmCnt;  // count of valid frames in the block
+  bool     eofFl;   // the end of the file follows this block
+} cmAfsBlk_t;
+
+typedef struct
+{
+  unsigned          frmIdx;  // seek target
+  unsigned          frmCnt;  // count of valid frames in the cache
+  bool              eofFl;   // the end of the file follows the cached frames
+  volatile unsigned readyFl; // set by the I/O thread once the cache is filled
+  cmSample_t*       smpV;    // smpV[ chCnt * cueFrmCnt ]
+} cmAfsCue_t;
+
+typedef struct cmAfsStream_str
+{
+  // consumer cache line
+  volatile unsigned ri;          // ring read index - only written by the consumer
+  unsigned          gen;         // current seek generation
+  unsigned          boff;        // count of frames already consumed from the block at 'ri'
+  unsigned          frmIdx;      // file frame index of the next frame to return
+  bool              eofFl;       // the consumer has reached the end of the file
+  unsigned          underrunCnt;
+  cmAfsCue_t*       cueP;        // cue being played or NULL
+  unsigned          cueOff;      // count of frames already consumed from cueP
+  volatile unsigned seekFrmIdx;  // producer start frame for generation 'seekGen'
+  volatile unsigned seekGen;     // written (release) by the consumer after 'seekFrmIdx'
+  char              pad0[ kAfsCacheLineByteCnt ];
+
+  // producer cache line
+  volatile unsigned wi;          // ring write index - only written by the I/O thread
+  unsigned          pgen;        // generation the I/O thread is currently reading for
+  unsigned          pfrmIdx;     // file frame index of the next frame to read into the ring
+  bool              peofFl;      // the I/O thread has read the last frame for 'pgen'
+  unsigned          fileFrmIdx;  // current location of the audio file
+  char              pad1[ kAfsCacheLineByteCnt ];
+
+  volatile unsigned cueCnt;      // count of valid records in cueV[] - only written by cmAfsStreamCue()
+
+  struct cmAfs_str*       p;
+  cmChar_t*               fn;
+  cmAudioFileH_t          afH;
+  cmAudioFileInfo_t       afInfo;
+  unsigned                chIdx;
+  unsigned                chCnt;
+  unsigned                blkFrmCnt;   // frames per ring block
+  cmAfsBlk_t              blkV[ kAfsBlkCnt ];
+  cmSample_t*             blkMem;      // blkMem[ kAfsBlkCnt * chCnt * blkFrmCnt ]
+  unsigned                cueFrmCnt;   // frames per cue cache
+  unsigned                maxCueCnt;
+  cmAfsCue_t*             cueV;        // cueV[ maxCueCnt ]
+  cmSample_t*             cueMem;      // cueMem[ maxCueCnt * chCnt * cueFrmCnt ]
+  cmSample_t**            chPtrV;      // chPtrV[ chCnt ] I/O thread read pointers
+  volatile bool           failFl;      // a read failed - the I/O thread ignores this stream
+  struct cmAfsStream_str* link;
+} cmAfsStream_t;
+
+typedef struct cmAfs_str
+{
+  cmErr_t          err;
+  cmThreadH_t      thH;
+  cmThreadMutexH_t mtxH;      // protects 'list' and 'svcSp' - never locked by a consumer
+  unsigned         periodMicros;
+  cmAfsStream_t*   list;
+  cmAfsStream_t*   svcSp;     // stream the I/O thread is currently servicing or NULL
+} cmAfs_t;
+
+// Process wide service see cmAfsSharedAcquire().
+typedef struct
+{
+  pthread_mutex_t mutex;
+  cmAfsH_t        h;
+  unsigned        refCnt;
+} cmAfsShared_t;
+
+static cmAfsShared_t _cmAfsShared = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+cmAfsH_t       cmAfsNullHandle       = cmSTATIC_NULL_HANDLE;
+cmAfsStreamH_t cmAfsStreamNullHandle = cmSTATIC_NULL_HANDLE;
+
+cmAfs_t* _cmAfsHandleToPtr( cmAfsH_t h )
+{
+  cmAfs_t* p = (cmAfs_t*)h.h;
+  assert(p!=NULL);
+  return p;
+}
+
+cmAfsStream_t* _cmAfsStreamHandleToPtr( cmAfsStreamH_t sh )
+{
+  cmAfsStream_t* sp = (cmAfsStream_t*)sh.h;
+  assert(sp!=NULL);
+  return sp;
+}
+
+//----------------------------------------------------------------------------
+// I/O thread
+//----------------------------------------------------------------------------
+
+// Read 'frmCnt' frames starting at 'frmIdx' into the channel planes begining at smpV[]
+// (the planes are 'planeFrmCnt' frames apart).  Returns the count of frames read.
+unsigned _cmAfsFileRead( cmAfsStream_t* sp, unsigned frmIdx, unsigned frmCnt, cmSample_t* smpV, unsigned planeFrmCnt )
+{
+  unsigned actFrmCnt = 0;
+  unsigned i;
+
+  if( frmCnt == 0 )
+    return 0;
+
+  if( sp->fileFrmIdx != frmIdx )
+  {
+    if( cmAudioFileSeek(sp->afH,frmIdx) != kOkAfRC )
+      goto errLabel;
+
+    sp->fileFrmIdx = frmIdx;
+  }
+
+  for(i=0; i<sp->chCnt; ++i)
+    sp->chPtrV[i] = smpV + i*planeFrmCnt;
+
+  if( cmAudioFileReadSample(sp->afH, frmCnt, sp->chIdx, sp->chCnt, sp->chPtrV, &actFrmCnt ) != kOkAfRC )
+    goto errLabel;
+
+  sp->fileFrmIdx += actFrmCnt;
+
+  return actFrmCnt;
+
+ errLabel:
+  cmErrMsg(&sp->p->err,kAudioFileFailAfsRC,"Read failed on the audio file '%s'.",cmStringNullGuard(sp->fn));
+  sp->fileFrmIdx = cmInvalidIdx;
+  _cmAfsStoreRelease(&sp->failFl,true);
+  return 0;
+}
+
+// Fill any empty cue caches and top up the ring.
+// Returns true if any I/O was performed.
+bool _cmAfsStreamService( cmAfsStream_t* sp )
+{
+  bool     workFl = false;
+  unsigned cueCnt = _cmAfsLoadAcquire(&sp->cueCnt);
+  unsigned i;
+
+  if( sp->failFl )
+    return false;
+
+  // fill the cue caches
+  for(i=0; i<cueCnt; ++i)
+  {
+    cmAfsCue_t* cp = sp->cueV + i;
+    if( cp->readyFl == 0 )
+    {
+      unsigned n = cp->frmIdx < sp->afInfo.frameCnt ? cmMin(sp->cueFrmCnt, sp->afInfo.frameCnt - cp->frmIdx) : 0;
+      cp->frmCnt = _cmAfsFileRead(sp, cp->frmIdx, n, cp->smpV, sp->cueFrmCnt );
+      cp->eofFl  = cp->frmIdx + cp->frmCnt >= sp->afInfo.frameCnt || cp->frmCnt < n;
+      _cmAfsStoreRelease(&cp->readyFl,1);
+      workFl     = true;
+    }
+  }
+
+  while( !sp->failFl )
+  {
+    // pick up a seek request
+    unsigned gen = _cmAfsLoadAcquire(&sp->seekGen);
+    if( gen != sp->pgen )
+    {
+      sp->pgen    = gen;
+      sp->pfrmIdx = sp->seekFrmIdx;
+      sp->peofFl  = false;
+    }
+
+    // the ring is full or the file is exhausted
+    unsigned wi = sp->wi;
+    if( sp->peofFl || wi - _cmAfsLoadAcquire(&sp->ri) >= kAfsBlkCnt )
+      break;
+
+    cmAfsBlk_t* bp = sp->blkV + (wi % kAfsBlkCnt);
+    unsigned    n  = sp->pfrmIdx < sp->afInfo.frameCnt ? cmMin(sp->blkFrmCnt, sp->afInfo.frameCnt - sp->pfrmIdx) : 0;
+
+    bp->gen    = sp->pgen;
+    bp->frmIdx = sp->pfrmIdx;
+    bp->frmCnt = _cmAfsFileRead(sp, sp->pfrmIdx, n, sp->blkMem + (wi % kAfsBlkCnt) * sp->chCnt * sp->blkFrmCnt, sp->blkFrmCnt );
+    bp->eofFl  = sp->pfrmIdx + bp->frmCnt >= sp->afInfo.frameCnt || bp->frmCnt < n;
+
+    sp->pfrmIdx += bp->frmCnt;
+    sp->peofFl   = bp->eofFl;
+
+    _cmAfsStoreRelease(&sp->wi,wi+1);
+    workFl = true;
+  }
+
+  return workFl;
+}
+
+bool _cmAfsThreadFunc( void* arg )
+{
+  cmAfs_t* p      = (cmAfs_t*)arg;
+  bool     workFl = false;
+  unsigned i;
+
+  // The list lock is only held while the next stream is selected. 
+  // The selected stream is marked in p->svcSp so that cmAfsStreamClose()
+  // can wait for its service to complete.
+  for(i=0; true; ++i)
+  {
+    cmAfsStream_t* sp = NULL;
+    unsigned       j  = 0;
+
+    if( cmThreadMutexLock(p->mtxH) != kOkThRC )
+      break;
+
+    for(sp=p->list; sp!=NULL && j<i; sp=sp->link)
+      ++j;
+
+    p->svcSp = sp;
+
+    cmThreadMutexUnlock(p->mtxH);
+
+    if( sp == NULL )
+      break;
+
+    if( _cmAfsStreamService(sp) )
+      workFl = true;
+
+    if( cmThreadMutexLock(p->mtxH) == kOkThRC )
+    {
+      p->svcSp = NULL;
+      cmThreadMutexSignalCondVar(p->mtxH);
+      cmThreadMutexUnlock(p->mtxH);
+    }
+  }
+
+  if( !workFl )
+    cmSleepUs(p->periodMicros);
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Streams
+//----------------------------------------------------------------------------
+
+void _cmAfsStreamFree( cmAfsStream_t* sp )
+{
+  if( cmAudioFileIsValid(sp->afH) )
+    if( cmAudioFileDelete(&sp->afH) != kOkAfRC )
+      cmErrMsg(&sp->p->err,kAudioFileFailAfsRC,"Audio file close failed on '%s'.",cmStringNullGuard(sp->fn));
+
+  cmMemFree(sp->blkMem);
+  cmMemFree(sp->cueV);
+  cmMemFree(sp->cueMem);
+  cmMemFree(sp->chPtrV);
+  cmMemFree(sp->fn);
+  cmMemFree(sp);
+}
+
+cmAfsRC_t cmAfsStreamOpen(  cmAfsH_t h, cmAfsStreamH_t* shp, const cmChar_t* fn, unsigned chIdx, unsigned chCnt, unsigned begFrmIdx, unsigned lookAheadFrmCnt, unsigned maxCueCnt, cmAudioFileInfo_t* afInfo )
+{
+  cmAfsRC_t rc;
+  cmRC_t    afRC;
+  unsigned  i;
+
+  if((rc = cmAfsStreamClose(shp)) != kOkAfsRC )
+    return rc;
+
+  cmAfs_t*       p  = _cmAfsHandleToPtr(h);
+  cmAfsStream_t* sp = cmMemAllocZ(cmAfsStream_t,1);
+  sp->p = p;
+
+  if( fn == NULL || chCnt == 0 )
+  {
+    rc = cmErrMsg(&p->err,kInvalidArgAfsRC,"A stream must have a file name and at least one channel.");
+    goto errLabel;
+  }
+
+  // open the audio file
+  if( cmAudioFileIsValid(sp->afH = cmAudioFileNewOpen(fn, &sp->afInfo, &afRC, p->err.rpt )) == false )
+  {
+    rc = cmErrMsg(&p->err,kAudioFileFailAfsRC,"The audio file '%s' could not be opened.",cmStringNullGuard(fn));
+    goto errLabel;
+  }
+
+  if( chIdx + chCnt > sp->afInfo.chCnt )
+  {
+    rc = cmErrMsg(&p->err,kInvalidArgAfsRC,"The channels %i to %i are not valid for the %i channel audio file '%s'.",chIdx,chIdx+chCnt-1,sp->afInfo.chCnt,fn);
+    goto errLabel;
+  }
+
+  sp->fn         = cmMemAllocStr(fn);
+  sp->chIdx      = chIdx;
+  sp->chCnt      = chCnt;
+  sp->blkFrmCnt  = cmMax(kAfsMinBlkFrmCnt, (lookAheadFrmCnt + kAfsBlkCnt - 2) / (kAfsBlkCnt-1));
+  sp->blkMem     = cmMemAllocZ(cmSample_t, kAfsBlkCnt * chCnt * sp->blkFrmCnt );
+  sp->cueFrmCnt  = (kAfsBlkCnt-1) * sp->blkFrmCnt;
+  sp->maxCueCnt  = maxCueCnt;
+  sp->cueV       = cmMemAllocZ(cmAfsCue_t, maxCueCnt );
+  sp->cueMem     = cmMemAllocZ(cmSample_t, maxCueCnt * chCnt * sp->cueFrmCnt );
+  sp->chPtrV     = cmMemAllocZ(cmSample_t*, chCnt );
+  sp->fileFrmIdx = 0;
+
+  for(i=0; i<maxCueCnt; ++i)
+    sp->cueV[i].smpV = sp->cueMem + i * chCnt * sp->cueFrmCnt;
+
+  // start the consumer and producer at 'begFrmIdx'
+  sp->frmIdx     = begFrmIdx;
+  sp->seekFrmIdx = begFrmIdx;
+  sp->pfrmIdx    = begFrmIdx;
+
+  // prepend the new stream to the service list
+  if( cmThreadMutexLock(p->mtxH) != kOkThRC )
+  {
+    rc = cmErrMsg(&p->err,kThreadFailAfsRC,"The I/O service lock failed.");
+    goto errLabel;
+  }
+
+  sp->link = p->list;
+  p->list  = sp;
+
+  cmThreadMutexUnlock(p->mtxH);
+
+  shp->h = sp;
+
+  if( afInfo != NULL )
+    *afInfo = sp->afInfo;
+
+ errLabel:
+  if( rc != kOkAfsRC )
+    _cmAfsStreamFree(sp);
+
+  return rc;
+}
+
+cmAfsRC_t cmAfsStreamClose( cmAfsStreamH_t* shp )
+{
+  if( shp==NULL || cmAfsStreamIsValid(*shp)==false )
+    return kOkAfsRC;
+
+  cmAfsStream_t* sp = _cmAfsStreamHandleToPtr(*shp);
+  cmAfs_t*       p  = sp->p;
+
+  // remove the stream from the service list
+  if( cmThreadMutexLock(p->mtxH) != kOkThRC )
+    return cmErrMsg(&p->err,kThreadFailAfsRC,"The I/O service lock failed.");
+
+  cmAfsStream_t*  s0 = NULL;
+  cmAfsStream_t*  s  = p->list;
+  for(; s!=NULL; s=s->link)
+  {
+    if( s == sp )
+    {
+      if( s0 == NULL )
+        p->list = s->link;
+      else
+        s0->link = s->link;
+      break;
+    }
+    s0 = s;
+  }
+
+  // wait for the I/O thread to finish servicing this stream
+  while( p->svcSp == sp )
+    cmThreadMutexWaitOnCondVar(p->mtxH,false);
+
+  cmThreadMutexUnlock(p->mtxH);
+
+  _cmAfsStreamFree(sp);
+
+  shp->h = NULL;
+
+  return kOkAfsRC;
+}
+
+bool      cmAfsStreamIsValid( cmAfsStreamH_t sh )
+{ return sh.h != NULL; }
+
+const cmAudioFileInfo_t* cmAfsStreamInfo( cmAfsStreamH_t sh )
+{
+  cmAfsStream_t* sp = _cmAfsStreamHandleToPtr(sh);
+  return &sp->afInfo;
+}
+
+cmAfsCue_t* _cmAfsStreamFindCue( cmAfsStream_t* sp, unsigned frmIdx )
+{
+  unsigned cueCnt = _cmAfsLoadAcquire(&sp->cueCnt);
+  unsigned i;
+  for(i=0; i<cueCnt; ++i)
+    if( sp->cueV[i].frmIdx == frmIdx )
+      return sp->cueV + i;
+  return NULL;
+}
+
+cmAfsRC_t cmAfsStreamCue( cmAfsStreamH_t sh, unsigned frmIdx )
+{
+  cmAfsStream_t* sp = _cmAfsStreamHandleToPtr(sh);
+
+  if( _cmAfsStreamFindCue(sp,frmIdx) != NULL )
+    return kOkAfsRC;
+
+  if( sp->cueCnt >= sp->maxCueCnt )
+    return cmErrMsg(&sp->p->err,kCueFullAfsRC,"The cue point at frame %i could not be added because '%s' already has %i cue points.",frmIdx,cmStringNullGuard(sp->fn),sp->maxCueCnt);
+
+  cmAfsCue_t* cp = sp->cueV + sp->cueCnt;
+  cp->frmIdx  = frmIdx;
+  cp->frmCnt  = 0;
+  cp->eofFl   = false;
+  cp->readyFl = 0;
+
+  // publish the cue to the I/O thread and the consumer
+  _cmAfsStoreRelease(&sp->cueCnt,sp->cueCnt+1);
+
+  return kOkAfsRC;
+}
+
+bool      cmAfsStreamIsCueReady( cmAfsStreamH_t sh, unsigned frmIdx )
+{
+  cmAfsStream_t* sp = _cmAfsStreamHandleToPtr(sh);
+  cmAfsCue_t*    cp = _cmAfsStreamFindCue(sp,frmIdx);
+  return cp != NULL && _cmAfsLoadAcquire(&cp->readyFl) != 0;
+}
+
+// Copy 'n' frames from channel planes starting at smpV[] ('planeFrmCnt' frames apart)
+// to chBufV[][oi:oi+n-1].
+void _cmAfsCopy( cmAfsStream_t* sp, cmSample_t** chBufV, unsigned oi, const cmSample_t* smpV, unsigned planeFrmCnt, unsigned n )
+{
+  unsigned i;
+  for(i=0; i<sp->chCnt; ++i)
+    cmVOS_Copy(chBufV[i] + oi, n, smpV + i*planeFrmCnt );
+}
+
+unsigned  cmAfsStreamRead( cmAfsStreamH_t sh, cmSample_t** chBufV, unsigned frmCnt )
+{
+  cmAfsStream_t* sp = _cmAfsStreamHandleToPtr(sh);
+  unsigned       n  = 0;
+  unsigned       i;
+
+  while( n < frmCnt && !sp->eofFl )
+  {
+    // play from the cue cache
+    if( sp->cueP != NULL )
+    {
+      cmAfsCue_t* cp = sp->cueP;
+      unsigned    m  = cmMin(cp->frmCnt - sp->cueOff, frmCnt - n);
+
+      _cmAfsCopy(sp, chBufV, n, cp->smpV + sp->cueOff, sp->cueFrmCnt, m );
+
+      n          += m;
+      sp->frmIdx += m;
+      sp->cueOff += m;
+
+      if( sp->cueOff == cp->frmCnt )
+        sp->cueP = NULL;
+
+      continue;
+    }
+
+    // the ring is empty
+    unsigned ri = sp->ri;
+    if( ri == _cmAfsLoadAcquire(&sp->wi) )
+      break;
+
+    cmAfsBlk_t* bp = sp->blkV + (ri % kAfsBlkCnt);
+
+    // skip blocks read for an earlier seek
+    if( bp->gen == sp->gen )
+    {
+      unsigned m = cmMin(bp->frmCnt - sp->boff, frmCnt - n);
+
+      _cmAfsCopy(sp, chBufV, n, sp->blkMem + (ri % kAfsBlkCnt) * sp->chCnt * sp->blkFrmCnt + sp->boff, sp->blkFrmCnt, m );
+
+      n          += m;
+      sp->frmIdx += m;
+      sp->boff   += m;
+
+      if( sp->boff < bp->frmCnt )
+        continue;
+
+      sp->eofFl = bp->eofFl;
+    }
+
+    // release the block to the I/O thread
+    sp->boff = 0;
+    _cmAfsStoreRelease(&sp->ri,ri+1);
+  }
+
+  if( n < frmCnt )
+  {
+    for(i=0; i<sp->chCnt; ++i)
+      cmVOS_Zero(chBufV[i] + n, frmCnt - n );
+
+    if( !sp->eofFl )
+      ++sp->underrunCnt;
+  }
+
+  return n;
+}
+
+cmAfsRC_t cmAfsStreamSeek( cmAfsStreamH_t sh, unsigned frmIdx )
+{
+  cmAfsStream_t* sp = _cmAfsStreamHandleToPtr(sh);
+  cmAfsCue_t*    cp = _cmAfsStreamFindCue(sp,frmIdx);
+
+  sp->gen   += 1;
+  sp->boff   = 0;
+  sp->frmIdx = frmIdx;
+  sp->eofFl  = false;
+  sp->cueP   = NULL;
+  sp->cueOff = 0;
+
+  // if the target was cued then play the cached frames and start the I/O thread after them
+  if( cp != NULL && _cmAfsLoadAcquire(&cp->readyFl) )
+  {
+    sp->cueP = cp->frmCnt > 0 ? cp : NULL;
+    frmIdx  += cp->frmCnt;
+  }
+
+  sp->seekFrmIdx = frmIdx;
+  _cmAfsStoreRelease(&sp->seekGen,sp->gen);
+
+  return kOkAfsRC;
+}
+
+unsigned  cmAfsStreamAvail( cmAfsStreamH_t sh, bool* eofFlPtr )
+{
+  cmAfsStream_t* sp    = _cmAfsStreamHandleToPtr(sh);
+  bool           eofFl = sp->eofFl;
+  unsigned       n     = 0;
+
+  if( !eofFl )
+  {
+    unsigned ri = sp->ri;
+    unsigned wi = _cmAfsLoadAcquire(&sp->wi);
+
+    if( sp->cueP != NULL )
+      n += sp->cueP->frmCnt - sp->cueOff;
+
+    for(; ri!=wi; ++ri)
+    {
+      const cmAfsBlk_t* bp = sp->blkV + (ri % kAfsBlkCnt);
+      if( bp->gen == sp->gen )
+      {
+        n += bp->frmCnt;
+        if((eofFl = bp->eofFl) == true )
+          break;
+      }
+    }
+
+    n -= sp->boff;
+  }
+
+  if( eofFlPtr != NULL )
+    *eofFlPtr = eofFl;
+
+  return n;
+}
+
+unsigned  cmAfsStreamFrameIndex( cmAfsStreamH_t sh )
+{
+  cmAfsStream_t* sp = _cmAfsStreamHandleToPtr(sh);
+  return sp->frmIdx;
+}
+
+bool      cmAfsStreamIsEof( cmAfsStreamH_t sh )
+{
+  cmAfsStream_t* sp = _cmAfsStreamHandleToPtr(sh);
+  return sp->eofFl;
+}
+
+unsigned  cmAfsStreamUnderrunCount( cmAfsStreamH_t sh )
+{
+  cmAfsStream_t* sp = _cmAfsStreamHandleToPtr(sh);
+  return sp->underrunCnt;
+}
+
+bool      cmAfsStreamIsFailed( cmAfsStreamH_t sh )
+{
+  cmAfsStream_t* sp = _cmAfsStreamHandleToPtr(sh);
+  return _cmAfsLoadAcquire(&sp->failFl);
+}
+
+//----------------------------------------------------------------------------
+// I/O Service
+//----------------------------------------------------------------------------
+
+cmAfsRC_t _cmAfsDestroy( cmAfs_t* p )
+{
+  cmAfsRC_t rc = kOkAfsRC;
+
+  if( cmThreadIsValid(p->thH) )
+    if( cmThreadDestroy(&p->thH) != kOkThRC )
+      return cmErrMsg(&p->err,kThreadFailAfsRC,"The I/O thread destroy failed.");
+
+  // the I/O thread is stopped so the list may be released without locking
+  while( p->list != NULL )
+  {
+    cmAfsStream_t* sp = p->list;
+    p->list = sp->link;
+    _cmAfsStreamFree(sp);
+  }
+
+  if( cmThreadMutexIsValid(p->mtxH) )
+    if( cmThreadMutexDestroy(&p->mtxH) != kOkThRC )
+      return cmErrMsg(&p->err,kThreadFailAfsRC,"The I/O service mutex destroy failed.");
+
+  cmMemFree(p);
+
+  return rc;
+}
+
+cmAfsRC_t cmAfsCreate(  cmAfsH_t* hp, unsigned periodMicros, cmRpt_t* rpt )
+{
+  cmAfsRC_t rc;
+  if((rc = cmAfsDestroy(hp)) != kOkAfsRC )
+    return rc;
+
+  cmAfs_t* p = cmMemAllocZ(cmAfs_t,1);
+  cmErrSetup(&p->err,rpt,"Audio File Stream");
+
+  p->periodMicros = periodMicros == 0 ? kAfsDfltPeriodMicros : periodMicros;
+
+  if( cmThreadMutexCreate(&p->mtxH,p->err.rpt) != kOkThRC )
+  {
+    rc = cmErrMsg(&p->err,kThreadFailAfsRC,"The I/O service mutex create failed.");
+    goto errLabel;
+  }
+
+  if( cmThreadCreate(&p->thH,_cmAfsThreadFunc,p,p->err.rpt) != kOkThRC )
+  {
+    rc = cmErrMsg(&p->err,kThreadFailAfsRC,"The I/O thread create failed.");
+    goto errLabel;
+  }
+
+  if( cmThreadPause(p->thH,0) != kOkThRC )
+  {
+    rc = cmErrMsg(&p->err,kThreadFailAfsRC,"The I/O thread start failed.");
+    goto errLabel;
+  }
+
+  hp->h = p;
+
+ errLabel:
+  if( rc != kOkAfsRC )
+    _cmAfsDestroy(p);
+
+  return rc;
+}
+
+cmAfsRC_t cmAfsDestroy( cmAfsH_t* hp )
+{
+  cmAfsRC_t rc = kOkAfsRC;
+
+  if( hp==NULL || cmAfsIsValid(*hp)==false )
+    return rc;
+
+  cmAfs_t* p = _cmAfsHandleToPtr(*hp);
+
+  if((rc = _cmAfsDestroy(p)) != kOkAfsRC )
+    return rc;
+
+  hp->h = NULL;
+
+  return rc;
+}
+
+bool      cmAfsIsValid( cmAfsH_t h )
+{ return h.h != NULL; }
+
+void      cmAfsReport( cmAfsH_t h, cmRpt_t* rpt )
+{
+  cmAfs_t* p = _cmAfsHandleToPtr(h);
+
+  if( cmThreadMutexLock(p->mtxH) != kOkThRC )
+    return;
+
+  cmAfsStream_t* sp = p->list;
+  for(; sp!=NULL; sp=sp->link)
+  {
+    unsigned ri = _cmAfsLoadAcquire(&sp->ri);
+    unsigned wi = _cmAfsLoadAcquire(&sp->wi);
+    cmRptPrintf(rpt,"%s ch:%i:%i frm:%i blk:%ix%i fill:%i cue:%i/%i underruns:%i%s\n",
+      sp->fn,sp->chIdx,sp->chCnt,sp->frmIdx,kAfsBlkCnt,sp->blkFrmCnt,wi-ri,
+      sp->cueCnt,sp->maxCueCnt,sp->underrunCnt,sp->failFl ? " FAILED" : "");
+  }
+
+  cmThreadMutexUnlock(p->mtxH);
+}
+
+cmAfsRC_t cmAfsSharedAcquire( cmAfsH_t* hp, cmRpt_t* rpt )
+{
+  cmAfsRC_t rc = kOkAfsRC;
+
+  pthread_mutex_lock(&_cmAfsShared.mutex);
+
+  if( _cmAfsShared.refCnt == 0 )
+    rc = cmAfsCreate(&_cmAfsShared.h,0,rpt);
+
+  if( rc == kOkAfsRC )
+  {
+    ++_cmAfsShared.refCnt;
+    *hp = _cmAfsShared.h;
+  }
+
+  pthread_mutex_unlock(&_cmAfsShared.mutex);
+
+  return rc;
+}
+
+cmAfsRC_t cmAfsSharedRelease( cmAfsH_t* hp )
+{
+  cmAfsRC_t rc = kOkAfsRC;
+
+  if( hp==NULL || cmAfsIsValid(*hp)==false )
+    return rc;
+
+  pthread_mutex_lock(&_cmAfsShared.mutex);
+
+  assert( hp->h == _cmAfsShared.h.h && _cmAfsShared.refCnt > 0 );
+
+  if( _cmAfsShared.refCnt == 1 )
+    rc = cmAfsDestroy(&_cmAfsShared.h);
+
+  if( rc == kOkAfsRC )
+  {
+    --_cmAfsShared.refCnt;
+    hp->h = NULL;
+  }
+
+  pthread_mutex_unlock(&_cmAfsShared.mutex);
+
+  return rc;
+}
+
+//----------------------------------------------------------------------------
+// Test
+//----------------------------------------------------------------------------
+
+// Read 'frmCnt' frames from the stream waiting for the I/O thread when necessary
+// and compare them to the reference signal refV[chCnt][refN] starting at 'frmIdx'.
+// Returns the count of mismatched frames.
+unsigned _cmAfsTestRead( cmAfsStreamH_t sh, cmSample_t** bufV, cmSample_t** refV, unsigned refN, unsigned chCnt, unsigned frmIdx, unsigned frmCnt, unsigned blkN, bool waitFl )
+{
+  unsigned errCnt = 0;
+  unsigned i,j;
+
+  while( frmCnt > 0 )
+  {
+    unsigned n   = cmMin(blkN,frmCnt);
+    bool     eofFl;
+
+    while( waitFl && cmAfsStreamAvail(sh,&eofFl) < n && !eofFl && !cmAfsStreamIsFailed(sh) )
+      cmSleepUs(100);
+
+    unsigned m = cmAfsStreamRead(sh,bufV,n);
+
+    for(j=0; j<n; ++j)
+      for(i=0; i<chCnt; ++i)
+      {
+        cmSample_t ref = frmIdx + j < refN ? refV[i][frmIdx+j] : 0;
+        if( bufV[i][j] != ref || (j >= m && frmIdx + j < refN) )
+        {
+          ++errCnt;
+          break;
+        }
+      }
+
+    frmIdx += n;
+    frmCnt -= n;
+  }
+
+  return errCnt;
+}
+
+cmAfsRC_t cmAfsTest( cmCtx_t* ctx, const cmChar_t* fn )
+{
+  enum { kBlkN = 64, kLookAheadN = 8192, kCueN = 4 };
+
+  cmAfsRC_t         rc       = kOkAfsRC;
+  cmAfsH_t          h        = cmAfsNullHandle;
+  cmAfsStreamH_t    sh       = cmAfsStreamNullHandle;
+  cmRpt_t*          rpt      = &ctx->rpt;
+  cmAudioFileInfo_t afInfo;
+  cmSample_t*       refV[2];
+  cmSample_t*       bufV[2];
+  unsigned          cueV[kCueN];
+  unsigned          actFrmCnt = 0;
+  unsigned          chCnt;
+  unsigned          i, errCnt;
+  cmRC_t            afRC;
+
+  // read the reference signal
+  cmAudioFileH_t afH = cmAudioFileNewOpen(fn,&afInfo,&afRC,rpt);
+  if( cmAudioFileIsValid(afH) == false )
+    return cmErrMsg(&ctx->err,kAudioFileFailAfsRC,"The test file '%s' could not be opened.",cmStringNullGuard(fn));
+
+  chCnt = cmMin(2,afInfo.chCnt);
+  for(i=0; i<chCnt; ++i)
+  {
+    refV[i] = cmMemAllocZ(cmSample_t,afInfo.frameCnt);
+    bufV[i] = cmMemAllocZ(cmSample_t,kBlkN);
+  }
+
+  cmAudioFileReadSample(afH,afInfo.frameCnt,0,chCnt,refV,&actFrmCnt);
+  cmAudioFileDelete(&afH);
+
+  if((rc = cmAfsCreate(&h,0,rpt)) != kOkAfsRC )
+    goto errLabel;
+
+  if((rc = cmAfsStreamOpen(h,&sh,fn,0,chCnt,0,kLookAheadN,kCueN,NULL)) != kOkAfsRC )
+    goto errLabel;
+
+  // stream the entire file
+  errCnt = _cmAfsTestRead(sh,bufV,refV,actFrmCnt,chCnt,0,actFrmCnt + kBlkN,kBlkN,true);
+  cmRptPrintf(rpt,"sequential  frames:%i errors:%i eof:%i\n",actFrmCnt,errCnt,cmAfsStreamIsEof(sh));
+
+  // register cue points and wait for the I/O thread to fill them
+  for(i=0; i<kCueN; ++i)
+  {
+    cueV[i] = (i+1) * actFrmCnt / (kCueN+1);
+    cmAfsStreamCue(sh,cueV[i]);
+  }
+
+  for(i=0; i<kCueN; ++i)
+    while( !cmAfsStreamIsCueReady(sh,cueV[i]) && !cmAfsStreamIsFailed(sh) )
+      cmSleepUs(100);
+
+  // seek to each cue point and read the cached segment without waiting
+  for(i=0; i<kCueN; ++i)
+  {
+    unsigned u0 = cmAfsStreamUnderrunCount(sh);
+    cmAfsStreamSeek(sh,cueV[i]);
+    errCnt  = _cmAfsTestRead(sh,bufV,refV,actFrmCnt,chCnt,cueV[i],kLookAheadN/2,kBlkN,false);
+    unsigned u1 = cmAfsStreamUnderrunCount(sh);
+    errCnt += _cmAfsTestRead(sh,bufV,refV,actFrmCnt,chCnt,cueV[i]+kLookAheadN/2,3*kLookAheadN,kBlkN,true);
+    cmRptPrintf(rpt,"cue:%8i errors:%i underruns:%i\n",cueV[i],errCnt,u1-u0);
+  }
+
+  // seek to un-cued locations
+  for(i=0; i<kCueN; ++i)
+  {
+    unsigned frmIdx = (7919 * (i+1)) % actFrmCnt;
+    cmAfsStreamSeek(sh,frmIdx);
+    errCnt = _cmAfsTestRead(sh,bufV,refV,actFrmCnt,chCnt,frmIdx,2*kLookAheadN,kBlkN,true);
+    cmRptPrintf(rpt,"seek:%7i errors:%i\n",frmIdx,errCnt);
+  }
+
+  cmAfsReport(h,rpt);
+
+ errLabel:
+  cmAfsStreamClose(&sh);
+  cmAfsDestroy(&h);
+
+  for(i=0; i<chCnt; ++i)
+  {
+    cmMemFree(refV[i]);
+    cmMemFree(bufV[i]);
+  }
+
+  return rc;
+}
@@ -0,0 +1,146 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+#ifndef cmAudioFileStream_h
+#define cmAudioFileStream_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  //( { file_desc:"Background read-ahead service for streaming audio files." kw:[audio file] }
+  //
+  // A single I/O thread services a set of streams. Each stream owns an audio file
+  // handle and a ring of fixed size blocks of decoded, deinterleaved samples.
+  // The I/O thread keeps each ring filled with 'lookAheadFrmCnt' frames
+  // following the current play position.
+  //
+  // The consumer functions (cmAfsStreamRead(), cmAfsStreamSeek(), cmAfsStreamAvail(),
+  // cmAfsStreamFrameIndex(), cmAfsStreamIsEof(), cmAfsStreamUnderrunCount())
+  // do not allocate, lock or perform I/O and may therefore be called from the
+  // audio thread. A stream has exactly one consumer thread.
+  //
+  // Seeking is asynchronous: the samples at the new location are available
+  // once the I/O thread has read them. To make a seek immediate the seek target
+  // may be registered in advance with cmAfsStreamCue(). The I/O thread then
+  // keeps a copy of the first 'lookAheadFrmCnt' frames following the target.
+  // Seeking to a ready cue point plays the cached frames while the I/O thread
+  // refills the ring from the end of the cached segment.
+  //
+  // If the consumer reads faster than the I/O thread can fill the ring the
+  // missing frames are returned as zeros and the stream underrun count is incremented.
+  // If a file read fails the I/O thread stops servicing the stream, cmAfsStreamIsFailed()
+  // returns true and all following reads return zeros.
+  //
+  // The I/O thread only holds the service lock while it selects the next stream
+  // therefore opening or closing a stream never waits for the file I/O of another stream.
+  //
+  // cmAudioFileRd (cmProc.h) reads through the shared service (see cmAfsSharedAcquire()).
+  // The DSP 'AudioFileOut' class and cmAudioSegPlayer (cmProc2.h) do not use this
+  // service: the former writes rather than reads its file and the latter plays
+  // segments of cmAudioFileBuf objects which are entirely loaded into memory.
+
+  enum
+  {
+    kOkAfsRC = cmOkRC,
+    kAudioFileFailAfsRC,
+    kThreadFailAfsRC,
+    kInvalidArgAfsRC,
+    kCueFullAfsRC
+  };
+
+  typedef cmHandle_t cmAfsH_t;
+  typedef cmHandle_t cmAfsStreamH_t;
+  typedef cmRC_t     cmAfsRC_t;
+
+  extern cmAfsH_t       cmAfsNullHandle;
+  extern cmAfsStreamH_t cmAfsStreamNullHandle;
+
+  //----------------------------------------------------------------------------
+  // Streams
+  //----------------------------------------------------------------------------
+
+  // Open 'fn' and begin reading 'chCnt' channels starting at channel 'chIdx'
+  // and frame 'begFrmIdx'. 'lookAheadFrmCnt' sets the count of frames which
+  // the I/O thread attempts to keep ahead of the play position and the
+  // length of each cue cache. 'maxCueCnt' sets the count of cue points
+  // which may be registered with cmAfsStreamCue().
+  // Not real-time safe.
+  cmAfsRC_t cmAfsStreamOpen(  cmAfsH_t h, cmAfsStreamH_t* shp, const cmChar_t* fn, unsigned chIdx, unsigned chCnt, unsigned begFrmIdx, unsigned lookAheadFrmCnt, unsigned maxCueCnt, cmAudioFileInfo_t* afInfo );
+
+  // Remove the stream from the service and release its resources. Not real-time safe.
+  cmAfsRC_t cmAfsStreamClose( cmAfsStreamH_t* shp );
+  bool      cmAfsStreamIsValid( cmAfsStreamH_t sh );
+
+  // Return a pointer to the information record associated with the stream's file.
+  const cmAudioFileInfo_t* cmAfsStreamInfo( cmAfsStreamH_t sh );
+
+  // Register 'frmIdx' as a seek target. The I/O thread reads the frames
+  // following the target into the cue cache in the background.
+  // Cue points remain registered until the stream is closed.
+  // Not real-time safe. Returns kCueFullAfsRC if 'maxCueCnt' cue points already exist.
+  cmAfsRC_t cmAfsStreamCue( cmAfsStreamH_t sh, unsigned frmIdx );
+
+  // Return true if the cue cache for 'frmIdx' has been filled.
+  bool      cmAfsStreamIsCueReady( cmAfsStreamH_t sh, unsigned frmIdx );
+
+  // Fill chBufV[chCnt][frmCnt] with the next 'frmCnt' frames from the stream.
+  // Frames which are not available are set to zero.
+  // Returns the count of frames actually read from the file.
+  // Real-time safe.
+  unsigned  cmAfsStreamRead( cmAfsStreamH_t sh, cmSample_t** chBufV, unsigned frmCnt );
+
+  // Move the play position to 'frmIdx'. Real-time safe.
+  cmAfsRC_t cmAfsStreamSeek( cmAfsStreamH_t sh, unsigned frmIdx );
+
+  // Return the count of frames which may be read without underrun.
+  // Set *eofFlPtr (if it is non-NULL) to true if the end of the file
+  // follows the available frames. Real-time safe.
+  unsigned  cmAfsStreamAvail( cmAfsStreamH_t sh, bool* eofFlPtr );
+
+  // Return the file frame index of the next frame which cmAfsStreamRead() will return.
+  unsigned  cmAfsStreamFrameIndex( cmAfsStreamH_t sh );
+
+  // Return true if cmAfsStreamRead() has reached the end of the file.
+  bool      cmAfsStreamIsEof( cmAfsStreamH_t sh );
+
+  // Return the count of reads which could not be completely filled because
+  // the I/O thread had not yet read the frames.
+  unsigned  cmAfsStreamUnderrunCount( cmAfsStreamH_t sh );
+
+  // Return true if a read on the stream's file failed. Real-time safe.
+  bool      cmAfsStreamIsFailed( cmAfsStreamH_t sh );
+
+  //----------------------------------------------------------------------------
+  // I/O Service
+  //----------------------------------------------------------------------------
+
+  // 'periodMicros' is the time the I/O thread sleeps when all streams are
+  // full. Set it to 0 to use the default (1000 microseconds).
+  cmAfsRC_t cmAfsCreate(  cmAfsH_t* hp, unsigned periodMicros, cmRpt_t* rpt );
+
+  // Close any streams which remain open and stop the I/O thread.
+  cmAfsRC_t cmAfsDestroy( cmAfsH_t* hp );
+  bool      cmAfsIsValid( cmAfsH_t h );
+
+  void      cmAfsReport( cmAfsH_t h, cmRpt_t* rpt );
+
+  // Return the process wide service creating it if necessary. The service is
+  // reference counted and each successful call to cmAfsSharedAcquire() must be
+  // matched by a call to cmAfsSharedRelease(). The service is destroyed when
+  // the last reference is released. Errors are reported via the 'rpt' given
+  // to the call which created the service. Not real-time safe.
+  cmAfsRC_t cmAfsSharedAcquire( cmAfsH_t* hp, cmRpt_t* rpt );
+  cmAfsRC_t cmAfsSharedRelease( cmAfsH_t* hp );
+
+  // Stream 'fn' through the service and verify the stream against direct
+  // reads of the file with and without seeking.
+  cmAfsRC_t cmAfsTest( cmCtx_t* ctx, const cmChar_t* fn );
+
+  //)
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
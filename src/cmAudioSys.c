@@ -326,18 +326,10 @@ bool _cmAsBufIsReady( const _cmAsCfg_t* cp )
 // This is only called with _cmAsRecd.engMutexH locked
 cmAsRC_t _cmAsDeliverMsgsWithLock( _cmAsCfg_t* cp  )
 {
-  int      i;
-  cmAsRC_t rc = kOkThRC;
-    
-  // as long as their may be a msg wating in the incoming msg queue
-  for(i=0; rc == kOkThRC; ++i)
-  {
-    // if a msg is waiting transmit it via cfg->cbFunc()
-    if((rc = cmTsMp1cDequeueMsg(cp->htdQueueH,NULL,0)) == kOkThRC)
-      ++cp->status.msgCbCnt;
-  }
+  // transmit all waiting msgs via cfg->cbFunc()
+  cp->status.msgCbCnt += cmTsMp1cDequeueAllMsgs(cp->htdQueueH,cmInvalidCnt);
 
-  return rc;
+  return kOkAsRC;
 }
 
 
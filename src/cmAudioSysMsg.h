@@ -19,6 +19,7 @@ extern "C" {
     kSsInitSelAsId,  // indicates the msg is of type cmAudioSysSsInitMsg_t
     kStatusSelAsId,  // indicates the msg is of type cmAudioSysStatus_t
     kNetSyncSelAsId,   // sent with a cmDspNetMsg_t object  
+    kDspProfileSelAsId, // indicates the msg is of type cmAudioSysDspProfile_t
   };
 
   typedef struct
@@ -116,6 +117,32 @@ extern "C" {
     
   } cmAudioSysStatus_t;
 
+  /// DSP execution profile record - this message is transmitted to the host at periodic
+  /// intervals while DSP profiling is enabled. See cmDspSysProfileEnable().
+  /// When transmitted to the host this record acts as the message header.
+  /// This header is followed by an array of cmAudioSysDspProfileInst_t records.
+  /// Message Layout: [ asSubIdx kDspProfileSelAsId cmAudioSysDspProfile_t instArray[instCnt] ]
+  typedef struct
+  {
+    unsigned asSubIdx;      ///< originating audio sub-system
+    unsigned cycleCnt;      ///< count of DSP cycles since the program was loaded
+    unsigned deadlineUsecs; ///< duration of one DSP cycle
+    unsigned lastUsecs;     ///< execution time of the last DSP cycle
+    unsigned maxUsecs;      ///< longest DSP cycle execution time
+    unsigned overrunCnt;    ///< count of DSP cycles whose execution time exceeded deadlineUsecs
+    unsigned instCnt;       ///< count of cmAudioSysDspProfileInst_t records following this header
+  } cmAudioSysDspProfile_t;
+
+  typedef struct
+  {
+    unsigned instId;        ///< DSP instance id
+    unsigned execCnt;       ///< count of exec calls measured
+    float    minUsecs;      ///< shortest exec time
+    float    meanUsecs;     ///< average exec time
+    float    maxUsecs;      ///< longest exec time
+    float    p99Usecs;      ///< 99th percentile exec time over the most recent exec calls
+  } cmAudioSysDspProfileInst_t;
+
   //)
   
 #ifdef __cplusplus
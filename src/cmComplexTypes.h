@@ -28,6 +28,10 @@ extern "C" {
 #define cmFftMallocS      fftwf_malloc
 #define cmFftFreeMemS     fftwf_free
 #define cmFftExecuteS     fftwf_execute
+#define cmFftExecuteR2CS  fftwf_execute_dft_r2c
+#define cmIFftExecuteC2RS fftwf_execute_dft_c2r
+#define cmFftExecuteSplitR2CS  fftwf_execute_split_dft_r2c
+#define cmIFftExecuteSplitC2RS fftwf_execute_split_dft_c2r
 
   typedef fftwf_plan      cmFftPlanS_t;
 
@@ -47,6 +51,10 @@ extern "C" {
 #define cmFftMallocS      fftw_malloc
 #define cmFftFreeMemS     fftw_free
 #define cmFftExecuteS     fftw_execute
+#define cmFftExecuteR2CS  fftw_execute_dft_r2c
+#define cmIFftExecuteC2RS fftw_execute_dft_c2r
+#define cmFftExecuteSplitR2CS  fftw_execute_split_dft_r2c
+#define cmIFftExecuteSplitC2RS fftw_execute_split_dft_c2r
 
   typedef fftw_plan      cmFftPlanS_t;
 
@@ -72,6 +80,10 @@ extern "C" {
 #define cmFftMallocR      fftwf_malloc
 #define cmFftFreeMemR     fftwf_free
 #define cmFftExecuteR     fftwf_execute
+#define cmFftExecuteR2CR  fftwf_execute_dft_r2c
+#define cmIFftExecuteC2RR fftwf_execute_dft_c2r
+#define cmFftExecuteSplitR2CR  fftwf_execute_split_dft_r2c
+#define cmIFftExecuteSplitC2RR fftwf_execute_split_dft_c2r
 
   typedef fftwf_plan     cmFftPlanR_t;
 
@@ -91,6 +103,10 @@ extern "C" {
 #define cmFftMallocR      fftw_malloc
 #define cmFftFreeMemR     fftw_free
 #define cmFftExecuteR     fftw_execute
+#define cmFftExecuteR2CR  fftw_execute_dft_r2c
+#define cmIFftExecuteC2RR fftw_execute_dft_c2r
+#define cmFftExecuteSplitR2CR  fftw_execute_split_dft_r2c
+#define cmIFftExecuteSplitC2RR fftw_execute_split_dft_c2r
 
   typedef fftw_plan       cmFftPlanR_t;
 
@@ -12,6 +12,8 @@
 #include "cmHashTbl.h"
 #include "cmCsv.h"
 #include "cmText.h"
+#include "cmThread.h"
+#include "cmTime.h"
 
 enum
 {
@@ -1231,3 +1233,756 @@ cmCsvRC_t  cmCsvPrint( cmCsvH_t h, unsigned rowCnt )
   }
   return kOkCsvRC;
 }
+
+//============================================================================================
+// Streaming reader
+//
+
+enum
+{
+  kCsvRdDfltChunkByteCnt = 1024*1024,
+  kCsvRdMinChunkByteCnt  = 16
+};
+
+// Row boundary scanner states
+enum
+{
+  kCellBegCsvRdId,   // preceding the first non-space character of a cell
+  kUnquotedCsvRdId,  // within an unquoted cell or following the end quote of a quoted cell
+  kQuotedCsvRdId,    // within a quoted cell
+  kEscapeCsvRdId     // following a backslash within a quoted cell
+};
+
+typedef struct
+{
+  unsigned state;     // kXXXCsvRdId
+  unsigned colCnt;    // count of columns in the current row
+  unsigned lineCnt;   // count of row terminators
+  unsigned maxColCnt; // max count of columns in a terminated row
+} _cmCsvRdScan_t;
+
+struct cmCsvRd_str;
+
+// Parsing state for one chunk.
+// Each part is a task of cmCsvRd_t.poolH. The tasks are claimed by the pool workers
+// and by the calling thread in cmThreadPoolRun(), so a part is not tied to a thread.
+// A single part is parsed directly by the calling thread.
+typedef struct
+{
+  struct cmCsvRd_str* p;
+  char*            textV;        // textV[textAllocCnt] chunk text
+  unsigned         textAllocCnt; //
+  unsigned         textCnt;      // count of characters in textV[] - the last character is always '\n'
+  unsigned         lineCnt;      // count of lines in textV[]
+  unsigned         maxColCnt;    // max count of columns in any line in textV[]
+
+  unsigned char*   typeV;        // typeV[cellAllocCnt]  cell types
+  cmCsvValue_t*    valueV;       // valueV[cellAllocCnt] cell values
+  unsigned         cellAllocCnt; //
+  unsigned         rowStride;    // count of cells in each column of typeV[] and valueV[]
+  unsigned         rowCnt;       // count of parsed rows
+  unsigned         colCnt;       // count of parsed columns
+  unsigned         errRowIdx;    // chunk row of the first syntax error or cmInvalidIdx
+  unsigned         errColIdx;    //
+} _cmCsvRdPart_t;
+
+typedef struct cmCsvRd_str
+{
+  cmErr_t         err;
+  cmHashTblH_t    htH;           // symbol table
+  unsigned        chunkByteCnt;  //
+  _cmCsvRdPart_t* partV;         // partV[partCnt]
+  unsigned        partCnt;       //
+  cmThreadPoolH_t poolH;         // partCnt-1 parsing threads (not used when partCnt==1)
+  char*           carryV;        // carryV[carryAllocCnt] partial row following the last chunk
+  unsigned        carryAllocCnt; //
+  unsigned        carryCnt;      //
+} cmCsvRd_t;
+
+cmCsvRdH_t cmCsvRdNullHandle = cmSTATIC_NULL_HANDLE;
+
+cmCsvRd_t* _cmCsvRdHandleToPtr( cmCsvRdH_t h )
+{
+  cmCsvRd_t* p = (cmCsvRd_t*)h.h;
+  assert( p != NULL );
+  return p;
+}
+
+cmCsvRC_t _cmCsvRdError( cmCsvRd_t* p, cmCsvRC_t rc, const char* fmt, ... )
+{
+  va_list vl;
+  va_start(vl,fmt);
+  rc = cmErrVMsg(&p->err,rc,fmt,vl);
+  va_end(vl);
+  return rc;
+}
+
+// Advance the row boundary scanner over textV[bi:ei]. Return the offset
+// following the last row terminator in the range or cmInvalidIdx if the
+// range does not contain a row terminator.
+unsigned _cmCsvRdScan( _cmCsvRdScan_t* s, const char* textV, unsigned bi, unsigned ei )
+{
+  unsigned endIdx = cmInvalidIdx;
+  unsigned state  = s->state;
+  unsigned colCnt = s->colCnt;
+  unsigned i;
+
+  for(i=bi; i<ei; ++i)
+  {
+    char c = textV[i];
+
+    switch( state )
+    {
+      case kCellBegCsvRdId:
+        if( c == '"' )
+        {
+          state = kQuotedCsvRdId;
+          break;
+        }
+
+        if( c == ' ' || c == '\t' || c == '\r' )
+          break;
+
+        state = kUnquotedCsvRdId;
+
+        // fall through
+
+      case kUnquotedCsvRdId:
+        if( c == ',' )
+        {
+          ++colCnt;
+          state = kCellBegCsvRdId;
+        }
+        else
+          if( c == '\n' )
+          {
+            s->maxColCnt = cmMax(s->maxColCnt,colCnt+1);
+            s->lineCnt  += 1;
+            colCnt       = 0;
+            state        = kCellBegCsvRdId;
+            endIdx       = i+1;
+          }
+        break;
+
+      case kQuotedCsvRdId:
+        if( c == '\\' )
+          state = kEscapeCsvRdId;
+        else
+          if( c == '"' )
+            state = kUnquotedCsvRdId;
+        break;
+
+      case kEscapeCsvRdId:
+        state = kQuotedCsvRdId;
+        break;
+    }
+  }
+
+  s->state  = state;
+  s->colCnt = colCnt;
+
+  return endIdx;
+}
+
+// Reserve space for 'n' characters in t->textV[] and preserve the current contents.
+void _cmCsvRdReserveText( _cmCsvRdPart_t* t, unsigned n )
+{
+  if( t->textAllocCnt < n )
+  {
+    t->textV        = cmMemResizeP(char,t->textV,n);
+    t->textAllocCnt = n;
+  }
+}
+
+// Fill t->textV[] with the partial row left by the previous chunk followed
+// by the complete rows in the next chunk of 'fp'. Allocate the cell buffers
+// for the chunk. Memory is only allocated here, and not in _cmCsvRdParsePart(),
+// because the parsing threads cannot call the memory manager.
+cmCsvRC_t _cmCsvRdFillPart( cmCsvRd_t* p, _cmCsvRdPart_t* t, FILE* fp, const char* fn, bool* eofFlPtr )
+{
+  _cmCsvRdScan_t s       = { kCellBegCsvRdId, 0, 0, 0 };
+  unsigned       endIdx  = cmInvalidIdx;
+  unsigned       n       = p->carryCnt;
+  unsigned       scanIdx = 0;
+  unsigned       cellCnt;
+
+  // the extra character leaves room to terminate the last row of the file
+  _cmCsvRdReserveText(t, p->carryCnt + p->chunkByteCnt + 1 );
+
+  if( p->carryCnt > 0 )
+    memcpy(t->textV,p->carryV,p->carryCnt);
+
+  p->carryCnt = 0;
+
+  for(;;)
+  {
+    unsigned reqCnt = t->textAllocCnt - n - 1;
+    unsigned cnt    = fread(t->textV + n, 1, reqCnt, fp);
+    unsigned idx;
+
+    if( cnt < reqCnt )
+    {
+      if( ferror(fp) )
+        return _cmCsvRdError(p,kFileReadErrCsvRC,"File read failed on:'%s'.",fn);
+
+      *eofFlPtr = true;
+    }
+
+    n += cnt;
+
+    if((idx = _cmCsvRdScan(&s,t->textV,scanIdx,n)) != cmInvalidIdx )
+      endIdx = idx;
+
+    scanIdx = n;
+
+    if( endIdx != cmInvalidIdx || *eofFlPtr )
+      break;
+
+    // the chunk does not contain a complete row - extend it
+    _cmCsvRdReserveText(t, t->textAllocCnt + p->chunkByteCnt );
+  }
+
+  if( *eofFlPtr )
+  {
+    if( s.state == kQuotedCsvRdId || s.state == kEscapeCsvRdId )
+      return _cmCsvRdError(p,kSyntaxErrCsvRC,"The last string literal in '%s' is missing an end quote.",fn);
+
+    // terminate the last row
+    if( n > 0 && t->textV[n-1] != '\n' )
+    {
+      t->textV[n] = '\n';
+      _cmCsvRdScan(&s,t->textV,n,n+1);
+      ++n;
+    }
+
+    endIdx = n;
+  }
+  else
+  {
+    // move the partial row following the last row terminator to the carry buffer
+    p->carryCnt = n - endIdx;
+
+    if( p->carryAllocCnt < p->carryCnt )
+    {
+      p->carryV        = cmMemResize(char,p->carryV,p->carryCnt);
+      p->carryAllocCnt = p->carryCnt;
+    }
+
+    if( p->carryCnt > 0 )
+      memcpy(p->carryV,t->textV + endIdx,p->carryCnt);
+  }
+
+  t->textCnt   = endIdx;
+  t->lineCnt   = s.lineCnt;
+  t->maxColCnt = s.maxColCnt;
+
+  if((cellCnt = t->lineCnt * t->maxColCnt) > t->cellAllocCnt )
+  {
+    t->typeV        = cmMemResize(unsigned char,t->typeV,cellCnt);
+    t->valueV       = cmMemResize(cmCsvValue_t,t->valueV,cellCnt);
+    t->cellAllocCnt = cellCnt;
+  }
+
+  return kOkCsvRC;
+}
+
+// Set the type and value of the unquoted cell textV[bi:ei]. textV[ei] must be zero.
+unsigned char _cmCsvRdCellValue( const char* textV, unsigned bi, unsigned ei, cmCsvValue_t* v )
+{
+  const char* cp = textV + bi;
+  const char* ep = textV + ei;
+  const char* dp;
+  char*       rp = NULL;
+
+  // hexadecimal integer
+  if( cp[0]=='0' && (cp[1]=='x' || cp[1]=='X') )
+  {
+    unsigned long long x = 0;
+
+    for(dp=cp+2; dp<ep && isxdigit(*dp) && x<=UINT_MAX; ++dp)
+      x = x*16 + (isdigit(*dp) ? *dp-'0' : tolower(*dp)-'a'+10);
+
+    if( dp==ep && dp>cp+2 && x<=UINT_MAX )
+    {
+      v->i = (int)(unsigned)x;
+      return kHexCsvTFl;
+    }
+  }
+
+  dp = cp[0]=='-' ? cp+1 : cp;
+
+  // decimal integer with an optional 'u' suffix (see _cmLexIntMatcher())
+  if( isdigit(*dp) )
+  {
+    const char* bp = dp;
+    long long   x  = 0;
+
+    for(; dp<ep && isdigit(*dp) && dp-bp<11; ++dp)
+      x = x*10 + (*dp-'0');
+
+    if( dp<ep && (*dp=='u' || *dp=='U') && cp[0]!='-' )
+      ++dp;
+
+    if( cp[0] == '-' )
+      x = -x;
+
+    if( dp==ep && INT_MIN<=x && x<=INT_MAX )
+    {
+      v->i = (int)x;
+      return kIntCsvTFl;
+    }
+
+    dp = bp;
+  }
+
+  // real
+  if( isdigit(dp[0]) || (dp[0]=='.' && isdigit(dp[1])) )
+  {
+    v->r = strtod(cp,&rp);
+
+    if( rp == ep )
+      return kRealCsvTFl;
+  }
+
+  // identifier - the symbol id is set to the text offset until the symbol is interned
+  v->symId = bi;
+  return kIdentCsvTFl;
+}
+
+// Parse the rows in t->textV[0:textCnt] into t->typeV[] and t->valueV[].
+// This function runs on the parsing threads and therefore does not allocate memory.
+void _cmCsvRdParsePart( _cmCsvRdPart_t* t )
+{
+  char*    textV = t->textV;
+  unsigned n     = t->textCnt;
+  unsigned i     = 0;
+  unsigned ri    = 0;
+
+  t->rowStride = t->lineCnt;
+  t->rowCnt    = 0;
+  t->colCnt    = 0;
+  t->errRowIdx = cmInvalidIdx;
+  t->errColIdx = cmInvalidIdx;
+
+  if( t->lineCnt * t->maxColCnt > 0 )
+    memset(t->typeV,0,t->lineCnt * t->maxColCnt);
+
+  while( i < n )
+  {
+    unsigned ci    = 0;
+    bool     rowFl = false;  // set if the row contains a cell or a comma
+
+    for(;;)
+    {
+      unsigned      bi,ei;
+      unsigned char type = 0;
+      char          c;
+
+      // skip leading white space
+      while( textV[i]==' ' || textV[i]=='\t' || textV[i]=='\r' )
+        ++i;
+
+      if( textV[i] == '"' )
+      {
+        // the scanner guarantees that the end quote is in textV[]
+        for(bi=++i; textV[i] != '"'; ++i)
+          if( textV[i] == '\\' )
+            ++i;
+
+        ei   = i++;
+        type = kStrCsvTFl;
+
+        while( textV[i]==' ' || textV[i]=='\t' || textV[i]=='\r' )
+          ++i;
+
+        // only white space may follow the end quote
+        if( textV[i] != ',' && textV[i] != '\n' )
+        {
+          if( t->errRowIdx == cmInvalidIdx )
+          {
+            t->errRowIdx = ri;
+            t->errColIdx = ci;
+          }
+
+          while( textV[i] != ',' && textV[i] != '\n' )
+            ++i;
+        }
+      }
+      else
+      {
+        for(bi=i; textV[i] != ',' && textV[i] != '\n'; ++i)
+        {}
+
+        // trim trailing white space
+        for(ei=i; ei>bi && (textV[ei-1]==' ' || textV[ei-1]=='\t' || textV[ei-1]=='\r'); --ei)
+        {}
+      }
+
+      c = textV[i++]; // cell terminator: ',' or '\n'
+
+      if( ei > bi )
+      {
+        unsigned k = ci * t->rowStride + ri;
+
+        // terminate the cell text - this may overwrite the cell terminator or the end quote
+        textV[ei] = 0;
+
+        if( type == kStrCsvTFl )
+          t->valueV[k].symId = bi;
+        else
+          type = _cmCsvRdCellValue(textV,bi,ei,t->valueV + k);
+
+        t->typeV[k] = type;
+        t->colCnt   = cmMax(t->colCnt,ci+1);
+        rowFl       = true;
+      }
+
+      if( c == '\n' )
+        break;
+
+      ++ci;
+      rowFl = true;
+    }
+
+    // blank lines are not rows
+    if( rowFl )
+      ++ri;
+  }
+
+  t->rowCnt = ri;
+}
+
+// Store the first 'rowCnt' rows of each column contiguously.
+void _cmCsvRdPackPart( _cmCsvRdPart_t* t, unsigned rowCnt )
+{
+  unsigned ci;
+
+  if( rowCnt != t->rowStride )
+  {
+    for(ci=1; ci<t->colCnt; ++ci)
+    {
+      memmove(t->typeV  + ci*rowCnt, t->typeV  + ci*t->rowStride, rowCnt*sizeof(t->typeV[0]));
+      memmove(t->valueV + ci*rowCnt, t->valueV + ci*t->rowStride, rowCnt*sizeof(t->valueV[0]));
+    }
+
+    t->rowStride = rowCnt;
+  }
+
+  t->rowCnt = rowCnt;
+}
+
+void _cmCsvRdParseTask( void* arg, unsigned taskIdx )
+{
+  cmCsvRd_t* p = (cmCsvRd_t*)arg;
+  _cmCsvRdParsePart(p->partV + taskIdx);
+}
+
+// Parse the first 'partCnt' parts in parallel.
+void _cmCsvRdRun( cmCsvRd_t* p, unsigned partCnt )
+{
+  if( partCnt == 1 )
+    _cmCsvRdParsePart(p->partV);
+  else
+    cmThreadPoolRun(p->poolH,_cmCsvRdParseTask,p,partCnt);
+}
+
+// Intern the text cells of a parsed chunk and pass the chunk to the callback.
+cmCsvRC_t _cmCsvRdDeliver( cmCsvRd_t* p, _cmCsvRdPart_t* t, const char* fn, unsigned* rowIdxRef, unsigned maxRowCnt, cmCsvRdFunc_t func, void* arg )
+{
+  cmCsvRdH_t   h      = { p };
+  unsigned     rowCnt = t->rowCnt;
+  cmCsvChunk_t c;
+  unsigned     i;
+
+  if( maxRowCnt != 0 && *rowIdxRef + rowCnt > maxRowCnt )
+    rowCnt = maxRowCnt - *rowIdxRef;
+
+  if( t->errRowIdx < rowCnt )
+    return _cmCsvRdError(p,kSyntaxErrCsvRC,"Unexpected characters follow the end quote in '%s' row:%i col:%i.",fn,*rowIdxRef + t->errRowIdx + 1,t->errColIdx + 1);
+
+  if( rowCnt == 0 )
+    return kOkCsvRC;
+
+  _cmCsvRdPackPart(t,rowCnt);
+
+  for(i=0; i<t->colCnt*rowCnt; ++i)
+    if( cmIsFlag(t->typeV[i],kTextTMask) )
+      if((t->valueV[i].symId = cmHashTblStoreStr(p->htH,t->textV + t->valueV[i].symId)) == cmInvalidId )
+        return _cmCsvRdError(p,kHashTblErrCsvRC,"Symbol registration failed in '%s' row:%i col:%i.",fn,*rowIdxRef + i%rowCnt + 1,i/rowCnt + 1);
+
+  c.rowIdx    = *rowIdxRef;
+  c.rowCnt    = rowCnt;
+  c.colCnt    = t->colCnt;
+  c.typeV     = t->typeV;
+  c.valueV    = t->valueV;
+  *rowIdxRef += rowCnt;
+
+  return func(arg,h,&c);
+}
+
+void _cmCsvRdFree( cmCsvRd_t* p )
+{
+  unsigned i;
+
+  if( cmThreadPoolIsValid(p->poolH) )
+    cmThreadPoolDestroy(&p->poolH);
+
+  for(i=0; i<p->partCnt; ++i)
+  {
+    _cmCsvRdPart_t* t = p->partV + i;
+
+    cmMemFree(t->textV);
+    cmMemFree(t->typeV);
+    cmMemFree(t->valueV);
+  }
+
+  if( cmHashTblIsValid(p->htH) )
+    cmHashTblDestroy(&p->htH);
+
+  cmMemFree(p->partV);
+  cmMemFree(p->carryV);
+  cmMemFree(p);
+}
+
+cmCsvRC_t cmCsvRdCreate( cmCtx_t* ctx, cmCsvRdH_t* hp, unsigned chunkByteCnt, unsigned threadCnt )
+{
+  cmCsvRC_t  rc;
+  cmCsvRd_t* p;
+  unsigned   i;
+
+  if((rc = cmCsvRdDestroy(hp)) != kOkCsvRC )
+    return rc;
+
+  p = cmMemAllocZ(cmCsvRd_t,1);
+
+  cmErrSetup(&p->err,&ctx->rpt,"CSV Reader");
+
+  p->chunkByteCnt = chunkByteCnt==0 ? kCsvRdDfltChunkByteCnt : cmMax(kCsvRdMinChunkByteCnt,chunkByteCnt);
+  p->partCnt      = cmMax(1,threadCnt);
+  p->partV        = cmMemAllocZ(_cmCsvRdPart_t,p->partCnt);
+
+  if( cmHashTblCreate(ctx,&p->htH,8192) != kOkHtRC )
+  {
+    rc = _cmCsvRdError(p,kHashTblErrCsvRC,"Hash table creation failed.");
+    goto errLabel;
+  }
+
+  for(i=0; i<p->partCnt; ++i)
+    p->partV[i].p = p;
+
+  if( p->partCnt > 1 )
+    if( cmThreadPoolCreate(&p->poolH,p->partCnt-1,p->err.rpt) != kOkThRC )
+    {
+      rc = _cmCsvRdError(p,kThreadFailCsvRC,"Parsing thread pool create failed.");
+      goto errLabel;
+    }
+
+  hp->h = p;
+
+  return kOkCsvRC;
+
+ errLabel:
+  _cmCsvRdFree(p);
+  return rc;
+}
+
+cmCsvRC_t cmCsvRdDestroy( cmCsvRdH_t* hp )
+{
+  if( hp == NULL || cmCsvRdIsValid(*hp) == false )
+    return kOkCsvRC;
+
+  _cmCsvRdFree(_cmCsvRdHandleToPtr(*hp));
+
+  hp->h = NULL;
+
+  return kOkCsvRC;
+}
+
+bool cmCsvRdIsValid( cmCsvRdH_t h )
+{ return h.h != NULL; }
+
+cmCsvRC_t cmCsvRdParseFile( cmCsvRdH_t h, const char* fn, unsigned maxRowCnt, cmCsvRdFunc_t func, void* arg )
+{
+  cmCsvRC_t  rc     = kOkCsvRC;
+  cmCsvRd_t* p      = _cmCsvRdHandleToPtr(h);
+  FILE*      fp     = NULL;
+  bool       eofFl  = false;
+  unsigned   rowIdx = 0;
+  unsigned   i,n;
+
+  assert( fn != NULL && func != NULL );
+
+  if((fp = fopen(fn,"rb")) == NULL )
+    return _cmCsvRdError(p,kFileOpenErrCsvRC,"Unable to open the file:'%s'.",fn);
+
+  p->carryCnt = 0;
+
+  while( !eofFl && (maxRowCnt==0 || rowIdx<maxRowCnt) )
+  {
+    // read the next chunk into each part
+    for(n=0; n<p->partCnt && !eofFl; ++n)
+      if((rc = _cmCsvRdFillPart(p,p->partV+n,fp,fn,&eofFl)) != kOkCsvRC )
+        goto errLabel;
+
+    // parse the chunks in parallel
+    _cmCsvRdRun(p,n);
+
+    // deliver the chunks in file order
+    for(i=0; i<n && (maxRowCnt==0 || rowIdx<maxRowCnt); ++i)
+      if((rc = _cmCsvRdDeliver(p,p->partV+i,fn,&rowIdx,maxRowCnt,func,arg)) != kOkCsvRC )
+        goto errLabel;
+  }
+
+ errLabel:
+
+  if( fclose(fp) != 0 && rc == kOkCsvRC )
+    rc = _cmCsvRdError(p,kFileCloseErrCsvRC,"File close failed on:'%s'.",fn);
+
+  return rc;
+}
+
+const cmChar_t* cmCsvRdSymText( cmCsvRdH_t h, unsigned symId )
+{
+  cmCsvRd_t*      p = _cmCsvRdHandleToPtr(h);
+  const cmChar_t* cp;
+
+  if((cp = cmHashTblStr(p->htH,symId)) == NULL )
+    _cmCsvRdError(p,kHashTblErrCsvRC,"The text associated with the symbol '%i' was not found.",symId);
+
+  return cp;
+}
+
+typedef struct
+{
+  cmRpt_t*     rpt;
+  cmCsvH_t     csvH;     // reference CSV object
+  cmCsvBind_t* bp;       // next reference row
+  unsigned     rowCnt;   // count of rows received
+  unsigned     cellCnt;  // count of non-blank cells compared
+  unsigned     errCnt;   // count of cells which did not match the reference
+  unsigned     chunkCnt; // count of chunks received
+} _cmCsvRdTest_t;
+
+bool _cmCsvRdTestCell( _cmCsvRdTest_t* r, cmCsvRdH_t h, const cmCsvCell_t* cp, unsigned type, const cmCsvValue_t* v )
+{
+  int    iv = 0;
+  double rv = 0;
+
+  if( cp == NULL || type == 0 || cp->flags != type )
+    return false;
+
+  switch( type )
+  {
+    case kIntCsvTFl:   return cmCsvCellSymInt(r->csvH,cp->symId,&iv) == kOkCsvRC && iv == v->i;
+    case kHexCsvTFl:   return strtoul(cmCsvCellSymText(r->csvH,cp->symId),NULL,16) == (unsigned)v->i;
+    case kRealCsvTFl:  return cmCsvCellSymDouble(r->csvH,cp->symId,&rv) == kOkCsvRC && rv == v->r;
+    case kIdentCsvTFl:
+    case kStrCsvTFl:   return strcmp(cmCsvCellSymText(r->csvH,cp->symId),cmCsvRdSymText(h,v->symId)) == 0;
+  }
+
+  return false;
+}
+
+// Compare each chunk to the reference CSV object.
+cmCsvRC_t _cmCsvRdTestFunc( void* arg, cmCsvRdH_t h, const cmCsvChunk_t* c )
+{
+  _cmCsvRdTest_t* r = (_cmCsvRdTest_t*)arg;
+  unsigned        ri,ci;
+
+  for(ri=0; ri<c->rowCnt; ++ri)
+  {
+    const cmCsvCell_t* cp = NULL;
+
+    // rows without cells do not have a binding record
+    if( r->bp != NULL && r->bp->rowPtr != NULL && r->bp->rowPtr->row == c->rowIdx + ri )
+    {
+      cp    = r->bp->rowPtr;
+      r->bp = r->bp->linkPtr;
+    }
+
+    for(ci=0; ci<c->colCnt || cp!=NULL; ++ci)
+    {
+      unsigned            k    = ci*c->rowCnt + ri;
+      unsigned            type = ci<c->colCnt ? c->typeV[k] : 0;
+      const cmCsvCell_t*  rcp  = cp!=NULL && cp->col==ci ? cp : NULL;
+
+      if( type==0 && rcp==NULL )
+        continue;
+
+      ++r->cellCnt;
+
+      if( !_cmCsvRdTestCell(r,h,rcp,type,c->valueV + k) )
+      {
+        if( r->errCnt++ < 10 )
+          cmRptPrintf(r->rpt,"Mismatch at row:%i col:%i.\n",c->rowIdx+ri+1,ci+1);
+      }
+
+      if( rcp != NULL )
+        cp = cp->rowPtr;
+    }
+  }
+
+  r->rowCnt += c->rowCnt;
+  ++r->chunkCnt;
+
+  return kOkCsvRC;
+}
+
+cmCsvRC_t _cmCsvRdCountFunc( void* arg, cmCsvRdH_t h, const cmCsvChunk_t* c )
+{
+  *(unsigned*)arg += c->rowCnt;
+  return kOkCsvRC;
+}
+
+cmCsvRC_t cmCsvRdTest( cmCtx_t* ctx, const char* fn, unsigned chunkByteCnt, unsigned threadCnt )
+{
+  cmCsvRC_t      rc     = kOkCsvRC;
+  cmCsvRdH_t     h      = cmCsvRdNullHandle;
+  unsigned       rowCnt = 0;
+  unsigned       csvUs,rdUs;
+  _cmCsvRdTest_t r;
+  cmTimeSpec_t   t0,t1;
+
+  memset(&r,0,sizeof(r));
+  r.rpt  = &ctx->rpt;
+  r.csvH = cmCsvNullHandle;
+
+  // parse the file with the reference parser
+  cmTimeGetMonotonic(&t0);
+
+  if((rc = cmCsvInitializeFromFile(&r.csvH,fn,0,ctx)) != kOkCsvRC )
+    goto errLabel;
+
+  cmTimeGetMonotonic(&t1);
+  csvUs = cmTimeElapsedMicros(&t0,&t1);
+
+  if((rc = cmCsvRdCreate(ctx,&h,chunkByteCnt,threadCnt)) != kOkCsvRC )
+    goto errLabel;
+
+  // compare the streaming reader to the reference
+  r.bp = _cmCsvHandleToPtr(r.csvH)->bindPtr;
+
+  if((rc = cmCsvRdParseFile(h,fn,0,_cmCsvRdTestFunc,&r)) != kOkCsvRC )
+    goto errLabel;
+
+  // time the streaming reader
+  cmTimeGetMonotonic(&t0);
+
+  if((rc = cmCsvRdParseFile(h,fn,0,_cmCsvRdCountFunc,&rowCnt)) != kOkCsvRC )
+    goto errLabel;
+
+  cmTimeGetMonotonic(&t1);
+  rdUs = cmTimeElapsedMicros(&t0,&t1);
+
+  cmRptPrintf(r.rpt,"rows:%i cells:%i chunks:%i mismatches:%i\n",r.rowCnt,r.cellCnt,r.chunkCnt,r.errCnt);
+  cmRptPrintf(r.rpt,"cmCsv:  %10.3f ms\n",csvUs/1000.0);
+  cmRptPrintf(r.rpt,"stream: %10.3f ms\n",rdUs/1000.0);
+
+  if( r.errCnt != 0 || rowCnt != r.rowCnt )
+    rc = cmErrMsg(&ctx->err,kDataCvtErrCsvRC,"The streaming reader did not match cmCsv on %i cells of '%s'.",r.errCnt,fn);
+
+ errLabel:
+  cmCsvRdDestroy(&h);
+  cmCsvFinalize(&r.csvH);
+  return rc;
+}
@@ -24,7 +24,8 @@ extern "C" {
     kFileCloseErrCsvRC,
     kDataCvtErrCsvRC,
     kCellNotFoundCsvRC,
-    kDuplicateLexCsvId
+    kDuplicateLexCsvId,
+    kThreadFailCsvRC
   };
 
   typedef unsigned   cmCsvRC_t;
@@ -155,6 +156,73 @@ extern "C" {
   cmCsvRC_t  cmCsvPrint( cmCsvH_t h, unsigned rowCnt );
 
   //)
+
+  //( { label:cmCsvRd file_desc:"Streaming CSV reader with column-major output." kw:[file] }
+  //
+  // cmCsvRdParseFile() reads a CSV file in fixed size chunks and passes the
+  // rows of each chunk to a callback as typed, column-major vectors.
+  // Only the current chunks and the symbol table are held in memory. The
+  // reader does not build the cmCsvCell_t graph used by the cmCsvH_t object.
+  //
+  // The file is read and split into chunks on row boundaries by the calling thread.
+  // The chunks are then parsed in parallel by 'threadCnt' threads and delivered
+  // to the callback in file order.
+  //
+  // Cells are typed in the same way as the cmCsvH_t lexer types them:
+  // kIntCsvTFl   - decimal integer (values outside the range of 'int' are
+  //                returned as kRealCsvTFl)
+  // kHexCsvTFl   - hexadecimal integer (0x...) stored in cmCsvValue_t.i
+  // kRealCsvTFl  - floating point number
+  // kIdentCsvTFl - any other unquoted text
+  // kStrCsvTFl   - double quoted text. The quotes are removed but backslash
+  //                escapes are not translated.
+  // Text cells are interned into the reader's symbol table and are
+  // returned as symbol id's (see cmCsvRdSymText()). Blank cells have a type of 0.
+  // Blank lines are skipped. Comments and user defined lexer tokens are not supported.
+
+  typedef cmHandle_t cmCsvRdH_t;
+
+  extern cmCsvRdH_t cmCsvRdNullHandle;
+
+  typedef union
+  {
+    int      i;      // kIntCsvTFl or kHexCsvTFl
+    double   r;      // kRealCsvTFl
+    unsigned symId;  // kIdentCsvTFl or kStrCsvTFl
+  } cmCsvValue_t;
+
+  // The cell at 'row' and 'col' of a chunk is given by
+  // typeV[ col*rowCnt + row ] and valueV[ col*rowCnt + row ].
+  typedef struct
+  {
+    unsigned             rowIdx;  // file row index of the first row in this chunk
+    unsigned             rowCnt;  // count of rows in this chunk
+    unsigned             colCnt;  // count of columns in this chunk
+    const unsigned char* typeV;   // typeV[ colCnt*rowCnt ]  cell type (kXXXCsvTFl) or 0 if the cell is blank
+    const cmCsvValue_t*  valueV;  // valueV[ colCnt*rowCnt ] cell values
+  } cmCsvChunk_t;
+
+  // Called once per chunk. The chunk is only valid during the call.
+  // Return a value other than kOkCsvRC to stop parsing.
+  typedef cmCsvRC_t (*cmCsvRdFunc_t)( void* arg, cmCsvRdH_t h, const cmCsvChunk_t* chunk );
+
+  // Set 'chunkByteCnt' to 0 to use the default chunk size (1MB).
+  // A chunk grows beyond 'chunkByteCnt' only to hold a row which is longer than the chunk.
+  // 'threadCnt' sets the count of parsing threads including the calling thread.
+  cmCsvRC_t       cmCsvRdCreate(  cmCtx_t* ctx, cmCsvRdH_t* hp, unsigned chunkByteCnt, unsigned threadCnt );
+  cmCsvRC_t       cmCsvRdDestroy( cmCsvRdH_t* hp );
+  bool            cmCsvRdIsValid( cmCsvRdH_t h );
+
+  // Set 'maxRowCnt' to 0 if there is no row limit on the file.
+  cmCsvRC_t       cmCsvRdParseFile( cmCsvRdH_t h, const char* fn, unsigned maxRowCnt, cmCsvRdFunc_t func, void* arg );
+
+  // Return the text associated with a symbol id. Symbols remain valid until the reader is destroyed.
+  const cmChar_t* cmCsvRdSymText( cmCsvRdH_t h, unsigned symId );
+
+  // Compare the streaming reader to cmCsvInitializeFromFile() on 'fn' and report the parse times.
+  cmCsvRC_t       cmCsvRdTest( cmCtx_t* ctx, const char* fn, unsigned chunkByteCnt, unsigned threadCnt );
+
+  //)
   
 #ifdef __cplusplus
 }
@@ -11,6 +11,10 @@
 #include "cmLex.h"
 #include "cmText.h"
 #include "cmStack.h"
+#include "cmTime.h"
+
+#include <stdint.h>
+#include <sys/uio.h>
 
 typedef struct
 {
@@ -143,9 +147,14 @@ void _cmDataFree( cmData_t* p )
 
   if( cmDataIsStruct(p) )
   {
+    // get the next sibling before the child is released
     cmData_t* cp = p->u.child;
-    for(; cp!=NULL; cp=cp->sibling)
+    while( cp!=NULL )
+    {
+      cmData_t* np = cp->sibling;
       _cmDataFree(cp);
+      cp = np;
+    }
   }
     
   _cmDataFreeData(p);
@@ -2444,141 +2453,591 @@ cmDtRC_t cmDataRecdParseId(cmData_t* p, cmErr_t* err, unsigned errRC, ... )
 //============================================================================
 //============================================================================
 //============================================================================
-#ifdef NOT_DEF
-unsigned _cmDataSerializeNodeByteCount( const cmData_t* p )
+// A serialized tree is a cmDtSerialHdr_t followed by one cmDtSerialRecd_t
+// per node in depth first order. The value of a string, blob or array
+// node directly follows the node's record and is padded to a multiple of
+// kDtSerialAlign bytes. Every record and value in a buffer with kDtSerialAlign
+// alignment is therefore naturally aligned and can be used in place.
+// Values are stored using the byte order and type widths of the writer.
+
+enum
 {
-  unsigned n = 0;
+  kDtSerialId      = 0x636d6474, // 'cmdt'
+  kDtSerialVersion = 1,
+  kDtSerialAlign   = 8,
+  kDtIovMinByteCnt = 256         // smaller values are copied to the record buffer by cmDataIovSerialize()
+};
 
-  // all serialized data ele's begin with a cmDataFmtId_t
-  n += sizeof(cmDataFmtId_t);  
+typedef struct
+{
+  unsigned id;       // kDtSerialId
+  unsigned version;  // kDtSerialVersion
+  unsigned byteCnt;  // count of bytes in the buffer including this header
+  unsigned nodeCnt;  // count of node records in the buffer
+} cmDtSerialHdr_t;
 
-  // arrays then have a count of bytes and structures have a child count
-  if( cmDataIsPtr(p) || cmDataIsStruct(p) )
-    n += sizeof(unsigned);
+typedef struct
+{
+  unsigned tid;      // cmDataTypeId_t
+  unsigned cid;      // cmDataContainerId_t
+  unsigned cnt;      // string/blob byte count, array element count or child count
+  unsigned flags;    // kConstValueDtFl | kConstObjDtFl
+  union
+  {
+    double        d; // force 8 byte alignment
+    unsigned char b[8];
+  } u;               // scalar value
+} cmDtSerialRecd_t;
 
-  // then the data itself takes a variable number of bytes
-  n += _cmDataByteCount(p);
+// deserializer stack frame
+typedef struct
+{
+  cmData_t* np;      // list, pair or record node
+  cmData_t* lastPtr; // last child of np
+  unsigned  cnt;     // count of children of np which have not yet been read
+} cmDtSerialFrame_t;
 
-  return n;
-}
+unsigned _cmDataSerialPad( unsigned n )
+{ return (kDtSerialAlign - (n % kDtSerialAlign)) % kDtSerialAlign; }
 
-unsigned cmDataSerializeByteCount( const cmData_t* p )
+// Return false if the record does not describe a node which may be a child of a 'parentCid' container.
+bool _cmDataSerialIsValidRecd( const cmDtSerialRecd_t* r, cmDataContainerId_t parentCid )
 {
-  unsigned bn = 0;
+  switch( r->cid )
+  {
+    case kScalarDtId:
+      if( r->tid < kNullDtId || r->tid > kBlobDtId || (r->tid==kStrDtId && r->cnt==0) )
+        return false;
+      break;
 
-  // if this data type has a child then calculate it's size
-  if( kMinStructDtId <= p->tid && p->tid <= kMaxStructDtId && p->u.child != NULL )
-    bn = cmDataSerializeByteCount(p->u.child);
-  
-  // if this data type has siblings get their type
-  cmData_t* dp = p->u.child;
-  for(; dp != NULL; dp=dp->sibling )
-    bn += cmDataSerializeByteCount(dp->sibling);
-    
+    case kArrayDtId:
+      // arrays of strings and blobs are arrays of pointers
+      if( r->tid < kBoolDtId || r->tid > kDoubleDtId )
+        return false;
+      break;
+
+    case kPairDtId:
+      if( r->tid != kStructDtId || r->cnt != 2 )
+        return false;
+      break;
 
-  // 
-  return  bn + _cmDataSerializeNodeByteCount(p);
+    case kListDtId:
+    case kRecordDtId:
+      if( r->tid != kStructDtId )
+        return false;
+      break;
+
+    default:
+      return false;
+  }
+
+  // the children of records must be pairs
+  return parentCid != kRecordDtId || r->cid == kPairDtId;
 }
 
-char* _cmDataSerializeWriteArray( cmData_t* np, char* dp, const char* ep )
+// Fill the record for 'd' and return the count of value bytes which follow it
+// or cmInvalidCnt if 'd' cannot be serialized.
+unsigned _cmDataSerialFillRecd( const cmData_t* d, cmDataContainerId_t parentCid, cmDtSerialRecd_t* r )
 {
-  unsigned byteCnt = _cmDataByteCount(np);
+  unsigned byteCnt = 0;
 
-  *((unsigned*)dp) = byteCnt;
-  dp += sizeof(unsigned);
+  memset(r,0,sizeof(*r));
+  r->tid   = d->tid;
+  r->cid   = d->cid;
+  r->cnt   = cmDataIsStruct(d) ? cmDataChildCount(d) : d->cnt;
+  r->flags = d->flags & (kConstValueDtFl | kConstObjDtFl);
 
-  memcpy(dp,np->u.vp,byteCnt);
-  dp += byteCnt;
+  if( !_cmDataSerialIsValidRecd(r,parentCid) )
+    return cmInvalidCnt;
 
-  return dp;
+  switch( d->cid )
+  {
+    case kScalarDtId:
+      if( d->tid == kStrDtId || d->tid == kBlobDtId )
+        byteCnt = d->cnt;
+      else
+        if( d->tid != kNullDtId )
+          memcpy(r->u.b,&d->u,cmDataByteWidth(d->tid));
+      break;
+
+    case kArrayDtId:
+      byteCnt = d->cnt * cmDataByteWidth(d->tid);
+      break;
+
+    default:
+      break;
+  }
+
+  return byteCnt > 0 && d->u.vp == NULL ? cmInvalidCnt : byteCnt;
 }
 
-char* _cmDataSerializeWriteStruct( cmData_t* np, char* dp, const char* ep )
+unsigned _cmDataSerializeByteCount( const cmData_t* d, cmDataContainerId_t parentCid )
 {
-  *((unsigned*)dp) = cmDataChildCount(np);
-  dp += sizeof(unsigned);
+  cmDtSerialRecd_t r;
+  const cmData_t*  cp;
+  unsigned         n;
+  unsigned         byteCnt;
 
-  return dp;
+  if((n = _cmDataSerialFillRecd(d,parentCid,&r)) == cmInvalidCnt )
+    return cmInvalidCnt;
+
+  byteCnt = sizeof(r) + n + _cmDataSerialPad(n);
+
+  if( cmDataIsStruct(d) )
+    for(cp=d->u.child; cp!=NULL; cp=cp->sibling)
+    {
+      if((n = _cmDataSerializeByteCount(cp,d->cid)) == cmInvalidCnt )
+        return cmInvalidCnt;
+
+      byteCnt += n;
+    }
+
+  return byteCnt;
 }
 
+unsigned cmDataSerializeByteCount( const cmData_t* p )
+{
+  unsigned n = _cmDataSerializeByteCount(p,kInvalidCntDtId);
+  return n == cmInvalidCnt ? cmInvalidCnt : sizeof(cmDtSerialHdr_t) + n;
+}
 
-char* _cmDataSerializeWrite( cmData_t* np, char* dp, const char* ep )
-{
-  assert( dp + _cmDataSerializeNodeByteCount(np) <= ep );
-
-  *((cmDataFmtId_t*)dp) = np->tid;
-  dp += sizeof(cmDataFmtId_t);
-
-  switch( np->tid )
-  {
-    case kNullDtId:   break;
-    case kBoolDtId:   *((bool*)dp)           = cmDataBool(np);   dp+=sizeof(bool);           break;
-    case kUCharDtId:  *((unsigned char*)dp)  = cmDataUChar(np);  dp+=sizeof(unsigned char);  break;
-    case kCharDtId:   *((char*)dp)           = cmDataChar(np);   dp+=sizeof(char);           break;
-    case kUShortDtId: *((unsigned short*)dp) = cmDataUShort(np); dp+=sizeof(unsigned short); break;
-    case kShortDtId:  *((short*)dp)          = cmDataShort(np);  dp+=sizeof(short);          break;
-    case kUIntDtId:   *((unsigned int*)dp)   = cmDataUInt(np);   dp+=sizeof(unsigned int);   break;
-    case kIntDtId:    *((int*)dp)            = cmDataInt(np);    dp+=sizeof(int);            break;
-    case kULongDtId:  *((unsigned long*)dp)  = cmDataULong(np);  dp+=sizeof(unsigned long);  break;
-    case kLongDtId:   *((long*)dp)           = cmDataLong(np);   dp+=sizeof(long);           break;
-    case kFloatDtId:  *((float*)dp)          = cmDataFloat(np);  dp+=sizeof(float);          break;
-    case kDoubleDtId: *((double*)dp)         = cmDataDouble(np); dp+=sizeof(double);         break;
-    case kStrDtId:       dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kConstStrDtId:  dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kUCharPtrDtId:  dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kCharPtrDtId:   dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kUShortPtrDtId: dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kShortPtrDtId:  dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kUIntPtrDtId:   dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kIntPtrDtId:    dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kULongPtrDtId:  dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kLongPtrDtId:   dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kFloatPtrDtId:  dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kDoublePtrDtId: dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kVoidPtrDtId:   dp = _cmDataSerializeWriteArray(np,dp,ep); break;
-    case kListDtId:      dp = _cmDataSerializeWriteStruct(np,dp,ep); break;
-    case kPairDtId:      dp = _cmDataSerializeWriteStruct(np,dp,ep); break;
-    case kRecordDtId:    dp = _cmDataSerializeWriteStruct(np,dp,ep); break;
-    default:
-      { assert(0); }
+// Write the subtree 'd' to dp[] and return the next location in dp[]
+// or NULL if the buffer is too small or the tree cannot be serialized.
+char* _cmDataSerialize( const cmData_t* d, cmDataContainerId_t parentCid, char* dp, const char* ep, unsigned* nodeCntRef )
+{
+  cmDtSerialRecd_t r;
+  const cmData_t*  cp;
+  unsigned         n,padCnt;
+
+  if((n = _cmDataSerialFillRecd(d,parentCid,&r)) == cmInvalidCnt )
+    return NULL;
+
+  padCnt = _cmDataSerialPad(n);
+
+  if( ep - dp < (long)(sizeof(r) + n + padCnt) )
+    return NULL;
+
+  // the buffer may not be aligned
+  memcpy(dp,&r,sizeof(r));
+  dp += sizeof(r);
+
+  if( n > 0 )
+  {
+    memcpy(dp,d->u.vp,n);
+    memset(dp+n,0,padCnt);
+    dp += n + padCnt;
   }
+
+  *nodeCntRef += 1;
+
+  if( cmDataIsStruct(d) )
+    for(cp=d->u.child; cp!=NULL && dp!=NULL; cp=cp->sibling)
+      dp = _cmDataSerialize(cp,d->cid,dp,ep,nodeCntRef);
+
   return dp;
 }
 
-char* _cmDataSerialize( const cmData_t* p, char* buf, const char* ep )
+cmDtRC_t cmDataSerialize( const cmData_t* p, void* buf, unsigned bufByteCnt )
 {
-  /*
-  buf = _cmDataSerializeWrite(p,buf,ep);
+  cmDtSerialHdr_t hdr;
+  char*           dp = buf;
 
-  // if this data type has a child then write the child
-  if( kMinStructDtId <= p->tid && p->tid <= kMaxStructDtId && p->u.child != NULL )
-    buf = _cmDataSerialize(p->u.child,buf,ep);
-  
-  // if this data type has siblings then write sibings
-  cmData_t* dp = p->u.child;
-  for(; dp != NULL; dp=dp->sibling )
-    buf = cmDataSerialize(dp->sibling,buf,ep);
+  memset(&hdr,0,sizeof(hdr));
 
-  return buf;
-  */
-  return NULL;
+  if( bufByteCnt < sizeof(hdr) || (dp = _cmDataSerialize(p,kInvalidCntDtId,dp + sizeof(hdr),dp + bufByteCnt,&hdr.nodeCnt)) == NULL )
+  {
+    if( cmDataSerializeByteCount(p) == cmInvalidCnt )
+      return _cmDtErrMsg(p,kInvalidTypeDtRC,"The tree contains a node which cannot be serialized.");
+
+    return _cmDtErrMsg(p,kSerialErrDtRC,"The serialization buffer is too small.");
+  }
+
+  hdr.id      = kDtSerialId;
+  hdr.version = kDtSerialVersion;
+  hdr.byteCnt = dp - (char*)buf;
+  memcpy(buf,&hdr,sizeof(hdr));
+
+  return kOkDtRC;
 }
 
-cmDtRC_t cmDataSerialize( const cmData_t* p, void* buf, unsigned bufByteCnt )
+// If 'viewFl' is set then the nodes are allocated in a single block
+// and the string, blob and array values refer to buf[].
+cmDtRC_t _cmDataDeserialize( const void* buf, unsigned bufByteCnt, bool viewFl, cmData_t** pp )
 {
-  /*
-  const char* ep = (char*)p + bufByteCnt;
-  buf = _cmDataSerialize(p,buf,bufByteCnt);
-  assert( buf <= ep );
-  */
-  return kOkDtRC;
+  cmDtRC_t           rc       = kOkDtRC;
+  const char*        bp       = buf;
+  const char*        ep;
+  cmDtSerialHdr_t    hdr;
+  cmData_t*          nodeV    = NULL;
+  cmData_t*          rootPtr  = NULL;
+  cmDtSerialFrame_t* stackV   = NULL;
+  unsigned           stackCnt = 0;
+  unsigned           i;
+
+  *pp = NULL;
+
+  if( bufByteCnt < sizeof(hdr) )
+    return _cmDtErrMsg(NULL,kSerialErrDtRC,"The serialization buffer is too small.");
+
+  memcpy(&hdr,bp,sizeof(hdr));
+
+  if( hdr.id != kDtSerialId || hdr.version != kDtSerialVersion || hdr.byteCnt < sizeof(hdr) || hdr.byteCnt > bufByteCnt || hdr.nodeCnt == 0 || hdr.nodeCnt > (hdr.byteCnt - sizeof(hdr)) / sizeof(cmDtSerialRecd_t) )
+    return _cmDtErrMsg(NULL,kSerialErrDtRC,"Invalid serialization buffer header.");
+
+  ep  = bp + hdr.byteCnt;
+  bp += sizeof(hdr);
+
+  if( viewFl )
+    nodeV = cmMemAllocZ(cmData_t,hdr.nodeCnt);
+
+  // the depth of the tree cannot exceed the count of nodes
+  stackV = cmMemAlloc(cmDtSerialFrame_t,hdr.nodeCnt);
+
+  for(i=0; i<hdr.nodeCnt; ++i)
+  {
+    cmDtSerialFrame_t* f = stackCnt==0 ? NULL : stackV + stackCnt - 1;
+    cmDtSerialRecd_t   r;
+    cmData_t*          d;
+    unsigned           n = 0;
+
+    if( i>0 && f==NULL )
+    {
+      rc = _cmDtErrMsg(NULL,kSerialErrDtRC,"The serialization buffer contains more than one tree.");
+      goto errLabel;
+    }
+
+    if( ep - bp < (long)sizeof(r) )
+    {
+      rc = _cmDtErrMsg(NULL,kSerialErrDtRC,"The serialization buffer is truncated.");
+      goto errLabel;
+    }
+
+    memcpy(&r,bp,sizeof(r));
+    bp += sizeof(r);
+
+    if( !_cmDataSerialIsValidRecd(&r, f==NULL ? kInvalidCntDtId : f->np->cid) )
+    {
+      rc = _cmDtErrMsg(NULL,kSerialErrDtRC,"Invalid node record in serialization buffer.");
+      goto errLabel;
+    }
+
+    // view nodes are released with the root node
+    if( viewFl )
+    {
+      d        = nodeV + i;
+      d->flags = i==0 ? kFreeObjDtFl : 0;
+    }
+    else
+    {
+      d        = cmMemAllocZ(cmData_t,1);
+      d->flags = kFreeObjDtFl | (r.flags & (kConstValueDtFl | kConstObjDtFl));
+    }
+
+    d->tid = r.tid;
+    d->cid = r.cid;
+
+    // link the new node to the end of it's parent's child list
+    if( f == NULL )
+      rootPtr = d;
+    else
+    {
+      d->parent = f->np;
+
+      if( f->lastPtr == NULL )
+        f->np->u.child = d;
+      else
+        f->lastPtr->sibling = d;
+
+      f->lastPtr = d;
+      f->cnt    -= 1;
+    }
+
+    switch( r.cid )
+    {
+      case kScalarDtId:
+        if( r.tid == kStrDtId || r.tid == kBlobDtId )
+          n = r.cnt;
+        else
+          if( r.tid != kNullDtId )
+            memcpy(&d->u,r.u.b,cmDataByteWidth(r.tid));
+        d->cnt = r.cnt;
+        break;
+
+      case kArrayDtId:
+        if( r.cnt > (unsigned)(ep - bp) / cmDataByteWidth(r.tid) )
+        {
+          rc = _cmDtErrMsg(NULL,kSerialErrDtRC,"The serialization buffer is truncated.");
+          goto errLabel;
+        }
+        n      = r.cnt * cmDataByteWidth(r.tid);
+        d->cnt = r.cnt;
+        break;
+
+      default:
+        if( r.cnt > 0 )
+        {
+          stackV[ stackCnt ].np      = d;
+          stackV[ stackCnt ].lastPtr = NULL;
+          stackV[ stackCnt ].cnt     = r.cnt;
+          ++stackCnt;
+        }
+        break;
+    }
+
+    if( n > 0 )
+    {
+      unsigned padCnt   = _cmDataSerialPad(n);
+      unsigned availCnt = ep - bp;
+
+      if( n > availCnt || padCnt > availCnt - n )
+      {
+        rc = _cmDtErrMsg(NULL,kSerialErrDtRC,"The serialization buffer is truncated.");
+        goto errLabel;
+      }
+
+      if( r.tid == kStrDtId && bp[n-1] != 0 )
+      {
+        rc = _cmDtErrMsg(NULL,kSerialErrDtRC,"Unterminated string in serialization buffer.");
+        goto errLabel;
+      }
+
+      // a view refers to the buffer unless the buffer is not aligned for the array element type
+      if( viewFl && (r.cid != kArrayDtId || (uintptr_t)bp % cmDataByteWidth(r.tid) == 0) )
+      {
+        d->u.vp   = (void*)bp;
+        d->flags |= kNoCopyDtFl;
+      }
+      else
+      {
+        d->u.vp   = cmMemAlloc(char,n);
+        d->flags |= kFreeValueDtFl;
+        memcpy(d->u.vp,bp,n);
+      }
+
+      bp += n + padCnt;
+    }
+
+    if( viewFl && cmDataIsLeaf(d) )
+      d->flags |= kConstValueDtFl;
+
+    // pop the completed containers
+    while( stackCnt>0 && stackV[stackCnt-1].cnt == 0 )
+      --stackCnt;
+  }
+
+  if( stackCnt > 0 )
+  {
+    rc = _cmDtErrMsg(NULL,kSerialErrDtRC,"The serialization buffer is truncated.");
+    goto errLabel;
+  }
+
+ errLabel:
+  cmMemFree(stackV);
+
+  if( rc != kOkDtRC )
+  {
+    // the partial tree is always fully linked
+    if( rootPtr != NULL )
+      cmDataFree(rootPtr);
+    else
+      cmMemFree(nodeV);
+    rootPtr = NULL;
+  }
+
+  *pp = rootPtr;
+
+  return rc;
 }
 
 cmDtRC_t cmDataDeserialize( const void* buf, unsigned bufByteCnt, cmData_t** pp )
+{ return _cmDataDeserialize(buf,bufByteCnt,false,pp); }
+
+cmDtRC_t cmDataDeserializeView( const void* buf, unsigned bufByteCnt, cmData_t** pp )
+{ return _cmDataDeserialize(buf,bufByteCnt,true,pp); }
+
+//----------------------------------------------------------------------------
+// Gather serialization
+//
+
+typedef struct
+{
+  struct iovec* iovV;            // iovV[iovAllocCnt]
+  unsigned      iovAllocCnt;
+  unsigned      iovCnt;          // count of elements of iovV[] in use
+  char*         bufV;            // bufV[bufAllocByteCnt] record buffer
+  unsigned      bufAllocByteCnt;
+  unsigned      bufByteCnt;      // count of bytes of bufV[] in use
+  unsigned      begOffs;         // offset into bufV[] of the current record vector
+  unsigned      nodeCnt;
+} cmDataIov_t;
+
+cmDataIovH_t cmDataIovNullHandle = cmSTATIC_NULL_HANDLE;
+
+cmDataIov_t* _cmDataIovHandleToPtr( cmDataIovH_t h )
+{
+  cmDataIov_t* p = (cmDataIov_t*)h.h;
+  assert( p!= NULL );
+  return p;
+}
+
+cmDtRC_t cmDataIovCreate( cmDataIovH_t* hp )
 {
+  cmDtRC_t rc;
+
+  if((rc = cmDataIovDestroy(hp)) != kOkDtRC )
+    return rc;
+
+  hp->h = cmMemAllocZ(cmDataIov_t,1);
+
+  return rc;
+}
+
+cmDtRC_t cmDataIovDestroy( cmDataIovH_t* hp )
+{
+  if( hp == NULL || cmDataIovIsValid(*hp) == false )
+    return kOkDtRC;
+
+  cmDataIov_t* p = _cmDataIovHandleToPtr(*hp);
+
+  cmMemFree(p->iovV);
+  cmMemFree(p->bufV);
+  cmMemFree(p);
+  hp->h = NULL;
+
   return kOkDtRC;
 }
-#endif
+
+bool cmDataIovIsValid( cmDataIovH_t h )
+{ return h.h != NULL; }
+
+// Return a pointer to 'byteCnt' bytes at the end of the record buffer.
+char* _cmDataIovAlloc( cmDataIov_t* p, unsigned byteCnt )
+{
+  char* dp;
+
+  if( p->bufByteCnt + byteCnt > p->bufAllocByteCnt )
+  {
+    p->bufAllocByteCnt = cmMax(4096,cmMax(2*p->bufAllocByteCnt,p->bufByteCnt + byteCnt));
+    p->bufV            = cmMemResizeP(char,p->bufV,p->bufAllocByteCnt);
+  }
+
+  dp             = p->bufV + p->bufByteCnt;
+  p->bufByteCnt += byteCnt;
+  return dp;
+}
+
+void _cmDataIovPush( cmDataIov_t* p, void* base, unsigned byteCnt )
+{
+  if( p->iovCnt == p->iovAllocCnt )
+  {
+    p->iovAllocCnt = cmMax(64,2*p->iovAllocCnt);
+    p->iovV        = cmMemResizeP(struct iovec,p->iovV,p->iovAllocCnt);
+  }
+
+  p->iovV[ p->iovCnt ].iov_base = base;
+  p->iovV[ p->iovCnt ].iov_len  = byteCnt;
+  p->iovCnt += 1;
+}
+
+// Record vectors refer to bufV[] which may move as it grows and are
+// therefore stored as offsets until the tree is complete.
+void _cmDataIovCloseRecdVector( cmDataIov_t* p )
+{
+  _cmDataIovPush(p,(void*)(uintptr_t)p->begOffs,p->bufByteCnt - p->begOffs);
+  p->begOffs = p->bufByteCnt;
+}
+
+cmDtRC_t _cmDataIovSerialize( cmDataIov_t* p, const cmData_t* d, cmDataContainerId_t parentCid )
+{
+  cmDtRC_t         rc = kOkDtRC;
+  cmDtSerialRecd_t r;
+  const cmData_t*  cp;
+  unsigned         n,padCnt;
+
+  if((n = _cmDataSerialFillRecd(d,parentCid,&r)) == cmInvalidCnt )
+    return _cmDtErrMsg(d,kInvalidTypeDtRC,"The tree contains a node which cannot be serialized.");
+
+  padCnt = _cmDataSerialPad(n);
+
+  memcpy(_cmDataIovAlloc(p,sizeof(r)),&r,sizeof(r));
+  p->nodeCnt += 1;
+
+  if( n > 0 )
+  {
+    if( n < kDtIovMinByteCnt )
+    {
+      char* dp = _cmDataIovAlloc(p,n + padCnt);
+      memcpy(dp,d->u.vp,n);
+      memset(dp+n,0,padCnt);
+    }
+    else
+    {
+      // refer to the value in place
+      _cmDataIovCloseRecdVector(p);
+      _cmDataIovPush(p,d->u.vp,n);
+      memset(_cmDataIovAlloc(p,padCnt),0,padCnt);
+    }
+  }
+
+  if( cmDataIsStruct(d) )
+    for(cp=d->u.child; cp!=NULL && rc==kOkDtRC; cp=cp->sibling)
+      rc = _cmDataIovSerialize(p,cp,d->cid);
+
+  return rc;
+}
+
+cmDtRC_t cmDataIovSerialize( cmDataIovH_t h, const cmData_t* d, const struct iovec** iovRef, unsigned* iovCntRef, unsigned* byteCntRef )
+{
+  cmDtRC_t        rc;
+  cmDataIov_t*    p       = _cmDataIovHandleToPtr(h);
+  unsigned        byteCnt = 0;
+  unsigned        i;
+  cmDtSerialHdr_t hdr;
+
+  p->iovCnt     = 0;
+  p->bufByteCnt = 0;
+  p->begOffs    = 0;
+  p->nodeCnt    = 0;
+
+  // reserve space for the header
+  _cmDataIovAlloc(p,sizeof(hdr));
+
+  if((rc = _cmDataIovSerialize(p,d,kInvalidCntDtId)) != kOkDtRC )
+  {
+    p->iovCnt = 0;
+    goto errLabel;
+  }
+
+  if( p->bufByteCnt > p->begOffs )
+    _cmDataIovCloseRecdVector(p);
+
+  // record vectors and values alternate beginning with a record vector
+  for(i=0; i<p->iovCnt; ++i)
+  {
+    if( i % 2 == 0 )
+      p->iovV[i].iov_base = p->bufV + (uintptr_t)p->iovV[i].iov_base;
+
+    byteCnt += p->iovV[i].iov_len;
+  }
+
+  hdr.id      = kDtSerialId;
+  hdr.version = kDtSerialVersion;
+  hdr.byteCnt = byteCnt;
+  hdr.nodeCnt = p->nodeCnt;
+  memcpy(p->bufV,&hdr,sizeof(hdr));
+
+ errLabel:
+  if( iovRef != NULL )
+    *iovRef = p->iovV;
+
+  if( iovCntRef != NULL )
+    *iovCntRef = p->iovCnt;
+
+  if( byteCntRef != NULL )
+    *byteCntRef = byteCnt;
+
+  return rc;
+}
 
 //============================================================================
 //============================================================================
@@ -3356,6 +3815,223 @@ cmDtRC_t cmDataParserTest( cmCtx_t* ctx )
 }
 
 
+// Return true if the trees 'a' and 'b' have the same structure, types and values.
+bool _cmDataIsEqual( const cmData_t* a, const cmData_t* b )
+{
+  if( a->cid != b->cid || a->tid != b->tid )
+    return false;
+
+  switch( a->cid )
+  {
+    case kScalarDtId:
+      if( a->tid == kStrDtId || a->tid == kBlobDtId )
+        return a->cnt == b->cnt && (a->cnt == 0 || memcmp(a->u.vp,b->u.vp,a->cnt) == 0);
+
+      return a->tid == kNullDtId || memcmp(&a->u,&b->u,cmDataByteWidth(a->tid)) == 0;
+
+    case kArrayDtId:
+      return a->cnt == b->cnt && (a->cnt == 0 || memcmp(a->u.vp,b->u.vp,a->cnt * cmDataByteWidth(a->tid)) == 0);
+
+    default:
+      break;
+  }
+
+  for(a=a->u.child,b=b->u.child; a!=NULL && b!=NULL; a=a->sibling,b=b->sibling)
+    if( !_cmDataIsEqual(a,b) )
+      return false;
+
+  return a == b;
+}
+
+// Create a chain of 'depth' nested records.
+cmData_t* _cmDataBenchNestedRecd( unsigned depth )
+{
+  float     tagV[] = { 0.1f, 0.2f, 0.3f, 0.4f };
+  cmData_t* root   = NULL;
+  cmData_t* rp     = NULL;
+  cmData_t* vp     = NULL;
+  cmChar_t  name[32];
+  unsigned  i;
+
+  for(i=0; i<depth; ++i)
+  {
+    cmData_t* np = cmDataRecdAlloc(NULL);
+
+    snprintf(name,sizeof(name),"level-%i",i);
+
+    cmDataNewUInt(      NULL, kNoFlagsDtFl, i,       &vp ); cmDataPairAllocLabel(np,"id",  vp,NULL);
+    cmDataNewStr(       NULL, kNoFlagsDtFl, name,    &vp ); cmDataPairAllocLabel(np,"name",vp,NULL);
+    cmDataNewDouble(    NULL, kNoFlagsDtFl, i * 0.5, &vp ); cmDataPairAllocLabel(np,"gain",vp,NULL);
+    cmDataNewFloatArray(NULL, tagV, 4, kNoFlagsDtFl, &vp ); cmDataPairAllocLabel(np,"tags",vp,NULL);
+
+    if( rp == NULL )
+      root = np;
+    else
+      cmDataPairAllocLabel(rp,"child",np,NULL);
+
+    rp = np;
+  }
+
+  return root;
+}
+
+// Create a record of large numeric arrays.
+cmData_t* _cmDataBenchArrayRecd( unsigned eleCnt )
+{
+  cmData_t* rp = cmDataRecdAlloc(NULL);
+  cmData_t* vp = NULL;
+  double*   dV = cmMemAlloc(double,eleCnt);
+  float*    fV = cmMemAlloc(float, eleCnt);
+  int*      iV = cmMemAlloc(int,   eleCnt);
+  unsigned  i;
+
+  for(i=0; i<eleCnt; ++i)
+  {
+    dV[i] = i * 0.001;
+    fV[i] = i * 0.01f;
+    iV[i] = i;
+  }
+
+  cmDataNewDoubleArray( NULL, dV, eleCnt, kNoFlagsDtFl, &vp ); cmDataPairAllocLabel(rp,"d0",vp,NULL);
+  cmDataNewDoubleArray( NULL, dV, eleCnt, kNoFlagsDtFl, &vp ); cmDataPairAllocLabel(rp,"d1",vp,NULL);
+  cmDataNewFloatArray(  NULL, fV, eleCnt, kNoFlagsDtFl, &vp ); cmDataPairAllocLabel(rp,"f0",vp,NULL);
+  cmDataNewFloatArray(  NULL, fV, eleCnt, kNoFlagsDtFl, &vp ); cmDataPairAllocLabel(rp,"f1",vp,NULL);
+  cmDataNewIntArray(    NULL, iV, eleCnt, kNoFlagsDtFl, &vp ); cmDataPairAllocLabel(rp,"i0",vp,NULL);
+
+  cmMemFree(dV);
+  cmMemFree(fV);
+  cmMemFree(iV);
+
+  return rp;
+}
+
+cmDtRC_t _cmDataSerialBenchTree( cmCtx_t* ctx, const cmChar_t* label, const cmData_t* d, unsigned iterCnt )
+{
+  cmDtRC_t            rc      = kOkDtRC;
+  cmRpt_t*            rpt     = &ctx->rpt;
+  cmDataIovH_t        ioH     = cmDataIovNullHandle;
+  const struct iovec* iovV    = NULL;
+  unsigned            iovCnt  = 0;
+  unsigned            iovN    = 0;
+  unsigned            byteCnt = cmDataSerializeByteCount(d);
+  char*               buf     = NULL;
+  char*               gbuf    = NULL;
+  cmData_t*           dd      = NULL;
+  unsigned            serUs   = 0;
+  unsigned            iovUs   = 0;
+  unsigned            copyUs  = 0;
+  unsigned            viewUs  = 0;
+  unsigned            i,j;
+  cmTimeSpec_t        t0,t1;
+
+  if( byteCnt == cmInvalidCnt )
+    return cmErrMsg(&ctx->err,kInvalidTypeDtRC,"The '%s' tree cannot be serialized.",label);
+
+  buf  = cmMemAlloc(char,byteCnt);
+  gbuf = cmMemAlloc(char,byteCnt);
+
+  cmDataIovCreate(&ioH);
+
+  // verify the contiguous and gathered buffers and both deserialization modes
+  if((rc = cmDataSerialize(d,buf,byteCnt)) != kOkDtRC )
+    goto errLabel;
+
+  if((rc = cmDataIovSerialize(ioH,d,&iovV,&iovCnt,&iovN)) != kOkDtRC )
+    goto errLabel;
+
+  for(i=0,j=0; i<iovCnt && j+iovV[i].iov_len<=iovN; ++i)
+  {
+    memcpy(gbuf+j,iovV[i].iov_base,iovV[i].iov_len);
+    j += iovV[i].iov_len;
+  }
+
+  if( iovN != byteCnt || memcmp(buf,gbuf,byteCnt) != 0 )
+  {
+    rc = cmErrMsg(&ctx->err,kSerialErrDtRC,"The '%s' gathered buffer does not match the serialized buffer.",label);
+    goto errLabel;
+  }
+
+  if((rc = cmDataDeserialize(buf,byteCnt,&dd)) != kOkDtRC || !_cmDataIsEqual(d,dd) )
+  {
+    rc = cmErrMsg(&ctx->err,kSerialErrDtRC,"The '%s' deserialized tree does not match the source tree.",label);
+    goto errLabel;
+  }
+
+  cmDataFree(dd);
+  dd = NULL;
+
+  if((rc = cmDataDeserializeView(buf,byteCnt,&dd)) != kOkDtRC || !_cmDataIsEqual(d,dd) )
+  {
+    rc = cmErrMsg(&ctx->err,kSerialErrDtRC,"The '%s' deserialized view does not match the source tree.",label);
+    goto errLabel;
+  }
+
+  cmDataFree(dd);
+  dd = NULL;
+
+  for(i=0; i<iterCnt; ++i)
+  {
+    cmTimeGetMonotonic(&t0);
+    cmDataSerialize(d,buf,cmDataSerializeByteCount(d));
+    cmTimeGetMonotonic(&t1);
+    serUs += cmTimeElapsedMicros(&t0,&t1);
+
+    cmTimeGetMonotonic(&t0);
+    cmDataIovSerialize(ioH,d,&iovV,&iovCnt,&iovN);
+    cmTimeGetMonotonic(&t1);
+    iovUs += cmTimeElapsedMicros(&t0,&t1);
+
+    cmTimeGetMonotonic(&t0);
+    cmDataDeserialize(buf,byteCnt,&dd);
+    cmDataFree(dd);
+    cmTimeGetMonotonic(&t1);
+    copyUs += cmTimeElapsedMicros(&t0,&t1);
+
+    cmTimeGetMonotonic(&t0);
+    cmDataDeserializeView(buf,byteCnt,&dd);
+    cmDataFree(dd);
+    cmTimeGetMonotonic(&t1);
+    viewUs += cmTimeElapsedMicros(&t0,&t1);
+  }
+
+  dd = NULL;
+
+  cmRptPrintf(rpt,"%s: %i bytes %i vectors %i iterations\n",label,byteCnt,iovCnt,iterCnt);
+  cmRptPrintf(rpt,"serialize:        %10.3f ms\n",serUs  / 1000.0 / iterCnt);
+  cmRptPrintf(rpt,"gather:           %10.3f ms\n",iovUs  / 1000.0 / iterCnt);
+  cmRptPrintf(rpt,"deserialize copy: %10.3f ms\n",copyUs / 1000.0 / iterCnt);
+  cmRptPrintf(rpt,"deserialize view: %10.3f ms\n",viewUs / 1000.0 / iterCnt);
+
+ errLabel:
+  cmDataFree(dd);
+  cmDataIovDestroy(&ioH);
+  cmMemFree(buf);
+  cmMemFree(gbuf);
+  return rc;
+}
+
+cmDtRC_t cmDataSerialBench( cmCtx_t* ctx, unsigned depth, unsigned eleCnt, unsigned iterCnt )
+{
+  cmDtRC_t  rc;
+  cmData_t* d;
+
+  if( iterCnt == 0 )
+    iterCnt = 1;
+
+  d  = _cmDataBenchNestedRecd(depth);
+  rc = _cmDataSerialBenchTree(ctx,"nested records",d,iterCnt);
+  cmDataFree(d);
+
+  if( rc != kOkDtRC )
+    return rc;
+
+  d  = _cmDataBenchArrayRecd(eleCnt);
+  rc = _cmDataSerialBenchTree(ctx,"numeric arrays",d,iterCnt);
+  cmDataFree(d);
+
+  return rc;
+}
+
 void     cmDataTest( cmCtx_t* ctx )
 {
   
@@ -3387,7 +4063,8 @@ void     cmDataTest( cmCtx_t* ctx )
 
   cmDataPrint(d1,&ctx->rpt);
   cmDataFree(d1);
- 
+
+  cmDataSerialBench(ctx,100,1024,10);
 
 
   cmRptPrintf(&ctx->rpt,"Done!.\n");
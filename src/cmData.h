@@ -63,7 +63,8 @@ extern "C" {
     kLexFailDtRC,
     kParseStackFailDtRC,
     kSyntaxErrDtRC,
-    kEolDtRC
+    kEolDtRC,
+    kSerialErrDtRC
   };
 
   typedef unsigned cmDtRC_t;
@@ -666,10 +667,53 @@ extern "C" {
   // Serialization related functions
   //
 
+  // A serialized tree is a header followed by one fixed size record per node
+  // in depth first order. Each record describes the type, container and
+  // count of its node. The value of a string, blob or array node directly
+  // follows its record and is padded to a multiple of 8 bytes.
+  // Values use the byte order and type widths of the writer.
+  // Arrays of strings and blobs cannot be serialized.
+
+  // Return the count of bytes required to serialize 'p' or cmInvalidCnt
+  // if the tree contains a node which cannot be serialized.
   unsigned cmDataSerializeByteCount( const cmData_t* p );
+
+  // Serialize the tree 'p' into buf[bufByteCnt] in a single pass.
   cmDtRC_t cmDataSerialize(   const cmData_t* p, void* buf, unsigned bufByteCnt );
+
+  // Create a tree from a serialization buffer. All nodes and values are
+  // dynamically allocated. Release the tree with cmDataFree().
   cmDtRC_t cmDataDeserialize( const void* buf, unsigned bufByteCnt, cmData_t** pp );
 
+  // Create a tree whose string, blob and array values refer directly to buf[].
+  // The nodes are allocated in a single block and have kConstValueDtFl set.
+  // buf[] must remain unchanged until the tree is released with cmDataFree().
+  // Only the root node may be passed to cmDataFree(). Arrays which are not
+  // aligned for their element type in buf[] are copied.
+  cmDtRC_t cmDataDeserializeView( const void* buf, unsigned bufByteCnt, cmData_t** pp );
+
+  // Gather serialization.
+  //
+  // cmDataIovSerialize() describes the serialized form of a tree as a list of
+  // I/O vectors which can be passed directly to writev() or sendmsg().
+  // The node records and small values are written to a buffer owned by the
+  // cmDataIovH_t object. Larger string, blob and array values are not copied
+  // but referenced in place. The vectors are valid until the next call to
+  // cmDataIovSerialize() with the same handle or until the tree changes.
+  // Note that the vector count may exceed the system limit (IOV_MAX) of a
+  // single writev() call.
+  struct iovec;
+  typedef cmHandle_t cmDataIovH_t;
+  extern cmDataIovH_t cmDataIovNullHandle;
+
+  cmDtRC_t cmDataIovCreate(  cmDataIovH_t* hp );
+  cmDtRC_t cmDataIovDestroy( cmDataIovH_t* hp );
+  bool     cmDataIovIsValid( cmDataIovH_t h );
+
+  // Set *iovRef to the vector list, *iovCntRef to the count of vectors and
+  // *byteCntRef to the total count of bytes described by the vectors.
+  cmDtRC_t cmDataIovSerialize( cmDataIovH_t h, const cmData_t* p, const struct iovec** iovRef, unsigned* iovCntRef, unsigned* byteCntRef );
+
   //----------------------------------------------------------------------------
   // Text to Data related functions
   //
@@ -692,6 +736,11 @@ extern "C" {
   void     cmDataPrint( const cmData_t* p, cmRpt_t* rpt );
   
   void     cmDataTest( cmCtx_t* ctx );
+
+  // Serialize and deserialize a tree of 'depth' nested records and a record
+  // of 'eleCnt' element numeric arrays 'iterCnt' times, verify the results and
+  // report the time taken by each serialization mode.
+  cmDtRC_t cmDataSerialBench( cmCtx_t* ctx, unsigned depth, unsigned eleCnt, unsigned iterCnt );
   //)
 
 #ifdef __cplusplus
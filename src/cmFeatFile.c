@@ -17,6 +17,7 @@
 #include "cmJson.h"
 #include "cmFileSys.h"
 #include "cmTime.h"
+#include "cmThread.h"
 #include "cmMidi.h"
 #include "cmProcObj.h"
 #include "cmProcTemplateMain.h"
@@ -65,6 +66,8 @@ typedef struct
   unsigned           progSmpCnt;
   unsigned           progSmpIdx;
 
+  struct _cmFtBatch_str* batch;  // set while cmFtAnalyzeBatch() is running on this analyzer
+  cmThreadMutexH_t   initMtxH;   // batch worker analyzers hold this lock during _cmFtProcInit()
 
 } _cmFt_t;
 
@@ -1498,20 +1501,20 @@ int _cmFtAnlCompare( const void* pp0, const void* pp1 )
 }
 
 
-cmFtRC_t   _cmFtValidateAttrArray( _cmFt_t* p )
+cmFtRC_t   _cmFtValidateAttrArray( _cmFt_t* p, const cmFtParam_t* pp )
 {
   cmFtRC_t rc = kOkFtRC;
   unsigned i,j;
 
-  for(i=0; i<p->attrCnt; ++i)
+  for(i=0; i<pp->attrCnt; ++i)
   {
-    _cmFtLabel_t* lp = _cmFtIdToLabelPtr(p->attrArray[i].id);
+    _cmFtLabel_t* lp = _cmFtIdToLabelPtr(pp->attrArray[i].id);
 
     assert( lp != NULL );
 
     // check for duplicate features
-    for(j=0; j<p->attrCnt; ++j)
-      if( i!=j && p->attrArray[i].id == p->attrArray[j].id )
+    for(j=0; j<pp->attrCnt; ++j)
+      if( i!=j && pp->attrArray[i].id == pp->attrArray[j].id )
       {
         rc = _cmFtError( kParamErrorFtRC, p, "The attribute '%s' has duplicate entries in the attribute array.", cmStringNullGuard(lp->label));
         goto errLabel;
@@ -1520,11 +1523,11 @@ cmFtRC_t   _cmFtValidateAttrArray( _cmFt_t* p )
     // verify that the source id for this secondary feature was specified
     if( lp->srcId != kInvalidFtId )
     {
-      for(j=0; j<p->attrCnt; ++j)
-        if( p->attrArray[j].id == lp->srcId )
+      for(j=0; j<pp->attrCnt; ++j)
+        if( pp->attrArray[j].id == lp->srcId )
           break;
 
-      if( j == p->attrCnt )
+      if( j == pp->attrCnt )
       {
         rc = _cmFtError( kParamErrorFtRC, p, "The primary feature '%s' must be specified in order to use the secondary feature '%s'.",cmStringNullGuard(_cmFtIdToLabelPtr(lp->srcId)->label),lp->label);
         goto errLabel;
@@ -1551,7 +1554,7 @@ cmFtRC_t        cmFtAnalyzeFile( cmFtH_t h, cmFtParam_t* pp)
   unsigned        i;
   cmReal_t        floorThreshAmpl;
 
-  if((rc = _cmFtValidateAttrArray(p)) != kOkFtRC )
+  if((rc = _cmFtValidateAttrArray(p,pp)) != kOkFtRC )
     goto errLabel;
 
   cmVOR_DbToAmplVV(&floorThreshAmpl,1,&pp->floorThreshDb);
@@ -1583,7 +1586,7 @@ cmFtRC_t        cmFtAnalyzeFile( cmFtH_t h, cmFtParam_t* pp)
   }
   
   // initialize the audio file reader
-  if( cmAudioFileRdOpen( p->afRdPtr, f.hopSmpCnt, pp->audioFn, pp->chIdx, 0, cmInvalidIdx ) != cmOkRC )
+  if( cmAudioFileRdOpen( p->afRdPtr, f.hopSmpCnt, pp->audioFn, pp->chIdx, 0, 0 ) != cmOkRC )
   {
     rc =  _cmFtError(kDspProcFailFtRC,p, "The audio file reader open failed.");
     goto errLabel;
@@ -1633,7 +1636,16 @@ cmFtRC_t        cmFtAnalyzeFile( cmFtH_t h, cmFtParam_t* pp)
 
 
   // initialize the feature extractors and allocate feature vector memory
-  if((rc = _cmFtProcInit(p, &f, pp, anlArray)) != kOkFtRC )
+  // (FFT plan creation is not re-entrant so batch workers take turns here)
+  if( cmThreadMutexIsValid(p->initMtxH) )
+    cmThreadMutexLock(p->initMtxH);
+
+  rc = _cmFtProcInit(p, &f, pp, anlArray);
+
+  if( cmThreadMutexIsValid(p->initMtxH) )
+    cmThreadMutexUnlock(p->initMtxH);
+
+  if( rc != kOkFtRC )
     goto errLabel;
 
   // create the output frame file
@@ -1813,10 +1825,15 @@ cmFtRC_t        cmFtAnalyze( cmFtH_t h )
   return rc;
 }
 
+const char* _cmFtBatchProgress( struct _cmFtBatch_str* b, unsigned* passPtr, cmReal_t* percentPtr );
+
 const char* cmFtAnalyzeProgress( cmFtH_t h, unsigned* passPtr, cmReal_t* percentPtr )
 {
   _cmFt_t* p = _cmFtHandleToPtr(h);
 
+  if( p->batch != NULL )
+    return _cmFtBatchProgress(p->batch,passPtr,percentPtr);
+
 
   if( percentPtr != NULL )
     *percentPtr = 0;
@@ -1836,6 +1853,399 @@ const char* cmFtAnalyzeProgress( cmFtH_t h, unsigned* passPtr, cmReal_t* percent
   return p->paramArray[ p->progParamIdx ].audioFn;
 }
 
+//------------------------------------------------------------------------------------------------------------
+// Batch analysis
+
+enum
+{
+  kAnlPassFtCnt = 5  // count of passes cmFtAnalyzeFile() makes over each file (analysis + 4 post-processing)
+};
+
+// Per-worker queue of paramArray[] indexes. The owner takes jobs from
+// the front and idle workers steal from the back.
+typedef struct
+{
+  cmThreadMutexH_t mtxH;
+  unsigned*        idxArray;  // paramArray[] indexes dealt to this worker
+  unsigned         begIdx;    // next job taken by the owner
+  unsigned         endIdx;    // one past the next job to be stolen
+} _cmFtDeque_t;
+
+typedef struct
+{
+  struct _cmFtBatch_str* b;
+  unsigned               idx;          // index of this worker in b->workerArray[]
+  cmFtH_t                h;            // private analyzer (processors and header serializer)
+  cmThreadH_t            thH;          // worker thread (worker 0 runs on the calling thread)
+  _cmFtDeque_t           dq;           //
+  cmFtAttr_t*            attrArray;    // attrArray[attrAllocCnt] private copy of the current file's attributes
+  unsigned               attrAllocCnt; //
+  volatile unsigned      paramIdx;     // file currently being analyzed or cmInvalidIdx if idle
+} _cmFtWorker_t;
+
+typedef struct _cmFtBatch_str
+{
+  _cmFt_t*          p;             // analyzer which owns this batch
+  cmFtParam_t*      paramArray;    // paramArray[paramCnt] files to analyze
+  unsigned          paramCnt;      //
+  _cmFtWorker_t*    workerArray;   // workerArray[workerCnt]
+  unsigned          workerCnt;     //
+  cmThreadMutexH_t  initMtxH;      // serializes the worker's processor (FFT plan) initialization
+  unsigned          doneCnt;       // count of completed files
+  cmFtRC_t*         rcArray;       // rcArray[paramCnt] result of each file (written only by the worker which analyzed the file)
+  volatile unsigned lastParamIdx;  // most recently started file
+} _cmFtBatch_t;
+
+typedef struct
+{
+  unsigned paramIdx;
+  unsigned byteCnt;
+} _cmFtBatchJob_t;
+
+// Sort jobs on decreasing file size.
+int _cmFtBatchJobCompare( const void* p0, const void* p1 )
+{
+  unsigned n0 = ((const _cmFtBatchJob_t*)p0)->byteCnt;
+  unsigned n1 = ((const _cmFtBatchJob_t*)p1)->byteCnt;
+  return n0 < n1 ? 1 : (n0 > n1 ? -1 : 0);
+}
+
+bool _cmFtDequeTake( _cmFtDeque_t* dq, bool stealFl, unsigned* paramIdxRef )
+{
+  bool retFl = false;
+
+  if( cmThreadMutexLock(dq->mtxH) != kOkThRC )
+    return false;
+
+  if( dq->begIdx < dq->endIdx )
+  {
+    *paramIdxRef = stealFl ? dq->idxArray[ --dq->endIdx ] : dq->idxArray[ dq->begIdx++ ];
+    retFl        = true;
+  }
+
+  cmThreadMutexUnlock(dq->mtxH);
+
+  return retFl;
+}
+
+// Take the next job from this worker's queue or steal one from another worker.
+// Jobs are never added after the batch starts so once this function
+// returns false there is no work left for this worker.
+bool _cmFtWorkerNextJob( _cmFtWorker_t* w, unsigned* paramIdxRef )
+{
+  _cmFtBatch_t* b = w->b;
+  unsigned      i;
+
+  if( _cmFtDequeTake(&w->dq,false,paramIdxRef) )
+    return true;
+
+  for(i=1; i<b->workerCnt; ++i)
+    if( _cmFtDequeTake( &b->workerArray[ (w->idx + i) % b->workerCnt ].dq, true, paramIdxRef ) )
+      return true;
+
+  return false;
+}
+
+void _cmFtWorkerExec( _cmFtWorker_t* w, unsigned paramIdx )
+{
+  _cmFtBatch_t* b  = w->b;
+  _cmFt_t*      wp = _cmFtHandleToPtr(w->h);
+  cmFtParam_t   param = b->paramArray[ paramIdx ];
+
+  // _cmFtProcInit() fills in default feature vector lengths based on the
+  // audio file so each file must be given a private copy of the attribute array
+  if( param.attrCnt > w->attrAllocCnt )
+  {
+    w->attrArray    = cmMemResizeZ( cmFtAttr_t, w->attrArray, param.attrCnt );
+    w->attrAllocCnt = param.attrCnt;
+  }
+
+  if( param.attrCnt )
+    memcpy(w->attrArray, param.attrArray, param.attrCnt * sizeof(cmFtAttr_t));
+
+  param.attrArray  = w->attrArray;
+
+  wp->progParamIdx = paramIdx;
+  wp->progPassIdx  = 0;
+  wp->progSmpIdx   = 0;
+  wp->progSmpCnt   = 0;
+  w->paramIdx      = paramIdx;
+  b->lastParamIdx  = paramIdx;
+
+  // b->p->err is not thread safe - the result is reported by the calling thread
+  // after the batch is complete (see cmFtAnalyzeBatch())
+  b->rcArray[ paramIdx ] = cmFtAnalyzeFile(w->h,&param);
+
+  w->paramIdx = cmInvalidIdx;
+  cmThUIntIncr(&b->doneCnt,1);
+}
+
+bool _cmFtWorkerThreadFunc( void* arg )
+{
+  _cmFtWorker_t* w = (_cmFtWorker_t*)arg;
+  unsigned       paramIdx;
+
+  if( _cmFtWorkerNextJob(w,&paramIdx) == false )
+    return false; // exit the thread
+
+  _cmFtWorkerExec(w,paramIdx);
+  return true;
+}
+
+const char* _cmFtBatchProgress( _cmFtBatch_t* b, unsigned* passPtr, cmReal_t* percentPtr )
+{
+  unsigned i;
+  cmReal_t sum = b->doneCnt;
+
+  // add the fractional completion of the files in progress
+  for(i=0; i<b->workerCnt; ++i)
+    if( b->workerArray[i].paramIdx != cmInvalidIdx )
+    {
+      const _cmFt_t* wp = _cmFtHandleToPtr(b->workerArray[i].h);
+      cmReal_t       fr = wp->progSmpCnt > 0 ? (cmReal_t)wp->progSmpIdx / wp->progSmpCnt : 0;
+      sum += (cmMin(wp->progPassIdx,kAnlPassFtCnt-1) + cmMin(fr,1.0)) / kAnlPassFtCnt;
+    }
+
+  if( percentPtr != NULL )
+    *percentPtr = b->paramCnt == 0 ? 0 : 100.0 * sum / b->paramCnt;
+
+  if( passPtr != NULL )
+    *passPtr = b->doneCnt;
+
+  return b->lastParamIdx == cmInvalidIdx ? NULL : b->paramArray[ b->lastParamIdx ].audioFn;
+}
+
+cmFtRC_t _cmFtBatchFree( _cmFtBatch_t* b )
+{
+  cmFtRC_t rc = kOkFtRC;
+  unsigned i;
+
+  for(i=0; i<b->workerCnt; ++i)
+  {
+    _cmFtWorker_t* w = b->workerArray + i;
+
+    if( cmThreadDestroy(&w->thH) != kOkThRC )
+      rc = _cmFtError(kThreadFailFtRC, b->p, "Batch worker %i thread destroy failed.",i);
+
+    if( cmFtFinalize(&w->h) != kOkFtRC )
+      rc = _cmFtError(kDspProcFailFtRC, b->p, "Batch worker %i analyzer release failed.",i);
+
+    cmThreadMutexDestroy(&w->dq.mtxH);
+    cmMemPtrFree(&w->dq.idxArray);
+    cmMemPtrFree(&w->attrArray);
+  }
+
+  cmThreadMutexDestroy(&b->initMtxH);
+  cmMemPtrFree(&b->workerArray);
+  cmMemPtrFree(&b->rcArray);
+  return rc;
+}
+
+cmFtRC_t _cmFtBatchAlloc( _cmFt_t* p, _cmFtBatch_t* b, cmFtParam_t* paramArray, unsigned paramCnt, unsigned threadCnt )
+{
+  cmFtRC_t         rc      = kOkFtRC;
+  _cmFtBatchJob_t* jobArray = cmMemAllocZ( _cmFtBatchJob_t, paramCnt );
+  unsigned         i;
+
+  b->p            = p;
+  b->paramArray   = paramArray;
+  b->paramCnt     = paramCnt;
+  b->workerCnt    = threadCnt;
+  b->workerArray  = cmMemAllocZ( _cmFtWorker_t, threadCnt );
+  b->rcArray      = cmMemAllocZ( cmFtRC_t, paramCnt );
+  b->lastParamIdx = cmInvalidIdx;
+
+  if( cmThreadMutexCreate(&b->initMtxH,&p->ctx.rpt) != kOkThRC )
+  {
+    rc = _cmFtError(kThreadFailFtRC, p, "Batch init. mutex create failed.");
+    goto errLabel;
+  }
+
+  // deal the files largest first so that the work left to be stolen
+  // from the back of the worker queues is the smallest
+  for(i=0; i<paramCnt; ++i)
+  {
+    jobArray[i].paramIdx = i;
+
+    if( cmFileByteCountFn( paramArray[i].audioFn, NULL, &jobArray[i].byteCnt ) != kOkFileRC )
+      jobArray[i].byteCnt = 0;  // the error will be reported when the file is analyzed
+  }
+
+  qsort(jobArray, paramCnt, sizeof(jobArray[0]), _cmFtBatchJobCompare );
+
+  for(i=0; i<threadCnt; ++i)
+  {
+    _cmFtWorker_t* w = b->workerArray + i;
+
+    w->b           = b;
+    w->idx         = i;
+    w->paramIdx    = cmInvalidIdx;
+    w->dq.idxArray = cmMemAllocZ( unsigned, paramCnt/threadCnt + 1 );
+
+    if( cmThreadMutexCreate(&w->dq.mtxH,&p->ctx.rpt) != kOkThRC )
+    {
+      rc = _cmFtError(kThreadFailFtRC, p, "Batch worker %i queue mutex create failed.",i);
+      goto errLabel;
+    }
+
+    // each worker owns a complete set of analysis processors
+    if((rc = cmFtInitialize(&w->h, &p->ctx)) != kOkFtRC )
+    {
+      rc = _cmFtError(rc, p, "Batch worker %i analyzer allocation failed.",i);
+      goto errLabel;
+    }
+
+    _cmFtHandleToPtr(w->h)->initMtxH = b->initMtxH;
+
+    // worker 0 runs on the calling thread
+    if( i > 0 && cmThreadCreate(&w->thH, _cmFtWorkerThreadFunc, w, &p->ctx.rpt) != kOkThRC )
+    {
+      rc = _cmFtError(kThreadFailFtRC, p, "Batch worker %i thread create failed.",i);
+      goto errLabel;
+    }
+  }
+
+  for(i=0; i<paramCnt; ++i)
+  {
+    _cmFtDeque_t* dq = &b->workerArray[ i % threadCnt ].dq;
+    dq->idxArray[ dq->endIdx++ ] = jobArray[i].paramIdx;
+  }
+
+ errLabel:
+  cmMemFree(jobArray);
+  return rc;
+}
+
+cmFtRC_t cmFtAnalyzeBatch( cmFtH_t h, cmFtParam_t* paramArray, unsigned paramCnt, unsigned threadCnt )
+{
+  cmFtRC_t     rc = kOkFtRC;
+  _cmFt_t*     p  = _cmFtHandleToPtr(h);
+  _cmFtBatch_t b;
+  unsigned     i,paramIdx;
+  unsigned     failCnt = 0;
+
+  memset(&b,0,sizeof(b));
+
+  if( paramArray == NULL )
+  {
+    paramArray = p->paramArray;
+    paramCnt   = p->paramCnt;
+  }
+
+  if( paramCnt == 0 )
+    return rc;
+
+  if( threadCnt == 0 )
+  {
+    long n    = sysconf(_SC_NPROCESSORS_ONLN);
+    threadCnt = n < 1 ? 1 : n;
+  }
+
+  threadCnt = cmMin(threadCnt,paramCnt);
+
+  if((rc = _cmFtBatchAlloc(p,&b,paramArray,paramCnt,threadCnt)) != kOkFtRC )
+    goto errLabel;
+
+  p->batch = &b;
+
+  // a worker which fails to start is released and its jobs are stolen by the others
+  for(i=1; i<b.workerCnt; ++i)
+  {
+    cmThreadSetPauseTimeOutMicros(b.workerArray[i].thH,1000);
+    if( cmThreadPause(b.workerArray[i].thH,0) != kOkThRC )
+    {
+      rc = _cmFtError(kThreadFailFtRC, p, "Batch worker %i thread start failed.",i);
+      cmThreadDestroy(&b.workerArray[i].thH);
+    }
+  }
+
+  // the calling thread is worker 0
+  while( _cmFtWorkerNextJob(b.workerArray,&paramIdx) )
+    _cmFtWorkerExec(b.workerArray,paramIdx);
+
+  // wait for the other workers to run out of jobs
+  for(i=1; i<b.workerCnt; ++i)
+    while( cmThreadIsValid(b.workerArray[i].thH) && cmThreadState(b.workerArray[i].thH) != kExitedThId )
+      cmSleepUs(1000);
+
+  // report the failed files in paramArray[] order
+  for(i=0; i<paramCnt; ++i)
+    if( b.rcArray[i] != kOkFtRC )
+    {
+      _cmFtError(b.rcArray[i], p, "Batch analysis failed on '%s'.", cmStringNullGuard(paramArray[i].audioFn));
+      
+      if( failCnt++ == 0 )
+        rc = b.rcArray[i]; // return the first error
+    }
+
+  if( failCnt > 0 )
+    rc = _cmFtError(rc, p, "%i of %i batch files could not be analyzed.", failCnt, paramCnt);
+
+ errLabel:
+  p->batch = NULL;
+
+  if( b.workerArray != NULL )
+  {
+    cmFtRC_t rc0 = _cmFtBatchFree(&b);
+    if( rc == kOkFtRC )
+      rc = rc0;
+  }
+
+  return rc;
+}
+
+cmFtRC_t cmFtAnalyzeBatchTest( cmCtx_t* ctx, const cmChar_t* cfgFn, unsigned maxThreadCnt )
+{
+  cmFtRC_t rc = kOkFtRC;
+  cmFtH_t  h  = cmFtNullHandle;
+  _cmFt_t* p  = NULL;
+  cmReal_t fps1 = 0;
+  unsigned threadCnt;
+
+  if( maxThreadCnt == 0 )
+  {
+    long n       = sysconf(_SC_NPROCESSORS_ONLN);
+    maxThreadCnt = n < 1 ? 1 : n;
+  }
+
+  if((rc = cmFtInitialize(&h,ctx)) != kOkFtRC )
+    return rc;
+
+  if((rc = cmFtParse(h,cfgFn)) != kOkFtRC )
+    goto errLabel;
+
+  p = _cmFtHandleToPtr(h);
+
+  for(threadCnt=1; ; threadCnt*=2)
+  {
+    cmTimeSpec_t t0,t1;
+
+    threadCnt = cmMin(threadCnt,maxThreadCnt);
+
+    cmTimeGetMonotonic(&t0);
+
+    if((rc = cmFtAnalyzeBatch(h,NULL,0,threadCnt)) != kOkFtRC )
+      goto errLabel;
+
+    cmTimeGetMonotonic(&t1);
+
+    cmReal_t secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    cmReal_t fps  = secs > 0 ? p->paramCnt / secs : 0;
+
+    if( threadCnt == 1 )
+      fps1 = fps;
+
+    _cmFtPrint(p,"threads:%3i files:%5i secs:%9.3f files/sec:%9.3f speedup:%6.2f\n",threadCnt,p->paramCnt,secs,fps,fps1>0 ? fps/fps1 : 0);
+
+    if( threadCnt == maxThreadCnt )
+      break;
+  }
+
+ errLabel:
+  cmFtFinalize(&h);
+  return rc;
+}
+
 cmFtRC_t _cmFtReaderClose( _cmFtFile_t* fp )
 {
   cmFtRC_t rc = kOkFtRC;
@@ -1912,7 +2322,7 @@ unsigned cmFtPlviewSrcFunc( void* userPtr, unsigned srcId, unsigned binIdx, unsi
 */
 
 
-cmFtRC_t cmFtReaderOpen(cmFtH_t h, cmFtFileH_t* hp, const char* featFn, const cmFtInfo_t** infoPtrPtr )
+cmFtRC_t _cmFtReaderOpen(cmFtH_t h, cmFtFileH_t* hp, const char* featFn, bool mapFl, const cmFtInfo_t** infoPtrPtr )
 {
   cmFfRC_t           ffRC         = kOkFfRC;
   const cmFfFile_t*  fileDescPtr  = NULL;
@@ -1934,7 +2344,12 @@ cmFtRC_t cmFtReaderOpen(cmFtH_t h, cmFtFileH_t* hp, const char* featFn, const cm
 
 
   // open the frame file
-  if( cmFrameFileOpen(&fp->ffH, featFn, &p->ctx, &fileDescPtr ) != kOkFfRC )
+  if( mapFl )
+    ffRC = cmFrameFileOpenMapped(&fp->ffH, featFn, &p->ctx, &fileDescPtr );
+  else
+    ffRC = cmFrameFileOpen(&fp->ffH, featFn, &p->ctx, &fileDescPtr );
+
+  if( ffRC != kOkFfRC )
   {
     rc = _cmFtError( kFrameFileFailFtRC, p, "Frame file open failed.");
     goto errLabel;
@@ -2014,6 +2429,12 @@ cmFtRC_t cmFtReaderOpen(cmFtH_t h, cmFtFileH_t* hp, const char* featFn, const cm
   return rc;
 }
 
+cmFtRC_t cmFtReaderOpen(cmFtH_t h, cmFtFileH_t* hp, const char* featFn, const cmFtInfo_t** infoPtrPtr )
+{ return _cmFtReaderOpen(h,hp,featFn,false,infoPtrPtr); }
+
+cmFtRC_t cmFtReaderOpenMapped(cmFtH_t h, cmFtFileH_t* hp, const char* featFn, const cmFtInfo_t** infoPtrPtr )
+{ return _cmFtReaderOpen(h,hp,featFn,true,infoPtrPtr); }
+
 cmFtRC_t        cmFtReaderClose(   cmFtFileH_t* hp )
 {
   cmFtRC_t rc = kOkFtRC;
@@ -34,7 +34,8 @@ extern "C" {
     kSerialFailFtRC,
     kInvalidFeatIdFtRC,
     kFileFailFtRC,
-    kInvalidFrmIdxFtRC
+    kInvalidFrmIdxFtRC,
+    kThreadFailFtRC
   };
 
   // Feature Id's
@@ -192,6 +193,23 @@ extern "C" {
   // can be used to access the analyzers progress.
   const char*     cmFtAnalyzeProgress( cmFtH_t h, unsigned* passPtr, cmReal_t* percentPtr );  
 
+  // Analyze the files in paramArray[paramCnt] on a pool of 'threadCnt' threads.
+  // If paramArray is NULL then the files from the last call to cmFtParse() are used.
+  // Set threadCnt to 0 to use one thread per online processor. The calling thread
+  // is one of the workers and the function returns when all files are complete.
+  // Each worker owns a private set of analysis processors and writes its
+  // feature files independently. Files are dealt, largest first, to per-worker
+  // queues and idle workers steal from the back of the other workers' queues.
+  // A failed file does not stop the batch; the result code of the first failure is returned.
+  // While a batch is running cmFtAnalyzeProgress() reports on the whole batch:
+  // *passPtr is set to the count of completed files, *percentPtr to the overall
+  // completion and the most recently started audio file name is returned.
+  cmFtRC_t        cmFtAnalyzeBatch( cmFtH_t h, cmFtParam_t* paramArray, unsigned paramCnt, unsigned threadCnt );
+
+  // Analyze the files listed in the analyzer cfg. file 'cfgFn' with 1,2,4,... 'maxThreadCnt'
+  // batch threads and report the throughput in files per second.
+  cmFtRC_t        cmFtAnalyzeBatchTest( cmCtx_t* ctx, const cmChar_t* cfgFn, unsigned maxThreadCnt );
+
   
   // Feature File Related Functions
 
@@ -199,6 +217,11 @@ extern "C" {
   // Note that inforPtrPtr is optional and will be ignored if it is set to NULL.
   cmFtRC_t        cmFtReaderOpen(    cmFtH_t h, cmFtFileH_t* hp, const char* featFn, const cmFtInfo_t** infoPtrPtr );
 
+  // Open a feature file via cmFrameFileOpenMapped(). Feature vectors returned
+  // from cmFtReaderAdvance() point directly into the file mapping where possible
+  // rather than into a copy of the frame.
+  cmFtRC_t        cmFtReaderOpenMapped( cmFtH_t h, cmFtFileH_t* hp, const char* featFn, const cmFtInfo_t** infoPtrPtr );
+
   // Close a feature file.
   cmFtRC_t        cmFtReaderClose(   cmFtFileH_t* hp );
 
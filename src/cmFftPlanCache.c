@@ -0,0 +1,488 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+#include "cmPrefix.h"
+#include "cmGlobal.h"
+#include "cmRpt.h"
+#include "cmErr.h"
+#include "cmCtx.h"
+#include "cmMem.h"
+#include "cmMallocDebug.h"
+#include "cmFileSys.h"
+#include "cmFloatTypes.h"
+#include "cmComplexTypes.h"
+#include "cmFftPlanCache.h"
+#include "cmTime.h"
+#include <pthread.h>
+
+typedef struct cmFpcPlan_str
+{
+  void*                 plan;     // fftwf_plan or fftw_plan
+  unsigned              n;        // transform length
+  unsigned              cnt;      // count of transforms in a split-format many-plan or 0 for a single interleaved plan
+  bool                  dblFl;    // precision
+  bool                  invFl;    // true=complex-to-real false=real-to-complex
+  bool                  alignFl;  // true if the plan requires SIMD aligned buffers
+  unsigned              refCnt;   // count of cmFft/cmIFft objects using this plan
+  struct cmFpcPlan_str* link;
+} cmFpcPlan_t;
+
+typedef struct
+{
+  cmErr_t          err;
+  pthread_mutex_t  mutex;       // FFTW planner functions are not thread-safe
+  unsigned         flags;       // see kXXXFpcFl
+  cmChar_t*        wisdomFnV[2];// [0]=float [1]=double wisdom file name or NULL
+  bool             dirtyFl;     // true if a non-estimated plan was created since the wisdom was imported
+  cmFpcPlan_t*     list;
+  unsigned         hitCnt;      // count of requests which were satisfied by an existing plan
+  unsigned         wisdomCnt;   // count of plans created from wisdom alone (see kWisdomOnlyFpcFl)
+} cmFpc_t;
+
+static cmFpc_t _cmFpc = { .mutex = PTHREAD_MUTEX_INITIALIZER, .flags = kEstimateFpcFl };
+
+static void _cmFpcLock()
+{ pthread_mutex_lock(&_cmFpc.mutex); }
+
+static void _cmFpcUnlock()
+{ pthread_mutex_unlock(&_cmFpc.mutex); }
+
+static void _cmFpcDestroyPlan( cmFpcPlan_t* pp )
+{
+  if( pp->dblFl )
+    fftw_destroy_plan((fftw_plan)pp->plan);
+  else
+    fftwf_destroy_plan((fftwf_plan)pp->plan);
+}
+
+// Create a plan on scratch buffers. The scratch buffers are always SIMD aligned
+// therefore FFTW_UNALIGNED is required when the client buffers are not.
+// If 'cnt' is non-zero a split-format plan which executes 'cnt' contiguous
+// transforms is created.
+// Called with the mutex locked.
+static void* _cmFpcCreatePlan( bool dblFl, unsigned n, unsigned cnt, bool invFl, bool alignFl, unsigned rigor )
+{
+  unsigned flags = rigor | (alignFl ? 0 : FFTW_UNALIGNED);
+  unsigned binN  = n/2 + 1;
+  unsigned frmN  = cnt==0 ? 1 : cnt;
+  void*    plan  = NULL;
+
+  // transform dimension and frame layout (r2c: real input distance=n complex output distance=binN)
+  fftw_iodim dim   = { .n=n,    .is=1, .os=1 };
+  fftw_iodim frm   = { .n=frmN, .is=invFl ? binN : n, .os=invFl ? n : binN };
+
+  if( dblFl )
+  {
+    double*       rV = fftw_malloc(sizeof(double)*n*frmN);
+    fftw_complex* cV = fftw_malloc(sizeof(fftw_complex)*binN*frmN);
+    double*       iV = (double*)cV + binN*frmN;
+
+    if( rV != NULL && cV != NULL )
+    {
+      if( cnt == 0 )
+        plan = invFl ? fftw_plan_dft_c2r_1d(n,cV,rV,flags) : fftw_plan_dft_r2c_1d(n,rV,cV,flags);
+      else
+        plan = invFl ? fftw_plan_guru_split_dft_c2r(1,&dim,1,&frm,(double*)cV,iV,rV,flags) : fftw_plan_guru_split_dft_r2c(1,&dim,1,&frm,rV,(double*)cV,iV,flags);
+    }
+
+    fftw_free(rV);
+    fftw_free(cV);
+  }
+  else
+  {
+    float*         rV = fftwf_malloc(sizeof(float)*n*frmN);
+    fftwf_complex* cV = fftwf_malloc(sizeof(fftwf_complex)*binN*frmN);
+    float*         iV = (float*)cV + binN*frmN;
+
+    if( rV != NULL && cV != NULL )
+    {
+      if( cnt == 0 )
+        plan = invFl ? fftwf_plan_dft_c2r_1d(n,cV,rV,flags) : fftwf_plan_dft_r2c_1d(n,rV,cV,flags);
+      else
+        plan = invFl ? fftwf_plan_guru_split_dft_c2r(1,&dim,1,&frm,(float*)cV,iV,rV,flags) : fftwf_plan_guru_split_dft_r2c(1,&dim,1,&frm,rV,(float*)cV,iV,flags);
+    }
+
+    fftwf_free(rV);
+    fftwf_free(cV);
+  }
+
+  return plan;
+}
+
+static void* _cmFpcAlloc( bool dblFl, unsigned n, unsigned cnt, bool invFl, bool alignFl )
+{
+  cmFpcPlan_t* pp;
+  void*        plan  = NULL;
+  unsigned     rigor = FFTW_ESTIMATE;
+
+  _cmFpcLock();
+
+  for(pp=_cmFpc.list; pp!=NULL; pp=pp->link)
+    if( pp->n==n && pp->cnt==cnt && pp->dblFl==dblFl && pp->invFl==invFl && pp->alignFl==alignFl )
+    {
+      ++pp->refCnt;
+      ++_cmFpc.hitCnt;
+      plan = pp->plan;
+      goto errLabel;
+    }
+
+  if( cmIsFlag(_cmFpc.flags,kPatientFpcFl) )
+    rigor = FFTW_PATIENT;
+  else
+    if( cmIsFlag(_cmFpc.flags,kMeasureFpcFl) )
+      rigor = FFTW_MEASURE;
+
+  // if only wisdom based plans may be measured then try the wisdom first ...
+  if( rigor != FFTW_ESTIMATE && cmIsFlag(_cmFpc.flags,kWisdomOnlyFpcFl) )
+  {
+    if((plan = _cmFpcCreatePlan(dblFl,n,cnt,invFl,alignFl,rigor | FFTW_WISDOM_ONLY)) == NULL )
+      rigor = FFTW_ESTIMATE; // ... and fall back to an estimated plan
+    else
+      ++_cmFpc.wisdomCnt;
+  }
+
+  if( plan == NULL )
+  {
+    if((plan = _cmFpcCreatePlan(dblFl,n,cnt,invFl,alignFl,rigor)) == NULL )
+    {
+      cmErrMsg(&_cmFpc.err,kPlanFailFpcRC,"FFTW %s plan creation failed for %i %s transform(s) of length %i.", dblFl ? "double" : "float", cnt==0 ? 1 : cnt, invFl ? "c2r" : "r2c", n);
+      goto errLabel;
+    }
+
+    if( rigor != FFTW_ESTIMATE )
+      _cmFpc.dirtyFl = true;
+  }
+
+  pp          = cmMemAllocZ(cmFpcPlan_t,1);
+  pp->plan    = plan;
+  pp->n       = n;
+  pp->cnt     = cnt;
+  pp->dblFl   = dblFl;
+  pp->invFl   = invFl;
+  pp->alignFl = alignFl;
+  pp->refCnt  = 1;
+  pp->link    = _cmFpc.list;
+  _cmFpc.list = pp;
+
+ errLabel:
+  _cmFpcUnlock();
+  return plan;
+}
+
+static void _cmFpcRelease( void* plan )
+{
+  cmFpcPlan_t* pp;
+
+  if( plan == NULL )
+    return;
+
+  _cmFpcLock();
+
+  for(pp=_cmFpc.list; pp!=NULL; pp=pp->link)
+    if( pp->plan == plan )
+    {
+      assert( pp->refCnt > 0 );
+      --pp->refCnt;
+      break;
+    }
+
+  _cmFpcUnlock();
+}
+
+// Called with the mutex locked.
+static cmFpcRC_t _cmFpcImportWisdom( bool dblFl, const cmChar_t* fn )
+{
+  int rc = dblFl ? fftw_import_wisdom_from_filename(fn) : fftwf_import_wisdom_from_filename(fn);
+
+  if( rc == 0 )
+    return cmErrWarnMsg(&_cmFpc.err,kWisdomImportFailFpcRC,"FFTW wisdom import failed from '%s'.",cmStringNullGuard(fn));
+
+  return kOkFpcRC;
+}
+
+// Called with the mutex locked.
+static cmFpcRC_t _cmFpcExportWisdom( bool dblFl, const cmChar_t* fn )
+{
+  int rc = dblFl ? fftw_export_wisdom_to_filename(fn) : fftwf_export_wisdom_to_filename(fn);
+
+  if( rc == 0 )
+    return cmErrMsg(&_cmFpc.err,kWisdomExportFailFpcRC,"FFTW wisdom export failed to '%s'.",cmStringNullGuard(fn));
+
+  return kOkFpcRC;
+}
+
+cmFpcRC_t  cmFpcInitialize( cmCtx_t* ctx, cmFileSysH_t fsH, unsigned flags )
+{
+  cmFpcRC_t rc;
+  unsigned  i;
+
+  if((rc = cmFpcFinalize()) != kOkFpcRC && rc != kPlansInUseFpcRC )
+    return rc;
+
+  cmErrSetup(&_cmFpc.err,&ctx->rpt,"FFT Plan Cache");
+
+  _cmFpcLock();
+
+  _cmFpc.flags   = flags;
+  _cmFpc.dirtyFl = false;
+
+  if( cmFileSysIsValid(fsH) && cmFileSysPrefsDir(fsH) != NULL )
+  {
+    const cmChar_t* labelV[] = { "fftwf", "fftw" };
+
+    for(i=0; i<2; ++i)
+    {
+      const cmChar_t* fn;
+      if((fn = cmFileSysMakeFn(fsH,cmFileSysPrefsDir(fsH),labelV[i],"wisdom",NULL)) != NULL )
+      {
+        _cmFpc.wisdomFnV[i] = cmMemAllocStr(fn);
+
+        // a missing wisdom file is not an error - it will be created by cmFpcFinalize()
+        if( cmFileSysIsFile(fsH,fn) )
+          _cmFpcImportWisdom(i==1,fn);
+
+        cmFileSysFreeFn(fsH,fn);
+      }
+    }
+  }
+
+  _cmFpcUnlock();
+
+  return kOkFpcRC;
+}
+
+cmFpcRC_t  cmFpcFinalize()
+{
+  cmFpcRC_t     rc  = kOkFpcRC;
+  cmFpcPlan_t*  pp  = NULL;
+  cmFpcPlan_t*  pp0 = NULL;
+  unsigned      i;
+
+  _cmFpcLock();
+
+  for(i=0; i<2; ++i)
+    if( _cmFpc.wisdomFnV[i] != NULL )
+    {
+      if( _cmFpc.dirtyFl )
+        _cmFpcExportWisdom(i==1,_cmFpc.wisdomFnV[i]);
+
+      cmMemPtrFree(&_cmFpc.wisdomFnV[i]);
+    }
+
+  // destroy the unreferenced plans
+  for(pp=_cmFpc.list; pp!=NULL; )
+  {
+    cmFpcPlan_t* np = pp->link;
+
+    if( pp->refCnt > 0 )
+    {
+      rc  = cmErrWarnMsg(&_cmFpc.err,kPlansInUseFpcRC,"A %s %s plan of length %i is still in use.",pp->dblFl ? "double" : "float", pp->invFl ? "c2r" : "r2c", pp->n);
+      pp0 = pp;
+    }
+    else
+    {
+      if( pp0 == NULL )
+        _cmFpc.list = np;
+      else
+        pp0->link = np;
+
+      _cmFpcDestroyPlan(pp);
+      cmMemFree(pp);
+    }
+
+    pp = np;
+  }
+
+  _cmFpc.dirtyFl   = false;
+  _cmFpc.hitCnt    = 0;
+  _cmFpc.wisdomCnt = 0;
+
+  _cmFpcUnlock();
+
+  return rc;
+}
+
+cmFpcRC_t  cmFpcImportWisdom( bool dblFl, const cmChar_t* fn )
+{
+  cmFpcRC_t rc;
+  _cmFpcLock();
+  rc = _cmFpcImportWisdom(dblFl,fn);
+  _cmFpcUnlock();
+  return rc;
+}
+
+cmFpcRC_t  cmFpcExportWisdom( bool dblFl, const cmChar_t* fn )
+{
+  cmFpcRC_t rc;
+  _cmFpcLock();
+  rc = _cmFpcExportWisdom(dblFl,fn);
+  _cmFpcUnlock();
+  return rc;
+}
+
+fftwf_plan cmFpcAllocF( unsigned n, bool invFl, float*  rV, fftwf_complex* cV )
+{
+  bool alignFl = fftwf_alignment_of(rV)==0 && fftwf_alignment_of((float*)cV)==0;
+  return (fftwf_plan)_cmFpcAlloc(false,n,0,invFl,alignFl);
+}
+
+fftw_plan  cmFpcAllocD( unsigned n, bool invFl, double* rV, fftw_complex*  cV )
+{
+  bool alignFl = fftw_alignment_of(rV)==0 && fftw_alignment_of((double*)cV)==0;
+  return (fftw_plan)_cmFpcAlloc(true,n,0,invFl,alignFl);
+}
+
+fftwf_plan cmFpcAllocSplitF( unsigned n, unsigned cnt, bool invFl, float*  rV, float*  reV, float*  imV )
+{
+  bool alignFl = fftwf_alignment_of(rV)==0 && fftwf_alignment_of(reV)==0 && fftwf_alignment_of(imV)==0;
+  return cnt==0 ? NULL : (fftwf_plan)_cmFpcAlloc(false,n,cnt,invFl,alignFl);
+}
+
+fftw_plan  cmFpcAllocSplitD( unsigned n, unsigned cnt, bool invFl, double* rV, double* reV, double* imV )
+{
+  bool alignFl = fftw_alignment_of(rV)==0 && fftw_alignment_of(reV)==0 && fftw_alignment_of(imV)==0;
+  return cnt==0 ? NULL : (fftw_plan)_cmFpcAlloc(true,n,cnt,invFl,alignFl);
+}
+
+void       cmFpcReleaseF( fftwf_plan plan )
+{ _cmFpcRelease(plan); }
+
+void       cmFpcReleaseD( fftw_plan  plan )
+{ _cmFpcRelease(plan); }
+
+void       cmFpcReport( cmRpt_t* rpt )
+{
+  cmFpcPlan_t* pp;
+
+  _cmFpcLock();
+
+  cmRptPrintf(rpt,"hits:%i wisdom:%i dirty:%i\n",_cmFpc.hitCnt,_cmFpc.wisdomCnt,_cmFpc.dirtyFl);
+
+  for(pp=_cmFpc.list; pp!=NULL; pp=pp->link)
+    cmRptPrintf(rpt,"%6i x%-4i %s %s %s refs:%i\n",pp->n,pp->cnt==0 ? 1 : pp->cnt,pp->dblFl ? "dbl" : "flt", pp->invFl ? "c2r" : "r2c", pp->alignFl ? "aligned  " : "unaligned", pp->refCnt);
+
+  _cmFpcUnlock();
+}
+
+// Remove the wisdom files created by cmFpcTest().
+static void _cmFpcTestRemoveWisdom( cmFileSysH_t fsH )
+{
+  const cmChar_t* labelV[] = { "fftwf", "fftw" };
+  unsigned        i;
+
+  for(i=0; i<2; ++i)
+  {
+    const cmChar_t* fn;
+    if((fn = cmFileSysMakeFn(fsH,cmFileSysPrefsDir(fsH),labelV[i],"wisdom",NULL)) != NULL )
+    {
+      if( cmFileSysIsFile(fsH,fn) )
+        remove(fn);
+      cmFileSysFreeFn(fsH,fn);
+    }
+  }
+}
+
+// Create a measured plan, save the wisdom, reload it and verify that the
+// plan is then created from the wisdom and is shared by later requests.
+cmFpcRC_t  cmFpcTest( cmCtx_t* ctx )
+{
+  enum { kN = 1024 };
+  cmFpcRC_t      rc     = kOkFpcRC;
+  cmFileSysH_t   fsH    = cmFileSysNullHandle;
+  float*         rV     = fftwf_malloc(sizeof(float)*kN);
+  fftwf_complex* cV     = fftwf_malloc(sizeof(fftwf_complex)*(kN/2+1));
+  cmErr_t        err;
+  const cmChar_t* fn    = NULL;
+  fftwf_plan     p0,p1;
+  cmTimeSpec_t   t0,t1;
+  unsigned       usV[2];
+
+  cmErrSetup(&err,&ctx->rpt,"FFT Plan Cache Test");
+
+  if( cmFileSysInitialize(&fsH,ctx,"cmFpcTest") != kOkFsRC )
+  {
+    rc = cmErrMsg(&err,kWisdomImportFailFpcRC,"The file system initialization failed.");
+    goto errLabel;
+  }
+
+  if( !cmFileSysIsDir(fsH,cmFileSysPrefsDir(fsH)) && cmFileSysMkDir(fsH,cmFileSysPrefsDir(fsH)) != kOkFsRC )
+  {
+    rc = cmErrMsg(&err,kWisdomExportFailFpcRC,"The wisdom directory '%s' could not be created.",cmStringNullGuard(cmFileSysPrefsDir(fsH)));
+    goto errLabel;
+  }
+
+  _cmFpcTestRemoveWisdom(fsH);
+
+  // create a measured plan - there is no wisdom yet
+  cmFpcInitialize(ctx,fsH,kMeasureFpcFl);
+
+  cmTimeGet(&t0);
+  p0 = cmFpcAllocF(kN,false,rV,cV);
+  cmTimeGet(&t1);
+  usV[0] = cmTimeElapsedMicros(&t0,&t1);
+  
+  p1 = cmFpcAllocF(kN,false,rV,cV);
+
+  if( p0 == NULL || p1 != p0 || _cmFpc.hitCnt != 1 )
+  {
+    rc = cmErrMsg(&err,kPlanFailFpcRC,"The second request for the same plan was not served from the cache.");
+    goto errLabel;
+  }
+
+  cmFpcReleaseF(p0);
+  cmFpcReleaseF(p1);
+
+  // export the wisdom
+  if((rc = cmFpcFinalize()) != kOkFpcRC )
+    goto errLabel;
+
+  if((fn = cmFileSysMakeFn(fsH,cmFileSysPrefsDir(fsH),"fftwf","wisdom",NULL)) == NULL || !cmFileSysIsFile(fsH,fn) )
+  {
+    rc = cmErrMsg(&err,kWisdomExportFailFpcRC,"The wisdom file '%s' was not written.",cmStringNullGuard(fn));
+    goto errLabel;
+  }
+
+  // reload the wisdom and require that measured plans come from the wisdom
+  cmFpcInitialize(ctx,fsH,kMeasureFpcFl | kWisdomOnlyFpcFl);
+
+  cmTimeGet(&t0);
+  p0 = cmFpcAllocF(kN,false,rV,cV);
+  cmTimeGet(&t1);
+  usV[1] = cmTimeElapsedMicros(&t0,&t1);
+
+  p1 = cmFpcAllocF(kN,false,rV,cV);
+
+  if( p0 == NULL || _cmFpc.wisdomCnt != 1 || _cmFpc.dirtyFl )
+  {
+    rc = cmErrMsg(&err,kWisdomImportFailFpcRC,"The plan was not created from the reloaded wisdom.");
+    goto errLabel;
+  }
+
+  if( p1 != p0 || _cmFpc.hitCnt != 1 )
+  {
+    rc = cmErrMsg(&err,kPlanFailFpcRC,"The plan created from the wisdom was not served from the cache.");
+    goto errLabel;
+  }
+
+  cmFpcReport(&ctx->rpt);
+  cmRptPrintf(&ctx->rpt,"plan time measured:%i us from wisdom:%i us\n",usV[0],usV[1]);
+
+  cmFpcReleaseF(p0);
+  cmFpcReleaseF(p1);
+
+ errLabel:
+  cmFpcFinalize();
+
+  if( fn != NULL )
+    cmFileSysFreeFn(fsH,fn);
+
+  if( cmFileSysIsValid(fsH) )
+  {
+    _cmFpcTestRemoveWisdom(fsH);
+    cmFileSysFinalize(&fsH);
+  }
+
+  fftwf_free(rV);
+  fftwf_free(cV);
+
+  return rc;
+}
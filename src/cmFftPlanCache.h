@@ -0,0 +1,118 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+#ifndef cmFftPlanCache_h
+#define cmFftPlanCache_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  //( { file_desc:"Process wide cache of shared FFTW plans with wisdom persistence." kw:[base math] }
+  //
+  // Real-to-complex and complex-to-real FFTW plans are cached by size, transform count,
+  // direction, precision and buffer alignment and are shared, via reference counting, by all
+  // cmFft and cmIFft objects. The plans are created on internal scratch buffers
+  // and must therefore be executed with the FFTW new-array execute functions
+  // (cmFftExecuteR2CX() and cmIFftExecuteC2RX()).
+  //
+  // cmFpcInitialize() sets the planning rigor and, given a valid file system handle,
+  // imports the FFTW wisdom previously stored in the application preferences directory.
+  // cmFpcFinalize() writes the accumulated wisdom back to the same files. Once
+  // the wisdom files exist measured plans are created with no planning delay.
+  //
+  // If cmFpcInitialize() is never called the cache creates FFTW_ESTIMATE plans
+  // and no wisdom is stored.
+  //
+  // All functions are thread-safe however creating a plan with the kMeasureFpcFl or
+  // kPatientFpcFl rigor may take a long time and should not be done from a
+  // real-time thread unless kWisdomOnlyFpcFl is also set.
+
+  enum
+  {
+    kOkFpcRC = cmOkRC,
+    kPlanFailFpcRC,
+    kWisdomImportFailFpcRC,
+    kWisdomExportFailFpcRC,
+    kPlansInUseFpcRC
+  };
+
+  typedef cmRC_t cmFpcRC_t;
+
+  // cmFpcInitialize() flags
+  enum
+  {
+    kEstimateFpcFl   = 0x00,  // plan with FFTW_ESTIMATE
+    kMeasureFpcFl    = 0x01,  // plan with FFTW_MEASURE
+    kPatientFpcFl    = 0x02,  // plan with FFTW_PATIENT
+    kWisdomOnlyFpcFl = 0x04,  // use the measured/patient rigor only when wisdom exists for the plan otherwise use FFTW_ESTIMATE
+  };
+
+  // Set the planning rigor and import the wisdom files (fftwf.wisdom, fftw.wisdom)
+  // from the preferences directory of 'fsH'. If 'fsH' is not valid then the wisdom
+  // is not imported or exported.
+  cmFpcRC_t  cmFpcInitialize( cmCtx_t* ctx, cmFileSysH_t fsH, unsigned flags );
+
+  // Export the wisdom files (if any plans were created since cmFpcInitialize())
+  // and destroy all unreferenced plans.  Returns kPlansInUseFpcRC if plans are
+  // still referenced by cmFft/cmIFft objects. These plans are not destroyed.
+  cmFpcRC_t  cmFpcFinalize();
+
+  // Import or export single (dblFl=false) or double (dblFl=true) precision wisdom.
+  cmFpcRC_t  cmFpcImportWisdom( bool dblFl, const cmChar_t* fn );
+  cmFpcRC_t  cmFpcExportWisdom( bool dblFl, const cmChar_t* fn );
+
+  // Return a shared plan for a real-to-complex (invFl=false) or complex-to-real (invFl=true)
+  // transform of length 'n'. 'rV' and 'cV' are the buffers which will later be passed to
+  // the execute function. They are only used to determine the plan alignment and are not
+  // written to. Returns NULL if the plan could not be created.
+  // Release the plan with cmFpcReleaseX().
+  fftwf_plan cmFpcAllocF( unsigned n, bool invFl, float*  rV, fftwf_complex* cV );
+  fftw_plan  cmFpcAllocD( unsigned n, bool invFl, double* rV, fftw_complex*  cV );
+
+  // Return a shared split-format plan which executes 'cnt' transforms of length 'n' in one call.
+  // The real frames are stored contiguously in rV[n*cnt] and the real and imaginary parts
+  // of the bin frames are stored contiguously in reV[binN*cnt] and imV[binN*cnt]
+  // where binN=n/2+1. Execute the plan with cmFftExecuteSplitR2CX() or cmIFftExecuteSplitC2RX().
+  // Note that a complex-to-real transform overwrites reV[] and imV[].
+  // Release the plan with cmFpcReleaseX().
+  fftwf_plan cmFpcAllocSplitF( unsigned n, unsigned cnt, bool invFl, float*  rV, float*  reV, float*  imV );
+  fftw_plan  cmFpcAllocSplitD( unsigned n, unsigned cnt, bool invFl, double* rV, double* reV, double* imV );
+
+  void       cmFpcReleaseF( fftwf_plan plan );
+  void       cmFpcReleaseD( fftw_plan  plan );
+
+  // Print the contents of the cache.
+  void       cmFpcReport( cmRpt_t* rpt );
+
+  // Save measured wisdom to the 'cmFpcTest' preferences directory, reload it and
+  // verify that the plan is created from the wisdom and served from the cache.
+  // Note: this test finalizes the process wide cache.
+  cmFpcRC_t  cmFpcTest( cmCtx_t* ctx );
+
+#if CM_FLOAT_SMP == 1
+#define cmFpcAllocS      cmFpcAllocF
+#define cmFpcAllocSplitS cmFpcAllocSplitF
+#define cmFpcReleaseS    cmFpcReleaseF
+#else
+#define cmFpcAllocS      cmFpcAllocD
+#define cmFpcAllocSplitS cmFpcAllocSplitD
+#define cmFpcReleaseS    cmFpcReleaseD
+#endif
+
+#if CM_FLOAT_REAL == 1
+#define cmFpcAllocR      cmFpcAllocF
+#define cmFpcAllocSplitR cmFpcAllocSplitF
+#define cmFpcReleaseR    cmFpcReleaseF
+#else
+#define cmFpcAllocR      cmFpcAllocD
+#define cmFpcAllocSplitR cmFpcAllocSplitD
+#define cmFpcReleaseR    cmFpcReleaseD
+#endif
+
+  //)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
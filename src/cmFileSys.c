@@ -748,7 +748,8 @@ cmFileSysPathPart_t* cmFileSysPathParts( cmFileSysH_t h, const cmChar_t* pathStr
     // Get the trailing word again.
     // pathStr must be copied into a buf because basename() may
     // is allowed to change the values in its arg.
-    strncpy(buf,pathStr,n);
+    // ('n' now holds the size of the returned record - use the buffer size.)
+    strncpy(buf,pathStr,sizeof(buf)-1);
     cp = basename(buf);
 
     
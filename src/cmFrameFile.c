@@ -13,6 +13,10 @@
 #include "cmLinkedHeap.h"
 #include "cmMath.h"
 #include "cmVectOps.h"
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
 /*
 
@@ -58,6 +62,11 @@ enum
   kSecondsTimeFl   = 0x02
 }; 
 
+enum
+{
+  kMapPrefetchFfByteCnt = 1024*1024  // mapped mode: read-ahead window size
+};
+
 
 typedef struct _cmFfOffs_str
 {
@@ -68,9 +77,11 @@ typedef struct _cmFfOffs_str
 
 typedef struct 
 {
-  _cmFfOffs_t* beg;
-  _cmFfOffs_t* end;
-  unsigned     cnt;
+  _cmFfOffs_t*  beg;
+  _cmFfOffs_t*  end;
+  unsigned      cnt;
+  _cmFfOffs_t** idxArray;  // idxArray[idxCnt] random access index into beg:end (see _cmFfOffsListIndex())
+  unsigned      idxCnt;
 } _cmFfOffsList_t;
 
 typedef struct _cmFfToC_str
@@ -121,6 +132,10 @@ typedef struct
   _cmFfToC_t*        frmToC;         // one ToC recd for each stream
   void*              writeMtxMem;
   bool               swapFl; 
+  char*              mapPtr;         // mapped mode: base of the file mapping otherwise NULL
+  off_t              mapByteCnt;     // mapped mode: file length
+  off_t              mapOffs;        // mapped mode: current read position (replaces the position of 'fp')
+  off_t              mapAdvOffs;     // mapped mode: end of the last region passed to madvise(MADV_WILLNEED)
 } cmFf_t;
 
 typedef struct 
@@ -356,6 +371,19 @@ cmFfRC_t _cmFfWriteDouble( cmFf_t* p, double v )
 
 cmFfRC_t _cmFfRead( cmFf_t* p, void* vp, unsigned bn )
 {
+  if( p->mapPtr != NULL )
+  {
+    if( p->mapOffs + bn > p->mapByteCnt )
+    {
+      p->mapOffs = p->mapByteCnt;
+      return kEofFfRC;
+    }
+
+    memcpy(vp,p->mapPtr + p->mapOffs, bn );
+    p->mapOffs += bn;
+    return kOkFfRC;
+  }
+
   if(fread(vp,bn,1,p->fp) != 1 )
   {
     if( feof(p->fp) )
@@ -406,6 +434,12 @@ cmFfRC_t _cmFfReadDouble( cmFf_t* p, double* vp )
 
 cmFfRC_t _cmFfTell( cmFf_t* p, off_t* offsPtr )
 {
+  if( p->mapPtr != NULL )
+  {
+    *offsPtr = p->mapOffs;
+    return kOkFfRC;
+  }
+
   if((*offsPtr = ftello( p->fp )) == -1 )
     return _cmFfError( p, kFileTellFailFfRC, errno, "File tell failed.");
 
@@ -417,6 +451,23 @@ cmFfRC_t _cmFfSeek( cmFf_t* p, int whence, off_t offset )
   //if( p->writeFl )
   //  return _cmFfError( p, kInvalidFileModeFfRC, 0, "Cannot seek on file opened for writing.");
 
+  if( p->mapPtr != NULL )
+  {
+    off_t offs = offset;
+
+    switch( whence )
+    {
+      case SEEK_CUR: offs += p->mapOffs;    break;
+      case SEEK_END: offs += p->mapByteCnt; break;
+    }
+
+    if( offs < 0 )
+      return _cmFfError( p, kFileSeekFailFfRC, EINVAL, "File seek failed.");
+
+    p->mapOffs = offs;
+    return kOkFfRC;
+  }
+
   if(fseeko(p->fp, offset, whence) != 0 )
     return _cmFfError( p, kFileSeekFailFfRC, errno, "File seek failed.");
 
@@ -427,7 +478,7 @@ cmFfRC_t _cmFfSeek( cmFf_t* p, int whence, off_t offset )
 //-------------------------------------------------------------------------------------------
 
 // append a _cmFfOffs_t record to a _cmFfOffsList
-void _cmFfAppendOffsList( cmFf_t* p, _cmFfOffsList_t* lp, unsigned frmIdx, unsigned offs )
+void _cmFfAppendOffsList( cmFf_t* p, _cmFfOffsList_t* lp, unsigned frmIdx, off_t offs )
 {
   _cmFfOffs_t*  op = (_cmFfOffs_t*)cmLHeapAllocZ( p->lhH, sizeof(_cmFfOffs_t) );
 
@@ -452,6 +503,31 @@ void _cmFfAppendOffsList( cmFf_t* p, _cmFfOffsList_t* lp, unsigned frmIdx, unsig
   ++lp->cnt;
 }
 
+// Return the 'idx'th record of an offset list or NULL if idx is out of range.
+// An index over the list is built on first use so that seeking does not rescan the list.
+_cmFfOffs_t* _cmFfOffsListIndex( cmFf_t* p, _cmFfOffsList_t* lp, unsigned idx )
+{
+  if( idx >= lp->cnt )
+    return NULL;
+
+  // (re)build the index if records were appended since it was last built
+  if( lp->idxCnt != lp->cnt )
+  {
+    _cmFfOffs_t* op = lp->beg;
+    unsigned     i;
+
+    lp->idxArray = (_cmFfOffs_t**)cmLHeapAllocZ( p->lhH, lp->cnt * sizeof(_cmFfOffs_t*) );
+
+    for(i=0; op != NULL; op=op->linkPtr,++i)
+      lp->idxArray[i] = op;
+
+    assert( i == lp->cnt );
+    lp->idxCnt = lp->cnt;
+  }
+
+  return lp->idxArray[idx];
+}
+
 // locate a ToC record in a ToC list
 _cmFfToC_t* _cmFfFindToCPtr( cmFf_t* p, _cmFfToC_t* cp, unsigned streamId, unsigned mtxType, unsigned mtxUnitsId, unsigned mtxFmtId )
 {
@@ -742,6 +818,13 @@ cmFfRC_t _cmFrameFileFree( cmFf_t* p )
       p->fp = NULL;
   }
 
+  if( p->mapPtr != NULL )
+  {
+    if( munmap(p->mapPtr,p->mapByteCnt) != 0 )
+      rc = _cmFfError(p,kFileCloseFailFfRC,errno,"File unmap failed.");
+    p->mapPtr = NULL;
+  }
+
   cmMemPtrFree(&p->writeMtxMem);
 
   // release the filename string
@@ -827,7 +910,61 @@ cmFfRC_t cmFrameFileCreate( cmFrameFileH_t* hPtr, const char* fn, double srate,
 
 }
 
-cmFfRC_t cmFrameFileOpen(   cmFrameFileH_t* hPtr, const char* fn, cmCtx_t* ctx, const cmFfFile_t** fileDescPtrPtr )
+// Map the entire file 'fn' into memory copy-on-write.
+cmFfRC_t _cmFfMapFile( cmFf_t* p, const char* fn )
+{
+  cmFfRC_t    rc = kOkFfRC;
+  struct stat st;
+  int         fd;
+
+  if((fd = open(fn,O_RDONLY)) == -1 )
+    return _cmFfError( p,kFileOpenFailFfRC,errno,"Unable to open the file:'%s'.",fn);
+
+  if( fstat(fd,&st) != 0 )
+  {
+    rc = _cmFfError( p,kFileOpenFailFfRC,errno,"Unable to read the size of the file:'%s'.",fn);
+    goto errLabel;
+  }
+
+  if( st.st_size == 0 )
+  {
+    rc = _cmFfError( p,kNotFrameFileFfRC,0,"'%s' is not a frame file.",fn);
+    goto errLabel;
+  }
+
+  if((p->mapPtr = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 )) == MAP_FAILED )
+  {
+    p->mapPtr = NULL;
+    rc = _cmFfError( p,kMemMapFailFfRC,errno,"Unable to map the file:'%s'.",fn);
+    goto errLabel;
+  }
+
+  p->mapByteCnt = st.st_size;
+  p->mapOffs    = 0;
+  p->mapAdvOffs = 0;
+
+  // the advice is only a hint - failure is not an error
+  madvise(p->mapPtr, p->mapByteCnt, MADV_SEQUENTIAL );
+
+ errLabel:
+  close(fd);
+  return rc;
+}
+
+// Ask the kernel to begin reading the mapped file region offs:offs+byteCnt.
+void _cmFfMapPrefetch( cmFf_t* p, off_t offs, off_t byteCnt )
+{
+  long  pageByteCnt = sysconf(_SC_PAGESIZE);
+  off_t bi          = offs - (offs % pageByteCnt);
+  off_t ei          = cmMin(offs + byteCnt, p->mapByteCnt);
+
+  if( ei > bi )
+    madvise(p->mapPtr + bi, ei - bi, MADV_WILLNEED );
+
+  p->mapAdvOffs = ei;
+}
+
+cmFfRC_t _cmFrameFileOpen(   cmFrameFileH_t* hPtr, const char* fn, cmCtx_t* ctx, bool mapFl, const cmFfFile_t** fileDescPtrPtr )
 {
   cmFfRC_t rc = kOkFfRC;
   cmFf_t*  p;
@@ -856,10 +993,18 @@ cmFfRC_t cmFrameFileOpen(   cmFrameFileH_t* hPtr, const char* fn, cmCtx_t* ctx,
   }
 
   // open the file for reading
-  if((p->fp = fopen(fn,"r+b")) == NULL )
+  if( mapFl )
   {
-    rc = _cmFfError( p,kFileOpenFailFfRC,errno,"Unable to open the file:'%s'.",fn);
-    goto errLabel;
+    if((rc = _cmFfMapFile(p,fn)) != kOkFfRC )
+      goto errLabel;
+  }
+  else
+  {
+    if((p->fp = fopen(fn,"r+b")) == NULL )
+    {
+      rc = _cmFfError( p,kFileOpenFailFfRC,errno,"Unable to open the file:'%s'.",fn);
+      goto errLabel;
+    }
   }
 
   p->writeFl = false;
@@ -928,6 +1073,12 @@ cmFfRC_t cmFrameFileOpen(   cmFrameFileH_t* hPtr, const char* fn, cmCtx_t* ctx,
 
 }
 
+cmFfRC_t cmFrameFileOpen(   cmFrameFileH_t* hPtr, const char* fn, cmCtx_t* ctx, const cmFfFile_t** fileDescPtrPtr )
+{ return _cmFrameFileOpen(hPtr,fn,ctx,false,fileDescPtrPtr); }
+
+cmFfRC_t cmFrameFileOpenMapped( cmFrameFileH_t* hPtr, const char* fn, cmCtx_t* ctx, const cmFfFile_t** fileDescPtrPtr )
+{ return _cmFrameFileOpen(hPtr,fn,ctx,true,fileDescPtrPtr); }
+
 
 cmFfRC_t cmFrameFileClose( cmFrameFileH_t* hp )
 {
@@ -979,6 +1130,12 @@ cmFfRC_t cmFrameFileClose( cmFrameFileH_t* hp )
 bool     cmFrameFileIsValid( cmFrameFileH_t h )
 {  return h.h != NULL; }
 
+bool     cmFrameFileIsMapped( cmFrameFileH_t h )
+{
+  cmFf_t* p = _cmFfHandleToPtr(h);
+  return p->mapPtr != NULL;
+}
+
 const cmFfFile_t* cmFrameFileDesc( cmFrameFileH_t h )
 {
   cmFf_t* p = _cmFfHandleToPtr(h);
@@ -1270,7 +1427,6 @@ cmFfRC_t cmFrameFileSeek( cmFrameFileH_t h, unsigned streamId, unsigned frameIdx
 {
   cmFfRC_t    rc = kOkFfRC;
   cmFf_t*     p  = _cmFfHandleToPtr(h);
-  unsigned    i  = 0;
   _cmFfToC_t* tocPtr;
 
 
@@ -1283,10 +1439,7 @@ cmFfRC_t cmFrameFileSeek( cmFrameFileH_t h, unsigned streamId, unsigned frameIdx
   }
 
   // locate the TOC offset recd assoc'd with frameIdx
-  _cmFfOffs_t* cp = tocPtr->offsList.beg;
-  for(; cp != NULL && i!=frameIdx; ++i )
-    cp = cp->linkPtr;
-
+  _cmFfOffs_t* cp = _cmFfOffsListIndex(p, &tocPtr->offsList, frameIdx );
 
   // if the frame index was not valid
   if( cp == NULL )
@@ -1299,6 +1452,13 @@ cmFfRC_t cmFrameFileSeek( cmFrameFileH_t h, unsigned streamId, unsigned frameIdx
   if((rc = _cmFfSeek(p,SEEK_SET,cp->offs)) != kOkFfRC )
     goto errLabel;
 
+  // keep the loaded frame index in sync with the file position
+  p->nxtFrmIdx = cp->frmIdx;
+
+  // begin reading the target region before the frame is loaded
+  if( p->mapPtr != NULL && (cp->offs < p->mapAdvOffs - kMapPrefetchFfByteCnt || cp->offs >= p->mapAdvOffs) )
+    _cmFfMapPrefetch(p, cp->offs, kMapPrefetchFfByteCnt );
+
  errLabel:
   return rc;
 }
@@ -1411,11 +1571,57 @@ cmFfRC_t _cmFfReadMtx( cmFf_t* p, _cmFfMtx_t* mp, void* buf,  unsigned bufByteCn
   return rc;
 }
 
+// Mapped mode: read a matrix header and point mp->dataPtr to the matrix data in the mapping.
+// Data which is not aligned to its word size is copied to the frame buffer at *bufIdxPtr.
+cmFfRC_t _cmFfMapMtx( cmFf_t* p, _cmFfMtx_t* mp, unsigned* bufIdxPtr )
+{
+  cmFfRC_t rc;
+  unsigned wordByteCnt;
+  unsigned padByteCnt;
+  char*    sp;
+
+  // read the matrix header
+  if((rc = _cmFfReadMtx(p, mp, NULL, 0 )) != kOkFfRC )
+    return rc;
+
+  padByteCnt = mp->byteCnt % 8;
+
+  if( p->mapOffs + mp->byteCnt + padByteCnt > p->mapByteCnt )
+    return _cmFfError(p,kFileReadFailFfRC,0,"The matrix data extends past the end of the file.");
+
+  sp          = p->mapPtr + p->mapOffs;
+  wordByteCnt = _cmFfIdToFmtPtr(mp->m.fmtId)->wordByteCnt;
+
+  if( ((uintptr_t)sp) % wordByteCnt == 0 )
+    mp->dataPtr = sp;
+  else
+  {
+    if( *bufIdxPtr + mp->byteCnt > p->frame.byteCnt )
+      return _cmFfError(p,kBufTooSmallFfRC,0, "Matrix buffer too small to complete the read.");
+
+    // the frame buffer is only allocated when a frame contains unaligned data
+    if( *bufIdxPtr == 0 )
+      p->frame.dataPtr = cmMemResize( char, p->frame.dataPtr, p->frame.byteCnt );
+
+    mp->dataPtr = p->frame.dataPtr + *bufIdxPtr;
+    memcpy(mp->dataPtr, sp, mp->byteCnt );
+
+    // keep the next copy 8 byte aligned
+    *bufIdxPtr += mp->byteCnt + ((8 - (mp->byteCnt % 8)) % 8);
+  }
+
+  p->mapOffs += mp->byteCnt + padByteCnt;
+
+  return rc;
+}
+
 cmFfRC_t           cmFrameFileFrameLoad(     cmFrameFileH_t h, const cmFfFrame_t** frameDescPtrPtr )
 {
   cmFfRC_t rc;
   cmFf_t*  p = _cmFfHandleToPtr(h);
   unsigned i;
+  bool     mapFl  = p->mapPtr != NULL && p->swapFl == false;
+  unsigned bufIdx = 0;
 
   if(frameDescPtrPtr != NULL)
     *frameDescPtrPtr = NULL;
@@ -1426,7 +1632,9 @@ cmFfRC_t           cmFrameFileFrameLoad(     cmFrameFileH_t h, const cmFfFrame_t
 
   // create a block of memory large enough to hold the entire frame
   // (this is more than is actually needed because it includes the mtx header records)
-  p->frame.dataPtr  = cmMemResizeZ( char, p->frame.dataPtr, p->frame.byteCnt );
+  // (mapped files point directly into the mapping and only use this buffer for unaligned data)
+  if( mapFl == false )
+    p->frame.dataPtr  = cmMemResizeZ( char, p->frame.dataPtr, p->frame.byteCnt );
 
   // create a mtx array to hold each mtx record
   p->frame.mtxArray = cmMemResizeZ( _cmFfMtx_t, p->frame.mtxArray, p->frame.f.mtxCnt );
@@ -1439,6 +1647,13 @@ cmFfRC_t           cmFrameFileFrameLoad(     cmFrameFileH_t h, const cmFfFrame_t
   {
     _cmFfMtx_t* mp = p->frame.mtxArray + i;
 
+    if( mapFl )
+    {
+      if((rc = _cmFfMapMtx(p, mp, &bufIdx )) != kOkFfRC )
+        goto errLabel;
+      continue;
+    }
+
     mp->dataPtr = dp;
 
     // read the matrix header and data
@@ -1477,6 +1692,10 @@ cmFfRC_t           cmFrameFileFrameLoad(     cmFrameFileH_t h, const cmFfFrame_t
   p->curFrmIdx = p->nxtFrmIdx;
   ++p->nxtFrmIdx;
 
+  // keep the read-ahead window at least half a window ahead of the read position
+  if( p->mapPtr != NULL && p->mapOffs + kMapPrefetchFfByteCnt/2 > p->mapAdvOffs )
+    _cmFfMapPrefetch(p, cmMax(p->mapOffs,p->mapAdvOffs), kMapPrefetchFfByteCnt );
+
 
  errLabel:
   return rc;
@@ -1514,6 +1733,9 @@ cmFfRC_t           cmFrameFileFrameUpdate( cmFrameFileH_t h )
   unsigned i    = 0;
   off_t    offs; 
 
+  if( p->mapPtr != NULL )
+    return _cmFfError( p, kInvalidFileModeFfRC, 0, "Frames cannot be updated on memory mapped frame files.");
+
   if((rc = _cmFfTell(p,&offs)) != kOkFfRC )
     goto errLabel;
 
@@ -1797,29 +2019,26 @@ cmFfRC_t _cmFrameFileMtxLoad(   cmFrameFileH_t h, unsigned streamId, unsigned mt
     goto errLabel;
   }
   
-  _cmFfOffs_t* op = tocPtr->offsList.beg;
+  _cmFfOffs_t* op = _cmFfOffsListIndex(p, &tocPtr->offsList, frmIdx );
 
-  for(fi=0; op != NULL && (frmCnt==-1 || fi<(frmIdx+frmCnt)); ++fi )
+  for(fi=frmIdx; op != NULL && (frmCnt==-1 || fi<(frmIdx+frmCnt)); ++fi )
   {
-    if( frmIdx<=fi )
-    {
-      if((rc = _cmFfSeek(p,SEEK_SET, op->offs )) != kOkFfRC )
-        goto errLabel;
-
-      if((rc = _cmFfReadMtx(p,&mtx,dp,dpn)) != kOkFfRC )
-        goto errLabel;
+    if((rc = _cmFfSeek(p,SEEK_SET, op->offs )) != kOkFfRC )
+      goto errLabel;
 
-      int readByteCnt =  mtx.m.rowCnt * mtx.m.colCnt * wordByteCnt;
+    if((rc = _cmFfReadMtx(p,&mtx,dp,dpn)) != kOkFfRC )
+      goto errLabel;
 
-      if( readByteCnt > dpn )
-      {
-        rc = _cmFfError( p, kBufTooSmallFfRC, 0, "The matrix load buffer is too small.");
-        goto errLabel;
-      }
+    int readByteCnt =  mtx.m.rowCnt * mtx.m.colCnt * wordByteCnt;
 
-      dpn -= readByteCnt;
-      dp  += readByteCnt;
+    if( readByteCnt > dpn )
+    {
+      rc = _cmFfError( p, kBufTooSmallFfRC, 0, "The matrix load buffer is too small.");
+      goto errLabel;
     }
+
+    dpn -= readByteCnt;
+    dp  += readByteCnt;
     
     op = op->linkPtr;
   }
@@ -2199,6 +2418,37 @@ cmFfRC_t cmFrameFileTest( const char* fn, cmCtx_t* ctx )
     }
   }
 
+  //
+  // repeat the seek test on a memory mapped file
+  //
+  
+  if((rc = cmFrameFileClose(&h)) != kOkFfRC )
+    goto errLabel;
+
+  printf("mapped seek test\n");
+
+  if((rc = cmFrameFileOpenMapped( &h, fn, ctx, &fileDescPtr )) != kOkFfRC )
+    goto errLabel;
+
+  if((rc = cmFrameFileSeek( h, streamId, fi )) != kOkFfRC )
+    goto errLabel;
+
+  if((rc = cmFrameFileFrameLoadNext(h,kInvalidFrameTId,kInvalidStreamId,&frmDescPtr)) != kOkFfRC )
+    goto errLabel;
+
+  if((rc = _cmFrameFileTestMtx( h, mtxType, unitsId, frmDescPtr->mtxCnt, fi, false )) != kOkFfRC )
+    goto errLabel;
+
+  if(1)
+  {
+    unsigned actualEleCnt;
+    unsigned eleCnt = frmCnt*rowCnt*colCnt;
+    long buf[ eleCnt ];
+    if((rc = cmFrameFileMtxLoadLong(h, streamId, mtxType, unitsId, 0, -1, buf, eleCnt, &actualEleCnt )) == kOkFfRC )
+    {
+      cmVOI_Print(&ctx->rpt,rowCnt,frmCnt,(int*)buf);
+    }
+  }
 
  errLabel:
   if( rc != kOkFfRC )
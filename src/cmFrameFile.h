@@ -49,7 +49,8 @@ extern "C" {
     kLHeapFailFfRC,       // 17
     kTocFrameRdFailFfRC,  // 18
     kTocRecdNotFoundFfRC, // 19
-    kBufTooSmallFfRC      // 20
+    kBufTooSmallFfRC,     // 20
+    kMemMapFailFfRC       // 21
   };
 
   // row data formats
@@ -163,6 +164,20 @@ extern "C" {
   // The fileDescPtrPtr is optional. Set to NULL to ignore.
   cmFfRC_t           cmFrameFileOpen(    cmFrameFileH_t* hPtr, const char* fn, cmCtx_t* ctx, const cmFfFile_t** fileDescPtrPtr );
   cmFfRC_t           cmFrameFileClose(   cmFrameFileH_t* hPtr );
+
+  // Open a frame file for reading via a memory map of the entire file.
+  // Matrix data pointers returned from the frame after cmFrameFileFrameLoad()
+  // point directly into a private (copy-on-write) mapping of the file
+  // unless the file byte order differs from the host or the matrix data is
+  // not aligned to its word size - in which case the data is copied to
+  // the frame buffer as with cmFrameFileOpen().  Changes made to the 
+  // returned data are never written back to the file and
+  // cmFrameFileFrameUpdate() fails with kInvalidFileModeFfRC.
+  // Sequential reads advise the kernel to read ahead of the current frame
+  // and cmFrameFileSeek() prefetches the region around the target frame.
+  cmFfRC_t           cmFrameFileOpenMapped( cmFrameFileH_t* hPtr, const char* fn, cmCtx_t* ctx, const cmFfFile_t** fileDescPtrPtr );
+  bool               cmFrameFileIsMapped(   cmFrameFileH_t h );
+
   bool               cmFrameFileIsValid( cmFrameFileH_t h );
   const cmFfFile_t*  cmFrameFileDesc(    cmFrameFileH_t h );
 
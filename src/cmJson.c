@@ -12,19 +12,33 @@
 #include "cmLex.h"
 #include "cmLinkedHeap.h"
 #include "cmFile.h"
+#include "cmTime.h"
 
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 
+
+// Scanner token id's. The id's of the scalar tokens are equal
+// to the type id of the node they create.
 enum
 {
-  kLCurlyLexTId = kUserLexTId+1,
-  kRCurlyLexTId,
-  kLHardLexTId,
-  kRHardLexTId,
-  kColonLexTId,
-  kCommaLexTId,
-  kTrueLexTId,
-  kFalseLexTId,
-  kNullLexTId
+  kErrorJsTokId  = kInvalidTId,
+  kStringJsTokId = kStringTId,  // quoted string or identifier
+  kIntJsTokId    = kIntTId,     // decimal or hex integer
+  kRealJsTokId   = kRealTId,
+  kNullJsTokId   = kNullTId,
+  kTrueJsTokId   = kTrueTId,
+  kFalseJsTokId  = kFalseTId,
+  kEofJsTokId    = kMaskTId + 1,
+  kLCurlyJsTokId,
+  kRCurlyJsTokId,
+  kLHardJsTokId,
+  kRHardJsTokId,
+  kColonJsTokId,
+  kCommaJsTokId
 };
 
 
@@ -34,6 +48,23 @@ typedef struct
   const char* text;
 } cmJsToken_t;
 
+// Object/array child index (see _cmJsonBuildIndex()).
+typedef struct cmJsonIdx_str
+{
+  unsigned       n;         // count of children
+  cmJsonNode_t** eleV;      // eleV[n] children in list order
+  unsigned       hashMask;  // count of hashV[] elements - 1
+  cmJsonNode_t** hashV;     // member pair hash table (objects only) 
+} cmJsonIdx_t;
+
+// parser stack frame
+typedef struct
+{
+  cmJsonNode_t* np;       // object, array or pair node
+  cmJsonNode_t* lastPtr;  // last child of np
+  unsigned      cnt;      // count of children of np
+} cmJsFrame_t;
+
 // serialization buffer header
 typedef struct
 {
@@ -66,33 +97,24 @@ typedef struct
 typedef struct
 {
   cmErr_t            err;            // 
-  cmLexH             lexH;           // parsing lexer 
   cmLHeapH_t         heapH;          // linked heap stores all node memory 
   cmJsonNode_t*      rootPtr;        // root of internal node tree
-  cmJsonNode_t*      basePtr;        // base of parsing stack
-  cmJsonNode_t*      lastPtr;        // top of parsing stack
+  cmJsFrame_t*       stackV;         // parsing stack 
+  unsigned           stackAllocCnt;  // count of records allocated in stackV[]
+  const char*        scanBegPtr;     // base of the text being parsed
+  const char*        scanEndPtr;     // end of the text being parsed
+  const char*        scanPtr;        // next char to scan
+  const char*        tokPtr;         // text of the current token
+  unsigned           tokCharCnt;     // count of chars in the current token
   cmJsRC_t           rc;             // last error code
   char*              serialBufPtr;   // serial buffer pointer
   unsigned           serialByteCnt;  // count of bytes in serialBuf[]
   bool               reportErrPosnFl;// report the file posn of syntax errors
   bool               modifiedFl;     // the tree has been modified since it was created.
+  char*              mapPtr;         // memory mapped binary image (see cmJsonMapBinFile())
+  unsigned           mapByteCnt;     // count of bytes in mapPtr[]
 } cmJs_t;
 
-cmJsToken_t _cmJsTokenArray[] = 
-{
-  { kLCurlyLexTId, "{" },
-  { kRCurlyLexTId, "}" },
-  { kLHardLexTId,  "[" },
-  { kRHardLexTId,  "]" },
-  { kColonLexTId,  ":" },
-  { kCommaLexTId,  "," },
-  { kTrueLexTId,   "true"},
-  { kFalseLexTId,  "false"},
-  { kNullLexTId,   "null" },
-  { kErrorLexTId,""}
-  
-};
-
 cmJsToken_t _cmJsNodeTypeLabel[] = 
 {
   { kObjectTId, "object" },
@@ -161,7 +183,20 @@ cmJsRC_t _cmJsonSyntaxError( cmJs_t* p, const char* fmt, ... )
   va_start(vl,fmt);
 
   if( p->reportErrPosnFl )
-    snprintf(buf,bn,"Syntax error on line:%i column:%i. ",cmLexCurrentLineNumber(p->lexH),cmLexCurrentColumnNumber(p->lexH));
+  {
+    unsigned    lineNo = 1;
+    const char* lp     = p->scanBegPtr; // start of the current line
+    const char* cp     = p->scanBegPtr;
+
+    for(; cp < p->tokPtr; ++cp)
+      if( *cp == '\n' )
+      {
+        ++lineNo;
+        lp = cp + 1;
+      }
+    
+    snprintf(buf,bn,"Syntax error on line:%i column:%i. ",lineNo,(int)(p->tokPtr - lp) + 1);
+  }
 
   int n = strlen(buf);
   vsnprintf(buf+n,bn-n,fmt,vl);
@@ -170,51 +205,165 @@ cmJsRC_t _cmJsonSyntaxError( cmJs_t* p, const char* fmt, ... )
   return cmErrMsg(&p->err,kSyntaxErrJsRC,"%s",buf);
 }
 
+//-----------------------------------------------------------------------------
+// Child index
+//
+// Objects and arrays closed by the parser with kJsonIndexMinChildCnt
+// or more children are given a vector of child pointers. Objects are
+// also given an open addressed hash table of their member pairs.
+// The index is released as soon as the child list changes.
+
+const char* _cmJsonIdxLabel( const cmJsonNode_t* pairPtr )
+{
+  const char* label = pairPtr->u.childPtr->u.stringVal;
+  return label == NULL ? "" : label;
+}
+
+// FNV-1a
+unsigned _cmJsonHashLabel( const char* label )
+{
+  unsigned h = 2166136261u;
+  for(; *label; ++label)
+    h = (h ^ (unsigned char)*label) * 16777619u;
+  return h;
+}
 
-// Note that the stack is formed by a linked list 
-// which is chained together using the nodes parentPtr.
-// This works beacause the parentPtr for object,array,
-// and pair nodes (the only nodes on the stack) is not
-// needed as long as the node is on the stack. Once the
-// node is popped the parentPtr is then set from the
-// new stack top.
-cmJsRC_t _cmJsonPushNode( cmJs_t* p, cmJsonNode_t* np )
+// Return the count of hash table slots required by the index of a container with 'childCnt' children.
+unsigned _cmJsonIndexHashCount( const cmJsonNode_t* np, unsigned childCnt )
 {
-  np->ownerPtr = p->lastPtr;
-  p->lastPtr  = np;
+  unsigned hashCnt = 0;
 
-  if( p->basePtr == NULL )
-    p->basePtr = np;
+  // keep the hash table at least half empty
+  if( np->typeId == kObjectTId )
+    for(hashCnt=16; hashCnt < 2*childCnt; hashCnt*=2)
+    {}
 
-  return kOkJsRC;
+  return hashCnt;
 }
 
-cmJsRC_t _cmJsonPopNode( cmJs_t* p )
+// Fill the index record 'ip' which is followed in memory by space for 'childCnt'+'hashCnt' node pointers.
+void _cmJsonFillIndex( cmJsonIdx_t* ip, cmJsonNode_t* np, unsigned childCnt, unsigned hashCnt )
 {
-  if( p->lastPtr == NULL )
-    return _cmJsonSyntaxError(p,"A parser stack underlow signalled a syntax error.");
+  cmJsonNode_t* cnp;
+  unsigned      i;
 
-  cmJsonNode_t* t = p->lastPtr;
+  ip->n        = childCnt;
+  ip->eleV     = (cmJsonNode_t**)(ip+1);
+  ip->hashMask = hashCnt==0 ? 0 : hashCnt-1;
+  ip->hashV    = hashCnt==0 ? NULL : ip->eleV + childCnt;
 
-  // remove the top element
-  p->lastPtr = p->lastPtr->ownerPtr;
+  for(i=0,cnp=np->u.childPtr; cnp!=NULL; cnp=cnp->siblingPtr,++i)
+    ip->eleV[i] = cnp;
 
-  // set the parent of the popped node
-  t->ownerPtr = p->lastPtr;
+  assert( i == childCnt );
 
-  if( p->lastPtr == NULL )
-    p->basePtr = NULL;
+  if( ip->hashV != NULL )
+  {
+    memset(ip->hashV,0,hashCnt*sizeof(cmJsonNode_t*));
 
-  return kOkJsRC;
+    for(i=0; i<childCnt; ++i)
+    {
+      const char* label = _cmJsonIdxLabel(ip->eleV[i]);
+      unsigned    j     = _cmJsonHashLabel(label) & ip->hashMask;
+
+      // only the first of a set of pairs with the same label is entered
+      // so that the lookup result matches a linear search
+      for(; ip->hashV[j] != NULL; j = (j+1) & ip->hashMask)
+        if( strcmp(label,_cmJsonIdxLabel(ip->hashV[j])) == 0 )
+          break;
+
+      if( ip->hashV[j] == NULL )
+        ip->hashV[j] = ip->eleV[i];
+    }
+  }
+
+  np->idxPtr = ip;
+}
+
+void _cmJsonBuildIndex( cmJs_t* p, cmJsonNode_t* np, unsigned childCnt )
+{
+  cmJsonIdx_t* ip;
+  unsigned     hashCnt;
+
+  if( childCnt < kJsonIndexMinChildCnt )
+    return;
+
+  hashCnt = _cmJsonIndexHashCount(np,childCnt);
+
+  // the index is optional - an allocation failure is not an error
+  if((ip = cmLHeapAlloc(p->heapH,sizeof(cmJsonIdx_t) + (childCnt+hashCnt)*sizeof(cmJsonNode_t*))) == NULL )
+    return;
+
+  _cmJsonFillIndex(ip,np,childCnt,hashCnt);
+}
+
+// Return true if 'ptr' points into the memory mapped binary image.
+bool _cmJsonIsMapped( const cmJs_t* p, const void* ptr )
+{ return p->mapPtr != NULL && (const char*)ptr >= p->mapPtr && (const char*)ptr < p->mapPtr + p->mapByteCnt; }
+
+// Release node memory. Memory which is part of a mapped binary image is
+// released when the image is unmapped.
+void _cmJsonHeapFree( cmJs_t* p, void* ptr )
+{
+  if( !_cmJsonIsMapped(p,ptr) )
+    cmLHeapFree(p->heapH,ptr);
+}
+
+// Release the mapped binary image.
+void _cmJsonUnmap( cmJs_t* p )
+{
+  if( p->mapPtr != NULL )
+  {
+    munmap(p->mapPtr,p->mapByteCnt);
+    p->mapPtr     = NULL;
+    p->mapByteCnt = 0;
+  }
+}
+
+// Release the index of 'np'. This function must be called whenever the child
+// list of 'np' or the label of one of it's member pairs changes.
+void _cmJsonDropIndex( cmJs_t* p, cmJsonNode_t* np )
+{
+  if( np != NULL && np->idxPtr != NULL )
+  {
+    _cmJsonHeapFree(p,np->idxPtr);
+    np->idxPtr = NULL;
+  }
 }
 
+// Return the first member pair of the object 'np' labeled with 'label' or NULL if no such pair exists.
+const cmJsonNode_t* _cmJsonFindMemberPair( const cmJsonNode_t* np, const char* label )
+{
+  const cmJsonNode_t* cnp;
+  const cmJsonIdx_t*  ip = np->idxPtr;
+
+  if( ip != NULL && ip->hashV != NULL )
+  {
+    unsigned j = _cmJsonHashLabel(label) & ip->hashMask;
+    
+    for(; ip->hashV[j] != NULL; j = (j+1) & ip->hashMask)
+      if( strcmp(label,_cmJsonIdxLabel(ip->hashV[j])) == 0 )
+        return ip->hashV[j];
+
+    return NULL;
+  }
+
+  for(cnp = np->u.childPtr; cnp != NULL; cnp = cnp->siblingPtr)
+  {
+    assert( (cnp->typeId & kMaskTId) == kPairTId );
+
+    if( strcmp( label, _cmJsonIdxLabel(cnp)) == 0 )
+      return cnp;
+  }
+
+  return NULL;
+}
 
 
 cmJsRC_t      cmJsonInitialize( cmJsonH_t* hp, cmCtx_t* ctx )
 {
   cmJsRC_t rc;
   cmJs_t*  p;
-  unsigned i;
 
   // finalize before initialize 
   if((rc = cmJsonFinalize(hp)) != kOkJsRC )
@@ -233,37 +382,16 @@ cmJsRC_t      cmJsonInitialize( cmJsonH_t* hp, cmCtx_t* ctx )
     goto errLabel;
   }
 
-  // allocate the lexer
-  if(cmLexIsValid(p->lexH = cmLexInit(NULL,0,0,&ctx->rpt)) == false )
-  {
-    rc =  _cmJsonError(p,kLexErrJsRC,"Lex allocation failed.");
-    goto errLabel;
-  }
-
-  // register json specific tokens with the lexer
-  for(i=0; _cmJsTokenArray[i].id != kErrorLexTId; ++i)
-  {
-    cmRC_t lexRC;
-    if( (lexRC = cmLexRegisterToken(p->lexH, _cmJsTokenArray[i].id, _cmJsTokenArray[i].text )) != kOkLexRC )
-    {
-      rc = _cmJsonError(p,kLexErrJsRC,"Lex token registration failed for:'%s'.\nLexer Error:%s",_cmJsTokenArray[i].text, cmLexRcToMsg(lexRC) );
-      goto errLabel;
-    }
-  }
-
   hp->h = p;
 
   return kOkJsRC;
       
   errLabel:
   
-  cmMemPtrFree(&p);
-
   if( cmLHeapIsValid(p->heapH) )
     cmLHeapDestroy(&p->heapH);
 
-  if( cmLexIsValid(p->lexH) )
-    cmLexFinal(&p->lexH);
+  cmMemPtrFree(&p);
 
   return rc;
 }
@@ -294,10 +422,21 @@ cmJsRC_t      cmJsonInitializeFromBuf( cmJsonH_t* hp, cmCtx_t* ctx, const char*
   return jsRC;
 }
 
-cmJsRC_t      cmJsonFinalize(   cmJsonH_t* hp )
+cmJsRC_t      cmJsonInitializeFromBinFile( cmJsonH_t* hp, const char* fn, cmCtx_t* ctx )
 {
-  cmRC_t lexRC;
+  cmJsRC_t jsRC;
+
+  if((jsRC = cmJsonInitialize(hp,ctx)) != kOkJsRC )
+    return jsRC;
+
+  if((jsRC = cmJsonMapBinFile(*hp,fn)) != kOkJsRC )
+    cmJsonFinalize(hp);
+
+  return jsRC;
+}
 
+cmJsRC_t      cmJsonFinalize(   cmJsonH_t* hp )
+{
   if( hp == NULL || hp->h == NULL )
     return kOkJsRC;
 
@@ -306,11 +445,9 @@ cmJsRC_t      cmJsonFinalize(   cmJsonH_t* hp )
   // free the internal heap object
   cmLHeapDestroy( &p->heapH );
 
-  // free the lexer
-  if( cmLexIsValid(p->lexH) )
-    if((lexRC = cmLexFinal(&p->lexH)) != kOkLexRC )
-      return _cmJsonError(p,kLexErrJsRC,"Lexer finalization failed.\nLexer Error:%s",cmLexRcToMsg(lexRC));
+  _cmJsonUnmap(p);
 
+  cmMemPtrFree(&p->stackV);
   cmMemPtrFree(&p->serialBufPtr);
 
   // free the handle
@@ -342,6 +479,8 @@ cmJsRC_t _cmJsonLinkInChild( cmJs_t* p, cmJsonNode_t* parentPtr, cmJsonNode_t* n
     case kArrayTId:
     case kPairTId:
       {
+        _cmJsonDropIndex(p,parentPtr);
+
         // if the parent is an 'object' then the child must be a 'pair'
         if( parentPtr->typeId == kObjectTId && np->typeId != kPairTId )
           rc = _cmJsonSyntaxError(p,"Expect only 'pair' nodes as children of 'objects'.");
@@ -451,7 +590,7 @@ cmJsRC_t _cmJsonCreateNumber( cmJs_t* p, cmJsonNode_t* parentPtr, unsigned nodeT
 {
   // numbers may only occurr as children of a 'pair' or element of an 'array'
   if( (parentPtr==NULL) || (parentPtr->typeId != kPairTId && parentPtr->typeId != kArrayTId) )
-    return _cmJsonSyntaxError(p, "The parent of scalar:%*s is not a 'pair' or 'array'.", cmLexTokenCharCount(p->lexH), cmLexTokenText(p->lexH) ); 
+    return _cmJsonSyntaxError(p, "The parent of a '%s' node must be a 'pair' or 'array'.", _cmJsonNodeTypeIdToLabel(nodeTId) ); 
 
   return _cmJsonCreateNode(p,parentPtr,nodeTId,npp);
 
@@ -620,7 +759,7 @@ cmJsRC_t _cmJsonSetString( cmJs_t* p, cmJsonNode_t* np, const char* cp, unsigned
   // deallocate the current string
   if( np->u.stringVal != NULL )
   {
-    cmLHeapFree(p->heapH,np->u.stringVal);
+    _cmJsonHeapFree(p,np->u.stringVal);
     np->u.stringVal = NULL;
   }
 
@@ -691,220 +830,702 @@ cmJsRC_t _cmJsonCreatePair( cmJs_t* p, cmJsonNode_t* parentPtr, const char* labe
 }
 
 
-// if fn == NULL then the buffer must contain the text to parse
-cmJsRC_t _cmJsonParse(cmJsonH_t h, const char* buf, unsigned bufCharCnt, const cmChar_t* fn, cmJsonNode_t* altRootPtr )
-{
-  unsigned      lexTId = kErrorLexTId;
-  cmJs_t*       p      = _cmJsonHandleToPtr(h);
-  cmJsonNode_t* cnp    = altRootPtr == p->rootPtr ? altRootPtr : p->rootPtr;
-  cmJsonNode_t* nnp    = NULL;
-  cmJsRC_t      rc;
+//-----------------------------------------------------------------------------
+// Scanner
+//
+// The scanner accepts the token set of the cmLex based parser which it
+// replaced: the structural characters, quoted strings, C identifiers
+// (treated as strings), decimal, hex and real numbers in the cmLex
+// formats, true, false, null, and C/C++ comments. 
+// White space and the body of quoted strings are skipped 16 characters
+// at a time using SSE2 compare/movemask operations where available.
+
+#if defined(__SSE2__)
+#define cmJS_SSE2
+#include <emmintrin.h>
+#endif
 
-  p->reportErrPosnFl = true;
+bool _cmJsIsSpace(     char c ) { return c==' ' || (c>='\t' && c<='\r'); }
+bool _cmJsIsDigit(     char c ) { return c>='0' && c<='9'; }
+bool _cmJsIsHexDigit(  char c ) { return _cmJsIsDigit(c) || ((c|0x20)>='a' && (c|0x20)<='f'); }
+bool _cmJsIsIdentBeg(  char c ) { return ((c|0x20)>='a' && (c|0x20)<='z') || c=='_'; }
+bool _cmJsIsIdentChar( char c ) { return _cmJsIsIdentBeg(c) || _cmJsIsDigit(c); }
 
-  // assign the text buffer and reset the lexer
-  if( fn == NULL )
-    rc = cmLexSetTextBuffer( p->lexH, buf, bufCharCnt );
-  else
-    rc = cmLexSetFile( p->lexH, fn );
+#ifdef cmJS_SSE2
+// Return the count of leading white space characters in cp[0:16].
+unsigned _cmJsSpaceSpan16( const char* cp )
+{
+  __m128i  v = _mm_loadu_si128((const __m128i*)cp);
+  __m128i  m = _mm_or_si128( _mm_cmpeq_epi8(v,_mm_set1_epi8(' ')),
+                             _mm_and_si128( _mm_cmpgt_epi8(v,_mm_set1_epi8('\t'-1)), _mm_cmplt_epi8(v,_mm_set1_epi8('\r'+1))));
+  unsigned b = ~(unsigned)_mm_movemask_epi8(m) & 0xffff;
+  return b==0 ? 16 : (unsigned)__builtin_ctz(b);
+}
 
-  if( rc != kOkLexRC )
-    return _cmJsonError( p, kLexErrJsRC, "Error setting lexer buffer.");
-  
-  // get the next token
-  while( (lexTId = cmLexGetNextToken( p->lexH )) != kErrorLexTId && (lexTId != kEofLexTId ) && (rc==kOkJsRC) )
-  {
-    cnp = p->lastPtr;
+// Return the index of the first '"' or '\' in cp[0:16] or 16 if neither occurs.
+unsigned _cmJsQuoteSpan16( const char* cp )
+{
+  __m128i  v = _mm_loadu_si128((const __m128i*)cp);
+  unsigned b = (unsigned)_mm_movemask_epi8( _mm_or_si128( _mm_cmpeq_epi8(v,_mm_set1_epi8('"')), _mm_cmpeq_epi8(v,_mm_set1_epi8('\\'))));
+  return b==0 ? 16 : (unsigned)__builtin_ctz(b);
+}
+#endif
 
-    // if cnp is a pair and it's value has been assigned
-    if( cnp != NULL && cnp->typeId == kPairTId && cmJsonChildCount(cnp)==2 )
-    {
-      if((rc = _cmJsonPopNode(p)) != kOkJsRC )
-        break;
+// Return the length of the real number at the start of cp[cn] or 0 if there is no real number.
+// As with cmLex a real must contain a decimal point, an exponent or an 'f' suffix.
+// Unlike cmLex the exponent may have a '+' prefix.
+unsigned _cmJsRealLen( const char* cp, unsigned cn )
+{
+  unsigned i     = 0;
+  unsigned d     = 0;     // digit count
+  unsigned n     = 0;     // decimal point count
+  bool     expFl = false;
 
-      cnp = p->lastPtr;
-    }
-    
-    switch( lexTId )
-    {
-      case kRealLexTId:     // real number
-        rc = _cmJsonCreateReal(p, cnp,  cmLexTokenDouble( p->lexH ), NULL);
+  if( i<cn && cp[i]=='-' )
+    ++i;
+
+  for(; i<cn; ++i)
+    if( _cmJsIsDigit(cp[i]) )
+      ++d;
+    else
+      if( cp[i]=='.' && n==0 )
+        ++n;
+      else
         break;
 
-      case kHexLexTId:      // hexidecimal integer
-        // allow hex integers to be equivalent to decimal integers
+  if( d == 0 )
+    return 0;
 
-      case kIntLexTId:      // decimal integer
-        rc = _cmJsonCreateInt(p, cnp, cmLexTokenInt( p->lexH ), NULL );
-        break;
+  if( i<cn && (cp[i]=='e' || cp[i]=='E') )
+  {
+    unsigned j = ++i;
+    for(; i<cn; ++i)
+      if( i==j && (cp[i]=='-' || cp[i]=='+') )
+        continue;
+      else
+        if( _cmJsIsDigit(cp[i]) )
+          expFl = true;
+        else
+          break;
+  }
 
-      case kTrueLexTId:     // true
-        rc = _cmJsonCreateBool(p, cnp, true, NULL );
-        break;
+  if( i<cn && (cp[i]=='f' || cp[i]=='F') )
+    return i+1;
 
-      case kFalseLexTId:    // false
-        rc = _cmJsonCreateBool(p, cnp, false, NULL );
-        break;
+  return expFl || n==1 ? i : 0;
+}
 
-      case kNullLexTId:     // null
-        rc = _cmJsonCreateNull(p, cnp, NULL );
-        break;
+// Return the length of the decimal integer at the start of cp[cn] or 0 if there is no integer.
+unsigned _cmJsIntLen( const char* cp, unsigned cn )
+{
+  unsigned i = cn>0 && cp[0]=='-' ? 1 : 0;
+  unsigned j = i;
 
-      case kIdentLexTId:    // identifier
-        // allow identifiers to be equivalent to strings.
+  for(; i<cn; ++i)
+    if( !_cmJsIsDigit(cp[i]) )
+      break;
 
-      case kQStrLexTId:     // quoted string
-        if( cnp == NULL )
-          rc = _cmJsonSyntaxError(p,"Encountered a 'string' with no parent.");
-        else
-          if( cnp->typeId == kObjectTId )
-          {
-            if((rc = _cmJsonCreateNode(p,cnp,kPairTId,&nnp)) == kOkJsRC )
-            {
-              _cmJsonPushNode(p,nnp);
-              cnp = nnp;
-            }
+  return i==j ? 0 : i;
+}
 
-            //if((rc = _cmJsonCreateNewParent(p,cnp,kPairTId)) == kOkJsRC )
-            //  cnp = p->lastPtr;
-          }
+// Return the length of the hex integer at the start of cp[cn] or 0 if there is no hex integer.
+unsigned _cmJsHexLen( const char* cp, unsigned cn )
+{
+  unsigned i = 0;
 
-        if( rc == kOkJsRC )
-          rc = _cmJsonCreateString(p, cnp, cmLexTokenText(p->lexH), cmLexTokenCharCount(p->lexH), NULL);
+  if( cn >= 3 && cp[0]=='0' && cp[1]=='x' )
+    for(i=2; i<cn; ++i)
+      if( !_cmJsIsHexDigit(cp[i]) )
         break;
 
-      case kColonLexTId:
-        if( cnp->typeId != kPairTId )
-          rc = _cmJsonSyntaxError(p,"A colon was found outside of a 'pair' element.");
-        break;
+  return i;
+}
 
-      case kLCurlyLexTId:   // {
-        //rc = _cmJsonCreateNewParent(p, cnp, kObjectTId );
-        if((rc = _cmJsonCreateNode(p,cnp,kObjectTId,&nnp)) == kOkJsRC )
-          _cmJsonPushNode(p,nnp);
-        break;
+int _cmJsIntValue( const char* cp, unsigned cn )
+{
+  unsigned i = cp[0]=='-' ? 1 : 0;
 
-      case kRCurlyLexTId:   // }
-        if( cnp == NULL || cnp->typeId != kObjectTId )
-          rc = _cmJsonSyntaxError(p,"A '}' was found without an accompanying opening bracket.");
-        else
-          rc = _cmJsonPopNode(p);
-        break;
+  // convert short decimal values w/o leading zeros (leading zeros signal octal to strtol())
+  if( cn-i <= 9 && (cp[i]!='0' || cn-i==1) )
+  {
+    int v = 0;
+    for(; i<cn && _cmJsIsDigit(cp[i]); ++i)
+      v = v*10 + (cp[i]-'0');
 
-      case kLHardLexTId:    // [
-        //rc = _cmJsonCreateNewParent(p, cnp, kArrayTId);
-        if((rc = _cmJsonCreateNode(p,cnp,kArrayTId,&nnp)) == kOkJsRC )
-          _cmJsonPushNode(p,nnp);
-        break;
+    if( i == cn )
+      return cp[0]=='-' ? -v : v;
+  }
 
-      case kRHardLexTId:    // ]
-        if( cnp == NULL || cnp->typeId != kArrayTId )
-          rc = _cmJsonSyntaxError(p,"A ']' was found without an accompanying opening bracket.");
-        else
-          rc = _cmJsonPopNode(p);
-        break;
+  char buf[cn+1];
+  memcpy(buf,cp,cn);
+  buf[cn] = 0;
+  return strtol(buf,NULL,0);
+}
 
-      case kCommaLexTId:    // ,
-        if( (cnp==NULL) || (cnp->typeId != kArrayTId && cnp->typeId != kObjectTId) )
-          rc = _cmJsonSyntaxError(p,"Commas may only occur in 'array' and 'object' nodes.");
+double _cmJsRealValue( const char* cp, unsigned cn )
+{
+  static const double pow10V[] = { 1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22 };
 
-        break;
+  unsigned           i        = 0;
+  unsigned           digitCnt = 0;
+  unsigned long long m        = 0;  // mantissa digits as an integer
+  int                scale    = 0;  // power of ten applied to m
+  int                e        = 0;
+  bool               negFl    = cp[0]=='-';
 
+  if( negFl )
+    ++i;
 
-      case kSpaceLexTId:    // white space
-      case kBlockCmtLexTId: //  block comment
-      case kLineCmtLexTId:  // line comment 
-        assert(0); 
-        break;
+  for(; i<cn && _cmJsIsDigit(cp[i]); ++i,++digitCnt)
+    m = m*10 + (cp[i]-'0');
 
-      default:
-        break;
-    }
-  }
+  if( i<cn && cp[i]=='.' )
+    for(++i; i<cn && _cmJsIsDigit(cp[i]); ++i,++digitCnt,--scale)
+      m = m*10 + (cp[i]-'0');
 
-  if( lexTId == kErrorLexTId )
-    rc = _cmJsonSyntaxError( p, "The lexer failed: %s.", cmLexRcToMsg(cmLexErrorRC(p->lexH)));
+  if( digitCnt <= 15 )
+  {
+    bool expNegFl = false;
 
-  p->reportErrPosnFl = false;
-  p->modifiedFl      = false;
+    if( i<cn && (cp[i]=='e' || cp[i]=='E') )
+    {
+      ++i;
+      if( i<cn && (cp[i]=='-' || cp[i]=='+') )
+        expNegFl = cp[i++]=='-';
 
-  return rc;
-}
+      for(; i<cn && _cmJsIsDigit(cp[i]) && e<1000; ++i)
+        e = e*10 + (cp[i]-'0');
+    }
 
-cmJsRC_t      cmJsonParse(      cmJsonH_t h, const char* buf, unsigned bufCharCnt, cmJsonNode_t* altRootPtr )
-{ return _cmJsonParse(h,buf,bufCharCnt,NULL,altRootPtr); }
+    scale += expNegFl ? -e : e;
 
-cmJsRC_t      cmJsonParseFile(  cmJsonH_t h, const char* fn, cmJsonNode_t* altRootPtr )
-{ return _cmJsonParse(h,NULL,0,fn,altRootPtr); }
+    // Both m (< 10^15 < 2^53) and 10^|scale| are exact doubles therefore
+    // the product (or quotient) is correctly rounded (Clinger's fast path).
+    if( -22 <= scale && scale <= 22 )
+    {
+      double v = (double)m;
+      v = scale < 0 ? v / pow10V[-scale] : v * pow10V[scale];
+      return negFl ? -v : v;
+    }
+  }
 
-cmJsonNode_t* cmJsonRoot(  cmJsonH_t h )
-{  
-  cmJs_t* p = _cmJsonHandleToPtr(h);
-  return p->rootPtr;
+  char buf[cn+1];
+  memcpy(buf,cp,cn);
+  buf[cn] = 0;
+  return strtod(buf,NULL);
 }
 
+unsigned _cmJsonScanError( cmJs_t* p, const char* tokPtr, const char* msg )
+{
+  p->tokPtr     = tokPtr;
+  p->tokCharCnt = 0;
+  _cmJsonSyntaxError(p,"%s",msg);
+  return kErrorJsTokId;
+}
 
-cmJsRC_t      cmJsonClearTree(      cmJsonH_t h )
+// Scan the next token. On return p->tokPtr and p->tokCharCnt delimit the
+// token text. The text of quoted strings does not include the quotes.
+// *escFlPtr is set to true if a string token contains escape sequences.
+unsigned _cmJsonScanToken( cmJs_t* p, bool* escFlPtr )
 {
-  cmJs_t* p = _cmJsonHandleToPtr(h);
+  const char* cp    = p->scanPtr;
+  const char* ep    = p->scanEndPtr;
+  const char* tp    = NULL;  // end of the token
+  unsigned    tokId = kErrorJsTokId;
 
-  p->rootPtr = NULL;
-  p->basePtr = NULL;
-  p->lastPtr = NULL;
-  
-  cmLHeapClear(p->heapH,true);
+  // skip white space and comments
+  for(;;)
+  {
+#ifdef cmJS_SSE2
+    while( ep - cp >= 16 )
+    {
+      unsigned n = _cmJsSpaceSpan16(cp);
+      cp += n;
+      if( n < 16 )
+        break;
+    }
+#endif
+    while( cp < ep && _cmJsIsSpace(*cp) )
+      ++cp;
 
-  return kOkJsRC;
-}
+    if( ep - cp < 2 || cp[0] != '/' )
+      break;
 
-bool cmJsonIsObject( const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kObjectTId); }
-bool cmJsonIsArray(  const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kArrayTId); }
-bool cmJsonIsPair(   const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kPairTId); }
-bool cmJsonIsString( const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kStringTId); }
-bool cmJsonIsInt(    const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kIntTId); }
-bool cmJsonIsReal(   const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kRealTId); }
-bool cmJsonIsBool(   const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kTrueTId | kFalseTId); }
+    if( cp[1] == '/' )
+    {
+      if((cp = memchr(cp+2,'\n',ep-(cp+2))) == NULL )
+        cp = ep;
+    }
+    else
+    {
+      if( cp[1] != '*' )
+        break;
 
+      for(tp=cp+2; ep-tp >= 2 && (tp[0]!='*' || tp[1]!='/'); ++tp)
+      {}
 
+      if( ep - tp < 2 )
+        return _cmJsonScanError(p,cp,"Missing end of block comment.");
 
-unsigned cmJsonChildCount( const cmJsonNode_t* np )
-{
-  if( np == NULL )
-    return 0;
+      cp = tp + 2;
+    }
+  }
 
-  unsigned n = 0;
-  switch( np->typeId )
+  p->tokPtr = cp;
+
+  if( cp >= ep )
   {
-    case kObjectTId:
-    case kArrayTId:
-    case kPairTId:
-      {        
-        const cmJsonNode_t* lp = np->u.childPtr;
+    p->scanPtr    = cp;
+    p->tokCharCnt = 0;
+    return kEofJsTokId;
+  }
 
-        while( lp != NULL )
+  tp = cp + 1;
+
+  switch( *cp )
+  {
+    case '{': tokId = kLCurlyJsTokId; break;
+    case '}': tokId = kRCurlyJsTokId; break;
+    case '[': tokId = kLHardJsTokId;  break;
+    case ']': tokId = kRHardJsTokId;  break;
+    case ':': tokId = kColonJsTokId;  break;
+    case ',': tokId = kCommaJsTokId;  break;
+
+    case '"':
+      {
+        bool escFl = false;
+        
+        for(;;)
         {
-          ++n;
-          lp = lp->siblingPtr;
+#ifdef cmJS_SSE2
+          while( ep - tp >= 16 )
+          {
+            unsigned n = _cmJsQuoteSpan16(tp);
+            tp += n;
+            if( n < 16 )
+              break;
+          }
+#endif
+          while( tp < ep && *tp != '"' && *tp != '\\' )
+            ++tp;
+
+          if( tp >= ep )
+            return _cmJsonScanError(p,cp,"Missing string literal end quote.");
+
+          if( *tp == '"' )
+            break;
+
+          escFl = true;
+          tp   += 2;  // skip the escaped character
         }
 
+        *escFlPtr     = escFl;
+        p->tokPtr     = cp + 1;
+        p->tokCharCnt = tp - (cp + 1);
+        p->scanPtr    = tp + 1;
+        return kStringJsTokId;
       }
-      break;
 
     default:
-      break;
-  }
-  return n;
-}
+      if( _cmJsIsIdentBeg(*cp) )
+      {
+        for(; tp < ep && _cmJsIsIdentChar(*tp); ++tp)
+        {}
 
-cmJsonNode_t* cmJsonArrayElement( cmJsonNode_t* np, unsigned index )
-{
-  unsigned i;
+        tokId     = kStringJsTokId;
+        *escFlPtr = false;
 
-  assert( index < cmJsonChildCount(np));
+        switch( tp - cp )
+        {
+          case 4:
+            if( strncmp(cp,"true",4) == 0 )
+              tokId = kTrueJsTokId;
+            else
+              if( strncmp(cp,"null",4) == 0 )
+                tokId = kNullJsTokId;
+            break;
 
-  np = np->u.childPtr;
+          case 5:
+            if( strncmp(cp,"false",5) == 0 )
+              tokId = kFalseJsTokId;
+            break;
+        }
+      }
+      else
+      {
+        // as with cmLex the longest match wins and reals win ties
+        unsigned cn = ep - cp;
+        unsigned rn = _cmJsRealLen(cp,cn);
+        unsigned in = _cmJsIntLen(cp,cn);
+        unsigned hn = _cmJsHexLen(cp,cn);
 
-  for(i=0; i<index; ++i)
+        if( rn > 0 && rn >= in && rn >= hn )
+        {
+          tokId = kRealJsTokId;
+          tp    = cp + rn;
+        }
+        else
+          if( in > 0 && in >= hn )
+          {
+            tokId = kIntJsTokId;
+            tp    = cp + in;
+
+            // allow an unsigned suffix
+            if( tp < ep && (*tp=='u' || *tp=='U') )
+            {
+              if( cp[0] == '-' )
+                return _cmJsonScanError(p,cp,"A signed integer has a 'u' or 'U' suffix.");
+              ++tp;
+            }
+          }
+          else
+            if( hn > 0 )
+            {
+              tokId = kIntJsTokId;
+              tp    = cp + hn;
+            }
+            else
+              return _cmJsonScanError(p,cp,"Unable to recognize token.");
+      }
+      break;
+  }
+
+  p->tokCharCnt = tp - cp;
+  p->scanPtr    = tp;
+  return tokId;
+}
+
+//-----------------------------------------------------------------------------
+// Parser
+//
+// The parser builds the tree directly in the linked heap using an explicit
+// stack of open object, array and pair nodes. Each stack frame tracks the
+// last child of it's node so that children are appended in constant time.
+
+enum { kJsMaxBlockByteCnt = 1024*1024 };  // max. linked heap block size set by the parser
+
+// Create a node and append it to the child list of the node on the top
+// of the stack 'f'. If 'f' is NULL the node has no parent and becomes the
+// root node if the tree does not yet have a root.
+cmJsonNode_t* _cmJsonScanCreateNode( cmJs_t* p, cmJsFrame_t* f, unsigned typeId )
+{
+  cmJsonNode_t* np;
+
+  if((np = cmLHeapAllocZ( p->heapH, sizeof(cmJsonNode_t) )) == NULL )
+  {
+    _cmJsonError(p,kMemAllocErrJsRC,"Error allocating node memory.");
+    return NULL;
+  }
+
+  np->typeId = typeId;
+
+  if( f == NULL )
+  {
+    if( p->rootPtr == NULL )
+      p->rootPtr = np;
+    return np;
+  }
+
+  np->ownerPtr = f->np;
+
+  if( f->lastPtr == NULL )
+    f->np->u.childPtr = np;
+  else
+    f->lastPtr->siblingPtr = np;
+
+  f->lastPtr = np;
+  ++f->cnt;
+
+  return np;
+}
+
+// Push 'np' on the parser stack and return the new top of stack.
+cmJsFrame_t* _cmJsonScanPush( cmJs_t* p, unsigned* stackCntPtr, cmJsonNode_t* np )
+{
+  cmJsFrame_t* f;
+
+  if( *stackCntPtr == p->stackAllocCnt )
+  {
+    p->stackAllocCnt += 32;
+    p->stackV         = cmMemResizeP(cmJsFrame_t,p->stackV,p->stackAllocCnt);
+  }
+
+  f          = p->stackV + *stackCntPtr;
+  f->np      = np;
+  f->lastPtr = NULL;
+  f->cnt     = 0;
+
+  *stackCntPtr += 1;
+
+  return f;
+}
+
+// Assign the current string token to the string node 'np'.
+cmJsRC_t _cmJsonScanString( cmJs_t* p, cmJsonNode_t* np, bool escFl )
+{
+  // empty strings are stored as NULL (see _cmJsonSetString())
+  if( p->tokCharCnt == 0 )
+    return kOkJsRC;
+
+  if( escFl )
+    return _cmJsonSetString(p,np,p->tokPtr,p->tokCharCnt);
+
+  if((np->u.stringVal = cmLHeapAlloc(p->heapH,p->tokCharCnt+1)) == NULL )
+    return _cmJsonError(p,kMemAllocErrJsRC,"Unable to allocate string memory.");
+
+  memcpy(np->u.stringVal,p->tokPtr,p->tokCharCnt);
+  np->u.stringVal[ p->tokCharCnt ] = 0;
+
+  return kOkJsRC;
+}
+
+cmJsRC_t _cmJsonParse(cmJs_t* p, const char* buf, unsigned bufCharCnt )
+{
+  cmJsRC_t      rc       = kOkJsRC;
+  unsigned      tokId    = kErrorJsTokId;
+  unsigned      stackCnt = 0;
+  bool          escFl    = false;
+  cmJsFrame_t*  f;
+  cmJsonNode_t* np;
+
+  p->reportErrPosnFl = true;
+  p->scanBegPtr      = buf;
+  p->scanEndPtr      = buf + bufCharCnt;
+  p->scanPtr         = buf;
+  p->tokPtr          = buf;
+  p->tokCharCnt      = 0;
+
+  // The tree uses many times more memory than the text. Size the linked heap
+  // blocks to the text so that large files do not create long block chains
+  // (the linked heap allocation time grows with the length of the chain).
+  if( bufCharCnt > cmLHeapDefaultBlockByteCount(p->heapH) )
+    cmLHeapSetDefaultBlockByteCount(p->heapH, cmMin(bufCharCnt,kJsMaxBlockByteCnt));
+  
+  while( rc == kOkJsRC && (tokId = _cmJsonScanToken(p,&escFl)) != kErrorJsTokId && tokId != kEofJsTokId )
+  {
+    f = stackCnt==0 ? NULL : p->stackV + stackCnt - 1;
+
+    // if f is a pair and it's value has been assigned
+    if( f != NULL && f->np->typeId == kPairTId && f->cnt == 2 )
+      f = --stackCnt==0 ? NULL : p->stackV + stackCnt - 1;
+
+    switch( tokId )
+    {
+      case kIntJsTokId:
+      case kRealJsTokId:
+      case kTrueJsTokId:
+      case kFalseJsTokId:
+      case kNullJsTokId:
+        // scalars may only occur as the value of a 'pair' or as an element of an 'array'
+        if( f == NULL || (f->np->typeId != kPairTId && f->np->typeId != kArrayTId) )
+        {
+          rc = _cmJsonSyntaxError(p, "The parent of scalar:%.*s is not a 'pair' or 'array'.", p->tokCharCnt, p->tokPtr );
+          break;
+        }
+
+        if((np = _cmJsonScanCreateNode(p,f,tokId)) == NULL )
+        {
+          rc = kMemAllocErrJsRC;
+          break;
+        }
+
+        switch( tokId )
+        {
+          case kIntJsTokId:   np->u.intVal  = _cmJsIntValue(p->tokPtr,p->tokCharCnt);  break;
+          case kRealJsTokId:  np->u.realVal = _cmJsRealValue(p->tokPtr,p->tokCharCnt); break;
+          case kTrueJsTokId:  np->u.boolVal = true;  break;
+          case kFalseJsTokId: np->u.boolVal = false; break;
+        }
+        break;
+
+      case kStringJsTokId:  // quoted string or identifier
+        if( f == NULL )
+        {
+          rc = _cmJsonSyntaxError(p,"Encountered a 'string' with no parent.");
+          break;
+        }
+
+        // a string which is the child of an object is the label of a new pair
+        if( f->np->typeId == kObjectTId )
+        {
+          if((np = _cmJsonScanCreateNode(p,f,kPairTId)) == NULL )
+          {
+            rc = kMemAllocErrJsRC;
+            break;
+          }
+
+          f = _cmJsonScanPush(p,&stackCnt,np);
+        }
+
+        if((np = _cmJsonScanCreateNode(p,f,kStringTId)) == NULL )
+        {
+          rc = kMemAllocErrJsRC;
+          break;
+        }
+        
+        rc = _cmJsonScanString(p,np,escFl);
+        break;
+
+      case kColonJsTokId:
+        if( f == NULL || f->np->typeId != kPairTId )
+          rc = _cmJsonSyntaxError(p,"A colon was found outside of a 'pair' element.");
+        break;
+
+      case kLCurlyJsTokId:  // {
+      case kLHardJsTokId:   // [
+        if( f != NULL && f->np->typeId == kObjectTId )
+        {
+          rc = _cmJsonSyntaxError(p,"Expect only 'pair' nodes as children of 'objects'.");
+          break;
+        }
+
+        if((np = _cmJsonScanCreateNode(p,f,tokId==kLCurlyJsTokId ? kObjectTId : kArrayTId)) == NULL )
+        {
+          rc = kMemAllocErrJsRC;
+          break;
+        }
+
+        _cmJsonScanPush(p,&stackCnt,np);
+        break;
+        
+      case kRCurlyJsTokId:  // }
+        if( f == NULL || f->np->typeId != kObjectTId )
+          rc = _cmJsonSyntaxError(p,"A '}' was found without an accompanying opening bracket.");
+        else
+        {
+          _cmJsonBuildIndex(p,f->np,f->cnt);
+          --stackCnt;
+        }
+        break;
+
+      case kRHardJsTokId:   // ]
+        if( f == NULL || f->np->typeId != kArrayTId )
+          rc = _cmJsonSyntaxError(p,"A ']' was found without an accompanying opening bracket.");
+        else
+        {
+          _cmJsonBuildIndex(p,f->np,f->cnt);
+          --stackCnt;
+        }
+        break;
+
+      case kCommaJsTokId:   // ,
+        if( (f==NULL) || (f->np->typeId != kArrayTId && f->np->typeId != kObjectTId) )
+          rc = _cmJsonSyntaxError(p,"Commas may only occur in 'array' and 'object' nodes.");
+        break;
+
+      default:
+        assert(0);
+        break;
+    }
+  }
+
+  // the scanner has already reported the error
+  if( tokId == kErrorJsTokId )
+    rc = kSyntaxErrJsRC;
+
+  p->reportErrPosnFl = false;
+  p->modifiedFl      = false;
+
+  return rc;
+}
+
+cmJsRC_t      cmJsonParse(      cmJsonH_t h, const char* buf, unsigned bufCharCnt, cmJsonNode_t* altRootPtr )
+{ 
+  cmJs_t* p = _cmJsonHandleToPtr(h);
+  return _cmJsonParse(p,buf,bufCharCnt); 
+}
+
+cmJsRC_t      cmJsonParseFile(  cmJsonH_t h, const char* fn, cmJsonNode_t* altRootPtr )
+{
+  cmJs_t*  p   = _cmJsonHandleToPtr(h);
+  unsigned n   = 0;
+  char*    buf = NULL;
+  cmJsRC_t rc;
+
+  if((buf = cmFileFnToStr(fn,p->err.rpt,&n)) == NULL )
+    return _cmJsonError(p,kFileReadErrJsRC,"Unable to read the JSON file '%s'.",cmStringNullGuard(fn));
+
+  rc = _cmJsonParse(p,buf,n);
+
+  cmMemFree(buf);
+
+  return rc;
+}
+
+cmJsonNode_t* cmJsonRoot(  cmJsonH_t h )
+{  
+  cmJs_t* p = _cmJsonHandleToPtr(h);
+  return p->rootPtr;
+}
+
+
+cmJsRC_t      cmJsonClearTree(      cmJsonH_t h )
+{
+  cmJs_t* p = _cmJsonHandleToPtr(h);
+
+  p->rootPtr = NULL;
+  
+  cmLHeapClear(p->heapH,true);
+
+  _cmJsonUnmap(p);
+
+  return kOkJsRC;
+}
+
+bool cmJsonIsObject( const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kObjectTId); }
+bool cmJsonIsArray(  const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kArrayTId); }
+bool cmJsonIsPair(   const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kPairTId); }
+bool cmJsonIsString( const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kStringTId); }
+bool cmJsonIsInt(    const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kIntTId); }
+bool cmJsonIsReal(   const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kRealTId); }
+bool cmJsonIsBool(   const cmJsonNode_t* np ) { return cmIsFlag(np->typeId,kTrueTId | kFalseTId); }
+
+
+
+unsigned cmJsonChildCount( const cmJsonNode_t* np )
+{
+  if( np == NULL )
+    return 0;
+
+  if( np->idxPtr != NULL )
+    return np->idxPtr->n;
+
+  unsigned n = 0;
+  switch( np->typeId )
+  {
+    case kObjectTId:
+    case kArrayTId:
+    case kPairTId:
+      {        
+        const cmJsonNode_t* lp = np->u.childPtr;
+
+        while( lp != NULL )
+        {
+          ++n;
+          lp = lp->siblingPtr;
+        }
+
+      }
+      break;
+
+    default:
+      break;
+  }
+  return n;
+}
+
+cmJsonNode_t* cmJsonArrayElement( cmJsonNode_t* np, unsigned index )
+{
+  unsigned i;
+
+  assert( index < cmJsonChildCount(np));
+
+  if( np->idxPtr != NULL )
+    return np->idxPtr->eleV[index];
+
+  np = np->u.childPtr;
+
+  for(i=0; i<index; ++i)
     np = np->siblingPtr;
 
   return np;
@@ -1053,32 +1674,18 @@ cmJsRC_t  _cmJsonFindPathValue( cmJs_t* p, const char* pathPrefix, const char* p
         break;
       }
 
-      // get the count of pairs in this object
-      unsigned      cn = cmJsonChildCount( rp );
-      cmJsonNode_t* cp = rp->u.childPtr;  
-      unsigned       k;
-
-      for(k=0; k<cn; ++k)
-      {
-        // all children of an object must be pairs
-        assert( cp != NULL && cmJsonIsPair(cp) );
-
-        // if this is the labeled pair we are looking for
-        if( strcmp(cmJsonPairLabel(cp),sp) == 0 )
-          break;        
-
-        cp = cp->siblingPtr;
-      }
+      // locate the labeled pair
+      const cmJsonNode_t* cp = _cmJsonFindMemberPair( rp, sp );
 
       // if the search failed
-      if( k == cn || cp == NULL )
+      if( cp == NULL )
       {
         rc = cmErrMsg(&p->err,kNodeNotFoundJsRC,"The path label '%s' could not be found.",cmStringNullGuard(sp));
         break;
       }
 
       // take the value of the located pair to continue the search
-      rp = cmJsonPairValue(cp);
+      rp = cmJsonPairValue((cmJsonNode_t*)cp);
 
       // advance to the next label
       sp += strlen(sp) + 1;
@@ -1271,30 +1878,21 @@ cmJsRC_t  _cmJsonFindMemberValue( const cmJsonNode_t* np, const char* label, uns
   if( np->typeId != kObjectTId )
     return kNodeNotFoundJsRC;
 
-  // for each member pair
-  const cmJsonNode_t* cnp = np->u.childPtr;
-  while( cnp != NULL )
-  {
-    assert( (cnp->typeId & kMaskTId) == kPairTId );
+  // locate the member pair
+  const cmJsonNode_t* cnp = _cmJsonFindMemberPair(np,label);
 
-    // if the labels match ...
-    if( strcmp( label, cmJsonPairLabel(cnp)) == 0 )
-    {
-      // ... and the type flags match ...
-      if( (keyTypeId==kInvalidTId || cmIsFlag(cnp->u.childPtr->siblingPtr->typeId,keyTypeId) ) )
-      {
-        *npp = cnp->u.childPtr->siblingPtr;
-        return kOkJsRC; // ... then the key was found.
-      }
+  if( cnp == NULL )
+    return kNodeNotFoundJsRC;
 
-      // ... label match but wrong type ... this is considered an error
-      return kNodeCannotCvtJsRC;
-    }
-  
-    cnp = cnp->siblingPtr; 
+  // if the type flags match ...
+  if( (keyTypeId==kInvalidTId || cmIsFlag(cnp->u.childPtr->siblingPtr->typeId,keyTypeId) ) )
+  {
+    *npp = cnp->u.childPtr->siblingPtr;
+    return kOkJsRC; // ... then the key was found.
   }
 
-  return kNodeNotFoundJsRC;
+  // ... label match but wrong type ... this is considered an error
+  return kNodeCannotCvtJsRC;
 }
 
 cmJsRC_t   cmJsonUIntValue( const cmJsonNode_t* vp, unsigned* retPtr )
@@ -1543,19 +2141,9 @@ cmJsonNode_t* cmJsonNodeMemberValue( const cmJsonNode_t* np, const char* label )
 {
   assert( cmJsonIsObject(np) );
 
-  unsigned n = cmJsonChildCount(np);
-  unsigned j = 0;
-  for(; j<n; ++j)
-  {
-    const cmJsonNode_t* cnp = cmJsonArrayElementC(np,j);
-
-    assert( cnp != NULL && cmJsonIsPair(cnp) );
+  const cmJsonNode_t* cnp = _cmJsonFindMemberPair(np,label);
 
-    if( strcmp(label,cmJsonPairLabel(cnp))==0 )
-      return cmJsonPairValue((cmJsonNode_t*)cnp);
-  }
-  
-  return NULL;
+  return cnp == NULL ? NULL : cmJsonPairValue((cmJsonNode_t*)cnp);
 }
 
 cmJsRC_t      cmJsonVMemberValues( const cmJsonNode_t* objectNodePtr, const char** errLabelPtrPtr, va_list vl )
@@ -1972,7 +2560,12 @@ cmJsRC_t    cmJsonSetString( cmJsonH_t h, cmJsonNode_t*  np, const char* sval )
 
   unsigned sn = strlen(sval);
 
-  if( np->u.stringVal != NULL && strlen(np->u.stringVal) <= sn )
+  // if 'np' is a pair label then the object containing the pair is no longer indexed correctly
+  if( np->ownerPtr != NULL && np->ownerPtr->typeId == kPairTId && np->ownerPtr->u.childPtr == np )
+    _cmJsonDropIndex(p,np->ownerPtr->ownerPtr);
+
+  // strings in a mapped image may be shared by many nodes and must not be overwritten
+  if( np->u.stringVal != NULL && sn <= strlen(np->u.stringVal) && !_cmJsonIsMapped(p,np->u.stringVal) )
     strcpy(np->u.stringVal,sval);
   else
     return  _cmJsonSetString(p,np,sval,sn);
@@ -2550,18 +3143,20 @@ void _cmJsonFreeNode( cmJs_t* p, cmJsonNode_t* np )
           cnp = nnp;
         }
 
+        _cmJsonDropIndex(p,np);
+
       }
       break;
 
     case kStringTId:
       if( np->u.stringVal != NULL )
-        cmLHeapFree(p->heapH,np->u.stringVal);
+        _cmJsonHeapFree(p,np->u.stringVal);
       break;
 
 
   }
 
-  cmLHeapFree(p->heapH,np);
+  _cmJsonHeapFree(p,np);
     
 }
 
@@ -2585,6 +3180,8 @@ cmJsRC_t _cmJsonRemoveNode( cmJs_t* p, cmJsonNode_t* np, bool freeFl, bool balan
       // get the parents first child
       cmJsonNode_t* cnp = parentPtr->u.childPtr;
 
+      _cmJsonDropIndex(p,parentPtr);
+
       // if np is the first child then make the second child the first child
       if( cnp == np )
       {
@@ -3018,167 +3615,695 @@ cmJsRC_t      cmJsonSerializeTree( cmJsonH_t h, const cmJsonNode_t* np, void** b
 
   cmJs_t* p      = _cmJsonHandleToPtr(h);
 
-  assert( bufPtrPtr != NULL && bufByteCntPtr != NULL );
+  assert( bufPtrPtr != NULL && bufByteCntPtr != NULL );
+
+  *bufPtrPtr     = NULL;
+  *bufByteCntPtr = 0;
+
+  if( np == NULL )
+    np = p->rootPtr;
+   
+  // validate the tree
+  if((rc = _cmJsonValidateNode(p,np,np->ownerPtr)) != kOkJsRC )
+    return rc;
+
+  // increment the buffer size to include the buffer header
+  p->serialByteCnt = cmJsonSerialByteCount(np);
+
+  // allocate the serial buffer memory
+  p->serialBufPtr  = cmMemResize( char, p->serialBufPtr, p->serialByteCnt );
+
+  // serialize the tree
+  if((rc = cmJsonSerialize(np, p->serialBufPtr, p->serialByteCnt )) != kOkJsRC )
+    return rc;
+
+  *bufPtrPtr     = p->serialBufPtr;
+  *bufByteCntPtr = p->serialByteCnt;
+
+  return rc;
+}
+
+const void* _cmJsonDeserialAdv( cmJsDeserial_t* rp, unsigned n )
+{
+  const void* vp = rp->nextPtr;
+  rp->nextPtr += n;
+  assert(rp->nextPtr <= rp->endPtr);
+  assert(rp->nodeIdx <= rp->nodeCnt);
+  return vp;
+}
+
+int _cmJsonDeserialInt( cmJsDeserial_t* rp )
+{ return *(const int*)_cmJsonDeserialAdv(rp,sizeof(int)); }
+
+unsigned _cmJsonDeserialUint( cmJsDeserial_t* rp )
+{ return *(const unsigned*)_cmJsonDeserialAdv(rp,sizeof(unsigned)); }
+
+double _cmJsonDeserialReal( cmJsDeserial_t* rp )
+{ return *(const double*)_cmJsonDeserialAdv(rp,sizeof(double)); }
+
+
+cmJsRC_t _cmJsonDeserializeNode( cmJs_t* p, cmJsonNode_t* parentPtr, cmJsDeserial_t* rp )
+{
+  cmJsRC_t      rc           = kOkJsRC;
+  unsigned      typeId       = _cmJsonDeserialUint(rp);
+  unsigned      childCnt     = 0;
+  cmJsonNode_t* newParentPtr = NULL;  
+
+  rp->nodeIdx++;
+  
+  switch( typeId )
+  {
+    case kPairTId:
+      rc       = _cmJsonCreateNode(p,parentPtr,typeId,&newParentPtr);
+      childCnt = 2;
+      break;
+
+    case kObjectTId:
+    case kArrayTId:
+      rc       = _cmJsonCreateNode(p,parentPtr,typeId,&newParentPtr);
+      childCnt = _cmJsonDeserialUint(rp);
+      break;
+
+    case kStringTId:
+      {
+        unsigned sn = strlen(rp->nextPtr);
+        rc =  _cmJsonCreateString( p, parentPtr, rp->nextPtr, sn,NULL);
+        _cmJsonDeserialAdv(rp,sn+1);
+      }
+      break;
+
+    case kIntTId: 
+      {
+        int v = _cmJsonDeserialInt(rp);
+        rc = _cmJsonCreateInt( p, parentPtr, v, NULL );
+      }
+      break;
+
+    case kRealTId:
+      {
+        double v = _cmJsonDeserialReal(rp);
+        rc = _cmJsonCreateReal( p, parentPtr, v, NULL );
+      }
+      break;
+
+    case kNullTId:
+      rc = _cmJsonCreateNull( p, parentPtr, NULL );
+      break;
+
+    case kTrueTId:
+      rc = _cmJsonCreateBool( p, parentPtr, true, NULL );
+      break;
+
+    case kFalseTId:
+      rc = _cmJsonCreateBool( p, parentPtr, false, NULL );
+      break;
+
+    default:
+      assert(0);
+      break;
+  }
+
+  if( rc != kOkJsRC )
+    return rc;
+
+  // if the current node is a parent
+  if( childCnt > 0 )
+  {
+    unsigned i;
+    assert( newParentPtr != NULL );
+    
+    for(i=0; i<childCnt; ++i)
+      if((rc= _cmJsonDeserializeNode( p, newParentPtr, rp )) != kOkJsRC )
+        return rc;
+  }
+
+  return rc;
+
+}
+
+cmJsRC_t _cmJsonDeserialize( cmJs_t* p, const void* vbuf, cmJsonNode_t* altRootPtr )
+{
+  cmJsDeserial_t         r;
+  cmJsonNode_t*          rootPtr = altRootPtr == NULL ? p->rootPtr : altRootPtr;
+  const char*            buf     = (const char*)vbuf;
+
+  memset(&r,0,sizeof(r));
+
+  r.nextPtr = buf;
+  r.endPtr  = buf + (4*sizeof(unsigned)); // the buf must at least contain a header
+
+  // read the buffer header
+  unsigned hdrId   = _cmJsonDeserialUint(&r);
+  unsigned byteCnt = _cmJsonDeserialUint(&r);
+  r.nodeCnt        = _cmJsonDeserialUint(&r);
+  /*unsigned version =*/ _cmJsonDeserialUint(&r);
+  
+  if( hdrId != 'json' )
+    return _cmJsonError(p,kSerialErrJsRC,"The buffer does not have the correct header.");
+
+  if( byteCnt < (4*sizeof(unsigned)) )
+    return _cmJsonError(p,kSerialErrJsRC,"The buffer is too small to be contain any information.");
+
+  // change the buffer end pointer to the correct size based
+  // on the the byte count stored in the buffer
+  r.endPtr = buf + byteCnt + (2*sizeof(unsigned));
+
+  return _cmJsonDeserializeNode(p, rootPtr, &r );   
+
+} 
+
+cmJsRC_t      cmJsonDeserialize( cmJsonH_t h, const void* bufPtr, cmJsonNode_t* altRootPtr )
+{
+  cmJs_t* p = _cmJsonHandleToPtr(h);
+  return _cmJsonDeserialize(p,bufPtr,altRootPtr);
+}
+
+//-----------------------------------------------------------------------------
+// Binary images
+//
+// An image is a cmJsBinHdr_t record followed by the node array, the index
+// area and the string table. The nodes are stored in depth first order
+// (the root is the first node) using the native cmJsonNode_t record.
+// Node, string and index links are stored as byte offsets from the start
+// of the image. Offset 0 (the header) represents NULL.
+
+enum
+{
+  kJsBinId        = 0x6a736e62, // 'jsnb'
+  kJsBinVersion   = 1,
+  kJsBinByteOrder = 0x01020304,
+  kJsBinAlign     = 8
+};
+
+typedef struct
+{
+  unsigned id;          // kJsBinId
+  unsigned version;     // kJsBinVersion
+  unsigned byteOrder;   // kJsBinByteOrder in the writer's byte order
+  unsigned nodeByteCnt; // sizeof(cmJsonNode_t) of the writer
+  unsigned ptrByteCnt;  // sizeof(void*) of the writer
+  unsigned nodeCnt;     // count of records in the node array
+  unsigned nodeOffs;    // offset to the node array
+  unsigned idxOffs;     // offset to the index area
+  unsigned strOffs;     // offset to the string table
+  unsigned byteCnt;     // total count of bytes in the image
+} cmJsBinHdr_t;
+
+// string intern table record
+typedef struct
+{
+  const char* s;     // string
+  unsigned    offs;  // offset of the string in the image string table
+} cmJsBinStr_t;
+
+// binary image writer state
+typedef struct
+{
+  char*         basePtr;     // image buffer
+  cmJsonNode_t* nodeV;       // node array in basePtr[]
+  unsigned      nodeCnt;     // count of nodes 
+  char*         idxPtr;      // next available location in the index area 
+  unsigned      idxByteCnt;  // size of the index area
+  cmJsBinStr_t* strV;        // open addressed intern table of unique strings
+  unsigned      strMask;     // count of strV[] elements - 1
+  unsigned      strCnt;      // count of unique strings
+  unsigned      strByteCnt;  // size of the string table
+} cmJsBinWr_t;
+
+unsigned _cmJsonBinAlign( unsigned n )
+{ return (n + kJsBinAlign - 1) & ~(kJsBinAlign - 1); }
+
+// Return the intern table record for 's'.
+cmJsBinStr_t* _cmJsonBinIntern( cmJsBinWr_t* w, const char* s )
+{
+  unsigned i,j;
+
+  // keep the table at least half empty
+  if( w->strV == NULL || 2*(w->strCnt+1) > w->strMask+1 )
+  {
+    unsigned      n  = w->strV == NULL ? 64 : 2*(w->strMask+1);
+    cmJsBinStr_t* sv = cmMemAllocZ(cmJsBinStr_t,n);
+
+    if( w->strV != NULL )
+      for(i=0; i<=w->strMask; ++i)
+        if( w->strV[i].s != NULL )
+        {
+          for(j=_cmJsonHashLabel(w->strV[i].s) & (n-1); sv[j].s != NULL; j=(j+1) & (n-1))
+          {}
+
+          sv[j] = w->strV[i];
+        }
+
+    cmMemFree(w->strV);
+    w->strV    = sv;
+    w->strMask = n-1;
+  }
+
+  for(j=_cmJsonHashLabel(s) & w->strMask; w->strV[j].s != NULL; j=(j+1) & w->strMask)
+    if( strcmp(s,w->strV[j].s) == 0 )
+      return w->strV + j;
+
+  w->strV[j].s   = s;
+  w->strByteCnt += strlen(s) + 1;
+  w->strCnt     += 1;
+  return w->strV + j;
+}
+
+// Count the nodes, size the index area and collect the unique strings of the subtree 'np'.
+void _cmJsonBinMeasure( cmJsBinWr_t* w, const cmJsonNode_t* np )
+{
+  const cmJsonNode_t* cnp;
+  unsigned            childCnt = 0;
+
+  w->nodeCnt += 1;
+
+  switch( np->typeId )
+  {
+    case kObjectTId:
+    case kArrayTId:
+    case kPairTId:
+      for(cnp=np->u.childPtr; cnp!=NULL; cnp=cnp->siblingPtr,++childCnt)
+        _cmJsonBinMeasure(w,cnp);
+
+      if( np->typeId != kPairTId && childCnt >= kJsonIndexMinChildCnt )
+        w->idxByteCnt += sizeof(cmJsonIdx_t) + (childCnt + _cmJsonIndexHashCount(np,childCnt)) * sizeof(cmJsonNode_t*);
+      break;
+
+    case kStringTId:
+      if( np->u.stringVal != NULL )
+        _cmJsonBinIntern(w,np->u.stringVal);
+      break;
+  }
+}
+
+// Copy the subtree 'sp' to the image node array and return the new node.
+cmJsonNode_t* _cmJsonBinWriteNode( cmJsBinWr_t* w, const cmJsonNode_t* sp, cmJsonNode_t* ownerPtr )
+{
+  cmJsonNode_t*       np = w->nodeV + w->nodeCnt++;
+  const cmJsonNode_t* scp;
+  cmJsonNode_t*       lastPtr  = NULL;
+  unsigned            childCnt = 0;
+
+  np->typeId     = sp->typeId;
+  np->ownerPtr   = ownerPtr;
+  np->siblingPtr = NULL;
+  np->u          = sp->u;
+  np->idxPtr     = NULL;
+
+  switch( sp->typeId )
+  {
+    case kObjectTId:
+    case kArrayTId:
+    case kPairTId:
+      np->u.childPtr = NULL;
+
+      for(scp=sp->u.childPtr; scp!=NULL; scp=scp->siblingPtr,++childCnt)
+      {
+        cmJsonNode_t* cnp = _cmJsonBinWriteNode(w,scp,np);
+
+        if( lastPtr == NULL )
+          np->u.childPtr = cnp;
+        else
+          lastPtr->siblingPtr = cnp;
+
+        lastPtr = cnp;
+      }
+
+      if( sp->typeId != kPairTId && childCnt >= kJsonIndexMinChildCnt )
+      {
+        unsigned hashCnt = _cmJsonIndexHashCount(np,childCnt);
+        _cmJsonFillIndex((cmJsonIdx_t*)w->idxPtr,np,childCnt,hashCnt);
+        w->idxPtr += sizeof(cmJsonIdx_t) + (childCnt+hashCnt) * sizeof(cmJsonNode_t*);
+      }
+      break;
+
+    case kStringTId:
+      if( sp->u.stringVal != NULL )
+        np->u.stringVal = w->basePtr + _cmJsonBinIntern(w,sp->u.stringVal)->offs;
+      break;
+  }
+
+  return np;
+}
+
+void* _cmJsonBinOffs( const char* basePtr, const void* ptr )
+{ return ptr == NULL ? NULL : (void*)((const char*)ptr - basePtr); }
+
+// Convert the links of the image nodes from pointers to offsets.
+void _cmJsonBinStoreLinks( char* basePtr, const cmJsBinHdr_t* hp )
+{
+  cmJsonNode_t* nodeV = (cmJsonNode_t*)(basePtr + hp->nodeOffs);
+  unsigned      i,j;
+
+  for(i=0; i<hp->nodeCnt; ++i)
+  {
+    cmJsonNode_t* np = nodeV + i;
+    cmJsonIdx_t*  ip = np->idxPtr;
+
+    if( ip != NULL )
+    {
+      for(j=0; j<ip->n; ++j)
+        ip->eleV[j] = _cmJsonBinOffs(basePtr,ip->eleV[j]);
+
+      if( ip->hashV != NULL )
+        for(j=0; j<=ip->hashMask; ++j)
+          ip->hashV[j] = _cmJsonBinOffs(basePtr,ip->hashV[j]);
+
+      ip->eleV   = _cmJsonBinOffs(basePtr,ip->eleV);
+      ip->hashV  = _cmJsonBinOffs(basePtr,ip->hashV);
+      np->idxPtr = _cmJsonBinOffs(basePtr,ip);
+    }
+
+    np->ownerPtr   = _cmJsonBinOffs(basePtr,np->ownerPtr);
+    np->siblingPtr = _cmJsonBinOffs(basePtr,np->siblingPtr);
+
+    switch( np->typeId )
+    {
+      case kObjectTId:
+      case kArrayTId:
+      case kPairTId:
+        np->u.childPtr = _cmJsonBinOffs(basePtr,np->u.childPtr);
+        break;
+
+      case kStringTId:
+        np->u.stringVal = _cmJsonBinOffs(basePtr,np->u.stringVal);
+        break;
+    }
+  }
+}
+
+// Convert the node link at *npRef from an offset to a pointer.
+// Return false if the offset does not refer to a record in the node array.
+bool _cmJsonBinLoadNodeLink( char* basePtr, const cmJsBinHdr_t* hp, cmJsonNode_t** npRef )
+{
+  uintptr_t offs = (uintptr_t)*npRef;
+
+  if( offs == 0 )
+    return true;
+
+  if( offs < hp->nodeOffs || (offs - hp->nodeOffs) % sizeof(cmJsonNode_t) != 0 || (offs - hp->nodeOffs) / sizeof(cmJsonNode_t) >= hp->nodeCnt )
+    return false;
+
+  *npRef = (cmJsonNode_t*)(basePtr + offs);
+  return true;
+}
+
+// Convert the index link of the object or array 'np' from an offset to a pointer.
+bool _cmJsonBinLoadIndex( char* basePtr, const cmJsBinHdr_t* hp, cmJsonNode_t* np )
+{
+  uintptr_t    offs = (uintptr_t)np->idxPtr;
+  cmJsonIdx_t* ip;
+  unsigned     hashCnt;
+  unsigned     usedCnt = 0;
+  unsigned     i;
+
+  if( offs < hp->idxOffs || offs % sizeof(void*) != 0 || offs + sizeof(cmJsonIdx_t) > hp->strOffs )
+    return false;
+
+  ip      = (cmJsonIdx_t*)(basePtr + offs);
+  hashCnt = np->typeId == kObjectTId ? ip->hashMask + 1 : 0;
+
+  // the vectors must directly follow the index record and fit in the index area
+  if( ip->n > hp->nodeCnt 
+    || (hashCnt & (hashCnt-1)) != 0 
+    || hashCnt > 4*hp->nodeCnt + 16 
+    || (uintptr_t)ip->eleV != offs + sizeof(cmJsonIdx_t)
+    || (uintptr_t)ip->hashV != (hashCnt==0 ? 0 : offs + sizeof(cmJsonIdx_t) + ip->n * sizeof(cmJsonNode_t*))
+    || offs + sizeof(cmJsonIdx_t) + ((unsigned long long)ip->n + hashCnt) * sizeof(cmJsonNode_t*) > hp->strOffs )
+    return false;
+
+  ip->eleV   = (cmJsonNode_t**)(ip+1);
+  ip->hashV  = hashCnt==0 ? NULL : ip->eleV + ip->n;
+  np->idxPtr = ip;
+
+  for(i=0; i<ip->n; ++i)
+    if( !_cmJsonBinLoadNodeLink(basePtr,hp,ip->eleV+i) || ip->eleV[i] == NULL || (hashCnt>0 && ip->eleV[i]->typeId != kPairTId) )
+      return false;
+
+  for(i=0; i<hashCnt; ++i)
+  {
+    if( !_cmJsonBinLoadNodeLink(basePtr,hp,ip->hashV+i) || (ip->hashV[i] != NULL && ip->hashV[i]->typeId != kPairTId) )
+      return false;
+
+    usedCnt += ip->hashV[i] != NULL;
+  }
+
+  // the hash table must have at least one empty slot to terminate a search
+  return hashCnt == 0 || usedCnt < hashCnt;
+}
+
+// Convert the links of the image nodes from offsets to pointers. Every link is
+// checked against the image section it must refer to so that a damaged
+// image cannot produce a pointer outside of the image.
+bool _cmJsonBinLoadLinks( char* basePtr, const cmJsBinHdr_t* hp )
+{
+  cmJsonNode_t* nodeV = (cmJsonNode_t*)(basePtr + hp->nodeOffs);
+  unsigned      i;
+
+  for(i=0; i<hp->nodeCnt; ++i)
+  {
+    cmJsonNode_t* np = nodeV + i;
+
+    if( !_cmJsonBinLoadNodeLink(basePtr,hp,&np->ownerPtr) || !_cmJsonBinLoadNodeLink(basePtr,hp,&np->siblingPtr) )
+      return false;
+
+    switch( np->typeId )
+    {
+      case kObjectTId:
+      case kArrayTId:
+        if( !_cmJsonBinLoadNodeLink(basePtr,hp,&np->u.childPtr) )
+          return false;
+        break;
+
+      case kPairTId:
+        // the first child of a pair is it's label
+        if( !_cmJsonBinLoadNodeLink(basePtr,hp,&np->u.childPtr) || np->u.childPtr == NULL || np->u.childPtr->typeId != kStringTId )
+          return false;
+        break;
 
-  *bufPtrPtr     = NULL;
-  *bufByteCntPtr = 0;
+      case kStringTId:
+        if( np->u.stringVal != NULL )
+        {
+          uintptr_t offs = (uintptr_t)np->u.stringVal;
 
-  if( np == NULL )
-    np = p->rootPtr;
-   
-  // validate the tree
-  if((rc = _cmJsonValidateNode(p,np,np->ownerPtr)) != kOkJsRC )
-    return rc;
+          // the image ends with a string terminator (see _cmJsonBinIsValidHdr())
+          if( offs < hp->strOffs || offs >= hp->byteCnt )
+            return false;
 
-  // increment the buffer size to include the buffer header
-  p->serialByteCnt = cmJsonSerialByteCount(np);
+          np->u.stringVal = basePtr + offs;
+        }
+        break;
 
-  // allocate the serial buffer memory
-  p->serialBufPtr  = cmMemResize( char, p->serialBufPtr, p->serialByteCnt );
+      case kIntTId:
+      case kRealTId:
+      case kNullTId:
+      case kTrueTId:
+      case kFalseTId:
+        break;
 
-  // serialize the tree
-  if((rc = cmJsonSerialize(np, p->serialBufPtr, p->serialByteCnt )) != kOkJsRC )
-    return rc;
+      default:
+        return false;
+    }
 
-  *bufPtrPtr     = p->serialBufPtr;
-  *bufByteCntPtr = p->serialByteCnt;
+    if( np->idxPtr != NULL )
+      if( (np->typeId != kObjectTId && np->typeId != kArrayTId) || !_cmJsonBinLoadIndex(basePtr,hp,np) )
+        return false;
+  }
 
-  return rc;
+  // the root must be the first node
+  return hp->nodeCnt == 0 || (nodeV[0].ownerPtr == NULL && nodeV[0].siblingPtr == NULL);
 }
 
-const void* _cmJsonDeserialAdv( cmJsDeserial_t* rp, unsigned n )
+bool _cmJsonBinIsValidHdr( const cmJsBinHdr_t* hp, unsigned long long byteCnt )
 {
-  const void* vp = rp->nextPtr;
-  rp->nextPtr += n;
-  assert(rp->nextPtr <= rp->endPtr);
-  assert(rp->nodeIdx <= rp->nodeCnt);
-  return vp;
+  return hp->id          == kJsBinId
+    &&   hp->version     == kJsBinVersion
+    &&   hp->byteOrder   == kJsBinByteOrder
+    &&   hp->nodeByteCnt == sizeof(cmJsonNode_t)
+    &&   hp->ptrByteCnt  == sizeof(void*)
+    &&   hp->byteCnt     == byteCnt
+    &&   hp->nodeOffs    >= sizeof(cmJsBinHdr_t)
+    &&   hp->nodeOffs    %  kJsBinAlign == 0
+    &&   hp->idxOffs     %  kJsBinAlign == 0
+    &&   hp->nodeOffs + (unsigned long long)hp->nodeCnt * sizeof(cmJsonNode_t) <= hp->idxOffs
+    &&   hp->idxOffs     <= hp->strOffs
+    &&   hp->strOffs     <= hp->byteCnt
+    &&   (hp->strOffs == hp->byteCnt || ((const char*)hp)[ hp->byteCnt-1 ] == 0);
 }
 
-int _cmJsonDeserialInt( cmJsDeserial_t* rp )
-{ return *(const int*)_cmJsonDeserialAdv(rp,sizeof(int)); }
+cmJsRC_t cmJsonWriteBin( cmJsonH_t h, const cmJsonNode_t* np, const cmChar_t* fn )
+{
+  cmJs_t*       p  = _cmJsonHandleToPtr(h);
+  cmJsRC_t      rc = kOkJsRC;
+  cmFileH_t     fh = cmFileNullHandle;
+  cmJsBinHdr_t* hp;
+  cmJsBinWr_t   w;
+  unsigned      i,offs;
 
-unsigned _cmJsonDeserialUint( cmJsDeserial_t* rp )
-{ return *(const unsigned*)_cmJsonDeserialAdv(rp,sizeof(unsigned)); }
+  if( np == NULL )
+    np = p->rootPtr;
 
-double _cmJsonDeserialReal( cmJsDeserial_t* rp )
-{ return *(const double*)_cmJsonDeserialAdv(rp,sizeof(double)); }
+  memset(&w,0,sizeof(w));
+
+  // count the nodes, size the index area and collect the unique strings
+  if( np != NULL )
+    _cmJsonBinMeasure(&w,np);
+
+  // allocate the image
+  unsigned nodeOffs = _cmJsonBinAlign(sizeof(cmJsBinHdr_t));
+  unsigned idxOffs  = _cmJsonBinAlign(nodeOffs + w.nodeCnt * sizeof(cmJsonNode_t));
+  unsigned strOffs  = idxOffs + w.idxByteCnt;
+  unsigned byteCnt  = strOffs + w.strByteCnt;
+
+  w.basePtr = cmMemAllocZ(char,byteCnt);
+  w.nodeV   = (cmJsonNode_t*)(w.basePtr + nodeOffs);
+  w.idxPtr  = w.basePtr + idxOffs;
+
+  hp              = (cmJsBinHdr_t*)w.basePtr;
+  hp->id          = kJsBinId;
+  hp->version     = kJsBinVersion;
+  hp->byteOrder   = kJsBinByteOrder;
+  hp->nodeByteCnt = sizeof(cmJsonNode_t);
+  hp->ptrByteCnt  = sizeof(void*);
+  hp->nodeCnt     = w.nodeCnt;
+  hp->nodeOffs    = nodeOffs;
+  hp->idxOffs     = idxOffs;
+  hp->strOffs     = strOffs;
+  hp->byteCnt     = byteCnt;
+
+  // fill the string table
+  for(i=0,offs=strOffs; w.strV!=NULL && i<=w.strMask; ++i)
+    if( w.strV[i].s != NULL )
+    {
+      unsigned n = strlen(w.strV[i].s) + 1;
+      memcpy(w.basePtr + offs, w.strV[i].s, n);
+      w.strV[i].offs = offs;
+      offs          += n;
+    }
 
+  // copy the nodes and build the indexes
+  w.nodeCnt = 0;
+  if( np != NULL )
+    _cmJsonBinWriteNode(&w,np,NULL);
 
-cmJsRC_t _cmJsonDeserializeNode( cmJs_t* p, cmJsonNode_t* parentPtr, cmJsDeserial_t* rp )
-{
-  cmJsRC_t      rc           = kOkJsRC;
-  unsigned      typeId       = _cmJsonDeserialUint(rp);
-  unsigned      childCnt     = 0;
-  cmJsonNode_t* newParentPtr = NULL;  
+  assert( w.nodeCnt == hp->nodeCnt && w.idxPtr == w.basePtr + strOffs );
 
-  rp->nodeIdx++;
-  
-  switch( typeId )
+  _cmJsonBinStoreLinks(w.basePtr,hp);
+
+  if( cmFileOpen(&fh,fn,kWriteFileFl | kBinaryFileFl,p->err.rpt) != kOkFileRC )
   {
-    case kPairTId:
-      rc       = _cmJsonCreateNode(p,parentPtr,typeId,&newParentPtr);
-      childCnt = 2;
-      break;
+    rc = _cmJsonError( p, kFileCreateErrJsRC, "Output file '%s' create failed.", cmStringNullGuard(fn) );
+    goto errLabel;
+  }
 
-    case kObjectTId:
-    case kArrayTId:
-      rc       = _cmJsonCreateNode(p,parentPtr,typeId,&newParentPtr);
-      childCnt = _cmJsonDeserialUint(rp);
-      break;
+  if( cmFileWrite(fh,w.basePtr,byteCnt) != kOkFileRC )
+  {
+    rc = _cmJsonError( p, kFileWriteErrJsRC, "Output file '%s' write failed.", fn );
+    goto errLabel;
+  }
+  
+ errLabel:
+  if( cmFileIsValid(fh) && cmFileClose(&fh) != kOkFileRC && rc == kOkJsRC )
+    rc = _cmJsonError( p, kFileCloseErrJsRC, "Output file '%s' close failed.", fn );
 
-    case kStringTId:
-      {
-        unsigned sn = strlen(rp->nextPtr);
-        rc =  _cmJsonCreateString( p, parentPtr, rp->nextPtr, sn,NULL);
-        _cmJsonDeserialAdv(rp,sn+1);
-      }
-      break;
+  cmMemFree(w.strV);
+  cmMemFree(w.basePtr);
+  return rc;
+}
 
-    case kIntTId: 
-      {
-        int v = _cmJsonDeserialInt(rp);
-        rc = _cmJsonCreateInt( p, parentPtr, v, NULL );
-      }
-      break;
+cmJsRC_t cmJsonMapBinFile( cmJsonH_t h, const char* fn )
+{
+  cmJs_t*             p      = _cmJsonHandleToPtr(h);
+  cmJsRC_t            rc     = kOkJsRC;
+  int                 fd     = -1;
+  char*               mapPtr = MAP_FAILED;
+  const cmJsBinHdr_t* hp;
+  struct stat         st;
 
-    case kRealTId:
-      {
-        double v = _cmJsonDeserialReal(rp);
-        rc = _cmJsonCreateReal( p, parentPtr, v, NULL );
-      }
-      break;
+  cmJsonClearTree(h);
 
-    case kNullTId:
-      rc = _cmJsonCreateNull( p, parentPtr, NULL );
-      break;
+  if((fd = open(fn,O_RDONLY)) == -1 )
+    return _cmJsonError(p,kFileOpenErrJsRC,"Unable to open the binary JSON file '%s'.",cmStringNullGuard(fn));
 
-    case kTrueTId:
-      rc = _cmJsonCreateBool( p, parentPtr, true, NULL );
-      break;
+  if( fstat(fd,&st) == -1 )
+  {
+    rc = _cmJsonError(p,kFileReadErrJsRC,"Unable to determine the size of the binary JSON file '%s'.",fn);
+    goto errLabel;
+  }
 
-    case kFalseTId:
-      rc = _cmJsonCreateBool( p, parentPtr, false, NULL );
-      break;
+  if( st.st_size < (off_t)sizeof(cmJsBinHdr_t) || (unsigned long long)st.st_size > UINT_MAX )
+  {
+    rc = _cmJsonError(p,kSerialErrJsRC,"'%s' is not a binary JSON file.",fn);
+    goto errLabel;
+  }
 
-    default:
-      assert(0);
-      break;
+  // the image is mapped private and writable so that the links can be converted in place
+  if((mapPtr = mmap(NULL,st.st_size,PROT_READ|PROT_WRITE,MAP_PRIVATE,fd,0)) == MAP_FAILED )
+  {
+    rc = _cmJsonError(p,kFileReadErrJsRC,"Memory mapping failed on the binary JSON file '%s'.",fn);
+    goto errLabel;
   }
 
-  if( rc != kOkJsRC )
-    return rc;
+  hp = (const cmJsBinHdr_t*)mapPtr;
 
-  // if the current node is a parent
-  if( childCnt > 0 )
+  if( !_cmJsonBinIsValidHdr(hp,st.st_size) )
   {
-    unsigned i;
-    assert( newParentPtr != NULL );
-    
-    for(i=0; i<childCnt; ++i)
-      if((rc= _cmJsonDeserializeNode( p, newParentPtr, rp )) != kOkJsRC )
-        return rc;
+    rc = _cmJsonError(p,kSerialErrJsRC,"'%s' is not a binary JSON file or was written by an incompatible version or platform.",fn);
+    goto errLabel;
+  }
+
+  if( !_cmJsonBinLoadLinks(mapPtr,hp) )
+  {
+    rc = _cmJsonError(p,kSerialErrJsRC,"The binary JSON file '%s' is corrupt.",fn);
+    goto errLabel;
   }
 
+  p->mapPtr     = mapPtr;
+  p->mapByteCnt = st.st_size;
+  p->rootPtr    = hp->nodeCnt == 0 ? NULL : (cmJsonNode_t*)(mapPtr + hp->nodeOffs);
+  p->modifiedFl = false;
+
+  close(fd);
+
   return rc;
 
+ errLabel:
+  if( mapPtr != MAP_FAILED )
+    munmap(mapPtr,st.st_size);
+
+  close(fd);
+
+  return rc;
 }
 
-cmJsRC_t _cmJsonDeserialize( cmJs_t* p, const void* vbuf, cmJsonNode_t* altRootPtr )
+cmJsRC_t cmJsonTextToBin( const cmChar_t* textFn, const cmChar_t* binFn, cmCtx_t* ctx )
 {
-  cmJsDeserial_t         r;
-  cmJsonNode_t*          rootPtr = altRootPtr == NULL ? p->rootPtr : altRootPtr;
-  const char*            buf     = (const char*)vbuf;
+  cmJsRC_t  rc;
+  cmJsonH_t h = cmJsonNullHandle;
 
-  memset(&r,0,sizeof(r));
+  if((rc = cmJsonInitializeFromFile(&h,textFn,ctx)) != kOkJsRC )
+    return rc;
 
-  r.nextPtr = buf;
-  r.endPtr  = buf + (4*sizeof(unsigned)); // the buf must at least contain a header
+  rc = cmJsonWriteBin(h,NULL,binFn);
 
-  // read the buffer header
-  unsigned hdrId   = _cmJsonDeserialUint(&r);
-  unsigned byteCnt = _cmJsonDeserialUint(&r);
-  r.nodeCnt        = _cmJsonDeserialUint(&r);
-  /*unsigned version =*/ _cmJsonDeserialUint(&r);
-  
-  if( hdrId != 'json' )
-    return _cmJsonError(p,kSerialErrJsRC,"The buffer does not have the correct header.");
+  cmJsonFinalize(&h);
 
-  if( byteCnt < (4*sizeof(unsigned)) )
-    return _cmJsonError(p,kSerialErrJsRC,"The buffer is too small to be contain any information.");
+  return rc;
+}
 
-  // change the buffer end pointer to the correct size based
-  // on the the byte count stored in the buffer
-  r.endPtr = buf + byteCnt + (2*sizeof(unsigned));
+cmJsRC_t cmJsonBinToText( const cmChar_t* binFn,  const cmChar_t* textFn, cmCtx_t* ctx )
+{
+  cmJsRC_t  rc;
+  cmJsonH_t h = cmJsonNullHandle;
 
-  return _cmJsonDeserializeNode(p, rootPtr, &r );   
+  if((rc = cmJsonInitializeFromBinFile(&h,binFn,ctx)) != kOkJsRC )
+    return rc;
 
-} 
+  rc = cmJsonWrite(h,NULL,textFn);
 
-cmJsRC_t      cmJsonDeserialize( cmJsonH_t h, const void* bufPtr, cmJsonNode_t* altRootPtr )
-{
-  cmJs_t* p = _cmJsonHandleToPtr(h);
-  return _cmJsonDeserialize(p,bufPtr,altRootPtr);
+  cmJsonFinalize(&h);
+
+  return rc;
 }
 
 cmJsRC_t      cmJsonLeafToString( const cmJsonNode_t* np, cmChar_t* buf, unsigned bufCharCnt )
@@ -3991,6 +5116,187 @@ void _cmJsonTestPrint( void* userPtr, const cmChar_t* text )
   fputs(text,stdout);
 }
 
+cmJsRC_t cmJsonBench( const char* fn, unsigned iterCnt, cmCtx_t* ctx )
+{
+  cmJsRC_t     rc        = kOkJsRC;
+  cmJsonH_t    h         = cmJsonNullHandle;
+  cmRpt_t*     rpt       = &ctx->rpt;
+  char*        buf       = NULL;
+  unsigned     bufN      = 0;
+  unsigned     fileUs    = 0;
+  unsigned     bufUs     = 0;
+  unsigned     lookupUs  = 0;
+  unsigned     lookupCnt = 0;
+  unsigned     i,j;
+  cmTimeSpec_t t0,t1;
+
+  if( iterCnt == 0 )
+    iterCnt = 1;
+
+  if((buf = cmFileFnToStr(fn,rpt,&bufN)) == NULL )
+    return cmErrMsg(&ctx->err,kFileReadErrJsRC,"Unable to read the JSON file '%s'.",cmStringNullGuard(fn));
+
+  for(i=0; i<iterCnt; ++i)
+  {
+    // parse from the file
+    cmTimeGetMonotonic(&t0);
+
+    if((rc = cmJsonInitializeFromFile(&h,fn,ctx)) != kOkJsRC )
+      goto errLabel;
+
+    cmTimeGetMonotonic(&t1);
+    fileUs += cmTimeElapsedMicros(&t0,&t1);
+
+    cmJsonFinalize(&h);
+
+    // parse from memory
+    cmTimeGetMonotonic(&t0);
+
+    if((rc = cmJsonInitializeFromBuf(&h,ctx,buf,bufN)) != kOkJsRC )
+      goto errLabel;
+
+    cmTimeGetMonotonic(&t1);
+    bufUs += cmTimeElapsedMicros(&t0,&t1);
+
+    // look up each member of the root object by label
+    const cmJsonNode_t* rp = cmJsonRoot(h);
+    if( rp != NULL && cmJsonIsObject(rp) )
+    {
+      unsigned n = cmJsonChildCount(rp);
+
+      cmTimeGetMonotonic(&t0);
+
+      for(j=0; j<n; ++j)
+      {
+        const char* label = cmJsonPairLabel(cmJsonArrayElementC(rp,j));
+        if( label != NULL && cmJsonFindPair(rp,label) == NULL )
+          cmRptPrintf(rpt,"Member '%s' lookup failed.\n",label);
+      }
+
+      cmTimeGetMonotonic(&t1);
+      lookupUs  += cmTimeElapsedMicros(&t0,&t1);
+      lookupCnt += n;
+    }
+
+    cmJsonFinalize(&h);
+  }
+
+  // bytes per microsecond is equal to megabytes per second
+  cmRptPrintf(rpt,"%s : %i bytes %i iterations\n",fn,bufN,iterCnt);
+  cmRptPrintf(rpt,"file:   %10.3f ms/parse %10.2f MB/s\n",fileUs/1000.0/iterCnt, fileUs==0 ? 0.0 : (double)bufN*iterCnt/fileUs);
+  cmRptPrintf(rpt,"buffer: %10.3f ms/parse %10.2f MB/s\n",bufUs/1000.0/iterCnt,  bufUs==0  ? 0.0 : (double)bufN*iterCnt/bufUs);
+
+  if( lookupCnt > 0 )
+    cmRptPrintf(rpt,"lookup: %10.3f us/member (%i root members)\n",(double)lookupUs/lookupCnt,lookupCnt/iterCnt);
+  
+ errLabel:
+  cmJsonFinalize(&h);
+  cmMemFree(buf);
+  return rc;
+}
+
+// Return true if the subtrees 'ap' and 'bp' have the same structure and values.
+bool _cmJsonIsEqualTree( const cmJsonNode_t* ap, const cmJsonNode_t* bp )
+{
+  if( ap == NULL || bp == NULL )
+    return ap == bp;
+
+  if( ap->typeId != bp->typeId )
+    return false;
+
+  switch( ap->typeId )
+  {
+    case kObjectTId:
+    case kArrayTId:
+    case kPairTId:
+      for(ap=ap->u.childPtr,bp=bp->u.childPtr; ap!=NULL && bp!=NULL; ap=ap->siblingPtr,bp=bp->siblingPtr)
+        if( !_cmJsonIsEqualTree(ap,bp) )
+          return false;
+      return ap == bp;
+
+    case kStringTId:
+      return strcmp(ap->u.stringVal==NULL ? "" : ap->u.stringVal, bp->u.stringVal==NULL ? "" : bp->u.stringVal) == 0;
+
+    case kIntTId:
+      return ap->u.intVal == bp->u.intVal;
+
+    case kRealTId:
+      return ap->u.realVal == bp->u.realVal;
+  }
+
+  return true;
+}
+
+cmJsRC_t cmJsonBinBench( const char* textFn, const char* binFn, unsigned iterCnt, cmCtx_t* ctx )
+{
+  cmJsRC_t     rc      = kOkJsRC;
+  cmJsonH_t    th      = cmJsonNullHandle;
+  cmJsonH_t    bh      = cmJsonNullHandle;
+  cmRpt_t*     rpt     = &ctx->rpt;
+  unsigned     textN   = 0;
+  unsigned     binN    = 0;
+  unsigned     textUs  = 0;
+  unsigned     binUs   = 0;
+  unsigned     i;
+  cmTimeSpec_t t0,t1;
+
+  if( iterCnt == 0 )
+    iterCnt = 1;
+
+  if((rc = cmJsonTextToBin(textFn,binFn,ctx)) != kOkJsRC )
+    return rc;
+
+  // verify the binary image against the text file
+  if((rc = cmJsonInitializeFromFile(&th,textFn,ctx)) != kOkJsRC )
+    goto errLabel;
+
+  if((rc = cmJsonInitializeFromBinFile(&bh,binFn,ctx)) != kOkJsRC )
+    goto errLabel;
+
+  if( !_cmJsonIsEqualTree(cmJsonRoot(th),cmJsonRoot(bh)) )
+  {
+    rc = cmErrMsg(&ctx->err,kSerialErrJsRC,"The tree loaded from '%s' does not match the tree parsed from '%s'.",binFn,textFn);
+    goto errLabel;
+  }
+
+  cmJsonFinalize(&th);
+  cmJsonFinalize(&bh);
+
+  for(i=0; i<iterCnt; ++i)
+  {
+    cmTimeGetMonotonic(&t0);
+
+    if((rc = cmJsonInitializeFromFile(&th,textFn,ctx)) != kOkJsRC )
+      goto errLabel;
+
+    cmTimeGetMonotonic(&t1);
+    textUs += cmTimeElapsedMicros(&t0,&t1);
+
+    cmJsonFinalize(&th);
+
+    cmTimeGetMonotonic(&t0);
+
+    if((rc = cmJsonInitializeFromBinFile(&bh,binFn,ctx)) != kOkJsRC )
+      goto errLabel;
+
+    cmTimeGetMonotonic(&t1);
+    binUs += cmTimeElapsedMicros(&t0,&t1);
+
+    cmJsonFinalize(&bh);
+  }
+
+  cmFileByteCountFn(textFn,rpt,&textN);
+  cmFileByteCountFn(binFn,rpt,&binN);
+
+  cmRptPrintf(rpt,"%s : %i bytes  %s : %i bytes  %i iterations\n",textFn,textN,binFn,binN,iterCnt);
+  cmRptPrintf(rpt,"text:   %10.3f ms/load\n",textUs/1000.0/iterCnt);
+  cmRptPrintf(rpt,"binary: %10.3f ms/load %10.2f x\n",binUs/1000.0/iterCnt, binUs==0 ? 0.0 : (double)textUs/binUs);
+
+ errLabel:
+  cmJsonFinalize(&th);
+  cmJsonFinalize(&bh);
+  return rc;
+}
 
 //( { label:cmJsonEx }
 //
@@ -4078,3 +5384,4 @@ cmJsRC_t cmJsonTest( const char* fn, cmCtx_t* ctx )
   return rc == kOkJsRC ? rc1 : rc;
 }
 //)
+
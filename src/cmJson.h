@@ -15,10 +15,6 @@ extern "C" {
   //  1. Accpets two digit hex sequences with 
   //  the \\u escape command. JSON specifies 4 digits.
   //
-  //  2. The scientific notation for real numbers is limited to
-  //  exponent prefixes: e,E,e-,E-. The prefixes e+ and E+ are
-  //  not recognized by cmLex.
-  //
   //  Extensions:
   //
   //  1. Will accept C style identifiers where JSON demands 
@@ -26,6 +22,31 @@ extern "C" {
   //
   //  2. Will accept C style hex notation (0xddd)  for integer values.
   //
+  //  3. Will accept C and C++ style comments.
+  //
+  //  Performance:
+  //
+  //  The parser scans the text in a single pass and builds the node
+  //  tree directly in the internal linked heap. Objects and arrays
+  //  read by the parser which have kJsonIndexMinChildCnt or more children
+  //  are given an index which makes cmJsonArrayElement(), cmJsonMemberAtIndex(),
+  //  cmJsonChildCount() and the member lookup functions (cmJsonFindPair(),
+  //  cmJsonXXXMember(), cmJsonMemberValues(), cmJsonPathValues())
+  //  constant time operations. The index is released when the
+  //  container is changed by any of the functions in this interface.
+  //  Code which links or unlinks nodes directly must set the container's
+  //  'idxPtr' to NULL.
+  //
+  //  Binary images:
+  //
+  //  cmJsonWriteBin() writes a tree as a binary image which cmJsonMapBinFile()
+  //  can memory map and use directly as the internal tree. The image holds the
+  //  nodes in their native cmJsonNode_t format along with the indexes of the
+  //  large objects and arrays and a table of unique strings. All links in the
+  //  image are stored as offsets from the start of the image and are converted
+  //  to pointers in a single pass when the image is loaded. Images are specific
+  //  to the pointer size and byte order of the machine which wrote them.
+  //
   //)
 
   //(
@@ -73,8 +94,12 @@ extern "C" {
     kInvalidNodeTypeJsRC,
     kValidateFailJsRC,
     kCsvErrJsRC,
-    kBufTooSmallJsRC
+    kBufTooSmallJsRC,
+    kFileWriteErrJsRC
   };
+
+  // Objects and arrays with at least this many children are indexed by the parser.
+  enum { kJsonIndexMinChildCnt = 8 };
  
   typedef unsigned cmJsRC_t;
 
@@ -101,6 +126,8 @@ extern "C" {
       bool                   boolVal;    // valid if typeId == kTrueTId || kFalseTId
     } u;
 
+    struct cmJsonIdx_str*  idxPtr;      // object/array child index (internal - may be NULL)
+
   } cmJsonNode_t;
 
   extern cmJsonH_t cmJsonNullHandle;
@@ -114,6 +141,9 @@ extern "C" {
   // Equivalent to cmJsonInitialize() followed by cmJsonParse(h,buf,cnt,NULL).
   cmJsRC_t      cmJsonInitializeFromBuf( cmJsonH_t* hp, cmCtx_t* ctx, const char* buf, unsigned bufByteCnt );
 
+  // Equivalent to cmJsonInitialize() followed by cmJsonMapBinFile().
+  cmJsRC_t      cmJsonInitializeFromBinFile( cmJsonH_t* hp, const char* fn, cmCtx_t* ctx );
+
   // Release all the resources held by the tree.
   cmJsRC_t      cmJsonFinalize(   cmJsonH_t* hp );
 
@@ -140,6 +170,14 @@ extern "C" {
   // Return the root node of the internal tree.
   cmJsonNode_t* cmJsonRoot(       cmJsonH_t h );
 
+  // Replace the internal tree with the tree held in the binary image
+  // file 'fn' (see cmJsonWriteBin()). The file is mapped privately into
+  // memory and the nodes are used in place. The tree may be changed
+  // with the functions in this interface however the changes are never
+  // written back to the file. The image is released by cmJsonClearTree()
+  // and cmJsonFinalize().
+  cmJsRC_t      cmJsonMapBinFile( cmJsonH_t h, const char* fn );
+
   // Return the tree to the post initialize state by clearing the  internal tree.
   cmJsRC_t      cmJsonClearTree(      cmJsonH_t h );
 
@@ -474,6 +512,14 @@ extern "C" {
   // or object node.
   cmJsRC_t      cmJsonDeserialize( cmJsonH_t h, const void* bufPtr, cmJsonNode_t* altRootPtr );
 
+  // Write the subtree indicated by 'np', or the entire tree if 'np' is NULL,
+  // to the binary image file 'fn'. Use cmJsonMapBinFile() to load the image.
+  cmJsRC_t      cmJsonWriteBin( cmJsonH_t h, const cmJsonNode_t* np, const cmChar_t* fn );
+
+  // Convert a JSON text file to a binary image file and vice versa.
+  cmJsRC_t      cmJsonTextToBin( const cmChar_t* textFn, const cmChar_t* binFn, cmCtx_t* ctx );
+  cmJsRC_t      cmJsonBinToText( const cmChar_t* binFn,  const cmChar_t* textFn, cmCtx_t* ctx );
+
   // Return a string/int/real/null/bool node as a string value.
   cmJsRC_t      cmJsonLeafToString( const cmJsonNode_t* np, cmChar_t* buf, unsigned bufCharCnt );
   
@@ -512,6 +558,15 @@ extern "C" {
   // Testing stub.
   cmJsRC_t      cmJsonTest( const char* fn, cmCtx_t* ctx );
 
+  // Parse 'fn' 'iterCnt' times from the file and from a memory buffer and
+  // report the parse throughput and the member lookup time of the root object.
+  cmJsRC_t      cmJsonBench( const char* fn, unsigned iterCnt, cmCtx_t* ctx );
+
+  // Convert the text file 'textFn' to the binary image file 'binFn', verify
+  // that both files produce the same tree and compare the time required to
+  // parse the text file with the time required to load the binary image.
+  cmJsRC_t      cmJsonBinBench( const char* textFn, const char* binFn, unsigned iterCnt, cmCtx_t* ctx );
+
   //)
 
 #ifdef __cplusplus
@@ -8,6 +8,8 @@
 #include "cmMem.h"
 #include "cmLinkedHeap.h"
 #include "cmMallocDebug.h"
+#include "cmThread.h"
+#include <pthread.h>
 
 typedef struct cmLhBlock_str
 {
@@ -19,12 +21,76 @@ typedef struct cmLhBlock_str
   unsigned              freeCnt;     // track orphaned space that is unavailable for reuse
 } cmLhBlock_t;
 
+//-----------------------------------------------------------------------------
+// Realtime arena
+//
+
+enum
+{
+  kRtClassLhCnt     = 10,       // count of size classes (see _cmLhRtClassByteCnt[])
+  kRtMaxThreadLhCnt = 16,       // max. count of threads with a private bump region
+  kRtChunkLhByteCnt = 4096,     // bytes claimed from the arena by a thread at a time
+  kRtAlignLhByteCnt = 16,       // alignment of all arena allocations (also the header size)
+
+  kEmptyLhThId = 0,             // cmLhRtThread_t.stateId values
+  kAllocLhThId,
+  kReadyLhThId
+};
+
+// Data byte counts of the size classes. cmDspCb_t records (40 bytes) use the 48 byte class and
+// cmDspValue_t records (24 bytes) use the 32 byte class.
+static const unsigned _cmLhRtClassByteCnt[ kRtClassLhCnt ] = { 16, 32, 48, 64, 96, 128, 256, 512, 1024, 2048 };
+
+// Header stored in front of each arena allocation.
+typedef struct
+{
+  unsigned byteCnt;  // data byte count of this allocation (class size or requested size rounded up to the alignment)
+  unsigned classIdx; // size class index or cmInvalidIdx if the allocation is not in a size class
+  unsigned pad[2];   // pad the header to kRtAlignLhByteCnt bytes
+} cmLhRtHdr_t;
+
+// Free list node. Overlays the data area of a released allocation.
+typedef struct cmLhRtFree_str
+{
+  struct cmLhRtFree_str* link;
+} cmLhRtFree_t;
+
+// Per-thread allocation state. Only the owning thread accesses nextPtr, endPtr and freeList[].
 typedef struct
 {
+  volatile unsigned stateId;                   // see kXXXLhThId
+  pthread_t         id;                        // owning thread as returned from pthread_self()
+  char*             nextPtr;                   // next avail location in the threads current chunk
+  char*             endPtr;                    // one past the end of the threads current chunk
+  cmLhRtFree_t*     freeList[ kRtClassLhCnt ]; // released allocations available for reuse
+} cmLhRtThread_t;
+
+typedef struct
+{
+  char*             basePtr;                     // base of the arena
+  unsigned          byteCnt;                     // size of the arena
+  volatile unsigned offs;                        // next avail offset in the arena
+  cmLhRtThread_t    thArray[ kRtMaxThreadLhCnt ];
+  volatile unsigned thCnt;                       // count of records claimed in thArray[]
+  cmLhRtFree_t*     sharedList[ kRtClassLhCnt ]; // allocations released by threads without a thArray[] record
+} cmLhRt_t;
+
+typedef struct
+{
+  cmErr_t       err;
   unsigned      dfltBlockByteCnt; // size of each block in chain
   cmLhBlock_t*  first;            // first block in chain
   cmLhBlock_t*  last;             // last block in chain
   cmMmH_t       mmH;
+  cmLhRt_t*     rt;               // realtime arena or NULL if this is not a realtime heap
+
+  // usage counters (see cmLHeapStats_t)
+  volatile unsigned blockByteCnt;
+  volatile unsigned blockHwmByteCnt;
+  volatile unsigned liveByteCnt;
+  volatile unsigned liveHwmByteCnt;
+  volatile unsigned allocCnt;
+  volatile unsigned failCnt;
 } cmLHeap_t;
 
 cmLHeapH_t cmLHeapNullHandle = { NULL };
@@ -36,6 +102,22 @@ cmLHeap_t* _cmLHeapHandleToPtr( cmLHeapH_t h )
   return lhp;
 }
 
+// Atomically set *hwmPtr to the max. of *hwmPtr and val.
+void _cmLHeapUpdateHwm( volatile unsigned* hwmPtr, unsigned val )
+{
+  unsigned v;
+  while( (v = *hwmPtr) < val )
+    if( cmThUIntCAS((unsigned*)hwmPtr,v,val) )
+      break;
+}
+
+void _cmLHeapIncrLive( cmLHeap_t* lhp, unsigned byteCnt )
+{
+  cmThUIntIncr((unsigned*)&lhp->allocCnt,1);
+  cmThUIntIncr((unsigned*)&lhp->liveByteCnt,byteCnt);
+  _cmLHeapUpdateHwm(&lhp->liveHwmByteCnt,lhp->liveByteCnt);
+}
+
 cmLhBlock_t* _cmLHeapAllocBlock( cmLHeap_t* lhp, unsigned blockByteCnt )
 {
   // note: the entire block (control record and data space) is allocated
@@ -61,6 +143,9 @@ cmLhBlock_t* _cmLHeapAllocBlock( cmLHeap_t* lhp, unsigned blockByteCnt )
 
   lhp->last = lbp;
 
+  lhp->blockByteCnt += blockByteCnt;
+  _cmLHeapUpdateHwm(&lhp->blockHwmByteCnt,lhp->blockByteCnt);
+
   return lbp;
 }
 
@@ -91,6 +176,8 @@ void*      _cmLHeapAlloc(  cmLHeap_t* lhp, unsigned dataByteCnt )
   
   lbp->nextPtr += allocByteCnt;
 
+  _cmLHeapIncrLive(lhp,allocByteCnt);
+
   return retPtr;
 }
 
@@ -138,6 +225,8 @@ bool     _cmLHeapFree(    cmLHeap_t* lhp, void* dataPtr )
   unsigned* allocPtr     = ((unsigned*)dataPtr)-1;
   unsigned  dataByteCnt  = *allocPtr - sizeof(unsigned);
 
+  lhp->liveByteCnt -= *allocPtr;
+
   // the data to be freed is at the end of the blocks space ...
   if( dataPtr == lbp->nextPtr - dataByteCnt )
     lbp->nextPtr = (char*)allocPtr; // ... then make it the space to alloc
@@ -162,11 +251,246 @@ bool  _cmLHeapFreeCb(void* funcArgPtr, void* ptr)
 }
 
 
+// Claim byteCnt bytes from the arena. Returns NULL if the arena is exhausted.
+char* _cmLhRtArenaAlloc( cmLHeap_t* lhp, unsigned byteCnt )
+{
+  cmLhRt_t* rt = lhp->rt;
+  unsigned  offs;
+
+  do
+  {
+    offs = rt->offs;
+    
+    if( byteCnt > rt->byteCnt - offs )
+      return NULL;
+    
+  }while( !cmThUIntCAS((unsigned*)&rt->offs, offs, offs + byteCnt ) );
+
+  _cmLHeapUpdateHwm(&lhp->blockHwmByteCnt, offs + byteCnt );
+
+  return rt->basePtr + offs;
+}
+
+// Return the thread record for the calling thread - claiming a record if necessary.
+// Returns NULL if all kRtMaxThreadLhCnt records have been claimed by other threads.
+cmLhRtThread_t* _cmLhRtThread( cmLhRt_t* rt )
+{
+  pthread_t id = pthread_self();
+  unsigned  i,n;
+
+  for(i=0; i<rt->thCnt; ++i)
+    if( rt->thArray[i].stateId == kReadyLhThId && pthread_equal(rt->thArray[i].id,id) )
+      return rt->thArray + i;
+
+  // claim the next empty record
+  do
+  {
+    if((n = rt->thCnt) >= kRtMaxThreadLhCnt )
+      return NULL;
+  }while( !cmThUIntCAS((unsigned*)&rt->thCnt,n,n+1) );
+
+  cmLhRtThread_t* tp = rt->thArray + n;
+  tp->stateId = kAllocLhThId;
+  tp->id      = id;
+  tp->nextPtr = NULL;
+  tp->endPtr  = NULL;
+  memset(tp->freeList,0,sizeof(tp->freeList));
+  
+  __sync_synchronize();
+  tp->stateId = kReadyLhThId;
+  return tp;
+}
+
+unsigned _cmLhRtClassIndex( unsigned byteCnt )
+{
+  unsigned i;
+  for(i=0; i<kRtClassLhCnt; ++i)
+    if( byteCnt <= _cmLhRtClassByteCnt[i] )
+      return i;
+  return cmInvalidIdx;
+}
+
+void* _cmLhRtAlloc( cmLHeap_t* lhp, unsigned dataByteCnt )
+{
+  cmLhRt_t*       rt       = lhp->rt;
+  cmLhRtThread_t* tp       = _cmLhRtThread(rt);
+  unsigned        classIdx = _cmLhRtClassIndex(dataByteCnt);
+  cmLhRtHdr_t*    hp       = NULL;
+  unsigned        byteCnt;
+  
+  if( classIdx != cmInvalidIdx )
+  {
+    byteCnt = _cmLhRtClassByteCnt[classIdx];
+
+    if( tp != NULL )
+    {
+      // if the threads free list is empty then take the entire shared free list
+      if( tp->freeList[classIdx] == NULL )
+      {
+        cmLhRtFree_t* fp;
+        do
+        {
+          fp = rt->sharedList[classIdx];
+        }while( fp != NULL && !cmThPtrCAS(&rt->sharedList[classIdx],fp,NULL) );
+
+        tp->freeList[classIdx] = fp;
+      }
+
+      // reuse a released allocation
+      if( tp->freeList[classIdx] != NULL )
+      {
+        cmLhRtFree_t* fp       = tp->freeList[classIdx];
+        tp->freeList[classIdx] = fp->link;
+        hp                     = ((cmLhRtHdr_t*)fp) - 1;
+      }
+    }
+  }
+  else
+  {
+    byteCnt = ((dataByteCnt + kRtAlignLhByteCnt - 1) / kRtAlignLhByteCnt) * kRtAlignLhByteCnt;
+  }
+
+  if( hp == NULL )
+  {
+    unsigned allocByteCnt = sizeof(cmLhRtHdr_t) + byteCnt;
+    
+    // threads without a private region and large allocations use the arena directly
+    if( tp == NULL || allocByteCnt > kRtChunkLhByteCnt/4 )
+      hp = (cmLhRtHdr_t*)_cmLhRtArenaAlloc(lhp,allocByteCnt);
+    else
+    {
+      // if the threads current chunk is full then claim a new chunk
+      if( tp->endPtr - tp->nextPtr < allocByteCnt )
+      {
+        char* cp;
+        if((cp = _cmLhRtArenaAlloc(lhp,kRtChunkLhByteCnt)) != NULL )
+        {
+          tp->nextPtr = cp;
+          tp->endPtr  = cp + kRtChunkLhByteCnt;
+        }
+      }
+
+      if( tp->endPtr - tp->nextPtr >= allocByteCnt )
+      {
+        hp           = (cmLhRtHdr_t*)tp->nextPtr;
+        tp->nextPtr += allocByteCnt;
+      }
+    }
+
+    if( hp == NULL )
+    {
+      // the arena is exhausted - realtime heaps never fall back to the system heap
+      cmThUIntIncr((unsigned*)&lhp->failCnt,1);
+      cmErrSetRC(&lhp->err,kArenaExhaustedLHeapRC);
+      return NULL;
+    }
+
+    hp->byteCnt  = byteCnt;
+    hp->classIdx = classIdx;
+  }
+
+  _cmLHeapIncrLive(lhp,byteCnt);
+
+  return hp + 1;
+}
+
+void _cmLhRtFree( cmLHeap_t* lhp, void* dataPtr )
+{
+  cmLhRt_t*     rt = lhp->rt;
+  cmLhRtHdr_t*  hp = ((cmLhRtHdr_t*)dataPtr) - 1;
+  cmLhRtFree_t* fp = (cmLhRtFree_t*)dataPtr;
+
+  cmThUIntDecr((unsigned*)&lhp->liveByteCnt,hp->byteCnt);
+
+  // allocations which are not in a size class are only reclaimed
+  // when they are at the end of the arena or the calling threads chunk
+  if( hp->classIdx == cmInvalidIdx )
+  {
+    unsigned        allocByteCnt = sizeof(cmLhRtHdr_t) + hp->byteCnt;
+    unsigned        offs         = (char*)hp - rt->basePtr;
+    cmLhRtThread_t* tp;
+    
+    if( cmThUIntCAS((unsigned*)&rt->offs, offs + allocByteCnt, offs ) )
+      return;
+
+    if((tp = _cmLhRtThread(rt)) != NULL && tp->nextPtr == (char*)hp + allocByteCnt )
+      tp->nextPtr = (char*)hp;
+    
+    return;
+  }
+
+  cmLhRtThread_t* tp = _cmLhRtThread(rt);
+
+  if( tp != NULL )
+  {
+    fp->link                   = tp->freeList[hp->classIdx];
+    tp->freeList[hp->classIdx] = fp;
+  }
+  else
+  {
+    // push onto the shared free list - this list is only ever emptied
+    // as a whole (see _cmLhRtAlloc()) which avoids the ABA problem
+    do
+    {
+      fp->link = rt->sharedList[hp->classIdx];
+    }while( !cmThPtrCAS(&rt->sharedList[hp->classIdx],fp->link,fp) );
+  }
+}
+
+void* _cmLhRtAllocate( cmLHeap_t* lhp, void* orgDataPtr, unsigned eleCnt, unsigned eleByteCnt, unsigned flags )
+{
+  unsigned byteCnt = eleCnt * eleByteCnt;
+  char*    dp;
+
+  // shrinking (or not growing beyond the existing allocation) is done in place
+  if( orgDataPtr != NULL && byteCnt <= (((cmLhRtHdr_t*)orgDataPtr)-1)->byteCnt )
+    return orgDataPtr;
+  
+  if((dp = _cmLhRtAlloc(lhp,byteCnt)) == NULL )
+    return NULL;
+
+  unsigned orgByteCnt = 0;
+
+  if( orgDataPtr != NULL )
+  {
+    orgByteCnt = cmMin(byteCnt,(((cmLhRtHdr_t*)orgDataPtr)-1)->byteCnt);
+    memcpy(dp,orgDataPtr,orgByteCnt);
+    _cmLhRtFree(lhp,orgDataPtr);
+  }
+
+  if( cmIsFlag(flags,kZeroMmFl) )
+    memset(dp + orgByteCnt, 0, byteCnt - orgByteCnt );
+
+  return dp;
+}
+
+void _cmLhRtClear( cmLHeap_t* lhp )
+{
+  cmLhRt_t* rt = lhp->rt;
+  unsigned  i;
+
+  rt->offs = 0;
+  memset(rt->sharedList,0,sizeof(rt->sharedList));
+
+  for(i=0; i<rt->thCnt; ++i)
+  {
+    cmLhRtThread_t* tp = rt->thArray + i;
+    tp->nextPtr = NULL;
+    tp->endPtr  = NULL;
+    memset(tp->freeList,0,sizeof(tp->freeList));
+  }
+
+  lhp->liveByteCnt = 0;
+}
+
+
 cmLHeapH_t cmLHeapCreate( unsigned dfltBlockByteCnt, cmCtx_t* ctx )
 {
   cmLHeapH_t h;
   cmLHeap_t* lhp = cmMemAllocZ( cmLHeap_t, 1 );
 
+  cmErrSetup(&lhp->err,&ctx->rpt,"Linked Heap");
+
   // We are not going to defer freeing each allocation  because it will result in using 
   // a lot of memory.  Commenting out this line however would result in
   // checking all allocations for corruption during cmLHeapDestroy().
@@ -186,6 +510,34 @@ cmLHeapH_t cmLHeapCreate( unsigned dfltBlockByteCnt, cmCtx_t* ctx )
   return h;
 }
 
+cmLHeapH_t cmLHeapCreateRt( unsigned arenaByteCnt, cmCtx_t* ctx )
+{
+  cmLHeapH_t h;
+  cmLHeap_t* lhp = cmMemAllocZ( cmLHeap_t, 1 );
+
+  cmErrSetup(&lhp->err,&ctx->rpt,"Linked Heap");
+
+  lhp->rt               = cmMemAllocZ( cmLhRt_t, 1 );
+  lhp->dfltBlockByteCnt = arenaByteCnt;
+  lhp->blockByteCnt     = arenaByteCnt;
+  
+  if((lhp->rt->basePtr = (char*)cmMemMalloc(arenaByteCnt)) == NULL )
+  {
+    cmErrMsg(&lhp->err,kArenaExhaustedLHeapRC,"The realtime arena allocation of %i bytes failed.",arenaByteCnt);
+    cmMemFree(lhp->rt);
+    cmMemFree(lhp);
+    return cmLHeapNullHandle;
+  }
+  
+  // touch every page of the arena so the first use on the realtime thread does not fault
+  memset(lhp->rt->basePtr,0,arenaByteCnt);
+
+  lhp->rt->byteCnt = arenaByteCnt;
+
+  h.h = lhp;
+  return h;
+}
+
 void cmLHeapDestroy( cmLHeapH_t* hp )
 {
   if( hp==NULL || hp->h == NULL )
@@ -193,6 +545,14 @@ void cmLHeapDestroy( cmLHeapH_t* hp )
 
   cmLHeap_t* lhp = _cmLHeapHandleToPtr(*hp);
 
+  if( lhp->rt != NULL )
+  {
+    cmMemFree(lhp->rt->basePtr);
+    cmMemFree(lhp->rt);
+    cmMemPtrFree(&hp->h);
+    return;
+  }
+
   // check for corruption
   if( cmIsFlag(cmMmInitializeFlags(lhp->mmH),kDeferFreeMmFl))
     cmMmReport(lhp->mmH, kSuppressSummaryMmFl | kIgnoreLeaksMmFl | kIgnoreNormalMmFl );
@@ -214,7 +574,14 @@ void cmLHeapDestroy( cmLHeapH_t* hp )
 }
 
 void*      cmLHeapAllocate(cmLHeapH_t h, void* orgDataPtr, unsigned eleCnt, unsigned eleByteCnt, unsigned flags, const char* fileStr, const char* funcStr, unsigned fileLine )
-{ return cmMmAllocate(_cmLHeapHandleToPtr(h)->mmH,orgDataPtr,eleCnt,eleByteCnt,flags,fileStr,funcStr,fileLine);  }
+{
+  cmLHeap_t* lhp = _cmLHeapHandleToPtr(h);
+
+  if( lhp->rt != NULL )
+    return _cmLhRtAllocate(lhp,orgDataPtr,eleCnt,eleByteCnt,flags);
+  
+  return cmMmAllocate(lhp->mmH,orgDataPtr,eleCnt,eleByteCnt,flags,fileStr,funcStr,fileLine);
+}
 
 cmChar_t*  cmLHeapAllocStr(cmLHeapH_t h, void* orgDataPtr, const cmChar_t*  str, unsigned charCnt, unsigned flags, const char* fileStr, const char* funcStr, unsigned fileLine )
 {
@@ -223,6 +590,10 @@ cmChar_t*  cmLHeapAllocStr(cmLHeapH_t h, void* orgDataPtr, const cmChar_t*  str,
 
   unsigned  n  = charCnt + 1;
   cmChar_t* cp = cmLHeapAllocate(h, orgDataPtr, n, sizeof(cmChar_t), flags, fileStr, funcStr, fileLine );
+
+  if( cp == NULL )
+    return NULL;
+  
   strncpy(cp,str,n);
   cp[n-1] = 0;
   return cp;
@@ -231,12 +602,27 @@ cmChar_t*  cmLHeapAllocStr(cmLHeapH_t h, void* orgDataPtr, const cmChar_t*  str,
 void       cmLHeapFree(    cmLHeapH_t h, void* dataPtr )
 { 
   cmLHeap_t*   lhp = _cmLHeapHandleToPtr(h);
+
+  if( lhp->rt != NULL )
+  {
+    if( dataPtr != NULL )
+      _cmLhRtFree(lhp,dataPtr);
+    return;
+  }
+
   cmMmFree(lhp->mmH,dataPtr);
 }
 
 void       cmLHeapFreeDebug(    cmLHeapH_t h, void* dataPtr,  const char* fileName, const char* funcName, unsigned fileLine )
 {
   cmLHeap_t*   lhp = _cmLHeapHandleToPtr(h);
+
+  if( lhp->rt != NULL )
+  {
+    cmLHeapFree(h,dataPtr);
+    return;
+  }
+  
   cmMmFreeDebug(lhp->mmH,dataPtr,fileName,funcName,fileLine); 
 }
 
@@ -262,22 +648,64 @@ unsigned   cmLHeapDefaultBlockByteCount( cmLHeapH_t h )
   return p->dfltBlockByteCnt;
 }
 
+void       cmLHeapSetDefaultBlockByteCount( cmLHeapH_t h, unsigned dfltBlockByteCnt )
+{
+  cmLHeap_t* p = _cmLHeapHandleToPtr(h);
+  p->dfltBlockByteCnt = dfltBlockByteCnt;
+}
+
 unsigned   cmLHeapGuardByteCount(  cmLHeapH_t h )
 {
   cmLHeap_t* p = _cmLHeapHandleToPtr(h);
-  return cmMmGuardByteCount( p->mmH );
+  return p->rt != NULL ? 0 : cmMmGuardByteCount( p->mmH );
 }
 
 unsigned   cmLHeapAlignByteCount(  cmLHeapH_t h )
 {
   cmLHeap_t* p = _cmLHeapHandleToPtr(h);
-  return cmMmAlignByteCount( p->mmH );
+  return p->rt != NULL ? kRtAlignLhByteCnt : cmMmAlignByteCount( p->mmH );
 }
 
 unsigned   cmLHeapInitializeFlags( cmLHeapH_t h )
 {
   cmLHeap_t* p = _cmLHeapHandleToPtr(h);
-  return cmMmInitializeFlags( p->mmH );
+  return p->rt != NULL ? 0 : cmMmInitializeFlags( p->mmH );
+}
+
+bool       cmLHeapIsRealtime( cmLHeapH_t h )
+{
+  cmLHeap_t* p = _cmLHeapHandleToPtr(h);
+  return p->rt != NULL;
+}
+
+cmLHeapRC_t cmLHeapLastRC( cmLHeapH_t h )
+{
+  cmLHeap_t* p = _cmLHeapHandleToPtr(h);
+  return cmErrLastRC(&p->err);
+}
+
+void       cmLHeapStats( cmLHeapH_t h, cmLHeapStats_t* s )
+{
+  cmLHeap_t* p = _cmLHeapHandleToPtr(h);
+
+  s->blockByteCnt    = p->blockByteCnt;
+  s->blockHwmByteCnt = p->blockHwmByteCnt;
+  s->liveByteCnt     = p->liveByteCnt;
+  s->liveHwmByteCnt  = p->liveHwmByteCnt;
+  s->allocCnt        = p->allocCnt;
+  s->failCnt         = p->failCnt;
+  s->arenaByteCnt    = p->rt==NULL ? 0 : p->rt->byteCnt;
+  s->arenaOffs       = p->rt==NULL ? 0 : p->rt->offs;
+  s->threadCnt       = p->rt==NULL ? 0 : p->rt->thCnt;
+}
+
+void       cmLHeapResetHighWater( cmLHeapH_t h )
+{
+  cmLHeap_t* p = _cmLHeapHandleToPtr(h);
+  p->liveHwmByteCnt  = p->liveByteCnt;
+  p->blockHwmByteCnt = p->rt==NULL ? p->blockByteCnt : p->rt->offs;
+  p->allocCnt        = 0;
+  p->failCnt         = 0;
 }
 
 bool cmLHeapIsValid( cmLHeapH_t h )
@@ -287,6 +715,12 @@ void       cmLHeapClear(   cmLHeapH_t h, bool releaseFl )
 {
   cmLHeap_t* p = _cmLHeapHandleToPtr(h);
 
+  if( p->rt != NULL )
+  {
+    _cmLhRtClear(p);
+    return;
+  }
+
   // If we are deferring freeing memory until the heap is destroyed
   // then we cannot clear the block list in this function.
   // If the block list was cleared here then later calls to _cmLHeapFreeCb()
@@ -311,20 +745,31 @@ void       cmLHeapClear(   cmLHeapH_t h, bool releaseFl )
 
   if( releaseFl )
   {
-    p->first = NULL;
-    p->last  = NULL;
+    p->first        = NULL;
+    p->last         = NULL;
+    p->blockByteCnt = 0;
   }
+
+  p->liveByteCnt = 0;
 }
 
 bool cmLHeapIsPtrInHeap( cmLHeapH_t h, const void* ptr )
 {
   cmLHeap_t*   lhp = _cmLHeapHandleToPtr(h); 
+
+  if( lhp->rt != NULL )
+    return lhp->rt->basePtr <= (char*)ptr && (char*)ptr < lhp->rt->basePtr + lhp->rt->byteCnt;
+  
   return _cmLHeapPtrToBlock(lhp,ptr) != NULL;
 }
 
 cmMmRC_t cmLHeapReportErrors( cmLHeapH_t h, unsigned mmFlags )
 {
   cmLHeap_t*   lhp = _cmLHeapHandleToPtr(h);
+
+  if( lhp->rt != NULL )
+    return kOkMmRC;
+  
   return cmMmReport(lhp->mmH, mmFlags );
 }
 
@@ -333,6 +778,11 @@ void cmLHeapReport( cmLHeapH_t h )
   cmLHeap_t*   lhp = _cmLHeapHandleToPtr(h);
   cmLhBlock_t* lbp = lhp->first;
   unsigned     i;
+
+  printf("live:%u hwm:%u blocks:%u blocks hwm:%u allocs:%u fails:%u\n", lhp->liveByteCnt, lhp->liveHwmByteCnt, lhp->blockByteCnt, lhp->blockHwmByteCnt, lhp->allocCnt, lhp->failCnt );
+
+  if( lhp->rt != NULL )
+    printf("arena: %u of %u used by %u threads\n", lhp->rt->offs, lhp->rt->byteCnt, lhp->rt->thCnt );
   for(i=0; lbp != NULL; ++i )
   {
     printf("%u : %li available  %i free\n", i, lbp->endPtr-lbp->nextPtr, lbp->freeCnt );
@@ -381,4 +831,37 @@ void cmLHeapTest()
   cmLHeapReportErrors(h,0);
 
   cmLHeapDestroy(&h);
+
+  //
+  // realtime heap: fill the arena with 40 byte records (the size of
+  // a cmDspCb_t, which is served from the 48 byte class), release them
+  // and verify that they are reused without claiming more of the arena
+  //
+  
+  unsigned       rtN   = 1024;
+  void*          rtArray[ rtN ];
+  cmLHeapStats_t s0,s1;
+  
+  h = cmLHeapCreateRt( 16384, &ctx );
+
+  for(i=0; i<rtN; ++i)
+    if((rtArray[i] = cmLHeapAllocZ(h,40)) == NULL )
+      break;
+
+  n = i;
+  cmLHeapStats(h,&s0);
+  printf("rt alloc'd:%i of %i rc:%i arena:%u of %u live hwm:%u fail:%u\n",n,rtN,cmLHeapLastRC(h),s0.arenaOffs,s0.arenaByteCnt,s0.liveHwmByteCnt,s0.failCnt);
+
+  for(i=0; i<n; ++i)
+    cmLHeapFree(h,rtArray[i]);
+
+  for(i=0; i<n; ++i)
+    if((rtArray[i] = cmLHeapAllocZ(h,40)) == NULL )
+      break;
+
+  cmLHeapStats(h,&s1);
+  printf("rt realloc'd:%i of %i arena:%u -> %u\n", i, n, s0.arenaOffs, s1.arenaOffs );
+
+  cmLHeapReport(h);
+  cmLHeapDestroy(&h);
 }
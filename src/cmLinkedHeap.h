@@ -20,10 +20,32 @@ extern "C" {
   //(
   
   typedef cmHandle_t cmLHeapH_t;
+  typedef cmRC_t     cmLHeapRC_t;
+
+  enum
+  {
+    kOkLHeapRC = cmOkRC,
+    kArenaExhaustedLHeapRC
+  };
   
   extern cmLHeapH_t cmLHeapNullHandle;
 
   cmLHeapH_t cmLHeapCreate( unsigned dfltBlockByteCnt, cmCtx_t* ctx );
+
+  // Create a realtime heap.
+  // A realtime heap allocates a single arena of arenaByteCnt bytes when it is 
+  // created and never allocates memory from the system again. Allocations are
+  // served from a private region of the arena for each calling thread (up to 16 threads)
+  // and released allocations of 2048 bytes or less are kept on size class free lists
+  // for reuse. No locks are taken by the allocation or release functions.
+  // When the arena is exhausted the allocation functions return NULL,
+  // cmLHeapLastRC() returns kArenaExhaustedLHeapRC and cmLHeapStats_t.failCnt is 
+  // incremented. No error message is printed from the allocating thread.
+  // Realtime heaps do not apply the guard bytes or allocation tracking
+  // set in 'ctx' and all allocations are aligned to 16 bytes.
+  // cmLHeapClear() on a realtime heap releases every allocation and must only
+  // be called when no other thread is using the heap.
+  cmLHeapH_t cmLHeapCreateRt( unsigned arenaByteCnt, cmCtx_t* ctx );
   void       cmLHeapDestroy( cmLHeapH_t* hp );
 
   void*     cmLHeapAllocate(     cmLHeapH_t h, void* orgDataPtr, unsigned eleCnt, unsigned eleByteCnt,   unsigned flags, const char* fileStr, const char* funcStr, unsigned fileLine );
@@ -45,6 +67,9 @@ extern "C" {
   unsigned   cmLHeapAlignByteCount(  cmLHeapH_t h );
   unsigned   cmLHeapInitializeFlags( cmLHeapH_t h );
 
+  // Set the size of the blocks allocated after this call.
+  void       cmLHeapSetDefaultBlockByteCount( cmLHeapH_t h, unsigned dfltBlockByteCnt );
+
   // If releaseFl==false then marks all internal memory blocks as empty but does not actually 
   // release the associated memory, otherwise releases all memory blocks.
   void       cmLHeapClear(   cmLHeapH_t h, bool releaseFl );
@@ -52,6 +77,33 @@ extern "C" {
   // Return true if 'ptr' points into a linked heap block.
   bool       cmLHeapIsPtrInHeap( cmLHeapH_t h, const void* ptr );
 
+  // Return true if 'h' was created by cmLHeapCreateRt().
+  bool        cmLHeapIsRealtime( cmLHeapH_t h );
+
+  // Return kArenaExhaustedLHeapRC if an allocation on a realtime heap has failed.
+  cmLHeapRC_t cmLHeapLastRC( cmLHeapH_t h );
+
+  // Heap usage counters.  The high water marks can be read from a heap created
+  // with cmLHeapCreate() during a typical run to choose the arena size
+  // for cmLHeapCreateRt().  All byte counts include the per-allocation overhead.
+  typedef struct
+  {
+    unsigned blockByteCnt;    // bytes held in blocks (the arena size for realtime heaps)
+    unsigned blockHwmByteCnt; // max. bytes held in blocks (max. bytes claimed from the arena for realtime heaps)
+    unsigned liveByteCnt;     // bytes currently allocated
+    unsigned liveHwmByteCnt;  // max. value of liveByteCnt
+    unsigned allocCnt;        // count of allocations
+    unsigned failCnt;         // count of allocations which failed because the arena was exhausted
+    unsigned arenaByteCnt;    // realtime arena size (0 if not a realtime heap)
+    unsigned arenaOffs;       // bytes currently claimed from the arena (0 if not a realtime heap)
+    unsigned threadCnt;       // count of threads with a private arena region (0 if not a realtime heap)
+  } cmLHeapStats_t;
+
+  void       cmLHeapStats( cmLHeapH_t h, cmLHeapStats_t* statsPtr );
+
+  // Set the high water marks to the current values and zero the alloc and fail counts.
+  void       cmLHeapResetHighWater( cmLHeapH_t h );
+
   // mmFlags take the same values as the flags parameter to cmMmReport().
   cmMmRC_t   cmLHeapReportErrors( cmLHeapH_t h, unsigned mmFlags );
   void       cmLHeapReport(  cmLHeapH_t h );
@@ -57,6 +57,8 @@ extern "C" {
     kSendMsgDuiId,         // forward msg to the audio system
     kDevReportDuiId,       // print a device report
     kPrintPgmDuiId,        // write the currently loaded pgm as a JSON file
+    kDspProfileDuiId,      // enable/disable DSP instance profiling
+    kDspProfileWriteDuiId, // write the DSP instance profile to a CSV or JSON file
     
     kRightAlignDuiId = 0,  // label alignment id used by kLabelDuiId 
     kLeftAlignDuiId,  
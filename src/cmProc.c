@@ -15,11 +15,15 @@
 #include "cmProcObj.h"
 #include "cmProcTemplate.h"
 #include "cmAudioFile.h"
+#include "cmAudioFileStream.h"
 #include "cmMath.h"
 #include "cmProc.h"
 #include "cmVectOps.h"
 #include "cmKeyboard.h"
 #include "cmGnuPlot.h"
+#include "cmResample.h"
+#include "cmThread.h"
+#include "cmTime.h"
 
 #include <time.h> // time()
 
@@ -74,6 +78,31 @@ void cmSetupFloatPointExceptHandler( struct sigaction* orgSaPtr )
 
 //------------------------------------------------------------------------------------------------------------
 
+typedef struct cmAudioFileRdStream_str
+{
+  cmAfsH_t       h;   // shared read-ahead I/O service (see cmAfsSharedAcquire())
+  cmAfsStreamH_t sH;  // stream on cmAudioFileRd.fn
+} cmAudioFileRdStream;
+
+cmRC_t _cmAudioFileRdStreamFree( cmAudioFileRd* p )
+{
+  cmRC_t rc = cmOkRC;
+  cmRC_t afRC;
+
+  if( p->stream == NULL )
+    return rc;
+
+  if((afRC = cmAfsStreamClose(&p->stream->sH)) != kOkAfsRC )
+    return cmCtxRtCondition( &p->obj, afRC, "The read-ahead stream for '%s' could not be closed.", p->fn );
+
+  if((afRC = cmAfsSharedRelease(&p->stream->h)) != kOkAfsRC )
+    return cmCtxRtCondition( &p->obj, afRC, "The read-ahead service could not be released by '%s'.", p->fn );
+
+  cmMemPtrFree(&p->stream);
+
+  return rc;
+}
+
 cmAudioFileRd* cmAudioFileRdAlloc( cmCtx* c,  cmAudioFileRd* p, unsigned procSmpCnt, const cmChar_t* fn, unsigned chIdx, unsigned begFrmIdx, unsigned endFrmIdx )
 { 
   cmAudioFileRd* op = cmObjAlloc( cmAudioFileRd, c, p ); 
@@ -145,6 +174,9 @@ cmRC_t               cmAudioFileRdClose( cmAudioFileRd* p )
 
   //cmCtxFreeDebugFile(p->obj.ctx,&p->mfp);
 
+  if( p->stream != NULL )
+    rc = _cmAudioFileRdStreamFree(p);
+
   if( cmAudioFileIsOpen(p->h) == false )
     return cmOkRC;
 
@@ -159,13 +191,48 @@ cmRC_t               cmAudioFileRdRead(  cmAudioFileRd* p )
   cmRC_t rc = cmOkRC;
   cmRC_t afRC;
 
-  if(p->eofFl || ((p->eofFl = cmAudioFileIsEOF(p->h)) == true) )
-    return cmEofRC;
+  if( p->stream != NULL )
+  {
+    if( p->eofFl )
+      return cmEofRC;
+  }
+  else
+  {
+    if(p->eofFl || ((p->eofFl = cmAudioFileIsEOF(p->h)) == true) )
+      return cmEofRC;
+  }
 
   unsigned n = p->endFrmIdx==cmInvalidIdx ? p->outN : cmMin( p->outN, p->endFrmIdx - p->curFrmIdx );
 
-  if((afRC =  cmAudioFileReadSample( p->h, n, p->chIdx, 1, &p->outV, &p->lastReadFrmCnt )) != kOkAfRC )
-    rc = cmCtxRtCondition( &p->obj, afRC, "Audio file read failed on:'%s'.", p->fn);
+  if( p->stream != NULL )
+  {
+    cmAfsStreamH_t sH = p->stream->sH;
+    unsigned       u0 = cmAfsStreamUnderrunCount(sH);
+
+    if( cmAfsStreamIsFailed(sH) )
+    {
+      cmVOS_Zero(p->outV,p->outN);
+      p->lastReadFrmCnt = 0;
+      p->eofFl          = true;
+      return cmCtxRtCondition( &p->obj, kAudioFileFailAfsRC, "The read-ahead stream failed on:'%s'.", p->fn);
+    }
+
+    // never wait on the I/O thread - frames which have not yet been read are returned as zeros
+    p->lastReadFrmCnt = cmAfsStreamRead( sH, &p->outV, n );
+    p->underrunCnt   += cmAfsStreamUnderrunCount(sH) - u0;
+
+    if( cmAfsStreamIsEof(sH) )
+    {
+      p->eofFl = true;
+      if( p->lastReadFrmCnt == 0 )
+        return cmEofRC;
+    }
+  }
+  else
+  {
+    if((afRC =  cmAudioFileReadSample( p->h, n, p->chIdx, 1, &p->outV, &p->lastReadFrmCnt )) != kOkAfRC )
+      rc = cmCtxRtCondition( &p->obj, afRC, "Audio file read failed on:'%s'.", p->fn);
+  }
 
   p->curFrmIdx += p->lastReadFrmCnt;
 
@@ -186,12 +253,50 @@ cmRC_t               cmAudioFileRdSeek( cmAudioFileRd* p, unsigned frmIdx )
   cmRC_t rc = cmOkRC;
   cmRC_t afRC;
 
-  if((afRC = cmAudioFileSeek( p->h, frmIdx )) != kOkAfRC )
+  if( p->stream != NULL )
+    afRC = cmAfsStreamSeek( p->stream->sH, frmIdx );
+  else
+    afRC = cmAudioFileSeek( p->h, frmIdx );
+
+  if( afRC != kOkAfRC )
     rc = cmCtxRtCondition( &p->obj, afRC, "Audio file read failed on:'%s'.", p->fn);
 
   return rc;
 }
 
+cmRC_t             cmAudioFileRdSetReadAhead( cmAudioFileRd* p, unsigned lookAheadFrmCnt )
+{
+  cmRC_t rc;
+  cmRC_t afRC;
+
+  if((rc = _cmAudioFileRdStreamFree(p)) != cmOkRC || lookAheadFrmCnt == 0 )
+    return rc;
+
+  if( cmAudioFileIsOpen(p->h) == false )
+    return cmCtxRtCondition( &p->obj, cmInvalidArgRC, "Read-ahead cannot be enabled because no audio file is open.");
+
+  p->stream      = cmMemAllocZ( cmAudioFileRdStream, 1 );
+  p->underrunCnt = 0;
+
+  if((afRC = cmAfsSharedAcquire( &p->stream->h, p->obj.err.rpt )) != kOkAfsRC )
+  {
+    rc = cmCtxRtCondition( &p->obj, afRC, "Unable to start the read-ahead service for '%s'.", p->fn );
+    goto errLabel;
+  }
+
+  if((afRC = cmAfsStreamOpen( p->stream->h, &p->stream->sH, p->fn, p->chIdx, 1, p->curFrmIdx, lookAheadFrmCnt, 0, NULL )) != kOkAfsRC )
+  {
+    rc = cmCtxRtCondition( &p->obj, afRC, "Unable to open a read-ahead stream on '%s'.", p->fn );
+    goto errLabel;
+  }
+
+ errLabel:
+  if( rc != cmOkRC )
+    _cmAudioFileRdStreamFree(p);
+
+  return rc;
+}
+
 cmRC_t             cmAudioFileRdMinMaxMean( cmAudioFileRd* p, unsigned chIdx, cmSample_t* minPtr, cmSample_t* maxPtr, cmSample_t* meanPtr )
 {
   cmRC_t rc = cmOkRC;
@@ -1949,8 +2054,6 @@ cmSRC* cmSRCAlloc( cmCtx* c, cmSRC* ap, double srate, unsigned procSmpCnt, unsig
 {
   cmSRC* p = cmObjAlloc( cmSRC, c,ap );
 
-  cmFilterAlloc(c,&p->filt,NULL,0,NULL,0,0,NULL);
- 
   if( srate > 0 && procSmpCnt > 0 )
     if( cmSRCInit( p, srate, procSmpCnt, upFact, dnFact ) != cmOkRC )
       cmSRCFree(&p);
@@ -1968,8 +2071,6 @@ cmRC_t cmSRCFree(  cmSRC** pp )
 
     if((rc = cmSRCFinal( p )) == cmOkRC )
     {
-      cmFilter* fp = &p->filt;
-      cmFilterFree(&fp);
       cmMemPtrFree(&p->outV);
       cmObjFree(pp);
     }
@@ -1978,32 +2079,27 @@ cmRC_t cmSRCFree(  cmSRC** pp )
 }
 
 cmRC_t cmSRCInit(  cmSRC* p, double srate, unsigned procSmpCnt, unsigned upFact, unsigned dnFact )
+{
+  return cmSRCInitQ(p,srate,procSmpCnt,upFact,dnFact,kMedRsmpQ);
+}
+
+cmRC_t cmSRCInitQ( cmSRC* p, double srate, unsigned procSmpCnt, unsigned upFact, unsigned dnFact, unsigned quality )
 {
   cmRC_t rc;
 
   if((rc = cmSRCFinal(p)) != cmOkRC )
     return rc;
 
-  double hiRate = upFact * srate;
-  double loRate = hiRate / dnFact;
-  double minRate= cmMin( loRate, srate ); 
-  double fcHz   = minRate/2;
-  double dHz    = (fcHz * .1); // transition band is 5% of min sample rate 
-  double passHz = fcHz-dHz;
-  double stopHz = fcHz;
-  double passDb = 0.001;
-  double stopDb = 20;
- 
-  cmFilterInitEllip( &p->filt, hiRate, passHz, stopHz,  passDb, stopDb, procSmpCnt, NULL );
-
-  //printf("CoeffCnt:%i dHz:%f passHz:%f stopHz:%f passDb:%f stopDb:%f\n", p->fir.coeffCnt, dHz, passHz, stopHz, passDb, stopDb );
+  if((p->rsmp = cmRsmpAlloc(upFact,dnFact,quality)) == NULL )
+    return cmCtxRtCondition( &p->obj, cmArgAssertRC, "Invalid sample rate conversion factors: up:%i dn:%i.",upFact,dnFact);
 
-  p->outN   = (unsigned)ceil(procSmpCnt * upFact / dnFact); 
-  p->outV   = cmMemResize( cmSample_t, p->outV, p->outN );  
-  p->upi    = 0;
-  p->dni    = 0;
-  p->upFact = upFact;
-  p->dnFact = dnFact;
+  // allow one extra input sample per block so that the variable length
+  // output of one cmSRC can be fed directly to another
+  p->outMaxN = cmRsmpMaxOutCount(p->rsmp,procSmpCnt+1);
+  p->outV    = cmMemResizeZ( cmSample_t, p->outV, p->outMaxN );
+  p->outN    = 0;
+  p->upFact  = upFact;
+  p->dnFact  = dnFact;
   //p->mfp    = cmCtxAllocDebugFile(p->obj.ctx,"src");
   return cmOkRC;
 }
@@ -2013,43 +2109,20 @@ cmRC_t cmSRCFinal( cmSRC* p )
   //if( p != NULL )
   //  cmCtxFreeDebugFile(p->obj.ctx,&p->mfp);
 
+  if( p != NULL )
+    cmRsmpFree(&p->rsmp);
+
   return cmOkRC;
 }
 
 cmRC_t cmSRCExec(  cmSRC* p, const cmSample_t* sp, unsigned sn )
 {
-  const cmSample_t* sep = sp + sn;
-  cmSample_t*       op  = p->outV;
-  const cmSample_t* oep = op + p->outN;
-  unsigned          iN  = sn * p->upFact;
-  unsigned          i,j; 
-
-  // run the filter at the upsampled rate ...
-  for(i=0; i<iN; ++i) 
-  {
-    assert( p->upi!=0 || sp<sep ); 
+  unsigned xn = 0;
 
-    cmSample_t x0 = p->upi==0 ? *sp++ : 0,
-               y0 = x0 * p->filt.b0 + p->filt.d[0];
-
-    // ... but output at the down sampled rate
-    if( p->dni==0 )
-    {
-      assert( op < oep );
-      *op++ = y0;
-    }
+  p->outN = cmRsmpExec( p->rsmp, sp, sn, 1, &xn, p->outV, p->outMaxN, 1, 1 );
 
-    // advance the filter delay line
-    for(j=0; j<p->filt.cn; ++j)
-      p->filt.d[j] = p->filt.b[j]*x0 - p->filt.a[j]*y0 + p->filt.d[j+1];
-
-    // update the input/output clocks
-    p->upi = (p->upi + 1) % p->upFact;
-    p->dni = (p->dni + 1) % p->dnFact;
-    
-  }
-
-  p->outN = op - p->outV;
+  if( xn < sn )
+    return cmCtxRtCondition( &p->obj, cmArgAssertRC, "The SRC input block (%i) exceeds the processing block size.",sn);
 
   if( p->mfp != NULL )
     cmMtxFileSmpExec(p->mfp,p->outV,p->outN );
@@ -3011,12 +3084,36 @@ cmRC_t          cmGmmFree(  cmGmm_t** pp )
   cmMemPtrFree(&p->sMM);
   cmMemPtrFree(&p->isMM);
   cmMemPtrFree(&p->uMM);
+  cmMemPtrFree(&p->liMM);
   cmMemPtrFree(&p->logDetV);
   cmMemPtrFree(&p->t);
   cmObjFree(pp);
   return rc;
 }
 
+// Set li[D,D] to inv(u)' where u[D,D] is an upper triangular matrix.
+void _cmGmmInvCholT( cmReal_t* li, const cmReal_t* u, unsigned D )
+{
+  unsigned i,j,k;
+
+  cmVOR_Zero(li,D*D);
+
+  // solve u*v=e[j] by back substitution and store v (col j of inv(u)) in row j of li[]
+  for(j=0; j<D; ++j)
+  {
+    li[ j + j*D ] = 1.0 / u[ j + j*D ];
+
+    for(i=j; i-- > 0; )
+    {
+      cmReal_t sum = 0;
+      for(k=i+1; k<=j; ++k)
+        sum += u[ i + k*D ] * li[ j + k*D ];
+
+      li[ j + i*D ] = -sum / u[ i + i*D ];
+    }
+  }
+}
+
 cmRC_t _cmGmmUpdateCovar( cmGmm_t* p, const cmReal_t* sMM )
 {
   unsigned i;
@@ -3065,6 +3162,8 @@ cmRC_t _cmGmmUpdateCovar( cmGmm_t* p, const cmReal_t* sMM )
       return cmCtxRtCondition(&p->obj, cmSingularMtxRC, "A singular covariance matrix (Cholesky factorization failed.)  was encountered in _cmGmmUpdateCovar().");
     }
 
+    _cmGmmInvCholT(p->liMM + i*De2, u, p->D );
+
     if( p->logDetV[i] == 0 )
     {
       cmGmmPrint(p,true);
@@ -3109,6 +3208,7 @@ cmRC_t          cmGmmInit(  cmGmm_t* p, unsigned K, unsigned D, const cmReal_t*
   p->sMM     = cmMemResizeZ( cmReal_t, p->sMM,     D*D*K);
   p->isMM    = cmMemResizeZ( cmReal_t, p->isMM,    D*D*K);
   p->uMM     = cmMemResizeZ( cmReal_t, p->uMM,     D*D*K);
+  p->liMM    = cmMemResizeZ( cmReal_t, p->liMM,    D*D*K);
   p->logDetV = cmMemResizeZ( cmReal_t, p->logDetV, K); 
   p->t       = cmMemResizeZ( cmReal_t, p->t,       D*D );
 
@@ -3130,6 +3230,12 @@ cmRC_t          cmGmmInit(  cmGmm_t* p, unsigned K, unsigned D, const cmReal_t*
 cmRC_t          cmGmmFinal( cmGmm_t* p )
 { return cmOkRC; }
 
+cmRC_t   cmGmmSetThreadCount( cmGmm_t* p, unsigned thCnt )
+{
+  p->thCnt = thCnt;
+  return cmOkRC;
+}
+
 
 typedef struct
 {
@@ -3145,57 +3251,139 @@ const cmReal_t* _cmGmmReadFunc( void* userPtr, unsigned colIdx )
 }
 
 
+// Evaluate the weighted component PDF's for the observations xM[D,xN] where xN <= kBlkFrmCntGmm.
+// yM[i + k*yStride] = gV[k] * N(xM[:,i] | uM[:,k], sMM[:,:,k])
+// dM[D,xN] and zM[D,xN] are scratch matrices.
+void _cmGmmEvalBlock( const cmGmm_t* p, const cmReal_t* xM, unsigned xN, cmReal_t* yM, unsigned yStride, cmReal_t* dM, cmReal_t* zM )
+{
+  unsigned D      = p->D;
+  unsigned De2    = D*D;
+  bool     diagFl = cmIsFlag(p->uflags,cmGmmDiagFl);
+  unsigned i,j,k;
+
+  for(k=0; k<p->K; ++k)
+  {
+    const cmReal_t* uV   = p->uM + k*D;
+    cmReal_t*       yV   = yM + k*yStride;
+    double          fact = (-(cmReal_t)D/2) * log(2.0*M_PI) - 0.5*p->logDetV[k];
+
+    // dM[D,xN] = xM[D,xN] - repmat(uV,1,xN)
+    for(i=0; i<xN; ++i)
+      cmVOR_SubVVV(dM + i*D, D, xM + i*D, uV );
+
+    if( diagFl )
+    {
+      // dist = sum( dx.^2 .* diag(isM) )
+      const cmReal_t* isM = p->isMM + k*De2;
+
+      for(i=0; i<xN; ++i)
+      {
+        const cmReal_t* dV   = dM + i*D;
+        cmReal_t        dist = 0;
+
+        for(j=0; j<D; ++j)
+          dist += dV[j] * dV[j] * isM[ j + j*D ];
+
+        yV[i] = p->gV[k] * exp( fact - 0.5*dist );
+      }
+    }
+    else
+    {
+      // zM[D,xN] = liM[D,D] * dM[D,xN]  then dist = sum(zM.^2,1)
+      cmVOR_MultMMM( zM, D, xN, p->liMM + k*De2, dM, D );
+
+      for(i=0; i<xN; ++i)
+        yV[i] = p->gV[k] * exp( fact - 0.5*cmVOR_MultSumVV(zM + i*D, zM + i*D, D) );
+    }
+  }
+}
+
+// Sum the component evaluations yM[xN,K] (yStride is the physical row count) into yV[xN].
+void _cmGmmSumComps( const cmGmm_t* p, const cmReal_t* yM, unsigned yStride, unsigned xN, cmReal_t* yV )
+{
+  unsigned i,k;
+
+  cmVOR_Zero(yV,xN);
+
+  for(k=0; k<p->K; ++k)
+    for(i=0; i<xN; ++i)
+      yV[i] += yM[ i + k*yStride ];
+}
+
 // xM[D,xN]
 // yV[xN]
 // yM[xN,K]
 cmRC_t          cmGmmEval(  cmGmm_t* p,  const cmReal_t* xM, unsigned xN, cmReal_t* yV, cmReal_t* yM )
 {
-  _cmGmmRdFuncData_t r;
-  r.colCnt = xN;
-  r.p      = p;
-  r.xM     = xM;
+  if( xN == 0 )
+    return cmOkRC;
+
+  unsigned  D  = p->D;
+  unsigned  bN = cmMin(xN,kBlkFrmCntGmm);
+  cmReal_t* dM = cmMemAlloc(cmReal_t, 2*D*bN + (yM==NULL ? bN*p->K : 0) );
+  cmReal_t* zM = dM + D*bN;
+  unsigned  i,n;
+
+  for(i=0; i<xN; i+=n)
+  {
+    n = cmMin(bN,xN-i);
+
+    // if yM[] was not given then use a temp. matrix (tM[bN,K]) for the component evaluations
+    cmReal_t* ym      = yM==NULL ? zM + D*bN : yM + i;
+    unsigned  yStride = yM==NULL ? bN        : xN;
+
+    _cmGmmEvalBlock(p, xM + i*D, n, ym, yStride, dM, zM );
+    _cmGmmSumComps( p, ym, yStride, n, yV + i );
+  }
 
-  return cmGmmEval2(p,_cmGmmReadFunc,&r,xN,yV,yM);
+  cmMemFree(dM);
+  return cmOkRC;
 }
 
 
 cmRC_t   cmGmmEval2(  cmGmm_t* p, cmGmmReadFunc_t readFunc, void* userFuncPtr, unsigned xN, cmReal_t* yV, cmReal_t* yM)
 {
-  cmReal_t  tV[xN];
-  unsigned k;
+  if( xN == 0 )
+    return cmOkRC;
 
-  //cmVOR_PrintL("cV: ",p->obj.err.rpt, 1, p->K, p->gV);
-  //cmVOR_PrintL("uM:\n",p->obj.err.rpt, p->D, p->K, p->uM );
-  
-  //
-  cmVOR_Fill(yV,xN,0);
+  unsigned  D  = p->D;
+  unsigned  bN = cmMin(xN,kBlkFrmCntGmm);
+  cmReal_t* xM = cmMemAlloc(cmReal_t, 3*D*bN + (yM==NULL ? bN*p->K : 0) );
+  cmReal_t* dM = xM + D*bN;
+  cmReal_t* zM = dM + D*bN;
+  bool      nullFlV[ bN ];
+  unsigned  i,j,k,n;
 
-  // for each component PDF
-  for(k=0; k<p->K; k++)
+  for(i=0; i<xN; i+=n)
   {
-    const cmReal_t* meanV  = p->uM   + (k*p->D);
-    const cmReal_t* isM    = p->isMM + (k*p->D*p->D);
-    cmReal_t*       pV;
-    
-    if( yM == NULL )
-      pV = tV;
-    else
-      pV = yM + (k*xN);
+    n = cmMin(bN,xN-i);
 
+    cmReal_t* ym      = yM==NULL ? zM + D*bN : yM + i;
+    unsigned  yStride = yM==NULL ? bN        : xN;
 
-    // evaluate the kth component PDF with xM[1:T]
+    // gather the next block of observations
+    for(j=0; j<n; ++j)
+    {
+      const cmReal_t* xV = readFunc( userFuncPtr, i+j );
 
-    //cmVOR_MultVarGaussPDF2( pV, xM,                    meanV, isM, p->logDetV[k], p->D, xN, cmIsFlag(p->uflags,cmGmmDiagFl) );
-    cmVOR_MultVarGaussPDF3( pV, readFunc, userFuncPtr, meanV, isM, p->logDetV[k], p->D, xN, cmIsFlag(p->uflags,cmGmmDiagFl) );
+      // missing observations evaluate to zero - use the first mean as a placeholder
+      if((nullFlV[j] = xV == NULL) == true )
+        xV = p->uM;
 
+      cmVOR_Copy( xM + j*D, D, xV );
+    }
 
-    // apply the kth component weight
-    cmVOR_MultVS( pV, xN, p->gV[k] );
+    _cmGmmEvalBlock(p, xM, n, ym, yStride, dM, zM );
 
-    // sum the result into the output vector
-    cmVOR_AddVV( yV, xN, pV );
+    for(j=0; j<n; ++j)
+      if( nullFlV[j] )
+        for(k=0; k<p->K; ++k)
+          ym[ j + k*yStride ] = 0;
 
+    _cmGmmSumComps( p, ym, yStride, n, yV + i );
   }
+
+  cmMemFree(xM);
   return cmOkRC;   
 }
 
@@ -3224,9 +3412,6 @@ cmRC_t          cmGmmEval3(  cmGmm_t* p,  const cmReal_t* xV,  cmReal_t* yV )
   return cmOkRC;
 }
 
-cmReal_t _cmGmmKmeansDistFunc( void* userPtr, const cmReal_t* v0, const cmReal_t* v1, unsigned vn )
-{ return  cmVOR_EuclidDistance(v0,v1,vn); }
-
 cmRC_t cmGmmRandomize2( cmGmm_t* p, cmGmmReadFunc_t readFunc, void* funcUserPtr, unsigned xN, const cmReal_t* uM, const bool* roFlV )
 {
   unsigned k;
@@ -3293,7 +3478,7 @@ cmRC_t cmGmmRandomize2( cmGmm_t* p, cmGmmReadFunc_t readFunc, void* funcUserPtr,
 
   // use kmeans clustering to move the means closer to their center values
   if( cmIsFlag( p->uflags, cmGmmSkipKmeansFl) == false )
-    cmVOR_Kmeans2( classIdxV, p->uM, p->K, readFunc, p->D, xN, funcUserPtr, _cmGmmKmeansDistFunc, NULL, -1, 0 ); 
+    cmVOR_Kmeans3( classIdxV, p->uM, p->K, readFunc, p->D, xN, funcUserPtr, roFlV, -1, 0, 0, p->thCnt, p->obj.err.rpt ); 
 
   cmMemPtrFree(&classIdxV);
 
@@ -3312,318 +3497,367 @@ cmRC_t cmGmmRandomize( cmGmm_t* p, const cmReal_t* xM, unsigned xN )
 }
 
 
-// xM[D,xN]
-cmRC_t cmGmmTrain( cmGmm_t* p, const cmReal_t* xM, unsigned xN, unsigned* iterCntPtr )
+// Sufficient statistics of a GMM accumulated during the E-step.
+typedef struct
 {
-  unsigned i,k;
-  cmRC_t rc;
-
-  if((rc = cmGmmRandomize(p,xM,xN)) != cmOkRC )
-    return rc;
+  cmReal_t* swV;   // swV[K]     sum of the component weights
+  cmReal_t* s1M;   // s1M[D,K]   weighted sum of the deviations from the current mean
+  cmReal_t* s2M;   // s2M[DD,K]  weighted sum of the outer products of the deviations from the current mean
+} _cmGmmStats_t;
 
-  //cmGmmPrint(c,p);
-
-  // wM[xN,K]
-  cmReal_t wM[ xN * p->K ]; // wM[N,K] soft assignment mtx
-  unsigned wV[ xN ];        // wV[N]   hard assignment vector
-  unsigned stopCnt = 0;
-  unsigned curStopCnt = 0;
-
-  if( iterCntPtr != NULL )
-  {
-    stopCnt     = *iterCntPtr;
-    *iterCntPtr = 0;
-  }
-  else
-  {
-    // BUG BUG BUG 
-    // stopCnt is used uninitialized when iterCntPtr == NULL
-    assert( 0 );
-  }
+void _cmGmmStatsAlloc( _cmGmmStats_t* s, unsigned K, unsigned D )
+{
+  s->swV = cmMemAllocZ(cmReal_t, K + D*K + D*D*K );
+  s->s1M = s->swV + K;
+  s->s2M = s->s1M + D*K;
+}
 
-  while(1)
-  {
+void _cmGmmStatsFree( _cmGmmStats_t* s )
+{ cmMemPtrFree(&s->swV); }
 
-    //cmVOR_NormalizeProbability(p->gV,p->K);
+void _cmGmmStatsZero( _cmGmmStats_t* s, unsigned K, unsigned D )
+{ cmVOR_Zero(s->swV, K + D*K + D*D*K ); }
 
-    cmCtxPrint(p->obj.ctx,"iter:%i --------------------------------------------\n",*iterCntPtr );
+// d += s
+void _cmGmmStatsAdd( _cmGmmStats_t* d, const _cmGmmStats_t* s, unsigned K, unsigned D )
+{ cmVOR_AddVV(d->swV, K + D*K + D*D*K, s->swV ); }
 
-    cmVOR_PrintL("uM:\n", p->obj.err.rpt, p->D, p->K, p->uM );
-    cmVOR_PrintL("gV:\n", p->obj.err.rpt, 1,    p->K, p->gV );
+// Accumulate the statistics of the observations xM[D,xN] (xN <= kBlkFrmCntGmm) weighted by
+// their responsibilities wM[i + k*wStride].  dM[D,xN] and zM[D,xN] are scratch matrices.
+void _cmGmmStatsAccum( const cmGmm_t* p, _cmGmmStats_t* s, const cmReal_t* xM, unsigned xN, const cmReal_t* wM, unsigned wStride, cmReal_t* dM, cmReal_t* zM )
+{
+  unsigned D = p->D;
+  unsigned i,k;
 
-    //cmGmmPrint(c,p);
+  for(k=0; k<p->K; ++k)
+  {
+    const cmReal_t* wV  = wM + k*wStride;
+    cmReal_t*       s1V = s->s1M + k*D;
 
-    for(k=0; k<p->K; ++k)
+    for(i=0; i<xN; ++i)
     {
-      cmReal_t* wp = wM + (k*xN);
-   
-      // calc the prob that each data point in xM[] was generated by the kth gaussian
-      // and store as a column vector in wM[:,k]
-      cmVOR_MultVarGaussPDF2( wp, xM, p->uM + (k*p->D), p->isMM + (k*p->D*p->D), p->logDetV[k], p->D, xN, cmIsFlag(p->uflags,cmGmmDiagFl) );
-
-        
-      // scale the prob by the gain coeff for gaussian k
-      cmVOR_MultVS( wp, xN, p->gV[k]);
-
+      cmVOR_SubVVV( dM + i*D, D, xM + i*D, p->uM + k*D ); // dM[:,i] = xM[:,i] - uM[:,k]
+      cmVOR_MultVVS(zM + i*D, D, dM + i*D, wV[i] );       // zM[:,i] = dM[:,i] * w[i]
+      cmVOR_AddVV(  s1V,      D, zM + i*D );
+      s->swV[k] += wV[i];
     }
 
+    // s2M[:,:,k] += zM * dM'
+    cmVOR_MultMMM1( s->s2M + k*D*D, D, D, 1.0, zM, dM, xN, 1.0, kTransposeM1Fl );
+  }
+}
 
+// Update the mean and/or covariance of component k from the statistics in 's'.
+// If 'newMeanCovarFl' is set the covariance is calculated about the updated
+// mean otherwise it is calculated about the mean which was used to accumulate 's'.
+void _cmGmmStatsUpdateComp( cmGmm_t* p, const _cmGmmStats_t* s, unsigned k, bool meanFl, bool covarFl, bool newMeanCovarFl )
+{
+  unsigned        D   = p->D;
+  cmReal_t        sw  = s->swV[k];
+  const cmReal_t* s1V = s->s1M + k*D;
+  const cmReal_t* s2M = s->s2M + k*D*D;
+  cmReal_t*       sM  = p->sMM + k*D*D;
+  cmReal_t        dV[D];  // dV[] = updated mean - previous mean
+  unsigned        i,j;
 
-    //cmVOR_PrintL("wM:\n",p->obj.err.rpt,xN,p->K,wM);
+  cmVOR_Zero(dV,D);
 
-    bool doneFl = true;
-    for(i=0; i<xN; ++i)
-    {        
-      
-      // form a probability for the ith data point weights
-      cmVOR_NormalizeProbabilityN( wM + i, p->K, xN);
- 
-      // select the cluster to which the ith data point is most likely to belong
-      unsigned mi = cmVOR_MaxIndex(wM + i, p->K, xN);
+  if( meanFl && sw != 0 )
+  {
+    cmVOR_DivVVS( dV, D, s1V, sw );
+    cmVOR_AddVV(  p->uM + k*D, D, dV );
+  }
 
-      // if the ith data point changed clusters
-      if( mi != wV[i] )
-      {
-        doneFl = false;
-        wV[i]  = mi;
-      }
-    }
+  if( covarFl )
+  {
+    if( !newMeanCovarFl )
+      cmVOR_Zero(dV,D);
 
-    curStopCnt = doneFl ? curStopCnt+1 : 0;
-    
+    // sum(w .* (x-u1)*(x-u1)') = s2 - s1*d' - d*s1' + sw*d*d'  where d = u1-u0
+    for(j=0; j<D; ++j)
+      for(i=0; i<D; ++i)
+        sM[ i + j*D ] = s2M[ i + j*D ] - s1V[i]*dV[j] - dV[i]*s1V[j] + sw*dV[i]*dV[j];
 
-    // if no data points changed owners then the clustering is complete
-    if( curStopCnt == stopCnt )
-    {
-      //cmVOU_PrintL("wV: ",p->obj.err.rpt,xN,1,wV);
-      break;
-    }
+    if( sw != 0 )
+      cmVOR_DivVS( sM, D*D, sw );
+  }
+}
 
-    // for each cluster
-    for(k=0; k<p->K; ++k)
-    {
-      cmReal_t* uV  = p->uM  + (k*p->D);            // meanV[k]
-      cmReal_t* sM  = p->sMM + (k*p->D*p->D);       // covarM[k]
+// E-step state for a single partition of the observations.
+// The partitions are run as tasks on a thread pool with thCnt-1 worker threads.
+typedef struct _cmGmmThread_str
+{
+  cmGmm_t**        gV;        // gV[gN] models whose statistics are accumulated
+  unsigned         gN;        
+  _cmGmmStats_t*   sV;        // sV[gN] statistics accumulated by this partition
+  unsigned         begIdx;    // first observation in this partition
+  unsigned         cnt;       // count of observations in this partition
+  cmReal_t*        xM;        // xM[D,kBlkFrmCntGmm] observation block
+  cmReal_t*        wM;        // wM[kBlkFrmCntGmm,K] responsibilities
+  cmReal_t*        dM;        // dM[D,kBlkFrmCntGmm] scratch
+  cmReal_t*        zM;        // zM[D,kBlkFrmCntGmm] scratch
+
+  // cmGmmTrain2() 
+  cmGmmReadFunc_t  readFunc;
+  void*            userPtr;
+  unsigned*        hardV;     // hardV[xN] hard assignment of each observation (shared - only [begIdx:begIdx+cnt) is written)
+  unsigned         chgCnt;    // count of observations in this partition whose hard assignment changed
+
+  // cmChmmTrain()
+  const cmReal_t*  oM;        // oM[D,T] observations
+  const cmReal_t*  gammaM;    // gammaM[T,K,N] component occupation probabilities 
+  unsigned         T;
+
+  void           (*func)( struct _cmGmmThread_str* t );
+  cmThreadPoolH_t  poolH;     // thread pool (only used in thV[0])
+} _cmGmmThread_t;
+
+// Partition xN observations between at most thCnt threads (but no more than one per block).
+// Returns the count of partitions allocated.
+unsigned _cmGmmThreadsAlloc( _cmGmmThread_t** thVRef, unsigned thCnt, cmGmm_t** gV, unsigned gN, unsigned xN, void (*func)( _cmGmmThread_t* t ) )
+{
+  unsigned        K      = gV[0]->K;
+  unsigned        D      = gV[0]->D;
+  unsigned        B      = kBlkFrmCntGmm;
+  unsigned        begIdx = 0;
+  unsigned        i,j;
+  _cmGmmThread_t* thV;
+
+  thCnt   = cmMax(1,cmMin(thCnt,(xN + B - 1)/B));
+  thV     = cmMemAllocZ(_cmGmmThread_t,thCnt);
+  *thVRef = thV;
+
+  for(i=0; i<thCnt; ++i)
+  {
+    _cmGmmThread_t* t = thV + i;
+
+    t->gV     = gV;
+    t->gN     = gN;
+    t->sV     = cmMemAllocZ(_cmGmmStats_t,gN);
+    t->begIdx = begIdx;
+    t->cnt    = (xN - begIdx) / (thCnt - i);
+    t->xM     = cmMemAllocZ(cmReal_t, 3*D*B + B*K );
+    t->dM     = t->xM + D*B;
+    t->zM     = t->dM + D*B;
+    t->wM     = t->zM + D*B;
+    t->func   = func;
+    t->poolH  = cmThreadPoolNullHandle;
+    begIdx   += t->cnt;
+
+    for(j=0; j<gN; ++j)
+      _cmGmmStatsAlloc(t->sV + j, K, D );
+  }
 
-      cmReal_t  sw  = cmVOR_Sum(wM + (k*xN), xN ); 
+  return thCnt;
+}
 
+void _cmGmmThreadTask( void* arg, unsigned taskIdx )
+{
+  _cmGmmThread_t* t = ((_cmGmmThread_t*)arg) + taskIdx;
+  t->func(t);
+}
 
-      // update the kth weight
-      p->gV[k] = sw / xN;
+// Create the thread pool which runs thV[0:thCnt-1].
+cmRC_t _cmGmmThreadsStart( cmObj* obj, _cmGmmThread_t* thV, unsigned thCnt )
+{
+  if( thCnt > 1 )
+    if( cmThreadPoolCreate(&thV->poolH,thCnt-1,obj->err.rpt) != kOkThRC )
+      return cmCtxRtCondition(obj, cmSubSysFailRC, "The GMM thread pool create failed.");
 
+  return cmOkRC;
+}
 
-      // form a sum of all data points weighted by their soft assignment to cluster k      
-      cmReal_t sumV[p->D];      
-      cmVOR_MultVMV( sumV, p->D, xM, xN, wM + k*xN );
+void _cmGmmThreadsFree( _cmGmmThread_t** thVRef, unsigned thCnt )
+{
+  _cmGmmThread_t* thV = *thVRef;
+  unsigned        i,j;
 
-      // update the mean[k]
-      cmVOR_DivVVS(uV, p->D, sumV, sw );
-         
+  if( thV == NULL )
+    return;
 
-      // update the covar[k]
-      // sM += ( W(i,k) .* ((X(:,i) - uV) * (X(:,i) - uV)')); 
-      cmVOR_Fill(sM,p->D*p->D,0);
-      for(i=0; i<xN; ++i)
-      {
-        cmReal_t duV[ p->D ];
-        
-        cmVOR_SubVVV(  duV,  p->D, xM + (i*p->D), uV );      // duV[]  = xM[:,i] - uV[];
-        cmVOR_MultMMM( p->t, p->D, p->D, duV, duV, 1 );      // t[,]   = duV[] * duV[]' 
-        cmVOR_MultVS(  p->t, p->D*p->D, wM[ k * xN + i ]);   // t[,]  *= wM[i,k]
-        cmVOR_AddVV(   sM, p->D*p->D, p->t );                // sM[,] += t[,];
-      }          
+  if( cmThreadPoolIsValid(thV->poolH) )
+    cmThreadPoolDestroy(&thV->poolH);
 
-      cmVOR_DivVS( sM, p->D*p->D, sw );  // sM[,] ./ sw;
-    }  
+  for(i=0; i<thCnt; ++i)
+  {
+    _cmGmmThread_t* t = thV + i;
 
-    // update the inverted covar mtx and covar det.
-    if((rc = _cmGmmUpdateCovar(p,p->sMM )) != cmOkRC )
-      return rc;
+    for(j=0; j<t->gN; ++j)
+      _cmGmmStatsFree(t->sV + j);
 
-    if( iterCntPtr != NULL )
-      *iterCntPtr += 1;
+    cmMemPtrFree(&t->sV);
+    cmMemPtrFree(&t->xM);
   }
-  return cmOkRC;
+
+  cmMemPtrFree(thVRef);
 }
 
-// xM[D,xN]
-cmRC_t cmGmmTrain2( cmGmm_t* p, cmGmmReadFunc_t readFunc, void* userFuncPtr, unsigned xN, unsigned* iterCntPtr, const cmReal_t* uM, const bool* roFlV, int maxIterCnt )
+// Run every partition and sum the statistics into thV[0].sV[] and thV[0].chgCnt.
+void _cmGmmThreadsRun( _cmGmmThread_t* thV, unsigned thCnt )
 {
-  unsigned i,j,k;
-  cmRC_t rc;
+  unsigned i,j;
+  unsigned K = thV->gV[0]->K;
+  unsigned D = thV->gV[0]->D;
 
-  // if uM[] is not set then ignore roFlV[]
-  if( uM == NULL )
-    roFlV=NULL;
+  if( thCnt == 1 )
+    thV->func(thV);
+  else
+    cmThreadPoolRun(thV->poolH,_cmGmmThreadTask,thV,thCnt);
 
-  if((rc = cmGmmRandomize2(p,readFunc,userFuncPtr,xN,uM,roFlV)) != cmOkRC )
-    return rc;
+  for(i=1; i<thCnt; ++i)
+  {
+    _cmGmmThread_t* t = thV + i;
 
-  //cmGmmPrint(c,p);
+    for(j=0; j<thV->gN; ++j)
+      _cmGmmStatsAdd(thV->sV + j, t->sV + j, K, D );
 
-  // wM[xN,K] soft assignment mtx
-  cmReal_t* wM = cmMemAlloc(cmReal_t, xN * p->K ); 
+    thV->chgCnt += t->chgCnt;
+  }
+}
 
-  // wV[N]   hard assignment vector
-  unsigned* wV = cmMemAlloc(unsigned, xN );
-        
-  unsigned stopCnt    = 0;
-  unsigned curStopCnt = 0;
+// cmGmmTrain2() E-step for one partition.
+void _cmGmmTrainPartition( _cmGmmThread_t* t )
+{
+  const cmGmm_t* p      = t->gV[0];
+  unsigned       D      = p->D;
+  unsigned       K      = p->K;
+  unsigned       B      = kBlkFrmCntGmm;
+  unsigned       endIdx = t->begIdx + t->cnt;
+  unsigned       i,j,n;
 
-  if( iterCntPtr != NULL )
-  {
-    stopCnt     = *iterCntPtr;
-    *iterCntPtr = 0;
-  }
-  else
-  {
-    // BUG BUG BUG 
-    // stopCnt is used uninitialized when iterCntPtr == NULL
-    assert( 0 );
-  }
+  _cmGmmStatsZero(t->sV,K,D);
+  t->chgCnt = 0;
 
-  while(1)
+  for(i=t->begIdx; i<endIdx; i+=n)
   {
+    n = cmMin(B,endIdx-i);
 
-    //cmCtxPrint(p->obj.ctx,"iter:%i --------------------------------------------\n",*iterCntPtr );
-    //cmVOR_PrintL("uM:\n", p->obj.err.rpt, p->D, p->K, p->uM );
-    cmVOR_PrintL("gV:\n", p->obj.err.rpt, 1,    p->K, p->gV );
-    //cmGmmPrint(c,p);
-
-    for(k=0; k<p->K; ++k)
+    for(j=0; j<n; ++j)
     {
-      cmReal_t* wp = wM + (k*xN);
-   
-      // calc the prob that each data point in xM[] was generated by the kth gaussian
-      // and store as a column vector in wM[:,k]
-      cmVOR_MultVarGaussPDF3( wp, readFunc, userFuncPtr, p->uM + (k*p->D), p->isMM + (k*p->D*p->D), p->logDetV[k], p->D, xN, cmIsFlag(p->uflags,cmGmmDiagFl) );
-
-        
-      // scale the prob by the gain coeff for gaussian k
-      cmVOR_MultVS( wp, xN, p->gV[k]);
+      const cmReal_t* xV = t->readFunc( t->userPtr, i+j );
+      
+      assert( xV != NULL );
 
+      cmVOR_Copy( t->xM + j*D, D, xV );
     }
 
-    //cmVOR_PrintL("wM:\n",p->obj.err.rpt,xN,p->K,wM);
+    // calc the prob that each data point was generated by each component
+    _cmGmmEvalBlock(p, t->xM, n, t->wM, B, t->dM, t->zM );
 
-    bool doneFl = true;
-    unsigned changeCnt = 0;
-    for(i=0; i<xN; ++i)
-    {        
-      
-      // form a probability for the ith data point weights
-      cmVOR_NormalizeProbabilityN( wM + i, p->K, xN);
- 
-      // select the cluster to which the ith data point is most likely to belong
-      unsigned mi = cmVOR_MaxIndex(wM + i, p->K, xN);
+    for(j=0; j<n; ++j)
+    {
+      // form a probability for the jth data point weights
+      cmVOR_NormalizeProbabilityN( t->wM + j, K, B );
+
+      // select the cluster to which the jth data point is most likely to belong
+      unsigned mi = cmVOR_MaxIndex( t->wM + j, K, B );
 
-      // if the ith data point changed clusters
-      if( mi != wV[i] )
+      // if the jth data point changed clusters
+      if( mi != t->hardV[i+j] )
       {
-        ++changeCnt;
-        doneFl = false;
-        wV[i]  = mi;
+        ++t->chgCnt;
+        t->hardV[i+j] = mi;
       }
     }
 
-    curStopCnt = doneFl ? curStopCnt+1 : 0;
-    
-    printf("%i stopCnt:%i changeCnt:%i\n",*iterCntPtr,curStopCnt,changeCnt);
+    _cmGmmStatsAccum(p, t->sV, t->xM, n, t->wM, B, t->dM, t->zM );
+  }
+}
 
-    // if no data points changed owners then the clustering is complete
-    if( curStopCnt == stopCnt )
-    {
-      //cmVOU_PrintL("wV: ",p->obj.err.rpt,xN,1,wV);
-      break;
-    }
+cmRC_t _cmGmmTrain( cmGmm_t* p, cmGmmReadFunc_t readFunc, void* userFuncPtr, unsigned xN, unsigned* iterCntPtr, const bool* roFlV, int maxIterCnt )
+{
+  cmRC_t          rc         = cmOkRC;
+  unsigned        stopCnt    = 1;
+  unsigned        curStopCnt = 0;
+  unsigned        iterCnt    = 0;
+  unsigned*       hardV      = cmMemAlloc(unsigned, xN ); // hardV[xN] hard assignment vector
+  _cmGmmThread_t* thV        = NULL;
+  unsigned        thCnt      = _cmGmmThreadsAlloc(&thV, p->thCnt, &p, 1, xN, _cmGmmTrainPartition );
+  unsigned        i,k;
 
-    // if a maxIterCnt was given and the cur iter cnt exceeds the max iter cnt then stop
-    if( maxIterCnt>=1 && *iterCntPtr >= maxIterCnt )
-      break;
+  cmVOU_Fill(hardV,xN,cmInvalidIdx);
 
-    // form a sum of all data points weighted by their soft assignment to cluster k      
-    // NOTE: cmGmmTrain() performs this step more efficiently because it use
-    //       an LAPACK matrix multiply.  
-    cmReal_t sumM[ p->D * p->K ];
+  for(i=0; i<thCnt; ++i)
+  {
+    thV[i].readFunc = readFunc;
+    thV[i].userPtr  = userFuncPtr;
+    thV[i].hardV    = hardV;
+  }
 
-    cmVOR_Zero(sumM,p->D*p->K);
+  if((rc = _cmGmmThreadsStart(&p->obj,thV,thCnt)) != cmOkRC )
+    goto errLabel;
 
-    for(i=0; i<xN; ++i)
-    {
-      const cmReal_t* xV = readFunc( userFuncPtr, i );
-      
-      assert( xV != NULL );
+  if( iterCntPtr != NULL )
+    stopCnt = *iterCntPtr;
 
-      for(k=0; k<p->K; ++k)
-      {
-        cmReal_t weight = wM[ i + (k*xN)];
+  while(1)
+  {
+    _cmGmmThreadsRun(thV,thCnt);
 
-        for(j=0; j<p->D; ++j)
-          sumM[ j + (k*p->D) ] += xV[j] * weight;
-      }
-    }
+    curStopCnt = thV->chgCnt==0 ? curStopCnt+1 : 0;
 
+    // if no data points changed owners then the clustering is complete
+    if( curStopCnt == stopCnt )
+      break;
 
+    // if a maxIterCnt was given and the cur iter cnt exceeds the max iter cnt then stop
+    if( maxIterCnt>=1 && iterCnt >= maxIterCnt )
+      break;
 
-    // for each cluster that is not marked as read-only
     for(k=0; k<p->K; ++k)
     {
-      cmReal_t* uV  = p->uM  + (k*p->D);            // meanV[k]
-      cmReal_t* sM  = p->sMM + (k*p->D*p->D);       // covarM[k]
-
-      cmReal_t  sw  = cmVOR_Sum(wM + (k*xN), xN ); 
-
-
       // update the kth weight
-      p->gV[k] = sw / xN;
+      p->gV[k] = thV->sV->swV[k] / xN;
 
+      // update the mean (if it is not read-only) and the covariance
+      _cmGmmStatsUpdateComp(p, thV->sV, k, roFlV==NULL || roFlV[k]==false, true, true );
+    }
 
-      // if this component's mean is not read-only
-      if( (roFlV==NULL || roFlV[k]==false) && sw != 0)
-      {
-        // get vector of all data points weighted by their soft assignment to cluster k      
-        cmReal_t* sumV = sumM + (k*p->D);  // sumV[p->D];      
+    // update the inverted covar mtx and covar det.
+    if((rc = _cmGmmUpdateCovar(p,p->sMM )) != cmOkRC )
+      goto errLabel;
 
-        // update the mean[k]
-        cmVOR_DivVVS(uV, p->D, sumV, sw );
-      }  
+    ++iterCnt;
+  }
 
-      // update the covar[k]
-      // sM += ( W(i,k) .* ((X(:,i) - uV) * (X(:,i) - uV)')); 
-      cmVOR_Fill(sM,p->D*p->D,0);
-      for(i=0; i<xN; ++i)
-      {
-        cmReal_t duV[ p->D ];
+ errLabel:
+  if( iterCntPtr != NULL )
+    *iterCntPtr = iterCnt;
 
-        const cmReal_t* xV = readFunc( userFuncPtr, i );
-        
-        assert( xV != NULL );
+  _cmGmmThreadsFree(&thV,thCnt);
+  cmMemPtrFree(&hardV);
 
-        
-        cmVOR_SubVVV(  duV,  p->D, xV, uV );                 // duV[]  = xM[:,i] - uV[];
-        cmVOR_MultMMM( p->t, p->D, p->D, duV, duV, 1 );      // t[,]   = duV[] * duV[]' 
-        cmVOR_MultVS(  p->t, p->D*p->D, wM[ k * xN + i ]);   // t[,]  *= wM[i,k]
-        cmVOR_AddVV(   sM, p->D*p->D, p->t );                // sM[,] += t[,];
-      }          
+  return rc;
+}
 
-      if( sw != 0 )        
-        cmVOR_DivVS( sM, p->D*p->D, sw );  // sM[,] ./ sw;
-    }  
+// xM[D,xN]
+cmRC_t cmGmmTrain( cmGmm_t* p, const cmReal_t* xM, unsigned xN, unsigned* iterCntPtr )
+{
+  cmRC_t rc;
+  _cmGmmRdFuncData_t r;
+  r.colCnt = xN;
+  r.p      = p;
+  r.xM     = xM;
 
-    // update the inverted covar mtx and covar det.
-    if((rc = _cmGmmUpdateCovar(p,p->sMM )) != cmOkRC )
-      goto errLabel;
+  if((rc = cmGmmRandomize(p,xM,xN)) != cmOkRC )
+    return rc;
 
-    if( iterCntPtr != NULL )
-      *iterCntPtr += 1;
-  }
+  return _cmGmmTrain(p,_cmGmmReadFunc,&r,xN,iterCntPtr,NULL,-1);
+}
+
+// xM[D,xN]
+cmRC_t cmGmmTrain2( cmGmm_t* p, cmGmmReadFunc_t readFunc, void* userFuncPtr, unsigned xN, unsigned* iterCntPtr, const cmReal_t* uM, const bool* roFlV, int maxIterCnt )
+{
+  cmRC_t rc;
 
-  cmMemPtrFree(&wM);
-  cmMemPtrFree(&wV);
+  // if uM[] is not set then ignore roFlV[]
+  if( uM == NULL )
+    roFlV=NULL;
 
- errLabel:
+  if((rc = cmGmmRandomize2(p,readFunc,userFuncPtr,xN,uM,roFlV)) != cmOkRC )
+    return rc;
 
-  return cmOkRC;
+  return _cmGmmTrain(p,readFunc,userFuncPtr,xN,iterCntPtr,roFlV,maxIterCnt);
 }
 
 cmRC_t cmGmmTrain3( cmGmm_t* p, const cmReal_t* xM, unsigned xN, unsigned* iterCntPtr )
@@ -3811,6 +4045,101 @@ void cmGmmTest(  cmRpt_t* rpt, cmLHeapH_t lhH, cmSymTblH_t stH )
 
 }
 
+void cmGmmEMTest( cmRpt_t* rpt, cmLHeapH_t lhH, cmSymTblH_t stH )
+{
+  cmCtx*       c        = cmCtxAlloc(NULL,rpt,lhH,stH);
+  unsigned     K        = 8;
+  unsigned     D        = 16;
+  unsigned     xN       = 10000;
+  unsigned     thCntV[] = { 1, 2, 4 };
+  unsigned     thN      = sizeof(thCntV)/sizeof(thCntV[0]);
+  cmReal_t*    gV       = cmMemAlloc(cmReal_t,K);
+  cmReal_t*    uM       = cmMemAlloc(cmReal_t,D*K);
+  cmReal_t*    sMM      = cmMemAlloc(cmReal_t,D*D*K);
+  cmReal_t*    xM       = cmMemAlloc(cmReal_t,D*xN);
+  cmReal_t*    yV       = cmMemAlloc(cmReal_t,xN);
+  cmReal_t*    yM       = cmMemAlloc(cmReal_t,xN*K);
+  cmReal_t*    rM       = cmMemAlloc(cmReal_t,xN*K);
+  cmReal_t*    u0M      = cmMemAlloc(cmReal_t,D*K);
+  cmReal_t     maxErr   = 0;
+  cmTimeSpec_t t0,t1;
+  unsigned     i,k,blkUs,refUs;
+  _cmGmmRdFuncData_t r;
+
+  srand(1);
+  cmVOR_Fill(gV,K,1.0/K);
+  cmVOR_Random(uM,D*K,-5.0,5.0);
+
+  for(k=0; k<K; ++k)
+    cmVOR_RandSymPosDef(sMM + k*D*D, D, NULL );
+
+  cmGmm_t* p = cmGmmAlloc(c,NULL,K,D,gV,uM,sMM,0);
+
+  cmGmmGenerate(p,xM,xN);
+
+  // blocked evaluation
+  cmTimeGetMonotonic(&t0);
+  cmGmmEval(p,xM,xN,yV,yM);
+  cmTimeGetMonotonic(&t1);
+  blkUs = cmTimeElapsedMicros(&t0,&t1);
+
+  // reference evaluation - one observation at a time 
+  cmTimeGetMonotonic(&t0);
+  for(k=0; k<K; ++k)
+  {
+    cmVOR_MultVarGaussPDF2( rM + k*xN, xM, p->uM + k*D, p->isMM + k*D*D, p->logDetV[k], D, xN, false );
+    cmVOR_MultVS( rM + k*xN, xN, p->gV[k] );
+  }
+  cmTimeGetMonotonic(&t1);
+  refUs = cmTimeElapsedMicros(&t0,&t1);
+
+  // the component probabilities span many orders of magnitude - compare them in the log domain
+  for(i=0; i<xN*K; ++i)
+    if( rM[i] > 0 && yM[i] > 0 )
+      maxErr = cmMax(maxErr,fabs(log(yM[i]) - log(rM[i])));
+
+  cmRptPrintf(rpt,"eval K:%i D:%i N:%i blocked:%i us reference:%i us max log err:%e\n",K,D,xN,blkUs,refUs,maxErr);
+
+  r.colCnt = xN;
+  r.p      = p;
+  r.xM     = xM;
+
+  for(i=0; i<thN; ++i)
+  {
+    unsigned iterCnt = 1;
+    cmReal_t maxDiff = 0;
+
+    // use the same initial parameters for every thread count
+    srand(2);
+
+    cmGmmSetThreadCount(p,thCntV[i]);
+
+    cmTimeGetMonotonic(&t0);
+    if( cmGmmTrain2(p,_cmGmmReadFunc,&r,xN,&iterCnt,NULL,NULL,20) != cmOkRC )
+      break;
+    cmTimeGetMonotonic(&t1);
+
+    if( i == 0 )
+      cmVOR_Copy(u0M,D*K,p->uM);
+
+    for(k=0; k<D*K; ++k)
+      maxDiff = cmMax(maxDiff,fabs(p->uM[k] - u0M[k]));
+
+    cmRptPrintf(rpt,"train threads:%i iter:%i %i us/iter max mean diff:%e\n",thCntV[i],iterCnt,cmTimeElapsedMicros(&t0,&t1)/cmMax(1,iterCnt),maxDiff);
+  }
+
+  cmGmmFree(&p);
+  cmMemFree(gV);
+  cmMemFree(uM);
+  cmMemFree(sMM);
+  cmMemFree(xM);
+  cmMemFree(yV);
+  cmMemFree(yM);
+  cmMemFree(rM);
+  cmMemFree(u0M);
+  cmCtxFree(&c);
+}
+
 //------------------------------------------------------------------------------------------------------------
 cmChmm_t* cmChmmAlloc( cmCtx* c, cmChmm_t* ap, unsigned stateN, unsigned mixN, unsigned dimN, const cmReal_t* iV, const cmReal_t* aM )
 {
@@ -3874,7 +4203,10 @@ cmRC_t    cmChmmInit(  cmChmm_t* p, unsigned stateN, unsigned mixN, unsigned dim
     cmVOR_Copy(p->aM,p->N*p->N,aM);
 
   for(i=0; i<p->N; ++i)
+  {
     p->bV[i] = cmGmmAlloc( p->obj.ctx, NULL, p->K, p->D, NULL, NULL, NULL, 0 ); 
+    cmGmmSetThreadCount(p->bV[i],p->thCnt);
+  }
 
   //p->mfp = cmCtxAllocDebugFile( p->obj.ctx,"chmm");
 
@@ -3899,6 +4231,19 @@ cmRC_t    cmChmmFinal( cmChmm_t* p )
   return cmOkRC; 
 }
 
+cmRC_t    cmChmmSetThreadCount( cmChmm_t* p, unsigned thCnt )
+{
+  unsigned i;
+
+  p->thCnt = thCnt;
+
+  for(i=0; i<p->N; ++i)
+    if( p->bV[i] != NULL )
+      cmGmmSetThreadCount(p->bV[i],thCnt);
+
+  return cmOkRC;
+}
+
 cmRC_t      cmChmmRandomize( cmChmm_t* p, const cmReal_t* oM, unsigned T )
 {
   cmRC_t rc;
@@ -3925,8 +4270,19 @@ cmRC_t      cmChmmRandomize( cmChmm_t* p, const cmReal_t* oM, unsigned T )
   return cmOkRC;
 }
 
-cmReal_t  _cmChmmKmeansDist( void* userPtr, const cmReal_t* v0, const cmReal_t* v1, unsigned vn )
-{ return cmVOR_EuclidDistance(v0,v1,vn); }
+typedef struct
+{
+  const cmReal_t* oM;      // oM[D,T] observations
+  unsigned        D;
+  const unsigned* selIdxV; // selIdxV[T] (optional) state assignment of each observation 
+  unsigned        selKey;  // state to cluster 
+} _cmChmmKmeansSrc_t;
+
+const cmReal_t* _cmChmmKmeansSrcFunc( void* userPtr, unsigned frmIdx )
+{
+  const _cmChmmKmeansSrc_t* r = (const _cmChmmKmeansSrc_t*)userPtr;
+  return r->selIdxV==NULL || r->selIdxV[frmIdx]==r->selKey ? r->oM + frmIdx*r->D : NULL;
+}
 
 cmRC_t    cmChmmSegKMeans( cmChmm_t* p, const cmReal_t* oM, unsigned T, cmReal_t threshProb, unsigned maxIterCnt, unsigned iterCnt )
 {
@@ -3964,11 +4320,12 @@ cmRC_t    cmChmmSegKMeans( cmChmm_t* p, const cmReal_t* oM, unsigned T, cmReal_t
 
   cmReal_t logPr = 0;
   bool reportFl = true;
+  _cmChmmKmeansSrc_t r = { oM, D, NULL, 0 };
 
   cmChmmRandomize(p,oM,T);
   
   // cluster the observations into N groups
-  cmVOR_Kmeans( qV, centroidM, N, oM, D, T, NULL, 0, false, _cmChmmKmeansDist, NULL ); 
+  cmVOR_Kmeans3( qV, centroidM, N, _cmChmmKmeansSrcFunc, D, T, &r, NULL, -1, 0, kRandSeedKmFl, p->thCnt, p->obj.err.rpt ); 
 
   for(i=0; i<maxIterCnt; ++i)
   {
@@ -3988,7 +4345,9 @@ cmRC_t    cmChmmSegKMeans( cmChmm_t* p, const cmReal_t* oM, unsigned T, cmReal_t
       cmGmm_t* g = p->bV[j];
       
       // cluster all datapoints which were assigned to state j
-      cmVOR_Kmeans( clusterIdxV, g->uM, K, oM, D, T, qV, j, false, _cmChmmKmeansDist, NULL ); 
+      r.selIdxV = qV;
+      r.selKey  = j;
+      cmVOR_Kmeans3( clusterIdxV, g->uM, K, _cmChmmKmeansSrcFunc, D, T, &r, NULL, -1, 0, kRandSeedKmFl, p->thCnt, p->obj.err.rpt ); 
 
       // for each cluster
       for(k=0; k<K; ++k)
@@ -4302,15 +4661,35 @@ cmRC_t    cmChmmDecode(   cmChmm_t* p, const cmReal_t* oM, unsigned T, unsigned*
 }
 
 
+// cmChmmTrain() mixture statistics for one partition of the time steps.
+void _cmChmmTrainPartition( _cmGmmThread_t* t )
+{
+  unsigned B      = kBlkFrmCntGmm;
+  unsigned endIdx = t->begIdx + t->cnt;
+  unsigned i,j,n;
+
+  for(j=0; j<t->gN; ++j)
+    _cmGmmStatsZero(t->sV + j, t->gV[j]->K, t->gV[j]->D );
+
+  for(i=t->begIdx; i<endIdx; i+=n)
+  {
+    n = cmMin(B,endIdx-i);
+
+    for(j=0; j<t->gN; ++j)
+    {
+      const cmGmm_t* g = t->gV[j];
+      _cmGmmStatsAccum(g, t->sV + j, t->oM + i*g->D, n, t->gammaM + j*g->K*t->T + i, t->T, t->dM, t->zM );
+    }
+  }
+}
+
 cmRC_t    cmChmmTrain( cmChmm_t* p, const cmReal_t* oM, unsigned T, unsigned iterCnt, cmReal_t thresh, unsigned flags )
 {
   cmRC_t   rc = cmOkRC;
-  unsigned i,j,k,t,d;
+  unsigned i,j,k,t;
   unsigned iter;
   unsigned N          = p->N;
   unsigned K          = p->K;
-  unsigned D          = p->D;
-  unsigned De2        = D * D;
   bool     mixFl      = !cmIsFlag(flags,kNoTrainMixCoeffChmmFl);
   bool     meanFl     = !cmIsFlag(flags,kNoTrainMeanChmmFl);
   bool     covarFl    = !cmIsFlag(flags,kNoTrainCovarChmmFl);
@@ -4356,10 +4735,23 @@ cmRC_t    cmChmmTrain( cmChmm_t* p, const cmReal_t* oM, unsigned T, unsigned ite
   cmReal_t* betaM    = cmMemAlloc( cmReal_t, N*T ); 
   cmReal_t* logPrV   = cmMemAlloc( cmReal_t, T ); 
   cmReal_t* EpsM     = cmMemAlloc( cmReal_t, N*N ); 
-  cmReal_t* BK       = cmMemAlloc( cmReal_t, N*K*T ); 
+  cmReal_t* BK       = cmMemAlloc( cmReal_t, N*K*T ); // BK[T,K,N]
   cmReal_t* gamma_jk = cmMemAlloc( cmReal_t, N*K ); 
-  cmReal_t* uM       = cmMemAlloc( cmReal_t, K*D*N ); 
-  cmReal_t* sMM      = cmMemAlloc( cmReal_t, K*De2*N ); 
+  cmReal_t* bV       = cmMemAlloc( cmReal_t, T );
+
+  // the mixture statistics are accumulated over T-1 time steps
+  _cmGmmThread_t* thV   = NULL;
+  unsigned        thCnt = bFl && T>0 ? _cmGmmThreadsAlloc(&thV, p->thCnt, p->bV, N, T-1, _cmChmmTrainPartition ) : 0;
+
+  for(i=0; i<thCnt; ++i)
+  {
+    thV[i].oM     = oM;
+    thV[i].gammaM = BK;
+    thV[i].T      = T;
+  }
+
+  if((rc = _cmGmmThreadsStart(&p->obj,thV,thCnt)) != cmOkRC )
+    goto errLabel;
 
   if( thresh <=0 )
     thresh = 0.0001;
@@ -4369,25 +4761,22 @@ cmRC_t    cmChmmTrain( cmChmm_t* p, const cmReal_t* oM, unsigned T, unsigned ite
 
   for(iter=0; iter<iterCnt; ++iter)
   {
-    // zero the mean and covar summation arrays
-    cmVOR_Fill(uM,  K*D  *N,0);
-    cmVOR_Fill(sMM, K*De2*N,0);
     cmVOR_Fill(EpsM,N*N,    0);
     cmVOR_Fill(gamma_jk,N*K,0);
 
     // 
     // B[i,t]     The prob that state i generated oM(:,t)                                           
-    // BK[i,k,t]  The prob that state i component k generated oM(:,t)
-    // Note: B[i,t] = sum(BK(i,k,:))
+    // BK[t,k,i]  The prob that state i component k generated oM(:,t)
+    // Note: B[i,t] = sum(BK(:,k,i))
     //
     if( calcBFl || bFl )
     {
       calcBFl = false;
-      for(t=0; t<T; ++t)
+      for(i=0; i<N; ++i )
       {
-        // prob. that state i generated objservation O[t]
-        for(i=0; i<N; ++i )
-          cmGmmEval(  p->bV[i], oM + (t*D), 1, p->bM + (t*N) + i, BK + (t*N*K) + (i*K) );
+        // prob. that state i generated each observation 
+        cmGmmEval(  p->bV[i], oM, T, bV, BK + (i*K*T) );
+        cmVOR_CopyN( p->bM + i, T, N, bV, 1 );
       }
     }
 
@@ -4415,10 +4804,6 @@ cmRC_t    cmChmmTrain( cmChmm_t* p, const cmReal_t* oM, unsigned T, unsigned ite
     // for each time step
     for(t=0; t<T-1; ++t)
     {
-      // oV[D] is the observation at step t
-      const cmReal_t* oV = oM + (t*D); 
-
-
       //
       // Update EpsM[N,N] (6.37)
       // (prob. of being in state i at time t and transitioning
@@ -4457,7 +4842,6 @@ cmRC_t    cmChmmTrain( cmChmm_t* p, const cmReal_t* oM, unsigned T, unsigned ite
         // 
         // Calculate gamma_jk[]
         // 
-        cmReal_t gtjk[N*K];  // gamma_jk[N,K] at time t
         cmReal_t abV[N];     //
 
       
@@ -4471,47 +4855,19 @@ cmRC_t    cmChmmTrain( cmChmm_t* p, const cmReal_t* oM, unsigned T, unsigned ite
         cmVOR_DivVS(abV,N,abSum);
 
      
+        // BK[t,k,j] is replaced with gamma[t,k,j] - the prob. of being in state j
+        // at time t with component k accounting for oM(:,t)
         for(j=0; j<N; ++j)
         {
-          cmReal_t bkSum = cmVOR_Sum(BK + (t*N*K) + (j*K), K );
+          cmReal_t* bkV   = BK + (j*K*T) + t;
+          cmReal_t  bkSum = cmVOR_SumN(bkV, K, T );
         
           for(k=0; k<K; ++k)
-            gtjk[ (k*N)+j ]  = abV[j] * (BK[ (t*N*K) + (j*K) + k ] / bkSum);       
-        }
-
-
-        // sum gtjk[N,K] into gamma_jk (integrate gamma over time)
-        cmVOR_AddVV( gamma_jk, N*K, gtjk );
-
-
-        // update the mean and covar numerators
-        for(j=0; j<N; ++j)
-        {
-          cmReal_t* uV = uM  + (j*D*K);
-          cmReal_t* sV = sMM + (j*De2*K);
-
-          for(k=0; k<K; ++k,uV+=D,sV+=De2)
           {
-            cmReal_t c = gtjk[ (k*N)+j ];
-
-            if( covarFl )
-            {
-              cmReal_t dV[D];
-              cmReal_t dM[D*D];
-
-              // covar numerator b[j].sM[k]
-              cmVOR_SubVVV(dV, D, oV, p->bV[j]->uM + (k*D));
-              cmVOR_MultMMM( dM, D, D, dV, dV, 1 );
-              cmVOR_MultVS(  dM, De2, c );
-              cmVOR_AddVV(   sV, De2, dM ); 
-            }
-
-            if( meanFl )
-            {
-              // mean numerator b[j].uM[k]
-              for(d=0; d<D; ++d)
-                uV[d] += c * oV[ d ];
-            }
+            bkV[k*T] = abV[j] * (bkV[k*T] / bkSum);
+
+            // integrate gamma over time
+            gamma_jk[ (k*N)+j ] += bkV[k*T];
           }
         }
       }
@@ -4524,6 +4880,10 @@ cmRC_t    cmChmmTrain( cmChmm_t* p, const cmReal_t* oM, unsigned T, unsigned ite
 
     } // end time loop
 
+    // accumulate the mean and covar numerators using gamma[] as the weights
+    if( bFl )
+      _cmGmmThreadsRun(thV,thCnt);
+
 
     for(i=0; i<N; ++i)
     {
@@ -4539,19 +4899,14 @@ cmRC_t    cmChmmTrain( cmChmm_t* p, const cmReal_t* oM, unsigned T, unsigned ite
       if( bFl )
       {
         // update the mean, covariance and mix coefficient
-        cmGmm_t*        g   = p->bV[i];
-        const cmReal_t* uV  = uM  + (i*D*K);
-        const cmReal_t* sMV = sMM + (i*De2*K);
+        cmGmm_t* g = p->bV[i];
 
-        for(k=0; k<K; ++k,uV+=D,sMV+=De2)
+        for(k=0; k<K; ++k)
         {
           cmReal_t gjk = gamma_jk[ (k*N) + i ];
 
-          if( meanFl )
-            cmVOR_DivVVS(g->uM  + (k*D),   D,   uV,  gjk );
-          
-          if( covarFl )
-            cmVOR_DivVVS(g->sMM + (k*De2), De2, sMV, gjk );
+          // the covariance is calculated about the mean used in the E-step
+          _cmGmmStatsUpdateComp(g, thV->sV + i, k, meanFl, covarFl, false );
 
           if( mixFl )
             g->gV[k] =  gjk / cmVOR_SumN( gamma_jk + i, K, N );
@@ -4594,8 +4949,8 @@ cmRC_t    cmChmmTrain( cmChmm_t* p, const cmReal_t* oM, unsigned T, unsigned ite
   cmMemPtrFree(&EpsM);
   cmMemPtrFree(&BK);
   cmMemPtrFree(&gamma_jk);
-  cmMemPtrFree(&uM);
-  cmMemPtrFree(&sMM);
+  cmMemPtrFree(&bV);
+  _cmGmmThreadsFree(&thV,thCnt);
 
   return rc;
 }
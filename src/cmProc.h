@@ -26,6 +26,8 @@ extern "C" {
     unsigned          endFrmIdx;
     unsigned          curFrmIdx; // frame index of the next frame to read
     cmMtxFile*        mfp;
+    struct cmAudioFileRdStream_str* stream; // read-ahead service or NULL see cmAudioFileRdSetReadAhead()
+    unsigned          underrunCnt; // count of read-ahead reads which were zero filled because the frames were not yet available
   } cmAudioFileRd;
 
   // set p to NULL to dynamically allocate the object
@@ -43,6 +45,15 @@ extern "C" {
   cmRC_t             cmAudioFileRdRead(  cmAudioFileRd* p );
   cmRC_t             cmAudioFileRdSeek(  cmAudioFileRd* p, unsigned frmIdx );
 
+  // Read the file via the shared read-ahead service (see cmAfsSharedAcquire()) which keeps
+  // 'lookAheadFrmCnt' frames read ahead of the current location. cmAudioFileRdRead()
+  // then never waits: if the read-ahead is exhausted the missing frames are returned
+  // as zeros, lastReadFrmCnt is short and underrunCnt is incremented. If the 
+  // background read fails cmAudioFileRdRead() returns an error.
+  // Set 'lookAheadFrmCnt' to 0 to return to synchronous reading. The file must
+  // already be open. The stream is released by cmAudioFileRdClose().
+  cmRC_t             cmAudioFileRdSetReadAhead( cmAudioFileRd* p, unsigned lookAheadFrmCnt );
+
   // Find the overall minimum, maximum, and mean sample values without changing the current file location.
   cmRC_t             cmAudioFileRdMinMaxMean( cmAudioFileRd* p, unsigned chIdx, cmSample_t* minPtr, cmSample_t* maxPtr, cmSample_t* meanPtr );
 
@@ -430,28 +441,35 @@ extern "C" {
   //)
 
   //( { label:cmSRC file_desc:"Sample rate converter" kw:[proc] }
+  //
+  // Rational sample rate converter based on the cmRsmp polyphase resampler.
+  // Each call to cmSRCExec() converts all of the incoming samples and sets outN
+  // to the count of samples available in outV[]. With non-integer ratios outN
+  // varies by one sample from block to block. cmSRCExec() accepts up to procSmpCnt+1
+  // samples so that converters may be chained.
   typedef struct
   {
-    cmObj        obj;
-    cmFilter     filt;
+    cmObj              obj;
+    struct cmRsmp_str* rsmp;
  
     cmSample_t*  outV;
-    unsigned     outN;
+    unsigned     outN;    // count of valid samples in outV[] after cmSRCExec().
+    unsigned     outMaxN; // allocated length of outV[]
 
     unsigned     upFact;
     unsigned     dnFact;
 
-    unsigned     upi;
-    unsigned     dni;
-
     cmMtxFile*   mfp;
 
   } cmSRC;
 
   // The srate paramater is the sample rate of the source signal provided via cmSRCExec()
+  // The output sample rate is srate*upFact/dnFact. cmSRCAlloc() and cmSRCInit() use the
+  // kMedRsmpQ quality preset. Use cmSRCInitQ() to select the quality (see cmResample.h).
   cmSRC* cmSRCAlloc( cmCtx* c, cmSRC* p, double srate, unsigned procSmpCnt, unsigned upFact, unsigned dnFact );
   cmRC_t cmSRCFree(  cmSRC** pp );
   cmRC_t cmSRCInit(  cmSRC* p, double srate, unsigned procSmpCnt, unsigned upFact, unsigned dnFact );
+  cmRC_t cmSRCInitQ( cmSRC* p, double srate, unsigned procSmpCnt, unsigned upFact, unsigned dnFact, unsigned quality );
   cmRC_t cmSRCFinal( cmSRC* p );
   cmRC_t cmSRCExec(  cmSRC* p, const cmSample_t* sp, unsigned sn );
 
@@ -558,6 +576,24 @@ extern "C" {
   //)
 
   //( { label:cmGmm file_desc"Gaussian Mixture Model containing N Gaussian PDF's each of dimension D." kw:[proc model]}
+  //
+  // cmGmmEval() and cmGmmEval2() evaluate the observations in blocks of
+  // kBlkFrmCntGmm columns. For each component the block is centered on the
+  // component mean and multiplied by the inverse of the transposed Cholesky factor
+  // of the covariance matrix (liMM[]) with a single matrix multiply (cblas gemm when
+  // CM_VECTOP is defined). The squared column norms of the result are the
+  // Mahalanobis distances.
+  //
+  // cmGmmTrain() and cmGmmTrain2() compute the responsibilities block by block and
+  // accumulate the sufficient statistics (weight, weighted deviation from the current
+  // mean and weighted deviation outer product sums) with the same gemm path.
+  // The soft assignment matrix is never formed. When the thread count
+  // (cmGmmSetThreadCount()) is greater than one the observations are partitioned
+  // across worker threads, each with private statistics, which are added together
+  // at the end of each pass. In this case the cmGmmReadFunc_t passed to
+  // cmGmmTrain2() must be safe to call concurrently from multiple threads.
+
+  enum { kBlkFrmCntGmm = 128 };
   
   typedef struct
   {
@@ -569,9 +605,11 @@ extern "C" {
     cmReal_t* sMM;    // sMM[D x D x K ] component covariance matrices - each column is a DxD matrix
     cmReal_t* isMM;   // isMM[D x D x K] inverted covar matrices
     cmReal_t* uMM;    // uMM[ D x D x K] upper triangle factor of chol(sMM)
+    cmReal_t* liMM;   // liMM[D x D x K] lower triangle inv(uMM)' - the Mahalanobis distance is sum((liMM*(x-u)).^2)
     cmReal_t* logDetV;// detV[ K ] determinent of covar matrices
     cmReal_t* t;      // t[ D x D  ]scratch matrix used for training
     unsigned  uflags; // user defined flags
+    unsigned  thCnt;  // count of threads used by cmGmmTrain() and cmGmmTrain2() (see cmGmmSetThreadCount())
 
   } cmGmm_t;
 
@@ -582,6 +620,9 @@ extern "C" {
   cmRC_t   cmGmmInit(  cmGmm_t* p, unsigned N, unsigned D, const cmReal_t* gV, const cmReal_t* uM, const cmReal_t* sMM, unsigned flags );
   cmRC_t   cmGmmFinal( cmGmm_t* p );
 
+  // Set the count of threads (including the calling thread) used for training. Default: 1.
+  cmRC_t   cmGmmSetThreadCount( cmGmm_t* p, unsigned thCnt );
+
   // Estimate the parameters of the GMM using the training data in xM[p->D,xN].
   // *iterCntPtr on input is the number of iterations with no change in class assignment to signal convergence.
   // *iterCntPtr on output is the total number of interations required to converge.
@@ -616,6 +657,10 @@ extern "C" {
   void     cmGmmPrint( cmGmm_t* p, bool detailsFl );
 
   void     cmGmmTest( cmRpt_t* rpt, cmLHeapH_t lhH, cmSymTblH_t stH );
+
+  // Verify the blocked evaluation against cmVOR_MultVarGaussPDF2() and report
+  // the evaluation and training time for a range of thread counts.
+  void     cmGmmEMTest( cmRpt_t* rpt, cmLHeapH_t lhH, cmSymTblH_t stH );
   //------------------------------------------------------------------------------------------------------------
   //)
   
@@ -632,6 +677,7 @@ extern "C" {
     cmGmm_t**   bV;       // bV[ N ] observation probability mtx (array of pointers to GMM's) 
     cmReal_t*   bM;       // bM[ N,T]  state-observation probability matrix 
     cmMtxFile* mfp;
+    unsigned    thCnt;    // count of threads used by cmChmmTrain() (see cmChmmSetThreadCount())
   } cmChmm_t;
 
   // Continuous HMM consisting of stateN states where the observations 
@@ -644,6 +690,10 @@ extern "C" {
   cmRC_t    cmChmmInit(     cmChmm_t* p, unsigned stateN, unsigned mixN, unsigned dimN, const cmReal_t* iV, const cmReal_t* aM );
   cmRC_t    cmChmmFinal(    cmChmm_t* p );
 
+  // Set the count of threads (including the calling thread) used to accumulate the
+  // mixture statistics in cmChmmTrain() and by the state GMM's. Default: 1.
+  cmRC_t    cmChmmSetThreadCount( cmChmm_t* p, unsigned thCnt );
+
 
   // Set the iV,aM and bV parameters to well-formed random values. 
   cmRC_t    cmChmmRandomize( cmChmm_t* p, const cmReal_t* oM, unsigned T );
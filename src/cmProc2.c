@@ -23,7 +23,9 @@
 #include "cmGnuPlot.h"
 #include "cmTime.h"
 #include "cmMidi.h"
+#include "cmThread.h"
 #include "cmProc2.h"
+#include "cmFftPlanCache.h"
 
 
 //------------------------------------------------------------------------------------------------------------
@@ -799,8 +801,10 @@ cmRC_t cmFIRFree(       cmFIR** pp )
     if((rc = cmFIRFinal(*pp)) == cmOkRC )
     {
       cmMemPtrFree(&p->coeffV);
+      cmMemPtrFree(&p->hrV);
+      cmMemPtrFree(&p->xV);
+      cmMemPtrFree(&p->bufV);
       cmMemPtrFree(&p->outV);
-      cmMemPtrFree(&p->delayV);
       cmObjFree(pp);
     }
   }
@@ -867,17 +871,17 @@ cmRC_t cmFIRInitKaiser( cmFIR* p, unsigned procSmpCnt, double srate, double pass
 
 cmRC_t cmFIRInitSinc( cmFIR* p, unsigned procSmpCnt, double srate, unsigned sincSmpCnt, double fcHz, unsigned flags, const double* wndV )
 {
-  cmRC_t rc;
+  cmRC_t   rc;
+  unsigned i;
 
   if((rc = cmFIRFinal(p)) != cmOkRC )
     return rc;
 
   p->coeffCnt = sincSmpCnt;
-  p->outV     = cmMemResizeZ( cmSample_t, p->outV, procSmpCnt );
+  p->flags    = flags;
   p->outN     = procSmpCnt;
-  p->coeffV   = cmMemResizeZ( double, p->coeffV, p->coeffCnt );
-  p->delayV   = cmMemResizeZ( double, p->delayV, p->coeffCnt-1 ); // there is always one less delay than coeff
-  p->delayIdx = 0;
+  p->coeffV   = cmMemResizeZ( double,     p->coeffV, p->coeffCnt );
+  p->hrV      = cmMemResizeZ( cmSample_t, p->hrV,    p->coeffCnt );
 
   unsigned lp_flags = kNormalize_LPSincFl;
 
@@ -885,59 +889,143 @@ cmRC_t cmFIRInitSinc( cmFIR* p, unsigned procSmpCnt, double srate, unsigned sinc
 
   cmVOD_LP_Sinc(p->coeffV, p->coeffCnt, wndV, srate, fcHz, lp_flags );
 
-  return cmOkRC;
+  // the block FIR kernel uses time reversed coefficients
+  for(i=0; i<p->coeffCnt; ++i)
+    p->hrV[i] = p->coeffV[ p->coeffCnt - 1 - i ];
+
+  return cmFIRSetChCount(p,1);
 }
 
 cmRC_t cmFIRFinal( cmFIR* p )
-{ return cmOkRC; }
+{
+  unsigned i;
 
-cmRC_t cmFIRExec( cmFIR* p, const cmSample_t* sbp, unsigned sn )
+  if( p != NULL && p->cnvV != NULL )
+  {
+    for(i=0; i<p->chCnt; ++i)
+      cmConvolveFree(p->cnvV + i);
+
+    cmMemPtrFree(&p->cnvV);
+  }
+
+  return cmOkRC;
+}
+
+cmRC_t cmFIRSetChCount( cmFIR* p, unsigned chCnt )
 {
-  unsigned   delayCnt   = p->coeffCnt-1;
-  int        di         = p->delayIdx;     
-  const cmSample_t* sep = sbp + sn;
-  cmSample_t*       op  = p->outV;
+  unsigned i;
 
-  assert( di < delayCnt );
-  assert( sn <= p->outN );
+  assert( chCnt > 0 );
 
-  // for each input sample
-  while( sbp < sep )
-  {		
-    // advance the delay line
-    p->delayIdx = (p->delayIdx + 1) % delayCnt;
+  cmFIRFinal(p);
 
-    const double* cbp = p->coeffV;
-    const double* cep = cbp + p->coeffCnt;
+  p->chCnt = chCnt;
+  p->bi    = 0;
+  p->xN    = p->coeffCnt - 1 + p->outN;
+  p->xV    = cmMemResizeZ( cmSample_t, p->xV,   p->chCnt * p->xN );
+  p->outV  = cmMemResizeZ( cmSample_t, p->outV, p->chCnt * p->outN );
 
-    // mult input sample by coeff[0] 
-    double       v   = *sbp  * *cbp++;
+  if( p->outN > 0 && cmIsFlag(p->flags,kFftFIRFl) )
+  {
+    p->bufV = cmMemResizeZ( cmSample_t, p->bufV, p->chCnt * p->outN );
+    p->cnvV = cmMemAllocZ(  cmConvolve*, p->chCnt );
 
-    // calc the output sample
-    while( cbp<cep)
-    {
-      // note that the delay is being iterated backwards
-      if( di == -1 )
-      di=delayCnt-1;
+    // xV[] (which is always longer than coeffCnt) holds the coefficients
+    // while the convolvers are created and is then cleared
+    cmVOS_CopyD(p->xV,p->coeffCnt,p->coeffV);
+
+    for(i=0; i<p->chCnt; ++i)
+      if((p->cnvV[i] = cmConvolveAlloc(p->obj.ctx,NULL,p->xV,p->coeffCnt,p->outN)) == NULL )
+        return cmCtxRtCondition( &p->obj, cmSubSysFailRC, "The FIR FFT convolver allocation failed.");
 
-      v += *cbp++ * p->delayV[di];			
+    cmVOS_Zero(p->xV,p->chCnt * p->xN);
+  }
+
+  return cmOkRC;
+}
+
+// Apply the direct form filter to the input samples oi:oi+n of the current block
+// (xV[hn+oi:hn+oi+n] of each channel) and write the result to outV[oi:oi+n].
+void _cmFIRExecDirect( cmFIR* p, unsigned oi, unsigned n )
+{
+  if( p->chCnt == 1 )
+    cmVOS_FirVV(p->outV + oi, n, p->xV + oi, p->hrV, p->coeffCnt );
+  else
+    cmVOS_FirMC(p->outV + oi, n, p->outN, p->xV + oi, p->xN, p->chCnt, p->hrV, p->coeffCnt );
+}
 
-      --di;
+cmRC_t cmFIRExecMC( cmFIR* p, const cmSample_t** spp, unsigned chCnt, unsigned sn )
+{
+  unsigned hn = p->coeffCnt - 1;  // length of the history
+  unsigned i;
+
+  assert( sn <= p->outN );
+
+  if( chCnt != p->chCnt )
+    return cmCtxRtCondition( &p->obj, cmArgAssertRC, "The FIR channel count (%i) does not match the configured channel count (%i).",chCnt,p->chCnt);
+
+  // append the input to the history of each channel
+  for(i=0; i<chCnt; ++i)
+    cmVOS_Copy(p->xV + i*p->xN + hn, sn, spp[i] );
+
+  if( p->cnvV == NULL )
+    _cmFIRExecDirect(p,0,sn);
+  else
+  {
+    // n0 samples fill (or extend) the current convolver input block
+    unsigned n0 = cmMin(sn, p->outN - p->bi);
+    unsigned bi = p->bi;
+
+    for(i=0; i<chCnt; ++i)
+      cmVOS_Copy(p->bufV + i*p->outN + bi, n0, spp[i] );
+
+    if( bi + n0 < p->outN )
+    {
+      // the block is incomplete - use the direct form for these samples
+      _cmFIRExecDirect(p,0,n0);
+      p->bi += n0;
     }
+    else
+    {
+      // the block is complete - the convolver output replaces the output for any
+      // samples of this block which were returned by previous calls
+      for(i=0; i<chCnt; ++i)
+      {
+        cmConvolveExec(p->cnvV[i],p->bufV + i*p->outN,p->outN);
+        cmVOS_Copy(p->outV + i*p->outN, n0, p->cnvV[i]->outV + bi );
+      }
+
+      // the remaining samples begin the next block
+      p->bi = sn - n0;
 
-    // store the output sample
-    *op++ = v;					
+      if( p->bi > 0 )
+      {
+        for(i=0; i<chCnt; ++i)
+          cmVOS_Copy(p->bufV + i*p->outN, p->bi, spp[i] + n0 );
 
-    // insert the input sample
-    p->delayV[ p->delayIdx ] = *sbp++;
+        _cmFIRExecDirect(p,n0,p->bi);
+      }
+    }
+  }
 
-    // store the position of the newest ele in the delay line
-    di = p->delayIdx;
+  // shift the last hn samples to the front of the buffer to form the history for the next block
+  for(i=0; i<chCnt; ++i)
+  {
+    cmSample_t* xp = p->xV + i*p->xN;
+    memmove(xp, xp + sn, hn * sizeof(cmSample_t));
   }
 
   return cmOkRC;
 }
 
+cmRC_t cmFIRExec( cmFIR* p, const cmSample_t* sbp, unsigned sn )
+{
+  if( p->chCnt != 1 )
+    return cmCtxRtCondition( &p->obj, cmArgAssertRC, "cmFIRExec() requires a single channel filter. Use cmFIRExecMC() for multi-channel filters.");
+
+  return cmFIRExecMC(p,&sbp,1,sn);
+}
+
 void cmFIRTest0( cmRpt_t* rpt, cmLHeapH_t lhH, cmSymTblH_t stH )
 {
   unsigned N = 512;
@@ -1011,6 +1099,145 @@ void cmFIRTest1( cmCtx* ctx )
   
 }
 
+
+// Scalar per-sample reference FIR (the original cmFIRExec() algorithm).
+static void _cmFIRTestRef( const double* h, unsigned hn, double* d, const cmSample_t* x, cmSample_t* y, unsigned n )
+{
+  unsigned i,k;
+  for(i=0; i<n; ++i)
+  {
+    double v = h[0] * x[i];
+    for(k=1; k<hn; ++k)
+      v += h[k] * d[k-1];
+
+    memmove(d+1,d,(hn-2)*sizeof(double));
+    d[0] = x[i];
+    y[i] = v;
+  }
+}
+
+void cmFIRTest2( cmCtx* ctx )
+{
+  unsigned     procSmpCnt = 64;
+  unsigned     blkCnt     = 2000;
+  unsigned     chCnt      = 4;
+  unsigned     hnV[]      = { 15, 31, 63, 95, 127, 255, 511, 1023 };
+  unsigned     hnN        = sizeof(hnV)/sizeof(hnV[0]);
+  unsigned     sn         = procSmpCnt * blkCnt;
+  cmSample_t*  x          = cmMemAllocZ(cmSample_t,sn*chCnt);
+  cmSample_t*  y0         = cmMemAllocZ(cmSample_t,sn);
+  cmSample_t*  y1         = cmMemAllocZ(cmSample_t,sn*chCnt);
+  unsigned     i,j,k,m;
+
+  cmVOS_Random(x,sn*chCnt,-1.0,1.0);
+
+  cmRptPrintf(ctx->obj.err.rpt,"procSmpCnt:%i us per block: (scalar=original per-sample implementation, mc=%i channels)\n",procSmpCnt,chCnt);
+  cmRptPrintf(ctx->obj.err.rpt,"  hn   scalar   direct  (err)        fft  (err)        mc direct (err)   fft var. blocks (err)\n");
+
+  for(i=0; i<hnN; ++i)
+  {
+    unsigned     hn      = hnV[i];
+    double       usV[4]  = {0,0,0,0};
+    double       errV[5] = {0,0,0,0,0};
+    double*      d       = cmMemAllocZ(double,hn);
+    cmTimeSpec_t t0,t1;
+
+    // m=1:direct m=2:fft m=3:multi-channel direct
+    for(m=1; m<4; ++m)
+    {
+      cmFIR* f = cmFIRAllocSinc(ctx,NULL,procSmpCnt,procSmpCnt*100,hn,procSmpCnt*10,m==2 ? kFftFIRFl : 0,NULL);
+
+      if( m==3 )
+        cmFIRSetChCount(f,chCnt);
+
+      cmTimeGetMonotonic(&t0);
+
+      for(j=0; j<blkCnt; ++j)
+      {
+        const cmSample_t* xp = x  + j*procSmpCnt;
+        cmSample_t*       yp = y1 + j*procSmpCnt;
+
+        switch( m )
+        {
+          case 3:
+            {
+              const cmSample_t* xpV[ chCnt ];
+              for(k=0; k<chCnt; ++k)
+                xpV[k] = xp + k*sn;
+
+              cmFIRExecMC(f,xpV,chCnt,procSmpCnt);
+
+              for(k=0; k<chCnt; ++k)
+                cmVOS_Copy(yp + k*sn, procSmpCnt, f->outV + k*f->outN);
+            }
+            break;
+
+          default:
+            cmFIRExec(f,xp,procSmpCnt);
+            cmVOS_Copy(yp,procSmpCnt,f->outV);
+        }
+      }
+
+      cmTimeGetMonotonic(&t1);
+
+      usV[m] = (double)cmTimeElapsedMicros(&t0,&t1) / (m==3 ? blkCnt*chCnt : blkCnt);
+
+      // compare against the reference for every channel
+      for(k=0; k<(m==3 ? chCnt : 1); ++k)
+      {
+        unsigned n;
+        cmVOD_Zero(d,hn);
+        _cmFIRTestRef(f->coeffV,hn,d,x + k*sn,y0,sn);
+        for(n=0; n<sn; ++n)
+          errV[m] = cmMax(errV[m],fabs(y0[n] - y1[k*sn+n]));
+      }
+
+      cmFIRFree(&f);
+    }
+
+    // verify the FFT filter with block sizes which are not a multiple of procSmpCnt
+    {
+      unsigned snV[] = { 17, 64, 1, 46, 63, 3, 64, 64, 30 };
+      cmFIR*   f     = cmFIRAllocSinc(ctx,NULL,procSmpCnt,procSmpCnt*100,hn,procSmpCnt*10,kFftFIRFl,NULL);
+      unsigned n;
+
+      for(j=0,k=0; j<sn; j+=n,++k)
+      {
+        n = cmMin(snV[ k % (sizeof(snV)/sizeof(snV[0])) ],sn-j);
+        cmFIRExec(f,x + j,n);
+        cmVOS_Copy(y1 + j,n,f->outV);
+      }
+
+      cmVOD_Zero(d,hn);
+      _cmFIRTestRef(f->coeffV,hn,d,x,y0,sn);
+      for(n=0; n<sn; ++n)
+        errV[4] = cmMax(errV[4],fabs(y0[n] - y1[n]));
+
+      cmFIRFree(&f);
+    }
+
+    // time the scalar reference
+    {
+      cmFIR* f = cmFIRAllocSinc(ctx,NULL,procSmpCnt,procSmpCnt*100,hn,procSmpCnt*10,0,NULL);
+      cmVOD_Zero(d,hn);
+      cmTimeGetMonotonic(&t0);
+      for(j=0; j<blkCnt; ++j)
+        _cmFIRTestRef(f->coeffV,hn,d,x + j*procSmpCnt,y0 + j*procSmpCnt,procSmpCnt);
+      cmTimeGetMonotonic(&t1);
+      usV[0] = (double)cmTimeElapsedMicros(&t0,&t1) / blkCnt;
+      cmFIRFree(&f);
+    }
+
+    cmRptPrintf(ctx->obj.err.rpt,"%5i %7.2f %7.2f (%7.1e)  %7.2f (%7.1e)  %7.2f (%7.1e)          (%7.1e)\n",hn,usV[0],usV[1],errV[1],usV[2],errV[2],usV[3],errV[3],errV[4]);
+
+    cmMemFree(d);
+  }
+
+  cmMemFree(x);
+  cmMemFree(y0);
+  cmMemFree(y1);
+}
+
 //------------------------------------------------------------------------------------------------------------
 
 
@@ -1650,17 +1877,230 @@ void  cmDhmmTest( cmRpt_t* rpt, cmLHeapH_t lhH, cmSymTblH_t stH )
   cmCtxFree(&c); 
 }
 
+//------------------------------------------------------------------------------------------------------------
+cmRC_t _cmConvolvePartFree( cmConvolvePart* c )
+{
+  if( c->fft != NULL )
+    cmFftFreeSS(&c->fft);
+
+  if( c->ifft != NULL )
+    cmIFftFreeSS(&c->ifft);
+
+  cmMemPtrFree(&c->inV);
+  cmMemPtrFree(&c->hrV);
+  cmMemPtrFree(&c->hiV);
+  cmMemPtrFree(&c->xrV);
+  cmMemPtrFree(&c->xiV);
+  cmMemPtrFree(&c->arV);
+  cmMemPtrFree(&c->aiV);
+  c->partN = 0;
+  return cmOkRC;
+}
+
+// Setup 'c' to convolve with h[hn] using partitions of blkN samples.
+cmRC_t _cmConvolvePartInit( cmConvolve* p, cmConvolvePart* c, const cmSample_t* h, unsigned hn, unsigned blkN )
+{
+  cmCtx*   ctx  = p->obj.ctx;
+  unsigned fftN = cmNextPowerOfTwo( 2*blkN );
+  unsigned i,j;
+
+  _cmConvolvePartFree(c);
+
+  c->blkN  = blkN;
+  c->partN = cmMax(1,(hn + blkN - 1) / blkN);
+  c->inV   = cmMemAllocZ( cmSample_t, fftN );
+
+  // the FFT reads directly from the overlap-save input window
+  if((c->fft  = cmFftAllocSS( ctx, NULL, c->inV, fftN, kNoConvertFftFl )) == NULL )
+    return cmCtxRtCondition(&p->obj, cmSubSysFailRC, "The convolution FFT allocation failed.");
+
+  if((c->ifft = cmIFftAllocSS( ctx, NULL, c->fft->binCnt )) == NULL )
+    return cmCtxRtCondition(&p->obj, cmSubSysFailRC, "The convolution IFFT allocation failed.");
+
+  c->binN = c->fft->binCnt;
+  c->hrV  = cmMemAllocZ( cmSample_t, c->partN * c->binN );
+  c->hiV  = cmMemAllocZ( cmSample_t, c->partN * c->binN );
+  c->xrV  = cmMemAllocZ( cmSample_t, c->partN * c->binN );
+  c->xiV  = cmMemAllocZ( cmSample_t, c->partN * c->binN );
+  c->arV  = cmMemAllocZ( cmSample_t, c->binN );
+  c->aiV  = cmMemAllocZ( cmSample_t, c->binN );
+  c->xi   = 0;
+
+  // take the FFT of each impulse response partition
+  for(i=0; i<c->partN; ++i)
+  {
+    unsigned    n  = cmMin(blkN, hn - i*blkN);
+    cmSample_t* hr = c->hrV + i*c->binN;
+    cmSample_t* hi = c->hiV + i*c->binN;
+
+    cmVOS_Zero( c->inV, fftN );
+    if( hn > i*blkN )
+      cmVOS_Copy( c->inV, n, h + i*blkN );
+
+    cmFftExecSS( c->fft, NULL, 0 );
+
+    // the IFFT is not normalized - scale the impulse response by 1/fftN
+    for(j=0; j<c->binN; ++j)
+    {
+      hr[j] = cmCrealS(c->fft->complexV[j]) / fftN;
+      hi[j] = cmCimagS(c->fft->complexV[j]) / fftN;
+    }
+  }
+
+  cmVOS_Zero( c->inV, fftN );
+
+  return cmOkRC;
+}
+
+// Convolve the next block x[blkN] and write the result to y[blkN].
+void _cmConvolvePartExec( cmConvolvePart* c, const cmSample_t* x, unsigned xn, cmSample_t* y )
+{
+  unsigned    fftN = c->fft->wndSmpCnt;
+  unsigned    binN = c->binN;
+  cmSample_t* ar   = c->arV;
+  cmSample_t* ai   = c->aiV;
+  unsigned    i,j,k;
+
+  // slide the overlap-save window and append the new input block
+  memmove( c->inV, c->inV + c->blkN, (fftN - c->blkN) * sizeof(cmSample_t) );
+
+  cmSample_t* ip = c->inV + fftN - c->blkN;
+  xn = x==NULL ? 0 : cmMin(xn,c->blkN);
+  cmVOS_Copy( ip, xn, x );
+  cmVOS_Zero( ip + xn, c->blkN - xn );
+
+  cmFftExecSS( c->fft, NULL, 0 );
+
+  // store the spectrum of the input window in the frequency domain delay line
+  c->xi = c->xi==0 ? c->partN-1 : c->xi-1;
+
+  cmSample_t* xr = c->xrV + c->xi*binN;
+  cmSample_t* xi = c->xiV + c->xi*binN;
+  for(j=0; j<binN; ++j)
+  {
+    xr[j] = cmCrealS(c->fft->complexV[j]);
+    xi[j] = cmCimagS(c->fft->complexV[j]);
+  }
+
+  // multiply each delayed input spectrum by the associated impulse response partition
+  cmVOS_Zero( ar, binN );
+  cmVOS_Zero( ai, binN );
+
+  for(i=0,k=c->xi; i<c->partN; ++i,k=k+1==c->partN ? 0 : k+1)
+  {
+    const cmSample_t* hr = c->hrV + i*binN;
+    const cmSample_t* hi = c->hiV + i*binN;
+    xr = c->xrV + k*binN;
+    xi = c->xiV + k*binN;
+
+    for(j=0; j<binN; ++j)
+    {
+      ar[j] += xr[j]*hr[j] - xi[j]*hi[j];
+      ai[j] += xr[j]*hi[j] + xi[j]*hr[j];
+    }
+  }
+
+  for(j=0; j<binN; ++j)
+    c->ifft->complexV[j] = ar[j] + I * ai[j];
+
+  cmIFftExecSS( c->ifft, NULL );
+
+  // the last blkN samples of the circular convolution are free of aliasing
+  cmVOS_Copy( y, c->blkN, c->ifft->outV + fftN - c->blkN );
+}
+
+//------------------------------------------------------------------------------------------------------------
+// Background tail processor.
+// Tail block j (tailN samples) is written to inV[j%2] by cmConvolveExec().
+// When the block is complete it is passed to the background thread which
+// writes the associated output to outV[j%2]. The output of tail block j is
+// summed into the cmConvolveExec() output 2*tailN samples after the
+// beginning of tail block j - the tail impulse response begins at h[2*tailN].
+
+typedef struct cmConvolveTail_str
+{
+  cmConvolvePart   part;
+  unsigned         tailN;     // tail partition length (multiple of cmConvolve.outN)
+  unsigned         blkPerTail;// tailN / cmConvolve.outN
+  cmSample_t*      inV[2];    // inV[2][tailN]
+  cmSample_t*      outV[2];   // outV[2][tailN]
+  cmThreadPoolH_t  poolH;     // single worker pool which runs the tail blocks
+  unsigned         reqIdx;    // index of the tail block being processed by the pool
+  bool             busyFl;    // a tail block has been started and not yet waited for
+} cmConvolveTail;
+
+void _cmConvolveTailTask( void* arg, unsigned taskIdx )
+{
+  cmConvolveTail* t = (cmConvolveTail*)arg;
+  unsigned        j = t->reqIdx;
+
+  _cmConvolvePartExec( &t->part, t->inV[j%2], t->tailN, t->outV[j%2] );
+}
+
+void _cmConvolveTailFree( cmConvolveTail** tp )
+{
+  cmConvolveTail* t;
+  unsigned        i;
+
+  if( tp==NULL || (t = *tp)==NULL )
+    return;
+
+  if( cmThreadPoolIsValid(t->poolH) )
+  {
+    if( t->busyFl )
+      cmThreadPoolWait(t->poolH);
+
+    cmThreadPoolDestroy(&t->poolH);
+  }
+
+  _cmConvolvePartFree(&t->part);
+
+  for(i=0; i<2; ++i)
+  {
+    cmMemPtrFree(&t->inV[i]);
+    cmMemPtrFree(&t->outV[i]);
+  }
+
+  cmMemPtrFree(tp);
+}
+
+cmRC_t _cmConvolveTailAlloc( cmConvolve* p, const cmSample_t* h, unsigned hn, unsigned tailN )
+{
+  cmRC_t          rc;
+  unsigned        i;
+  cmConvolveTail* t = cmMemAllocZ(cmConvolveTail,1);
+
+  p->tail       = t;
+  t->tailN      = tailN;
+  t->blkPerTail = tailN / p->outN;
+  t->poolH      = cmThreadPoolNullHandle;
+
+  for(i=0; i<2; ++i)
+  {
+    t->inV[i]  = cmMemAllocZ(cmSample_t,tailN);
+    t->outV[i] = cmMemAllocZ(cmSample_t,tailN);
+  }
+
+  if((rc = _cmConvolvePartInit(p, &t->part, h, hn, tailN )) != cmOkRC )
+    return rc;
+
+  if( cmThreadPoolCreate(&t->poolH,1,p->obj.err.rpt) != kOkThRC )
+    return cmCtxRtCondition(&p->obj, cmSubSysFailRC, "The convolution tail thread pool create failed.");
+
+  return cmOkRC;
+}
+
 //------------------------------------------------------------------------------------------------------------
 cmConvolve* cmConvolveAlloc( cmCtx* c, cmConvolve* ap, const cmSample_t* h, unsigned hn, unsigned procSmpCnt )
+{ return cmConvolveAllocTail(c,ap,h,hn,procSmpCnt,0); }
+
+cmConvolve* cmConvolveAllocTail( cmCtx* c, cmConvolve* ap, const cmSample_t* h, unsigned hn, unsigned procSmpCnt, unsigned tailSmpCnt )
 {
   cmConvolve* p = cmObjAlloc( cmConvolve, c, ap);
   
-  p->fft = cmFftAllocSR( c,NULL,NULL,0,kNoConvertFftFl);
-  p->ifft= cmIFftAllocRS(c,NULL,p->fft->binCnt);
-
   if( hn > 0 && procSmpCnt > 0 )
-    if( cmConvolveInit(p,h,hn,procSmpCnt) != cmOkRC )
-      cmObjFree(&p);
+    if( cmConvolveInitTail(p,h,hn,procSmpCnt,tailSmpCnt) != cmOkRC )
+      cmConvolveFree(&p);
 
   return p;
 }
@@ -1676,92 +2116,150 @@ cmRC_t      cmConvolveFree(  cmConvolve** pp )
   if((rc = cmConvolveFinal(p)) != cmOkRC )
     return cmOkRC;
 
-  cmFftFreeSR(&p->fft);
-  cmIFftFreeRS(&p->ifft);
-  cmMemPtrFree(&p->H);
-  cmMemPtrFree(&p->outV);
   cmObjFree(pp);
 
   return cmOkRC;
 }
 
 cmRC_t      cmConvolveInit(  cmConvolve* p, const cmSample_t* h, unsigned hn, unsigned procSmpCnt )
+{ return cmConvolveInitTail(p,h,hn,procSmpCnt,0); }
+
+cmRC_t      cmConvolveInitTail(  cmConvolve* p, const cmSample_t* h, unsigned hn, unsigned procSmpCnt, unsigned tailSmpCnt )
 {
-  cmRC_t rc;
-  unsigned i;
-  unsigned cn = cmNextPowerOfTwo( hn + procSmpCnt - 1 );
+  cmRC_t   rc;
+  unsigned tailN = tailSmpCnt==0 ? 0 : ((tailSmpCnt + procSmpCnt - 1) / procSmpCnt) * procSmpCnt;
 
   if((rc = cmConvolveFinal(p)) != cmOkRC )
     return rc;
-  
-  cmFftInitSR(  p->fft, NULL, cn, kNoConvertFftFl );
-  cmIFftInitRS( p->ifft, p->fft->binCnt);
 
-  p->H    = cmMemResizeZ( cmComplexR_t,p->H,  p->fft->binCnt );
-  p->outV = cmMemResizeZ( cmSample_t,p->outV, cn );
-  p->olaV = p->outV + procSmpCnt;
-  p->outN = procSmpCnt;
-  p->hn   = hn;
+  if( procSmpCnt == 0 )
+    return cmCtxRtCondition(&p->obj, cmArgAssertRC, "The convolution block size must be greater than zero.");
 
-  // take the FFT of the impulse response
-  cmFftExecSR(  p->fft, h, hn );
+  p->outN   = procSmpCnt;
+  p->outV   = cmMemResizeZ( cmSample_t, p->outV, procSmpCnt );
+  p->hn     = hn;
+  p->headN  = hn;
+  p->blkIdx = 0;
 
-  // copy the FFT of the impulse response to p->H[]
-  for(i=0; i<p->fft->binCnt; ++i)
-     p->H[i] = p->fft->complexV[i] / p->fft->wndSmpCnt;
+  // the tail is only used if it contains at least one tail partition
+  if( tailN > 0 && hn > 2*tailN )
+    p->headN = 2*tailN;
+
+  if((rc = _cmConvolvePartInit(p, &p->head, h, p->headN, procSmpCnt )) != cmOkRC )
+    return rc;
+
+  if( p->headN < hn )
+    if((rc = _cmConvolveTailAlloc(p, h + p->headN, hn - p->headN, tailN )) != cmOkRC )
+      return rc;
 
   return cmOkRC;
 }
 
 cmRC_t      cmConvolveFinal(  cmConvolve* p )
-{  return cmOkRC; }
+{
+  if( p != NULL )
+  {
+    _cmConvolveTailFree(&p->tail);
+    _cmConvolvePartFree(&p->head);
+    cmMemPtrFree(&p->outV);
+  }
+  return cmOkRC;
+}
 
 cmRC_t      cmConvolveExec(  cmConvolve* p, const cmSample_t* x, unsigned xn )
 {
-  unsigned i;
+  assert( xn <= p->outN );
 
-  // take FT of input signal
-  cmFftExecSR(  p->fft, x, xn );
+  _cmConvolvePartExec( &p->head, x, xn, p->outV );
+
+  cmConvolveTail* t = p->tail;
+
+  if( t != NULL )
+  {
+    unsigned    j  = p->blkIdx / t->blkPerTail;            // index of the current tail block
+    unsigned    m  = (p->blkIdx % t->blkPerTail) * p->outN; // offset of this block into the tail block
+    cmSample_t* ip = t->inV[j%2] + m;
 
-  // multiply the signal spectra of the input signal and impulse response
-  for(i=0; i<p->fft->binCnt; ++i)
-    p->ifft->complexV[i] = p->H[i] * p->fft->complexV[i];
+    // store the input in the current tail block
+    xn = x==NULL ? 0 : cmMin(xn,p->outN);
+    cmVOS_Copy( ip, xn, x );
+    cmVOS_Zero( ip + xn, p->outN - xn );
 
-  // take the IFFT of the convolved spectrum
-  cmIFftExecRS(p->ifft,NULL);
+    // sum in the output of tail block j-2 (this is stored in outV[j%2])
+    if( j >= 2 )
+      cmVOS_AddVV( p->outV, p->outN, t->outV[j%2] + m );
 
-  // sum with previous impulse response tail
-  cmVOS_AddVVV( p->outV, p->outN-1, p->olaV, p->ifft->outV );
+    // if the current tail block is complete then wait for the previous block
+    // to finish and pass it to the background thread
+    if( m + p->outN == t->tailN )
+    {
+      if( t->busyFl )
+        cmThreadPoolWait(t->poolH);
 
-  // first sample of the impulse response tail is complete 
-  p->outV[p->outN-1] = p->ifft->outV[p->outN-1];
+      t->reqIdx = j;
+      t->busyFl = cmThreadPoolStart(t->poolH,_cmConvolveTailTask,t,1) == kOkThRC;
+    }
+  }
 
-  // store the new impulse response tail
-  cmVOS_Copy(p->olaV,p->hn-1,p->ifft->outV + p->outN );
+  ++p->blkIdx;
 
   return cmOkRC;
 }
 
 cmRC_t      cmConvolveSignal( cmCtx* c, const cmSample_t* h, unsigned hn, const cmSample_t* x, unsigned xn, cmSample_t* y, unsigned yn )
 {
-  cmConvolve* p = cmConvolveAlloc(c,NULL,h,hn,xn);
-
-  cmConvolveExec(p,x,xn);
+  unsigned    blkN = cmMin(1024,cmMax(1,xn));
+  cmConvolve* p    = cmConvolveAlloc(c,NULL,h,hn,blkN);
+  unsigned    i;
 
-  unsigned n = cmMin(p->outN,yn);
-  
-  cmVOS_Copy(y,n,p->outV);
+  if( p == NULL )
+    return cmSubSysFailRC;
 
-  if( yn > p->outN )
+  for(i=0; i<yn; i+=blkN)
   {
-    unsigned m = cmMin(yn-p->outN,p->hn-1);
-    cmVOS_Copy(y+n,m,p->olaV);
+    unsigned n = i < xn ? cmMin(blkN,xn-i) : 0;
+
+    cmConvolveExec(p, n==0 ? NULL : x+i, n );
+
+    cmVOS_Copy(y+i,cmMin(blkN,yn-i),p->outV);
   }
 
   cmConvolveFree(&p);
   return cmOkRC;
 }
 
+// Convolve x[xn] with h[hn] using block size blkN and tail size tailN and
+// return the max. absolute difference from direct convolution.
+double _cmConvolveTestError( cmCtx* c, const cmSample_t* h, unsigned hn, const cmSample_t* x, unsigned xn, unsigned blkN, unsigned tailN )
+{
+  unsigned    yn = xn + hn - 1;
+  cmSample_t* y  = cmMemAllocZ(cmSample_t,yn);
+  cmConvolve* p  = cmConvolveAllocTail(c,NULL,h,hn,blkN,tailN);
+  double      err = 0;
+  unsigned    i,j;
+
+  for(i=0; i<yn; i+=blkN)
+  {
+    unsigned n = i < xn ? cmMin(blkN,xn-i) : 0;
+    cmConvolveExec(p, n==0 ? NULL : x+i, n );
+    cmVOS_Copy(y+i,cmMin(blkN,yn-i),p->outV);
+  }
+
+  for(i=0; i<yn; ++i)
+  {
+    double d = 0;
+    for(j=0; j<hn; ++j)
+      if( j <= i && i-j < xn )
+        d += h[j] * x[i-j];
+
+    err = cmMax(err,fabs(d-y[i]));
+  }
+
+  cmConvolveFree(&p);
+  cmMemFree(y);
+  return err;
+}
+
 cmRC_t      cmConvolveTest(cmRpt_t* rpt, cmLHeapH_t lhH, cmSymTblH_t stH )
 {
   cmCtx *c = cmCtxAlloc(NULL,rpt,lhH,stH);
@@ -1772,20 +2270,101 @@ cmRC_t      cmConvolveTest(cmRpt_t* rpt, cmLHeapH_t lhH, cmSymTblH_t stH )
   unsigned   xn  = sizeof(x) / sizeof(x[0]);
   unsigned   yn  = xn+hn-1;
   cmSample_t y[yn];
+  unsigned   i,j;
 
-  //cmVOS_Hann(h,5);
+  cmConvolveSignal(c,h,hn,x,xn,y,yn);
+  cmVOS_Print( rpt, 1, yn, y );
 
-  cmConvolve* p = cmConvolveAlloc(c,NULL,h,hn,xn);
- 
-  cmConvolveExec(p,x,xn);
+  // verify against direct convolution for block sizes which are
+  // smaller, equal to, and larger than the impulse response
+  {
+    unsigned    tn = 3000;
+    unsigned    sn = 5000;
+    cmSample_t* tV = cmMemAllocZ(cmSample_t,tn);
+    cmSample_t* sV = cmMemAllocZ(cmSample_t,sn);
 
-  cmVOS_Print( rpt, 1, p->outN, p->outV );
-  cmVOS_Print( rpt, 1, p->hn-1, p->olaV );
- 
-  cmConvolveFree(&p);
+    for(i=0; i<tn; ++i)
+      tV[i] = exp(-(double)i/500) * (2.0*rand()/RAND_MAX - 1.0);
 
-  cmConvolveSignal(c,h,hn,x,xn,y,yn);
-  cmVOS_Print( rpt, 1, hn+xn-1, y );
+    for(i=0; i<sn; ++i)
+      sV[i] = 2.0*rand()/RAND_MAX - 1.0;
+
+    unsigned cfgV[][3] = { {tn,64,0}, {tn,100,0}, {17,64,0}, {64,64,0}, {tn,4096,0}, {tn,64,256}, {tn,48,200} };
+    unsigned cfgN      = sizeof(cfgV)/sizeof(cfgV[0]);
+
+    for(i=0; i<cfgN; ++i)
+      cmRptPrintf(rpt,"hn:%5i blk:%5i tail:%5i err:%g\n",cfgV[i][0],cfgV[i][1],cfgV[i][2],_cmConvolveTestError(c,tV,cfgV[i][0],sV,sn,cfgV[i][1],cfgV[i][2]));
+
+    cmMemFree(tV);
+    cmMemFree(sV);
+  }
+
+  // report the cost per block as a function of the impulse response length.
+  // The blocks are paced in real-time so that the background thread
+  // has the same time budget as it would with an audio device.
+  {
+    double      srate  = 44100;
+    unsigned    blkN   = 64;
+    unsigned    tailN  = 1024;
+    unsigned    iterN  = 1000;
+    double      secsV[] = { 0.1, 0.5, 1, 2, 4, 8 };
+    unsigned    secsN  = sizeof(secsV)/sizeof(secsV[0]);
+    cmSample_t* xV     = cmMemAllocZ(cmSample_t,blkN);
+    unsigned    maxHn  = secsV[secsN-1] * srate;
+    cmSample_t* hV     = cmMemAllocZ(cmSample_t,maxHn);
+
+    for(i=0; i<maxHn; ++i)
+      hV[i] = exp(-(double)i/srate) * (2.0*rand()/RAND_MAX - 1.0);
+
+    for(i=0; i<blkN; ++i)
+      xV[i] = 2.0*rand()/RAND_MAX - 1.0;
+
+    unsigned    budgetUs = 1e6*blkN/srate;
+
+    cmRptPrintf(rpt,"block:%i samples tail:%i samples budget:%i us/block\n",blkN,tailN,budgetUs);
+
+    for(i=0; i<secsN; ++i)
+    {
+      unsigned hn = secsV[i] * srate;
+      unsigned k;
+
+      cmRptPrintf(rpt,"IR:%5.1f sec ",secsV[i]);
+
+      for(k=0; k<2; ++k)
+      {
+        cmConvolve*  p      = cmConvolveAllocTail(c,NULL,hV,hn,blkN,k==0 ? 0 : tailN);
+        unsigned     sumUs  = 0;
+        unsigned     maxUs  = 0;
+
+        if( p == NULL )
+          continue;
+
+        for(j=0; j<iterN; ++j)
+        {
+          cmTimeSpec_t t0,t1;
+          cmTimeGetMonotonic(&t0);
+          cmConvolveExec(p,xV,blkN);
+          cmTimeGetMonotonic(&t1);
+
+          unsigned us = cmTimeElapsedMicros(&t0,&t1);
+          sumUs += us;
+          maxUs  = cmMax(maxUs,us);
+
+          if( us < budgetUs )
+            cmSleepUs(budgetUs - us);
+        }
+
+        cmRptPrintf(rpt,"| %s avg:%6.1f max:%6i us ", k==0 ? "uniform" : "tail", (double)sumUs/iterN, maxUs );
+
+        cmConvolveFree(&p);
+      }
+
+      cmRptPrintf(rpt,"\n");
+    }
+
+    cmMemFree(xV);
+    cmMemFree(hV);
+  }
 
   cmCtxFree(&c);
 
@@ -2358,150 +2937,529 @@ cmPvSyn*   cmPvSynAlloc( cmCtx* ctx, cmPvSyn* ap, unsigned procSmpCnt, double ou
   cmIFftAllocRS(  ctx, &p->ft, wndSmpCnt/2+1 );
   cmOlaAlloc(     ctx, &p->ola, wndSmpCnt, hopSmpCnt, procSmpCnt, wndTypeId );
 
-  if( procSmpCnt )
-    if((rc = cmPvSynInit(p,procSmpCnt,outSrate,wndSmpCnt,hopSmpCnt,wndTypeId)) != cmOkRC )
-      cmPvSynFree(&p);
-  return p;  
+  if( procSmpCnt )
+    if((rc = cmPvSynInit(p,procSmpCnt,outSrate,wndSmpCnt,hopSmpCnt,wndTypeId)) != cmOkRC )
+      cmPvSynFree(&p);
+  return p;  
+}
+
+cmRC_t     cmPvSynFree( cmPvSyn** pp )
+{
+  cmRC_t rc;
+
+  if( pp==NULL || *pp==NULL )
+    return cmOkRC;
+
+  cmPvSyn* p = *pp;
+
+  if((rc = cmPvSynFinal(p)) != cmOkRC )
+    return rc;
+
+  cmMemPtrFree(&p->minRphV);
+  cmMemPtrFree(&p->maxRphV);
+  cmMemPtrFree(&p->itrV);
+  cmMemPtrFree(&p->phs0V);
+  cmMemPtrFree(&p->phsV);
+  cmMemPtrFree(&p->mag0V);
+  cmMemPtrFree(&p->magV);
+
+  cmObjFreeStatic( cmOlaFree,      cmOla,      p->ola);
+  cmObjFreeStatic( cmIFftFreeRS,   cmIFftRS,   p->ft );
+  cmObjFreeStatic( cmWndFuncFree,  cmWndFunc,  p->wf );
+
+  cmObjFree(pp);
+
+  return cmOkRC;
+}
+
+cmRC_t     cmPvSynInit( cmPvSyn* p, unsigned procSmpCnt, double outSrate, unsigned wndSmpCnt, unsigned hopSmpCnt, unsigned wndTypeId )
+{
+  cmRC_t   rc;
+  int      k;
+  double   twoPi     = 2.0 * M_PI;
+  bool     useHannFl = true;
+  int      m         = useHannFl ? 2 : 1;
+
+  if((rc = cmPvSynFinal(p)) != cmOkRC )
+    return rc;
+
+  p->outSrate   = outSrate;
+  p->procSmpCnt = procSmpCnt;
+  p->wndSmpCnt  = wndSmpCnt;
+  p->hopSmpCnt  = hopSmpCnt;
+  p->binCnt     = wndSmpCnt / 2 + 1;
+
+  p->minRphV    = cmMemResizeZ( cmReal_t, p->minRphV, p->binCnt );
+  p->maxRphV    = cmMemResizeZ( cmReal_t, p->maxRphV, p->binCnt );
+  p->itrV       = cmMemResizeZ( cmReal_t, p->itrV,    p->binCnt );
+  p->phs0V      = cmMemResizeZ( cmReal_t, p->phs0V,   p->binCnt );
+  p->phsV       = cmMemResizeZ( cmReal_t, p->phsV,    p->binCnt );
+  p->mag0V      = cmMemResizeZ( cmReal_t, p->mag0V,   p->binCnt );
+  p->magV       = cmMemResizeZ( cmReal_t, p->magV,    p->binCnt );
+
+
+  if((rc = cmWndFuncInit( &p->wf, wndTypeId, wndSmpCnt, 0)) != cmOkRC )
+    return rc;
+
+  if((rc = cmIFftInitRS( &p->ft, p->binCnt )) != cmOkRC )
+    return rc;
+
+  if((rc = cmOlaInit(  &p->ola, wndSmpCnt, hopSmpCnt, procSmpCnt, wndTypeId )) != cmOkRC )
+    return rc;
+
+  for(k=0; k<p->binCnt; ++k)
+  {
+    // complete revolutions per hop in radians
+    p->itrV[k] = twoPi * floor((double)k * hopSmpCnt / wndSmpCnt ); 
+
+    p->minRphV[k] = ((cmReal_t)(k-m)) * hopSmpCnt * twoPi / wndSmpCnt;
+    p->maxRphV[k] = ((cmReal_t)(k+m)) * hopSmpCnt * twoPi / wndSmpCnt;
+
+    //printf("%f %f %f\n",p->itrV[k],p->minRphV[k],p->maxRphV[k]);
+  }
+
+  return rc;  
+}
+
+cmRC_t     cmPvSynFinal(cmPvSyn* p )
+{ return cmOkRC; }
+
+cmRC_t     cmPvSynExec( cmPvSyn* p, const cmReal_t* magV, const cmReal_t* phsV )
+{
+  double   twoPi     = 2.0 * M_PI;
+  unsigned k;
+
+  for(k=0; k<p->binCnt; ++k)
+  {
+    // phase dist between cur and prv frame
+    cmReal_t dp = phsV[k] - p->phs0V[k];
+
+    // dist must be positive (accum phase always increases)
+    if( dp < -0.00001 )
+      dp += twoPi;
+
+    // add in complete revolutions based on the bin frequency
+    // (these would have been lost from 'dp' due to phase wrap)
+    dp += p->itrV[k];
+
+    // constrain the phase change to lie within the range of the kth bin
+    if( dp < p->minRphV[k] )
+      dp += twoPi;
+
+    if( dp > p->maxRphV[k] )
+      dp -= twoPi;
+
+    p->phsV[k] = p->phs0V[k] + dp;
+    p->magV[k] = p->mag0V[k];
+     
+    
+    p->phs0V[k] = phsV[k];
+    p->mag0V[k] = magV[k];
+  }
+  
+  cmIFftExecPolarRS( &p->ft, magV, phsV );
+  
+  cmOlaExecS( &p->ola, p->ft.outV, p->ft.outN ); 
+
+  //printf("%i %i\n",p->binCnt,p->ft.binCnt );
+
+  //cmVOR_Print( p->obj.ctx->outFuncPtr, 1, p->binCnt, magV );
+  //cmVOR_Print( p->obj.ctx->outFuncPtr, 1, p->binCnt, p->phsV );
+  //cmVOS_Print( p->obj.ctx->outFuncPtr, 1, 10, p->ft.outV );
+
+  return cmOkRC;
+}
+
+cmRC_t  cmPvSynDoIt( cmPvSyn* p, const cmSample_t* v )
+{
+  cmOlaExecS( &p->ola, v, p->wndSmpCnt ); 
+
+  //printf("%f\n",cmVOS_RMS(s,p->wndSmpCnt,p->wndSmpCnt));
+
+  return cmOkRC;
+}
+
+const cmSample_t* cmPvSynExecOut(cmPvSyn* p )
+{ return cmOlaExecOut(&p->ola); }
+
+//------------------------------------------------------------------------------------------------------------
+#if CM_FLOAT_SMP == 1
+#define _cmPvPolarD cmVsF_PolarD
+#else
+#define _cmPvPolarD cmVsD_PolarD
+#endif
+
+cmPvAnlBatch* cmPvAnlBatchAlloc( cmCtx* ctx, cmPvAnlBatch* ap, double srate, unsigned wndSmpCnt, unsigned hopSmpCnt, unsigned maxFrmCnt, unsigned flags )
+{
+  cmPvAnlBatch* p = cmObjAlloc( cmPvAnlBatch, ctx, ap );
+
+  cmWndFuncAlloc( ctx, &p->wf, kHannWndId, wndSmpCnt, 0);
+
+  if( wndSmpCnt > 0 )
+    if( cmPvAnlBatchInit(p,srate,wndSmpCnt,hopSmpCnt,maxFrmCnt,flags) != cmOkRC )
+      cmPvAnlBatchFree(&p);
+
+  return p;
+}
+
+cmRC_t        cmPvAnlBatchFree( cmPvAnlBatch** pp )
+{
+  cmRC_t rc;
+
+  if( pp==NULL || *pp==NULL )
+    return cmOkRC;
+
+  cmPvAnlBatch* p = *pp;
+
+  if((rc = cmPvAnlBatchFinal(p)) != cmOkRC )
+    return rc;
+
+  cmMemPtrFree(&p->xM);
+  cmMemPtrFree(&p->reM);
+  cmMemPtrFree(&p->imM);
+  cmMemPtrFree(&p->magM);
+  cmMemPtrFree(&p->phsM);
+  cmMemPtrFree(&p->hzM);
+  cmMemPtrFree(&p->wV);
+  cmMemPtrFree(&p->phs0V);
+  cmObjFreeStatic( cmWndFuncFree, cmWndFunc, p->wf );
+  cmObjFree(pp);
+
+  return rc;
+}
+
+cmRC_t        cmPvAnlBatchInit( cmPvAnlBatch* p, double srate, unsigned wndSmpCnt, unsigned hopSmpCnt, unsigned maxFrmCnt, unsigned flags )
+{
+  cmRC_t   rc;
+  unsigned i;
+
+  if((rc = cmPvAnlBatchFinal(p)) != cmOkRC )
+    return rc;
+
+  if( maxFrmCnt == 0 || hopSmpCnt == 0 || hopSmpCnt > wndSmpCnt )
+    return cmCtxRtCondition( &p->obj, cmArgAssertRC, "Invalid PV batch analysis parameters: wnd:%i hop:%i frames:%i.",wndSmpCnt,hopSmpCnt,maxFrmCnt);
+
+  if((rc = cmWndFuncInit( &p->wf, kHannWndId | kNormByLengthWndFl, wndSmpCnt, 0)) != cmOkRC )
+    return rc;
+
+  p->flags     = flags;
+  p->srate     = srate;
+  p->wndSmpCnt = wndSmpCnt;
+  p->hopSmpCnt = hopSmpCnt;
+  p->binCnt    = wndSmpCnt/2 + 1;
+  p->maxFrmCnt = maxFrmCnt;
+  p->frmCnt    = 0;
+
+  p->xM    = cmMemResizeZ( cmSample_t, p->xM,    wndSmpCnt * maxFrmCnt );
+  p->reM   = cmMemResizeZ( cmSample_t, p->reM,   p->binCnt * maxFrmCnt );
+  p->imM   = cmMemResizeZ( cmSample_t, p->imM,   p->binCnt * maxFrmCnt );
+  p->magM  = cmMemResizeZ( cmReal_t,   p->magM,  p->binCnt * maxFrmCnt );
+  p->phsM  = cmMemResizeZ( cmReal_t,   p->phsM,  p->binCnt * maxFrmCnt );
+  p->hzM   = cmMemResizeZ( cmReal_t,   p->hzM,   cmIsFlag(flags,kCalcHzPvaFl) ? p->binCnt * maxFrmCnt : 0 );
+  p->wV    = cmMemResizeZ( cmReal_t,   p->wV,    p->binCnt );
+  p->phs0V = cmMemResizeZ( cmReal_t,   p->phs0V, p->binCnt );
+
+  for(i=0; i<p->binCnt; ++i)
+    p->wV[i] = M_PI * i * hopSmpCnt / (p->binCnt-1);
+
+  if((p->plan = cmFpcAllocSplitS( wndSmpCnt, maxFrmCnt, false, p->xM, p->reM, p->imM )) == NULL )
+    return cmCtxRtCondition( &p->obj, cmSubSysFailRC, "The FFTW plan for %i frames of length %i could not be created.",maxFrmCnt,wndSmpCnt);
+
+  return rc;
+}
+
+cmRC_t        cmPvAnlBatchFinal(cmPvAnlBatch* p )
+{
+  if( p != NULL && p->plan != NULL )
+  {
+    cmFpcReleaseS( p->plan );
+    p->plan = NULL;
+  }
+  return cmOkRC;
+}
+
+unsigned      cmPvAnlBatchExec( cmPvAnlBatch* p, const cmSample_t* x, unsigned xN )
+{
+  unsigned wn = p->wndSmpCnt;
+  unsigned bn = p->binCnt;
+  unsigned fn,i,k;
+
+  // window the frames into the columns of xM[]
+  for(fn=0; fn<p->maxFrmCnt && fn*p->hopSmpCnt + wn <= xN; ++fn)
+    cmVOS_MultVVV( p->xM + fn*wn, wn, x + fn*p->hopSmpCnt, p->wf.wndV );
+
+  if((p->frmCnt = fn) == 0 )
+    return 0;
+
+  // the plan always transforms maxFrmCnt frames - clear the unused frames of a short batch
+  if( fn < p->maxFrmCnt )
+    cmVOS_Zero( p->xM + fn*wn, (p->maxFrmCnt-fn)*wn );
+
+  cmFftExecuteSplitR2CS( p->plan, p->xM, p->reM, p->imM );
+
+#if CM_FLOAT_REAL == 0
+  _cmPvPolarD( p->magM, p->phsM, fn*bn, p->reM, p->imM );
+#else
+  for(i=0; i<fn*bn; ++i)
+  {
+    p->magM[i] = hypot( p->reM[i], p->imM[i] );
+    p->phsM[i] = atan2( p->imM[i], p->reM[i] );
+  }
+#endif
+
+  // convert the phase change between frames to Hz (see cmPhsToFrqExec())
+  if( cmIsFlag(p->flags,kCalcHzPvaFl) )
+  {
+    double          twoPi = 2.0 * M_PI;
+    double          den   = twoPi * p->hopSmpCnt;
+    const cmReal_t* phs0V = p->phs0V;
+
+    for(k=0; k<fn; ++k)
+    {
+      const cmReal_t* phsV = p->phsM + k*bn;
+      cmReal_t*       hzV  = p->hzM  + k*bn;
+
+      for(i=0; i<bn; ++i)
+      {
+        cmReal_t dPhs = phsV[i] - phs0V[i];
+        cmReal_t m    = round( (p->wV[i] - dPhs) / twoPi);
+        hzV[i]        = (m * twoPi + dPhs) * p->srate / den;
+      }
+
+      phs0V = phsV;
+    }
+
+    cmVOR_Copy( p->phs0V, bn, phs0V );
+  }
+
+  return fn;
+}
+
+//------------------------------------------------------------------------------------------------------------
+cmPvSynBatch* cmPvSynBatchAlloc( cmCtx* ctx, cmPvSynBatch* ap, unsigned wndSmpCnt, unsigned hopSmpCnt, unsigned maxFrmCnt, unsigned wndTypeId )
+{
+  cmPvSynBatch* p = cmObjAlloc( cmPvSynBatch, ctx, ap );
+
+  cmWndFuncAlloc( ctx, &p->wf, kHannWndId, wndSmpCnt, 0);
+
+  if( wndSmpCnt > 0 )
+    if( cmPvSynBatchInit(p,wndSmpCnt,hopSmpCnt,maxFrmCnt,wndTypeId) != cmOkRC )
+      cmPvSynBatchFree(&p);
+
+  return p;
 }
 
-cmRC_t     cmPvSynFree( cmPvSyn** pp )
+cmRC_t        cmPvSynBatchFree( cmPvSynBatch** pp )
 {
   cmRC_t rc;
 
   if( pp==NULL || *pp==NULL )
     return cmOkRC;
 
-  cmPvSyn* p = *pp;
+  cmPvSynBatch* p = *pp;
 
-  if((rc = cmPvSynFinal(p)) != cmOkRC )
+  if((rc = cmPvSynBatchFinal(p)) != cmOkRC )
     return rc;
 
-  cmMemPtrFree(&p->minRphV);
-  cmMemPtrFree(&p->maxRphV);
-  cmMemPtrFree(&p->itrV);
-  cmMemPtrFree(&p->phs0V);
-  cmMemPtrFree(&p->phsV);
-  cmMemPtrFree(&p->mag0V);
-  cmMemPtrFree(&p->magV);
-
-  cmObjFreeStatic( cmOlaFree,      cmOla,      p->ola);
-  cmObjFreeStatic( cmIFftFreeRS,   cmIFftRS,   p->ft );
-  cmObjFreeStatic( cmWndFuncFree,  cmWndFunc,  p->wf );
-
+  cmMemPtrFree(&p->reM);
+  cmMemPtrFree(&p->imM);
+  cmMemPtrFree(&p->yM);
+  cmMemPtrFree(&p->outV);
+  cmObjFreeStatic( cmWndFuncFree, cmWndFunc, p->wf );
   cmObjFree(pp);
 
-  return cmOkRC;
+  return rc;
 }
 
-cmRC_t     cmPvSynInit( cmPvSyn* p, unsigned procSmpCnt, double outSrate, unsigned wndSmpCnt, unsigned hopSmpCnt, unsigned wndTypeId )
+cmRC_t        cmPvSynBatchInit( cmPvSynBatch* p, unsigned wndSmpCnt, unsigned hopSmpCnt, unsigned maxFrmCnt, unsigned wndTypeId )
 {
-  cmRC_t   rc;
-  int      k;
-  double   twoPi     = 2.0 * M_PI;
-  bool     useHannFl = true;
-  int      m         = useHannFl ? 2 : 1;
+  cmRC_t rc;
 
-  if((rc = cmPvSynFinal(p)) != cmOkRC )
+  if((rc = cmPvSynBatchFinal(p)) != cmOkRC )
     return rc;
 
-  p->outSrate   = outSrate;
-  p->procSmpCnt = procSmpCnt;
-  p->wndSmpCnt  = wndSmpCnt;
-  p->hopSmpCnt  = hopSmpCnt;
-  p->binCnt     = wndSmpCnt / 2 + 1;
-
-  p->minRphV    = cmMemResizeZ( cmReal_t, p->minRphV, p->binCnt );
-  p->maxRphV    = cmMemResizeZ( cmReal_t, p->maxRphV, p->binCnt );
-  p->itrV       = cmMemResizeZ( cmReal_t, p->itrV,    p->binCnt );
-  p->phs0V      = cmMemResizeZ( cmReal_t, p->phs0V,   p->binCnt );
-  p->phsV       = cmMemResizeZ( cmReal_t, p->phsV,    p->binCnt );
-  p->mag0V      = cmMemResizeZ( cmReal_t, p->mag0V,   p->binCnt );
-  p->magV       = cmMemResizeZ( cmReal_t, p->magV,    p->binCnt );
-
+  if( maxFrmCnt == 0 || hopSmpCnt == 0 || hopSmpCnt > wndSmpCnt )
+    return cmCtxRtCondition( &p->obj, cmArgAssertRC, "Invalid PV batch synthesis parameters: wnd:%i hop:%i frames:%i.",wndSmpCnt,hopSmpCnt,maxFrmCnt);
 
   if((rc = cmWndFuncInit( &p->wf, wndTypeId, wndSmpCnt, 0)) != cmOkRC )
     return rc;
 
-  if((rc = cmIFftInitRS( &p->ft, p->binCnt )) != cmOkRC )
-    return rc;
+  p->wndSmpCnt = wndSmpCnt;
+  p->hopSmpCnt = hopSmpCnt;
+  p->binCnt    = wndSmpCnt/2 + 1;
+  p->maxFrmCnt = maxFrmCnt;
+  p->outN      = 0;
 
-  if((rc = cmOlaInit(  &p->ola, wndSmpCnt, hopSmpCnt, procSmpCnt, wndTypeId )) != cmOkRC )
-    return rc;
+  p->reM  = cmMemResizeZ( cmSample_t, p->reM,  p->binCnt * maxFrmCnt );
+  p->imM  = cmMemResizeZ( cmSample_t, p->imM,  p->binCnt * maxFrmCnt );
+  p->yM   = cmMemResizeZ( cmSample_t, p->yM,   wndSmpCnt * maxFrmCnt );
+  p->outV = cmMemResizeZ( cmSample_t, p->outV, maxFrmCnt*hopSmpCnt + wndSmpCnt-hopSmpCnt );
 
-  for(k=0; k<p->binCnt; ++k)
-  {
-    // complete revolutions per hop in radians
-    p->itrV[k] = twoPi * floor((double)k * hopSmpCnt / wndSmpCnt ); 
+  if((p->plan = cmFpcAllocSplitS( wndSmpCnt, maxFrmCnt, true, p->yM, p->reM, p->imM )) == NULL )
+    return cmCtxRtCondition( &p->obj, cmSubSysFailRC, "The inverse FFTW plan for %i frames of length %i could not be created.",maxFrmCnt,wndSmpCnt);
 
-    p->minRphV[k] = ((cmReal_t)(k-m)) * hopSmpCnt * twoPi / wndSmpCnt;
-    p->maxRphV[k] = ((cmReal_t)(k+m)) * hopSmpCnt * twoPi / wndSmpCnt;
+  return rc;
+}
 
-    //printf("%f %f %f\n",p->itrV[k],p->minRphV[k],p->maxRphV[k]);
+cmRC_t        cmPvSynBatchFinal(cmPvSynBatch* p )
+{
+  if( p != NULL && p->plan != NULL )
+  {
+    cmFpcReleaseS( p->plan );
+    p->plan = NULL;
   }
-
-  return rc;  
+  return cmOkRC;
 }
 
-cmRC_t     cmPvSynFinal(cmPvSyn* p )
-{ return cmOkRC; }
-
-cmRC_t     cmPvSynExec( cmPvSyn* p, const cmReal_t* magV, const cmReal_t* phsV )
+cmRC_t        cmPvSynBatchExec( cmPvSynBatch* p, const cmReal_t* magM, const cmReal_t* phsM, unsigned frmCnt )
 {
-  double   twoPi     = 2.0 * M_PI;
-  unsigned k;
+  unsigned wn = p->wndSmpCnt;
+  unsigned hn = p->hopSmpCnt;
+  unsigned bn = p->binCnt;
+  unsigned i,k;
 
-  for(k=0; k<p->binCnt; ++k)
-  {
-    // phase dist between cur and prv frame
-    cmReal_t dp = phsV[k] - p->phs0V[k];
+  if( frmCnt > p->maxFrmCnt )
+    return cmCtxRtCondition( &p->obj, cmArgAssertRC, "The PV synthesis frame count (%i) is greater than the max. frame count (%i).",frmCnt,p->maxFrmCnt);
 
-    // dist must be positive (accum phase always increases)
-    if( dp < -0.00001 )
-      dp += twoPi;
+  for(i=0; i<frmCnt*bn; ++i)
+  {
+    p->reM[i] = magM[i] * cos(phsM[i]);
+    p->imM[i] = magM[i] * sin(phsM[i]);
+  }
 
-    // add in complete revolutions based on the bin frequency
-    // (these would have been lost from 'dp' due to phase wrap)
-    dp += p->itrV[k];
+  // the plan always transforms maxFrmCnt frames - clear the unused frames of a short batch
+  if( frmCnt < p->maxFrmCnt )
+  {
+    cmVOS_Zero( p->reM + frmCnt*bn, (p->maxFrmCnt-frmCnt)*bn );
+    cmVOS_Zero( p->imM + frmCnt*bn, (p->maxFrmCnt-frmCnt)*bn );
+  }
 
-    // constrain the phase change to lie within the range of the kth bin
-    if( dp < p->minRphV[k] )
-      dp += twoPi;
+  cmIFftExecuteSplitC2RS( p->plan, p->reM, p->imM, p->yM );
 
-    if( dp > p->maxRphV[k] )
-      dp -= twoPi;
+  // move the overlap remaining from the previous batch to the front of the buffer
+  memmove( p->outV, p->outV + p->outN, (wn-hn) * sizeof(cmSample_t) );
+  cmVOS_Zero( p->outV + wn-hn, frmCnt*hn );
 
-    p->phsV[k] = p->phs0V[k] + dp;
-    p->magV[k] = p->mag0V[k];
-     
-    
-    p->phs0V[k] = phsV[k];
-    p->mag0V[k] = magV[k];
+  // window and overlap-add the frames
+  for(k=0; k<frmCnt; ++k)
+  {
+    cmSample_t* yV = p->yM + k*wn;
+    cmVOS_MultVV( yV, wn, p->wf.wndV );
+    cmVOS_AddVV( p->outV + k*hn, wn, yV );
   }
-  
-  cmIFftExecPolarRS( &p->ft, magV, phsV );
-  
-  cmOlaExecS( &p->ola, p->ft.outV, p->ft.outN ); 
-
-  //printf("%i %i\n",p->binCnt,p->ft.binCnt );
 
-  //cmVOR_Print( p->obj.ctx->outFuncPtr, 1, p->binCnt, magV );
-  //cmVOR_Print( p->obj.ctx->outFuncPtr, 1, p->binCnt, p->phsV );
-  //cmVOS_Print( p->obj.ctx->outFuncPtr, 1, 10, p->ft.outV );
+  p->outN = frmCnt*hn;
 
   return cmOkRC;
 }
 
-cmRC_t  cmPvSynDoIt( cmPvSyn* p, const cmSample_t* v )
-{
-  cmOlaExecS( &p->ola, v, p->wndSmpCnt ); 
+void cmPvBatchTest( cmCtx* ctx )
+{
+  double        srate   = 44100;
+  unsigned      wndN    = 2048;
+  unsigned      hopN    = 512;
+  unsigned      frmN    = 16;                  // frames per batch
+  unsigned      blkN    = 64;                  // count of batches
+  unsigned      fN      = blkN*frmN;           // total count of frames
+  unsigned      xN      = (fN-1)*hopN + wndN;
+  cmSample_t*   x       = cmMemAllocZ(cmSample_t,xN);
+  cmSample_t*   y0      = cmMemAllocZ(cmSample_t,fN*hopN);
+  cmSample_t*   y1      = cmMemAllocZ(cmSample_t,fN*hopN);
+  double        usV[2]  = {0,0};
+  double        magErr  = 0;
+  double        phsErr  = 0;
+  double        hzErr   = 0;
+  double        synErr  = 0;
+  unsigned      i,k,fi;
+  cmTimeSpec_t  t0,t1;
+
+  // the signal is a chirp mixed with noise
+  for(i=0; i<xN; ++i)
+    x[i] = 0.5*sin(2*M_PI*(100.0 + 0.01*i)*i/srate) + 0.1*(2.0*rand()/RAND_MAX - 1.0);
+
+  cmPvAnl*      a0  = cmPvAnlAlloc(ctx,NULL,hopN,srate,wndN,hopN,kCalcHzPvaFl);
+  cmPvSyn*      s0  = cmPvSynAlloc(ctx,NULL,hopN,srate,wndN,hopN,kHannWndId);
+  cmPvAnlBatch* a1  = cmPvAnlBatchAlloc(ctx,NULL,srate,wndN,hopN,frmN,kCalcHzPvaFl);
+  cmPvSynBatch* s1  = cmPvSynBatchAlloc(ctx,NULL,wndN,hopN,frmN,kHannWndId);
+  unsigned      bn  = a0->binCnt;
+  cmReal_t*     mM  = cmMemAllocZ(cmReal_t,bn*fN);
+  cmReal_t*     pM  = cmMemAllocZ(cmReal_t,bn*fN);
+  cmReal_t*     hM  = cmMemAllocZ(cmReal_t,bn*fN);
+  cmReal_t*     mM1 = cmMemAllocZ(cmReal_t,bn*fN);
+  cmReal_t*     pM1 = cmMemAllocZ(cmReal_t,bn*fN);
+  cmReal_t*     hM1 = cmMemAllocZ(cmReal_t,bn*fN);
+
+  // frame by frame - cmPvAnl produces its first frame after wndN samples have been received
+  cmTimeGetMonotonic(&t0);
+  for(i=0,fi=0; i+hopN<=xN && fi<fN; i+=hopN)
+    if( cmPvAnlExec(a0, x + i, hopN) )
+    {
+      const cmSample_t* op;
 
-  //printf("%f\n",cmVOS_RMS(s,p->wndSmpCnt,p->wndSmpCnt));
+      cmVOR_Copy(mM + fi*bn, bn, a0->magV);
+      cmVOR_Copy(pM + fi*bn, bn, a0->phsV);
+      cmVOR_Copy(hM + fi*bn, bn, a0->hzV);
 
-  return cmOkRC;
-}
+      cmPvSynExec(s0, a0->magV, a0->phsV);
 
-const cmSample_t* cmPvSynExecOut(cmPvSyn* p )
-{ return cmOlaExecOut(&p->ola); }
+      for(k=0; (op = cmPvSynExecOut(s0)) != NULL; k+=hopN )
+        cmVOS_Copy(y0 + fi*hopN + k, hopN, op);
+
+      ++fi;
+    }
+  cmTimeGetMonotonic(&t1);
+  usV[0] = cmTimeElapsedMicros(&t0,&t1);
+
+  // batched
+  cmTimeGetMonotonic(&t0);
+  for(k=0; k<blkN; ++k)
+  {
+    unsigned fn = cmPvAnlBatchExec(a1, x + k*frmN*hopN, xN - k*frmN*hopN );
+
+    cmPvSynBatchExec(s1, a1->magM, a1->phsM, fn );
+
+    cmVOS_Copy(y1 + k*frmN*hopN, s1->outN, s1->outV);
+    cmVOR_Copy(mM1 + k*frmN*bn, fn*bn, a1->magM);
+    cmVOR_Copy(pM1 + k*frmN*bn, fn*bn, a1->phsM);
+    cmVOR_Copy(hM1 + k*frmN*bn, fn*bn, a1->hzM);
+  }
+  cmTimeGetMonotonic(&t1);
+  usV[1] = cmTimeElapsedMicros(&t0,&t1);
+
+  for(i=0; i<fN*bn; ++i)
+  {
+    magErr = cmMax(magErr, fabs(mM[i]-mM1[i]) / cmMax(fabs(mM[i]),1e-3));
+
+    // the phase error is only meaningful where the magnitude is significant
+    if( mM[i] > 1e-3 )
+    {
+      double d = fabs(pM[i]-pM1[i]);
+      phsErr = cmMax(phsErr, cmMin(d, 2*M_PI-d));
+      hzErr  = cmMax(hzErr,  fabs(hM[i]-hM1[i]));
+    }
+  }
+
+  for(i=0; i<fN*hopN; ++i)
+    synErr = cmMax(synErr, fabs(y0[i]-y1[i]));
+
+  cmCtxPrint(ctx,"wnd:%i hop:%i frames:%i batch:%i\n",wndN,hopN,fN,frmN);
+  cmCtxPrint(ctx,"frame: %8.0f us  batch: %8.0f us  x%5.2f\n",usV[0],usV[1],usV[1]>0 ? usV[0]/usV[1] : 0);
+  cmCtxPrint(ctx,"max err mag(rel):%g phs:%g hz:%g syn:%g\n",magErr,phsErr,hzErr,synErr);
+
+  cmMemFree(mM);
+  cmMemFree(pM);
+  cmMemFree(hM);
+  cmMemFree(mM1);
+  cmMemFree(pM1);
+  cmMemFree(hM1);
+  cmPvSynBatchFree(&s1);
+  cmPvAnlBatchFree(&a1);
+  cmPvSynFree(&s0);
+  cmPvAnlFree(&a0);
+  cmMemFree(x);
+  cmMemFree(y0);
+  cmMemFree(y1);
+}
 
 
 //------------------------------------------------------------------------------------------------------------
@@ -3519,9 +4477,187 @@ cmRC_t           cmCluster0Exec(  cmCluster0* p, const cmReal_t* v, unsigned vn
 */
 
 
-  cmNmf_t* cmNmfAlloc( cmCtx* ctx, cmNmf_t* ap, unsigned n, unsigned m, unsigned r, unsigned maxIterCnt, unsigned convergeCnt )
+enum { kTileByteCntNmf = 256*1024 };
+
+typedef struct cmNmfPart_str
+{
+  cmNmf_t*         p;
+  unsigned         begColIdx; // first column of V[] and H[] in this partition
+  unsigned         colCnt;    // count of columns in this partition
+  cmReal_t*        tV;        // tV[n,tileColCnt] V./(W*H) for one tile
+  cmReal_t*        uV;        // uV[r,tileColCnt] W'*(V./(W*H)) for one tile
+  cmReal_t*        tnr;       // tnr[n,r]  partial (V./(W*H))*H'
+  cmReal_t*        sumHV;     // sumHV[r]  partial sum(H,2)
+} cmNmfPart_t;
+
+typedef struct cmNmfThreads_str
+{
+  cmNmfPart_t*     partV;     // partV[thCnt]
+  cmThreadPoolH_t  poolH;     // pool with thCnt-1 worker threads
+} cmNmfThreads_t;
+
+// Update the columns of H[] in partition 't' and accumulate the partial
+// numerator (tnr) and denominator (sumHV) of the W update.
+void _cmNmfUpdateCols( cmNmfPart_t* t )
+{
+  cmNmf_t* p      = t->p;
+  unsigned n      = p->n;
+  unsigned r      = p->r;
+  unsigned endIdx = t->begColIdx + t->colCnt;
+  unsigned i,j,k,cn;
+
+  cmVOR_Zero(t->tnr,  n*r);
+  cmVOR_Zero(t->sumHV,r);
+
+  for(j=t->begColIdx; j<endIdx; j+=cn)
+  {
+    cmReal_t* hp = p->H + j*r;
+
+    cn = cmMin(p->tileColCnt,endIdx-j);
+
+    cmVOR_MultMMM( t->tV, n, cn, p->W, hp, r );                           // tV[n,cn] =                W*H
+    cmVOR_DivVVV(  t->tV, n*cn, p->V + j*n, t->tV );                        // tV[n,cn] =            V./(W*H)
+    cmVOR_MultMMM1(t->uV, r, cn, 1.0, p->W, t->tV, n, 0.0, kTransposeM0Fl); // uV[r,cn] =        W'*(V./(W*H))
+
+    // H = (H .* (W'*(V./(W*H)))) ./ repmat(sum(W,1)',1,m)
+    for(k=0; k<cn; ++k)
+      for(i=0; i<r; ++i)
+      {
+        cmReal_t* h = hp + k*r + i;
+        *h = *h * t->uV[k*r+i] / p->sumWV[i];
+        t->sumHV[i] += *h;
+      }
+
+    // tnr[n,r] += (V./(W*H)) * H'
+    cmVOR_MultMMM1(t->tnr, n, r, 1.0, t->tV, hp, cn, 1.0, kTransposeM1Fl );
+  }
+}
+
+void _cmNmfUpdateColsTask( void* arg, unsigned taskIdx )
+{
+  cmNmf_t* p = (cmNmf_t*)arg;
+  _cmNmfUpdateCols(p->thr->partV + taskIdx);
+}
+
+void _cmNmfThreadsFree( cmNmf_t* p )
+{
+  unsigned        i;
+  cmNmfThreads_t* thr = p->thr;
+
+  if( thr == NULL )
+    return;
+
+  if( cmThreadPoolIsValid(thr->poolH) )
+    cmThreadPoolDestroy(&thr->poolH);
+
+  for(i=0; i<p->thCnt; ++i)
+  {
+    cmNmfPart_t* t = thr->partV + i;
+
+    cmMemPtrFree(&t->tV);
+    cmMemPtrFree(&t->uV);
+
+    // partV[0] accumulates directly into p->tnr and p->sumHV
+    if( i > 0 )
+    {
+      cmMemPtrFree(&t->tnr);
+      cmMemPtrFree(&t->sumHV);
+    }
+  }
+
+  cmMemPtrFree(&thr->partV);
+  cmMemPtrFree(&p->thr);
+}
+
+cmRC_t _cmNmfThreadsAlloc( cmNmf_t* p )
+{
+  unsigned        i;
+  unsigned        colIdx = 0;
+  cmNmfThreads_t* thr    = cmMemAllocZ(cmNmfThreads_t,1);
+
+  // a partition must have at least one column
+  p->thCnt   = cmMax(1,cmMin(p->thCnt,p->m));
+  p->thr     = thr;
+  thr->partV = cmMemAllocZ(cmNmfPart_t,p->thCnt);
+  thr->poolH = cmThreadPoolNullHandle;
+
+  for(i=0; i<p->thCnt; ++i)
+  {
+    cmNmfPart_t* t = thr->partV + i;
+
+    t->p         = p;
+    t->begColIdx = colIdx;
+    t->colCnt    = (p->m - colIdx) / (p->thCnt - i);
+    t->tV        = cmMemAllocZ(cmReal_t,p->n*p->tileColCnt);
+    t->uV        = cmMemAllocZ(cmReal_t,p->r*p->tileColCnt);
+    t->tnr       = i==0 ? p->tnr   : cmMemAllocZ(cmReal_t,p->n*p->r);
+    t->sumHV     = i==0 ? p->sumHV : cmMemAllocZ(cmReal_t,p->r);
+    colIdx      += t->colCnt;
+  }
+
+  if( p->thCnt > 1 )
+    if( cmThreadPoolCreate(&thr->poolH,p->thCnt-1,p->obj.err.rpt) != kOkThRC )
+      return cmCtxRtCondition(&p->obj, cmSubSysFailRC, "The NMF thread pool create failed.");
+
+  return cmOkRC;
+}
+
+// Run _cmNmfUpdateCols() on every partition and combine the partial sums into p->tnr and p->sumHV.
+void _cmNmfUpdateH( cmNmf_t* p )
+{
+  cmNmfThreads_t* thr = p->thr;
+  unsigned        i;
+
+  if( p->thCnt == 1 )
+  {
+    _cmNmfUpdateCols(thr->partV);
+    return;
+  }
+
+  cmThreadPoolRun(thr->poolH,_cmNmfUpdateColsTask,p,p->thCnt);
+
+  for(i=1; i<p->thCnt; ++i)
+  {
+    cmNmfPart_t* t = thr->partV + i;
+    cmVOR_AddVV(p->tnr,  p->n*p->r, t->tnr );
+    cmVOR_AddVV(p->sumHV,p->r,      t->sumHV );
+  }
+}
+
+// Return the count of columns whose assignment in idxV[] is not consistent
+// with idx0V[]. Two assignments produce the same connectivity matrix
+// if and only if one is a one-to-one relabeling of the other.
+unsigned _cmNmfChangeCount( cmNmf_t* p )
+{
+  unsigned* m01 = p->mapV;        // m01[r] maps idx0V[] labels to idxV[] labels
+  unsigned* m10 = p->mapV + p->r; // m10[r] maps idxV[] labels to idx0V[] labels
+  unsigned  cnt = 0;
+  unsigned  j;
+
+  cmVOU_Fill(p->mapV,2*p->r,cmInvalidIdx);
+
+  for(j=0; j<p->m; ++j)
+  {
+    unsigned a = p->idx0V[j];
+    unsigned b = p->idxV[j];
+
+    if( m01[a]==cmInvalidIdx && m10[b]==cmInvalidIdx )
+    {
+      m01[a] = b;
+      m10[b] = a;
+    }
+    else
+      if( m01[a] != b || m10[b] != a )
+        ++cnt;
+  }
+
+  return cnt;
+}
+
+cmNmf_t* cmNmfAlloc( cmCtx* ctx, cmNmf_t* ap, unsigned n, unsigned m, unsigned r, unsigned maxIterCnt, unsigned convergeCnt )
 {
   cmNmf_t* p = cmObjAlloc( cmNmf_t, ctx, ap );
+  p->thCnt = 1;
   if( n != 0 )
     if( cmNmfInit( p, n, m, r, maxIterCnt, convergeCnt ) != cmOkRC )
       cmNmfFree(&p);
@@ -3536,19 +4672,16 @@ cmRC_t   cmNmfFree( cmNmf_t** pp )
 
   cmNmf_t* p = *pp;
 
+  cmNmfFinal(p);
   cmMemPtrFree(&p->V);
   cmMemPtrFree(&p->W);
   cmMemPtrFree(&p->H);
-  cmMemPtrFree(&p->tr);
-  cmMemPtrFree(&p->x);
-  cmMemPtrFree(&p->t0nm);
-  cmMemPtrFree(&p->t1nm);
-  cmMemPtrFree(&p->Wt);
-  cmMemPtrFree(&p->trm);
-  cmMemPtrFree(&p->crm);
-  cmMemPtrFree(&p->c0);
-  cmMemPtrFree(&p->c1);
+  cmMemPtrFree(&p->sumWV);
+  cmMemPtrFree(&p->sumHV);
+  cmMemPtrFree(&p->tnr);
   cmMemPtrFree(&p->idxV);
+  cmMemPtrFree(&p->idx0V);
+  cmMemPtrFree(&p->mapV);
 
   cmObjFree(pp);
   return cmOkRC;
@@ -3571,32 +4704,42 @@ cmRC_t   cmNmfInit( cmNmf_t* p,  unsigned n, unsigned m, unsigned r, unsigned ma
   p->V          = cmMemResizeZ(cmReal_t, p->V,    n*m );
   p->W          = cmMemResize( cmReal_t, p->W,    n*r );
   p->H          = cmMemResize( cmReal_t, p->H,    r*m );
-  p->tr         = cmMemResize( cmReal_t, p->tr,   r );
-  p->x          = cmMemResize( cmReal_t, p->x,    r*cmMax(m,n) );
-  p->t0nm       = cmMemResize( cmReal_t, p->t0nm, cmMax(r,n)*m );
-  p->Ht         = p->t0nm;
-  p->t1nm       = cmMemResize( cmReal_t, p->t1nm, n*m );
-  p->Wt         = cmMemResize( cmReal_t, p->Wt,   r*n );
-  p->trm        = cmMemResize( cmReal_t, p->trm,  r*cmMax(m,n) );
-  p->crm        = cmMemResizeZ(unsigned, p->crm,  r*m);
-  p->tnr        = p->trm;
-  p->c0         = cmMemResizeZ(unsigned, p->c0,   m*m);
-  p->c1         = cmMemResizeZ(unsigned, p->c1,   m*m);
+  p->sumWV      = cmMemResize( cmReal_t, p->sumWV,r );
+  p->sumHV      = cmMemResize( cmReal_t, p->sumHV,r );
+  p->tnr        = cmMemResize( cmReal_t, p->tnr,  n*r );
   p->idxV       = cmMemResizeZ(unsigned, p->idxV, m );
-  p->c0m        = p->c0;
-  p->c1m        = p->c1;
+  p->idx0V      = cmMemResizeZ(unsigned, p->idx0V,m );
+  p->mapV       = cmMemResizeZ(unsigned, p->mapV, 2*r );
+  p->tileColCnt = cmMax(1,cmMin(m, kTileByteCntNmf / (n*sizeof(cmReal_t))));
+  p->iterCnt    = 0;
+  p->changeCnt  = 0;
 
   cmVOR_Random(p->W,n*r,0.0,1.0);
   cmVOR_Random(p->H,r*m,0.0,1.0);
 
-  return rc;
+  return _cmNmfThreadsAlloc(p);
   
 }
 
 cmRC_t   cmNmfFinal(cmNmf_t* p )
-{ return cmOkRC; }
+{
+  if( p != NULL )
+    _cmNmfThreadsFree(p);
+  return cmOkRC;
+}
+
+cmRC_t   cmNmfSetThreadCount( cmNmf_t* p, unsigned thCnt )
+{
+  _cmNmfThreadsFree(p);
+
+  p->thCnt = thCnt;
 
+  // the threads are created by cmNmfInit() if the object is not yet initialized
+  if( p->m == 0 )
+    return cmOkRC;
 
+  return _cmNmfThreadsAlloc(p);
+}
 
 // NMF base on: Lee and Seung, 2001, Algo's for Non-negative Matrix Fcmtorization
 // Connectivity stopping technique based on: http://www.broadinstitute.org/mpr/publications/projects/NMF/nmf.m 
@@ -3622,71 +4765,179 @@ cmRC_t   cmNmfExec( cmNmf_t* p, const cmReal_t* vM, unsigned cn )
     cmVOR_Shift( p->H, r*m, r*cn,0);
   cmVOR_Random(p->H, r*cn, 0.0, 1.0 );
 
-  cmVOU_Zero( p->c1m, m*m );
-
-  for(i=0,j=0; i<p->maxIterCnt && stopIter<p->convergeCnt; ++i)
+  for(i=0; i<p->maxIterCnt && stopIter<p->convergeCnt; ++i)
   {
-    // x[r,m] =repmat(sum(W,1)',1,m);
-    cmVOR_SumM( p->W, n, r, p->tr );
-    for(j=0; j<m; ++j)
-      cmVOR_Copy( p->x + (j*r), r, p->tr );
+    // H=H.*(W'*(V./(W*H)))./repmat(sum(W,1)',1,m);
+    cmVOR_SumM( p->W, n, r, p->sumWV );
+    _cmNmfUpdateH(p);
 
-    cmVOR_Transpose(p->Wt,p->W,n,r);
+    // W=W.*((V./(W*H))*H')./repmat(sum(H,2)',n,1);
+    for(k=0; k<r; ++k)
+      for(j=0; j<n; ++j)
+        p->W[k*n+j] = p->W[k*n+j] * p->tnr[k*n+j] / p->sumHV[k];
 
-    //H=H.*(W'*(V./(W*H)))./x;
-    cmVOR_MultMMM(p->t0nm,n,m,p->W,p->H,r);    // t0nm[n,m] =                W*H  
-    cmVOR_DivVVV( p->t1nm,n*m,p->V,p->t0nm);   // t1nm[n,m] =            V./(W*H)
-    cmVOR_MultMMM(p->trm,r,m,p->Wt,p->t1nm,n); // trm[r,m]  =        W'*(V./(W*H))
-    cmVOR_MultVV(p->H,r*m,p->trm);             // H[r,m]    =  H .* (W'*(V./(W*H)))
-    cmVOR_DivVV(p->H,r*m, p->x );              // H[r,m]    = (H .* (W'*(V./(W*H)))) ./ x
-
-    // x[n,r]=repmat(sum(H,2)',n,1);
-    cmVOR_SumMN(p->H, r, m, p->tr );
-    for(j=0; j<n; ++j)
-      cmVOR_CopyN(p->x + j, r, n, p->tr, 1 );
-
-    cmVOR_Transpose(p->Ht,p->H,r,m);
-
-    //  W=W.*((V./(W*H))*H')./x;
-    cmVOR_MultMMM(p->tnr,n,r,p->t1nm,p->Ht,m); // tnr[n,r]  =       (V./(W*H))*Ht
-    cmVOR_MultVV(p->W,n*r,p->tnr);             // W[n,r]    =    W.*(V./(W*H))*Ht
-    cmVOR_DivVV(p->W,n*r,p->x);                // W[n,r]    =    W.*(V./(W*H))*Ht ./x
-
-    if( i % 10 == 0 )
+    if( i % kCheckPeriodNmf == 0 )
     {
+      unsigned* t;
 
       cmVOR_ReplaceLte( p->H, r*m, p->H, 2.2204e-16, 2.2204e-16 );
       cmVOR_ReplaceLte( p->W, n*r, p->W, 2.2204e-16, 2.2204e-16 );
 
       cmVOR_MaxIndexM( p->idxV, p->H, r, m );
 
-      unsigned mismatchCnt = 0;
-
-      for(j=0; j<m; ++j)
-        for(k=0; k<m; ++k)
-        {
-          unsigned c_idx = (j*m)+k;
-          p->c0m[ c_idx ] = p->idxV[j] == p->idxV[k];
-          mismatchCnt += p->c0m[ c_idx ] != p->c1m[ c_idx ];
-        }
+      // the first test has no previous assignment to compare to
+      p->changeCnt = i==0 ? m : _cmNmfChangeCount(p);
       
-      if( mismatchCnt == 0 )
+      if( p->changeCnt == 0 )
         ++stopIter;
       else
         stopIter = 0;
 
-      printf("%i %i %i\n",i,stopIter,mismatchCnt);
-      fflush(stdout);
-
-      unsigned* tcm = p->c0m;
-      p->c0m = p->c1m;
-      p->c1m = tcm;
+      t        = p->idx0V;
+      p->idx0V = p->idxV;
+      p->idxV  = t;
     }
   }
 
+  p->iterCnt = i;
+
   return rc;
 }
 
+//------------------------------------------------------------------------------------------------------------
+// Original (untiled, single threaded) implementation of the update rules used by cmNmfTest().
+void _cmNmfTestRef( unsigned n, unsigned m, unsigned r, const cmReal_t* V, cmReal_t* W, cmReal_t* H, unsigned iterCnt )
+{
+  cmReal_t* tr   = cmMemAllocZ(cmReal_t,r);
+  cmReal_t* x    = cmMemAllocZ(cmReal_t,r*cmMax(m,n));
+  cmReal_t* t0nm = cmMemAllocZ(cmReal_t,cmMax(r,n)*m);
+  cmReal_t* t1nm = cmMemAllocZ(cmReal_t,n*m);
+  cmReal_t* Wt   = cmMemAllocZ(cmReal_t,r*n);
+  cmReal_t* trm  = cmMemAllocZ(cmReal_t,r*cmMax(m,n));
+  cmReal_t* Ht   = t0nm;
+  cmReal_t* tnr  = trm;
+  unsigned  i,j;
+
+  for(i=0; i<iterCnt; ++i)
+  {
+    cmVOR_SumM( W, n, r, tr );
+    for(j=0; j<m; ++j)
+      cmVOR_Copy( x + (j*r), r, tr );
+
+    cmVOR_Transpose(Wt,W,n,r);
+
+    cmVOR_MultMMM(t0nm,n,m,W,H,r);
+    cmVOR_DivVVV( t1nm,n*m,V,t0nm);
+    cmVOR_MultMMM(trm,r,m,Wt,t1nm,n);
+    cmVOR_MultVV(H,r*m,trm);
+    cmVOR_DivVV(H,r*m,x);
+
+    cmVOR_SumMN(H, r, m, tr );
+    for(j=0; j<n; ++j)
+      cmVOR_CopyN(x + j, r, n, tr, 1 );
+
+    cmVOR_Transpose(Ht,H,r,m);
+
+    cmVOR_MultMMM(tnr,n,r,t1nm,Ht,m);
+    cmVOR_MultVV(W,n*r,tnr);
+    cmVOR_DivVV(W,n*r,x);
+
+    if( i % kCheckPeriodNmf == 0 )
+    {
+      cmVOR_ReplaceLte( H, r*m, H, 2.2204e-16, 2.2204e-16 );
+      cmVOR_ReplaceLte( W, n*r, W, 2.2204e-16, 2.2204e-16 );
+    }
+  }
+
+  cmMemFree(tr);
+  cmMemFree(x);
+  cmMemFree(t0nm);
+  cmMemFree(t1nm);
+  cmMemFree(Wt);
+  cmMemFree(trm);
+}
+
+double _cmNmfTestMaxRelErr( const cmReal_t* v0, const cmReal_t* v1, unsigned n )
+{
+  double   err = 0;
+  unsigned i;
+  for(i=0; i<n; ++i)
+    err = cmMax(err, fabs(v0[i]-v1[i]) / cmMax(fabs(v0[i]),1e-12));
+  return err;
+}
+
+void cmNmfTest( cmCtx* ctx )
+{
+  typedef struct { unsigned n,m,r; } sz_t;
+
+  sz_t      szV[]   = { {257,1000,8}, {513,2000,16}, {1025,4000,16}, {2049,8000,32} };
+  unsigned  szN     = sizeof(szV)/sizeof(szV[0]);
+  unsigned  thCntV[]= { 1, 2, 4, 8 };
+  unsigned  thCntN  = sizeof(thCntV)/sizeof(thCntV[0]);
+  unsigned  iterCnt = 10;
+  cmRpt_t*  rpt     = ctx->obj.err.rpt;
+  unsigned  i,j;
+
+  cmRptPrintf(rpt,"ms per iteration (ref=original implementation) err=max relative error of W and H vs. ref\n");
+  cmRptPrintf(rpt,"    n     m   r      ref");
+  for(j=0; j<thCntN; ++j)
+    cmRptPrintf(rpt,"   th=%i",thCntV[j]);
+  cmRptPrintf(rpt,"     err\n");
+
+  for(i=0; i<szN; ++i)
+  {
+    unsigned     n    = szV[i].n;
+    unsigned     m    = szV[i].m;
+    unsigned     r    = szV[i].r;
+    cmReal_t*    V    = cmMemAllocZ(cmReal_t,n*m);
+    cmReal_t*    W    = cmMemAllocZ(cmReal_t,n*r);
+    cmReal_t*    H    = cmMemAllocZ(cmReal_t,r*m);
+    double       err  = 0;
+    cmTimeSpec_t t0,t1;
+
+    cmVOR_Random(V,n*m,0.01,1.0);
+
+    // reproduce the initial state of W[] and H[] from cmNmfInit() and cmNmfExec()
+    srand(1);
+    cmVOR_Random(W,n*r,0.0,1.0);
+    cmVOR_Random(H,r*m,0.0,1.0);
+    srand(2);
+    cmVOR_Random(H,r*m,0.0,1.0);
+
+    cmTimeGetMonotonic(&t0);
+    _cmNmfTestRef(n,m,r,V,W,H,iterCnt);
+    cmTimeGetMonotonic(&t1);
+    cmRptPrintf(rpt,"%5i %5i %3i %8.2f",n,m,r,cmTimeElapsedMicros(&t0,&t1)/(1000.0*iterCnt));
+
+    for(j=0; j<thCntN; ++j)
+    {
+      cmNmf_t* p = cmNmfAlloc(ctx,NULL,0,0,0,0,0);
+      cmNmfSetThreadCount(p,thCntV[j]);
+
+      // an unreachable convergence count forces 'iterCnt' iterations
+      srand(1);
+      cmNmfInit(p,n,m,r,iterCnt,iterCnt+1);
+      srand(2);
+
+      cmTimeGetMonotonic(&t0);
+      cmNmfExec(p,V,m);
+      cmTimeGetMonotonic(&t1);
+      cmRptPrintf(rpt," %7.2f",cmTimeElapsedMicros(&t0,&t1)/(1000.0*iterCnt));
+
+      err = cmMax(err,_cmNmfTestMaxRelErr(W,p->W,n*r));
+      err = cmMax(err,_cmNmfTestMaxRelErr(H,p->H,r*m));
+
+      cmNmfFree(&p);
+    }
+
+    cmRptPrintf(rpt,"  %7.1e\n",err);
+
+    cmMemFree(V);
+    cmMemFree(W);
+    cmMemFree(H);
+  }
+}
+
 //------------------------------------------------------------------------------------------------------------
 
 unsigned _cmVectArrayTypeByteCnt( cmVectArray_t* p, unsigned flags )
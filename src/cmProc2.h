@@ -180,19 +180,38 @@ extern "C" {
   //)
   
   //( { label:cmFIR file_desc:"Finite impulse response filter." kw:[proc]}
+  //
+  // The filter is applied a block at a time. Each channel has a linear buffer which
+  // holds coeffCnt-1 samples of history followed by the incoming block so that the
+  // SIMD block FIR kernel (cmVOS_FirVV()) reads contiguous memory. 
+  // If kFftFIRFl is set the filter is applied with the partitioned FFT
+  // convolver (cmConvolve). This is only faster than the direct form for long
+  // filters - use cmFIRTest2() to find the crossover on the target machine.
+  // Blocks shorter than procSmpCnt are buffered internally and the output for
+  // an incomplete block is computed with the direct form, so the output is
+  // independent of the block sizes passed to cmFIRExec().
+  //
+  // Use cmFIRSetChCount() and cmFIRExecMC() to filter multiple channels
+  // with the same coefficients.
   typedef struct
   {
     cmObj       obj;
     double*     coeffV;      // FIR coefficient vector (impulse response)
     unsigned    coeffCnt;    // count of elements in coeffV
-    double*     delayV;      // delay vector contains one less elements than the coeff array
-    cmSample_t* outV;        // output signal
-    unsigned    outN;        // length of the output signal (outN == ctx.procSmpCnt)
-    unsigned    delayIdx;    // current next sample to receive input in the the delay line
+    unsigned    flags;       // see kXXXFIRFl
+    cmSample_t* hrV;         // hrV[coeffCnt] time reversed copy of coeffV[] 
+    cmSample_t* xV;          // xV[chCnt*xN] per channel history followed by the current input block
+    unsigned    xN;          // coeffCnt-1 + procSmpCnt
+    unsigned    chCnt;       // count of channels
+    struct cmConvolve_str** cnvV; // cnvV[chCnt] FFT convolvers or NULL if the filter is applied directly
+    cmSample_t* bufV;        // bufV[chCnt*outN] FFT convolver input blocks (channel c is at bufV[c*outN])
+    unsigned    bi;          // count of samples in the current FFT convolver input block
+    cmSample_t* outV;        // output signal (channel c is at outV[c*outN])
+    unsigned    outN;        // length of the output signal per channel (outN == ctx.procSmpCnt)
 
   } cmFIR;
 
-  enum { kHighPassFIRFl = 0x01 };
+  enum { kHighPassFIRFl = 0x01, kFftFIRFl = 0x02 };
 
   // Note that the relative values of passHz and stopHz do not matter
   // for low-pass vs high-pass filters.  In practice passHz and
@@ -207,10 +226,24 @@ extern "C" {
   cmRC_t cmFIRInitKaiser( cmFIR* p, unsigned procSmpCnt, double srate, double passHz,       double stopHz, double passDb, double stopDb, unsigned flags );
   cmRC_t cmFIRInitSinc(   cmFIR* p, unsigned procSmpCnt, double srate, unsigned sincSmpCnt, double fcHz,   unsigned flags, const double* wndV );
   cmRC_t cmFIRFinal(      cmFIR* p );
+
+  // Set the count of channels processed by cmFIRExecMC(). The filter state is cleared.
+  // The count of channels is set to 1 by cmFIRInitKaiser() and cmFIRInitSinc().
+  cmRC_t cmFIRSetChCount( cmFIR* p, unsigned chCnt );
+
+  // Filter sp[sn] into outV[0:sn].
   cmRC_t cmFIRExec(       cmFIR* p, const cmSample_t* sp, unsigned sn );
+
+  // Filter spp[chCnt][sn] into outV[c*outN:c*outN+sn]. chCnt must match the value set with cmFIRSetChCount().
+  cmRC_t cmFIRExecMC(     cmFIR* p, const cmSample_t** spp, unsigned chCnt, unsigned sn );
+
   void   cmFIRTest0( cmRpt_t* rpt, cmLHeapH_t lhH, cmSymTblH_t stH );
   void   cmFIRTest1( cmCtx* ctx );
 
+  // Verify the direct, multi-channel and FFT implementations against a reference
+  // implementation and time them for a range of coefficient counts.
+  void   cmFIRTest2( cmCtx* ctx );
+
   //------------------------------------------------------------------------------------------------------------
   //)
   
@@ -269,43 +302,77 @@ extern "C" {
   //)
   
   //( { label:cmConvolve file_desc:"Convolve a signal with an impulse response." kw:[proc]}
+  //
+  // Uniformly partitioned overlap-save convolution with a frequency domain delay line.
+  // The impulse response is split into partitions of procSmpCnt samples and the
+  // output block is returned by the same cmConvolveExec() call which received the
+  // input block, so the only latency is the block size. The cost per block is one FFT/IFFT pair of
+  // length nextPowerOfTwo(2*procSmpCnt) plus one complex multiply-add per partition.
+  //
+  // Long impulse responses may optionally be split (cmConvolveAllocTail()):
+  // the head, h[0:2*tailSmpCnt], is processed in the cmConvolveExec() call, and the
+  // tail, h[2*tailSmpCnt:hn], is processed by a background thread using
+  // partitions of tailSmpCnt samples. The background thread has tailSmpCnt samples
+  // of time in which to complete each tail block, so the cost of cmConvolveExec()
+  // does not grow with the length of the impulse response. If the background
+  // thread has not finished a block when it is needed cmConvolveExec() waits for it.
+
+  // Partitioned convolution state for one partition size.
   typedef struct
   {
-    cmObj     obj;
-    cmFftSR*  fft;
-    cmIFftRS* ifft;
-
-    cmComplexR_t* H; 
-
-    unsigned    hn;
-    cmSample_t* olaV;   // olaV[hn-1];
-
-    cmSample_t* outV;  // outV[procSmpCnt]
-    unsigned    outN;  // outN == procSmpCnt
+    cmFftSS*    fft;
+    cmIFftSS*   ifft;
+    unsigned    blkN;   // partition and hop length in samples
+    unsigned    binN;   // count of spectrum bins
+    unsigned    partN;  // count of partitions
+    cmSample_t* inV;    // inV[ fft->wndSmpCnt ] overlap-save input window
+    cmSample_t* hrV;    // hrV[ partN*binN ] impulse response partition spectra (real part, scaled by 1/fft->wndSmpCnt)
+    cmSample_t* hiV;    // hiV[ partN*binN ] (imag. part)
+    cmSample_t* xrV;    // xrV[ partN*binN ] frequency domain delay line (real part)
+    cmSample_t* xiV;    // xiV[ partN*binN ] (imag. part)
+    cmSample_t* arV;    // arV[ binN ] spectrum accumulator (real part)
+    cmSample_t* aiV;    // aiV[ binN ] (imag. part)
+    unsigned    xi;     // index of the newest spectrum in the delay line
+  } cmConvolvePart;
+
+  typedef struct cmConvolve_str
+  {
+    cmObj          obj;
+    cmConvolvePart head;   // partitions of h[0:headN] processed in cmConvolveExec()
+    struct cmConvolveTail_str* tail; // partitions of h[headN:hn] processed by the background thread (or NULL)
+    unsigned       headN;  // count of impulse response samples in 'head'
+    unsigned       hn;     // impulse response length
+    unsigned       blkIdx; // count of blocks processed since the last call to cmConvolveInit()
+
+    cmSample_t*    outV;  // outV[procSmpCnt]
+    unsigned       outN;  // outN == procSmpCnt
   } cmConvolve;
 
-  // After cmConvolveExec() outV[outN] contains the first outN samples
-  // which are complete and can be used by the application.
-  // The tail of the convolution is held in olaV[hn-1] and will
-  // be automatically summed with the beginning of the next convolution
-  // frame. 
-
-  // BUG BUG BUG
-  // This code seems to have a problem when hn != procSmpCnt (or maybe hn > procSmpCnt ???).  
-  // See mas/main.c convolve() where procSmpCnt must be set to wndSmpCnt size or 
-  // only the first half of the window is emitted.
+  // After cmConvolveExec() outV[outN] contains the output samples
+  // associated with the input block x[].
 
-
-  // h[hn] is the impulse response to convolve with
+  // h[hn] is the impulse response to convolve with.
   cmConvolve* cmConvolveAlloc( cmCtx* c, cmConvolve* p, const cmSample_t* h, unsigned hn, unsigned procSmpCnt );
   cmRC_t      cmConvolveFree(  cmConvolve** pp );
   cmRC_t      cmConvolveInit(  cmConvolve* p, const cmSample_t* h, unsigned hn, unsigned procSmpCnt );
   cmRC_t      cmConvolveFinal( cmConvolve* p );
-  // xn must be <= procSmpCnt
+
+  // Same as cmConvolveAlloc/Init() but process the tail of the impulse response in
+  // a background thread using partitions of tailSmpCnt samples. tailSmpCnt is
+  // rounded up to a multiple of procSmpCnt. If tailSmpCnt is 0 or hn <= 2*tailSmpCnt
+  // then no background thread is used.
+  cmConvolve* cmConvolveAllocTail( cmCtx* c, cmConvolve* p, const cmSample_t* h, unsigned hn, unsigned procSmpCnt, unsigned tailSmpCnt );
+  cmRC_t      cmConvolveInitTail(  cmConvolve* p, const cmSample_t* h, unsigned hn, unsigned procSmpCnt, unsigned tailSmpCnt );
+
+  // xn must be <= procSmpCnt. If xn < procSmpCnt the input block is padded with zeros.
+  // x may be NULL to convolve a block of zeros.
   cmRC_t      cmConvolveExec(  cmConvolve* p, const cmSample_t* x, unsigned xn );
 
+  // Convolve x[xn] with h[hn] and store the result in y[yn]. (yn <= xn+hn-1)
   cmRC_t      cmConvolveSignal( cmCtx* c, const cmSample_t* h, unsigned hn, const cmSample_t* x, unsigned xn, cmSample_t* y, unsigned yn );
 
+  // Verify the convolver against direct convolution and report the cost per
+  // block for a range of impulse response lengths.
   cmRC_t      cmConvolveTest( cmRpt_t* rpt, cmLHeapH_t lhH, cmSymTblH_t stH );
 
   //------------------------------------------------------------------------------------------------------------
@@ -488,6 +555,98 @@ extern "C" {
   cmRC_t     cmPvSynExec( cmPvSyn* p, const cmReal_t* magV, const cmReal_t* phsV );
   const cmSample_t* cmPvSynExecOut(cmPvSyn* p );
 
+  //------------------------------------------------------------------------------------------------------------
+  //)
+  //( { label:cmPvAnlBatch file_desc:"Phase-vocoder analysis of a block of hops using a single FFT many-plan." kw:[proc]}
+  //
+  // cmPvAnlBatchExec() analyzes up to maxFrmCnt frames of a signal which is already in memory.
+  // Frame k is x[k*hopSmpCnt : k*hopSmpCnt+wndSmpCnt]. The window multiply, the FFT's and the
+  // polar conversion are each executed once across the whole batch.
+  //
+  // The output matrices are stored column (frame) major: bin i of frame k is at magM[k*binCnt + i].
+  // They remain valid until the next call to cmPvAnlBatchExec() and may be read directly by
+  // later stages (e.g. cmPvSynBatchExec()).
+  //
+  // The window and magnitude scaling match cmPvAnl. Given the same signal the kth frame
+  // produced by successive calls to cmPvAnlBatchExec() is the kth frame produced by cmPvAnl.
+
+  typedef struct
+  {
+    cmObj         obj;
+    cmWndFunc     wf;
+
+    unsigned      flags;      // see kXXXPvaFl
+    double        srate;
+    unsigned      wndSmpCnt;
+    unsigned      hopSmpCnt;
+    unsigned      binCnt;
+    unsigned      maxFrmCnt;  // max. count of frames per batch
+    unsigned      frmCnt;     // count of frames computed by the last call to cmPvAnlBatchExec()
+
+    cmFftPlanS_t  plan;       // split format r2c plan for maxFrmCnt frames
+    cmSample_t*   xM;         // xM[ wndSmpCnt, maxFrmCnt ]  windowed frames
+    cmSample_t*   reM;        // reM[ binCnt, maxFrmCnt ]    real part of the spectra
+    cmSample_t*   imM;        // imM[ binCnt, maxFrmCnt ]    imaginary part of the spectra
+
+    cmReal_t*     magM;       // magM[ binCnt, maxFrmCnt ]  amplitude NOT power
+    cmReal_t*     phsM;       // phsM[ binCnt, maxFrmCnt ]
+    cmReal_t*     hzM;        // hzM[  binCnt, maxFrmCnt ]  instantaneous frequency (kCalcHzPvaFl only)
+
+    cmReal_t*     wV;         // wV[ binCnt ] bin frequency in radians per hop
+    cmReal_t*     phs0V;      // phs0V[ binCnt ] phase of the last frame of the previous batch
+
+  } cmPvAnlBatch;
+
+  cmPvAnlBatch* cmPvAnlBatchAlloc( cmCtx* ctx, cmPvAnlBatch* p, double srate, unsigned wndSmpCnt, unsigned hopSmpCnt, unsigned maxFrmCnt, unsigned flags );
+  cmRC_t        cmPvAnlBatchFree( cmPvAnlBatch** pp );
+  cmRC_t        cmPvAnlBatchInit( cmPvAnlBatch* p, double srate, unsigned wndSmpCnt, unsigned hopSmpCnt, unsigned maxFrmCnt, unsigned flags );
+  cmRC_t        cmPvAnlBatchFinal(cmPvAnlBatch* p );
+
+  // Analyze the frames which lie entirely inside x[xN] (up to maxFrmCnt frames).
+  // Returns the count of frames computed. The next batch begins at x[ frmCnt*hopSmpCnt ].
+  unsigned      cmPvAnlBatchExec( cmPvAnlBatch* p, const cmSample_t* x, unsigned xN );
+
+  //------------------------------------------------------------------------------------------------------------
+  //)
+  //( { label:cmPvSynBatch file_desc:"Phase-vocoder synthesis of a block of hops using a single inverse FFT many-plan." kw:[proc]}
+  //
+  // cmPvSynBatchExec() converts frmCnt polar spectra (stored column major as produced
+  // by cmPvAnlBatch) to the time domain with one inverse FFT call and overlap-adds them
+  // into outV[0:frmCnt*hopSmpCnt]. The output is identical to the output of cmPvSyn
+  // given the same sequence of frames.
+
+  typedef struct
+  {
+    cmObj         obj;
+    cmWndFunc     wf;
+
+    unsigned      wndSmpCnt;
+    unsigned      hopSmpCnt;
+    unsigned      binCnt;
+    unsigned      maxFrmCnt;  // max. count of frames per batch
+
+    cmFftPlanS_t  plan;       // split format c2r plan for maxFrmCnt frames
+    cmSample_t*   reM;        // reM[ binCnt, maxFrmCnt ]
+    cmSample_t*   imM;        // imM[ binCnt, maxFrmCnt ]
+    cmSample_t*   yM;         // yM[ wndSmpCnt, maxFrmCnt ] time domain frames
+
+    cmSample_t*   outV;       // outV[ maxFrmCnt*hopSmpCnt + wndSmpCnt-hopSmpCnt ] overlap-add buffer
+    unsigned      outN;       // count of output samples in outV[] produced by the last call to cmPvSynBatchExec()
+
+  } cmPvSynBatch;
+
+  cmPvSynBatch* cmPvSynBatchAlloc( cmCtx* ctx, cmPvSynBatch* p, unsigned wndSmpCnt, unsigned hopSmpCnt, unsigned maxFrmCnt, unsigned wndTypeId );
+  cmRC_t        cmPvSynBatchFree( cmPvSynBatch** pp );
+  cmRC_t        cmPvSynBatchInit( cmPvSynBatch* p, unsigned wndSmpCnt, unsigned hopSmpCnt, unsigned maxFrmCnt, unsigned wndTypeId );
+  cmRC_t        cmPvSynBatchFinal(cmPvSynBatch* p );
+
+  // magM[binCnt,frmCnt] and phsM[binCnt,frmCnt] hold the frames to synthesize.
+  // frmCnt must be less than or equal to maxFrmCnt.
+  cmRC_t        cmPvSynBatchExec( cmPvSynBatch* p, const cmReal_t* magM, const cmReal_t* phsM, unsigned frmCnt );
+
+  // Verify cmPvAnlBatch and cmPvSynBatch against cmPvAnl and cmPvSyn and time them.
+  void          cmPvBatchTest( cmCtx* ctx );
+
   //------------------------------------------------------------------------------------------------------------
   //)
   
@@ -776,6 +935,34 @@ extern "C" {
   */
 
   //( { label:cmNmf file_desc:"Non-negative matrix factorization implementation." kw:[proc]}
+  //
+  // Factor V[n,m] into W[n,r]*H[r,m] with the Lee and Seung multiplicative update
+  // rules for the divergence cost.
+  //
+  // Each iteration makes one pass over the columns of V[] and H[] in tiles of
+  // 'tileColCnt' columns. The working set of a tile (V./(W*H) for the tile) is sized
+  // to fit in the cache and the n x m intermediate matrices of the textbook
+  // implementation are never formed. The matrix products use VECT_OP_FUNC(MultMMM1)
+  // (cblas gemm when CM_VECTOP is defined).
+  //
+  // cmNmfSetThreadCount() partitions the columns of H[] and runs the partitions
+  // on a cmThreadPool. The H update is independent per column and each partition
+  // accumulates private partial sums for the W update which are combined when all
+  // partitions are complete. The calling thread also runs partitions. When CM_VECTOP
+  // links to a multi-threaded BLAS the BLAS thread count should be limited to
+  // avoid over-subscribing the CPU.
+  //
+  // Convergence is tested every kCheckPeriodNmf iterations by assigning each
+  // column of H[] to its maximum row. Iteration stops when the assignment has
+  // partitioned the columns identically for 'convergeCnt' consecutive tests.
+  // This is equivalent to the connectivity matrix test of Brunet et al.
+  // (http://www.broadinstitute.org/mpr/publications/projects/NMF/nmf.m)
+  // but takes O(m) rather than O(m^2) time and memory.
+
+  enum { kCheckPeriodNmf = 10 };
+
+  struct cmNmfThreads_str;
+
   typedef struct
   {
     cmObj     obj;
@@ -790,20 +977,19 @@ extern "C" {
     cmReal_t* W;  // W[n,r]
     cmReal_t* H;  // H[r,m]
 
-    cmReal_t* tr;
-    cmReal_t* x;
-    cmReal_t* t0nm;
-    cmReal_t* t1nm;
-    cmReal_t* Wt;
-    cmReal_t* Ht;
-    cmReal_t* trm;
-    unsigned* crm;
-    cmReal_t* tnr;
-    unsigned* c0;
-    unsigned* c1;
-    unsigned* c0m;
-    unsigned* c1m;
-    unsigned* idxV;
+    cmReal_t* sumWV;      // sumWV[r] sum(W,1) 
+    cmReal_t* sumHV;      // sumHV[r] sum(H,2)
+    cmReal_t* tnr;        // tnr[n,r] (V./(W*H))*H'
+    unsigned* idxV;       // idxV[m]  max row of each column of H[] at the last convergence test
+    unsigned* idx0V;      // idx0V[m] max row of each column of H[] at the previous convergence test
+    unsigned* mapV;       // mapV[2*r] row label maps used by the convergence test
+
+    unsigned  tileColCnt; // count of columns per tile
+    unsigned  thCnt;      // count of threads (including the calling thread)
+    struct cmNmfThreads_str* thr; // column partitions and thread pool
+
+    unsigned  iterCnt;    // count of iterations performed by the last call to cmNmfExec()
+    unsigned  changeCnt;  // count of columns whose assignment changed at the last convergence test
     
   } cmNmf_t;
 
@@ -813,9 +999,17 @@ extern "C" {
   cmRC_t   cmNmfInit( cmNmf_t* p,  unsigned n, unsigned m, unsigned r, unsigned maxIterCnt, unsigned convergeCnt );
   cmRC_t   cmNmfFinal(cmNmf_t* p );
 
-  // 
+  // Set the count of threads used by cmNmfExec(). 'thCnt' includes the calling thread.
+  // The default is one (no worker threads). The setting is retained by cmNmfInit().
+  cmRC_t   cmNmfSetThreadCount( cmNmf_t* p, unsigned thCnt );
+
+  // Shift 'cn' new columns into V[] (and random columns into H[]) and iterate.
   cmRC_t   cmNmfExec( cmNmf_t* p, const cmReal_t* v, unsigned cn );
 
+  // Compare against the original implementation and report the time per iteration
+  // across matrix sizes and thread counts.
+  void     cmNmfTest( cmCtx* ctx );
+
   //------------------------------------------------------------------------------------------------------------
   //)
 
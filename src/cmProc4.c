@@ -440,6 +440,7 @@ cmRC_t     cmScMatchFree(  cmScMatch** pp )
   cmMemFree(p->loc);
   cmMemFree(p->m);
   cmMemFree(p->p_mem);
+  cmMemFree(p->ibV);
   cmObjFree(pp);
   return rc;
 }
@@ -522,6 +523,12 @@ cmRC_t     cmScMatchInit(  cmScMatch* p, cmScH_t scH, unsigned maxScWndN, unsign
     p->p_opt[i].next = i<p->pn-1 ? p->p_opt + i + 1 : NULL;
   }
 
+  // the incremental matcher rows are stored in p->m[] as p->mrn rows of p->bn elements
+  p->bn    = cmMin(p->msn,p->locN);
+  p->ibV   = cmMemResizeZ(unsigned, p->ibV, p->mrn );
+  p->ibi   = 0;
+  p->iN    = 0;
+
   return rc;
 }
 
@@ -790,6 +797,7 @@ double _cmScMatchEvalCandidate( cmScMatch* r, double min_cost, double cost )
       r->p_opt[i].ri      = cp->ri;
       r->p_opt[i].ci      = cp->ci;
       r->p_opt[i].flags   = cp->flags;
+      r->p_opt[i].locIdx  = cp->locIdx;
       r->p_opt[i].scEvtIdx= cp->scEvtIdx;
       r->p_opt[i].next    = cp->next==NULL ? NULL : r->p_opt + i + 1;
     }
@@ -894,6 +902,169 @@ cmRC_t cmScMatchExec( cmScMatch* p, unsigned locIdx, unsigned locN, const cmScMa
   return rc;
 }
 
+//-----------------------------------------------------------------------------------------------------------------------
+// Incremental banded matcher.
+//
+// Row 'i' of the incremental DP matrix is stored in p->m[ (i % p->mrn) * p->bn ] 
+// and covers the score locations p->loc[ p->ibV[i % p->mrn] : + p->bn-1 ].
+// The costs are the same as _cmScMatchCalcMtx() except that each row is
+// normalized by the min. cost of the previous row. 
+enum { kSmIncrInfCost = 0x3fffffff };
+
+cmScMatchVal_t* _cmScMatchIncrRow( cmScMatch* p, unsigned i )
+{ return p->m + (i % p->mrn) * p->bn; }
+
+// Return the cost of row 'i' at p->loc[li] relative to 'base' or
+// kSmIncrInfCost if 'li' is outside of the band of row 'i'.
+unsigned _cmScMatchIncrCost( cmScMatch* p, unsigned i, unsigned li, unsigned base )
+{
+  unsigned bi = p->ibV[ i % p->mrn ];
+
+  if( li < bi || li >= bi + p->bn )
+    return kSmIncrInfCost;
+
+  return _cmScMatchIncrRow(p,i)[ li - bi ].v[kSmMinIdx] - base;
+}
+
+// Trace the least cost path back from the last row at p->loc[li] through, at most,
+// 'midiN' rows and store it in p->p_opt[].  The path records are taken 
+// from, and returned to, p->p_avl.
+double _cmScMatchIncrAlign( cmScMatch* p, unsigned midiN, unsigned li )
+{
+  unsigned i    = p->iN - 1;  // current DP row
+  unsigned ri   = midiN;      // current midiV[] index + 1
+  unsigned n    = 0;
+  double   cost = 0;
+
+  while( p->p_avl != NULL && n < p->pn-1 )
+  {
+    unsigned              bi = p->ibV[ i % p->mrn ];
+    const cmScMatchVal_t* vp;
+    unsigned              m;
+    
+    if( li < bi || li >= bi + p->bn )
+      break;
+
+    vp = _cmScMatchIncrRow(p,i) + (li - bi);
+
+    // select the first operation which produced the min cost (same order as _cmScMatchGenPaths())
+    for(m=kSmSubIdx; m<kSmCnt; ++m)
+      if( vp->v[m] == vp->v[kSmMinIdx] )
+        break;
+
+    assert( m < kSmCnt );
+
+    _cmScMatchPathPush(p,m,ri,li-bi,vp->flags,vp->scEvtIdx);
+    p->p_cur->locIdx = m==kSmDelIdx ? cmInvalidIdx : li;
+    cost            += m==kSmSubIdx && cmIsFlag(vp->flags,kSmMatchFl) ? 0 : 1;
+    ++n;
+
+    // 'substitute' and 'insert' consume a score location
+    if( m != kSmDelIdx )
+    {
+      if( li == 0 )
+        break;
+      --li;
+    }
+
+    // 'insert' stays on the current row
+    if( m == kSmInsIdx )
+      continue;
+    
+    // 'substitute' and 'delete' consume a MIDI note
+    if( ri == 1 || i == 0 )
+      break;
+
+    --ri;
+    --i;
+  }
+
+  // copy p_cur to p_opt
+  if( p->p_cur != NULL )
+    _cmScMatchEvalCandidate(p,DBL_MAX,cost);
+
+  // return the path records to the available list
+  while( p->p_cur != NULL )
+    _cmScMatchPathPop(p);
+
+  return cost;
+}
+
+cmRC_t cmScMatchIncrReset( cmScMatch* p, unsigned locIdx )
+{
+  if( p->bn == 0 )
+    return cmCtxRtCondition( &p->obj, cmInvalidArgRC, "The incremental score matcher has an empty score band.");
+
+  p->ibi      = cmMin(locIdx, p->locN - p->bn);
+  p->iN       = 0;
+  p->iMinCost = 0;
+  return cmOkRC;
+}
+
+cmRC_t cmScMatchIncrExec( cmScMatch* p, const cmScMatchMidi_t* midiV, unsigned midiN )
+{
+  if( p->bn == 0 )
+    return cmCtxRtCondition( &p->obj, cmInvalidArgRC, "The incremental score matcher has an empty score band.");
+
+  if( midiN == 0 || midiN > p->mmn )
+    return cmCtxRtCondition( &p->obj, cmInvalidArgRC, "The incremental score matcher MIDI sequence length must be between 1 and %i.",p->mmn);
+
+  unsigned        i       = p->iN;
+  unsigned        bi      = p->ibi;
+  unsigned        pitch   = midiV[midiN-1].pitch;
+  cmScMatchVal_t* rp      = _cmScMatchIncrRow(p,i);
+  unsigned        minCost = kSmIncrInfCost;
+  unsigned        li_opt  = bi;
+  unsigned        k;
+
+  // p->m[] no longer holds the cmScMatchExec() matrix
+  p->rn = 0;
+  p->cn = 0;
+  
+  p->ibV[ i % p->mrn ] = bi;
+
+  for(k=0; k<p->bn; ++k)
+  {
+    unsigned        li  = bi + k;
+    cmScMatchLoc_t* loc = p->loc + li;
+    cmScMatchVal_t* vp  = rp + k;
+    unsigned        idx = _cmScMatchIsMatchIndex(loc,pitch);
+    unsigned        c00 = 0;  // cost of the previous row at li-1
+    unsigned        c01 = 0;  // cost of the previous row at li
+
+    // the first row may begin at any score location
+    if( i > 0 )
+    {
+      c00 = li==0 ? kSmIncrInfCost : _cmScMatchIncrCost(p,i-1,li-1,p->iMinCost);
+      c01 = _cmScMatchIncrCost(p,i-1,li,p->iMinCost);
+    }
+
+    vp->flags        = idx==cmInvalidIdx ? 0            : kSmMatchFl;
+    vp->scEvtIdx     = idx==cmInvalidIdx ? cmInvalidIdx : loc->evtV[idx].scEvtIdx;
+    vp->v[kSmSubIdx] = c00 + (idx==cmInvalidIdx ? 1 : 0);
+    vp->v[kSmDelIdx] = c01 + 1;
+    vp->v[kSmInsIdx] = k==0 ? kSmIncrInfCost : rp[k-1].v[kSmMinIdx] + 1;
+    vp->v[kSmMinIdx] = cmMin( vp->v[kSmSubIdx], cmMin(vp->v[kSmDelIdx],vp->v[kSmInsIdx]));
+
+    // locate the first least cost location 
+    if( vp->v[kSmMinIdx] < minCost )
+    {
+      minCost = vp->v[kSmMinIdx];
+      li_opt  = li;
+    }
+  }
+
+  p->iMinCost = minCost;
+  p->iN      += 1;
+
+  // position the next band so that li_opt is in its first quarter
+  p->ibi = cmMin( li_opt > p->bn/4 ? li_opt - p->bn/4 : 0, p->locN - p->bn);
+  
+  p->opt_cost = _cmScMatchIncrAlign(p,midiN,li_opt);
+
+  return cmOkRC;
+}
+
 // Traverse the least cost path and:
 // 1) Return, esi, the score location index of the last MIDI note
 // which has a positive match with the score and assign
@@ -1229,6 +1400,7 @@ cmRC_t cmScMatcherInit(  cmScMatcher* p, double srate, cmScH_t scH, unsigned scW
   p->maxMissCnt = p->stepCnt+1;
   p->rn         = 2 * cmScoreEvtCount(scH);
   p->res        = cmMemResizeZ(cmScMatcherResult_t,p->res,p->rn);
+  p->incrFl     = false;
   p->printFl    = false;
 
   cmScMatcherReset(p,0);
@@ -1252,6 +1424,9 @@ cmRC_t cmScMatcherReset( cmScMatcher* p, unsigned scLocIdx )
   p->ri            = 0;
   p->eli           = cmInvalidIdx;
   p->ili           = 0;
+  p->latCnt        = 0;
+  p->latSumNs      = 0;
+  p->latMaxNs      = 0;
 
   // convert scLocIdx to an index into p->mp->loc[]
   unsigned i = 0;
@@ -1274,8 +1449,7 @@ cmRC_t cmScMatcherReset( cmScMatcher* p, unsigned scLocIdx )
   if( i==p->mp->locN)
     return cmCtxRtCondition( &p->obj, cmSubSysFailRC, "Score matcher reset failed."); 
 
-
-  return cmOkRC;
+  return cmScMatchIncrReset(p->mp,p->ili);
 }
 
 bool cmScMatcherInputMidi(  cmScMatcher* p, unsigned smpIdx, unsigned muid, unsigned status, cmMidiByte_t d0, cmMidiByte_t d1 )
@@ -1320,20 +1494,27 @@ void _cmScMatcherStoreResult( cmScMatcher* p, unsigned locIdx, unsigned scEvtIdx
 
   // it is possible that the same MIDI event is reported more than once
   // (due to step->scan back tracking) - try to find previous result records
-  // associated with this MIDI event
-  for(i=0; i<p->ri; ++i) 
-    if( p->res[i].mni == mp->mni )
+  // associated with this MIDI event. Events are only reported while they are
+  // in p->midiBuf[] therefore the records which precede a record whose
+  // event left p->midiBuf[] before 'mp' arrived do not need to be searched.
+  for(i=p->ri; i>0; --i) 
+  {
+    if( p->res[i-1].mni + p->mn <= mp->mni )
+      break;
+    
+    if( p->res[i-1].mni == mp->mni )
     {
       // if this is not the first time this note was reported and it is a true positive 
       if( tpFl )
       {
-        rp = p->res + i;
+        rp = p->res + i - 1;
         break;
       }
 
       // a match was found but this was not a true-pos so ignore it
       return;
     }
+  }
 
   if( rp == NULL )
   {
@@ -1508,37 +1689,118 @@ cmRC_t     cmScMatcherStep(  cmScMatcher* p )
   return cmOkRC;
 }
 
+// Match the latest note in p->midiBuf[] with cmScMatchIncrExec(), update the
+// locIdx of the notes in p->midiBuf[] from the least cost path and report the 
+// latest note along with any previous notes which became positive matches.
+cmRC_t     _cmScMatcherIncrStep( cmScMatcher* p )
+{
+  cmRC_t           rc;
+  unsigned         mN      = p->mn - p->mbi;
+  cmScMatchMidi_t* mV      = p->midiBuf + p->mbi;
+  unsigned         esi     = cmInvalidIdx;
+  unsigned         missCnt = 0;
+  cmScMatchPath_t* cp;
+
+  // if the end of the score has been reached
+  if( p->eli != cmInvalidIdx && p->eli + 1 >= p->mp->locN )
+    return cmEofRC;
+
+  if((rc = cmScMatchIncrExec(p->mp,mV,mN)) != cmOkRC )
+    return rc;
+
+  for(cp=p->mp->p_opt; cp!=NULL; cp=cp->next)
+  {
+    // there is no MIDI note associated with 'inserts'
+    if( cp->code == kSmInsIdx )
+      continue;
+
+    cmScMatchMidi_t* mp       = mV + cp->ri - 1;
+    bool             matchFl  = cp->code==kSmSubIdx && cmIsFlag(cp->flags,kSmMatchFl);
+    unsigned         locIdx   = cp->code==kSmSubIdx ? cp->locIdx   : cmInvalidIdx;
+    unsigned         scEvtIdx = cp->code==kSmSubIdx ? cp->scEvtIdx : cmInvalidIdx;
+    bool             reportFl = cp->ri == mN || (matchFl && mp->locIdx != locIdx);
+
+    mp->locIdx   = locIdx;
+    mp->scEvtIdx = scEvtIdx;
+
+    if( matchFl )
+    {
+      esi     = locIdx;
+      missCnt = 0;
+    }
+    else
+    {
+      ++missCnt;
+    }
+
+    if( reportFl )
+      _cmScMatcherStoreResult(p, locIdx, scEvtIdx, cp->flags, mp);
+  }
+
+  p->missCnt = missCnt;
+
+  if( esi != cmInvalidIdx )
+    p->eli = esi;
+
+  // if the follower appears to be lost then attempt a resync. scan
+  if( p->missCnt >= p->maxMissCnt && p->mbi == 0 && p->eli != cmInvalidIdx )
+  {
+    unsigned org_eli       = p->eli;
+    unsigned begScanLocIdx = p->eli > p->mn ? p->eli - p->mn : 0;
+    unsigned bli           = cmScMatcherScan(p,begScanLocIdx,p->mn*2);
+    ++p->scanCnt;
+
+    // a failed scan is not fatal - the banded matcher restarts from the last known location 
+    if( bli == cmInvalidIdx )
+      p->eli = org_eli;
+
+    // the scan used p->mp->m[] which also holds the incremental DP rows 
+    // therefore the banded matcher must be restarted on both branches
+    rc = cmScMatchIncrReset(p->mp, p->eli > p->mp->bn/4 ? p->eli - p->mp->bn/4 : 0 );
+  }
+
+  return rc;
+}
+
 cmRC_t     cmScMatcherExec(  cmScMatcher* p, unsigned smpIdx, unsigned muid, unsigned status, cmMidiByte_t d0, cmMidiByte_t d1, unsigned* scLocIdxPtr )
 {
-  bool     fl  = p->mbi > 0;
-  cmRC_t   rc  = cmOkRC;
-  unsigned org_eli = p->eli;
+  bool         fl      = p->mbi > 0;
+  cmRC_t       rc      = cmOkRC;
+  unsigned     org_eli = p->eli;
+  cmTimeSpec_t t0,t1;
 
   if( scLocIdxPtr != NULL )
     *scLocIdxPtr = cmInvalidIdx;
 
+  cmTimeGetMonotonic(&t0);
+
   // update the MIDI buffer with the incoming note
   if( cmScMatcherInputMidi(p,smpIdx,muid,status,d0,d1) == false )
     return rc;
 
-  // if the MIDI buffer transitioned to full then perform an initial scan sync.
-  if( fl && p->mbi == 0 )
+  if( p->incrFl )
+    rc = _cmScMatcherIncrStep(p);
+  else
   {
-    if( (p->begSyncLocIdx = cmScMatcherScan(p,p->ili,p->initHopCnt)) == cmInvalidIdx )
+    // if the MIDI buffer transitioned to full then perform an initial scan sync.
+    if( fl && p->mbi == 0 )
     {
-      rc = cmInvalidArgRC; // signal init. scan sync. fail
+      if( (p->begSyncLocIdx = cmScMatcherScan(p,p->ili,p->initHopCnt)) == cmInvalidIdx )
+      {
+        rc = cmInvalidArgRC; // signal init. scan sync. fail
+      }
+      else
+      {
+        //cmScMatcherPrintPath(p);
+      }
     }
     else
     {
-      //cmScMatcherPrintPath(p);
+      // if the MIDI buffer is full then perform a step sync.
+      if( !fl && p->mbi == 0 ) 
+        rc = cmScMatcherStep(p);
     }
   }
-  else
-  {
-    // if the MIDI buffer is full then perform a step sync.
-    if( !fl && p->mbi == 0 ) 
-      rc = cmScMatcherStep(p);
-  }
 
   // if we lost sync 
   if( p->eli == cmInvalidIdx )
@@ -1556,6 +1818,13 @@ cmRC_t     cmScMatcherExec(  cmScMatcher* p, unsigned smpIdx, unsigned muid, uns
     }
   }
 
+  // update the processing time statistics
+  cmTimeGetMonotonic(&t1);
+  unsigned ns = cmTimeElapsedNanos(&t0,&t1);
+  p->latCnt   += 1;
+  p->latSumNs += ns;
+  p->latMaxNs  = cmMax(p->latMaxNs,ns);
+
   return rc;
 }
 
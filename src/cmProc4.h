@@ -177,7 +177,13 @@ extern "C" {
     cmScMatchPath_t* p_avl;       // available path record linked list
     cmScMatchPath_t* p_cur;       // current path linked list
     cmScMatchPath_t* p_opt;       // p_opt[pn] - current best alignment as a linked list
-    double           opt_cost;    // last p_opt cost set by cmScMatchExec() 
+    double           opt_cost;    // last p_opt cost set by cmScMatchExec() or cmScMatchIncrExec()
+
+    unsigned         bn;          // incremental matcher band width (count of score locations evaluated per MIDI note)
+    unsigned*        ibV;         // ibV[mrn] - p->loc[] index of the first band element of each incremental DP row
+    unsigned         ibi;         // p->loc[] index of the band used by the next call to cmScMatchIncrExec()
+    unsigned         iN;          // count of incremental DP rows computed since the last call to cmScMatchIncrReset()
+    unsigned         iMinCost;    // min. cost of the last incremental DP row
   } cmScMatch;
 
   /*
@@ -206,6 +212,27 @@ extern "C" {
   // necessarily an error.
   cmRC_t     cmScMatchExec(  cmScMatch* p, unsigned locIdx, unsigned locN, const cmScMatchMidi_t* midiV, unsigned midiN, double min_cost );
 
+  // Incremental banded matcher.
+  // Rather than recomputing the DP matrix for the entire MIDI window
+  // cmScMatchIncrExec() adds a single row, for the newest note midiV[midiN-1],
+  // to a circular buffer of p->mrn DP rows held in p->m[].  Each row covers
+  // only a band of p->bn score locations. The band follows the least cost 
+  // location and is positioned so that this location is in its first quarter.
+  // The first row following cmScMatchIncrReset() may begin at any location in the band.
+  // The least cost path is then traced back through, at most, midiN rows and
+  // stored in p_opt[].  The path records locIdx field is set to the p->loc[] index
+  // of each 'substitute' and 'insert' element.  
+  // The cost of each call is therefore O(p->bn + midiN) regardless of the length of 
+  // the score or MIDI window.  
+  // Note that unlike cmScMatchExec() only a single least cost path is considered
+  // and transpositions are not detected.
+
+  // Set the p->loc[] index of the band for the next call to cmScMatchIncrExec() and clear the DP history.
+  cmRC_t     cmScMatchIncrReset( cmScMatch* p, unsigned locIdx );
+
+  // midiN must be <= p->mmn.
+  cmRC_t     cmScMatchIncrExec(  cmScMatch* p, const cmScMatchMidi_t* midiV, unsigned midiN );
+
   //------------------------------------------------------------------------------------------------------------
   //)
 
@@ -249,6 +276,12 @@ extern "C" {
     unsigned             stepCnt;        // count of forward/backward score loc's to examine for a match during cmScMatcherStep().
     unsigned             maxMissCnt;     // max. number of consecutive non-matches during step prior to executing a scan.
     unsigned             scanCnt;        // current count of times a resync-scan was executed during cmScMatcherStep()
+
+    bool                 incrFl;         // use the incremental matcher (cmScMatchIncrExec()) in place of cmScMatcherScan()/cmScMatcherStep(). (default:false)
+
+    unsigned             latCnt;         // count of MIDI note-on's processed by cmScMatcherExec() since the last reset
+    double               latSumNs;       // sum of cmScMatcherExec() processing time in nanoseconds
+    unsigned             latMaxNs;       // max. cmScMatcherExec() processing time in nanoseconds
  
     bool                 printFl;
   } cmScMatcher;
@@ -311,6 +344,12 @@ extern "C" {
   // cmEofRC - The end of the score was encountered.
   // cmInvalidArgRC - scan failed or the object was in an invalid state to attempt a match.
   // cmSubSysFailRC - a scan resync failed in cmScMatcherStep().
+  //
+  // If p->incrFl is set then each note is matched with cmScMatchIncrExec()
+  // beginning with the first note following the reset. A scan is only performed
+  // after p->maxMissCnt consecutive misses with a full MIDI buffer.
+  //
+  // The processing time of each note is accumulated in p->latCnt,p->latSumNs and p->latMaxNs.
   cmRC_t     cmScMatcherExec(  cmScMatcher* p, unsigned smpIdx, unsigned muid, unsigned status, cmMidiByte_t d0, cmMidiByte_t d1, unsigned* scLocIdxPtr );
 
   void cmScMatcherPrint( cmScMatcher* p );
@@ -0,0 +1,318 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+#include "cmPrefix.h"
+#include "cmGlobal.h"
+#include "cmRpt.h"
+#include "cmErr.h"
+#include "cmCtx.h"
+#include "cmMem.h"
+#include "cmMallocDebug.h"
+#include "cmFloatTypes.h"
+#include "cmMath.h"
+#include "cmTime.h"
+#include "cmVectOps.h"
+#include "cmResample.h"
+
+typedef struct
+{
+  unsigned tapN;   // taps per polyphase branch
+  double   stopDb; // Kaiser stop band attenuation
+} cmRsmpQual_t;
+
+static const cmRsmpQual_t _cmRsmpQualArray[] =
+{
+  {  16,  60 },  // kLowRsmpQ
+  {  32,  80 },  // kMedRsmpQ
+  {  64,  96 },  // kHighRsmpQ
+  { 128, 120 }   // kBestRsmpQ
+};
+
+static unsigned _cmRsmpGcd( unsigned a, unsigned b )
+{
+  while( b != 0 )
+  {
+    unsigned t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+// Return the taps per branch for a given ratio and quality.
+// When down-sampling the filter is stretched by dnFact/upFact to hold the
+// transition band constant relative to the output Nyquist rate.
+static unsigned _cmRsmpTapCount( unsigned upFact, unsigned dnFact, unsigned quality )
+{
+  unsigned tapN = _cmRsmpQualArray[ cmMin(quality,kBestRsmpQ) ].tapN;
+
+  if( dnFact > upFact )
+    tapN = (unsigned)ceil( (double)tapN * dnFact / upFact );
+
+  return tapN;
+}
+
+// Fill h[upFact*tapN] with the prototype low-pass filter designed at the up-sampled rate.
+static void _cmRsmpDesign( cmSample_t* h, unsigned upFact, unsigned dnFact, unsigned tapN, unsigned quality )
+{
+  unsigned hN     = upFact * tapN;
+  double   stopDb = _cmRsmpQualArray[ cmMin(quality,kBestRsmpQ) ].stopDb;
+  double   beta   = 0.1102 * (stopDb - 8.7);
+  double   nyq    = 0.5 / cmMax(upFact,dnFact);                     // lower Nyquist rate in cycles/sample at the up-sampled rate
+  double   tw     = (stopDb - 8.0) / (2.285 * (hN-1) * 2.0 * M_PI);  // Kaiser transition band width in cycles/sample
+  double   fc     = nyq - tw/4;                                     // -6dB point (allows aliasing only in the upper half of the transition band)
+  double   c      = (hN-1) / 2.0;
+  double   i0b    = cmBessel0(beta);
+  unsigned k;
+
+  for(k=0; k<hN; ++k)
+  {
+    double t = k - c;
+    double r = c > 0 ? t / c : 0;
+    double s = t==0 ? 1.0 : sin(2*M_PI*fc*t) / (2*M_PI*fc*t);
+    double w = cmBessel0( beta * sqrt( cmMax(0.0, 1.0 - r*r) ) ) / i0b;
+
+    h[k] = (cmSample_t)( upFact * 2 * fc * s * w );
+  }
+}
+
+cmRsmp_t* cmRsmpAlloc( unsigned upFact, unsigned dnFact, unsigned quality )
+{
+  cmRsmp_t*   p;
+  cmSample_t* h;
+  unsigned    g,i,j;
+
+  if( upFact == 0 || dnFact == 0 )
+    return NULL;
+
+  g       = _cmRsmpGcd(upFact,dnFact);
+  p       = cmMemAllocZ(cmRsmp_t,1);
+  p->upFact = upFact / g;
+  p->dnFact = dnFact / g;
+  p->tapN   = _cmRsmpTapCount(p->upFact,p->dnFact,quality);
+  p->coeffV = cmMemAllocZ(cmSample_t,p->upFact * p->tapN);
+  p->histV  = cmMemAllocZ(cmSample_t,2 * p->tapN);
+
+  h = cmMemAllocZ(cmSample_t,p->upFact * p->tapN);
+
+  _cmRsmpDesign(h,p->upFact,p->dnFact,p->tapN,quality);
+
+  // branch i is formed from h[i + j*upFact] and is stored time reversed
+  // so that it can be applied with a single dot product against the delay line
+  for(i=0; i<p->upFact; ++i)
+    for(j=0; j<p->tapN; ++j)
+      p->coeffV[ i*p->tapN + (p->tapN-1-j) ] = h[ i + j*p->upFact ];
+
+  cmMemFree(h);
+
+  cmRsmpReset(p);
+
+  return p;
+}
+
+cmRsmp_t* cmRsmpAllocSrate( double srcSrate, double dstSrate, unsigned quality )
+{
+  unsigned s = (unsigned)floor(srcSrate + 0.5);
+  unsigned d = (unsigned)floor(dstSrate + 0.5);
+
+  if( fabs(srcSrate - s) > 1e-6 || fabs(dstSrate - d) > 1e-6 )
+    return NULL;
+
+  return cmRsmpAlloc(d,s,quality);
+}
+
+void      cmRsmpFree( cmRsmp_t** pp )
+{
+  if( pp == NULL || *pp == NULL )
+    return;
+
+  cmMemFree((*pp)->coeffV);
+  cmMemFree((*pp)->histV);
+  cmMemPtrFree(pp);
+}
+
+void      cmRsmpReset( cmRsmp_t* p )
+{
+  cmVOS_Zero(p->histV,2*p->tapN);
+  p->hi  = 0;
+  p->phs = p->upFact;  // the first input sample must be read before the first output is produced
+}
+
+unsigned  cmRsmpMaxOutCount( const cmRsmp_t* p, unsigned inN )
+{
+  return (unsigned)(((unsigned long long)inN * p->upFact + p->dnFact - 1) / p->dnFact) + 1;
+}
+
+double    cmRsmpDelay( const cmRsmp_t* p )
+{
+  return (p->upFact * p->tapN - 1) / (2.0 * p->dnFact);
+}
+
+unsigned  cmRsmpExec( cmRsmp_t* p, const cmSample_t* xV, unsigned xN, unsigned xStride, unsigned* xCntRef, cmSample_t* yV, unsigned yN, unsigned yStride, cmSample_t gain )
+{
+  unsigned          xi = 0;
+  unsigned          yi = 0;
+  const unsigned    L  = p->upFact;
+  const unsigned    M  = p->dnFact;
+  const unsigned    tN = p->tapN;
+
+  for(;;)
+  {
+    // produce the output samples which fall between the last input sample and the next
+    for(; p->phs < L; p->phs += M )
+    {
+      if( yi >= yN )
+        goto doneLabel;
+
+      yV[ yi * yStride ] = gain * cmVOS_MultSumVV( p->coeffV + p->phs*tN, p->histV + p->hi, tN );
+      ++yi;
+    }
+
+    if( xi >= xN )
+      break;
+
+    // insert the next input sample into both halves of the delay line
+    // so that the tN most recent samples are always contiguous at histV[hi]
+    cmSample_t x = xV[ xi * xStride ];
+    p->histV[ p->hi      ] = x;
+    p->histV[ p->hi + tN ] = x;
+    p->hi = (p->hi + 1) % tN;
+    p->phs -= L;
+    ++xi;
+  }
+
+ doneLabel:
+  if( xCntRef != NULL )
+    *xCntRef = xi;
+
+  return yi;
+}
+
+//------------------------------------------------------------------------------------------------------------
+
+// Direct form: up-sample by zero insertion, filter at the up-sampled rate, down-sample.
+static unsigned _cmRsmpTestDirect( const cmSample_t* h, unsigned hN, unsigned L, unsigned M, const cmSample_t* x, unsigned xN, cmSample_t* y, unsigned yN )
+{
+  unsigned m,n,k;
+
+  for(n=0,m=0; n<yN && m<xN*L; ++n, m+=M)
+  {
+    double sum = 0;
+    for(k=m%L; k<hN && k<=m; k+=L)
+      sum += h[k] * x[ (m-k)/L ];
+
+    y[n] = sum;
+  }
+  return n;
+}
+
+// Return the magnitude response of h[] (in dB) at 'f' cycles/sample.
+static double _cmRsmpTestMagDb( const cmSample_t* h, unsigned hN, unsigned L, double f )
+{
+  double re = 0, im = 0;
+  unsigned k;
+  for(k=0; k<hN; ++k)
+  {
+    re += h[k] * cos(2*M_PI*f*k);
+    im -= h[k] * sin(2*M_PI*f*k);
+  }
+  return 20.0 * log10( sqrt(re*re + im*im) / L + 1e-30 );
+}
+
+void      cmRsmpTest( cmRpt_t* rpt )
+{
+  typedef struct { unsigned up; unsigned dn; } ratio_t;
+
+  ratio_t  ratioV[] = { {160,147}, {147,160}, {2,1}, {1,2}, {1,8}, {3,1}, {320,147} };
+  unsigned ratioN   = sizeof(ratioV)/sizeof(ratioV[0]);
+  unsigned xN       = 4000;
+  unsigned i,j,q;
+
+  cmSample_t* xV = cmMemAllocZ(cmSample_t,xN);
+  for(i=0; i<xN; ++i)
+    xV[i] = (cmSample_t)(2.0 * rand() / RAND_MAX - 1.0);
+
+  // verify the streaming polyphase output against the direct form
+  // while feeding the converter with random input and output block sizes
+  cmRptPrintf(rpt,"ratio    qual taps   max err  stop(dB)  pass(-0.1dB)\n");
+  for(i=0; i<ratioN; ++i)
+    for(q=kLowRsmpQ; q<=kBestRsmpQ; ++q)
+    {
+      unsigned    L  = ratioV[i].up;
+      unsigned    M  = ratioV[i].dn;
+      cmRsmp_t*   p  = cmRsmpAlloc(L,M,q);
+      unsigned    hN = p->upFact * p->tapN;
+      unsigned    yN = cmRsmpMaxOutCount(p,xN);
+      cmSample_t* h  = cmMemAllocZ(cmSample_t,hN);
+      cmSample_t* y0 = cmMemAllocZ(cmSample_t,yN);
+      cmSample_t* y1 = cmMemAllocZ(cmSample_t,yN);
+      unsigned    xi = 0, yi = 0, n0;
+      double      err = 0, stopDb = -1000, passF = 0;
+
+      _cmRsmpDesign(h,p->upFact,p->dnFact,p->tapN,q);
+
+      n0 = _cmRsmpTestDirect(h,hN,p->upFact,p->dnFact,xV,xN,y0,yN);
+
+      while( xi < xN )
+      {
+        unsigned xn = 1 + rand() % 100;
+        unsigned yn = 1 + rand() % 100;
+        unsigned xc;
+        xn  = cmMin(xN-xi,xn);
+        yn  = cmMin(yN-yi,yn);
+        yi += cmRsmpExec(p,xV+xi,xn,1,&xc,y1+yi,yn,1,1.0);
+        xi += xc;
+      }
+
+      for(j=0; j<cmMin(yi,n0); ++j)
+        err = cmMax(err,fabs(y0[j]-y1[j]));
+
+      // worst stop band response between the stop band edge and three times the lower Nyquist rate
+      double nyq = 0.5 / cmMax(p->upFact,p->dnFact);
+      double tw  = (_cmRsmpQualArray[q].stopDb - 8.0) / (2.285 * (hN-1) * 2.0 * M_PI);
+      double f;
+      for(f=nyq + tw/4; f<cmMin(0.5,3*nyq); f+=nyq/100)
+        stopDb = cmMax(stopDb,_cmRsmpTestMagDb(h,hN,p->upFact,f));
+
+      // highest frequency which is within 0.1 dB of unity gain
+      for(f=0; f<nyq; f+=nyq/200)
+        if( fabs(_cmRsmpTestMagDb(h,hN,p->upFact,f)) > 0.1 )
+          break;
+        else
+          passF = f;
+
+      cmRptPrintf(rpt,"%3i/%-3i   %i  %4i  %8.2e  %7.1f   %5.3f*nyq %s\n",L,M,q,p->tapN,err,stopDb,passF/nyq, yi==n0 ? "" : "count mismatch");
+
+      cmMemFree(h);
+      cmMemFree(y0);
+      cmMemFree(y1);
+      cmRsmpFree(&p);
+    }
+
+  // benchmark: one second of 44.1k->48k conversion using 64 sample input blocks
+  {
+    unsigned     srate = 44100;
+    unsigned     blkN  = 64;
+    cmSample_t*  yV    = cmMemAllocZ(cmSample_t,2*blkN);
+
+    for(q=kLowRsmpQ; q<=kBestRsmpQ; ++q)
+    {
+      cmRsmp_t*    p  = cmRsmpAllocSrate(srate,48000,q);
+      cmTimeSpec_t t0,t1;
+      unsigned     n;
+
+      cmTimeGetMonotonic(&t0);
+      for(n=0; n<srate; n+=blkN)
+        cmRsmpExec(p,xV + (n % (xN-blkN)),blkN,1,NULL,yV,2*blkN,1,1.0);
+      cmTimeGetMonotonic(&t1);
+
+      // filtering at the up-sampled rate and then decimating requires upFact*tapN*dnFact multiply-adds per output
+      cmRptPrintf(rpt,"44.1k->48k q:%i %6i us per channel second (%i MACs/output vs. %i at the up-sampled rate)\n",q,cmTimeElapsedMicros(&t0,&t1),p->tapN, p->upFact*p->tapN*p->dnFact);
+
+      cmRsmpFree(&p);
+    }
+
+    cmMemFree(yV);
+  }
+
+  cmMemFree(xV);
+}
@@ -0,0 +1,92 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+#ifndef cmResample_h
+#define cmResample_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  //( { file_desc:"Streaming polyphase rational sample rate converter." kw:[base audio] }
+  //
+  // Converts a signal by the rational factor upFact/dnFact using a Kaiser windowed
+  // sinc low-pass filter decomposed into upFact polyphase branches.  Only the
+  // output samples are computed - the cost is tapN multiply-adds per output sample
+  // regardless of the conversion ratio.  (44.1k->48k is upFact=160 dnFact=147).
+  //
+  // The filter cutoff is placed just below the Nyquist rate of the lower of the
+  // two sample rates. The quality preset selects the count of taps per polyphase
+  // branch and the stop band attenuation.
+  //
+  //   Preset     taps  stop band  pass band (0.1 dB)  delay (input samples)
+  //   kLowRsmpQ    16    -59 dB    0.69 * Nyquist        8
+  //   kMedRsmpQ    32    -79 dB    0.80 * Nyquist       16
+  //   kHighRsmpQ   64    -96 dB    0.88 * Nyquist       32
+  //   kBestRsmpQ  128   -118 dB    0.93 * Nyquist       64
+  //
+  // When down-sampling the tap count and delay are multiplied by dnFact/upFact
+  // to keep the transition band fixed relative to the output Nyquist rate.
+  // The figures above are measured by cmRsmpTest().
+  //
+  // cmRsmpExec() is a streaming push/pull function. It consumes input and produces
+  // output until either the input is exhausted or the output buffer is full and
+  // returns the count of samples it consumed and produced.  This allows it
+  // to be driven by the input (cmSRCExec()) or the output (cmApBufUpdate() on
+  // playback).
+  //
+  // cmRsmpExec() does not allocate memory and is therefore real-time safe.
+
+  enum
+  {
+    kLowRsmpQ,
+    kMedRsmpQ,
+    kHighRsmpQ,
+    kBestRsmpQ
+  };
+
+  typedef struct cmRsmp_str
+  {
+    unsigned    upFact;  // reduced up-sample factor (count of polyphase branches)
+    unsigned    dnFact;  // reduced down-sample factor
+    unsigned    tapN;    // count of filter taps per branch
+    cmSample_t* coeffV;  // coeffV[ upFact * tapN ] polyphase coefficients stored in time reversed order
+    cmSample_t* histV;   // histV[ 2 * tapN ] doubled input delay line
+    unsigned    hi;      // index of the oldest sample in the delay line
+    unsigned    phs;     // current branch (phs>=upFact indicates that an input sample is required)
+  } cmRsmp_t;
+
+  // Create a converter which changes the sample rate by upFact/dnFact. The ratio
+  // is reduced to lowest terms. Returns NULL if either factor is zero.
+  cmRsmp_t* cmRsmpAlloc( unsigned upFact, unsigned dnFact, unsigned quality );
+
+  // Create a converter from 'srcSrate' to 'dstSrate'. Both rates must be integers.
+  cmRsmp_t* cmRsmpAllocSrate( double srcSrate, double dstSrate, unsigned quality );
+
+  void      cmRsmpFree( cmRsmp_t** pp );
+
+  // Clear the delay line.
+  void      cmRsmpReset( cmRsmp_t* p );
+
+  // Return the maximum count of output samples which 'inN' input samples may produce.
+  unsigned  cmRsmpMaxOutCount( const cmRsmp_t* p, unsigned inN );
+
+  // Return the filter group delay in output samples.
+  double    cmRsmpDelay( const cmRsmp_t* p );
+
+  // Convert xV[xN] into yV[yN].  'xStride' and 'yStride' allow interleaved buffers to be
+  // read and written directly. Every output sample is multiplied by 'gain'.
+  // Processing stops when either the input is exhausted or the output buffer is full.
+  // Returns the count of samples written to yV[] and sets *xCntRef (if it is non-NULL)
+  // to the count of samples consumed from xV[].
+  unsigned  cmRsmpExec( cmRsmp_t* p, const cmSample_t* xV, unsigned xN, unsigned xStride, unsigned* xCntRef, cmSample_t* yV, unsigned yN, unsigned yStride, cmSample_t gain );
+
+  // Verify the converter against a direct implementation and time it.
+  void      cmRsmpTest( cmRpt_t* rpt );
+
+  //)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
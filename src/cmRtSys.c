@@ -261,18 +261,10 @@ cmRtRC_t _cmRtSendStateStatusToHost(  _cmRtCfg_t* cp )
 // messages to the real-time DSP processes via cp->ss.cbFunc()
 cmRtRC_t _cmRtDeliverMsgsWithLock( _cmRtCfg_t* cp  )
 {
-  int      i;
-  cmRtRC_t rc = kOkThRC;
-    
-  // as long msg's are in the queue incoming msg queue
-  for(i=0; rc == kOkThRC; ++i)
-  {
-    // if a msg is waiting transmit it via cp->ss.cbFunc()
-    if((rc = cmTsMp1cDequeueMsg(cp->htdQueueH,NULL,0)) == kOkThRC)
-      ++cp->status.msgCbCnt;
-  }
+  // transmit all waiting msgs via cp->ss.cbFunc()
+  cp->status.msgCbCnt += cmTsMp1cDequeueAllMsgs(cp->htdQueueH,cmInvalidCnt);
 
-  return rc;
+  return kOkRtRC;
 }
 
 // This funciton is _cmRtDspExecCallback()->cmRtNetReceive() in the 
@@ -9,6 +9,7 @@
 #include "cmMallocDebug.h"
 #include "cmSymTbl.h"
 #include "cmLinkedHeap.h"
+#include "cmTime.h"
 
 cmSymTblH_t cmSymTblNullHandle = cmSTATIC_NULL_HANDLE;
 
@@ -17,9 +18,16 @@ enum
   kDynStFl = 0x01
 };
 
+enum
+{
+  kInitHashSlotCnt = 64,                // initial count of slots in cmSymTbl_t.hashV[] (must be a power of 2)
+  kDelHashSlotId   = cmInvalidId - 1    // marks a hashV[] slot whose symbol was removed
+};
+
 typedef struct cmSymLabel_str
 {
   unsigned        flags;
+  unsigned        hash;   // label hash (see _cmSymTblHash())
   const cmChar_t* label;
 } cmSymLabel_t;
 
@@ -59,6 +67,13 @@ typedef struct
   unsigned      baseSymId; 
   unsigned      symPerBlock;
   cmSym_t*      availPtr;
+
+  cmSymBlock_t** blkV;          // blkV[blkAllocCnt] block index - blkV[i] is the i'th block on the chain
+  unsigned       blkAllocCnt;   // count of slots allocated in blkV[]
+
+  unsigned*      hashV;         // hashV[hashN] open addressed (linear probe) label hash index of symbol id's
+  unsigned       hashN;         // count of slots in hashV[] (always a power of 2)
+  unsigned       hashUseCnt;    // count of used and deleted slots in hashV[]
 } cmSymTbl_t;
 
 cmSymTbl_t* _cmSymTblHandleToPtr( cmSymTblH_t h )
@@ -87,6 +102,15 @@ cmSymBlock_t*  _cmSymTblAllocateBlock( cmSymTbl_t* stp )
   // the new block control recd always becomes the last recd in the chain
   stp->last = sbp;
 
+  // add the new block to the block index
+  if( stp->blkCnt == stp->blkAllocCnt )
+  {
+    stp->blkAllocCnt = stp->blkAllocCnt==0 ? 16 : 2*stp->blkAllocCnt;
+    stp->blkV        = cmMemResizeP( cmSymBlock_t*, stp->blkV, stp->blkAllocCnt );
+  }
+
+  stp->blkV[ stp->blkCnt ] = sbp;
+
   ++stp->blkCnt;
 
   return sbp;
@@ -101,27 +125,33 @@ bool _cmSymTblIsSymbolRemoved( cmSymTbl_t* stp, unsigned symId )
   return false;
 }
 
-unsigned _cmSymTblLabelToId( cmSymTbl_t* stp, const char* label )
+// FNV-1a hash of a symbol label.
+unsigned _cmSymTblHash( const char* label )
 {
-  cmSymBlock_t* sbp = stp->first;
+  const unsigned char* cp = (const unsigned char*)label;
+  unsigned             h  = 2166136261u;
 
-  unsigned symId = stp->baseSymId;
+  for(; *cp; ++cp)
+    h = (h ^ *cp) * 16777619u;
 
-  while( sbp != NULL )
-  {
-    cmSym_t* sp = sbp->base;
-    cmSym_t* ep = sbp->base + sbp->cnt;
+  return h;
+}
 
-    for(; sp<ep; ++sp,++symId)
-    {
-      if( _cmSymTblIsSymbolRemoved(stp, symId ) == false )
-        if( strcmp( sp->u.label.label, label ) == 0 )
-          return symId;
-    }
-    sbp = sbp->link;
-  }
+// Return a pointer to a symbol record in this table (the parent table is not searched).
+cmSym_t* _cmSymTblLocalIdToSymPtr( cmSymTbl_t* stp, unsigned symId )
+{
+  if( symId < stp->baseSymId )
+    return NULL;
 
-  return cmInvalidId; 
+  symId -= stp->baseSymId;
+
+  unsigned n = symId / stp->symPerBlock;
+  unsigned i = symId % stp->symPerBlock;
+
+  if( n >= stp->blkCnt || i >= stp->blkV[n]->cnt )
+    return NULL;
+
+  return stp->blkV[n]->base + i;
 }
 
 cmSym_t* _cmSymTblIdToSymPtr( cmSymTbl_t* stp, unsigned symId )
@@ -129,24 +159,98 @@ cmSym_t* _cmSymTblIdToSymPtr( cmSymTbl_t* stp, unsigned symId )
   if( cmSymTblIsValid(stp->parentH) && cmSymTblIsValidId( stp->parentH, symId ) )
     return _cmSymTblIdToSymPtr( _cmSymTblHandleToPtr(stp->parentH), symId );
 
-  symId -= stp->baseSymId;
+  return _cmSymTblLocalIdToSymPtr(stp,symId);
+}
 
-  unsigned    n   = symId / stp->symPerBlock;
-  unsigned    i   = symId % stp->symPerBlock;
+// Insert a symbol id into the hash index without checking the load factor.
+void _cmSymTblHashSet( unsigned* hashV, unsigned hashN, unsigned hash, unsigned symId )
+{
+  unsigned i = hash & (hashN-1);
 
-  if( n >= stp->blkCnt )
-    return NULL;
+  while( hashV[i] != cmInvalidId && hashV[i] != kDelHashSlotId )
+    i = (i+1) & (hashN-1);
 
-  cmSymBlock_t* sbp = stp->first;
+  hashV[i] = symId;
+}
 
-  unsigned j;
-  for(j=0; j<n; ++j)
-    sbp = sbp->link;
+// Rebuild the hash index with 'hashN' slots. Deleted slots are not carried over.
+void _cmSymTblHashResize( cmSymTbl_t* stp, unsigned hashN )
+{
+  unsigned* hashV = cmMemAlloc( unsigned, hashN );
+  unsigned  i;
 
-  if( i >= sbp->cnt )
-    return NULL;
+  memset(hashV,0xff,hashN*sizeof(unsigned)); // fill with cmInvalidId
 
-  return sbp->base + i;
+  stp->hashUseCnt = 0;
+
+  for(i=0; i<stp->hashN; ++i)
+    if( stp->hashV[i] != cmInvalidId && stp->hashV[i] != kDelHashSlotId )
+    {
+      const cmSym_t* sp = _cmSymTblLocalIdToSymPtr(stp,stp->hashV[i]);
+      _cmSymTblHashSet(hashV,hashN,sp->u.label.hash,stp->hashV[i]);
+      ++stp->hashUseCnt;
+    }
+
+  cmMemFree(stp->hashV);
+  stp->hashV = hashV;
+  stp->hashN = hashN;
+}
+
+void _cmSymTblHashInsert( cmSymTbl_t* stp, unsigned hash, unsigned symId )
+{
+  // keep the load factor (including deleted slots) below 3/4
+  if( 4*(stp->hashUseCnt+1) > 3*stp->hashN )
+    _cmSymTblHashResize(stp, 2*stp->symCnt+1 > stp->hashN/2 ? 2*stp->hashN : stp->hashN );
+
+  _cmSymTblHashSet(stp->hashV,stp->hashN,hash,symId);
+  ++stp->hashUseCnt;
+}
+
+// Mark the hash index slot which refers to 'symId' as deleted.
+void _cmSymTblHashRemove( cmSymTbl_t* stp, unsigned hash, unsigned symId )
+{
+  unsigned i = hash & (stp->hashN-1);
+
+  for(; stp->hashV[i] != cmInvalidId; i=(i+1) & (stp->hashN-1))
+    if( stp->hashV[i] == symId )
+    {
+      stp->hashV[i] = kDelHashSlotId;
+      return;
+    }
+}
+
+// Search the local table for 'label'.
+unsigned _cmSymTblLocalLabelToId( cmSymTbl_t* stp, const char* label, unsigned hash )
+{
+  unsigned i = hash & (stp->hashN-1);
+
+  for(; stp->hashV[i] != cmInvalidId; i=(i+1) & (stp->hashN-1))
+    if( stp->hashV[i] != kDelHashSlotId )
+    {
+      const cmSym_t* sp = _cmSymTblLocalIdToSymPtr(stp,stp->hashV[i]);
+      if( sp->u.label.hash == hash && strcmp( sp->u.label.label, label ) == 0 )
+        return stp->hashV[i];
+    }
+
+  return cmInvalidId; 
+}
+
+// Search the local table and then the parent table chain for 'label'.
+unsigned _cmSymTblLabelToId( cmSymTbl_t* stp, const char* label, unsigned hash )
+{
+  for(;;)
+  {
+    unsigned symId;
+    if((symId = _cmSymTblLocalLabelToId(stp,label,hash)) != cmInvalidId )
+      return symId;
+
+    if( cmSymTblIsValid(stp->parentH) == false )
+      break;
+
+    stp = _cmSymTblHandleToPtr(stp->parentH);
+  }
+
+  return cmInvalidId;
 }
 
 cmSymTblH_t cmSymTblCreate(           cmSymTblH_t parentH, unsigned baseSymId, cmCtx_t* ctx )
@@ -155,9 +259,13 @@ cmSymTblH_t cmSymTblCreate(           cmSymTblH_t parentH, unsigned baseSymId, c
   cmSymTbl_t* stp = cmMemAllocZ( cmSymTbl_t, 1 );
 
   stp->heapH       = cmLHeapCreate( 2048, ctx );
-  stp->symPerBlock = 3;
+  stp->symPerBlock = 64;
   stp->baseSymId   = baseSymId;
   stp->parentH     = parentH;
+  stp->hashN       = kInitHashSlotCnt;
+  stp->hashV       = cmMemAlloc( unsigned, stp->hashN );
+
+  memset(stp->hashV,0xff,stp->hashN*sizeof(unsigned)); // fill with cmInvalidId
 
   _cmSymTblAllocateBlock( stp );
 
@@ -185,6 +293,8 @@ void        cmSymTblDestroy( cmSymTblH_t* hp )
 
   cmLHeapDestroy(&stp->heapH); 
 
+  cmMemFree(stp->blkV);
+  cmMemFree(stp->hashV);
   cmMemFree(hp->h);
 
   hp->h = NULL;
@@ -197,16 +307,12 @@ unsigned    cmSymTblRegister( cmSymTblH_t h, const char* label, bool staticFl )
   unsigned    symId;
   unsigned    flags = 0;
   cmSym_t*    sp    = NULL;
+  unsigned    hash  = _cmSymTblHash(label);
 
-  // check for the label in the local symbol table
-  if((symId = _cmSymTblLabelToId( stp, label )) != cmInvalidId )
+  // check for the label in the local symbol table and its parents
+  if((symId = _cmSymTblLabelToId( stp, label, hash )) != cmInvalidId )
     return symId;
 
-  // check for the label in the parent symbol table
-  if( cmSymTblIsValid(stp->parentH) )
-    if((symId = _cmSymTblLabelToId( _cmSymTblHandleToPtr(stp->parentH), label)) != cmInvalidId )
-      return symId;
-
   // if the label is not static then create a copy of it on the local heap
   if( !staticFl )
   {
@@ -247,12 +353,15 @@ unsigned    cmSymTblRegister( cmSymTblH_t h, const char* label, bool staticFl )
   // setup the symbol record
   sp->u.label.label = label;
   sp->u.label.flags = flags;
+  sp->u.label.hash  = hash;
 
   // verify that the new symId does not already belong to the parent
   assert( cmSymTblIsValid(stp->parentH)==false ? 1 : cmSymTblLabel( stp->parentH, symId)==NULL );
 
   ++stp->symCnt;
 
+  _cmSymTblHashInsert(stp,hash,symId);
+
   return symId;
   
 }
@@ -291,6 +400,8 @@ bool        cmSymTblRemove( cmSymTblH_t h, unsigned symId )
   if((sp = _cmSymTblIdToSymPtr(stp,symId)) == NULL )
     return false;
 
+  _cmSymTblHashRemove(stp,sp->u.label.hash,symId);
+
   if( cmIsFlag(sp->u.label.flags,kDynStFl))
     cmLHeapFree(stp->heapH,(void*)sp->u.label.label);
 
@@ -319,11 +430,7 @@ const char* cmSymTblLabel( cmSymTblH_t h, unsigned    symId )
 unsigned    cmSymTblId(                   cmSymTblH_t h, const char* label )
 {
   cmSymTbl_t* stp = _cmSymTblHandleToPtr(h);
-  unsigned     id;
-  if((id=_cmSymTblLabelToId(stp,label)) == cmInvalidId )
-    if( cmSymTblIsValid(stp->parentH))
-      return _cmSymTblLabelToId( _cmSymTblHandleToPtr(stp->parentH), label );
-  return id;
+  return _cmSymTblLabelToId(stp,label,_cmSymTblHash(label));
 }
 
 bool        cmSymTblIsValid(               cmSymTblH_t h )
@@ -341,7 +448,7 @@ void        cmSymTblReport(               cmSymTblH_t h )
   cmSymBlock_t* sbp = stp->first;
   unsigned i=0, j=0, symId = stp->baseSymId;
 
-  printf("blks:%i syms:%i\n", stp->blkCnt, stp->symCnt );
+  printf("blks:%i syms:%i hash slots:%i used:%i\n", stp->blkCnt, stp->symCnt, stp->hashN, stp->hashUseCnt );
 
   for(; sbp != NULL; sbp=sbp->link,++i)
     for(j=0; j<sbp->cnt; ++j,++symId)
@@ -352,6 +459,56 @@ void        cmSymTblReport(               cmSymTblH_t h )
 
 }
 
+// Time registering and looking up a large number of symbols in a table with a parent.
+void _cmSymTblLoadBenchmark( cmCtx_t* ctx )
+{
+  unsigned     parentN = 10000;
+  unsigned     childN  = 100000;
+  unsigned     errCnt  = 0;
+  unsigned     i;
+  cmChar_t     str[32];
+  cmTimeSpec_t t0,t1,t2;
+
+  cmSymTblH_t  pH      = cmSymTblCreate( cmSymTblNullHandle, 1, ctx );
+  cmSymTblH_t  cH      = cmSymTblCreate( pH, 1000000, ctx );
+
+  for(i=0; i<parentN; ++i)
+  {
+    snprintf(str,sizeof(str),"psym%i",i);
+    cmSymTblRegisterSymbol(pH,str);
+  }
+
+  cmTimeGet(&t0);
+
+  // register new symbols in the child table and re-register the parent symbols
+  for(i=0; i<childN; ++i)
+  {
+    snprintf(str,sizeof(str),"csym%i",i);
+    cmSymTblRegisterSymbol(cH,str);
+
+    snprintf(str,sizeof(str),"psym%i",i % parentN);
+    if( cmSymTblRegisterSymbol(cH,str) != 1 + (i % parentN) )
+      ++errCnt;
+  }
+
+  cmTimeGet(&t1);
+
+  for(i=0; i<childN; ++i)
+  {
+    snprintf(str,sizeof(str),"csym%i",i);
+    if( cmSymTblId(cH,str) != 1000000 + i )
+      ++errCnt;
+  }
+
+  cmTimeGet(&t2);
+
+  cmRptPrintf(&ctx->rpt,"register:%i syms %i us  lookup:%i syms %i us  errors:%i\n",
+    2*childN, cmTimeElapsedMicros(&t0,&t1), childN, cmTimeElapsedMicros(&t1,&t2), errCnt);
+
+  cmSymTblDestroy(&cH);
+  cmSymTblDestroy(&pH);
+}
+
 //( { label:cmSymTblEx }
 //
 //  cmSymTblTest() gives a usage example for the symbol table component.
@@ -402,6 +559,8 @@ void cmSymTblTest( cmCtx_t* ctx )
   // release the symbol table
   cmSymTblDestroy(&h);
 
+  _cmSymTblLoadBenchmark(ctx);
+
   return;
 }
 //)
@@ -9,6 +9,7 @@
 #include "cmMallocDebug.h"
 
 #include "cmThread.h"
+#include "cmTime.h"
 
 #include <pthread.h>
 #include <unistd.h>  // usleep
@@ -473,6 +474,304 @@ cmThRC_t cmThreadMutexSignalCondVar( cmThreadMutexH_t h )
 }
 
 
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+//-----------------------------------------------------------------------------
+
+struct cmThPool_str;
+
+typedef struct
+{
+  struct cmThPool_str* p;
+  cmThreadH_t          thH;
+  unsigned             runIdx;   // value of cmThPool_t.runIdx when this worker last started work
+} cmThPoolWorker_t;
+
+typedef struct cmThPool_str
+{
+  cmErr_t             err;
+  pthread_mutex_t     mutex;     // protects all of the fields below
+  pthread_cond_t      startCvar; // broadcast when a run is started or the pool is destroyed
+  pthread_cond_t      doneCvar;  // signaled when the last task of a run completes
+  cmThPoolWorker_t*   wV;        // wV[wN] worker threads
+  unsigned            wN;        // 
+  cmThreadPoolFunc_t  func;      // task function of the current run
+  void*               arg;       //
+  unsigned            taskCnt;   // count of tasks in the current run
+  unsigned            nextIdx;   // index of the next task to be claimed
+  unsigned            doneCnt;   // count of completed tasks
+  unsigned            runIdx;    // incremented to start a run
+  bool                quitFl;    // set to make the worker threads exit
+  bool                mutexFl;   // mutex and cond. vars. were initialized
+} cmThPool_t;
+
+cmThreadPoolH_t cmThreadPoolNullHandle = cmSTATIC_NULL_HANDLE;
+
+cmThPool_t* _cmThPoolHandleToPtr( cmThreadPoolH_t h )
+{
+  cmThPool_t* p = (cmThPool_t*)h.h;
+  assert( p != NULL );
+  return p;
+}
+
+// Execute unclaimed tasks until all have been claimed. Called with the mutex locked.
+void _cmThPoolExec( cmThPool_t* p )
+{
+  unsigned i;
+  while( (i = p->nextIdx) < p->taskCnt )
+  {
+    ++p->nextIdx;
+
+    pthread_mutex_unlock(&p->mutex);
+    p->func(p->arg,i);
+    pthread_mutex_lock(&p->mutex);
+
+    if( ++p->doneCnt == p->taskCnt )
+      pthread_cond_signal(&p->doneCvar);
+  }
+}
+
+bool _cmThPoolThreadFunc( void* arg )
+{
+  cmThPoolWorker_t* w = (cmThPoolWorker_t*)arg;
+  cmThPool_t*       p = w->p;
+  bool              fl;
+
+  pthread_mutex_lock(&p->mutex);
+
+  while( w->runIdx == p->runIdx && p->quitFl == false )
+    pthread_cond_wait(&p->startCvar,&p->mutex);
+
+  if((fl = !p->quitFl) == true )
+  {
+    w->runIdx = p->runIdx;
+    _cmThPoolExec(p);
+  }
+
+  pthread_mutex_unlock(&p->mutex);
+
+  return fl;
+}
+
+cmThRC_t cmThreadPoolDestroy( cmThreadPoolH_t* hp )
+{
+  cmThRC_t rc = kOkThRC;
+  unsigned i;
+
+  if( hp == NULL || cmThreadPoolIsValid(*hp) == false )
+    return kOkThRC;
+
+  cmThPool_t* p = _cmThPoolHandleToPtr(*hp);
+
+  if( p->mutexFl )
+  {
+    pthread_mutex_lock(&p->mutex);
+    p->quitFl = true;
+    pthread_cond_broadcast(&p->startCvar);
+    pthread_mutex_unlock(&p->mutex);
+  }
+
+  for(i=0; i<p->wN; ++i)
+    if( cmThreadIsValid(p->wV[i].thH) )
+      if( cmThreadDestroy(&p->wV[i].thH) != kOkThRC )
+        rc = _cmThError(&p->err,kDestroyFailThRC,0,"Thread pool worker %i destroy failed.",i);
+
+  if( rc != kOkThRC )
+    return rc;
+
+  if( p->mutexFl )
+  {
+    pthread_cond_destroy(&p->startCvar);
+    pthread_cond_destroy(&p->doneCvar);
+    pthread_mutex_destroy(&p->mutex);
+  }
+
+  cmMemFree(p->wV);
+  cmMemFree(p);
+  hp->h = NULL;
+
+  return rc;
+}
+
+cmThRC_t cmThreadPoolCreate( cmThreadPoolH_t* hp, unsigned threadCnt, cmRpt_t* rpt )
+{
+  cmThRC_t rc;
+  int      sysErr;
+  unsigned i;
+
+  if((rc = cmThreadPoolDestroy(hp)) != kOkThRC )
+    return rc;
+
+  cmThPool_t* p = cmMemAllocZ(cmThPool_t,1);
+  cmErrSetup(&p->err,rpt,"Thread Pool");
+
+  p->wV = cmMemAllocZ(cmThPoolWorker_t,threadCnt);
+  hp->h = p;
+
+  if((sysErr = pthread_mutex_init(&p->mutex,NULL)) != 0 )
+  {
+    rc = _cmThError(&p->err,kCreateFailThRC,sysErr,"Thread pool mutex create failed.");
+    goto errLabel;
+  }
+
+  pthread_cond_init(&p->startCvar,NULL);
+  pthread_cond_init(&p->doneCvar,NULL);
+  p->mutexFl = true;
+
+  for(i=0; i<threadCnt; ++i,++p->wN)
+  {
+    cmThPoolWorker_t* w = p->wV + i;
+    w->p   = p;
+    w->thH = cmThreadNullHandle;
+
+    if( cmThreadCreate(&w->thH,_cmThPoolThreadFunc,w,rpt) != kOkThRC )
+    {
+      rc = _cmThError(&p->err,kCreateFailThRC,0,"Thread pool worker %i create failed.",i);
+      goto errLabel;
+    }
+
+    cmThreadSetPauseTimeOutMicros(w->thH,1000);
+
+    if( cmThreadPause(w->thH,0) != kOkThRC )
+    {
+      rc = _cmThError(&p->err,kCreateFailThRC,0,"Thread pool worker %i start failed.",i);
+      goto errLabel;
+    }
+  }
+
+ errLabel:
+  if( rc != kOkThRC )
+    cmThreadPoolDestroy(hp);
+
+  return rc;
+}
+
+bool     cmThreadPoolIsValid( cmThreadPoolH_t h )
+{ return h.h != NULL; }
+
+unsigned cmThreadPoolThreadCount( cmThreadPoolH_t h )
+{
+  cmThPool_t* p = _cmThPoolHandleToPtr(h);
+  return p->wN;
+}
+
+cmThRC_t cmThreadPoolStart( cmThreadPoolH_t h, cmThreadPoolFunc_t func, void* arg, unsigned taskCnt )
+{
+  cmThPool_t* p  = _cmThPoolHandleToPtr(h);
+  cmThRC_t    rc = kOkThRC;
+
+  pthread_mutex_lock(&p->mutex);
+
+  if( p->doneCnt != p->taskCnt )
+    rc = _cmThError(&p->err,kInvalidStateThRC,0,"A thread pool run was started before the previous run was completed.");
+  else
+  {
+    p->func    = func;
+    p->arg     = arg;
+    p->taskCnt = taskCnt;
+    p->nextIdx = 0;
+    p->doneCnt = 0;
+    ++p->runIdx;
+
+    if( taskCnt > 0 )
+      pthread_cond_broadcast(&p->startCvar);
+  }
+
+  pthread_mutex_unlock(&p->mutex);
+  return rc;
+}
+
+cmThRC_t cmThreadPoolWait( cmThreadPoolH_t h )
+{
+  cmThPool_t* p = _cmThPoolHandleToPtr(h);
+
+  pthread_mutex_lock(&p->mutex);
+
+  // help with the tasks which have not been claimed
+  _cmThPoolExec(p);
+
+  // wait for the tasks claimed by the workers
+  while( p->doneCnt != p->taskCnt )
+    pthread_cond_wait(&p->doneCvar,&p->mutex);
+
+  pthread_mutex_unlock(&p->mutex);
+  return kOkThRC;
+}
+
+cmThRC_t cmThreadPoolRun( cmThreadPoolH_t h, cmThreadPoolFunc_t func, void* arg, unsigned taskCnt )
+{
+  cmThRC_t rc;
+  if((rc = cmThreadPoolStart(h,func,arg,taskCnt)) != kOkThRC )
+    return rc;
+
+  return cmThreadPoolWait(h);
+}
+
+enum { kThPoolTestTaskCnt = 257, kThPoolTestRunCnt = 200 };
+
+typedef struct
+{
+  unsigned cntV[ kThPoolTestTaskCnt ];  // count of times each task was run
+} _cmThPoolTest_t;
+
+void _cmThPoolTestFunc( void* arg, unsigned taskIdx )
+{
+  _cmThPoolTest_t* t = (_cmThPoolTest_t*)arg;
+  t->cntV[taskIdx] += 1;
+}
+
+void cmThreadPoolTest( cmRpt_t* rpt )
+{
+  cmThreadPoolH_t h      = cmThreadPoolNullHandle;
+  unsigned        errCnt = 0;
+  unsigned        i,j,k;
+  _cmThPoolTest_t t;
+
+  for(k=0; k<4; ++k)
+  {
+    if( cmThreadPoolCreate(&h,k,rpt) != kOkThRC )
+    {
+      ++errCnt;
+      break;
+    }
+
+    for(i=0; i<kThPoolTestRunCnt; ++i)
+    {
+      unsigned taskCnt = i % kThPoolTestTaskCnt;
+
+      memset(&t,0,sizeof(t));
+
+      // alternate between Run() and Start()/Wait()
+      if( i % 2 )
+      {
+        if( cmThreadPoolRun(h,_cmThPoolTestFunc,&t,taskCnt) != kOkThRC )
+          ++errCnt;
+      }
+      else
+      {
+        if( cmThreadPoolStart(h,_cmThPoolTestFunc,&t,taskCnt) != kOkThRC )
+          ++errCnt;
+
+        if( cmThreadPoolWait(h) != kOkThRC )
+          ++errCnt;
+      }
+
+      for(j=0; j<kThPoolTestTaskCnt; ++j)
+        if( t.cntV[j] != (j<taskCnt ? 1 : 0) )
+          ++errCnt;
+    }
+
+    cmRptPrintf(rpt,"workers:%i runs:%i errors:%i\n",cmThreadPoolThreadCount(h),kThPoolTestRunCnt,errCnt);
+
+    if( cmThreadPoolDestroy(&h) != kOkThRC )
+      ++errCnt;
+  }
+
+  if( errCnt > 0 )
+    cmRptPrintf(rpt,"FAIL\n");
+}
+
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -833,17 +1132,40 @@ bool cmTsQueueIsValid( cmTsQueueH_t h )
 //--------------------------------------------------------------------------------------------------
 //--------------------------------------------------------------------------------------------------
 
+enum
+{
+  kTsHdrByteCnt       = 8,   // size of the msg record header [ msgByteCnt rsrvd ] - msg records are aligned to this size 
+  kTsCacheLineByteCnt = 64   // used to keep the producer and consumer state on separate cache lines
+};
+
+// size of a msg record containing 'mn' msg bytes 
+#define _cmTsRecdByteCnt(mn) ((kTsHdrByteCnt + (mn) + kTsHdrByteCnt-1) & ~(kTsHdrByteCnt-1))
+
+#define _cmThLoadAcquire(addr)   __atomic_load_n((addr),__ATOMIC_ACQUIRE)
+#define _cmThStoreRelease(addr,v) __atomic_store_n((addr),(v),__ATOMIC_RELEASE)
+
 typedef struct
 {
-  volatile unsigned ii;
+  // consumer cache line
+  volatile unsigned oi;        // output index - only written by the consumer
+  unsigned          iiCache;   // consumer copy of 'ii' - refreshed only when the queue appears empty
+  char              pad0[ kTsCacheLineByteCnt ];
+
+  // producer cache line
+  volatile unsigned ii;        // input index - only written by the producer
+  unsigned          oiCache;   // producer copy of 'oi' - refreshed only when the queue appears full
+  unsigned          resBi;     // index of the reserved record or cmInvalidIdx if no record is reserved
+  char              pad1[ kTsCacheLineByteCnt ];
+
   cmErr_t           err;
-  char*             buf;
+  char*             buf;       // buf[bn + kTsHdrByteCnt] (the extra header is used to mark a wrap at buf[bn])
   unsigned          bn;
   cmTsQueueCb_t     cbFunc;
   void*             cbArg;
-  volatile unsigned oi;
 } cmTs1p1c_t;
 
+cmTs1p1cH_t cmTs1p1cNullHandle = cmSTATIC_NULL_HANDLE;
+
 cmTs1p1c_t* _cmTs1p1cHandleToPtr( cmTs1p1cH_t h )
 {
   cmTs1p1c_t* p = (cmTs1p1c_t*)h.h;
@@ -859,12 +1181,13 @@ cmThRC_t   cmTs1p1cCreate( cmTs1p1cH_t* hPtr, unsigned bufByteCnt, cmTsQueueCb_t
   
   cmTs1p1c_t* p = cmMemAllocZ(cmTs1p1c_t,1);
   cmErrSetup(&p->err,rpt,"1p1c Queue");
-  p->buf        = cmMemAllocZ(char,bufByteCnt+sizeof(unsigned));
+  p->bn         = bufByteCnt & ~(kTsHdrByteCnt-1);
+  p->buf        = cmMemAllocZ(char,p->bn+kTsHdrByteCnt);
   p->ii         = 0;
   p->oi         = 0;
-  p->bn         = bufByteCnt;
+  p->resBi      = cmInvalidIdx;
   p->cbFunc     = cbFunc;
-  p->cbArg = cbArg;
+  p->cbArg      = cbArg;
   hPtr->h = p;
 
   return rc;
@@ -894,68 +1217,106 @@ cmThRC_t cmTs1p1cSetCallback( cmTs1p1cH_t h, cmTsQueueCb_t cbFunc, void* cbArg )
   return kOkThRC;
 }
 
+// Return the index of 'rn' consecutive free bytes given the input index 'ii' 
+// and output index 'oi' or cmInvalidIdx if the space is not available.  
+// Note: 'ii' may never advance onto 'oi' because 'ii'=='oi' marks an empty queue.
+// A stale (lagging) value of 'oi' is safe because it only underestimates the free space.
+unsigned _cmTs1p1cFindSpace( const cmTs1p1c_t* p, unsigned ii, unsigned oi, unsigned rn )
+{
+  // if oi is ahead of ii then the free space is between them
+  if( oi > ii )
+    return ii + rn < oi ? ii : cmInvalidIdx;
+
+  // if the record fits at the end of the buffer
+  if( ii + rn <= p->bn )
+    return ii;
+
+  // otherwise wrap to the front of the buffer
+  return rn < oi ? 0 : cmInvalidIdx;
+}
+
+void*  _cmTs1p1cReserve( cmTs1p1c_t* p, unsigned byteCnt )
+{
+  unsigned rn = _cmTsRecdByteCnt(byteCnt);
+  unsigned ii = p->ii;
+  unsigned bi;
+
+  // only read the consumer index if the cached copy indicates that the queue is full
+  if((bi = _cmTs1p1cFindSpace(p,ii,p->oiCache,rn)) == cmInvalidIdx )
+  {
+    p->oiCache = _cmThLoadAcquire(&p->oi);
+
+    if((bi = _cmTs1p1cFindSpace(p,ii,p->oiCache,rn)) == cmInvalidIdx )
+      return NULL;
+  }
+
+  // if the record is wrapping to the front of the buffer then mark the wrap location
+  // (the consumer cannot read this location until 'ii' is updated in _cmTs1p1cCommit())
+  if( bi != ii )
+    *(unsigned*)(p->buf + ii) = cmInvalidIdx;
+
+  p->resBi = bi;
+
+  return p->buf + bi + kTsHdrByteCnt;
+}
+
+void _cmTs1p1cCommit( cmTs1p1c_t* p, unsigned byteCnt )
+{
+  // set the msg byte count - the msg byte cnt precedes the msg body
+  *(unsigned*)(p->buf + p->resBi) = byteCnt;
+
+  // the msg must be completely written before the consumer can see the new value of 'ii'
+  _cmThStoreRelease(&p->ii, p->resBi + _cmTsRecdByteCnt(byteCnt));
+
+  p->resBi = cmInvalidIdx;
+}
+
+void*      cmTs1p1cEnqueueReserve( cmTs1p1cH_t h, unsigned byteCnt )
+{
+  cmTs1p1c_t* p  = _cmTs1p1cHandleToPtr(h);
+
+  assert( p->resBi == cmInvalidIdx );
+
+  // Note: a full queue is not reported as an error - the producer may try again later.
+  return _cmTs1p1cReserve(p,byteCnt);
+}
+
+cmThRC_t   cmTs1p1cEnqueueCommit( cmTs1p1cH_t h, unsigned byteCnt )
+{
+  cmTs1p1c_t* p  = _cmTs1p1cHandleToPtr(h);
+
+  if( p->resBi == cmInvalidIdx )
+    return cmErrMsg(&p->err,kInvalidStateThRC,"A queue commit was requested but no space was reserved.");
+
+  _cmTs1p1cCommit(p,byteCnt);
+  return kOkThRC;
+}
+
 cmThRC_t   cmTs1p1cEnqueueSegMsg( cmTs1p1cH_t h, const void* msgPtrArray[], unsigned msgByteCntArray[], unsigned arrayCnt )
 {
-  cmThRC_t    rc = kOkThRC;
   unsigned    mn = 0;
   unsigned    i;
   cmTs1p1c_t* p  = _cmTs1p1cHandleToPtr(h);
+  char*       dp;
 
   // get the total count of bytes for this msg
   for(i=0; i<arrayCnt; ++i)
     mn += msgByteCntArray[i];
 
-  int dn = mn + sizeof(unsigned);
-  int oi = p->oi;
-  int bi = p->ii;   // 'bi' is the idx of the leftmost cell which can be written 
-  int en = p->bn;   // 'en' is the idx of the cell just to the right of the rightmost cell that can be written
-
-  // note: If 'oi' marks the rightmost location then 'en' must be set
-  // one cell to the left of 'oi', because 'ii' can never be allowed to
-  // advance onto 'oi' - because 'oi'=='ii' marks an empty (NOT a full)
-  // queue. 
-  //
-  // If 'bn' marks the rightmost location then 'ii' can advance onto 'bn'
-  // beause the true queue length is bn+1.
-
-  // if we need to wrap
-  if( en-bi < dn && oi<=bi )
-  {
-    bi = 0;
-    en = oi - 1;  // note if oi==0 then en is negative - see note above re: oi==ii
-    assert( p->ii>=0 && p->ii <= p->bn );
-    *(unsigned*)(p->buf + p->ii) = cmInvalidIdx; // mark the wrap location
-  }
-
-  // if oi is between ii and bn
-  if( oi > bi )
-    en = oi - 1;  // never allow ii to advance onto oi - see note above
-
   // if the msg won't fit
-  if( en - bi < dn )
-    return cmErrMsg(&p->err,kBufFullThRC,"%i consecutive bytes is not available in the queue.",dn); 
+  if((dp = _cmTs1p1cReserve(p,mn)) == NULL )
+    return cmErrMsg(&p->err,kBufFullThRC,"%i consecutive bytes is not available in the queue.",_cmTsRecdByteCnt(mn)); 
 
-  // set the msg byte count - the msg byte cnt precedes the msg body
-  char* dp = p->buf + bi;
-  *(unsigned*)dp = dn - sizeof(unsigned);
-  dp += sizeof(unsigned);
-  
   // copy the msg into the buffer
-  for(i=0,dn=0; i<arrayCnt; ++i)
+  for(i=0; i<arrayCnt; ++i)
   {
     memcpy(dp,msgPtrArray[i],msgByteCntArray[i]);
     dp += msgByteCntArray[i];
-    dn += msgByteCntArray[i];
   }
 
-  // incrementing p->ii must occur last - the unnecessary accumulation
-  // of dn in the above loop is intended to prevent this line from
-  // begin moved before the copy loop.
-  p->ii = bi + dn + sizeof(unsigned);
-
-  assert( p->ii >= 0 && p->ii <= p->bn);
+  _cmTs1p1cCommit(p,mn);
 
-  return rc;
+  return kOkThRC;
 }
 
 cmThRC_t   cmTs1p1cEnqueueMsg( cmTs1p1cH_t  h, const void* dataPtr, unsigned byteCnt )
@@ -970,42 +1331,52 @@ unsigned   cmTs1p1cAllocByteCount( cmTs1p1cH_t h )
 unsigned   cmTs1p1cAvailByteCount( cmTs1p1cH_t h )
 {
   cmTs1p1c_t* p = _cmTs1p1cHandleToPtr(h);
-  unsigned oi = p->oi;
+  unsigned oi = _cmThLoadAcquire(&p->oi);
   unsigned ii = p->ii;
-  return oi < ii ? p->bn - ii + oi : oi - ii;
+  return oi <= ii ? p->bn - ii + oi : oi - ii;
 }
 
-unsigned _cmTs1p1cDequeueMsgByteCount( cmTs1p1c_t* p )
+// Return the index of the next msg record or cmInvalidIdx if the queue is empty.
+unsigned _cmTs1p1cNextRecdIndex( cmTs1p1c_t* p )
 {
-  // if the buffer is empty
-  if( p->ii == p->oi )
-    return 0;
+  unsigned oi = p->oi;
 
-  // get the length of the next msg
-  unsigned mn = *(unsigned*)(p->buf + p->oi);
+  // only read the producer index if the cached copy indicates that the queue is empty
+  if( oi == p->iiCache )
+    if( oi == (p->iiCache = _cmThLoadAcquire(&p->ii)) )
+      return cmInvalidIdx;
 
-  // if the msg length is cmInvalidIdx ...
-  if( mn == cmInvalidIdx )
+  // if the msg length is cmInvalidIdx then the producer wrapped to the front of the buffer
+  // (the producer never wraps onto an empty queue so the queue cannot be empty after the wrap)
+  if( *(unsigned*)(p->buf + oi) == cmInvalidIdx )
   {
-    p->oi = 0;  // ... wrap to buf begin and try again
-
-    return _cmTs1p1cDequeueMsgByteCount(p);
+    oi = 0;
+    _cmThStoreRelease(&p->oi,oi);
   }
-  
-  return mn;
+
+  return oi;
 }
 
-cmThRC_t   cmTs1p1cDequeueMsg( cmTs1p1cH_t  h,  void* dataPtr, unsigned byteCnt )
+unsigned _cmTs1p1cDequeueMsgByteCount( cmTs1p1c_t* p )
 {
-  cmThRC_t    rc = kOkThRC;
-  cmTs1p1c_t* p  = _cmTs1p1cHandleToPtr(h);
+  unsigned oi;
+  if((oi = _cmTs1p1cNextRecdIndex(p)) == cmInvalidIdx )
+    return 0;
+
+  return *(unsigned*)(p->buf + oi);
+}
 
-  unsigned mn;
+// If 'dataPtr' is NULL then the msg is delivered via 'cbFunc' otherwise it is copied to dataPtr[byteCnt].
+cmThRC_t   _cmTs1p1cDequeueMsg( cmTs1p1c_t* p, void* dataPtr, unsigned byteCnt, cmTsQueueCb_t cbFunc, void* cbArg )
+{
+  cmThRC_t    rc = kOkThRC;
+  unsigned    oi;
 
-  if((mn = _cmTs1p1cDequeueMsgByteCount(p)) == 0 )
+  if((oi = _cmTs1p1cNextRecdIndex(p)) == cmInvalidIdx )
     return kBufEmptyThRC;
 
-  void* mp = p->buf + p->oi + sizeof(unsigned);
+  unsigned mn = *(unsigned*)(p->buf + oi);
+  void*    mp = p->buf + oi + kTsHdrByteCnt;
 
   if( dataPtr != NULL )
   {
@@ -1016,60 +1387,152 @@ cmThRC_t   cmTs1p1cDequeueMsg( cmTs1p1cH_t  h,  void* dataPtr, unsigned byteCnt
   }
   else
   {
-    p->cbFunc(p->cbArg,mn,mp);
+    cbFunc(cbArg,mn,mp);
   }
 
-  p->oi += mn + sizeof(unsigned);
+  // the msg must be completely read before the producer can see the new value of 'oi'
+  _cmThStoreRelease(&p->oi, oi + _cmTsRecdByteCnt(mn));
   
   return rc;
 }
 
-
-unsigned cmTs1p1cDequeueMsgByteCount( cmTs1p1cH_t h )
+cmThRC_t   cmTs1p1cDequeueMsg( cmTs1p1cH_t  h,  void* dataPtr, unsigned byteCnt )
 {
   cmTs1p1c_t* p  = _cmTs1p1cHandleToPtr(h);
-  return _cmTs1p1cDequeueMsgByteCount(p);
+  return _cmTs1p1cDequeueMsg(p,dataPtr,byteCnt,p->cbFunc,p->cbArg);
 }
 
-bool     cmTs1p1cMsgWaiting( cmTs1p1cH_t h )
-{  return cmTs1p1cDequeueMsgByteCount(h) > 0;  }
+unsigned   _cmTs1p1cDequeueSpan( cmTs1p1c_t* p, cmTsSpan_t* s )
+{
+  unsigned oi = _cmTs1p1cNextRecdIndex(p);
+  unsigned ii = p->iiCache;
+  unsigned i;
 
-bool cmTs1p1cIsValid( cmTs1p1cH_t h )
-{ return h.h != NULL; }
+  s->buf     = NULL;
+  s->byteCnt = 0;
+  s->msgCnt  = 0;
 
-//============================================================================================================================
+  if( oi == cmInvalidIdx )
+    return 0;
 
+  // the span ends at the input index or at the wrap marker
+  for(i=oi; i!=ii && *(unsigned*)(p->buf + i) != cmInvalidIdx; ++s->msgCnt)
+    i += _cmTsRecdByteCnt( *(unsigned*)(p->buf + i) );
 
-bool     cmThIntCAS(   int*      addr, int      old, int      new )
-{
-#ifdef OS_OSX
-  int rv = OSAtomicCompareAndSwap32Barrier(old,new,addr);
-  return rv;
-#endif
+  s->buf     = p->buf + oi;
+  s->byteCnt = i - oi;
 
-#ifdef OS_LINUX 
-  return __sync_bool_compare_and_swap(addr,old,new); 
-#endif
+  return s->msgCnt;
 }
 
-bool     cmThUIntCAS(  unsigned* addr, unsigned old, unsigned new )
-{ 
-#ifdef OS_OSX
-  return OSAtomicCompareAndSwap32Barrier((int)old,(int)new,(int*)addr);
-#endif
-
-#ifdef OS_LINUX 
-  return __sync_bool_compare_and_swap(addr,old,new); 
-#endif
+void _cmTs1p1cDequeueRelease( cmTs1p1c_t* p, unsigned byteCnt )
+{
+  _cmThStoreRelease(&p->oi, p->oi + byteCnt);
 }
 
-bool     cmThFloatCAS( float*    addr, float    old, float    new )
-{ 
-#ifdef OS_OSX
-  return  OSAtomicCompareAndSwap32Barrier(*(int*)(&old),*(int*)(&new),(int*)addr ); 
-#endif
+unsigned _cmTs1p1cDequeueAllMsgs( cmTs1p1c_t* p, cmTsQueueCb_t cbFunc, void* cbArg, unsigned maxMsgCnt )
+{
+  unsigned   n = 0;
+  cmTsSpan_t s;
 
-#ifdef OS_LINUX
+  // there are at most two spans waiting (before and after the wrap) 
+  // but a producer may add more while the callbacks are in progress
+  while( n < maxMsgCnt && _cmTs1p1cDequeueSpan(p,&s) > 0 )
+  {
+    unsigned    offs = 0;
+    unsigned    mn;
+    const void* mp;
+    
+    for(; n < maxMsgCnt && (mp = cmTsSpanNextMsg(&s,&offs,&mn)) != NULL; ++n)
+      cbFunc(cbArg,mn,mp);
+
+    _cmTs1p1cDequeueRelease(p,offs);
+  }
+
+  return n;
+}
+
+unsigned   cmTs1p1cDequeueSpan( cmTs1p1cH_t h, cmTsSpan_t* s )
+{
+  cmTs1p1c_t* p  = _cmTs1p1cHandleToPtr(h);
+  return _cmTs1p1cDequeueSpan(p,s);
+}
+
+cmThRC_t   cmTs1p1cDequeueRelease( cmTs1p1cH_t h, const cmTsSpan_t* s )
+{
+  cmTs1p1c_t* p  = _cmTs1p1cHandleToPtr(h);
+
+  if( s->byteCnt > 0 && s->buf != p->buf + p->oi )
+    return cmErrMsg(&p->err,kInvalidStateThRC,"The released span does not begin at the queue output location.");
+
+  _cmTs1p1cDequeueRelease(p,s->byteCnt);
+  return kOkThRC;
+}
+
+unsigned   cmTs1p1cDequeueAllMsgs( cmTs1p1cH_t h, unsigned maxMsgCnt )
+{
+  cmTs1p1c_t* p  = _cmTs1p1cHandleToPtr(h);
+  return _cmTs1p1cDequeueAllMsgs(p,p->cbFunc,p->cbArg,maxMsgCnt);
+}
+
+unsigned cmTs1p1cDequeueMsgByteCount( cmTs1p1cH_t h )
+{
+  cmTs1p1c_t* p  = _cmTs1p1cHandleToPtr(h);
+  return _cmTs1p1cDequeueMsgByteCount(p);
+}
+
+bool     cmTs1p1cMsgWaiting( cmTs1p1cH_t h )
+{  return cmTs1p1cDequeueMsgByteCount(h) > 0;  }
+
+bool cmTs1p1cIsValid( cmTs1p1cH_t h )
+{ return h.h != NULL; }
+
+const void* cmTsSpanNextMsg( const cmTsSpan_t* s, unsigned* offsRef, unsigned* msgByteCntRef )
+{
+  if( *offsRef >= s->byteCnt )
+    return NULL;
+
+  const char* rp = s->buf + *offsRef;
+  unsigned    mn = *(const unsigned*)rp;
+
+  *msgByteCntRef = mn;
+  *offsRef      += _cmTsRecdByteCnt(mn);
+  return rp + kTsHdrByteCnt;
+}
+
+//============================================================================================================================
+
+
+bool     cmThIntCAS(   int*      addr, int      old, int      new )
+{
+#ifdef OS_OSX
+  int rv = OSAtomicCompareAndSwap32Barrier(old,new,addr);
+  return rv;
+#endif
+
+#ifdef OS_LINUX 
+  return __sync_bool_compare_and_swap(addr,old,new); 
+#endif
+}
+
+bool     cmThUIntCAS(  unsigned* addr, unsigned old, unsigned new )
+{ 
+#ifdef OS_OSX
+  return OSAtomicCompareAndSwap32Barrier((int)old,(int)new,(int*)addr);
+#endif
+
+#ifdef OS_LINUX 
+  return __sync_bool_compare_and_swap(addr,old,new); 
+#endif
+}
+
+bool     cmThFloatCAS( float*    addr, float    old, float    new )
+{ 
+#ifdef OS_OSX
+  return  OSAtomicCompareAndSwap32Barrier(*(int*)(&old),*(int*)(&new),(int*)addr ); 
+#endif
+
+#ifdef OS_LINUX
   // If we use pointer aliasing to pun the pointer types then it will violate the
   // strict pointer aliasing rules used by -O2. Instead we use this union
   // punning scheme which in theory should always work in C99 (although no C++).
@@ -1205,43 +1668,48 @@ void     cmThFloatDecr(float*    addr, float    decr )
 //============================================================================================================================
 //
 //
-typedef  pthread_t cmThreadId_t;
 
-typedef struct
+enum
 {
-  cmThreadId_t id;    // id of this thread as returned by pthread_self()
-  char*        buf;   // buf[bn]
-  int          ii;    // input index
-  int          oi;    // output index  (oi==ii == empty buffer)
-} cmTsBuf_t;
+  kActiveMp1cId = 0,         // cmTsMp1cBuf_t.stateId values
+  kReleasedMp1cId            // the producer thread has exited - the record may be claimed by a new producer
+};
 
-// msg header - which is actually written AFTER the msg it is associated with
-typedef struct cmTsHdr_str
+// The second word of a msg record header [ msgByteCnt rsrvd ] is not used by cmTs1p1c.
+// cmTsMp1c uses it to hold the sequence number of the msg.
+#define _cmTsMp1cRecdSeq(recdPtr) (((unsigned*)(recdPtr))[1])
+
+// one queue per producer thread
+typedef struct cmTsMp1cBuf_str
 {
-  int                 mn;     // length of the msg
-  int                 ai;     // buffer index
-  struct cmTsHdr_str* link;   // pointer to next msg
-} cmTsHdr_t;
+  volatile unsigned        stateId; // see kXXXMp1cId
+  cmTs1p1c_t*              q;       // producer queue
+  struct cmTsMp1cBuf_str*  link;    // next producer record
+} cmTsMp1cBuf_t;
 
 typedef struct
 {
-  cmErr_t       err;
-  int           bn;        // bytes per thread buffer  
-  cmTsBuf_t*    a;         // a[an] buffer array
-  unsigned      an;        // length of a[] - one buffer per thread
-  cmTsQueueCb_t cbFunc;
-  void*         cbArg;
-  cmTsHdr_t*    ilp;        // prev msg hdr record
-  cmTsHdr_t*    olp;        // prev msg hdr record (wait for olp->link to be set to go to next record)
+  cmErr_t           err;
+  unsigned          bn;        // bytes per producer queue  
+  cmTsQueueCb_t     cbFunc;
+  void*             cbArg;
+  cmRpt_t*          rpt;
+  pthread_key_t     key;       // thread specific ptr to the producer record of the calling thread
+  bool              keyFl;     // 'key' was created
+  cmTsMp1cBuf_t*    list;      // producer records (records are recycled but not released until the queue is destroyed)
+  volatile unsigned iSeq;      // sequence number of the next msg to be enqueued
+  unsigned          oSeq;      // sequence number of the next msg to be dequeued
+  cmTsMp1cBuf_t*    cp;        // producer of the last msg dequeued
 } cmTsMp1c_t;
 
 cmTsMp1cH_t cmTsMp1cNullHandle = cmSTATIC_NULL_HANDLE;
 
 void _cmTsMp1cPrint( cmTsMp1c_t* p )
 {
-  unsigned i;
-  for(i=0; i<p->an; ++i)
-    printf("%2i ii:%3i oi:%3i\n",i,p->a[i].ii,p->a[i].oi);
+  cmTsMp1cBuf_t* b;
+  unsigned       i;
+  for(b=p->list,i=0; b!=NULL; b=b->link,++i)
+    printf("%2i %s ii:%3i oi:%3i\n",i,b->stateId==kActiveMp1cId ? "act" : "rls",b->q->ii,b->q->oi);
 }
 
 cmTsMp1c_t* _cmTsMp1cHandleToPtr( cmTsMp1cH_t h )
@@ -1251,19 +1719,59 @@ cmTsMp1c_t* _cmTsMp1cHandleToPtr( cmTsMp1cH_t h )
   return p;
 }
 
-unsigned _cmTsMp1cBufIndex( cmTsMp1c_t* p, cmThreadId_t id )
+// Called when a producer thread exits.  The record, and any msgs which
+// are still in its queue, remain in the producer list.
+void _cmTsMp1cReleaseBuf( void* arg )
 {
-  unsigned i;
-  for(i=0; i<p->an; ++i)
-    if( p->a[i].id == id )
-      return i;
-
-  p->an       = i+1;
-  p->a        = cmMemResizePZ(cmTsBuf_t,p->a,p->an);
-  p->a[i].buf = cmMemAllocZ(char,p->bn);
-  p->a[i].id  = id;
- 
-  return i;        
+  cmTsMp1cBuf_t* b = (cmTsMp1cBuf_t*)arg;
+  _cmThStoreRelease(&b->stateId,kReleasedMp1cId);
+}
+
+// Return the producer queue for the calling thread - allocating it if necessary.
+cmTsMp1cBuf_t* _cmTsMp1cBuf( cmTsMp1c_t* p )
+{
+  cmTsMp1cBuf_t* b;
+
+  if((b = (cmTsMp1cBuf_t*)pthread_getspecific(p->key)) != NULL )
+    return b;
+
+  // claim the record of a producer thread which has exited
+  // (the previous producer will never write to the queue again so
+  // the queue remains single producer even if msgs are still waiting)
+  for(b=_cmThLoadAcquire(&p->list); b!=NULL; b=b->link)
+    if( _cmThLoadAcquire(&b->stateId) == kReleasedMp1cId && cmThUIntCAS((unsigned*)&b->stateId,kReleasedMp1cId,kActiveMp1cId) )
+      break;
+
+  // otherwise allocate a new record
+  if( b == NULL )
+  {
+    cmTs1p1cH_t qH = cmTs1p1cNullHandle;
+    
+    if( cmTs1p1cCreate(&qH,p->bn,NULL,NULL,p->rpt) != kOkThRC )
+    {
+      cmErrMsg(&p->err,kCreateFailThRC,"The producer queue allocation failed.");
+      return NULL;
+    }
+
+    b          = cmMemAllocZ(cmTsMp1cBuf_t,1);
+    b->stateId = kActiveMp1cId;
+    b->q       = _cmTs1p1cHandleToPtr(qH);
+
+    // prepend the record to the producer list - the consumer may now service this queue
+    do
+    {
+      b->link = p->list;
+    }while( !cmThPtrCAS(&p->list,b->link,b) );
+  }
+  
+  if( pthread_setspecific(p->key,b) != 0 )
+  {
+    _cmThStoreRelease(&b->stateId,kReleasedMp1cId);
+    cmErrMsg(&p->err,kCreateFailThRC,"The producer thread record could not be assigned.");
+    return NULL;
+  }
+
+  return b;        
 }
 
 cmThRC_t   cmTsMp1cDestroy(    cmTsMp1cH_t* hp )
@@ -1271,12 +1779,24 @@ cmThRC_t   cmTsMp1cDestroy(    cmTsMp1cH_t* hp )
   if( hp == NULL || cmTsMp1cIsValid(*hp) == false )
     return kOkThRC;
 
-  cmTsMp1c_t* p = _cmTsMp1cHandleToPtr(*hp);
-  unsigned i;
-  for(i=0; i<p->an; ++i)
-    cmMemFree(p->a[i].buf);
+  cmTsMp1c_t*    p = _cmTsMp1cHandleToPtr(*hp);
+  cmTsMp1cBuf_t* b = p->list;
 
-  cmMemPtrFree(&p->a);
+  // Note: deleting the key does not call _cmTsMp1cReleaseBuf() for threads
+  // which are still running - the records are released below. 
+  if( p->keyFl )
+    pthread_key_delete(p->key);
+  
+  while( b != NULL )
+  {
+    cmTsMp1cBuf_t* nb = b->link;
+    cmTs1p1cH_t    qH;
+    qH.h = b->q;
+    cmTs1p1cDestroy(&qH);
+    cmMemFree(b);
+    b = nb;
+  }
+  
   cmMemFree(p);
 
   hp->h = NULL;
@@ -1294,15 +1814,25 @@ cmThRC_t   cmTsMp1cCreate(  cmTsMp1cH_t* hp, unsigned bufByteCnt, cmTsQueueCb_t
 
   cmErrSetup(&p->err,rpt,"TsMp1c Queue");
 
-  p->a          = NULL;
-  p->an         = 0;
+  p->list       = NULL;
+  p->iSeq       = 0;
+  p->oSeq       = 0;
+  p->cp         = NULL;
   p->bn         = bufByteCnt;
   p->cbFunc     = cbFunc;
-  p->cbArg = cbArg;
-  p->ilp        = NULL;
-  p->olp        = NULL;
+  p->cbArg      = cbArg;
+  p->rpt        = rpt;
 
-  hp->h = p;
+  int sysErr;
+  if((sysErr = pthread_key_create(&p->key,_cmTsMp1cReleaseBuf)) != 0 )
+  {
+    rc = _cmThError(&p->err,kCreateFailThRC,sysErr,"The producer thread key create failed.");
+    cmMemFree(p);
+    return rc;
+  }
+  
+  p->keyFl = true;
+  hp->h    = p;
   return rc;
 }
 
@@ -1325,107 +1855,40 @@ void* cmTsMp1cCbArg( cmTsMp1cH_t h )
   return p->cbArg;
 }
 
-//#define CAS(addr,old,new) __sync_bool_compare_and_swap(addr,old,new)
-//#define CAS(addr,old,neww) cmThPtrCAS(addr,old,neww)
-
 cmThRC_t   cmTsMp1cEnqueueSegMsg( cmTsMp1cH_t h, const void* msgPtrArray[], unsigned msgByteCntArray[], unsigned arrayCnt )
 {
-  cmThRC_t    rc = kOkThRC;
-  unsigned    mn = 0;
-  cmTsMp1c_t* p  = _cmTsMp1cHandleToPtr(h);
-  unsigned    ai = _cmTsMp1cBufIndex( p, pthread_self() );
-  cmTsBuf_t*  b  = p->a + ai;
-  int         i,bi,ei;
-  cmTsHdr_t   hdr;
-
-  // Use a stored oi for the duration of this function.
-  // b->oi may be changed by the dequeue thread but storing it here
-  // at least prevents it from changing during the course of the this function.
-  // Note: b->oi is only used to check for buffer full.  Even if it changes
-  // it would only mean that more bytes were available than calculated based
-  // on the stored value.  A low estimate of the actual bytes available is 
-  // never unsafe.
-  volatile int    oi = b->oi; 
+  cmTsMp1c_t*    p  = _cmTsMp1cHandleToPtr(h);
+  cmTsMp1cBuf_t* b;
+  unsigned       mn = 0;
+  unsigned       i;
+  char*          dp;
+
+  if((b = _cmTsMp1cBuf(p)) == NULL )
+    return kBufFullThRC;
 
   // get the total count of bytes for this msg
   for(i=0; i<arrayCnt; ++i)
     mn += msgByteCntArray[i];
 
-  // dn = count of msg bytes + count of header bytes
-  int dn = mn + sizeof(hdr);
-
-  // if oi is ahead of ii in the queue then we must write
-  // in the area between ii and oi
-  if( oi > b->ii )
-  {
-    ei = oi-1; // (never allow ii to equal oi (that's the empty condition))
-    bi = b->ii;
-  }
-  else // otherwise oi is same or before ii in the queue and we have the option to wrap
-  {
-    // if the new msg will not fit at the end of the queue ....
-    if( b->ii + dn > p->bn )
-    {
-      bi = 0;     // ... then wrap to the beginning
-      ei = oi-1;  // (never allow ii to equal oi (that's the empty condition))
-     }
-    else 
-    {
-      ei = p->bn; // otherwise write at the current location
-      bi = b->ii;
-    }
-  }
-  
-  if( bi + dn > ei )
-    return cmErrMsg(&p->err,kBufFullThRC,"%i consecutive bytes is not available in the queue.",dn);
-
-  char* dp = b->buf + bi;
+  // if the msg won't fit
+  if((dp = _cmTs1p1cReserve(b->q,mn)) == NULL )
+    return cmErrMsg(&p->err,kBufFullThRC,"%i consecutive bytes is not available in the queue.",_cmTsRecdByteCnt(mn)); 
 
-  // write the msg
+  // copy the msg into the buffer
   for(i=0; i<arrayCnt; ++i)
   {
     memcpy(dp,msgPtrArray[i],msgByteCntArray[i]);
     dp += msgByteCntArray[i];
   }
 
-  // setup the msg header
-  hdr.ai   = ai;
-  hdr.mn   = mn;
-  hdr.link = NULL;
-
-  // write the msg header (following the msg body in memory)
-  cmTsHdr_t* hp = (cmTsHdr_t*)dp;
-  memcpy(hp,&hdr,sizeof(hdr));
-
-  // increment the buffers input index
-  b->ii = bi + dn;
+  // The sequence number is taken after the space is reserved so that every
+  // sequence number is committed. The consumer cannot deliver any msg 
+  // following this one until it is committed.
+  _cmTsMp1cRecdSeq(b->q->buf + b->q->resBi) = __sync_fetch_and_add(&p->iSeq,1);
 
-  // update the link list head to point to this msg hdr
-  cmTsHdr_t* old_hp, *new_hp;
-  do
-  {
-    old_hp = p->ilp;
-    new_hp = hp;
-  }while(!cmThPtrCAS(&p->ilp,old_hp,new_hp));
-
-  // link the prev recd to this recd
-  if( old_hp != NULL )
-    old_hp->link = hp;
-
-  // if this is the first record written by this queue then prime the output list 
-  do
-  {
-    old_hp = p->olp;
-    new_hp = hp;
+  _cmTs1p1cCommit(b->q,mn);
 
-    if( old_hp != NULL )
-      break;
-    
-  }while(!cmThPtrCAS(&p->olp,old_hp,new_hp));
-
-  //printf("%p %p %i\n",p->ilp,p->olp,p->olp->mn);
-
-  return rc;
+  return kOkThRC;
 }
 
 cmThRC_t   cmTsMp1cEnqueueMsg( cmTsMp1cH_t  h, const void* dataPtr, unsigned byteCnt )
@@ -1439,84 +1902,103 @@ unsigned   cmTsMp1cAllocByteCount( cmTsMp1cH_t h )
 
 unsigned   cmTsMp1cAvailByteCount( cmTsMp1cH_t h )
 {
-  cmTsMp1c_t*      p  = _cmTsMp1cHandleToPtr(h);
-  unsigned         ai = _cmTsMp1cBufIndex(p,pthread_self());
-  const cmTsBuf_t* b  = p->a + ai;
+  cmTsMp1c_t*    p  = _cmTsMp1cHandleToPtr(h);
+  cmTsMp1cBuf_t* b;
+  cmTs1p1cH_t    qH;
 
-  if( b->oi > b->ii )
-    return b->oi - b->ii - 1;
+  // if the calling thread has not enqueued any msgs then its entire queue is available
+  if((b = (cmTsMp1cBuf_t*)pthread_getspecific(p->key)) == NULL )
+    return p->bn;
 
-  return (p->bn - b->ii) + b->oi - 1;
+  qH.h = b->q;
+  return cmTs1p1cAvailByteCount(qH);
 }
 
-unsigned _cmTsMp1cNextMsgByteCnt( cmTsMp1c_t* p )
-{ 
-  if( p->olp == NULL )
-    return 0;
-
-  // if the current msg has not yet been read
-  if( p->olp->mn != 0 )
-    return p->olp->mn;
+// Return true if the next msg in the queue 'q' is the next msg in sequence.
+bool _cmTsMp1cIsNext( cmTsMp1c_t* p, cmTs1p1c_t* q )
+{
+  unsigned oi;
+  return (oi = _cmTs1p1cNextRecdIndex(q)) != cmInvalidIdx && _cmTsMp1cRecdSeq(q->buf + oi) == p->oSeq;
+}
 
-  // if the current msg has been read but a new next msg has been linked
-  if( p->olp->mn == 0 && p->olp->link != NULL )
-  {
-    // advance the buffer output msg past the prev msg header
-    char* hp = (char*)(p->olp + 1);
-    p->a[p->olp->ai].oi =  hp - p->a[p->olp->ai].buf;
+// Return the producer whose next msg is the next msg in sequence or NULL if
+// the next msg has not been committed.
+cmTsMp1cBuf_t* _cmTsMp1cNextBuf( cmTsMp1c_t* p )
+{ 
+  cmTsMp1cBuf_t* b;
 
-    // advance msg pointer to point to the new msg header
-    p->olp = p->olp->link;
+  // the next msg is most likely from the same producer as the last msg
+  if( p->cp != NULL && _cmTsMp1cIsNext(p,p->cp->q) )
+    return p->cp;
+  
+  for(b=_cmThLoadAcquire(&p->list); b!=NULL; b=b->link)
+    if( b != p->cp && _cmTsMp1cIsNext(p,b->q) )
+      return p->cp = b;
 
-    // return the size of the new msg
-    return p->olp->mn;
-  }
-  return 0;
+  return NULL;
 }
 
 cmThRC_t   cmTsMp1cDequeueMsg( cmTsMp1cH_t  h,  void* dataPtr, unsigned byteCnt )
 {
-  cmTsMp1c_t* p  = _cmTsMp1cHandleToPtr(h);
+  cmTsMp1c_t*    p  = _cmTsMp1cHandleToPtr(h);
+  cmTsMp1cBuf_t* b;
+  cmThRC_t       rc;
 
   // if there are no messages waiting
-  if( _cmTsMp1cNextMsgByteCnt(p) == 0 )
+  if((b = _cmTsMp1cNextBuf(p)) == NULL )
     return kBufEmptyThRC;
 
-  char*    hp = (char*)p->olp;
-  char*    dp = hp - p->olp->mn;  // the msg body is before the msg hdr
+  if((rc = _cmTs1p1cDequeueMsg(b->q,dataPtr,byteCnt,p->cbFunc,p->cbArg)) == kOkThRC )
+    ++p->oSeq;
 
-  if( dataPtr == NULL )
-  {
-    p->cbFunc(p->cbArg,p->olp->mn,dp);
-  }
-  else
-  {
-    if( p->olp->mn > byteCnt )
-      return cmErrMsg(&p->err,kBufTooSmallThRC,"The return buffer constains too few bytes (%i) to contain %i bytes.",byteCnt,p->olp->mn);
+  return rc;
+}
 
-    memcpy(dataPtr,dp,p->olp->mn);
-  }
+unsigned   cmTsMp1cDequeueAllMsgs( cmTsMp1cH_t h, unsigned maxMsgCnt )
+{
+  cmTsMp1c_t*    p   = _cmTsMp1cHandleToPtr(h);
+  unsigned       n   = 0;
+  cmTsMp1cBuf_t* b;
+  cmTsSpan_t     s;
+
+  // deliver runs of consecutive msgs from each producer's queue in sequence order
+  while( n < maxMsgCnt && (b = _cmTsMp1cNextBuf(p)) != NULL && _cmTs1p1cDequeueSpan(b->q,&s) > 0 )
+  {
+    unsigned    offs = 0;
+    unsigned    o    = 0;
+    unsigned    mn;
+    const void* mp;
 
-  // advance the buffers output index past the msg body
-  p->a[p->olp->ai].oi = hp - p->a[p->olp->ai].buf;
+    for(; n < maxMsgCnt; ++n, ++p->oSeq, offs=o)
+    {
+      if( offs >= s.byteCnt || _cmTsMp1cRecdSeq(s.buf + offs) != p->oSeq )
+        break;
 
-  // mark the msg as read
-  p->olp->mn = 0;
+      mp = cmTsSpanNextMsg(&s,&o,&mn);
+      p->cbFunc(p->cbArg,mn,mp);
+    }
+    
+    _cmTs1p1cDequeueRelease(b->q,offs);
+  }
 
-  return kOkThRC;
+  return n;
 }
 
-
 bool       cmTsMp1cMsgWaiting( cmTsMp1cH_t h )
 {
   cmTsMp1c_t* p  = _cmTsMp1cHandleToPtr(h);
-  return _cmTsMp1cNextMsgByteCnt(p) != 0;
+  return _cmTsMp1cNextBuf(p) != NULL;
 }
 
 unsigned   cmTsMp1cDequeueMsgByteCount( cmTsMp1cH_t h )
 {
-  cmTsMp1c_t* p  = _cmTsMp1cHandleToPtr(h);
-  return _cmTsMp1cNextMsgByteCnt(p);
+  cmTsMp1c_t*    p  = _cmTsMp1cHandleToPtr(h);
+  cmTsMp1cBuf_t* b;
+
+  if((b = _cmTsMp1cNextBuf(p)) == NULL )
+    return 0;
+
+  return _cmTs1p1cDequeueMsgByteCount(b->q);
 }
   
 bool       cmTsMp1cIsValid( cmTsMp1cH_t h )
@@ -1649,112 +2131,163 @@ void cmTsQueueTest( cmRpt_t* rpt )
 //
 // cmTs1p1cTest()
 //
+// Throughput and latency benchmark. A producer thread sends msgs to the
+// calling (consumer) thread using the copying and reserve/commit enqueue
+// functions and the consumer receives them one at a time and in batches.
+//
+
+enum { kTs1p1cTestMsgCnt = 1000000, kTs1p1cTestQueueByteCnt = 64*1024 };
 
-// param recd for use by _cmTsQueueCb0() and
-// the msg record passed between the sender
-// threads and the receiver thread
 typedef struct
 {
-  unsigned     id;
-  cmTs1p1cH_t  qH;
-  int          val;
-} _cmTs1p1cCbParam_t;
+  unsigned     seqId;     // msg sequence number
+  cmTimeSpec_t t;         // time the msg was enqueued
+  char         data[40];  // msg payload (approx. the size of a cmDspUiHdr_t msg)
+} _cmTs1p1cTestMsg_t;
 
-cmTs1p1cH_t cmTs1p1cNullHandle = cmSTATIC_NULL_HANDLE;
+typedef struct
+{
+  cmTs1p1cH_t        qH;
+  bool               reserveFl;  // use cmTs1p1cEnqueueReserve()/cmTs1p1cEnqueueCommit()
+  unsigned           msgCnt;     // count of msgs to send
+  unsigned           sendCnt;    // count of msgs sent
+  unsigned           fullCnt;    // count of times the queue was full 
+  unsigned           recvCnt;    // count of msgs received
+  unsigned           errCnt;     // count of msgs received out of order
+  unsigned long long latSumNs;   // sum of enqueue to dequeue latency
+  unsigned           latMaxNs;   // max enqueue to dequeue latency
+} _cmTs1p1cTest_t;
 
-// Generate a random number and put it in a TS queue
-bool _cmTs1p1cCb0(void* param)
+bool _cmTs1p1cTestProducer( void* arg )
 {
-  _cmTs1p1cCbParam_t* p = (_cmTs1p1cCbParam_t*)param;
+  _cmTs1p1cTest_t* p = (_cmTs1p1cTest_t*)arg;
+  unsigned         i;
 
-  p->val = rand(); // generate a random number
+  if( p->sendCnt >= p->msgCnt )
+  {
+    cmSleepUs(1000);
+    return true;
+  }
 
-  // send the msg
-  if( cmTs1p1cEnqueueMsg( p->qH, p, sizeof(_cmTs1p1cCbParam_t)) == kOkThRC )
-    printf("in:%i %i\n",p->id,p->val);
-  else
-    printf("in error %i\n",p->id);
-  
-  ++p->id;
+  for(i=0; i<64 && p->sendCnt < p->msgCnt; ++i)
+  {
+    _cmTs1p1cTestMsg_t* mp;
 
-  cmSleepUs(100*1000);
+    if( p->reserveFl )
+    {
+      // build the msg in place
+      if((mp = (_cmTs1p1cTestMsg_t*)cmTs1p1cEnqueueReserve(p->qH,sizeof(*mp))) == NULL )
+      {
+        ++p->fullCnt;
+        break;
+      }
+
+      mp->seqId = p->sendCnt;
+      cmTimeGetMonotonic(&mp->t);
+      cmTs1p1cEnqueueCommit(p->qH,sizeof(*mp));
+    }
+    else
+    {
+      _cmTs1p1cTestMsg_t m;
+
+      // avoid the queue full error msg - this test guarantees that a msg will fit
+      if( cmTs1p1cAvailByteCount(p->qH) < 2*(sizeof(m)+kTsHdrByteCnt) )
+      {
+        ++p->fullCnt;
+        break;
+      }
+
+      memset(&m,0,sizeof(m));
+      m.seqId = p->sendCnt;
+      cmTimeGetMonotonic(&m.t);
+      cmTs1p1cEnqueueMsg(p->qH,&m,sizeof(m));
+    }
+
+    ++p->sendCnt;
+  }
 
   return true;
 }
 
-// Monitor a TS queue for incoming messages from _cmTs1p1cCb1()
-bool _cmTs1p1cCb1(void* param)
+void _cmTs1p1cTestRecv( _cmTs1p1cTest_t* p, const _cmTs1p1cTestMsg_t* m )
 {
-  // the thread param is a ptr to the TS queue to monitor.
-  cmTs1p1cH_t*   qp = (cmTs1p1cH_t*)param;
-  cmThRC_t        rc;
-  _cmTs1p1cCbParam_t msg;
+  cmTimeSpec_t t;
+  cmTimeGetMonotonic(&t);
 
-  // dequeue any waiting messages
-  if((rc = cmTs1p1cDequeueMsg( *qp, &msg, sizeof(msg))) == kOkThRC )
-    printf("out:%i %i\n",msg.id,msg.val);
-  else
-  {
-    if( rc != kBufEmptyThRC )
-      printf("out error:%i\n", rc);
-  }
+  unsigned ns = cmTimeElapsedNanos(&m->t,&t);
 
-  return true;
+  if( m->seqId != p->recvCnt )
+    ++p->errCnt;
+
+  p->latSumNs += ns;
+  if( ns > p->latMaxNs )
+    p->latMaxNs = ns;
+
+  ++p->recvCnt;
 }
 
-// Test the TS queue by starting sender threads (threads 0 & 1)
-// and a receiver thread (thread 2) and sending messages
-// from the sender to the receiver.
-void cmTs1p1cTest( cmRpt_t* rpt )
+cmRC_t _cmTs1p1cTestCb( void* arg, unsigned msgByteCnt, const void* msgDataPtr )
 {
-  cmThreadH_t th0=cmThreadNullHandle,th1=cmThreadNullHandle,th2=cmThreadNullHandle;
-  cmTs1p1cH_t q=cmTs1p1cNullHandle;
-  _cmTs1p1cCbParam_t param1;
+  _cmTs1p1cTestRecv((_cmTs1p1cTest_t*)arg,(const _cmTs1p1cTestMsg_t*)msgDataPtr);
+  return cmOkRC;
+}
 
-  // create a TS Queue
-  if( cmTs1p1cCreate(&q,28*2,NULL,NULL,rpt) != kOkThRC )
-    goto errLabel;
+void _cmTs1p1cTestRun( cmRpt_t* rpt, const char* label, bool reserveFl, bool batchFl )
+{
+  cmThreadH_t     thH = cmThreadNullHandle;
+  _cmTs1p1cTest_t t;
+  cmTimeSpec_t    t0,t1;
 
-  // create thread 1
-  param1.id = 0;
-  param1.qH = q;
-  if( cmThreadCreate(&th1,_cmTs1p1cCb0,&param1,rpt) != kOkThRC )
-    goto errLabel;
+  memset(&t,0,sizeof(t));
+  t.qH        = cmTs1p1cNullHandle;
+  t.reserveFl = reserveFl;
+  t.msgCnt    = kTs1p1cTestMsgCnt;
 
-  // create thread 2
-  if( cmThreadCreate(&th2,_cmTs1p1cCb1,&q,rpt) != kOkThRC )
+  if( cmTs1p1cCreate(&t.qH,kTs1p1cTestQueueByteCnt,_cmTs1p1cTestCb,&t,rpt) != kOkThRC )
     goto errLabel;
 
-  // start thread 1
-  if( cmThreadPause(th1,0) != kOkThRC )
+  if( cmThreadCreate(&thH,_cmTs1p1cTestProducer,&t,rpt) != kOkThRC )
     goto errLabel;
 
-  // start thread 2
-  if( cmThreadPause(th2,0) != kOkThRC )
+  cmTimeGetMonotonic(&t0);
+
+  if( cmThreadPause(thH,0) != kOkThRC )
     goto errLabel;
 
-  printf("any key to quit.");
-  getchar();
+  while( t.recvCnt < t.msgCnt )
+  {
+    if( batchFl )
+      cmTs1p1cDequeueAllMsgs(t.qH,cmInvalidCnt);
+    else
+    {
+      _cmTs1p1cTestMsg_t m;
+      if( cmTs1p1cDequeueMsg(t.qH,&m,sizeof(m)) == kOkThRC )
+        _cmTs1p1cTestRecv(&t,&m);
+    }
+  }
 
- 
- errLabel:
+  cmTimeGetMonotonic(&t1);
 
-  if( cmThreadIsValid(th0) )
-    if( cmThreadDestroy(&th0) != kOkThRC )
-      printf("Error destroying thread 0\n");
+  double secs = cmTimeElapsedMicros(&t0,&t1) / 1000000.0;
 
-  if( cmThreadIsValid(th1) )
-    if( cmThreadDestroy(&th1) != kOkThRC )
-      printf("Error destroying thread 1\n");
+  cmRptPrintf(rpt,"%-16s msgs:%i secs:%6.3f msgs/sec:%10.0f latency mean:%8.1f max:%8.1f usecs full:%i errors:%i\n",
+    label, t.recvCnt, secs, t.recvCnt/secs, t.latSumNs/1000.0/t.recvCnt, t.latMaxNs/1000.0, t.fullCnt, t.errCnt );
 
-  if( cmThreadIsValid(th2) )
-    if( cmThreadDestroy(&th2) != kOkThRC )
-      printf("Error destroying thread 1\n");
+ errLabel:
+  if( cmThreadIsValid(thH) )
+    if( cmThreadDestroy(&thH) != kOkThRC )
+      cmRptPrintf(rpt,"Error destroying producer thread.\n");
 
-  if( cmTs1p1cIsValid(q) )
-    if( cmTs1p1cDestroy(&q) != kOkThRC )
-      printf("Error destroying queue\n");
-  
+  if( cmTs1p1cIsValid(t.qH) )
+    if( cmTs1p1cDestroy(&t.qH) != kOkThRC )
+      cmRptPrintf(rpt,"Error destroying queue.\n");
+}
+
+void cmTs1p1cTest( cmRpt_t* rpt )
+{
+  _cmTs1p1cTestRun(rpt,"copy/single",   false, false );
+  _cmTs1p1cTestRun(rpt,"copy/batch",    false, true  );
+  _cmTs1p1cTestRun(rpt,"reserve/batch", true,  true  );
 }
 
 
@@ -1762,123 +2295,177 @@ void cmTs1p1cTest( cmRpt_t* rpt )
 //
 // cmTsMp1cTest()
 //
-// param recd for use by _cmTsQueueCb0() and
-// the msg record passed between the sender
-// threads and the receiver thread
+// Producer threads are started in waves. Each producer sends a fixed count of msgs
+// and then exits. The total count of producer threads is much larger than the count
+// running at any one time so the producer queues of exited threads are recycled.
+// Each msg is stamped with a ticket while holding a mutex so that the order in which
+// the msgs were enqueued is known. The consumer (the calling thread) checks that
+// the msgs arrive in that order.
+//
+
+enum { kTsMp1cTestWaveCnt = 8, kTsMp1cTestThreadCnt = 24, kTsMp1cTestMsgCnt = 500 };
+
 typedef struct
 {
-  unsigned     id;
-  cmTsMp1cH_t  qH;
-  int          val;
-} _cmTsMp1cCbParam_t;
+  unsigned     id;        // producer index
+  unsigned     val;       // ticket
+} _cmTsMp1cTestMsg_t;
 
+typedef struct
+{
+  cmTsMp1cH_t      qH;
+  pthread_mutex_t  mutex;     // serializes the producers so that the enqueue order is known
+  unsigned         ticket;    // ticket of the next msg to be enqueued
+  unsigned         fullCnt;   // count of times a producer queue was full
+  unsigned         recvCnt;   // count of msgs received
+  unsigned         errCnt;    // count of msgs received out of order
+} _cmTsMp1cTest_t;
 
-unsigned _cmTsMp1cVal = 0;
+typedef struct
+{
+  _cmTsMp1cTest_t* p;
+  unsigned         id;
+  unsigned         sendCnt;
+  volatile bool    doneFl;
+} _cmTsMp1cTestProducer_t;
 
-// Incr the global value _cmTsMp1cVal and put it in a TS queue
-bool _cmTsMp1cCb0(void* param)
+bool _cmTsMp1cTestProducer( void* arg )
 {
-  _cmTsMp1cCbParam_t* p = (_cmTsMp1cCbParam_t*)param;
+  _cmTsMp1cTestProducer_t* r = (_cmTsMp1cTestProducer_t*)arg;
+  _cmTsMp1cTest_t*         p = r->p;
+  _cmTsMp1cTestMsg_t       m;
 
-  //p->val = __sync_fetch_and_add(&_cmTsMp1cVal,1);
+  // exit the thread - this releases the producer queue
+  if( r->sendCnt == kTsMp1cTestMsgCnt )
+  {
+    _cmThStoreRelease(&r->doneFl,true);
+    return false;
+  }
 
-  cmThUIntIncr(&_cmTsMp1cVal,1);
-  p->val = _cmTsMp1cVal;
+  pthread_mutex_lock(&p->mutex);
 
-  // send the msg
-  if( cmTsMp1cEnqueueMsg( p->qH, p, sizeof(_cmTsMp1cCbParam_t)) == kOkThRC )
-    printf("in:%i %i\n",p->id,p->val);
+  // avoid the queue full error msg
+  if( cmTsMp1cAvailByteCount(p->qH) < 2*(sizeof(m)+kTsHdrByteCnt) )
+    ++p->fullCnt;
   else
-    printf("in error %i\n",p->id);
+  {
+    m.id  = r->id;
+    m.val = p->ticket;
+    
+    if( cmTsMp1cEnqueueMsg(p->qH,&m,sizeof(m)) == kOkThRC )
+    {
+      ++p->ticket;
+      ++r->sendCnt;
+    }
+  }
 
-  cmSleepUs(100*1000);
+  pthread_mutex_unlock(&p->mutex);
 
+  if( r->sendCnt % 64 == 0 )
+    cmSleepUs(100);
+  
   return true;
 }
 
-// Monitor a TS queue for incoming messages from _cmTsMp1cCb1()
-bool _cmTsMp1cCb1(void* param)
+cmRC_t _cmTsMp1cTestRecv( void* arg, unsigned msgByteCnt, const void* msgDataPtr )
 {
-  // the thread param is a ptr to the TS queue to monitor.
-  cmTsMp1cH_t*   qp = (cmTsMp1cH_t*)param;
-  cmThRC_t        rc;
-  _cmTsMp1cCbParam_t msg;
+  _cmTsMp1cTest_t*          p = (_cmTsMp1cTest_t*)arg;
+  const _cmTsMp1cTestMsg_t* m = (const _cmTsMp1cTestMsg_t*)msgDataPtr;
 
-  // dequeue any waiting messages
-  if((rc = cmTsMp1cDequeueMsg( *qp, &msg, sizeof(msg))) == kOkThRC )
-    printf("out - cons id:%i val:%i\n",msg.id,msg.val);
-  else
-  {
-    if( rc != kBufEmptyThRC )
-      printf("out error:%i\n", rc);
-  }
+  if( msgByteCnt != sizeof(*m) || m->val != p->recvCnt )
+    ++p->errCnt;
 
-  return true;
+  ++p->recvCnt;
+  return cmOkRC;
 }
 
-// Test the TS queue by starting sender threads (threads 0 & 1)
-// and a receiver thread (thread 2) and sending messages
-// from the sender to the receiver.
 void cmTsMp1cTest( cmRpt_t* rpt )
 {
-  cmThreadH_t th0=cmThreadNullHandle,th1=cmThreadNullHandle,th2=cmThreadNullHandle;
-  cmTsMp1cH_t q=cmTsMp1cNullHandle;
-  _cmTsMp1cCbParam_t param0, param1;
+  _cmTsMp1cTest_t         t;
+  _cmTsMp1cTestProducer_t r[ kTsMp1cTestThreadCnt ];
+  cmThreadH_t             thA[ kTsMp1cTestThreadCnt ];
+  unsigned                i,j,k;
+  unsigned                queueCnt = 0;
 
-  // create a TS Queue
-  if( cmTsMp1cCreate(&q,1000,NULL,NULL,rpt) != kOkThRC )
-    goto errLabel;
+  memset(&t,0,sizeof(t));
+  t.qH = cmTsMp1cNullHandle;
+  pthread_mutex_init(&t.mutex,NULL);
 
-  // create thread 0 - producer 0
-  param0.id = 0;
-  param0.qH = q;
-  if( cmThreadCreate(&th0,_cmTsMp1cCb0,&param0,rpt) != kOkThRC )
-    goto errLabel;
+  for(i=0; i<kTsMp1cTestThreadCnt; ++i)
+    thA[i] = cmThreadNullHandle;
 
-  // create thread 1 - producer 1
-  param1.id = 1;
-  param1.qH = q;
-  if( cmThreadCreate(&th1,_cmTsMp1cCb0,&param1,rpt) != kOkThRC )
+  if( cmTsMp1cCreate(&t.qH,4096,_cmTsMp1cTestRecv,&t,rpt) != kOkThRC )
     goto errLabel;
 
-  // create thread 2 - consumer 0
-  if( cmThreadCreate(&th2,_cmTsMp1cCb1,&q,rpt) != kOkThRC )
-    goto errLabel;
+  for(i=0; i<kTsMp1cTestWaveCnt; ++i)
+  {
+    // create and start a wave of producers
+    for(j=0; j<kTsMp1cTestThreadCnt; ++j)
+    {
+      r[j].p       = &t;
+      r[j].id      = i*kTsMp1cTestThreadCnt + j;
+      r[j].sendCnt = 0;
+      r[j].doneFl  = false;
 
-  // start thread 0
-  if( cmThreadPause(th0,0) != kOkThRC )
-    goto errLabel;
+      if( cmThreadCreate(thA + j,_cmTsMp1cTestProducer,r + j,rpt) != kOkThRC )
+        goto errLabel;
 
-  // start thread 1
-  if( cmThreadPause(th1,0) != kOkThRC )
-    goto errLabel;
+      cmThreadSetPauseTimeOutMicros(thA[j],1000);
 
-  // start thread 2
-  if( cmThreadPause(th2,0) != kOkThRC )
-    goto errLabel;
+      if( cmThreadPause(thA[j],0) != kOkThRC )
+        goto errLabel;
+    }
 
-  printf("any key to quit.");
-  getchar();
+    // receive msgs until all producers have exited and the queue is empty
+    for(k=0; true; ++k)
+    {
+      bool doneFl = true;
+      for(j=0; j<kTsMp1cTestThreadCnt; ++j)
+        doneFl = doneFl && _cmThLoadAcquire(&r[j].doneFl);
+
+      // alternate between single msg and batch dequeue
+      if( k % 2 )
+        cmTsMp1cDequeueAllMsgs(t.qH,cmInvalidCnt);
+      else
+        while( cmTsMp1cDequeueMsg(t.qH,NULL,0) == kOkThRC )
+        {}
+
+      if( doneFl && cmTsMp1cMsgWaiting(t.qH) == false )
+        break;
+      
+      cmSleepUs(50);
+    }
 
- 
- errLabel:
+    for(j=0; j<kTsMp1cTestThreadCnt; ++j)
+      if( cmThreadDestroy(thA + j) != kOkThRC )
+        goto errLabel;
+  }
 
-  if( cmThreadIsValid(th0) )
-    if( cmThreadDestroy(&th0) != kOkThRC )
-      printf("Error destroying thread 0\n");
+  queueCnt = 0;
+  {
+    cmTsMp1cBuf_t* b = _cmTsMp1cHandleToPtr(t.qH)->list;
+    for(; b!=NULL; b=b->link)
+      ++queueCnt;
+  }
 
-  if( cmThreadIsValid(th1) )
-    if( cmThreadDestroy(&th1) != kOkThRC )
-      printf("Error destroying thread 1\n");
+  cmRptPrintf(rpt,"producers:%i producer queues:%i sent:%i recv'd:%i out of order:%i full:%i\n",
+    kTsMp1cTestWaveCnt*kTsMp1cTestThreadCnt,queueCnt,t.ticket,t.recvCnt,t.errCnt,t.fullCnt);
 
-  if( cmThreadIsValid(th2) )
-    if( cmThreadDestroy(&th2) != kOkThRC )
-      printf("Error destroying thread 1\n");
+  if( t.errCnt > 0 || t.recvCnt != t.ticket || t.ticket != kTsMp1cTestWaveCnt*kTsMp1cTestThreadCnt*kTsMp1cTestMsgCnt )
+    cmRptPrintf(rpt,"FAIL\n");
 
-  if( cmTsMp1cIsValid(q) )
-    if( cmTsMp1cDestroy(&q) != kOkThRC )
+ errLabel:
+
+  for(j=0; j<kTsMp1cTestThreadCnt; ++j)
+    if( cmThreadIsValid(thA[j]) )
+      if( cmThreadDestroy(thA + j) != kOkThRC )
+        printf("Error destroying producer thread %i\n",j);
+
+  if( cmTsMp1cIsValid(t.qH) )
+    if( cmTsMp1cDestroy(&t.qH) != kOkThRC )
       printf("Error destroying queue\n");
-  
+
+  pthread_mutex_destroy(&t.mutex);
 }
 
 void cmSleepUs( unsigned microseconds )
@@ -24,7 +24,8 @@ extern "C" {
     kCVarSignalFailThRC, // 8
     kBufFullThRC,        // 9
     kBufEmptyThRC,       // 10
-    kBufTooSmallThRC     // 11
+    kBufTooSmallThRC,    // 11
+    kInvalidStateThRC    // 12
 
   };
 
@@ -114,6 +115,45 @@ extern "C" {
   cmThRC_t cmThreadMutexSignalCondVar( cmThreadMutexH_t h );
 
 
+  //)
+  //( { label:cmThreadPool file_desc:"Pool of worker threads for data parallel tasks." kw[parallel]}
+  //============================================================================
+  // A run consists of 'taskCnt' calls to a task function, func(arg,taskIdx), 
+  // where taskIdx is in [0,taskCnt).  The tasks are claimed, in order, by the
+  // idle worker threads and by the thread which waits for the run to complete.
+  // Since a task may be executed by any thread, per-task state (e.g. scratch 
+  // buffers) should be indexed by 'taskIdx' rather than associated with a thread.
+  //
+  // The worker threads block while the pool is idle.
+
+  typedef cmHandle_t cmThreadPoolH_t;
+
+  extern cmThreadPoolH_t cmThreadPoolNullHandle;
+
+  typedef void (*cmThreadPoolFunc_t)( void* arg, unsigned taskIdx );
+
+  // Create a pool with 'threadCnt' worker threads. If 'threadCnt' is 0 then all
+  // tasks are run by the thread which calls cmThreadPoolWait() or cmThreadPoolRun().
+  cmThRC_t cmThreadPoolCreate(  cmThreadPoolH_t* hp, unsigned threadCnt, cmRpt_t* rpt );
+  cmThRC_t cmThreadPoolDestroy( cmThreadPoolH_t* hp );
+  bool     cmThreadPoolIsValid( cmThreadPoolH_t h );
+
+  // Count of worker threads (not including the calling thread).
+  unsigned cmThreadPoolThreadCount( cmThreadPoolH_t h );
+
+  // Start a run and return without waiting for it to complete. Returns
+  // kInvalidStateThRC if the previous run has not been completed by cmThreadPoolWait().
+  cmThRC_t cmThreadPoolStart( cmThreadPoolH_t h, cmThreadPoolFunc_t func, void* arg, unsigned taskCnt );
+
+  // Run the tasks of the current run which have not yet been claimed by a worker
+  // and then block until the remaining tasks are complete.
+  cmThRC_t cmThreadPoolWait(  cmThreadPoolH_t h );
+
+  // cmThreadPoolStart() followed by cmThreadPoolWait().
+  cmThRC_t cmThreadPoolRun(   cmThreadPoolH_t h, cmThreadPoolFunc_t func, void* arg, unsigned taskCnt );
+
+  void     cmThreadPoolTest( cmRpt_t* rpt );
+
   //)
   //( { label:cmTsQueue file_desc:"Thread safe message queue." kw[parallel]}
   //============================================================================
@@ -205,9 +245,32 @@ extern "C" {
   // Single producer / Single consumer thread-safe queue.
   // These functions have identical semantics and return values
   // to the same named cmTsQueueXXXX() calls above.
+  //
+  // The queue is a wait-free ring buffer. The producer and consumer
+  // indexes are kept on separate cache lines and each side only reads
+  // the other side's index when the queue appears full (producer) or
+  // empty (consumer).  
+  //
+  // In addition to the copying enqueue/dequeue functions messages may be
+  // built in place with cmTs1p1cEnqueueReserve()/cmTs1p1cEnqueueCommit()
+  // and read in place, in batches, with cmTs1p1cDequeueSpan()/cmTs1p1cDequeueRelease().
 
   typedef cmHandle_t cmTs1p1cH_t;
 
+  // A contiguous span of messages returned from cmTs1p1cDequeueSpan(). 
+  // Use cmTsSpanNextMsg() to iterate through the messages.
+  typedef struct
+  {
+    const char* buf;      // first msg record in the span 
+    unsigned    byteCnt;  // count of bytes in the span (including msg record headers)
+    unsigned    msgCnt;   // count of msgs in the span
+  } cmTsSpan_t;
+
+  // Iterate through the msgs in a span. Set *offsRef to 0 prior to the first call.
+  // Returns a pointer to the next msg body and sets *msgByteCntRef to the msg length
+  // or returns NULL if there are no more msgs in the span. 
+  const void* cmTsSpanNextMsg( const cmTsSpan_t* s, unsigned* offsRef, unsigned* msgByteCntRef );
+
   extern cmTs1p1cH_t cmTs1p1cNullHandle;
 
   cmThRC_t   cmTs1p1cCreate(     cmTs1p1cH_t* hPtr, unsigned bufByteCnt, cmTsQueueCb_t cbFunc, void* cbArg, cmRpt_t* rpt );
@@ -220,12 +283,31 @@ extern "C" {
 
   cmThRC_t   cmTs1p1cEnqueueMsg( cmTs1p1cH_t  h, const void* dataPtr, unsigned byteCnt );
 
+  // Reserve space for a msg of 'byteCnt' bytes and return a pointer to the msg body.
+  // The msg is not visible to the consumer until cmTs1p1cEnqueueCommit() is called.
+  // Returns NULL if the space is not available.
+  void*      cmTs1p1cEnqueueReserve( cmTs1p1cH_t h, unsigned byteCnt );
+
+  // Publish the msg reserved by the previous call to cmTs1p1cEnqueueReserve(). 
+  // 'byteCnt' must be less than or equal to the reserved byte count.
+  cmThRC_t   cmTs1p1cEnqueueCommit(  cmTs1p1cH_t h, unsigned byteCnt );
+
   unsigned   cmTs1p1cAllocByteCount( cmTs1p1cH_t h );
 
   unsigned   cmTs1p1cAvailByteCount( cmTs1p1cH_t h );
 
   cmThRC_t   cmTs1p1cDequeueMsg( cmTs1p1cH_t  h,  void* dataPtr, unsigned byteCnt );
 
+  // Get the contiguous span of msgs at the front of the queue. The msgs
+  // remain in the queue until they are released with cmTs1p1cDequeueRelease().
+  // Returns the count of msgs in the span (0 if the queue is empty).
+  unsigned   cmTs1p1cDequeueSpan(    cmTs1p1cH_t h, cmTsSpan_t* s );
+  cmThRC_t   cmTs1p1cDequeueRelease( cmTs1p1cH_t h, const cmTsSpan_t* s );
+
+  // Deliver up to 'maxMsgCnt' waiting msgs via the queue callback function.
+  // Returns the count of msgs delivered. Use maxMsgCnt=cmInvalidCnt to deliver all waiting msgs.
+  unsigned   cmTs1p1cDequeueAllMsgs( cmTs1p1cH_t h, unsigned maxMsgCnt );
+
   bool       cmTs1p1cMsgWaiting( cmTs1p1cH_t h );
 
   unsigned   cmTs1p1cDequeueMsgByteCount( cmTs1p1cH_t h );
@@ -261,6 +343,15 @@ extern "C" {
   // Multiple producer / Single consumer thread-safe queue.
   // These functions have identical semantics and return values
   // to the same named cmTsQueueXXXX() calls above.
+  //
+  // Each producer thread is given its own cmTs1p1c queue the first
+  // time it enqueues a msg. The queue is recycled for use by another
+  // producer when the thread exits. Each msg is stamped with a global
+  // sequence number as it is enqueued and the consumer merges the 
+  // producer queues in sequence order. Msgs are therefore delivered 
+  // in the order they were enqueued across all producers. Note that
+  // a producer which is pre-empted between stamping and committing a
+  // msg delays the delivery of all later msgs until it is committed.
 
   typedef cmHandle_t cmTsMp1cH_t;
 
@@ -283,6 +374,10 @@ extern "C" {
 
   cmThRC_t   cmTsMp1cDequeueMsg( cmTsMp1cH_t  h,  void* dataPtr, unsigned byteCnt );
 
+  // Deliver up to 'maxMsgCnt' waiting msgs via the queue callback function.
+  // Returns the count of msgs delivered. Use maxMsgCnt=cmInvalidCnt to deliver all waiting msgs.
+  unsigned   cmTsMp1cDequeueAllMsgs( cmTsMp1cH_t h, unsigned maxMsgCnt );
+
   bool       cmTsMp1cMsgWaiting( cmTsMp1cH_t h );
 
   unsigned   cmTsMp1cDequeueMsgByteCount( cmTsMp1cH_t h );
@@ -39,11 +39,18 @@ void cmTimeGet( cmTimeSpec_t* t )
   
 }
 
+// cmTimeGet() is already based on the monotonic mach clock.
+void cmTimeGetMonotonic( cmTimeSpec_t* t )
+{ cmTimeGet(t); }
+
 #endif
 
 #ifdef OS_LINUX
 void cmTimeGet( cmTimeSpec_t* t )
 { clock_gettime(CLOCK_REALTIME,t); }
+
+void cmTimeGetMonotonic( cmTimeSpec_t* t )
+{ clock_gettime(CLOCK_MONOTONIC,t); }
 #endif
 
 // this assumes that the seconds have been normalized to a recent start time
@@ -62,6 +69,13 @@ unsigned cmTimeElapsedMicros( const cmTimeSpec_t* t0, const cmTimeSpec_t* t1 )
   return u1 - u0;
 }
 
+unsigned cmTimeElapsedNanos( const cmTimeSpec_t* t0, const cmTimeSpec_t* t1 )
+{
+  long long ds = t1->tv_sec  - t0->tv_sec;
+  long long dn = t1->tv_nsec - t0->tv_nsec;
+  return (unsigned)(ds * 1000000000LL + dn);
+}
+
 unsigned cmTimeAbsElapsedMicros( const cmTimeSpec_t*  t0, const cmTimeSpec_t* t1 )
 {
   if( cmTimeIsLTE(t0,t1) )
@@ -22,11 +22,19 @@ extern "C" {
   // Get the time 
   void cmTimeGet( cmTimeSpec_t* t );
 
+  // Get the time from a clock which is not affected by changes to the system time.
+  // Use this function when measuring short intervals (e.g. execution time).
+  void cmTimeGetMonotonic( cmTimeSpec_t* t );
+
   // Return the elapsed time (t1 - t0) in microseconds
   // t1 is assumed to be at a later time than t0.
   unsigned cmTimeElapsedMicros( const cmTimeSpec_t*  t0, const cmTimeSpec_t* t1 );
 
   
+  // Return the elapsed time (t1 - t0) in nanoseconds. 
+  // t1 is assumed to be at a later time than t0 and the interval must be less than 4 seconds.
+  unsigned cmTimeElapsedNanos( const cmTimeSpec_t*  t0, const cmTimeSpec_t* t1 );
+
   // Same as cmTimeElapsedMicros() but the times are not assumed to be ordered.
   // The function therefore begins by swapping t1 and t0 if t0 is after t1.
   unsigned cmTimeAbsElapsedMicros( const cmTimeSpec_t*  t0, const cmTimeSpec_t* t1 ); 
@@ -704,7 +704,8 @@ cmXmlRC_t cmXmlParse( cmXmlH_t h, const cmChar_t* fn )
 
   cmMemPtrFree(&p->b);
   
-  if( (p->b = cmFileFnToBuf(fn, p->err.rpt, &p->bn )) == NULL )
+  // the lexer reads the character following the last character in the file
+  if( (p->b = cmFileFnToStr(fn, p->err.rpt, &p->bn )) == NULL )
   {
     rc = cmErrMsg(&p->err,kMemAllocErrXmlRC,"Unable to buffer the file '%s'.",cmStringNullGuard(fn));
     goto errLabel;
@@ -1221,3 +1222,698 @@ cmXmlRC_t cmXmlTest( cmCtx_t* ctx, const cmChar_t* fn )
   
   return rc;  
 }
+
+//------------------------------------------------------------------------------------------
+// Streaming reader
+//------------------------------------------------------------------------------------------
+
+cmXmlRdH_t cmXmlRdNullHandle = cmSTATIC_NULL_HANDLE;
+
+enum
+{
+  kDfltBufCharCntXmlRd = 65536
+};
+
+typedef struct
+{
+  cmErr_t      err;
+  cmFileH_t    fH;      // XML file
+  unsigned     fileN;   // count of file bytes not yet read into b[]
+
+  cmChar_t*    b;       // b[bN+1] read window
+  unsigned     bN;      //
+  cmChar_t*    c;       // current position in b[]
+  cmChar_t*    e;       // end of the valid text in b[] (*e is always 0)
+  unsigned     line;    // line number at 'c'
+  bool         tagFl;   // c[] begins a tag whose leading '<' was overwritten by a data string terminator
+
+  cmXmlAttr_t* attrV;   // attrV[attrN] attributes of the last begin tag
+  unsigned     attrN;   //
+
+  cmChar_t*    lblV;    // lblV[lblN] labels of the open elements
+  unsigned     lblN;    //
+  unsigned     lblCnt;  // count of characters in use in lblV[]
+  unsigned*    depthV;  // depthV[depthN] offset into lblV[] of the label of each open element
+  unsigned     depthN;  //
+  unsigned     depth;   // count of open elements
+  bool         closeFl; // the last begin tag was self-closing - the next event is its end tag
+
+  cmChar_t*    textV;   // textV[textN] cmXmlRdText() buffer
+  unsigned     textN;   //
+} cmXmlRd_t;
+
+cmXmlRd_t* _cmXmlRdHandleToPtr( cmXmlRdH_t h )
+{
+  cmXmlRd_t* p = (cmXmlRd_t*)h.h;
+  assert( p != NULL );
+  return p;
+}
+
+cmXmlRC_t _cmXmlRdFree( cmXmlRd_t* p )
+{
+  cmXmlRC_t rc = kOkXmlRC;
+
+  if( cmFileClose(&p->fH) != kOkFileRC )
+    rc = cmErrMsg(&p->err,kFileFailXmlRC,"XML file close failed.");
+
+  cmMemFree(p->b);
+  cmMemFree(p->attrV);
+  cmMemFree(p->lblV);
+  cmMemFree(p->depthV);
+  cmMemFree(p->textV);
+  cmMemFree(p);
+
+  return rc;
+}
+
+cmXmlRC_t cmXmlRdOpen( cmCtx_t* ctx, cmXmlRdH_t* hp, const cmChar_t* fn, unsigned bufCharCnt )
+{
+  cmXmlRC_t  rc;
+  cmXmlRd_t* p;
+
+  if((rc = cmXmlRdClose(hp)) != kOkXmlRC )
+    return rc;
+
+  if((p = cmMemAllocZ( cmXmlRd_t, 1 )) == NULL )
+    return cmErrMsg(&ctx->err,kMemAllocErrXmlRC,"Object memory allocation failed.");
+
+  cmErrSetup(&p->err,&ctx->rpt,"XML Reader");
+
+  if( cmFileOpen(&p->fH,fn,kReadFileFl,p->err.rpt) != kOkFileRC )
+  {
+    rc = cmErrMsg(&p->err,kFileFailXmlRC,"Unable to open the XML file '%s'.",cmStringNullGuard(fn));
+    goto errLabel;
+  }
+
+  p->fileN = cmFileByteCount(p->fH);
+  p->bN    = bufCharCnt==0 ? kDfltBufCharCntXmlRd : bufCharCnt;
+  p->b     = cmMemAlloc(cmChar_t,p->bN+1);
+  p->c     = p->b;
+  p->e     = p->b;
+  *p->e    = 0;
+  p->line  = 1;
+
+  hp->h = p;
+
+ errLabel:
+  if( rc != kOkXmlRC )
+    _cmXmlRdFree(p);
+
+  return rc;
+}
+
+cmXmlRC_t cmXmlRdClose( cmXmlRdH_t* hp )
+{
+  cmXmlRC_t rc = kOkXmlRC;
+
+  if( hp == NULL || cmXmlRdIsValid(*hp)==false )
+    return rc;
+
+  cmXmlRd_t* p = _cmXmlRdHandleToPtr(*hp);
+
+  if((rc = _cmXmlRdFree(p)) != kOkXmlRC )
+    return rc;
+
+  hp->h = NULL;
+
+  return rc;
+}
+
+bool cmXmlRdIsValid( cmXmlRdH_t h )
+{ return h.h != NULL; }
+
+// Move the unread text to the front of the window and append the next block
+// of the file. The window is doubled in size if the unread text already fills it.
+// *nRef is set to the count of characters read. It is 0 at the end of the file.
+cmXmlRC_t _cmXmlRdFill( cmXmlRd_t* p, unsigned* nRef )
+{
+  unsigned n = p->e - p->c;
+  unsigned cn;
+
+  *nRef = 0;
+
+  if( p->fileN == 0 )
+    return kOkXmlRC;
+
+  if( p->c > p->b )
+  {
+    memmove(p->b,p->c,n);
+    p->c = p->b;
+    p->e = p->b + n;
+  }
+
+  if( n == p->bN )
+  {
+    p->bN *= 2;
+    p->b   = cmMemResizeP(cmChar_t,p->b,p->bN+1);
+    p->c   = p->b;
+    p->e   = p->b + n;
+  }
+
+  cn = cmMin(p->bN - n, p->fileN);
+
+  if( cmFileRead(p->fH,p->e,cn) != kOkFileRC )
+    return cmErrMsg(&p->err,kFileFailXmlRC,"XML file read failed.");
+
+  p->fileN -= cn;
+  p->e     += cn;
+  *p->e     = 0;
+  *nRef     = cn;
+
+  return kOkXmlRC;
+}
+
+// Advance p->c to 'c' and count the lines which were passed over.
+void _cmXmlRdAdvance( cmXmlRd_t* p, cmChar_t* c )
+{
+  const cmChar_t* s = p->c;
+
+  while((s = memchr(s,'\n',c-s)) != NULL )
+  {
+    ++p->line;
+    ++s;
+  }
+
+  p->c = c;
+}
+
+// Return a pointer to the first occurrence of 'str' in s[] before p->e or NULL if it does not occur.
+cmChar_t* _cmXmlRdFind( cmXmlRd_t* p, cmChar_t* s, const cmChar_t* str )
+{
+  unsigned n = strlen(str);
+
+  while( p->e - s >= n )
+  {
+    if((s = memchr(s,str[0],(p->e - s) - n + 1)) == NULL )
+      break;
+
+    if( strncmp(s,str,n) == 0 )
+      return s;
+
+    ++s;
+  }
+  return NULL;
+}
+
+// Return a pointer to the '>' which ends the tag beginning at 'lt' or
+// NULL if the end of the tag is not in the window.
+cmChar_t* _cmXmlRdTagEnd( cmXmlRd_t* p, cmChar_t* lt )
+{
+  cmChar_t* s = lt + 1;
+  unsigned  n = p->e - s;
+  unsigned  brackN = 0;
+
+  if( n>=3 && strncmp(s,"!--",3)==0 )
+    return (s = _cmXmlRdFind(p,s+3,"-->")) == NULL ? NULL : s+2;
+
+  if( n>=8 && strncmp(s,"![CDATA[",8)==0 )
+    return (s = _cmXmlRdFind(p,s+8,"]]>")) == NULL ? NULL : s+2;
+
+  if( *s == '?' )
+    return (s = _cmXmlRdFind(p,s+1,"?>")) == NULL ? NULL : s+1;
+
+  // Other tags may contain quoted strings with embedded '>' characters
+  // and a DOCTYPE may contain a bracketed internal subset.
+  for(; s<p->e; ++s)
+    switch( *s )
+    {
+      case '>':
+        if( brackN == 0 )
+          return s;
+        break;
+
+      case '[':
+        brackN += lt[1]=='!';
+        break;
+
+      case ']':
+        brackN -= brackN > 0;
+        break;
+
+      case '"':
+      case '\'':
+        if((s = memchr(s+1,*s,p->e - (s+1))) == NULL )
+          return NULL;
+        break;
+    }
+
+  return NULL;
+}
+
+cmChar_t* _cmXmlRdSkipSpace( cmChar_t* s )
+{
+  while( isspace((unsigned char)*s) )
+    ++s;
+  return s;
+}
+
+// Fill an end tag event from the top of the label stack and pop the stack.
+void _cmXmlRdPop( cmXmlRd_t* p, cmXmlEvent_t* e, unsigned line )
+{
+  assert( p->depth > 0 );
+
+  e->typeId  = kEndXmlRdId;
+  e->line    = line;
+  e->depth   = p->depth;
+  e->label   = p->lblV + p->depthV[ p->depth-1 ];
+  p->depth  -= 1;
+  p->lblCnt  = p->depthV[ p->depth ];
+}
+
+// Parse the begin tag in lt[] and push its label on the label stack.
+// 'te' points to the tag's ending '>'.
+cmXmlRC_t _cmXmlRdBegTag( cmXmlRd_t* p, cmChar_t* lt, cmChar_t* te, unsigned line, cmXmlEvent_t* e )
+{
+  cmChar_t* s       = lt + 1;
+  cmChar_t* l0      = s;
+  unsigned  attrCnt = 0;
+  unsigned  n, i;
+
+  // if this is a self-closing tag
+  if((p->closeFl = te[-1]=='/' && te-1 > s) )
+    te -= 1;
+
+  // terminate the tag text
+  *te = 0;
+
+  // locate the end of the label
+  while( *s && !isspace((unsigned char)*s) )
+    ++s;
+
+  if( s == l0 )
+    return cmErrMsg(&p->err,kSyntaxErrorXmlRC,"Missing tag label on line %i.",line);
+
+  if( *s )
+    *s++ = 0;
+
+  // parse the attribute list
+  while( *(s = _cmXmlRdSkipSpace(s)) )
+  {
+    cmChar_t* a0 = s;
+    cmChar_t* a1;
+    cmChar_t* v0;
+
+    while( *s && *s!='=' && !isspace((unsigned char)*s) )
+      ++s;
+
+    a1 = s;
+    s  = _cmXmlRdSkipSpace(s);
+
+    if( *s != '=' )
+      return cmErrMsg(&p->err,kSyntaxErrorXmlRC,"The attribute '%.*s' on line %i does not have a value.",(int)(a1-a0),a0,line);
+
+    s = _cmXmlRdSkipSpace(s+1);
+
+    // values may be quoted with either single or double quotes
+    if( *s=='"' || *s=='\'' )
+    {
+      cmChar_t* q;
+      if((q = strchr(s+1,*s)) == NULL )
+        return cmErrMsg(&p->err,kSyntaxErrorXmlRC,"Unterminated attribute value on line %i.",line);
+
+      v0 = s+1;
+      *q = 0;
+      s  = q+1;
+    }
+    else
+    {
+      v0 = s;
+      while( *s && !isspace((unsigned char)*s) )
+        ++s;
+
+      if( *s )
+        *s++ = 0;
+    }
+
+    *a1 = 0;
+
+    if( attrCnt == p->attrN )
+    {
+      p->attrN = cmMax(8,p->attrN*2);
+      p->attrV = cmMemResizeP(cmXmlAttr_t,p->attrV,p->attrN);
+    }
+
+    p->attrV[attrCnt].label = a0;
+    p->attrV[attrCnt].value = v0;
+    ++attrCnt;
+  }
+
+  for(i=0; i<attrCnt; ++i)
+    p->attrV[i].link = i+1<attrCnt ? p->attrV + i + 1 : NULL;
+
+  // push the label on the label stack
+  n = strlen(l0) + 1;
+
+  if( p->lblCnt + n > p->lblN )
+  {
+    p->lblN = cmMax(p->lblN*2,p->lblCnt + n + 256);
+    p->lblV = cmMemResizeP(cmChar_t,p->lblV,p->lblN);
+  }
+
+  if( p->depth == p->depthN )
+  {
+    p->depthN = cmMax(32,p->depthN*2);
+    p->depthV = cmMemResizeP(unsigned,p->depthV,p->depthN);
+  }
+
+  p->depthV[ p->depth++ ] = p->lblCnt;
+  memcpy(p->lblV + p->lblCnt, l0, n );
+  p->lblCnt += n;
+
+  e->typeId = kBegXmlRdId;
+  e->line   = line;
+  e->depth  = p->depth;
+  e->label  = l0;
+  e->attr   = attrCnt==0 ? NULL : p->attrV;
+
+  return kOkXmlRC;
+}
+
+// Parse the end tag in lt[] and pop the label stack.
+cmXmlRC_t _cmXmlRdEndTag( cmXmlRd_t* p, cmChar_t* lt, cmChar_t* te, unsigned line, cmXmlEvent_t* e )
+{
+  cmChar_t* l0 = lt + 2;
+  cmChar_t* l1 = te;
+
+  // trim trailing space from the label
+  while( l1 > l0 && isspace((unsigned char)l1[-1]) )
+    --l1;
+
+  *l1 = 0;
+
+  if( p->depth == 0 )
+    return cmErrMsg(&p->err,kSyntaxErrorXmlRC,"The end tag '%s' on line %i does not have a begin tag.",l0,line);
+
+  if( strcmp(l0, p->lblV + p->depthV[ p->depth-1 ]) != 0 )
+    return cmErrMsg(&p->err,kSyntaxErrorXmlRC,"The end tag '%s' on line %i does not match the begin tag '%s'.",l0,line,p->lblV + p->depthV[ p->depth-1 ]);
+
+  _cmXmlRdPop(p,e,line);
+
+  return kOkXmlRC;
+}
+
+cmXmlRC_t cmXmlRdNext( cmXmlRdH_t h, cmXmlEvent_t* e )
+{
+  cmXmlRC_t  rc = kOkXmlRC;
+  cmXmlRd_t* p  = _cmXmlRdHandleToPtr(h);
+
+  memset(e,0,sizeof(*e));
+
+  // a self-closing tag is followed by its end tag
+  if( p->closeFl )
+  {
+    p->closeFl = false;
+    _cmXmlRdPop(p,e,p->line);
+    return rc;
+  }
+
+  while(1)
+  {
+    cmChar_t* lt;
+    cmChar_t* te;
+    unsigned  line;
+    unsigned  n;
+
+    // leading white space is never part of a data string
+    if( !p->tagFl )
+      _cmXmlRdAdvance(p,_cmXmlRdSkipSpace(p->c));
+
+    // locate the start of the next tag
+    if( p->tagFl )
+      lt = p->c;
+    else
+      if((lt = memchr(p->c,'<',p->e - p->c)) == NULL )
+      {
+        if((rc = _cmXmlRdFill(p,&n)) != kOkXmlRC )
+          return rc;
+
+        if( n > 0 )
+          continue;
+
+        // the end of the file was encountered
+        if( p->depth > 0 )
+          return cmErrMsg(&p->err,kSyntaxErrorXmlRC,"Unexpected end of file. The element '%s' is not closed.",p->lblV + p->depthV[ p->depth-1 ]);
+
+        _cmXmlRdAdvance(p,p->e);
+
+        e->typeId = kEofXmlRdId;
+        e->line   = p->line;
+        return rc;
+      }
+
+    // if data text precedes the tag
+    if( lt > p->c )
+    {
+      // text outside of the outermost element is ignored
+      if( p->depth == 0 )
+        _cmXmlRdAdvance(p,lt);
+      else
+      {
+        e->typeId = kDataXmlRdId;
+        e->line   = p->line;
+        e->depth  = p->depth;
+        e->text   = p->c;
+
+        // terminate the text by overwriting the tag's leading '<'
+        _cmXmlRdAdvance(p,lt);
+        *lt      = 0;
+        p->tagFl = true;
+        return rc;
+      }
+    }
+
+    // locate the end of the tag
+    if((te = _cmXmlRdTagEnd(p,lt)) == NULL )
+    {
+      if((rc = _cmXmlRdFill(p,&n)) != kOkXmlRC )
+        return rc;
+
+      if( n == 0 )
+        return cmErrMsg(&p->err,kSyntaxErrorXmlRC,"Unterminated tag on line %i.",p->line);
+
+      continue;
+    }
+
+    line     = p->line;
+    p->tagFl = false;
+
+    // count the lines in the tag before it is modified
+    _cmXmlRdAdvance(p,te+1);
+
+    switch( lt[1] )
+    {
+      case '/':
+        return _cmXmlRdEndTag(p,lt,te,line,e);
+
+      case '?':
+        break; // skip declarations
+
+      case '!':
+        // CDATA sections are reported as data
+        if( strncmp(lt+2,"[CDATA[",7)==0 && p->depth > 0 )
+        {
+          te[-2]    = 0;
+          e->typeId = kDataXmlRdId;
+          e->line   = line;
+          e->depth  = p->depth;
+          e->text   = lt + 9;
+          return rc;
+        }
+        break;  // skip comments and DOCTYPE's
+
+      default:
+        return _cmXmlRdBegTag(p,lt,te,line,e);
+    }
+  }
+
+  return rc;
+}
+
+cmXmlRC_t cmXmlRdSkip( cmXmlRdH_t h )
+{
+  cmXmlRC_t    rc    = kOkXmlRC;
+  cmXmlRd_t*   p     = _cmXmlRdHandleToPtr(h);
+  unsigned     depth = p->depth;
+  cmXmlEvent_t e;
+
+  do
+  {
+    if((rc = cmXmlRdNext(h,&e)) != kOkXmlRC )
+      break;
+
+  }while( e.typeId != kEofXmlRdId && (e.typeId != kEndXmlRdId || e.depth != depth) );
+
+  return rc;
+}
+
+cmXmlRC_t cmXmlRdText( cmXmlRdH_t h, const cmChar_t** textRef )
+{
+  cmXmlRC_t    rc      = kOkXmlRC;
+  cmXmlRd_t*   p       = _cmXmlRdHandleToPtr(h);
+  unsigned     depth   = p->depth;
+  bool         childFl = false;
+  cmXmlEvent_t e;
+
+  *textRef = NULL;
+
+  do
+  {
+    if((rc = cmXmlRdNext(h,&e)) != kOkXmlRC )
+      break;
+
+    switch( e.typeId )
+    {
+      case kBegXmlRdId:
+        childFl = true;
+        break;
+
+      case kDataXmlRdId:
+        // only text which precedes the element's first child is the element's data text
+        if( e.depth == depth && childFl == false && *textRef == NULL )
+        {
+          unsigned n = strlen(e.text) + 1;
+
+          if( n > p->textN )
+          {
+            p->textN = cmMax(n,64);
+            p->textV = cmMemResize(cmChar_t,p->textV,p->textN);
+          }
+
+          memcpy(p->textV,e.text,n);
+          *textRef = p->textV;
+        }
+        break;
+    }
+
+  }while( e.typeId != kEofXmlRdId && (e.typeId != kEndXmlRdId || e.depth != depth) );
+
+  return rc;
+}
+
+const cmChar_t* cmXmlRdAttrValue( const cmXmlEvent_t* e, const cmChar_t* label )
+{
+  const cmXmlAttr_t* a = e->attr;
+  for(; a!=NULL; a=a->link)
+    if( strcmp(a->label,label) == 0 )
+      return a->value;
+
+  return NULL;
+}
+
+bool _cmXmlRdTestIsEqualAttr( const cmXmlNode_t* np, const cmXmlEvent_t* e )
+{
+  const cmXmlAttr_t* a  = np->attr;
+  unsigned           n0 = 0;
+  unsigned           n1 = 0;
+
+  for(; a!=NULL; a=a->link,++n0)
+  {
+    // the tree stores empty attribute values as NULL
+    const cmChar_t* v = cmXmlRdAttrValue(e,a->label);
+    if( v == NULL || strcmp(v, a->value==NULL ? "" : a->value) )
+      return false;
+  }
+
+  for(a=e->attr; a!=NULL; a=a->link)
+    ++n1;
+
+  return n0 == n1;
+}
+
+// Verify that the events which follow the begin tag of 'np' match the node's
+// data string, child nodes and end tag.  The root node is ended by the end of the file.
+cmXmlRC_t _cmXmlRdTestNode( cmErr_t* err, cmXmlRdH_t h, const cmXmlNode_t* np, unsigned* evtCntRef )
+{
+  cmXmlRC_t          rc      = kOkXmlRC;
+  const cmXmlNode_t* cnp     = np->children;
+  bool               childFl = false;
+  bool               dataFl  = false;
+  cmXmlEvent_t       e;
+
+  while((rc = cmXmlRdNext(h,&e)) == kOkXmlRC )
+  {
+    *evtCntRef += 1;
+
+    switch( e.typeId )
+    {
+      case kDataXmlRdId:
+        // the tree only stores text which precedes the first child node
+        if( childFl == false )
+        {
+          if( dataFl || np->dataStr==NULL || strcmp(np->dataStr,e.text) )
+            return cmErrMsg(err,kTestFailXmlRC,"Data text mismatch on line %i.",e.line);
+
+          dataFl = true;
+        }
+        break;
+
+      case kBegXmlRdId:
+        // skip declaration and DOCTYPE nodes
+        while( cnp != NULL && cmIsNotFlag(cnp->flags,kNormalXmlFl) )
+          cnp = cnp->sibling;
+
+        if( cnp==NULL || strcmp(cnp->label,e.label) || !_cmXmlRdTestIsEqualAttr(cnp,&e) )
+          return cmErrMsg(err,kTestFailXmlRC,"Begin tag '%s' mismatch on line %i.",e.label,e.line);
+
+        childFl = true;
+
+        if((rc = _cmXmlRdTestNode(err,h,cnp,evtCntRef)) != kOkXmlRC )
+          return rc;
+
+        cnp = cnp->sibling;
+        break;
+
+      case kEndXmlRdId:
+      case kEofXmlRdId:
+        while( cnp != NULL && cmIsNotFlag(cnp->flags,kNormalXmlFl) )
+          cnp = cnp->sibling;
+
+        if( cnp != NULL )
+          return cmErrMsg(err,kTestFailXmlRC,"The node '%s' on line %i was not found in the event stream.",cnp->label,cnp->line);
+
+        if( (e.typeId==kEofXmlRdId) != cmIsFlag(np->flags,kRootXmlFl) || (e.typeId==kEndXmlRdId && strcmp(e.label,np->label)) )
+          return cmErrMsg(err,kTestFailXmlRC,"Unexpected end tag on line %i.",e.line);
+
+        if( np->dataStr != NULL && dataFl==false )
+          return cmErrMsg(err,kTestFailXmlRC,"The data text for '%s' on line %i was not found in the event stream.",np->label,np->line);
+
+        return rc;
+    }
+  }
+
+  return rc;
+}
+
+cmXmlRC_t cmXmlRdTest( cmCtx_t* ctx, const cmChar_t* fn )
+{
+  cmXmlRC_t  rc     = kOkXmlRC;
+  cmXmlH_t   h      = cmXmlNullHandle;
+  cmXmlRdH_t rdH    = cmXmlRdNullHandle;
+  unsigned   bufNV[] = { 0, 16 };
+  unsigned   i;
+
+  if((rc = cmXmlAlloc(ctx, &h, fn )) != kOkXmlRC )
+    return cmErrMsg(&ctx->err,rc,"XML alloc failed.");
+
+  for(i=0; i<sizeof(bufNV)/sizeof(bufNV[0]); ++i)
+  {
+    unsigned evtCnt = 0;
+
+    if((rc = cmXmlRdOpen(ctx,&rdH,fn,bufNV[i])) != kOkXmlRC )
+      goto errLabel;
+
+    if((rc = _cmXmlRdTestNode(&ctx->err,rdH,cmXmlRoot(h),&evtCnt)) != kOkXmlRC )
+      goto errLabel;
+
+    cmRptPrintf(&ctx->rpt,"window:%i events:%i pass\n",bufNV[i],evtCnt);
+
+    if((rc = cmXmlRdClose(&rdH)) != kOkXmlRC )
+      goto errLabel;
+  }
+
+ errLabel:
+  cmXmlRdClose(&rdH);
+  cmXmlFree(&h);
+
+  return rc;
+}
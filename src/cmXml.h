@@ -17,7 +17,8 @@ extern "C" {
     kSyntaxErrorXmlRC,
     kTestFailXmlRC,
     kInvalidTypeXmlRC,
-    kNodeNotFoundXmlRC
+    kNodeNotFoundXmlRC,
+    kFileFailXmlRC
   }; 
   
   typedef struct cmXmlAttr_str
@@ -107,6 +108,76 @@ extern "C" {
   cmXmlRC_t cmXmlTest( cmCtx_t* ctx, const cmChar_t* fn );
 
   //)
+
+  //( { label:cmXmlRd file_desc:"Streaming (pull) XML reader." kw[file] }
+  //
+  // cmXmlRdNext() returns the elements of an XML file as a sequence of
+  // begin-tag, data and end-tag events without building a tree.
+  // The file is read through a fixed size window which only grows if a
+  // single tag does not fit in it.  Memory use is therefore independent
+  // of the size of the file.
+  //
+  // The label, text and attribute strings referenced by an event
+  // point into the reader's window and remain valid only until the
+  // next call to a cmXmlRdXXX() function.
+  //
+  // Data events follow the conventions of the XML tree (cmXmlNode_t.dataStr):
+  // white space only text is not reported, leading white space is removed
+  // and entities are not decoded.  CDATA sections are reported verbatim.
+  // Comments, declarations and DOCTYPE's are skipped.
+  // A self-closing tag (<tag/>) produces a begin-tag event followed by an end-tag event.
+
+  enum
+  {
+    kEofXmlRdId,    // end of file
+    kBegXmlRdId,    // begin tag
+    kEndXmlRdId,    // end tag
+    kDataXmlRdId    // element data text
+  };
+
+  typedef struct
+  {
+    unsigned           typeId; // See k???XmlRdId
+    unsigned           line;   // line number of the event
+    unsigned           depth;  // depth of the element (the outermost element is at depth 1)
+    const cmChar_t*    label;  // element label (kBegXmlRdId and kEndXmlRdId)
+    const cmChar_t*    text;   // data text (kDataXmlRdId)
+    const cmXmlAttr_t* attr;   // attribute list in document order (kBegXmlRdId)
+  } cmXmlEvent_t;
+
+  typedef cmHandle_t cmXmlRdH_t;
+
+  extern cmXmlRdH_t cmXmlRdNullHandle;
+
+  // Set 'bufCharCnt' to 0 to use the default window size.
+  cmXmlRC_t       cmXmlRdOpen(    cmCtx_t* ctx, cmXmlRdH_t* hp, const cmChar_t* fn, unsigned bufCharCnt );
+  cmXmlRC_t       cmXmlRdClose(   cmXmlRdH_t* hp );
+  bool            cmXmlRdIsValid( cmXmlRdH_t h );
+
+  // Return the next event from the file. After the kEofXmlRdId event is
+  // returned all further calls also return kEofXmlRdId.
+  cmXmlRC_t       cmXmlRdNext(    cmXmlRdH_t h, cmXmlEvent_t* e );
+
+  // Consume the remainder of the element opened by the last kBegXmlRdId
+  // event including its end tag.
+  cmXmlRC_t       cmXmlRdSkip(    cmXmlRdH_t h );
+
+  // Consume the remainder of the element opened by the last kBegXmlRdId
+  // event including its end tag and return the element's data text in *textRef.
+  // As with cmXmlNode_t.dataStr *textRef is set to NULL if the element
+  // body does not begin with text. The returned string is valid until the
+  // next call to cmXmlRdText().
+  cmXmlRC_t       cmXmlRdText(    cmXmlRdH_t h, const cmChar_t** textRef );
+
+  // Return the value of the attribute 'label' from a kBegXmlRdId event or NULL if the attribute does not exist.
+  const cmChar_t* cmXmlRdAttrValue( const cmXmlEvent_t* e, const cmChar_t* label );
+
+  // Verify that the event stream of 'fn' matches the tree produced by cmXmlParse()
+  // using both the default window size and a window small enough to force
+  // tags to be split across reads.
+  cmXmlRC_t       cmXmlRdTest( cmCtx_t* ctx, const cmChar_t* fn );
+
+  //)
   
 #ifdef __cpluspus
 }
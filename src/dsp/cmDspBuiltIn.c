@@ -5642,6 +5642,7 @@ cmDspClassConsFunc_t _cmDspClassBuiltInArray[] =
   cmPresetClassCons,
   cmBcastSymClassCons,
   cmSegLineClassCons,
+  cmConvolveClassCons,
 
   cmKrClassCons,
   cmKr2ClassCons,
@@ -6830,3 +6830,287 @@ cmDspClass_t* cmSegLineClassCons( cmDspCtx_t* ctx )
 }
 
 //)
+//( { label:cmDspConvolve file_desc:"Partitioned convolution with an impulse response read from an audio file." kw:[sunit] }
+enum
+{
+  kFnCvId,
+  kChCvId,
+  kTailCvId,
+  kGainCvId,
+  kBypassCvId,
+  kInCvId,
+  kOutCvId
+};
+
+cmDspClass_t _cmConvolveDC;
+
+enum { kFnCharCnt = 1024 };
+
+// The impulse response is read and the convolver is created by a background
+// loader thread. The audio thread owns 'cnv' and swaps in 'nxtCnv' when the
+// loader signals that it is complete. The replaced convolver is released by
+// the next load (or by _cmDspConvolveFree()) so that the audio thread never
+// frees memory or destroys threads.
+typedef struct
+{
+  cmDspInst_t     inst;
+  cmDspCtx_t*     ctx;
+  cmConvolve*     cnv;      // convolver in use by the audio thread
+  cmConvolve*     nxtCnv;   // convolver created by the loader
+  cmConvolve*     oldCnv;   // convolver replaced by nxtCnv - released by the loader
+  cmThreadPoolH_t poolH;    // single worker pool which runs the loader
+  bool            reqFl;    // a load has been requested by _cmDspConvolveRecv()
+  bool            loadFl;   // the loader has been started and not yet waited for
+  volatile bool   doneFl;   // set by the loader when nxtCnv is ready
+  cmChar_t        fn[ kFnCharCnt ]; // copy of the load parameters made when the loader was started
+  unsigned        chIdx;    //
+  unsigned        tailN;    //
+} cmDspConvolve_t;
+
+// Read the impulse response and create a convolver from the parameters in p->fn, p->chIdx and p->tailN.
+// Note that this function reads the impulse response file and may start a thread
+// and is therefore not real-time safe.
+cmDspRC_t _cmDspConvolveLoad( cmDspCtx_t* ctx, cmDspConvolve_t* p, cmConvolve** cnvRef )
+{
+  const cmChar_t*   fn     = p->fn;
+  cmSample_t*       h      = NULL;
+  unsigned          hn     = 0;
+  cmDspRC_t         rc     = kOkDspRC;
+  cmAudioFileInfo_t afInfo;
+
+  *cnvRef = NULL;
+
+  if( strlen(fn) == 0 )
+    return kOkDspRC;
+
+  if( cmAudioFileGetInfo(fn,&afInfo,ctx->rpt) != kOkAfRC )
+    return cmDspInstErr(ctx,&p->inst,kInvalidArgDspRC,"The impulse response file '%s' could not be opened.",fn);
+
+  if( p->chIdx >= afInfo.chCnt )
+    return cmDspInstErr(ctx,&p->inst,kInvalidArgDspRC,"The impulse response channel index %i is invalid for the %i channel file '%s'.",p->chIdx,afInfo.chCnt,fn);
+
+  h = cmMemAllocZ(cmSample_t,afInfo.frameCnt);
+
+  if( cmAudioFileGetSample(fn,0,afInfo.frameCnt,p->chIdx,1,&h,&hn,NULL,ctx->rpt) != kOkAfRC )
+  {
+    rc = cmDspInstErr(ctx,&p->inst,kInvalidArgDspRC,"The impulse response file '%s' read failed.",fn);
+    goto errLabel;
+  }
+
+  if((*cnvRef = cmConvolveAllocTail(ctx->cmProcCtx,NULL,h,hn,cmDspSamplesPerCycle(ctx),p->tailN)) == NULL )
+    rc = cmDspInstErr(ctx,&p->inst,kSubSysFailDspRC,"The convolver initialization failed.");
+
+ errLabel:
+  cmMemFree(h);
+  return rc;
+}
+
+// Copy the load parameters from the instance variables.
+cmDspRC_t _cmDspConvolveGetParams( cmDspCtx_t* ctx, cmDspConvolve_t* p )
+{
+  const cmChar_t* fn = cmDspStrcz(&p->inst,kFnCvId);
+
+  p->chIdx = cmDspUInt(&p->inst,kChCvId);
+  p->tailN = cmDspUInt(&p->inst,kTailCvId);
+  p->fn[0] = 0;
+
+  if( fn == NULL )
+    return kOkDspRC;
+
+  if( strlen(fn) >= kFnCharCnt )
+    return cmDspInstErr(ctx,&p->inst,kInvalidArgDspRC,"The impulse response file name '%s' is too long.",fn);
+
+  strcpy(p->fn,fn);
+  return kOkDspRC;
+}
+
+// Loader task - runs on the pool worker thread.
+void _cmDspConvolveLoadTask( void* arg, unsigned taskIdx )
+{
+  cmDspConvolve_t* p = (cmDspConvolve_t*)arg;
+
+  cmConvolveFree(&p->oldCnv);
+
+  _cmDspConvolveLoad(p->ctx,p,&p->nxtCnv);
+
+  // pairs with the barrier in _cmDspConvolveUpdate()
+  __sync_synchronize();
+  p->doneFl = true;
+}
+
+// Called from the audio thread to install a completed load and to start a requested load.
+void _cmDspConvolveUpdate( cmDspCtx_t* ctx, cmDspConvolve_t* p )
+{
+  if( p->loadFl && p->doneFl )
+  {
+    // the loader is complete so this wait does not block
+    cmThreadPoolWait(p->poolH);
+
+    __sync_synchronize();
+
+    p->oldCnv = p->cnv;
+    p->cnv    = p->nxtCnv;
+    p->nxtCnv = NULL;
+    p->loadFl = false;
+  }
+
+  if( p->reqFl && p->loadFl == false )
+  {
+    p->reqFl = false;
+
+    if( _cmDspConvolveGetParams(ctx,p) != kOkDspRC )
+      return;
+
+    p->doneFl = false;
+    p->loadFl = cmThreadPoolStart(p->poolH,_cmDspConvolveLoadTask,p,1) == kOkThRC;
+  }
+}
+
+cmDspInst_t*  _cmDspConvolveAlloc(cmDspCtx_t* ctx, cmDspClass_t* classPtr, unsigned storeSymId, unsigned instSymId, unsigned id, unsigned va_cnt, va_list vl )
+{
+  cmDspVarArg_t args[] =
+  {
+    { "fn",    kFnCvId,     0, 0, kInDsvFl  | kStrzDsvFl   | kReqArgDsvFl, "Impulse response audio file." },
+    { "ch",    kChCvId,     0, 0, kInDsvFl  | kUIntDsvFl   | kOptArgDsvFl, "Impulse response channel index." },
+    { "tail",  kTailCvId,   0, 0, kInDsvFl  | kUIntDsvFl   | kOptArgDsvFl, "Background tail partition length in samples (0 to disable)." },
+    { "gain",  kGainCvId,   0, 0, kInDsvFl  | kDoubleDsvFl | kOptArgDsvFl, "Output gain." },
+    { "bypass",kBypassCvId, 0, 0, kInDsvFl  | kBoolDsvFl   | kOptArgDsvFl, "Bypass enable flag." },
+    { "in",    kInCvId,     0, 0, kInDsvFl  | kAudioBufDsvFl,              "Audio input" },
+    { "out",   kOutCvId,    0, 1, kOutDsvFl | kAudioBufDsvFl,              "Audio output." },
+    { NULL, 0, 0, 0, 0 }
+  };
+
+  cmDspConvolve_t* p = cmDspInstAlloc(cmDspConvolve_t,ctx,classPtr,args,instSymId,id,storeSymId,va_cnt,vl);
+
+  cmDspSetDefaultUInt(   ctx, &p->inst, kChCvId,     0,     0 );
+  cmDspSetDefaultUInt(   ctx, &p->inst, kTailCvId,   0,     1024 );
+  cmDspSetDefaultDouble( ctx, &p->inst, kGainCvId,   0.0,   1.0 );
+  cmDspSetDefaultBool(   ctx, &p->inst, kBypassCvId, false, false );
+
+  p->ctx   = ctx;
+  p->poolH = cmThreadPoolNullHandle;
+
+  if( cmThreadPoolCreate(&p->poolH,1,ctx->rpt) != kOkThRC )
+    cmDspInstErr(ctx,&p->inst,kThreadFailDspRC,"The impulse response loader thread create failed.");
+
+  return &p->inst;
+}
+
+cmDspRC_t _cmDspConvolveFree(cmDspCtx_t* ctx, cmDspInst_t* inst, const cmDspEvt_t* evt )
+{
+  cmDspConvolve_t* p = (cmDspConvolve_t*)inst;
+
+  if( cmThreadPoolIsValid(p->poolH) )
+  {
+    if( p->loadFl )
+      cmThreadPoolWait(p->poolH);
+
+    if( cmThreadPoolDestroy(&p->poolH) != kOkThRC )
+      cmDspInstErr(ctx,inst,kThreadFailDspRC,"The impulse response loader thread failed to close.");
+  }
+
+  cmConvolveFree(&p->cnv);
+  cmConvolveFree(&p->nxtCnv);
+  cmConvolveFree(&p->oldCnv);
+  return kOkDspRC;
+}
+
+cmDspRC_t _cmDspConvolveReset(cmDspCtx_t* ctx, cmDspInst_t* inst, const cmDspEvt_t* evt )
+{
+  cmDspConvolve_t* p = (cmDspConvolve_t*)inst;
+  cmDspRC_t        rc;
+
+  if((rc = cmDspApplyAllDefaults(ctx,inst)) != kOkDspRC )
+    return rc;
+
+  cmDspZeroAudioBuf(ctx,inst,kOutCvId);
+
+  // Reset is not called from the audio thread so the impulse response is loaded here
+  // rather than by the loader thread.
+  if( p->loadFl )
+  {
+    cmThreadPoolWait(p->poolH);
+    p->loadFl = false;
+  }
+
+  p->reqFl = false;
+  cmConvolveFree(&p->cnv);
+  cmConvolveFree(&p->nxtCnv);
+  cmConvolveFree(&p->oldCnv);
+
+  if((rc = _cmDspConvolveGetParams(ctx,p)) != kOkDspRC )
+    return rc;
+
+  return _cmDspConvolveLoad(ctx,p,&p->cnv);
+}
+
+cmDspRC_t _cmDspConvolveExec(cmDspCtx_t* ctx, cmDspInst_t* inst, const cmDspEvt_t* evt )
+{
+  cmDspConvolve_t*  p  = (cmDspConvolve_t*)inst;
+  const cmSample_t* ip = cmDspAudioBuf(ctx,inst,kInCvId,0);
+  cmSample_t*       op = cmDspAudioBuf(ctx,inst,kOutCvId,0);
+  unsigned          n  = cmDspVarRows(inst,kOutCvId);
+
+  _cmDspConvolveUpdate(ctx,p);
+
+  if( op == NULL )
+    return kOkDspRC;
+
+  if( ip == NULL )
+  {
+    cmVOS_Zero(op,n);
+    return kOkDspRC;
+  }
+
+  if( p->cnv == NULL || cmDspBool(inst,kBypassCvId) )
+  {
+    cmVOS_Copy(op,n,ip);
+    return kOkDspRC;
+  }
+
+  n = cmMin(n,p->cnv->outN);
+
+  cmConvolveExec(p->cnv,ip,cmMin(n,cmDspVarRows(inst,kInCvId)));
+
+  cmVOS_MultVVS(op,n,p->cnv->outV,cmDspDouble(inst,kGainCvId));
+
+  return kOkDspRC;
+}
+
+cmDspRC_t _cmDspConvolveRecv(cmDspCtx_t* ctx, cmDspInst_t* inst, const cmDspEvt_t* evt )
+{
+  cmDspConvolve_t* p = (cmDspConvolve_t*)inst;
+  cmDspRC_t        rc;
+
+  if((rc = cmDspSetEvent(ctx,inst,evt)) != kOkDspRC )
+    return rc;
+
+  switch( evt->dstVarId )
+  {
+    case kFnCvId:
+    case kChCvId:
+    case kTailCvId:
+      // the load is started by the next call to _cmDspConvolveExec()
+      p->reqFl = true;
+      break;
+  }
+
+  return rc;
+}
+
+cmDspClass_t* cmConvolveClassCons( cmDspCtx_t* ctx )
+{
+  cmDspClassSetup(&_cmConvolveDC,ctx,"Convolve",
+    NULL,
+    _cmDspConvolveAlloc,
+    _cmDspConvolveFree,
+    _cmDspConvolveReset,
+    _cmDspConvolveExec,
+    _cmDspConvolveRecv,
+    NULL,NULL,
+    "Partitioned convolution reverb. Changing the 'fn', 'ch' or 'tail' inputs reloads the impulse response in a background thread. The previous impulse response is used until the load is complete.");
+
+  return &_cmConvolveDC;
+}
+
+//)
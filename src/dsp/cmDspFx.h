@@ -46,6 +46,7 @@ extern "C" {
   struct cmDspClass_str* cmPresetClassCons(     cmDspCtx_t* ctx );
   struct cmDspClass_str* cmBcastSymClassCons(   cmDspCtx_t* ctx );
   struct cmDspClass_str* cmSegLineClassCons(    cmDspCtx_t* ctx );
+  struct cmDspClass_str* cmConvolveClassCons(   cmDspCtx_t* ctx );
 
   //)
   
@@ -8,6 +8,8 @@ extern "C" {
 #endif
 
   //( { file_desc:"'snap' distributed host UDP networking implementation." kw:[snap]}
+
+  #include <semaphore.h>
   
 #define cmDspSys_PARENT_SYM_TBL_BASE_ID 10000
 #define cmDspSys_AsSubIdx_Zero (0)
@@ -59,6 +61,60 @@ extern "C" {
   } _cmDspDstConn_t;
 
 
+  enum { kProfSmpDspCnt = 256 };  // count of recent exec times kept for each instance (must be a power of 2)
+
+  // Per-instance execution profile. Each record is only written by the thread which executes
+  // the instance and is read without locking by the profile report functions.
+  typedef struct
+  {
+    unsigned           smpV[ kProfSmpDspCnt ]; // ring of the most recent exec times in nanoseconds
+    volatile unsigned  smpCnt;    // total count of samples written (smpCnt % kProfSmpDspCnt is the next write location)
+    unsigned           minNs;     // 
+    unsigned           maxNs;     //
+    unsigned long long sumNs;     //
+    unsigned           resetIdx;  // value of _cmDspProf_t.resetIdx when this record was last cleared
+  } _cmDspProfInst_t;
+
+  typedef struct
+  {
+    volatile bool               enableFl;       // 
+    volatile unsigned           resetIdx;       // incremented to request that all records be cleared
+    _cmDspProfInst_t*           instArray;      // instArray[instCnt] indexed by cmDspInst_t.id
+    unsigned                    instCnt;        //
+    cmAudioSysDspProfileInst_t* msgArray;       // msgArray[instCnt] host msg buffer
+    unsigned                    reportCycleCnt; // send a profile msg to the host every reportCycleCnt cycles (0=never)
+    unsigned                    cycleIdx;       // cycles since the last profile msg was sent
+  } _cmDspProf_t;
+
+  struct _cmDspExec_str;
+
+  // A lane is an ordered list of instances executed by a single thread. See cmDspSysSetExecThreadCount().
+  typedef struct
+  {
+    struct _cmDspExec_str* p;           // parent exec record
+    unsigned               laneIdx;     // index of this lane in execLaneArray[]
+    cmDspInst_t**          instArray;   // instArray[instCnt] instances in execution order
+    unsigned               instCnt;     //
+    cmThreadH_t            thH;         // worker thread (not used by lane 0)
+    sem_t                  startSem;    // posted by the audio thread to release the worker for a cycle (not used by lane 0)
+    bool                   semFl;       // startSem has been initialized
+    volatile unsigned      cycleIdx;    // value of _cmDspExec_t.cycleIdx when this lane was last claimed (see _cmDspExecClaimLane())
+    volatile unsigned      doneIdx;     // value of cycleIdx when this lane last completed (doneIdx!=cycleIdx while the lane is executing)
+    bool                   relFl;       // the lane was released on the current cycle (not used by lane 0)
+    unsigned               execUsecs;   // execution time of the last cycle
+    cmDspInst_t*           failInstPtr; // first instance to fail on the last cycle or NULL
+    bool                   rtFl;        // worker thread priority has been set
+  } _cmDspExecLane_t;
+
+  typedef struct _cmDspExec_str
+  {
+    cmDspCtx_t*        ctx;
+    _cmDspProf_t*      prof;          // profiler state (cmDsp_t.prof)
+    unsigned           laneCnt;       // count of records in laneArray[]
+    _cmDspExecLane_t*  laneArray;     // laneArray[laneCnt]
+    volatile unsigned  cycleIdx;      // incremented by the audio thread to start a cycle
+  } _cmDspExec_t;
+
   typedef struct
   {
     cmErr_t             err;
@@ -93,6 +149,11 @@ extern "C" {
     unsigned              sendWaitMs;
     unsigned              syncState; // see kSyncXXXDspId
     cmDspInstSymId_t*     symIdList; // sym id's which will be assigned to each new instance
+
+    unsigned              execThreadCnt; // count of worker threads requested by cmDspSysSetExecThreadCount()
+    _cmDspExec_t*         exec;          // parallel execution schedule or NULL if the pgm is executed serially
+    cmDspSysExecStats_t   execStats;     // 
+    _cmDspProf_t          prof;          // per-instance execution profiler see cmDspSysProfileEnable()
   } cmDsp_t;
 
 
@@ -11,6 +11,7 @@
 #include "cmLinkedHeap.h"
 #include "cmText.h"
 #include "cmFileSys.h"
+#include "cmFile.h"
 #include "cmSymTbl.h"
 #include "cmTime.h"
 #include "cmMidi.h"
@@ -34,6 +35,9 @@
 #include "cmDspNet.h"
 #include "cmTime.h"
 
+#include <pthread.h>
+#include <sched.h>
+
 cmDspSysH_t cmDspNullHandle = cmSTATIC_NULL_HANDLE;
 
 #define kDspSysLabelCharCnt (127)
@@ -403,6 +407,933 @@ cmDspRC_t _cmDspSysAssignUniqueInstSymId( cmDsp_t* p )
   return rc;
 }
 
+//--------------------------------------------------------------------------------------------------
+// Profiling
+//
+
+// Execute an instance and record its execution time.
+cmDspRC_t _cmDspProfExec( _cmDspProf_t* pp, cmDspCtx_t* ctx, cmDspInst_t* inst )
+{
+  cmTimeSpec_t t0,t1;
+  cmDspRC_t    rc;
+
+  cmTimeGetMonotonic(&t0);
+  rc = inst->execFunc(ctx,inst,NULL);
+  cmTimeGetMonotonic(&t1);
+
+  if( inst->id < pp->instCnt )
+  {
+    _cmDspProfInst_t* r  = pp->instArray + inst->id;
+    unsigned          ns = cmTimeElapsedNanos(&t0,&t1);
+    unsigned          ri = pp->resetIdx;
+
+    // clear the record if a reset was requested
+    if( r->resetIdx != ri )
+    {
+      r->smpCnt   = 0;
+      r->sumNs    = 0;
+      r->maxNs    = 0;
+      r->resetIdx = ri;
+    }
+
+    if( r->smpCnt == 0 || ns < r->minNs )
+      r->minNs = ns;
+
+    if( ns > r->maxNs )
+      r->maxNs = ns;
+
+    r->sumNs += ns;
+    r->smpV[ r->smpCnt & (kProfSmpDspCnt-1) ] = ns;
+    ++r->smpCnt;
+  }
+
+  return rc;
+}
+
+// Execute an instance.  'pp' is NULL when profiling is disabled.
+cmDspRC_t _cmDspSysExecInst( _cmDspProf_t* pp, cmDspCtx_t* ctx, cmDspInst_t* inst )
+{
+  if( pp == NULL )
+    return inst->execFunc(ctx,inst,NULL);
+  
+  return _cmDspProfExec(pp,ctx,inst);
+}
+
+// Fill 'mp' with the current statistics of the instance 'id'. 
+// Returns false if the instance has not been executed since the profiler was enabled.
+bool _cmDspProfInstStats( const _cmDspProf_t* pp, unsigned id, cmAudioSysDspProfileInst_t* mp )
+{
+  const _cmDspProfInst_t* r;
+  unsigned                n,i,j;
+
+  if( id >= pp->instCnt )
+    return false;
+
+  r = pp->instArray + id;
+  n = r->smpCnt;
+
+  if( r->resetIdx != pp->resetIdx || n == 0 )
+    return false;
+
+  mp->instId    = id;
+  mp->execCnt   = n;
+  mp->minUsecs  = r->minNs / 1000.0f;
+  mp->maxUsecs  = r->maxNs / 1000.0f;
+  mp->meanUsecs = (float)((double)r->sumNs / n / 1000.0);
+
+  // The 99th percentile is the k'th largest of the most recent samples.
+  // The record may be written while it is being read - the result is approximate but bounded.
+  enum { kMaxTopCnt = kProfSmpDspCnt/100 + 1 };
+  unsigned topV[ kMaxTopCnt ];
+  unsigned sn = cmMin(n,kProfSmpDspCnt);
+  unsigned k  = sn/100 + 1;
+  unsigned tn = 0;
+
+  for(i=0; i<sn; ++i)
+  {
+    unsigned v = r->smpV[i];
+
+    if( tn < k )
+      ++tn;
+    else
+      if( v <= topV[tn-1] )
+        continue;
+
+    // insert v into the descending list topV[0:tn]
+    for(j=tn-1; j>0 && topV[j-1] < v; --j)
+      topV[j] = topV[j-1];
+    topV[j] = v;
+  }
+
+  mp->p99Usecs = topV[tn-1] / 1000.0f;
+
+  return true;
+}
+
+cmDspRC_t _cmDspSysProfileFree( cmDsp_t* p )
+{
+  cmMemFree(p->prof.instArray);
+  cmMemFree(p->prof.msgArray);
+  memset(&p->prof,0,sizeof(p->prof));
+  return kOkDspRC;
+}
+
+// Send a kDspProfileSelAsId message to the host.  Called from the audio thread.
+void _cmDspSysProfileSend( cmDsp_t* p )
+{
+  _cmDspProf_t*          pp    = &p->prof;
+  unsigned               hdr[] = { p->ctx.ctx->asSubIdx, kDspProfileSelAsId };
+  cmAudioSysDspProfile_t r;
+  unsigned               i;
+
+  r.asSubIdx      = p->ctx.ctx->asSubIdx;
+  r.cycleCnt      = p->execStats.cycleCnt;
+  r.deadlineUsecs = p->execStats.deadlineUsecs;
+  r.lastUsecs     = p->execStats.lastUsecs;
+  r.maxUsecs      = p->execStats.maxUsecs;
+  r.overrunCnt    = p->execStats.overrunCnt;
+  r.instCnt       = 0;
+
+  for(i=0; i<pp->instCnt; ++i)
+    if( _cmDspProfInstStats(pp,i,pp->msgArray + r.instCnt) )
+      ++r.instCnt;
+
+  const void* msgDataPtrArray[] = { &hdr, &r, pp->msgArray };
+  unsigned    msgByteCntArray[] = { sizeof(hdr), sizeof(r), r.instCnt * sizeof(pp->msgArray[0]) };
+  unsigned    segCnt            = sizeof(msgByteCntArray)/sizeof(unsigned);
+
+  if( p->ctx.ctx->dspToHostFunc(p->ctx.ctx,msgDataPtrArray,msgByteCntArray,segCnt) != kOkAsRC )
+    cmErrMsg(&p->err,kSendToHostFailDspRC,"DSP profile message transmission failed.");
+}
+
+cmDspRC_t cmDspSysProfileEnable( cmDspSysH_t h, bool enableFl, unsigned reportCycleCnt )
+{
+  cmDsp_t*      p  = _cmDspHandleToPtr(h);
+  _cmDspProf_t* pp = &p->prof;
+
+  if( enableFl == false )
+  {
+    pp->enableFl = false;
+    return kOkDspRC;
+  }
+
+  if( p->pgmIdx == cmInvalidIdx )
+    return cmErrMsg(&p->err,kInvalidStateDspRC,"A DSP program must be loaded before profiling is enabled.");
+
+  // The profile records are allocated on the first enable and released when the program is
+  // unloaded. The audio thread only reads instArray[] while enableFl is set.
+  if( pp->instArray == NULL )
+  {
+    pp->instCnt  = p->nextInstId;
+    pp->msgArray = cmMemAllocZ(cmAudioSysDspProfileInst_t,pp->instCnt);
+
+    _cmDspProfInst_t* a = cmMemAllocZ(_cmDspProfInst_t,pp->instCnt);
+    cmThPtrCAS(&pp->instArray,NULL,a);
+  }
+
+  pp->reportCycleCnt = reportCycleCnt;
+  pp->cycleIdx       = 0;
+
+  // clear the statistics - the records are cleared by the thread which executes the instance
+  cmThUIntIncr((unsigned*)&pp->resetIdx,1);
+
+  pp->enableFl = true;
+
+  return kOkDspRC;
+}
+
+bool  cmDspSysProfileIsEnabled( cmDspSysH_t h )
+{
+  cmDsp_t* p = _cmDspHandleToPtr(h);
+  return p->prof.enableFl;
+}
+
+cmDspRC_t _cmDspSysProfileWriteCsv( cmDsp_t* p, const cmChar_t* fn )
+{
+  cmDspRC_t     rc  = kOkDspRC;
+  cmFileH_t     fH  = cmFileNullHandle;
+  _cmDspInst_t* ip  = p->instList;
+
+  if( cmFileOpen(&fH,fn,kWriteFileFl,p->err.rpt) != kOkFileRC )
+    return cmErrMsg(&p->err,kFileOpenFailDspRC,"The DSP profile file '%s' could not be created.",cmStringNullGuard(fn));
+
+  cmFilePrintf(fH,"id,class,label,count,min_us,mean_us,max_us,p99_us\n");
+
+  for(; ip!=NULL; ip=ip->linkPtr)
+  {
+    cmAudioSysDspProfileInst_t r;
+    if( _cmDspProfInstStats(&p->prof,ip->instPtr->id,&r) )
+      if( cmFilePrintf(fH,"%i,%s,%s,%i,%f,%f,%f,%f\n",
+          ip->instPtr->id,
+          ip->instPtr->classPtr->labelStr,
+          cmStringNullGuard(cmSymTblLabel(p->ctx.stH,ip->instPtr->symId)),
+          r.execCnt,r.minUsecs,r.meanUsecs,r.maxUsecs,r.p99Usecs) != kOkFileRC )
+      {
+        rc = cmErrMsg(&p->err,kFileWriteFailDspRC,"DSP profile file write failed on '%s'.",cmStringNullGuard(fn));
+        break;
+      }
+  }
+
+  if( cmFileClose(&fH) != kOkFileRC )
+    rc = cmErrMsg(&p->err,kFileCloseFailDspRC,"DSP profile file close failed on '%s'.",cmStringNullGuard(fn));
+
+  return rc;
+}
+
+cmDspRC_t _cmDspSysProfileWriteJson( cmDsp_t* p, const cmChar_t* fn )
+{
+  cmDspRC_t     rc  = kOkDspRC;
+  cmJsonH_t     jsH = cmJsonNullHandle;
+  _cmDspInst_t* ip  = p->instList;
+  cmJsonNode_t* onp;
+  cmJsonNode_t* iap;
+
+  if( cmJsonInitialize(&jsH, &p->cmCtx ) != kOkJsRC )
+    return cmErrMsg(&p->err,kJsonFailDspRC,"JSON profile object create failed.");
+
+  onp = cmJsonCreateObject(jsH,NULL);
+
+  if( cmJsonInsertPairs(jsH, onp,
+      "cycleCnt",      kIntTId, p->execStats.cycleCnt,
+      "deadlineUsecs", kIntTId, p->execStats.deadlineUsecs,
+      "meanUsecs",     kRealTId,p->execStats.meanUsecs,
+      "maxUsecs",      kIntTId, p->execStats.maxUsecs,
+      "overrunCnt",    kIntTId, p->execStats.overrunCnt,
+      "laneCnt",       kIntTId, p->execStats.laneCnt,
+      NULL ) != kOkJsRC )
+  {
+    rc = cmErrMsg(&p->err,kJsonFailDspRC,"JSON DSP profile header create failed.");
+    goto errLabel;
+  }
+
+  iap = cmJsonInsertPairArray(jsH, onp, "inst_array" );
+
+  for(; ip!=NULL; ip=ip->linkPtr)
+  {
+    cmAudioSysDspProfileInst_t r;
+    if( _cmDspProfInstStats(&p->prof,ip->instPtr->id,&r) )
+    {
+      cmJsonNode_t* np = cmJsonCreateObject(jsH,iap);
+      
+      if( cmJsonInsertPairs(jsH, np,
+          "id",        kIntTId,    ip->instPtr->id,
+          "class",     kStringTId, ip->instPtr->classPtr->labelStr,
+          "label",     kStringTId, cmStringNullGuard(cmSymTblLabel(p->ctx.stH,ip->instPtr->symId)),
+          "count",     kIntTId,    r.execCnt,
+          "minUsecs",  kRealTId,   (double)r.minUsecs,
+          "meanUsecs", kRealTId,   (double)r.meanUsecs,
+          "maxUsecs",  kRealTId,   (double)r.maxUsecs,
+          "p99Usecs",  kRealTId,   (double)r.p99Usecs,
+          NULL ) != kOkJsRC )
+      {
+        rc = cmErrMsg(&p->err,kJsonFailDspRC,"JSON DSP profile instance create failed.");
+        goto errLabel;
+      }
+    }
+  }
+
+  if( cmJsonWrite(jsH,cmJsonRoot(jsH),fn) != kOkJsRC )
+    rc = cmErrMsg(&p->err,kJsonFailDspRC,"DSP profile JSON file write failed on '%s'.",cmStringNullGuard(fn));
+
+ errLabel:
+  if( cmJsonFinalize(&jsH) != kOkJsRC )
+    rc = cmErrMsg(&p->err,kJsonFailDspRC,"JSON DSP profile object finalize failed.");
+
+  return rc;
+}
+
+cmDspRC_t cmDspSysProfileWrite( cmDspSysH_t h, const cmChar_t* fn )
+{
+  cmDsp_t*             p  = _cmDspHandleToPtr(h);
+  cmDspRC_t            rc = kOkDspRC;
+  cmFileSysPathPart_t* pp;
+  bool                 csvFl;
+
+  if( p->prof.instArray == NULL )
+    return cmErrMsg(&p->err,kInvalidStateDspRC,"The DSP profile cannot be written because profiling has not been enabled.");
+
+  if((pp = cmFsPathParts(fn)) == NULL )
+    return cmErrMsg(&p->err,kFileSysFailDspRC,"The DSP profile file name '%s' could not be parsed.",cmStringNullGuard(fn));
+
+  csvFl = pp->extStr != NULL && strcmp(pp->extStr,"csv")==0;
+  cmFsFreePathParts(pp);
+
+  if( csvFl )
+    rc = _cmDspSysProfileWriteCsv(p,fn);
+  else
+    rc = _cmDspSysProfileWriteJson(p,fn);
+
+  return rc;
+}
+
+//--------------------------------------------------------------------------------------------------
+// Parallel execution
+//
+
+enum
+{
+  kExecIdleWaitUs   = 20000, // max. time a worker blocks waiting for a cycle before returning to cmThread to service pause/exit requests
+  kExecLaneWaitUs   = 100,   // max. time the audio thread waits for the workers to start their lanes before executing them itself
+  kExecLaneMaxWaitUs = 10000 // max. time the audio thread waits for a started lane when the cycle period is not known
+};
+
+typedef struct
+{
+  const char*  begPtr;  // address of varArray[0]
+  const char*  endPtr;  // address of varArray[varCnt]
+  unsigned     idx;     // index of the owning instance
+} _cmDspExecVarRange_t;
+
+int _cmDspExecVarRangeCmp( const void* p0, const void* p1 )
+{
+  const _cmDspExecVarRange_t* r0 = (const _cmDspExecVarRange_t*)p0;
+  const _cmDspExecVarRange_t* r1 = (const _cmDspExecVarRange_t*)p1;
+  return r0->begPtr < r1->begPtr ? -1 : (r0->begPtr > r1->begPtr ? 1 : 0);
+}
+
+int _cmDspExecInstPtrCmp( const void* p0, const void* p1 )
+{
+  const _cmDspExecVarRange_t* r0 = (const _cmDspExecVarRange_t*)p0;
+  const _cmDspExecVarRange_t* r1 = (const _cmDspExecVarRange_t*)p1;
+  return r0->endPtr < r1->endPtr ? -1 : (r0->endPtr > r1->endPtr ? 1 : 0);
+}
+
+// Return the index of the instance whose var array contains 'addr' or cmInvalidIdx.
+unsigned _cmDspExecVarAddrToIdx( const _cmDspExecVarRange_t* r, unsigned n, const void* addr )
+{
+  const char* a = (const char*)addr;
+  unsigned    lo = 0, hi = n;
+
+  while( lo < hi )
+  {
+    unsigned m = (lo + hi) / 2;
+
+    if( a < r[m].begPtr )
+      hi = m;
+    else
+      if( a >= r[m].endPtr )
+        lo = m + 1;
+      else
+        return r[m].idx;
+  }
+
+  return cmInvalidIdx;
+}
+
+// Return the index of the instance 'ip' or cmInvalidIdx.
+// 'r[]' is sorted on endPtr which holds the instance address.
+unsigned _cmDspExecInstPtrToIdx( const _cmDspExecVarRange_t* r, unsigned n, const cmDspInst_t* ip )
+{
+  _cmDspExecVarRange_t        k  = { NULL, (const char*)ip, 0 };
+  const _cmDspExecVarRange_t* rp = (const _cmDspExecVarRange_t*)bsearch(&k,r,n,sizeof(*r),_cmDspExecInstPtrCmp);
+  return rp == NULL ? cmInvalidIdx : rp->idx;
+}
+
+int _cmDspExecEdgeCmp( const void* p0, const void* p1 )
+{
+  const unsigned* e0 = (const unsigned*)p0;
+  const unsigned* e1 = (const unsigned*)p1;
+  return e0[0] < e1[0] ? -1 : (e0[0] > e1[0] ? 1 : 0);
+}
+
+// Return the index of the first edge in edgeV[] whose source is 'srcIdx'.
+unsigned _cmDspExecFirstEdge( const unsigned* edgeV, unsigned edgeCnt, unsigned srcIdx )
+{
+  unsigned lo = 0, hi = edgeCnt;
+  while( lo < hi )
+  {
+    unsigned m = (lo + hi) / 2;
+    if( edgeV[m*2+0] < srcIdx )
+      lo = m + 1;
+    else
+      hi = m;
+  }
+  return lo;
+}
+
+unsigned _cmDspExecUfFind( unsigned* parentV, unsigned i )
+{
+  while( parentV[i] != i )
+  {
+    parentV[i] = parentV[ parentV[i] ];
+    i          = parentV[i];
+  }
+  return i;
+}
+
+void _cmDspExecUfUnion( unsigned* parentV, unsigned i, unsigned j )
+{
+  i = _cmDspExecUfFind(parentV,i);
+  j = _cmDspExecUfFind(parentV,j);
+
+  // the lower index becomes the root so that component roots follow allocation order
+  if( i < j )
+    parentV[j] = i;
+  else
+    if( j < i )
+      parentV[i] = j;
+}
+
+void _cmDspExecLane( _cmDspExecLane_t* lp )
+{
+  cmDspCtx_t*   ctx = lp->p->ctx;
+  _cmDspProf_t* pp  = lp->p->prof->enableFl ? lp->p->prof : NULL;
+  unsigned      i;
+  cmTimeSpec_t t0,t1;
+
+  cmTimeGet(&t0);
+
+  lp->failInstPtr = NULL;
+
+  for(i=0; i<lp->instCnt; ++i)
+  {
+    cmDspInst_t* inst = lp->instArray[i];
+
+    if( cmIsFlag(inst->flags,kDisableExecInstFl)==false )
+      if( _cmDspSysExecInst(pp,ctx,inst) != kOkDspRC && lp->failInstPtr == NULL )
+        lp->failInstPtr = inst;
+  }
+
+  cmTimeGet(&t1);
+  lp->execUsecs = cmTimeElapsedMicros(&t0,&t1);
+}
+
+// Claim the lane for the current cycle. Returns false if the lane was 
+// already claimed by the audio thread or the worker, or if it is still 
+// executing an earlier cycle. A lane is therefore executed at most once 
+// per cycle, by whichever thread claims it first, and never concurrently.
+bool _cmDspExecClaimLane( _cmDspExecLane_t* lp )
+{
+  unsigned cycleIdx = lp->p->cycleIdx;
+  unsigned laneIdx  = lp->cycleIdx;
+
+  return laneIdx != cycleIdx && lp->doneIdx == laneIdx && cmThUIntCAS((unsigned*)&lp->cycleIdx,laneIdx,cycleIdx);
+}
+
+// Execute a claimed worker lane and notify the audio thread.
+void _cmDspExecWorkerLane( _cmDspExecLane_t* lp )
+{
+  _cmDspExecLane(lp);
+  __sync_synchronize();         // the lane results are visible before doneIdx changes
+  lp->doneIdx = lp->cycleIdx;
+}
+
+// Return the count of lanes released on the current cycle which have not completed.
+unsigned _cmDspExecPendingLaneCnt( _cmDspExec_t* ep )
+{
+  unsigned i,n;
+
+  for(i=1,n=0; i<ep->laneCnt; ++i)
+    if( ep->laneArray[i].relFl && ep->laneArray[i].doneIdx != ep->cycleIdx )
+      ++n;
+
+  return n;
+}
+
+// Wait at most 'usecs' for the lanes released on the current cycle to complete.
+// Returns the count of lanes which have not completed.
+unsigned _cmDspExecWaitLanes( _cmDspExec_t* ep, unsigned usecs )
+{
+  unsigned     n;
+  cmTimeSpec_t t0,t1;
+
+  cmTimeGet(&t0);
+  while((n = _cmDspExecPendingLaneCnt(ep)) > 0 )
+  {
+    cmTimeGet(&t1);
+    if( cmTimeElapsedMicros(&t0,&t1) >= usecs )
+      break;
+  }
+
+  return n;
+}
+
+bool _cmDspExecThreadFunc( void* arg )
+{
+  _cmDspExecLane_t* lp = (_cmDspExecLane_t*)arg;
+  struct timespec   ts;
+
+  // attempt to give the worker the same scheduling class as a typical audio thread
+  if( lp->rtFl == false )
+  {
+    struct sched_param sp;
+    int                pri = sched_get_priority_max(SCHED_FIFO);
+    
+    memset(&sp,0,sizeof(sp));
+    sp.sched_priority = pri > 1 ? pri-1 : pri;
+    pthread_setschedparam(pthread_self(),SCHED_FIFO,&sp);  // failure is not an error
+    lp->rtFl = true;
+  }
+
+  // block until the audio thread starts the next cycle - the wait times out 
+  // periodically so that cmThread can service pause/exit requests
+  clock_gettime(CLOCK_REALTIME,&ts);
+  ts.tv_nsec += kExecIdleWaitUs * 1000;
+  if( ts.tv_nsec >= 1000000000 )
+  {
+    ts.tv_sec  += 1;
+    ts.tv_nsec -= 1000000000;
+  }
+
+  if( sem_timedwait(&lp->startSem,&ts) != 0 )
+    return true;
+
+  // the audio thread may have executed this lane itself if the worker was late
+  if( _cmDspExecClaimLane(lp) )
+    _cmDspExecWorkerLane(lp);
+
+  return true;
+}
+
+cmDspRC_t _cmDspSysExecFree( cmDsp_t* p )
+{
+  cmDspRC_t     rc = kOkDspRC;
+  _cmDspExec_t* ep = p->exec;
+  unsigned      i;
+
+  if( ep == NULL )
+    return rc;
+
+  for(i=1; i<ep->laneCnt; ++i)
+  {
+    if( cmThreadIsValid(ep->laneArray[i].thH) )
+      if( cmThreadDestroy(&ep->laneArray[i].thH) != kOkThRC )
+        rc = cmErrMsg(&p->err,kThreadFailDspRC,"DSP execution worker thread %i destroy failed.",i);
+
+    if( ep->laneArray[i].semFl )
+      sem_destroy(&ep->laneArray[i].startSem);
+  }
+
+  for(i=0; i<ep->laneCnt; ++i)
+    cmMemFree(ep->laneArray[i].instArray);
+
+  cmMemFree(ep->laneArray);
+  cmMemPtrFree(&p->exec);
+
+  return rc;
+}
+
+// Partition the instance list into independent sub-graphs and distribute them 
+// over p->execThreadCnt+1 lanes.
+cmDspRC_t _cmDspSysExecAlloc( cmDsp_t* p )
+{
+  cmDspRC_t     rc = kOkDspRC;
+  _cmDspInst_t* ip;
+  unsigned      i,j,k,n;
+
+  memset(&p->execStats,0,sizeof(p->execStats));
+  p->execStats.laneCnt = 1;
+
+  if((rc = _cmDspSysExecFree(p)) != kOkDspRC )
+    return rc;
+
+  // network connections are serviced from within the exec functions - execute serially
+  if( p->execThreadCnt == 0 || p->srcConnList != NULL || p->dstConnList != NULL )
+    return rc;
+
+  // count the instances
+  for(n=0,ip=p->instList; ip!=NULL; ip=ip->linkPtr)
+    ++n;
+
+  if( n < 2 )
+    return rc;
+
+  cmDspInst_t**         instV   = cmMemAllocZ(cmDspInst_t*,        n );
+  _cmDspExecVarRange_t* varV    = cmMemAllocZ(_cmDspExecVarRange_t,n );
+  _cmDspExecVarRange_t* ptrV    = cmMemAllocZ(_cmDspExecVarRange_t,n );
+  unsigned*             parentV = cmMemAllocZ(unsigned,            n );
+  unsigned*             inDegV  = cmMemAllocZ(unsigned,            n );
+  unsigned*             orderV  = cmMemAllocZ(unsigned,            n );
+  unsigned*             compV   = cmMemAllocZ(unsigned,            n );
+  unsigned*             costV   = cmMemAllocZ(unsigned,            n );
+  unsigned*             laneV   = cmMemAllocZ(unsigned,            n );
+  unsigned              laneCnt = cmMin(p->execThreadCnt+1,kMaxExecLaneDspCnt);
+  unsigned              laneCostV[ kMaxExecLaneDspCnt ];
+  unsigned              compCnt = 0;
+  unsigned              edgeCnt = 0;
+  unsigned*             edgeV   = NULL;
+
+  for(i=0,ip=p->instList; ip!=NULL; ip=ip->linkPtr,++i)
+  {
+    instV[i]        = ip->instPtr;
+    varV[i].begPtr  = (const char*)ip->instPtr->varArray;
+    varV[i].endPtr  = (const char*)(ip->instPtr->varArray + ip->instPtr->varCnt);
+    varV[i].idx     = i;
+    ptrV[i].endPtr  = (const char*)ip->instPtr;
+    ptrV[i].idx     = i;
+    parentV[i]      = i;
+  }
+
+  qsort(varV,n,sizeof(*varV),_cmDspExecVarRangeCmp);
+  qsort(ptrV,n,sizeof(*ptrV),_cmDspExecInstPtrCmp);
+
+  // count the audio connections
+  for(i=0; i<n; ++i)
+    for(j=0; j<instV[i]->varCnt; ++j)
+      if( cmIsFlag(instV[i]->varArray[j].flags,kAudioBufDsvFl) && cmIsFlag(instV[i]->varArray[j].value.flags,kProxyDsvFl) )
+        ++edgeCnt;
+
+  // edgeV[k*2+0] is the source instance and edgeV[k*2+1] is the destination instance of audio connection k
+  edgeV = cmMemAllocZ(unsigned,edgeCnt*2+1);
+  
+  for(i=0,k=0; i<n; ++i)
+    for(j=0; j<instV[i]->varCnt; ++j)
+    {
+      const cmDspVar_t* vp = instV[i]->varArray + j;
+
+      // audio connections are implemented as a proxy to the source variable
+      if( cmIsFlag(vp->flags,kAudioBufDsvFl) && cmIsFlag(vp->value.flags,kProxyDsvFl) )
+      {
+        unsigned si = _cmDspExecVarAddrToIdx(varV,n,vp->value.u.vp);
+        if( si != cmInvalidIdx && si != i )
+        {
+          edgeV[k*2+0] = si;
+          edgeV[k*2+1] = i;
+          ++k;
+          ++inDegV[i];
+          _cmDspExecUfUnion(parentV,si,i);
+        }
+      }
+
+      // events are delivered synchronously so the source and destination must share a thread
+      const cmDspCb_t* cbp = vp->cbList;
+      for(; cbp!=NULL; cbp=cbp->linkPtr)
+      {
+        unsigned di = _cmDspExecInstPtrToIdx(ptrV,n,cbp->dstInstPtr);
+        if( di != cmInvalidIdx )
+          _cmDspExecUfUnion(parentV,i,di);
+      }
+    }
+
+  edgeCnt = k;
+
+  // sort the connections on the source instance so that the out edges of each instance are contiguous
+  qsort(edgeV,edgeCnt,sizeof(unsigned)*2,_cmDspExecEdgeCmp);
+
+  // Order the instances by audio data flow (Kahn) preferring allocation order.
+  // If a feedback cycle prevents progress then the earliest remaining instance is released.
+  {
+    unsigned* queV = laneV; // laneV[] is used as the work queue here 
+    unsigned  qi   = 0;
+    unsigned  qn   = 0;
+    unsigned  oi   = 0;
+    unsigned  ri   = 0;
+    bool*     doneV = cmMemAllocZ(bool,n);
+
+    for(i=0; i<n; ++i)
+      if( inDegV[i] == 0 )
+        queV[qn++] = i;
+
+    while( oi < n )
+    {
+      if( qi == qn )
+      {
+        for(; doneV[ri]; ++ri)
+        {}
+        inDegV[ri] = 0;
+        queV[qn++] = ri;
+      }
+
+      i          = queV[qi++];
+      doneV[i]   = true;
+      orderV[oi++] = i;
+
+      for(k=_cmDspExecFirstEdge(edgeV,edgeCnt,i); k<edgeCnt && edgeV[k*2+0] == i; ++k)
+        if( inDegV[ edgeV[k*2+1] ] > 0 )
+          if( --inDegV[ edgeV[k*2+1] ] == 0 && doneV[ edgeV[k*2+1] ] == false )
+            queV[qn++] = edgeV[k*2+1];
+    }
+
+    cmMemFree(doneV);
+  }
+
+  // assign a cost to each component (the count of instances with an exec function)
+  for(i=0; i<n; ++i)
+  {
+    unsigned r = _cmDspExecUfFind(parentV,i);
+
+    if( r == i )
+      compV[compCnt++] = r;
+
+    if( instV[i]->execFunc != NULL )
+      ++costV[r];
+  }
+
+  // sort the component roots by decreasing cost
+  for(i=1; i<compCnt; ++i)
+    for(j=i; j>0 && costV[compV[j]] > costV[compV[j-1]]; --j)
+    {
+      unsigned t = compV[j]; compV[j] = compV[j-1]; compV[j-1] = t;
+    }
+
+  // ... then assign each to the least loaded lane
+  memset(laneCostV,0,sizeof(laneCostV));
+  for(i=0; i<compCnt; ++i)
+  {
+    unsigned li = 0;
+    for(j=1; j<laneCnt; ++j)
+      if( laneCostV[j] < laneCostV[li] )
+        li = j;
+
+    laneCostV[li] += costV[ compV[i] ];
+    laneV[ compV[i] ] = li;  
+  }
+
+  // lanes with no work are dropped
+  for(j=0; j<laneCnt && laneCostV[j]>0; ++j)
+  {}
+  laneCnt = j;
+
+  if( laneCnt > 1 )
+  {
+    _cmDspExec_t* ep = cmMemAllocZ(_cmDspExec_t,1);
+    ep->ctx          = &p->ctx;
+    ep->prof         = &p->prof;
+    ep->laneCnt      = laneCnt;
+    ep->laneArray    = cmMemAllocZ(_cmDspExecLane_t,laneCnt);
+
+    for(j=0; j<laneCnt; ++j)
+    {
+      ep->laneArray[j].p         = ep;
+      ep->laneArray[j].laneIdx   = j;
+      ep->laneArray[j].thH       = cmThreadNullHandle;
+      ep->laneArray[j].instArray = cmMemAllocZ(cmDspInst_t*,laneCostV[j]);
+    }
+
+    // distribute the instances in data flow order
+    for(k=0; k<n; ++k)
+    {
+      cmDspInst_t* inst = instV[ orderV[k] ];
+      if( inst->execFunc != NULL )
+      {
+        _cmDspExecLane_t* lp = ep->laneArray + laneV[ _cmDspExecUfFind(parentV,orderV[k]) ];
+        lp->instArray[ lp->instCnt++ ] = inst;
+      }
+    }
+
+    p->exec = ep;
+
+    // create the worker threads
+    for(j=1; j<laneCnt; ++j)
+    {
+      if( sem_init(&ep->laneArray[j].startSem,0,0) != 0 )
+      {
+        rc = cmErrSysMsg(&p->err,kThreadFailDspRC,errno,"DSP execution worker %i semaphore create failed.",j);
+        break;
+      }
+
+      ep->laneArray[j].semFl = true;
+
+      if( cmThreadCreate(&ep->laneArray[j].thH,_cmDspExecThreadFunc,ep->laneArray+j,p->err.rpt) != kOkThRC )
+      {
+        rc = cmErrMsg(&p->err,kThreadFailDspRC,"DSP execution worker thread %i create failed.",j);
+        break;
+      }
+
+      if( cmThreadPause(ep->laneArray[j].thH,0) != kOkThRC )
+      {
+        rc = cmErrMsg(&p->err,kThreadFailDspRC,"DSP execution worker thread %i start failed.",j);
+        break;
+      }
+    }
+
+    if( rc != kOkDspRC )
+      _cmDspSysExecFree(p);
+    else
+    {
+      p->execStats.laneCnt = laneCnt;
+      for(j=0; j<laneCnt; ++j)
+        p->execStats.laneInstCnt[j] = ep->laneArray[j].instCnt;
+    }
+  }
+
+  cmMemFree(edgeV);
+  cmMemFree(laneV);
+  cmMemFree(costV);
+  cmMemFree(compV);
+  cmMemFree(orderV);
+  cmMemFree(inDegV);
+  cmMemFree(parentV);
+  cmMemFree(ptrV);
+  cmMemFree(varV);
+  cmMemFree(instV);
+
+  return rc;
+}
+
+// Execute one DSP cycle using the parallel schedule.
+void _cmDspSysExecParallel( cmDsp_t* p )
+{
+  _cmDspExec_t*     ep = p->exec;
+  _cmDspExecLane_t* lp;
+  unsigned          i;
+
+  cmThUIntIncr((unsigned*)&ep->cycleIdx,1);
+
+  // release the workers (sem_post() does not block) - a lane whose worker
+  // is still executing an earlier cycle is skipped until the worker finishes
+  for(i=1; i<ep->laneCnt; ++i)
+  {
+    lp        = ep->laneArray + i;
+    lp->relFl = lp->doneIdx == lp->cycleIdx;
+
+    if( lp->relFl )
+      sem_post(&lp->startSem);
+    else
+      ++p->execStats.skipLaneCnt;
+  }
+
+  // the audio thread executes lane 0
+  _cmDspExecLane(ep->laneArray);
+
+  // wait a limited time for the workers ...
+  if( _cmDspExecWaitLanes(ep,kExecLaneWaitUs) > 0 )
+  {
+    // ... then execute the lanes whose worker has not yet started 
+    for(i=1; i<ep->laneCnt; ++i)
+      if( ep->laneArray[i].relFl && _cmDspExecClaimLane(ep->laneArray + i) )
+      {
+        _cmDspExecWorkerLane(ep->laneArray + i);
+        ++p->execStats.inlineLaneCnt;
+      }
+
+    // A lane which was started by a worker cannot be taken over. Wait for
+    // it for at most one cycle period and then continue without it.
+    if( _cmDspExecWaitLanes(ep,p->execStats.deadlineUsecs > 0 ? p->execStats.deadlineUsecs : kExecLaneMaxWaitUs) > 0 )
+      for(i=1; i<ep->laneCnt; ++i)
+        if( ep->laneArray[i].relFl && ep->laneArray[i].doneIdx != ep->cycleIdx )
+        {
+          ep->laneArray[i].relFl = false;
+          ++p->execStats.lateLaneCnt;
+        }
+  }
+
+  // pairs with the barrier in _cmDspExecWorkerLane() 
+  __sync_synchronize();
+
+  // worker threads do not report errors - report them here
+  for(i=0; i<ep->laneCnt; ++i)
+  {
+    const cmDspInst_t* inst;
+
+    // a late lane's results are not available
+    if( i > 0 && ep->laneArray[i].relFl == false )
+      continue;
+
+    if((inst = ep->laneArray[i].failInstPtr) != NULL )
+      cmErrMsg(&p->err,kInstExecFailDspRC,"Execution failed on DSP instance '%s' id:%i (lane:%i).",inst->classPtr->labelStr,inst->id,i);
+
+    p->execStats.laneUsecs[i] = ep->laneArray[i].execUsecs;
+  }
+}
+
+void _cmDspSysExecUpdateStats( cmDsp_t* p, unsigned usecs )
+{
+  cmDspSysExecStats_t* s = &p->execStats;
+
+  if( s->deadlineUsecs == 0 && p->ctx.ctx != NULL )
+    s->deadlineUsecs = (unsigned)(1000000.0 * cmDspSamplesPerCycle(&p->ctx) / cmDspSampleRate(&p->ctx));
+
+  s->lastUsecs  = usecs;
+  s->maxUsecs   = cmMax(s->maxUsecs,usecs);
+  s->meanUsecs += (usecs - s->meanUsecs) / (s->cycleCnt + 1);
+  s->cycleCnt  += 1;
+
+  if( s->deadlineUsecs > 0 && usecs > s->deadlineUsecs )
+    ++s->overrunCnt;
+}
+
+cmDspRC_t cmDspSysSetExecThreadCount( cmDspSysH_t h, unsigned threadCnt )
+{
+  cmDsp_t* p = _cmDspHandleToPtr(h);
+
+  if( threadCnt >= kMaxExecLaneDspCnt )
+    return cmErrMsg(&p->err,kInvalidArgDspRC,"The DSP execution thread count %i is greater than the max. count %i.",threadCnt,kMaxExecLaneDspCnt-1);
+
+  p->execThreadCnt = threadCnt;
+
+  if( p->pgmIdx != cmInvalidIdx )
+    return _cmDspSysExecAlloc(p);
+
+  return kOkDspRC;
+}
+
+unsigned  cmDspSysExecThreadCount( cmDspSysH_t h )
+{
+  cmDsp_t* p = _cmDspHandleToPtr(h);
+  return p->execThreadCnt;
+}
+
+cmDspRC_t cmDspSysExecStats( cmDspSysH_t h, cmDspSysExecStats_t* s )
+{
+  cmDsp_t* p = _cmDspHandleToPtr(h);
+  *s = p->execStats;
+  return kOkDspRC;
+}
+
+void  cmDspSysExecReport( cmDspSysH_t h, cmRpt_t* rpt )
+{
+  cmDsp_t*                   p = _cmDspHandleToPtr(h);
+  const cmDspSysExecStats_t* s = &p->execStats;
+  unsigned                   i,j;
+
+  cmRptPrintf(rpt,"lanes:%i cycles:%i last:%i mean:%.1f max:%i deadline:%i overruns:%i inline lanes:%i late lanes:%i skipped lanes:%i (usecs)\n",
+    s->laneCnt,s->cycleCnt,s->lastUsecs,s->meanUsecs,s->maxUsecs,s->deadlineUsecs,s->overrunCnt,s->inlineLaneCnt,s->lateLaneCnt,s->skipLaneCnt);
+
+  if( p->exec == NULL )
+    return;
+
+  for(i=0; i<p->exec->laneCnt; ++i)
+  {
+    const _cmDspExecLane_t* lp = p->exec->laneArray + i;
+
+    cmRptPrintf(rpt,"lane:%i insts:%i last:%i usecs\n",i,lp->instCnt,lp->execUsecs);
+
+    for(j=0; j<lp->instCnt; ++j)
+      cmRptPrintf(rpt,"  %5i %s\n",lp->instArray[j]->id,cmStringNullGuard(lp->instArray[j]->classPtr->labelStr));
+  }
+}
+
 cmDspRC_t cmDspSysLoad( cmDspSysH_t  h,  cmAudioSysCtx_t* asCtx, unsigned pgmIdx )
 {
   cmDspRC_t       rc;
@@ -514,7 +1445,11 @@ cmDspRC_t cmDspSysLoad( cmDspSysH_t  h,  cmAudioSysCtx_t* asCtx, unsigned pgmIdx
     goto errLabel;
   }
 
-  rc = _cmDspSysAssignUniqueInstSymId(p);
+  if((rc = _cmDspSysAssignUniqueInstSymId(p)) != kOkDspRC )
+    goto errLabel;
+
+  // build the parallel execution schedule
+  rc = _cmDspSysExecAlloc(p);
 
  errLabel:
   if( rc != kOkDspRC )
@@ -551,6 +1486,10 @@ cmDspRC_t cmDspSysUnload( cmDspSysH_t h )
 
   p->pgmIdx    = cmInvalidIdx;
 
+  // stop the execution worker threads before the instances are released
+  _cmDspSysExecFree(p);
+  _cmDspSysProfileFree(p);
+
   // unload the networking components
   _cmDspSysNetUnload(p);
 
@@ -691,19 +1630,35 @@ cmDspRC_t cmDspSysRcvMsg(    cmDspSysH_t h, cmAudioSysCtx_t* asCtx, const void*
     cmTimeSpec_t t0,t1;
     cmTimeGet(&t0);
 
-    for(; ip != NULL; ip = ip->linkPtr )
-      if( ip->instPtr->execFunc != NULL && cmIsFlag(ip->instPtr->flags,kDisableExecInstFl)==false )
-      {
-        if( ip->instPtr->execFunc(&p->ctx,ip->instPtr,NULL) != kOkDspRC )
-          cmErrMsg(&p->err,kInstExecFailDspRC,"Execution failed on DSP instance '%s' id:%i.",ip->instPtr->classPtr->labelStr,ip->instPtr->id);
+    if( p->exec != NULL )
+      _cmDspSysExecParallel(p);
+    else
+    {
+      _cmDspProf_t* pp = p->prof.enableFl ? &p->prof : NULL;
+      
+      for(; ip != NULL; ip = ip->linkPtr )
+        if( ip->instPtr->execFunc != NULL && cmIsFlag(ip->instPtr->flags,kDisableExecInstFl)==false )
+        {
+          if( _cmDspSysExecInst(pp,&p->ctx,ip->instPtr) != kOkDspRC )
+            cmErrMsg(&p->err,kInstExecFailDspRC,"Execution failed on DSP instance '%s' id:%i.",ip->instPtr->classPtr->labelStr,ip->instPtr->id);
 
-        //printf("%i %s\n",p->ctx.cycleCnt,ip->instPtr->classPtr->labelStr);
+          //printf("%i %s\n",p->ctx.cycleCnt,ip->instPtr->classPtr->labelStr);
 
-      }
+        }
+    }
 
     cmTimeGet(&t1);
     p->ctx.execDurUsecs = cmTimeElapsedMicros(&t0,&t1);
 
+    _cmDspSysExecUpdateStats(p,p->ctx.execDurUsecs);
+
+    // send the instance profile to the host
+    if( p->prof.enableFl && p->prof.reportCycleCnt > 0 && ++p->prof.cycleIdx >= p->prof.reportCycleCnt )
+    {
+      p->prof.cycleIdx = 0;
+      _cmDspSysProfileSend(p);
+    }
+
     ++p->ctx.cycleCnt;
   }
   else
@@ -52,6 +52,87 @@ extern "C" {
   // Print the loaded program (instances and connections) to a JSON file.
   cmDspRC_t cmDspSysPrintPgm( cmDspSysH_t h, const cmChar_t* outFn );
 
+  //----------------------------------------------------------------------------------------------------
+  // Parallel execution:
+  //
+  // By default the DSP instances are executed serially, in allocation order, 
+  // by the audio thread. When one or more worker threads are requested the
+  // instances are partitioned into independent sub-graphs and each sub-graph
+  // is assigned to an execution 'lane'. Lane 0 is executed by the audio thread
+  // and the remaining lanes are executed concurrently by the worker threads.
+  //
+  // Two instances are placed in the same sub-graph if they are connected by
+  // an audio connection or an event connection. Within each lane the instances
+  // are executed in audio data-flow order.  The audio thread waits for all
+  // lanes to complete before cmDspSysRcvMsg() returns. The workers block
+  // between cycles. If a worker has not started its lane shortly after
+  // the audio thread completes lane 0 the audio thread executes the lane
+  // itself (see cmDspSysExecStats_t.inlineLaneCnt). A lane which a worker
+  // has started is waited for at most one cycle period. If it has still not
+  // completed the audio thread returns without it, and the lane is skipped
+  // on the following cycles until the worker finishes
+  // (see cmDspSysExecStats_t.lateLaneCnt and skipLaneCnt).
+  //
+  // Notes:
+  // 1) Programs which use network (remote) connections are always executed serially.
+  // 2) DSP instances which allocate from the shared linked heap or symbol table,
+  // or which share state with other instances by means other than a connection
+  // (e.g. the global variable store), inside their exec function should not 
+  // be used with parallel execution.
+  // 3) The instances of a lane which was not waited for may still be executing
+  // when the audio thread delivers the next messages to the DSP system.
+
+  enum { kMaxExecLaneDspCnt = 32 };
+
+  typedef struct
+  {
+    unsigned laneCnt;            // count of execution lanes (1=serial execution)
+    unsigned cycleCnt;           // count of DSP cycles measured since the program was loaded
+    unsigned lastUsecs;          // execution time of the last cycle
+    unsigned maxUsecs;           // longest execution time
+    double   meanUsecs;          // average execution time
+    unsigned deadlineUsecs;      // duration of one DSP cycle (dspFramesPerCycle/srate)
+    unsigned overrunCnt;         // count of cycles whose execution time exceeded deadlineUsecs
+    unsigned inlineLaneCnt;      // count of worker lanes executed by the audio thread because the worker did not start in time
+    unsigned lateLaneCnt;        // count of worker lanes which the audio thread stopped waiting for
+    unsigned skipLaneCnt;        // count of cycles on which a worker lane was skipped because it was still executing an earlier cycle
+    unsigned laneInstCnt[ kMaxExecLaneDspCnt ];  // count of instances assigned to each lane 
+    unsigned laneUsecs[   kMaxExecLaneDspCnt ];  // execution time of each lane on the last cycle
+  } cmDspSysExecStats_t;
+
+  // Set the count of worker threads used to execute the DSP program (0=serial execution).
+  // The total count of lanes is threadCnt+1 but may be reduced if the program does not 
+  // contain enough independent sub-graphs.  This function must not be called while the
+  // audio system is running. If a program is currently loaded the execution schedule
+  // is rebuilt immediately otherwise it is built by the next call to cmDspSysLoad().
+  cmDspRC_t cmDspSysSetExecThreadCount( cmDspSysH_t h, unsigned threadCnt );
+  unsigned  cmDspSysExecThreadCount(    cmDspSysH_t h );
+
+  // Get the execution timing statistics for the current program.
+  cmDspRC_t cmDspSysExecStats( cmDspSysH_t h, cmDspSysExecStats_t* s );
+
+  // Print the execution schedule and statistics.
+  void      cmDspSysExecReport( cmDspSysH_t h, cmRpt_t* rpt );
+
+  //----------------------------------------------------------------------------------------------------
+  // Profiling:
+  //
+  // When profiling is enabled the duration of every instance exec function call is measured
+  // and the min/mean/max and 99th percentile (over the most recent calls) are maintained for
+  // each instance. When profiling is disabled the cost is a single test per instance per cycle.
+  //
+  // If 'reportCycleCnt' is non-zero a kDspProfileSelAsId message (cmAudioSysDspProfile_t)
+  // is sent to the host every 'reportCycleCnt' DSP cycles.
+  //
+  // Profiling may be enabled and disabled while the audio system is running.  
+  // Enabling the profiler clears the previously collected statistics.
+  cmDspRC_t cmDspSysProfileEnable(    cmDspSysH_t h, bool enableFl, unsigned reportCycleCnt );
+  bool      cmDspSysProfileIsEnabled( cmDspSysH_t h );
+
+  // Write the profile of every instance to a file. If the file name has a '.csv'
+  // extension then the file is written as CSV otherwise it is written as JSON.
+  cmDspRC_t cmDspSysProfileWrite(     cmDspSysH_t h, const cmChar_t* fn );
+
   //----------------------------------------------------------------------------------------------------
   // Preset function:
   //
@@ -12,6 +12,7 @@
 #include "cmComplexTypes.h"
 #include "cmAudioFile.h"
 #include "cmFileSys.h"
+#include "cmFftPlanCache.h"
 #include "cmSymTbl.h"
 #include "cmProcObj.h"
 #include "cmProc.h"
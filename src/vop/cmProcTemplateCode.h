@@ -57,7 +57,9 @@ cmRC_t        MEMBER(FftInit)(   CLASS(Fft)* p, T0*   inPtr, unsigned wndSmpCnt,
   p->complexV  = cmMemResize( COMPLEX_T0,   p->complexV, p->wndSmpCnt );
   p->inPtr     = p->copyFl ? cmMemResizeZ( T0, p->inPtr, p->wndSmpCnt ) : inPtr;
 
-  p->plan      = FFT_FUNC_T0(FftPlanAlloc)( p->wndSmpCnt, p->inPtr, p->complexV, FFTW_ESTIMATE );  
+  // the plan is shared with all other FFT's of the same size, precision and alignment
+  if((p->plan = FFT_FUNC_T0(FpcAlloc)( p->wndSmpCnt, false, p->inPtr, p->complexV )) == NULL )
+    return cmCtxRtCondition(&p->obj, cmSubSysFailRC, "FFT plan allocation failed.");
 
   //p->mfp       = cmCtxAllocDebugFile( p->obj.ctx,"fft");
   return cmOkRC;
@@ -73,7 +75,7 @@ cmRC_t        MEMBER(FftFinal)(  CLASS(Fft)* p )
 
     if( p->plan != NULL )
     {
-      FFT_FUNC_T0(FftPlanFree)( p->plan );
+      FFT_FUNC_T0(FpcRelease)( p->plan );
       p->plan = NULL;
     }
 
@@ -97,7 +99,7 @@ cmRC_t        MEMBER(FftExec)(  CLASS(Fft)* p, const T0*   sp, unsigned sn  )
   }
 
   // perform the Fourier transform
-  FFT_FUNC_T0(FftExecute)(p->plan);
+  FFT_FUNC_T0(FftExecuteR2C)(p->plan,p->inPtr,p->complexV);
 
   COMPLEX_T0* cp = p->complexV;
   T1*         mp = p->magV;
@@ -177,17 +179,23 @@ cmRC_t   MEMBER(IFftInit)(  CLASS(IFft)* p, unsigned binCnt )
   p->outV     = cmMemResizeZ(T1,         p->outV,    p->outN);
   p->complexV = cmMemResizeZ(COMPLEX_T1, p->complexV,p->outN);
 
-  if( p->binCnt != binCnt )
-  {
-    p->binCnt   = binCnt;
-    p->plan     =  FFT_FUNC_T1(IFftPlanAlloc)( p->outN, p->complexV, p->outV, FFTW_ESTIMATE );    
-  }
+  p->binCnt   = binCnt;
+
+  if((p->plan = FFT_FUNC_T1(FpcAlloc)( p->outN, true, p->outV, p->complexV )) == NULL )
+    return cmCtxRtCondition(&p->obj, cmSubSysFailRC, "IFFT plan allocation failed.");
 
   return cmOkRC;
 }
 
 cmRC_t   MEMBER(IFftFinal)( CLASS(IFft)* p )
-{ return cmOkRC; }
+{
+  if( p != NULL && p->plan != NULL )
+  {
+    FFT_FUNC_T1(FpcRelease)( p->plan );
+    p->plan = NULL;
+  }
+  return cmOkRC;
+}
 
 
   // x must contain 'binCnt' elements.
@@ -202,7 +210,7 @@ cmRC_t   MEMBER(IFftExec)(      CLASS(IFft)* p, COMPLEX_T0* x )
   for(i=p->outN-1,j=1; j<p->binCnt-1; --i,++j)
     p->complexV[i] = (COMPLEX_T1)conj(p->complexV[j]);
 
-  FFT_FUNC_T1(FftExecute)(p->plan);  
+  FFT_FUNC_T1(IFftExecuteC2R)(p->plan,p->complexV,p->outV);
 
   return cmOkRC;
 }
@@ -216,7 +224,7 @@ cmRC_t   MEMBER(IFftExecPolar)( CLASS(IFft)* p, const T0* magV, const T0* phsV )
   for(i=p->outN-1,j=1; j<p->binCnt-1; --i,++j)
     p->complexV[i] = (COMPLEX_T1)(magV[j] * cos(phsV[j])) + (magV[j] * I * sin(phsV[j]));
 
-  FFT_FUNC_T1(FftExecute)(p->plan);  
+  FFT_FUNC_T1(IFftExecuteC2R)(p->plan,p->complexV,p->outV);
 
   return cmOkRC;
 
@@ -231,7 +239,7 @@ cmRC_t   MEMBER(IFftExecRect)(  CLASS(IFft)* p, const T0* rV,   const T0* iV )
   for(i=p->outN-1,j=1; j<p->binCnt-1; --i,++j)
     p->complexV[i] = rV[j] + (I *  iV[j]);
 
-  FFT_FUNC_T1(FftExecute)(p->plan);  
+  FFT_FUNC_T1(IFftExecuteC2R)(p->plan,p->complexV,p->outV);
 
   return cmOkRC;
  
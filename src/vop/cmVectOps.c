@@ -12,6 +12,8 @@
 #include "cmLinkedHeap.h"
 #include "cmSymTbl.h"
 #include "cmMath.h"
+#include "cmThread.h"
+#include "cmTime.h"
 
 #ifdef OS_LINUX
 #include <cblas.h>
@@ -56,10 +56,13 @@ enum { kNoTtmFlags=0, kModifiedTtmFl=0x01 };
   // Constants for cmVOX_MultMMM1() and cmVOX_MultMMM2()
   enum { kTransposeM0Fl=0x01, kTransposeM1Fl=0x02 };
 
+  // Constants for cmVOX_Kmeans3()
+  enum { kRandSeedKmFl=0x01, kPlusPlusSeedKmFl=0x02 };
+
 #define kDefaultMelBandCnt  (36)
 #define kDefaultBarkBandCnt (24)
 
-
+#include "cmVectOpsSimd.h"
 #include "cmVectOpsTemplateMain.h"
 
 
@@ -441,11 +441,15 @@ VECT_OP_TYPE* VECT_OP_FUNC(SubVS)( VECT_OP_TYPE* bp, unsigned n, VECT_OP_TYPE v
 
 VECT_OP_TYPE* VECT_OP_FUNC(SubVV)( VECT_OP_TYPE* bp, unsigned n, const VECT_OP_TYPE* v )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(SubVV)(bp,n,v);
+#else
   const VECT_OP_TYPE* ep = bp + n;
   VECT_OP_TYPE* dp = bp;
   while( dp < ep )
     *dp++ -= *v++;
   return bp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(SubVVS)( VECT_OP_TYPE* bp, unsigned n, const VECT_OP_TYPE* v, VECT_OP_TYPE s )
@@ -469,11 +473,15 @@ VECT_OP_TYPE* VECT_OP_FUNC(SubVVNN)(VECT_OP_TYPE* dp, unsigned dn, unsigned dnn,
 
 VECT_OP_TYPE* VECT_OP_FUNC(SubVVV)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sb0p, const VECT_OP_TYPE* sb1p )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(SubVVV)(dbp,dn,sb0p,sb1p);
+#else
   const VECT_OP_TYPE* dep = dbp + dn;
   VECT_OP_TYPE* dp = dbp;
   while( dbp < dep )
     *dbp++ = *sb0p++ - *sb1p++;
   return dp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(SubVSV)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE s0, const VECT_OP_TYPE* sb1p )
@@ -487,20 +495,28 @@ VECT_OP_TYPE* VECT_OP_FUNC(SubVSV)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_O
 
 VECT_OP_TYPE* VECT_OP_FUNC(AddVS)( VECT_OP_TYPE* bp, unsigned n, VECT_OP_TYPE v )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(AddVS)(bp,n,v);
+#else
   const VECT_OP_TYPE* ep = bp + n;
   VECT_OP_TYPE* dp = bp;
   while( dp < ep )
     *dp++ += v;
   return bp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(AddVV)( VECT_OP_TYPE* bp, unsigned bn, const VECT_OP_TYPE* v )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(AddVV)(bp,bn,v);
+#else
   const VECT_OP_TYPE* ep = bp + bn;
   VECT_OP_TYPE* dp = bp;
   while( dp < ep )
     *dp++ += *v++;
   return bp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(AddVVS)( VECT_OP_TYPE* bp, unsigned bn, const VECT_OP_TYPE* v, VECT_OP_TYPE s )
@@ -523,29 +539,41 @@ VECT_OP_TYPE* VECT_OP_FUNC(AddVVNN)(VECT_OP_TYPE* dp, unsigned dn, unsigned dnn,
 
 VECT_OP_TYPE* VECT_OP_FUNC(AddVVV)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sb0p, const VECT_OP_TYPE* sb1p )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(AddVVV)(dbp,dn,sb0p,sb1p);
+#else
   const VECT_OP_TYPE* dep = dbp + dn;
   VECT_OP_TYPE* dp = dbp;
   while( dbp < dep )
     *dbp++ = *sb0p++ + *sb1p++;
   return dp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(MultVVV)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sb0p, const VECT_OP_TYPE* sb1p )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(MultVVV)(dbp,dn,sb0p,sb1p);
+#else
   const VECT_OP_TYPE* dep = dbp + dn;
   VECT_OP_TYPE* dp = dbp;
   while( dbp < dep )
     *dbp++ = *sb0p++ * *sb1p++;
   return dp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(MultVV)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sbp )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(MultVV)(dbp,dn,sbp);
+#else
   const VECT_OP_TYPE* dep = dbp + dn;
   VECT_OP_TYPE* dp = dbp;
   while( dbp < dep )
     *dbp++ *= *sbp++;
   return dp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(MultVVNN)(VECT_OP_TYPE* dp, unsigned dn, unsigned dnn, const VECT_OP_TYPE* v, unsigned n )
@@ -559,20 +587,28 @@ VECT_OP_TYPE* VECT_OP_FUNC(MultVVNN)(VECT_OP_TYPE* dp, unsigned dn, unsigned dnn
 
 VECT_OP_TYPE* VECT_OP_FUNC(MultVS)( VECT_OP_TYPE* dbp, unsigned dn, VECT_OP_TYPE s )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(MultVS)(dbp,dn,s);
+#else
   const VECT_OP_TYPE* dep = dbp + dn;
   VECT_OP_TYPE* dp = dbp;
   while( dbp < dep )
     *dbp++ *= s;
   return dp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(MultVVS)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sbp, VECT_OP_TYPE s )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(MultVVS)(dbp,dn,sbp,s);
+#else
   const VECT_OP_TYPE* dep = dbp + dn;
   VECT_OP_TYPE* dp = dbp;
   while( dbp < dep )
     *dbp++ = *sbp++ * s;
   return dp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(MultVaVS)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sbp, VECT_OP_TYPE s )
@@ -690,12 +726,16 @@ VECT_OP_TYPE*  VECT_OP_FUNC(DivMS)(    VECT_OP_TYPE* dp, unsigned drn, unsigned
 
 VECT_OP_TYPE  VECT_OP_FUNC(Sum)( const VECT_OP_TYPE* bp, unsigned n )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(Sum)(bp,n);
+#else
   const VECT_OP_TYPE* ep = bp + n;
   VECT_OP_TYPE s = 0;
   while( bp < ep )
     s += *bp++;
 
   return s;
+#endif
 }
 
 VECT_OP_TYPE  VECT_OP_FUNC(SumN)( const VECT_OP_TYPE* bp, unsigned n, unsigned stride )
@@ -0,0 +1,560 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+#include "cmPrefix.h"
+#include "cmGlobal.h"
+#include "cmRpt.h"
+#include "cmErr.h"
+#include "cmCtx.h"
+#include "cmMem.h"
+#include "cmMallocDebug.h"
+#include "cmTime.h"
+#include "cmVectOpsSimd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define cmVS_X86
+#include <immintrin.h>
+#endif
+
+//-----------------------------------------------------------------------------
+// PCM sample access used by the FromPcm() and ToPcm() kernels
+//
+
+// Return the count of bytes in a sample of format 'fmtId' (kXXXPcmVsId).
+static inline unsigned _cmVsPcmByteCnt( unsigned fmtId )
+{ return fmtId/2 + 1; }
+
+static inline int _cmVsPcmLd( const unsigned char* p, unsigned fmtId )
+{
+  switch( fmtId )
+  {
+    case kS8PcmVsId:    return (signed char)p[0];
+    case kU8PcmVsId:    return (int)p[0] - 128;
+    case kS16LePcmVsId: return (short)(p[0] | (p[1] << 8));
+    case kS16BePcmVsId: return (short)(p[1] | (p[0] << 8));
+    case kS24LePcmVsId: return (int)(((unsigned)p[0] << 8) | ((unsigned)p[1] << 16) | ((unsigned)p[2] << 24)) >> 8;
+    case kS24BePcmVsId: return (int)(((unsigned)p[2] << 8) | ((unsigned)p[1] << 16) | ((unsigned)p[0] << 24)) >> 8;
+    case kS32LePcmVsId: return (int)((unsigned)p[0] | ((unsigned)p[1] << 8) | ((unsigned)p[2] << 16) | ((unsigned)p[3] << 24));
+    case kS32BePcmVsId: return (int)((unsigned)p[3] | ((unsigned)p[2] << 8) | ((unsigned)p[1] << 16) | ((unsigned)p[0] << 24));
+  }
+  return 0;
+}
+
+static inline void _cmVsPcmSt( unsigned char* p, int v, unsigned fmtId )
+{
+  unsigned u = (unsigned)v;
+  switch( fmtId )
+  {
+    case kS8PcmVsId:    p[0] = u;                                               break;
+    case kU8PcmVsId:    p[0] = u + 128;                                         break;
+    case kS16LePcmVsId: p[0] = u;       p[1] = u >> 8;                          break;
+    case kS16BePcmVsId: p[0] = u >> 8;  p[1] = u;                               break;
+    case kS24LePcmVsId: p[0] = u;       p[1] = u >> 8;  p[2] = u >> 16;         break;
+    case kS24BePcmVsId: p[0] = u >> 16; p[1] = u >> 8;  p[2] = u;               break;
+    case kS32LePcmVsId: p[0] = u;       p[1] = u >> 8;  p[2] = u >> 16; p[3] = u >> 24; break;
+    case kS32BePcmVsId: p[0] = u >> 24; p[1] = u >> 16; p[2] = u >> 8;  p[3] = u;       break;
+  }
+}
+
+#ifdef cmVS_X86
+// Load four 24 bit samples as the low three bytes of four 32 bit words.
+static inline __attribute__((target("sse2"))) __m128i _cmVsSse2Ld24( const unsigned char* p )
+{
+  int a,b,c,d;
+  memcpy(&a,p,4); memcpy(&b,p+3,4); memcpy(&c,p+6,4); memcpy(&d,p+9,4);
+  return _mm_setr_epi32(a,b,c,d);
+}
+#endif
+
+//-----------------------------------------------------------------------------
+// Scalar kernels
+//
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE    float
+#define VS_FUNC(F) _cmVsScalarF_##F
+#include "cmVectOpsSimdCode.h"
+
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE    double
+#define VS_FUNC(F) _cmVsScalarD_##F
+#include "cmVectOpsSimdCode.h"
+
+#ifdef cmVS_X86
+
+//-----------------------------------------------------------------------------
+// SSE2 kernels
+//
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE                float
+#define VS_FUNC(F)             _cmVsSse2F_##F
+#define VS_ATTR                __attribute__((target("sse2")))
+#define VS_IS_FLOAT            1
+#define VS_N                   4
+#define VS_V                   __m128
+#define VS_LD(p)               _mm_loadu_ps(p)
+#define VS_ST(p,v)             _mm_storeu_ps(p,v)
+#define VS_SET1(x)             _mm_set1_ps(x)
+#define VS_ZERO()              _mm_setzero_ps()
+#define VS_ADD(a,b)            _mm_add_ps(a,b)
+#define VS_SUB(a,b)            _mm_sub_ps(a,b)
+#define VS_MUL(a,b)            _mm_mul_ps(a,b)
+#define VS_DIV(a,b)            _mm_div_ps(a,b)
+#define VS_SQRT(a)             _mm_sqrt_ps(a)
+#define VS_VD                  __m128d
+#define VS_ND                  2
+#define VS_ST_D(p,v)           _mm_storeu_pd(p,v)
+#define VS_ZERO_D()            _mm_setzero_pd()
+#define VS_ADD_D(a,b)          _mm_add_pd(a,b)
+#define VS_MUL_D(a,b)          _mm_mul_pd(a,b)
+#define VS_CVT_LO_D(v)         _mm_cvtps_pd(v)
+#define VS_CVT_HI_D(v)         _mm_cvtps_pd(_mm_movehl_ps(v,v))
+#define VS_I                   __m128i
+#define VS_CAST_I(v)           _mm_castps_si128(v)
+#define VS_CAST_F(v)           _mm_castsi128_ps(v)
+#define VS_SRLI(v,n)           _mm_srli_epi32(v,n)
+#define VS_SLLI(v,n)           _mm_slli_epi32(v,n)
+#define VS_AND_I(a,b)          _mm_and_si128(a,b)
+#define VS_OR_I(a,b)           _mm_or_si128(a,b)
+#define VS_ADD_I(a,b)          _mm_add_epi32(a,b)
+#define VS_SUB_I(a,b)          _mm_sub_epi32(a,b)
+#define VS_SET1_I(x)           _mm_set1_epi32(x)
+#define VS_CVT_IF(v)           _mm_cvtepi32_ps(v)
+#define VS_CVT_FI(v)           _mm_cvtps_epi32(v)
+#define VS_SELECT_LT(a,b,x,y)  _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(a,b),x),_mm_andnot_ps(_mm_cmplt_ps(a,b),y))
+#define VS_ALL_IN(x,lo,hi)     (_mm_movemask_ps(_mm_and_ps(_mm_cmpge_ps(x,lo),_mm_cmple_ps(x,hi))) == 0xf)
+#define VS_SRAI(v,n)           _mm_srai_epi32(v,n)
+#define VS_CVTT_FI(v)          _mm_cvttps_epi32(v)
+#define VS_LD_I(p)             _mm_loadu_si128((const __m128i*)(p))
+#define VS_ST_I(p,v)           _mm_storeu_si128((__m128i*)(p),v)
+#define VS_LD_S16(p)           _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(),_mm_loadl_epi64((const __m128i*)(p))),16)
+#define VS_ST_S16(p,v)         _mm_storel_epi64((__m128i*)(p),_mm_packs_epi32(v,v))
+#define VS_LD_24(p)            _cmVsSse2Ld24(p)
+#include "cmVectOpsSimdCode.h"
+
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE                double
+#define VS_FUNC(F)             _cmVsSse2D_##F
+#define VS_ATTR                __attribute__((target("sse2")))
+#define VS_IS_FLOAT            0
+#define VS_N                   2
+#define VS_V                   __m128d
+#define VS_LD(p)               _mm_loadu_pd(p)
+#define VS_ST(p,v)             _mm_storeu_pd(p,v)
+#define VS_SET1(x)             _mm_set1_pd(x)
+#define VS_ZERO()              _mm_setzero_pd()
+#define VS_ADD(a,b)            _mm_add_pd(a,b)
+#define VS_SUB(a,b)            _mm_sub_pd(a,b)
+#define VS_MUL(a,b)            _mm_mul_pd(a,b)
+#include "cmVectOpsSimdCode.h"
+
+//-----------------------------------------------------------------------------
+// AVX2 kernels
+//
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE                float
+#define VS_FUNC(F)             _cmVsAvx2F_##F
+#define VS_ATTR                __attribute__((target("avx2")))
+#define VS_IS_FLOAT            1
+#define VS_N                   8
+#define VS_V                   __m256
+#define VS_LD(p)               _mm256_loadu_ps(p)
+#define VS_ST(p,v)             _mm256_storeu_ps(p,v)
+#define VS_SET1(x)             _mm256_set1_ps(x)
+#define VS_ZERO()              _mm256_setzero_ps()
+#define VS_ADD(a,b)            _mm256_add_ps(a,b)
+#define VS_SUB(a,b)            _mm256_sub_ps(a,b)
+#define VS_MUL(a,b)            _mm256_mul_ps(a,b)
+#define VS_DIV(a,b)            _mm256_div_ps(a,b)
+#define VS_SQRT(a)             _mm256_sqrt_ps(a)
+#define VS_VD                  __m256d
+#define VS_ND                  4
+#define VS_ST_D(p,v)           _mm256_storeu_pd(p,v)
+#define VS_ZERO_D()            _mm256_setzero_pd()
+#define VS_ADD_D(a,b)          _mm256_add_pd(a,b)
+#define VS_MUL_D(a,b)          _mm256_mul_pd(a,b)
+#define VS_CVT_LO_D(v)         _mm256_cvtps_pd(_mm256_castps256_ps128(v))
+#define VS_CVT_HI_D(v)         _mm256_cvtps_pd(_mm256_extractf128_ps(v,1))
+#define VS_I                   __m256i
+#define VS_CAST_I(v)           _mm256_castps_si256(v)
+#define VS_CAST_F(v)           _mm256_castsi256_ps(v)
+#define VS_SRLI(v,n)           _mm256_srli_epi32(v,n)
+#define VS_SLLI(v,n)           _mm256_slli_epi32(v,n)
+#define VS_AND_I(a,b)          _mm256_and_si256(a,b)
+#define VS_OR_I(a,b)           _mm256_or_si256(a,b)
+#define VS_ADD_I(a,b)          _mm256_add_epi32(a,b)
+#define VS_SUB_I(a,b)          _mm256_sub_epi32(a,b)
+#define VS_SET1_I(x)           _mm256_set1_epi32(x)
+#define VS_CVT_IF(v)           _mm256_cvtepi32_ps(v)
+#define VS_CVT_FI(v)           _mm256_cvtps_epi32(v)
+#define VS_SELECT_LT(a,b,x,y)  _mm256_blendv_ps(y,x,_mm256_cmp_ps(a,b,_CMP_LT_OQ))
+#define VS_ALL_IN(x,lo,hi)     (_mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(x,lo,_CMP_GE_OQ),_mm256_cmp_ps(x,hi,_CMP_LE_OQ))) == 0xff)
+#define VS_SRAI(v,n)           _mm256_srai_epi32(v,n)
+#define VS_CVTT_FI(v)          _mm256_cvttps_epi32(v)
+#define VS_LD_I(p)             _mm256_loadu_si256((const __m256i*)(p))
+#define VS_ST_I(p,v)           _mm256_storeu_si256((__m256i*)(p),v)
+#define VS_LD_S16(p)           _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(p)))
+#define VS_ST_S16(p,v)         _mm_storeu_si128((__m128i*)(p),_mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packs_epi32(v,v),0x08)))
+#define VS_LD_24(p)            _mm256_i32gather_epi32((const int*)(p),_mm256_setr_epi32(0,3,6,9,12,15,18,21),1)
+#include "cmVectOpsSimdCode.h"
+
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE                double
+#define VS_FUNC(F)             _cmVsAvx2D_##F
+#define VS_ATTR                __attribute__((target("avx2")))
+#define VS_IS_FLOAT            0
+#define VS_N                   4
+#define VS_V                   __m256d
+#define VS_LD(p)               _mm256_loadu_pd(p)
+#define VS_ST(p,v)             _mm256_storeu_pd(p,v)
+#define VS_SET1(x)             _mm256_set1_pd(x)
+#define VS_ZERO()              _mm256_setzero_pd()
+#define VS_ADD(a,b)            _mm256_add_pd(a,b)
+#define VS_SUB(a,b)            _mm256_sub_pd(a,b)
+#define VS_MUL(a,b)            _mm256_mul_pd(a,b)
+#include "cmVectOpsSimdCode.h"
+
+//-----------------------------------------------------------------------------
+// AVX-512 kernels
+//
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE                float
+#define VS_FUNC(F)             _cmVsAvx512F_##F
+#define VS_ATTR                __attribute__((target("avx512f")))
+#define VS_IS_FLOAT            1
+#define VS_N                   16
+#define VS_V                   __m512
+#define VS_LD(p)               _mm512_loadu_ps(p)
+#define VS_ST(p,v)             _mm512_storeu_ps(p,v)
+#define VS_SET1(x)             _mm512_set1_ps(x)
+#define VS_ZERO()              _mm512_setzero_ps()
+#define VS_ADD(a,b)            _mm512_add_ps(a,b)
+#define VS_SUB(a,b)            _mm512_sub_ps(a,b)
+#define VS_MUL(a,b)            _mm512_mul_ps(a,b)
+#define VS_DIV(a,b)            _mm512_div_ps(a,b)
+#define VS_SQRT(a)             _mm512_sqrt_ps(a)
+#define VS_VD                  __m512d
+#define VS_ND                  8
+#define VS_ST_D(p,v)           _mm512_storeu_pd(p,v)
+#define VS_ZERO_D()            _mm512_setzero_pd()
+#define VS_ADD_D(a,b)          _mm512_add_pd(a,b)
+#define VS_MUL_D(a,b)          _mm512_mul_pd(a,b)
+#define VS_CVT_LO_D(v)         _mm512_cvtps_pd(_mm512_castps512_ps256(v))
+#define VS_CVT_HI_D(v)         _mm512_cvtps_pd(_mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(v),1)))
+#define VS_I                   __m512i
+#define VS_CAST_I(v)           _mm512_castps_si512(v)
+#define VS_CAST_F(v)           _mm512_castsi512_ps(v)
+#define VS_SRLI(v,n)           _mm512_srli_epi32(v,n)
+#define VS_SLLI(v,n)           _mm512_slli_epi32(v,n)
+#define VS_AND_I(a,b)          _mm512_and_si512(a,b)
+#define VS_OR_I(a,b)           _mm512_or_si512(a,b)
+#define VS_ADD_I(a,b)          _mm512_add_epi32(a,b)
+#define VS_SUB_I(a,b)          _mm512_sub_epi32(a,b)
+#define VS_SET1_I(x)           _mm512_set1_epi32(x)
+#define VS_CVT_IF(v)           _mm512_cvtepi32_ps(v)
+#define VS_CVT_FI(v)           _mm512_cvtps_epi32(v)
+#define VS_SELECT_LT(a,b,x,y)  _mm512_mask_blend_ps(_mm512_cmp_ps_mask(a,b,_CMP_LT_OQ),y,x)
+#define VS_ALL_IN(x,lo,hi)     ((_mm512_cmp_ps_mask(x,lo,_CMP_GE_OQ) & _mm512_cmp_ps_mask(x,hi,_CMP_LE_OQ)) == 0xffff)
+#define VS_SRAI(v,n)           _mm512_srai_epi32(v,n)
+#define VS_CVTT_FI(v)          _mm512_cvttps_epi32(v)
+#define VS_LD_I(p)             _mm512_loadu_si512((const void*)(p))
+#define VS_ST_I(p,v)           _mm512_storeu_si512((void*)(p),v)
+#define VS_LD_S16(p)           _mm512_cvtepi16_epi32(_mm256_loadu_si256((const __m256i*)(p)))
+#define VS_ST_S16(p,v)         _mm256_storeu_si256((__m256i*)(p),_mm512_cvtsepi32_epi16(v))
+#define VS_LD_24(p)            _mm512_i32gather_epi32(_mm512_setr_epi32(0,3,6,9,12,15,18,21,24,27,30,33,36,39,42,45),(const void*)(p),1)
+#include "cmVectOpsSimdCode.h"
+
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE                double
+#define VS_FUNC(F)             _cmVsAvx512D_##F
+#define VS_ATTR                __attribute__((target("avx512f")))
+#define VS_IS_FLOAT            0
+#define VS_N                   8
+#define VS_V                   __m512d
+#define VS_LD(p)               _mm512_loadu_pd(p)
+#define VS_ST(p,v)             _mm512_storeu_pd(p,v)
+#define VS_SET1(x)             _mm512_set1_pd(x)
+#define VS_ZERO()              _mm512_setzero_pd()
+#define VS_ADD(a,b)            _mm512_add_pd(a,b)
+#define VS_SUB(a,b)            _mm512_sub_pd(a,b)
+#define VS_MUL(a,b)            _mm512_mul_pd(a,b)
+#include "cmVectOpsSimdCode.h"
+
+#endif // cmVS_X86
+
+//-----------------------------------------------------------------------------
+// Kernel set selection
+//
+
+static unsigned _cmVsId = cmInvalidId;
+
+static const cmChar_t* _cmVsLabelArray[ kVsIdCnt ] = { "scalar", "sse2", "avx2", "avx512" };
+
+bool cmVsIsSupported( unsigned vsId )
+{
+  switch( vsId )
+  {
+    case kScalarVsId: return true;
+#ifdef cmVS_X86
+    case kSse2VsId:   return __builtin_cpu_supports("sse2");
+    case kAvx2VsId:   return __builtin_cpu_supports("avx2");
+    case kAvx512VsId: return __builtin_cpu_supports("avx512f");
+#endif
+  }
+  return false;
+}
+
+unsigned cmVsSelect( unsigned vsId )
+{
+  if( vsId == cmInvalidId )
+  {
+    // select the widest supported kernel set
+    for(vsId=kVsIdCnt-1; vsId>kScalarVsId; --vsId)
+      if( cmVsIsSupported(vsId) )
+        break;
+  }
+
+  if( cmVsIsSupported(vsId) )
+    _cmVsId = vsId;
+
+  return cmVsSelectedId();
+}
+
+unsigned cmVsSelectedId()
+{
+  if( _cmVsId == cmInvalidId )
+    cmVsSelect(cmInvalidId);
+  return _cmVsId;
+}
+
+const cmChar_t* cmVsLabel( unsigned vsId )
+{ return vsId < kVsIdCnt ? _cmVsLabelArray[vsId] : "<invalid>"; }
+
+//-----------------------------------------------------------------------------
+// Integer PCM conversion
+//
+
+int* cmVsI_FromPcm( int* dbp, unsigned dn, const void* sbp, unsigned sStride, unsigned fmtId, bool sumFl )
+{
+  const unsigned char* sp = (const unsigned char*)sbp;
+  unsigned             i;
+
+  if( sumFl )
+    for(i=0; i<dn; ++i,sp+=sStride)
+      dbp[i] += _cmVsPcmLd(sp,fmtId);
+  else
+    for(i=0; i<dn; ++i,sp+=sStride)
+      dbp[i]  = _cmVsPcmLd(sp,fmtId);
+
+  return dbp;
+}
+
+void* cmVsI_ToPcm( void* dbp, const int* sbp, unsigned sn, unsigned fmtId )
+{
+  unsigned char* dp = (unsigned char*)dbp;
+  unsigned       bn = _cmVsPcmByteCnt(fmtId);
+  unsigned       i;
+
+  for(i=0; i<sn; ++i)
+    _cmVsPcmSt(dp + i*bn,sbp[i],fmtId);
+
+  return dbp;
+}
+
+//-----------------------------------------------------------------------------
+// Public functions
+//
+
+#ifdef cmVS_X86
+#define _cmVS_DISPATCH(T,F,args)                                \
+  switch( cmVsSelectedId() )                                    \
+  {                                                             \
+    case kAvx512VsId: return _cmVsAvx512##T##_##F args;         \
+    case kAvx2VsId:   return _cmVsAvx2##T##_##F args;           \
+    case kSse2VsId:   return _cmVsSse2##T##_##F args;           \
+  }                                                             \
+  return _cmVsScalar##T##_##F args
+#else
+#define _cmVS_DISPATCH(T,F,args) return _cmVsScalar##T##_##F args
+#endif
+
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE                float
+#define VS_FUNC(F)             cmVsF_##F
+#define VS_DISPATCH(fn,args)   _cmVS_DISPATCH(F,fn,args)
+#include "cmVectOpsSimdCode.h"
+
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE                double
+#define VS_FUNC(F)             cmVsD_##F
+#define VS_DISPATCH(fn,args)   _cmVS_DISPATCH(D,fn,args)
+#include "cmVectOpsSimdCode.h"
+
+#include "cmVectOpsSimdUndef.h"
+
+//-----------------------------------------------------------------------------
+// Test and benchmark
+//
+
+enum
+{
+  kAddVVV_VsTId,
+  kMultVVV_VsTId,
+  kMultVS_VsTId,
+  kSum_VsTId,
+  kSquaredSum_VsTId,
+  kSquaredSumD_VsTId,
+  kMultSumVV_VsTId,
+  kFirVV_VsTId,
+  kLog10VV_VsTId,
+  kExp10VV_VsTId,
+  kPolarD_VsTId,
+  kPcm16Be_VsTId,
+  kPcm24Le_VsTId,
+  kVsTIdCnt
+};
+
+static const cmChar_t* _cmVsTestLabelArray[ kVsTIdCnt ] =
+{ "AddVVV", "MultVVV", "MultVS", "Sum", "SquaredSum", "SquaredSumD", "MultSumVV", "FirVV", "Log10VV", "Exp10VV", "PolarD", "Pcm16Be", "Pcm24Le" };
+
+// PCM buffer used by the PCM round trip tests.
+static unsigned char* _cmVsTestPcmBuf = NULL;
+
+// Execute kernel 'tid' on float (dblFl==false) or double vectors.
+// Reductions store their result in d[0]. PolarD() converts s0[0:n/2] + j*s0[n/2:n]
+// and stores the magnitude in double d[0:n/2] and the phase in double d[n/2:n].
+// The PCM tests encode s0 with ToPcm() and decode the result with FromPcm().
+static void _cmVsTestExec( unsigned tid, bool dblFl, void* d, const void* s0, const void* s1, unsigned n )
+{
+  float*        fd  = (float*)d;
+  const float*  fs0 = (const float*)s0;
+  const float*  fs1 = (const float*)s1;
+  double*       dd  = (double*)d;
+  const double* ds0 = (const double*)s0;
+  const double* ds1 = (const double*)s1;
+
+  switch( tid )
+  {
+    case kAddVVV_VsTId:      if(dblFl) cmVsD_AddVVV(dd,n,ds0,ds1);          else cmVsF_AddVVV(fd,n,fs0,fs1);           break;
+    case kMultVVV_VsTId:     if(dblFl) cmVsD_MultVVV(dd,n,ds0,ds1);         else cmVsF_MultVVV(fd,n,fs0,fs1);          break;
+    case kMultVS_VsTId:      if(dblFl) cmVsD_MultVVS(dd,n,ds0,0.5);         else cmVsF_MultVVS(fd,n,fs0,0.5f);         break;
+    case kSum_VsTId:         if(dblFl) dd[0] = cmVsD_Sum(ds0,n);            else fd[0] = cmVsF_Sum(fs0,n);             break;
+    case kSquaredSum_VsTId:  if(dblFl) dd[0] = cmVsD_SquaredSum(ds0,n);     else fd[0] = cmVsF_SquaredSum(fs0,n);      break;
+    case kSquaredSumD_VsTId: if(dblFl) dd[0] = cmVsD_SquaredSumD(ds0,n);    else fd[0] = cmVsF_SquaredSumD(fs0,n);     break;
+    case kMultSumVV_VsTId:   if(dblFl) dd[0] = cmVsD_MultSumVV(ds0,ds1,n);  else fd[0] = cmVsF_MultSumVV(fs0,fs1,n);   break;
+    case kFirVV_VsTId:       if(dblFl) cmVsD_FirVV(dd,n-63,ds0,ds1,64);     else cmVsF_FirVV(fd,n-63,fs0,fs1,64);      break;
+    case kLog10VV_VsTId:     if(dblFl) cmVsD_Log10VV(dd,n,ds1,0,20,1e-6,-120); else cmVsF_Log10VV(fd,n,fs1,0,20,1e-6f,-120); break;
+    case kExp10VV_VsTId:     if(dblFl) cmVsD_Exp10VV(dd,n,ds0,20.0/120.0);  else cmVsF_Exp10VV(fd,n,fs0,20.0/120.0);   break;
+    case kPolarD_VsTId:      if(dblFl) cmVsD_PolarD(dd,dd+n/2,n/2,ds0,ds0+n/2); else cmVsF_PolarD(dd,dd+n/2,n/2,fs0,fs0+n/2); break;
+
+    case kPcm16Be_VsTId:
+      if(dblFl) cmVsD_FromPcm(dd,n,cmVsD_ToPcm(_cmVsTestPcmBuf,ds0,n,kS16BePcmVsId,32767.0),2,kS16BePcmVsId,1.0/32768.0);
+      else      cmVsF_FromPcm(fd,n,cmVsF_ToPcm(_cmVsTestPcmBuf,fs0,n,kS16BePcmVsId,32767.0f),2,kS16BePcmVsId,1.0f/32768.0f);
+      break;
+
+    case kPcm24Le_VsTId:
+      if(dblFl) cmVsD_FromPcm(dd,n,cmVsD_ToPcm(_cmVsTestPcmBuf,ds0,n,kS24LePcmVsId,8388607.0),3,kS24LePcmVsId,1.0/8388608.0);
+      else      cmVsF_FromPcm(fd,n,cmVsF_ToPcm(_cmVsTestPcmBuf,fs0,n,kS24LePcmVsId,8388607.0f),3,kS24LePcmVsId,1.0f/8388608.0f);
+      break;
+  }
+}
+
+static unsigned _cmVsTestResultCount( unsigned tid, unsigned n )
+{
+  switch( tid )
+  {
+    case kSum_VsTId:
+    case kSquaredSum_VsTId:
+    case kSquaredSumD_VsTId:
+    case kMultSumVV_VsTId:
+      return 1;
+
+    case kFirVV_VsTId:
+      return n-63;  // 64 tap filter
+  }
+  return n;
+}
+
+void cmVsTest( cmRpt_t* rpt )
+{
+  const unsigned n      = 1024;  // vector length
+  const unsigned iterN  = 2000;  // count of kernel calls timed per kernel
+  const unsigned orgId  = cmVsSelectedId();
+  unsigned       dbl,tid,vsId,i,j;
+
+  // s0 = [-1,1), s1 = (0,1] - the Exp10VV() test maps s0 to [-120,120] dB
+  double* s0 = cmMemAllocZ(double,n);
+  double* s1 = cmMemAllocZ(double,n);
+  double* d0 = cmMemAllocZ(double,n);
+  double* d1 = cmMemAllocZ(double,n);
+  float*  f0 = cmMemAllocZ(float,n);
+  float*  f1 = cmMemAllocZ(float,n);
+
+  _cmVsTestPcmBuf = cmMemAllocZ(unsigned char,n*4);
+
+  for(i=0; i<n; ++i)
+  {
+    s0[i] = 2.0 * rand() / RAND_MAX - 1.0;
+    s1[i] = (1.0 + rand()) / (1.0 + RAND_MAX);
+    f0[i] = s0[i];
+    f1[i] = s1[i];
+  }
+
+  cmRptPrintf(rpt,"n:%i iterations:%i (err: max. |a-b|/max(|a|,1) where a is the scalar result)\n",n,iterN);
+
+  for(dbl=0; dbl<2; ++dbl)
+    for(tid=0; tid<kVsTIdCnt; ++tid)
+    {
+      const void* a0     = dbl ? (const void*)s0 : (const void*)f0;
+      const void* a1     = dbl ? (const void*)s1 : (const void*)f1;
+      unsigned    rn     = _cmVsTestResultCount(tid,n);
+      double      ns0    = 0;
+
+      cmRptPrintf(rpt,"%-12s %s ",_cmVsTestLabelArray[tid], dbl ? "dbl" : "flt");
+
+      for(vsId=0; vsId<kVsIdCnt; ++vsId)
+      {
+        if( !cmVsIsSupported(vsId) )
+          continue;
+
+        cmVsSelect(vsId);
+
+        // d0 holds the scalar result, d1 the result under test
+        void* dp = vsId == kScalarVsId ? (void*)d0 : (void*)d1;
+
+        cmTimeSpec_t t0,t1;
+        cmTimeGetMonotonic(&t0);
+
+        for(i=0; i<iterN; ++i)
+          _cmVsTestExec(tid,dbl,dp,a0,a1,n);
+
+        cmTimeGetMonotonic(&t1);
+
+        double ns  = (double)cmTimeElapsedNanos(&t0,&t1) / iterN;
+        double err = 0;
+
+        if( vsId == kScalarVsId )
+          ns0 = ns;
+        else
+          for(j=0; j<rn; ++j)
+          {
+            bool   dFl = dbl || tid == kPolarD_VsTId;  // PolarD() always produces double results
+            double v0  = dFl ? d0[j] : ((float*)d0)[j];
+            double v1  = dFl ? d1[j] : ((float*)d1)[j];
+            err = cmMax(err,fabs(v0-v1)/cmMax(fabs(v0),1.0));
+          }
+
+        cmRptPrintf(rpt,"| %s %8.0f ns x%5.2f err:%8.2g ",cmVsLabel(vsId),ns,ns>0 ? ns0/ns : 0,err);
+      }
+
+      cmRptPrintf(rpt,"\n");
+    }
+
+  cmVsSelect(orgId);
+
+  cmMemFree(s0);
+  cmMemFree(s1);
+  cmMemFree(d0);
+  cmMemFree(d1);
+  cmMemFree(f0);
+  cmMemFree(f1);
+  cmMemPtrFree(&_cmVsTestPcmBuf);
+}
@@ -0,0 +1,108 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+#ifndef cmVectOpsSimd_h
+#define cmVectOpsSimd_h
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  //( { file_desc:"Explicitly vectorized kernels for the float and double cmVectOps functions." kw:[vop] }
+  //
+  // The cmVsF_XXX() (float) and cmVsD_XXX() (double) functions are called from the
+  // cmVOF_, cmVOD_, cmVOS_ and cmVOR_ template functions of the same name.
+  // Each kernel has a scalar, SSE2, AVX2 and AVX-512 implementation.
+  // The best implementation supported by the CPU is selected the first time a kernel
+  // is called. Use cmVsSelect() to force a particular implementation.
+  //
+  // Results:
+  // Element-wise kernels (AddVVV,SubVVV,MultVVV,AddVV,SubVV,MultVV,AddVS,MultVS,MultVVS)
+  // are bit-exact with the scalar implementation.
+  //
+  // Reductions (Sum,SquaredSum,SquaredSumD,MultSumVV) accumulate in VS_N parallel
+  // partial sums and therefore differ from the scalar result only by the order of
+  // summation. SquaredSumD() accumulates in double for both float and double vectors.
+  //
+  // The float Log10VV() and Exp10VV() kernels use polynomial approximations.
+  // Log10VV() is within 2.1e-7 (relative, or absolute for results less than 1) of
+  // log10() and Exp10VV() is within 1e-6 (relative) of pow(10,x) for |x| <= 6
+  // (the error grows with |x| because x is rounded to float). Chunks containing zero, negative, denormal, inf or NaN
+  // arguments to log10 or arguments to 10^x outside of [-126*log10(2),127*log10(2)]
+  // are computed with the scalar code. The double versions of these kernels
+  // always use the scalar code.
+  //
+  // The PCM conversion kernels (FromPcm,ToPcm) are bit-exact with the scalar kernels.
+  // Only the float kernels are vectorized and only for contiguous samples.
+  // The 8 bit formats are always converted by the scalar code.
+  //
+  // The FIR kernels (FirVV,FirMC) vectorize across output samples and accumulate
+  // each output in coefficient order. They are bit-exact with the scalar kernels
+  // except with the AVX-512 kernel set where the compiler contracts the multiply-add
+  // into FMA instructions (float 64 tap error: 9.5e-7).
+  //
+
+  enum
+  {
+    kScalarVsId,
+    kSse2VsId,
+    kAvx2VsId,
+    kAvx512VsId,
+    kVsIdCnt
+  };
+
+  // PCM sample formats for the FromPcm() and ToPcm() kernels.
+  enum
+  {
+    kS8PcmVsId,     // signed 8 bit
+    kU8PcmVsId,     // unsigned 8 bit with a 128 offset
+    kS16LePcmVsId,  // signed 16 bit little-endian
+    kS16BePcmVsId,  // signed 16 bit big-endian
+    kS24LePcmVsId,  // signed 24 bit little-endian
+    kS24BePcmVsId,  // signed 24 bit big-endian
+    kS32LePcmVsId,  // signed 32 bit little-endian
+    kS32BePcmVsId   // signed 32 bit big-endian
+  };
+
+  // Return true if the CPU supports the kernel set identified by 'vsId'.
+  bool            cmVsIsSupported( unsigned vsId );
+
+  // Select the kernel set used by the cmVsX_XXX() functions.
+  // Set vsId to cmInvalidId to select the best supported kernel set.
+  // Returns the id of the selected kernel set. If 'vsId' is not supported
+  // the selection is not changed.
+  unsigned        cmVsSelect( unsigned vsId );
+
+  // Return the id of the kernel set currently in use.
+  unsigned        cmVsSelectedId();
+
+  // Return a label for the kernel set identified by vsId.
+  const cmChar_t* cmVsLabel( unsigned vsId );
+
+  // Verify each supported kernel set against the scalar kernels and time each kernel.
+  void            cmVsTest( cmRpt_t* rpt );
+
+  // Integer PCM sample conversion (fmtId is one of kXXXPcmVsId). The samples are
+  // decoded and encoded as by the FromPcm() and ToPcm() kernels but are not scaled.
+  // cmVsI_FromPcm(): dbp[i] = x[i] (or dbp[i] += x[i] if sumFl is set) where x[i] is the sample at sbp + i*sStride bytes.
+  // cmVsI_ToPcm():   encode the low order bytes of sbp[i] at dbp + i*(sample byte count).
+  int*            cmVsI_FromPcm( int* dbp, unsigned dn, const void* sbp, unsigned sStride, unsigned fmtId, bool sumFl );
+  void*           cmVsI_ToPcm(   void* dbp, const int* sbp, unsigned sn, unsigned fmtId );
+
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE    float
+#define VS_FUNC(F) cmVsF_##F
+#include "cmVectOpsSimdHdr.h"
+
+#include "cmVectOpsSimdUndef.h"
+#define VS_TYPE    double
+#define VS_FUNC(F) cmVsD_##F
+#include "cmVectOpsSimdHdr.h"
+#include "cmVectOpsSimdUndef.h"
+
+  //)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,867 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+
+// This file is included once for each kernel set and value type by cmVectOpsSimd.c.
+//
+// VS_DISPATCH defined - generate the public cmVsX_XXX() functions which call the selected kernel set.
+// VS_N defined        - generate the vector kernels using the VS_XXX() instruction macros.
+// otherwise           - generate the scalar kernels.
+
+#if defined(VS_DISPATCH)
+
+VS_TYPE* VS_FUNC(AddVVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p )
+{ VS_DISPATCH(AddVVV,(dbp,dn,sb0p,sb1p)); }
+
+VS_TYPE* VS_FUNC(SubVVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p )
+{ VS_DISPATCH(SubVVV,(dbp,dn,sb0p,sb1p)); }
+
+VS_TYPE* VS_FUNC(MultVVV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p )
+{ VS_DISPATCH(MultVVV,(dbp,dn,sb0p,sb1p)); }
+
+VS_TYPE* VS_FUNC(AddVV)(   VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp )
+{ VS_DISPATCH(AddVV,(dbp,dn,sbp)); }
+
+VS_TYPE* VS_FUNC(SubVV)(   VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp )
+{ VS_DISPATCH(SubVV,(dbp,dn,sbp)); }
+
+VS_TYPE* VS_FUNC(MultVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp )
+{ VS_DISPATCH(MultVV,(dbp,dn,sbp)); }
+
+VS_TYPE* VS_FUNC(AddVS)(   VS_TYPE* dbp, unsigned dn, VS_TYPE s )
+{ VS_DISPATCH(AddVS,(dbp,dn,s)); }
+
+VS_TYPE* VS_FUNC(MultVS)(  VS_TYPE* dbp, unsigned dn, VS_TYPE s )
+{ VS_DISPATCH(MultVS,(dbp,dn,s)); }
+
+VS_TYPE* VS_FUNC(MultVVS)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, VS_TYPE s )
+{ VS_DISPATCH(MultVVS,(dbp,dn,sbp,s)); }
+
+VS_TYPE  VS_FUNC(Sum)(         const VS_TYPE* sbp, unsigned sn )
+{ VS_DISPATCH(Sum,(sbp,sn)); }
+
+VS_TYPE  VS_FUNC(SquaredSum)(  const VS_TYPE* sbp, unsigned sn )
+{ VS_DISPATCH(SquaredSum,(sbp,sn)); }
+
+double   VS_FUNC(SquaredSumD)( const VS_TYPE* sbp, unsigned sn )
+{ VS_DISPATCH(SquaredSumD,(sbp,sn)); }
+
+VS_TYPE  VS_FUNC(MultSumVV)(   const VS_TYPE* s0p, const VS_TYPE* s1p, unsigned sn )
+{ VS_DISPATCH(MultSumVV,(s0p,s1p,sn)); }
+
+VS_TYPE* VS_FUNC(FirVV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, const VS_TYPE* hrp, unsigned hn )
+{ VS_DISPATCH(FirVV,(dbp,dn,sbp,hrp,hn)); }
+
+VS_TYPE* VS_FUNC(FirMC)( VS_TYPE* dbp, unsigned dn, unsigned dStride, const VS_TYPE* sbp, unsigned sStride, unsigned chCnt, const VS_TYPE* hrp, unsigned hn )
+{ VS_DISPATCH(FirMC,(dbp,dn,dStride,sbp,sStride,chCnt,hrp,hn)); }
+
+VS_TYPE* VS_FUNC(Log10VV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, VS_TYPE addVal, VS_TYPE mult, VS_TYPE minVal, VS_TYPE minRes )
+{ VS_DISPATCH(Log10VV,(dbp,dn,sbp,addVal,mult,minVal,minRes)); }
+
+VS_TYPE* VS_FUNC(Exp10VV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, double div )
+{ VS_DISPATCH(Exp10VV,(dbp,dn,sbp,div)); }
+
+double*  VS_FUNC(PolarD)( double* magp, double* phsp, unsigned dn, const VS_TYPE* rep, const VS_TYPE* imp )
+{ VS_DISPATCH(PolarD,(magp,phsp,dn,rep,imp)); }
+
+VS_TYPE* VS_FUNC(FromPcm)( VS_TYPE* dbp, unsigned dn, const void* sbp, unsigned sStride, unsigned fmtId, VS_TYPE scale )
+{ VS_DISPATCH(FromPcm,(dbp,dn,sbp,sStride,fmtId,scale)); }
+
+void*    VS_FUNC(ToPcm)(   void* dbp, const VS_TYPE* sbp, unsigned sn, unsigned fmtId, VS_TYPE mult )
+{ VS_DISPATCH(ToPcm,(dbp,sbp,sn,fmtId,mult)); }
+
+#elif defined(VS_N)
+
+VS_ATTR static VS_TYPE* VS_FUNC(AddVVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p )
+{
+  unsigned i = 0;
+  for(; i+VS_N <= dn; i+=VS_N )
+    VS_ST(dbp+i, VS_ADD(VS_LD(sb0p+i),VS_LD(sb1p+i)));
+  for(; i<dn; ++i)
+    dbp[i] = sb0p[i] + sb1p[i];
+  return dbp;
+}
+
+VS_ATTR static VS_TYPE* VS_FUNC(SubVVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p )
+{
+  unsigned i = 0;
+  for(; i+VS_N <= dn; i+=VS_N )
+    VS_ST(dbp+i, VS_SUB(VS_LD(sb0p+i),VS_LD(sb1p+i)));
+  for(; i<dn; ++i)
+    dbp[i] = sb0p[i] - sb1p[i];
+  return dbp;
+}
+
+VS_ATTR static VS_TYPE* VS_FUNC(MultVVV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p )
+{
+  unsigned i = 0;
+  for(; i+VS_N <= dn; i+=VS_N )
+    VS_ST(dbp+i, VS_MUL(VS_LD(sb0p+i),VS_LD(sb1p+i)));
+  for(; i<dn; ++i)
+    dbp[i] = sb0p[i] * sb1p[i];
+  return dbp;
+}
+
+VS_ATTR static VS_TYPE* VS_FUNC(AddVV)(   VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp )
+{ return VS_FUNC(AddVVV)(dbp,dn,dbp,sbp); }
+
+VS_ATTR static VS_TYPE* VS_FUNC(SubVV)(   VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp )
+{ return VS_FUNC(SubVVV)(dbp,dn,dbp,sbp); }
+
+VS_ATTR static VS_TYPE* VS_FUNC(MultVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp )
+{ return VS_FUNC(MultVVV)(dbp,dn,dbp,sbp); }
+
+VS_ATTR static VS_TYPE* VS_FUNC(AddVS)(   VS_TYPE* dbp, unsigned dn, VS_TYPE s )
+{
+  const VS_V sv = VS_SET1(s);
+  unsigned   i  = 0;
+  for(; i+VS_N <= dn; i+=VS_N )
+    VS_ST(dbp+i, VS_ADD(VS_LD(dbp+i),sv));
+  for(; i<dn; ++i)
+    dbp[i] += s;
+  return dbp;
+}
+
+VS_ATTR static VS_TYPE* VS_FUNC(MultVVS)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, VS_TYPE s )
+{
+  const VS_V sv = VS_SET1(s);
+  unsigned   i  = 0;
+  for(; i+VS_N <= dn; i+=VS_N )
+    VS_ST(dbp+i, VS_MUL(VS_LD(sbp+i),sv));
+  for(; i<dn; ++i)
+    dbp[i] = sbp[i] * s;
+  return dbp;
+}
+
+VS_ATTR static VS_TYPE* VS_FUNC(MultVS)(  VS_TYPE* dbp, unsigned dn, VS_TYPE s )
+{ return VS_FUNC(MultVVS)(dbp,dn,dbp,s); }
+
+// Sum the lanes of a vector in lane order.
+VS_ATTR static VS_TYPE VS_FUNC(_HSum)( VS_V v )
+{
+  VS_TYPE  a[ VS_N ];
+  VS_TYPE  sum = 0;
+  unsigned i;
+  VS_ST(a,v);
+  for(i=0; i<VS_N; ++i)
+    sum += a[i];
+  return sum;
+}
+
+// The reductions use four independent accumulators to hide the add latency.
+VS_ATTR static VS_TYPE  VS_FUNC(Sum)(         const VS_TYPE* sbp, unsigned sn )
+{
+  VS_V     a0 = VS_ZERO(), a1 = VS_ZERO(), a2 = VS_ZERO(), a3 = VS_ZERO();
+  unsigned i  = 0;
+  VS_TYPE  sum;
+
+  for(; i+4*VS_N <= sn; i+=4*VS_N )
+  {
+    a0 = VS_ADD(a0,VS_LD(sbp+i+0*VS_N));
+    a1 = VS_ADD(a1,VS_LD(sbp+i+1*VS_N));
+    a2 = VS_ADD(a2,VS_LD(sbp+i+2*VS_N));
+    a3 = VS_ADD(a3,VS_LD(sbp+i+3*VS_N));
+  }
+
+  for(; i+VS_N <= sn; i+=VS_N )
+    a0 = VS_ADD(a0,VS_LD(sbp+i));
+
+  sum = VS_FUNC(_HSum)(VS_ADD(VS_ADD(a0,a1),VS_ADD(a2,a3)));
+
+  for(; i<sn; ++i)
+    sum += sbp[i];
+
+  return sum;
+}
+
+VS_ATTR static VS_TYPE  VS_FUNC(SquaredSum)(  const VS_TYPE* sbp, unsigned sn )
+{
+  VS_V     a0 = VS_ZERO(), a1 = VS_ZERO(), a2 = VS_ZERO(), a3 = VS_ZERO();
+  VS_V     v0,v1,v2,v3;
+  unsigned i  = 0;
+  VS_TYPE  sum;
+
+  for(; i+4*VS_N <= sn; i+=4*VS_N )
+  {
+    v0 = VS_LD(sbp+i+0*VS_N);
+    v1 = VS_LD(sbp+i+1*VS_N);
+    v2 = VS_LD(sbp+i+2*VS_N);
+    v3 = VS_LD(sbp+i+3*VS_N);
+    a0 = VS_ADD(a0,VS_MUL(v0,v0));
+    a1 = VS_ADD(a1,VS_MUL(v1,v1));
+    a2 = VS_ADD(a2,VS_MUL(v2,v2));
+    a3 = VS_ADD(a3,VS_MUL(v3,v3));
+  }
+
+  for(; i+VS_N <= sn; i+=VS_N )
+  {
+    v0 = VS_LD(sbp+i);
+    a0 = VS_ADD(a0,VS_MUL(v0,v0));
+  }
+
+  sum = VS_FUNC(_HSum)(VS_ADD(VS_ADD(a0,a1),VS_ADD(a2,a3)));
+
+  for(; i<sn; ++i)
+    sum += sbp[i] * sbp[i];
+
+  return sum;
+}
+
+VS_ATTR static double   VS_FUNC(SquaredSumD)( const VS_TYPE* sbp, unsigned sn )
+{
+#if VS_IS_FLOAT
+  VS_VD    a0 = VS_ZERO_D(), a1 = VS_ZERO_D();
+  VS_VD    lo,hi;
+  double   a[ VS_ND ];
+  double   sum = 0;
+  unsigned i   = 0;
+
+  for(; i+VS_N <= sn; i+=VS_N )
+  {
+    VS_V v = VS_LD(sbp+i);
+    lo = VS_CVT_LO_D(v);
+    hi = VS_CVT_HI_D(v);
+    a0 = VS_ADD_D(a0,VS_MUL_D(lo,lo));
+    a1 = VS_ADD_D(a1,VS_MUL_D(hi,hi));
+  }
+
+  VS_ST_D(a,VS_ADD_D(a0,a1));
+
+  for(i=0; i<VS_ND; ++i)
+    sum += a[i];
+
+  for(i=sn - (sn % VS_N); i<sn; ++i)
+    sum += sbp[i] * sbp[i];
+
+  return sum;
+#else
+  return VS_FUNC(SquaredSum)(sbp,sn);
+#endif
+}
+
+VS_ATTR static VS_TYPE  VS_FUNC(MultSumVV)(   const VS_TYPE* s0p, const VS_TYPE* s1p, unsigned sn )
+{
+  VS_V     a0 = VS_ZERO(), a1 = VS_ZERO(), a2 = VS_ZERO(), a3 = VS_ZERO();
+  unsigned i  = 0;
+  VS_TYPE  sum;
+
+  for(; i+4*VS_N <= sn; i+=4*VS_N )
+  {
+    a0 = VS_ADD(a0,VS_MUL(VS_LD(s0p+i+0*VS_N),VS_LD(s1p+i+0*VS_N)));
+    a1 = VS_ADD(a1,VS_MUL(VS_LD(s0p+i+1*VS_N),VS_LD(s1p+i+1*VS_N)));
+    a2 = VS_ADD(a2,VS_MUL(VS_LD(s0p+i+2*VS_N),VS_LD(s1p+i+2*VS_N)));
+    a3 = VS_ADD(a3,VS_MUL(VS_LD(s0p+i+3*VS_N),VS_LD(s1p+i+3*VS_N)));
+  }
+
+  for(; i+VS_N <= sn; i+=VS_N )
+    a0 = VS_ADD(a0,VS_MUL(VS_LD(s0p+i),VS_LD(s1p+i)));
+
+  sum = VS_FUNC(_HSum)(VS_ADD(VS_ADD(a0,a1),VS_ADD(a2,a3)));
+
+  for(; i<sn; ++i)
+    sum += s0p[i] * s1p[i];
+
+  return sum;
+}
+
+// The FIR kernels vectorize across output samples: each coefficient is
+// broadcast once and multiplied against contiguous (unaligned) input.
+// Each output is accumulated in coefficient order, as in the scalar kernel.
+VS_ATTR static VS_TYPE* VS_FUNC(FirVV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, const VS_TYPE* hrp, unsigned hn )
+{
+  unsigned i = 0, k;
+
+  for(; i+4*VS_N <= dn; i+=4*VS_N )
+  {
+    const VS_TYPE* sp = sbp + i;
+    VS_V           a0 = VS_ZERO(), a1 = VS_ZERO(), a2 = VS_ZERO(), a3 = VS_ZERO();
+
+    for(k=0; k<hn; ++k)
+    {
+      const VS_V hv = VS_SET1(hrp[k]);
+      a0 = VS_ADD(a0,VS_MUL(hv,VS_LD(sp+k+0*VS_N)));
+      a1 = VS_ADD(a1,VS_MUL(hv,VS_LD(sp+k+1*VS_N)));
+      a2 = VS_ADD(a2,VS_MUL(hv,VS_LD(sp+k+2*VS_N)));
+      a3 = VS_ADD(a3,VS_MUL(hv,VS_LD(sp+k+3*VS_N)));
+    }
+
+    VS_ST(dbp+i+0*VS_N,a0);
+    VS_ST(dbp+i+1*VS_N,a1);
+    VS_ST(dbp+i+2*VS_N,a2);
+    VS_ST(dbp+i+3*VS_N,a3);
+  }
+
+  for(; i+VS_N <= dn; i+=VS_N )
+  {
+    VS_V a0 = VS_ZERO();
+    for(k=0; k<hn; ++k)
+      a0 = VS_ADD(a0,VS_MUL(VS_SET1(hrp[k]),VS_LD(sbp+i+k)));
+    VS_ST(dbp+i,a0);
+  }
+
+  for(; i<dn; ++i)
+  {
+    VS_TYPE sum = 0;
+    for(k=0; k<hn; ++k)
+      sum += hrp[k] * sbp[i+k];
+    dbp[i] = sum;
+  }
+
+  return dbp;
+}
+
+// Channels are processed in groups of four. Unused slots in the last group
+// repeat the last channel and are not stored.
+VS_ATTR static VS_TYPE* VS_FUNC(FirMC)( VS_TYPE* dbp, unsigned dn, unsigned dStride, const VS_TYPE* sbp, unsigned sStride, unsigned chCnt, const VS_TYPE* hrp, unsigned hn )
+{
+  unsigned c0,c,i,k;
+
+  for(c0=0; c0<chCnt; c0+=4)
+  {
+    unsigned       gN = cmMin(4,chCnt-c0);
+    const VS_TYPE* s0 = sbp + (c0 + 0)          * sStride;
+    const VS_TYPE* s1 = sbp + (c0 + cmMin(1,gN-1)) * sStride;
+    const VS_TYPE* s2 = sbp + (c0 + cmMin(2,gN-1)) * sStride;
+    const VS_TYPE* s3 = sbp + (c0 + cmMin(3,gN-1)) * sStride;
+
+    for(i=0; i+VS_N <= dn; i+=VS_N )
+    {
+      VS_V a0 = VS_ZERO(), a1 = VS_ZERO(), a2 = VS_ZERO(), a3 = VS_ZERO();
+
+      for(k=0; k<hn; ++k)
+      {
+        const VS_V hv = VS_SET1(hrp[k]);
+        a0 = VS_ADD(a0,VS_MUL(hv,VS_LD(s0+i+k)));
+        a1 = VS_ADD(a1,VS_MUL(hv,VS_LD(s1+i+k)));
+        a2 = VS_ADD(a2,VS_MUL(hv,VS_LD(s2+i+k)));
+        a3 = VS_ADD(a3,VS_MUL(hv,VS_LD(s3+i+k)));
+      }
+
+      VS_ST(dbp + (c0+0)*dStride + i, a0);
+      if( gN > 1 ) VS_ST(dbp + (c0+1)*dStride + i, a1);
+      if( gN > 2 ) VS_ST(dbp + (c0+2)*dStride + i, a2);
+      if( gN > 3 ) VS_ST(dbp + (c0+3)*dStride + i, a3);
+    }
+
+    for(c=c0; c<c0+gN; ++c)
+    {
+      const VS_TYPE* sp = sbp + c*sStride;
+      unsigned       j;
+      for(j=i; j<dn; ++j)
+      {
+        VS_TYPE sum = 0;
+        for(k=0; k<hn; ++k)
+          sum += hrp[k] * sp[j+k];
+        dbp[c*dStride + j] = sum;
+      }
+    }
+  }
+
+  return dbp;
+}
+
+VS_ATTR static VS_TYPE* VS_FUNC(Log10VV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, VS_TYPE addVal, VS_TYPE mult, VS_TYPE minVal, VS_TYPE minRes )
+{
+  unsigned i = 0;
+
+#if VS_IS_FLOAT
+  // log10(x) = (e*ln(2) + ln(m)) * log10(e)  where x = m * 2^e and sqrt(.5) <= m < sqrt(2)
+  // ln(m)    = 2*(t + t^3/3 + t^5/5 + t^7/7 + t^9/9) where t = (m-1)/(m+1) and |t| < 0.172
+  const VS_V addV    = VS_SET1(addVal);
+  const VS_V minV    = VS_SET1(minVal);
+  const VS_V minResV = VS_SET1(minRes);
+  const VS_V kV      = VS_SET1((float)(mult * M_LOG10E));
+  const VS_V oneV    = VS_SET1(1.0f);
+  const VS_V halfV   = VS_SET1(0.5f);
+  const VS_V sqrt2V  = VS_SET1((float)M_SQRT2);
+  const VS_V lo      = VS_SET1(FLT_MIN);
+  const VS_V hi      = VS_SET1(FLT_MAX);
+  const VS_V ln2hiV  = VS_SET1(0.693145751953125f);
+  const VS_V ln2loV  = VS_SET1(1.428606820309417232e-06f);
+
+  for(; i+VS_N <= dn; i+=VS_N )
+  {
+    VS_V s = VS_LD(sbp+i);
+    VS_V x = VS_SELECT_LT(s,minV,oneV,VS_ADD(s,addV));
+
+    // zero, negative, denormal, inf and nan arguments are handled by the scalar code below
+    if( !VS_ALL_IN(x,lo,hi) )
+    {
+      unsigned j;
+      for(j=i; j<i+VS_N; ++j)
+        dbp[j] = sbp[j] < minVal ? minRes : (VS_TYPE)(mult * log10(sbp[j] + addVal));
+      continue;
+    }
+
+    VS_I b = VS_CAST_I(x);
+    VS_V e = VS_CVT_IF(VS_SUB_I(VS_SRLI(b,23),VS_SET1_I(127)));
+    VS_V m = VS_CAST_F(VS_OR_I(VS_AND_I(b,VS_SET1_I(0x007fffff)),VS_SET1_I(0x3f800000)));
+
+    // move m from [1,2) to [sqrt(.5),sqrt(2))
+    e = VS_SELECT_LT(sqrt2V,m,VS_ADD(e,oneV),e);
+    m = VS_SELECT_LT(sqrt2V,m,VS_MUL(m,halfV),m);
+
+    VS_V t  = VS_DIV(VS_SUB(m,oneV),VS_ADD(m,oneV));
+    VS_V t2 = VS_MUL(t,t);
+    VS_V p  = VS_SET1(1.0f/9.0f);
+    p = VS_ADD(VS_MUL(p,t2),VS_SET1(1.0f/7.0f));
+    p = VS_ADD(VS_MUL(p,t2),VS_SET1(1.0f/5.0f));
+    p = VS_ADD(VS_MUL(p,t2),VS_SET1(1.0f/3.0f));
+    p = VS_ADD(VS_MUL(p,t2),oneV);
+    p = VS_MUL(VS_ADD(t,t),p);
+
+    VS_V r = VS_MUL(VS_ADD(VS_MUL(e,ln2hiV),VS_ADD(p,VS_MUL(e,ln2loV))),kV);
+
+    VS_ST(dbp+i, VS_SELECT_LT(s,minV,minResV,r));
+  }
+#endif
+
+  for(; i<dn; ++i)
+    dbp[i] = sbp[i] < minVal ? minRes : (VS_TYPE)(mult * log10(sbp[i] + addVal));
+
+  return dbp;
+}
+
+VS_ATTR static VS_TYPE* VS_FUNC(Exp10VV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, double div )
+{
+  unsigned i = 0;
+
+#if VS_IS_FLOAT
+  // 10^(s/div) = 2^x = 2^n * 2^f where x = s*log2(10)/div, n = round(x) and |f| <= 0.5
+  // 2^f = exp(g) = 1 + g + g^2/2! + ... + g^7/7!  where g = f*ln(2)
+  const VS_V cV    = VS_SET1((float)(M_LN10/M_LN2/div));
+  const VS_V ln2V  = VS_SET1((float)M_LN2);
+  const VS_V lo    = VS_SET1(-126.0f);
+  const VS_V hi    = VS_SET1( 127.0f);
+
+  for(; i+VS_N <= dn; i+=VS_N )
+  {
+    VS_V x = VS_MUL(VS_LD(sbp+i),cV);
+
+    // results which would be denormal or overflow (and nan arguments) are handled by the scalar code
+    if( !VS_ALL_IN(x,lo,hi) )
+    {
+      unsigned j;
+      for(j=i; j<i+VS_N; ++j)
+        dbp[j] = pow(10.0,sbp[j]/div);
+      continue;
+    }
+
+    VS_I n = VS_CVT_FI(x);
+    VS_V g = VS_MUL(VS_SUB(x,VS_CVT_IF(n)),ln2V);
+    VS_V p = VS_SET1(1.0f/5040.0f);
+    p = VS_ADD(VS_MUL(p,g),VS_SET1(1.0f/720.0f));
+    p = VS_ADD(VS_MUL(p,g),VS_SET1(1.0f/120.0f));
+    p = VS_ADD(VS_MUL(p,g),VS_SET1(1.0f/24.0f));
+    p = VS_ADD(VS_MUL(p,g),VS_SET1(1.0f/6.0f));
+    p = VS_ADD(VS_MUL(p,g),VS_SET1(0.5f));
+    p = VS_ADD(VS_MUL(p,g),VS_SET1(1.0f));
+    p = VS_ADD(VS_MUL(p,g),VS_SET1(1.0f));
+
+    // scale by 2^n
+    VS_V s = VS_CAST_F(VS_SLLI(VS_ADD_I(n,VS_SET1_I(127)),23));
+
+    VS_ST(dbp+i, VS_MUL(p,s));
+  }
+#endif
+
+  for(; i<dn; ++i)
+    dbp[i] = pow(10.0,sbp[i]/div);
+
+  return dbp;
+}
+
+VS_ATTR static double* VS_FUNC(PolarD)( double* magp, double* phsp, unsigned dn, const VS_TYPE* rep, const VS_TYPE* imp )
+{
+  unsigned i = 0;
+
+#if VS_IS_FLOAT
+  // a = min(|x|,|y|) / max(|x|,|y|) is reduced to |t| <= tan(pi/8) by atan(a) = pi/4 + atan((a-1)/(a+1))
+  // atan(t) = t + t^3*p(t^2) (Cephes atanf() coefficients)
+  // atan2(y,x) is then recovered from the octant and |x + j*y| = max(|x|,|y|) * sqrt(1 + a^2)
+  const VS_I absV   = VS_SET1_I(0x7fffffff);
+  const VS_I sgnV   = VS_SET1_I((int)0x80000000);
+  const VS_V zeroV  = VS_ZERO();
+  const VS_V oneV   = VS_SET1(1.0f);
+  const VS_V tinyV  = VS_SET1(FLT_MIN);
+  const VS_V t8V    = VS_SET1(0.414213562373095f);
+  const VS_V pi4V   = VS_SET1((float)M_PI_4);
+  const VS_V pi2V   = VS_SET1((float)M_PI_2);
+  const VS_V piV    = VS_SET1((float)M_PI);
+
+  for(; i+VS_N <= dn; i+=VS_N )
+  {
+    VS_V x  = VS_LD(rep+i);
+    VS_V y  = VS_LD(imp+i);
+    VS_V ax = VS_CAST_F(VS_AND_I(VS_CAST_I(x),absV));
+    VS_V ay = VS_CAST_F(VS_AND_I(VS_CAST_I(y),absV));
+    VS_V mn = VS_SELECT_LT(ax,ay,ax,ay);
+    VS_V mx = VS_SELECT_LT(ax,ay,ay,ax);
+    VS_V a  = VS_SELECT_LT(mx,tinyV,zeroV,VS_DIV(mn,mx));
+
+    // reduce a to [-tan(pi/8),tan(pi/8)]
+    VS_V t  = VS_SELECT_LT(t8V,a,VS_DIV(VS_SUB(a,oneV),VS_ADD(a,oneV)),a);
+    VS_V r  = VS_SELECT_LT(t8V,a,pi4V,zeroV);
+    VS_V z  = VS_MUL(t,t);
+    VS_V p  = VS_SET1(8.05374449538e-2f);
+    p = VS_ADD(VS_MUL(p,z),VS_SET1(-1.38776856032e-1f));
+    p = VS_ADD(VS_MUL(p,z),VS_SET1( 1.99777106478e-1f));
+    p = VS_ADD(VS_MUL(p,z),VS_SET1(-3.33329491539e-1f));
+    r = VS_ADD(r,VS_ADD(VS_MUL(VS_MUL(p,z),t),t));
+
+    // move r from the first octant to the quadrant of (x,y)
+    r = VS_SELECT_LT(ax,ay,VS_SUB(pi2V,r),r);
+    r = VS_SELECT_LT(x,zeroV,VS_SUB(piV,r),r);
+    r = VS_CAST_F(VS_OR_I(VS_CAST_I(r),VS_AND_I(VS_CAST_I(y),sgnV)));
+
+    VS_V m = VS_MUL(mx,VS_SQRT(VS_ADD(oneV,VS_MUL(a,a))));
+
+    VS_ST_D(magp+i,       VS_CVT_LO_D(m));
+    VS_ST_D(magp+i+VS_ND, VS_CVT_HI_D(m));
+    VS_ST_D(phsp+i,       VS_CVT_LO_D(r));
+    VS_ST_D(phsp+i+VS_ND, VS_CVT_HI_D(r));
+  }
+#endif
+
+  for(; i<dn; ++i)
+  {
+    magp[i] = hypot(rep[i],imp[i]);
+    phsp[i] = atan2(imp[i],rep[i]);
+  }
+
+  return magp;
+}
+
+#else // scalar kernels
+
+static VS_TYPE* VS_FUNC(AddVVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p )
+{
+  const VS_TYPE* dep = dbp + dn;
+  VS_TYPE*       dp  = dbp;
+  while( dbp < dep )
+    *dbp++ = *sb0p++ + *sb1p++;
+  return dp;
+}
+
+static VS_TYPE* VS_FUNC(SubVVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p )
+{
+  const VS_TYPE* dep = dbp + dn;
+  VS_TYPE*       dp  = dbp;
+  while( dbp < dep )
+    *dbp++ = *sb0p++ - *sb1p++;
+  return dp;
+}
+
+static VS_TYPE* VS_FUNC(MultVVV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p )
+{
+  const VS_TYPE* dep = dbp + dn;
+  VS_TYPE*       dp  = dbp;
+  while( dbp < dep )
+    *dbp++ = *sb0p++ * *sb1p++;
+  return dp;
+}
+
+static VS_TYPE* VS_FUNC(AddVV)(   VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp )
+{
+  const VS_TYPE* dep = dbp + dn;
+  VS_TYPE*       dp  = dbp;
+  while( dbp < dep )
+    *dbp++ += *sbp++;
+  return dp;
+}
+
+static VS_TYPE* VS_FUNC(SubVV)(   VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp )
+{
+  const VS_TYPE* dep = dbp + dn;
+  VS_TYPE*       dp  = dbp;
+  while( dbp < dep )
+    *dbp++ -= *sbp++;
+  return dp;
+}
+
+static VS_TYPE* VS_FUNC(MultVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp )
+{
+  const VS_TYPE* dep = dbp + dn;
+  VS_TYPE*       dp  = dbp;
+  while( dbp < dep )
+    *dbp++ *= *sbp++;
+  return dp;
+}
+
+static VS_TYPE* VS_FUNC(AddVS)(   VS_TYPE* dbp, unsigned dn, VS_TYPE s )
+{
+  const VS_TYPE* dep = dbp + dn;
+  VS_TYPE*       dp  = dbp;
+  while( dbp < dep )
+    *dbp++ += s;
+  return dp;
+}
+
+static VS_TYPE* VS_FUNC(MultVS)(  VS_TYPE* dbp, unsigned dn, VS_TYPE s )
+{
+  const VS_TYPE* dep = dbp + dn;
+  VS_TYPE*       dp  = dbp;
+  while( dbp < dep )
+    *dbp++ *= s;
+  return dp;
+}
+
+static VS_TYPE* VS_FUNC(MultVVS)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, VS_TYPE s )
+{
+  const VS_TYPE* dep = dbp + dn;
+  VS_TYPE*       dp  = dbp;
+  while( dbp < dep )
+    *dbp++ = *sbp++ * s;
+  return dp;
+}
+
+static VS_TYPE  VS_FUNC(Sum)(         const VS_TYPE* sbp, unsigned sn )
+{
+  const VS_TYPE* ep = sbp + sn;
+  VS_TYPE        s  = 0;
+  while( sbp < ep )
+    s += *sbp++;
+  return s;
+}
+
+static VS_TYPE  VS_FUNC(SquaredSum)(  const VS_TYPE* sbp, unsigned sn )
+{
+  const VS_TYPE* ep  = sbp + sn;
+  VS_TYPE        sum = 0;
+  for(; sbp < ep; ++sbp )
+    sum += *sbp * *sbp;
+  return sum;
+}
+
+static double   VS_FUNC(SquaredSumD)( const VS_TYPE* sbp, unsigned sn )
+{
+  const VS_TYPE* ep  = sbp + sn;
+  double         sum = 0;
+  for(; sbp < ep; ++sbp )
+    sum += *sbp * *sbp;
+  return sum;
+}
+
+static VS_TYPE  VS_FUNC(MultSumVV)(   const VS_TYPE* s0p, const VS_TYPE* s1p, unsigned sn )
+{
+  const VS_TYPE* sep = s0p + sn;
+  VS_TYPE        sum = 0;
+  while( s0p < sep )
+    sum += *s0p++ * *s1p++;
+  return sum;
+}
+
+static VS_TYPE* VS_FUNC(FirVV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, const VS_TYPE* hrp, unsigned hn )
+{
+  unsigned i,k;
+  for(i=0; i<dn; ++i)
+  {
+    VS_TYPE sum = 0;
+    for(k=0; k<hn; ++k)
+      sum += hrp[k] * sbp[i+k];
+    dbp[i] = sum;
+  }
+  return dbp;
+}
+
+static VS_TYPE* VS_FUNC(FirMC)( VS_TYPE* dbp, unsigned dn, unsigned dStride, const VS_TYPE* sbp, unsigned sStride, unsigned chCnt, const VS_TYPE* hrp, unsigned hn )
+{
+  unsigned c;
+  for(c=0; c<chCnt; ++c)
+    VS_FUNC(FirVV)(dbp + c*dStride, dn, sbp + c*sStride, hrp, hn);
+  return dbp;
+}
+
+static VS_TYPE* VS_FUNC(Log10VV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, VS_TYPE addVal, VS_TYPE mult, VS_TYPE minVal, VS_TYPE minRes )
+{
+  unsigned i;
+  for(i=0; i<dn; ++i)
+    dbp[i] = sbp[i] < minVal ? minRes : (VS_TYPE)(mult * log10(sbp[i] + addVal));
+  return dbp;
+}
+
+static VS_TYPE* VS_FUNC(Exp10VV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, double div )
+{
+  unsigned i;
+  for(i=0; i<dn; ++i)
+    dbp[i] = pow(10.0,sbp[i]/div);
+  return dbp;
+}
+
+static double*  VS_FUNC(PolarD)( double* magp, double* phsp, unsigned dn, const VS_TYPE* rep, const VS_TYPE* imp )
+{
+  unsigned i;
+  for(i=0; i<dn; ++i)
+  {
+    magp[i] = hypot(rep[i],imp[i]);
+    phsp[i] = atan2(imp[i],rep[i]);
+  }
+  return magp;
+}
+
+#endif
+
+#if !defined(VS_DISPATCH)
+
+//-----------------------------------------------------------------------------
+// PCM conversion kernels - the scalar loops are shared by every kernel set and
+// also convert the vector tails.
+//
+#ifdef VS_N
+#define _VS_PCM_ATTR VS_ATTR
+#else
+#define _VS_PCM_ATTR
+#endif
+
+#define _VS_PCM_LD_LOOP(fid) case fid: for(; i<dn; ++i) dbp[i] = scale * (VS_TYPE)_cmVsPcmLd(sp + i*sStride,fid); break
+#define _VS_PCM_ST_LOOP(fid)                                            \
+  case fid:                                                             \
+    for(; i<sn; ++i)                                                    \
+    {                                                                   \
+      VS_TYPE x = sbp[i] * mult;                                        \
+      x = x < mult  ? x : mult;                                         \
+      x = -mult < x ? x : -mult;                                        \
+      _cmVsPcmSt(dp + i*bn,(int)x,fid);                                 \
+    }                                                                   \
+    break
+
+#if defined(VS_N) && VS_IS_FLOAT
+
+// Swap the bytes of each 32 bit word.
+#define _VS_BSWAP32(v) VS_OR_I(VS_OR_I(VS_SLLI(v,24),VS_AND_I(VS_SLLI(v,8),VS_SET1_I(0x00ff0000))),VS_OR_I(VS_AND_I(VS_SRLI(v,8),VS_SET1_I(0x0000ff00)),VS_SRLI(v,24)))
+
+// Swap the two low bytes of each word and sign extend the result.
+#define _VS_BSWAP16(v) VS_OR_I(VS_SRAI(VS_SLLI(v,24),16),VS_AND_I(VS_SRLI(v,8),VS_SET1_I(0xff)))
+
+#endif
+
+_VS_PCM_ATTR static VS_TYPE* VS_FUNC(FromPcm)( VS_TYPE* dbp, unsigned dn, const void* sbp, unsigned sStride, unsigned fmtId, VS_TYPE scale )
+{
+  const unsigned char* sp = (const unsigned char*)sbp;
+  unsigned             i  = 0;
+
+#if defined(VS_N) && VS_IS_FLOAT
+  if( sStride == _cmVsPcmByteCnt(fmtId) )
+  {
+    const VS_V sV = VS_SET1(scale);
+
+    switch( fmtId )
+    {
+      case kS16LePcmVsId:
+        for(; i+VS_N <= dn; i+=VS_N )
+          VS_ST(dbp+i,VS_MUL(VS_CVT_IF(VS_LD_S16(sp + 2*i)),sV));
+        break;
+
+      case kS16BePcmVsId:
+        for(; i+VS_N <= dn; i+=VS_N )
+        {
+          VS_I v = VS_LD_S16(sp + 2*i);
+          VS_ST(dbp+i,VS_MUL(VS_CVT_IF(_VS_BSWAP16(v)),sV));
+        }
+        break;
+
+      // the 24 bit loads read one byte past the last sample - leave it to the scalar loop
+      case kS24LePcmVsId:
+        for(; i+VS_N < dn; i+=VS_N )
+        {
+          VS_I v = VS_LD_24(sp + 3*i);
+          VS_ST(dbp+i,VS_MUL(VS_CVT_IF(VS_SRAI(VS_SLLI(v,8),8)),sV));
+        }
+        break;
+
+      case kS24BePcmVsId:
+        for(; i+VS_N < dn; i+=VS_N )
+        {
+          VS_I v = VS_LD_24(sp + 3*i);
+          VS_ST(dbp+i,VS_MUL(VS_CVT_IF(VS_SRAI(_VS_BSWAP32(v),8)),sV));
+        }
+        break;
+
+      case kS32LePcmVsId:
+        for(; i+VS_N <= dn; i+=VS_N )
+          VS_ST(dbp+i,VS_MUL(VS_CVT_IF(VS_LD_I(sp + 4*i)),sV));
+        break;
+
+      case kS32BePcmVsId:
+        for(; i+VS_N <= dn; i+=VS_N )
+        {
+          VS_I v = VS_LD_I(sp + 4*i);
+          VS_ST(dbp+i,VS_MUL(VS_CVT_IF(_VS_BSWAP32(v)),sV));
+        }
+        break;
+    }
+  }
+#endif
+
+  switch( fmtId )
+  {
+    _VS_PCM_LD_LOOP(kS8PcmVsId);
+    _VS_PCM_LD_LOOP(kU8PcmVsId);
+    _VS_PCM_LD_LOOP(kS16LePcmVsId);
+    _VS_PCM_LD_LOOP(kS16BePcmVsId);
+    _VS_PCM_LD_LOOP(kS24LePcmVsId);
+    _VS_PCM_LD_LOOP(kS24BePcmVsId);
+    _VS_PCM_LD_LOOP(kS32LePcmVsId);
+    _VS_PCM_LD_LOOP(kS32BePcmVsId);
+  }
+
+  return dbp;
+}
+
+_VS_PCM_ATTR static void*    VS_FUNC(ToPcm)(   void* dbp, const VS_TYPE* sbp, unsigned sn, unsigned fmtId, VS_TYPE mult )
+{
+  unsigned char* dp = (unsigned char*)dbp;
+  unsigned       bn = _cmVsPcmByteCnt(fmtId);
+  unsigned       i  = 0;
+
+#if defined(VS_N) && VS_IS_FLOAT
+  if( fmtId != kS8PcmVsId && fmtId != kU8PcmVsId )
+  {
+    const VS_V mV = VS_SET1(mult);
+    const VS_V nV = VS_SET1(-mult);
+    int        a[ VS_N ];
+    unsigned   j;
+
+    for(; i+VS_N <= sn; i+=VS_N )
+    {
+      VS_V x = VS_MUL(VS_LD(sbp+i),mV);
+      x      = VS_SELECT_LT(x,mV,x,mV);
+      x      = VS_SELECT_LT(nV,x,x,nV);
+      VS_I v = VS_CVTT_FI(x);
+
+      switch( fmtId )
+      {
+        case kS16LePcmVsId: VS_ST_S16(dp + 2*i,v);              break;
+        case kS16BePcmVsId: VS_ST_S16(dp + 2*i,_VS_BSWAP16(v)); break;
+        case kS32LePcmVsId: VS_ST_I(dp + 4*i,v);                break;
+        case kS32BePcmVsId: VS_ST_I(dp + 4*i,_VS_BSWAP32(v));   break;
+        default:
+          VS_ST_I(a,v);
+          for(j=0; j<VS_N; ++j)
+            _cmVsPcmSt(dp + (i+j)*bn,a[j],fmtId);
+      }
+    }
+  }
+#endif
+
+  switch( fmtId )
+  {
+    _VS_PCM_ST_LOOP(kS8PcmVsId);
+    _VS_PCM_ST_LOOP(kU8PcmVsId);
+    _VS_PCM_ST_LOOP(kS16LePcmVsId);
+    _VS_PCM_ST_LOOP(kS16BePcmVsId);
+    _VS_PCM_ST_LOOP(kS24LePcmVsId);
+    _VS_PCM_ST_LOOP(kS24BePcmVsId);
+    _VS_PCM_ST_LOOP(kS32LePcmVsId);
+    _VS_PCM_ST_LOOP(kS32BePcmVsId);
+  }
+
+  return dbp;
+}
+
+#undef _VS_PCM_ATTR
+#undef _VS_PCM_LD_LOOP
+#undef _VS_PCM_ST_LOOP
+#undef _VS_BSWAP32
+#undef _VS_BSWAP16
+
+#endif
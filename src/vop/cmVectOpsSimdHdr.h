@@ -0,0 +1,46 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+
+// Element-wise kernels.
+VS_TYPE* VS_FUNC(AddVVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p );
+VS_TYPE* VS_FUNC(SubVVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p );
+VS_TYPE* VS_FUNC(MultVVV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sb0p, const VS_TYPE* sb1p );
+VS_TYPE* VS_FUNC(AddVV)(   VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp );
+VS_TYPE* VS_FUNC(SubVV)(   VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp );
+VS_TYPE* VS_FUNC(MultVV)(  VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp );
+VS_TYPE* VS_FUNC(AddVS)(   VS_TYPE* dbp, unsigned dn, VS_TYPE s );
+VS_TYPE* VS_FUNC(MultVS)(  VS_TYPE* dbp, unsigned dn, VS_TYPE s );
+VS_TYPE* VS_FUNC(MultVVS)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, VS_TYPE s );
+
+// Reductions.
+VS_TYPE  VS_FUNC(Sum)(         const VS_TYPE* sbp, unsigned sn );
+VS_TYPE  VS_FUNC(SquaredSum)(  const VS_TYPE* sbp, unsigned sn );
+double   VS_FUNC(SquaredSumD)( const VS_TYPE* sbp, unsigned sn );
+VS_TYPE  VS_FUNC(MultSumVV)(   const VS_TYPE* s0p, const VS_TYPE* s1p, unsigned sn );
+
+// FIR filter: dbp[i] = sum(hrp[k] * sbp[i+k]) for k=0:hn-1
+// sbp[dn+hn-1] is the input signal preceded by hn-1 samples of history and
+// hrp[hn] is the time reversed impulse response.
+VS_TYPE* VS_FUNC(FirVV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, const VS_TYPE* hrp, unsigned hn );
+
+// Apply FirVV() to chCnt channels with one pass over the coefficients. Channel c
+// reads sbp[c*sStride:c*sStride+dn+hn-1] and writes dbp[c*dStride:c*dStride+dn].
+VS_TYPE* VS_FUNC(FirMC)( VS_TYPE* dbp, unsigned dn, unsigned dStride, const VS_TYPE* sbp, unsigned sStride, unsigned chCnt, const VS_TYPE* hrp, unsigned hn );
+
+// dbp[i] = sbp[i] < minVal ? minRes : mult * log10(sbp[i] + addVal)
+VS_TYPE* VS_FUNC(Log10VV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, VS_TYPE addVal, VS_TYPE mult, VS_TYPE minVal, VS_TYPE minRes );
+
+// dbp[i] = pow(10, sbp[i] / div)
+VS_TYPE* VS_FUNC(Exp10VV)( VS_TYPE* dbp, unsigned dn, const VS_TYPE* sbp, double div );
+
+// Split complex to polar conversion with double precision results.
+// magp[i] = |rep[i] + j*imp[i]|   phsp[i] = atan2(imp[i],rep[i])
+// The float vector kernels use a single precision atan() approximation with
+// an absolute phase error less than 3e-7 radians.
+double*  VS_FUNC(PolarD)( double* magp, double* phsp, unsigned dn, const VS_TYPE* rep, const VS_TYPE* imp );
+
+// PCM sample conversion (fmtId is one of kXXXPcmVsId).
+// FromPcm(): dbp[i] = scale * x[i] where x[i] is the sample at sbp + i*sStride bytes.
+// ToPcm():   encode trunc(min(max(sbp[i]*mult,-mult),mult)) at dbp + i*(sample byte count).
+VS_TYPE* VS_FUNC(FromPcm)( VS_TYPE* dbp, unsigned dn, const void* sbp, unsigned sStride, unsigned fmtId, VS_TYPE scale );
+void*    VS_FUNC(ToPcm)(   void* dbp, const VS_TYPE* sbp, unsigned sn, unsigned fmtId, VS_TYPE mult );
@@ -0,0 +1,47 @@
+//| Copyright: (C) 2009-2020 Kevin Larke <contact AT larke DOT org>
+//| License: GNU GPL version 3.0 or above. See the accompanying LICENSE file.
+#undef VS_TYPE
+#undef VS_FUNC
+#undef VS_ATTR
+#undef VS_DISPATCH
+#undef VS_IS_FLOAT
+#undef VS_N
+#undef VS_V
+#undef VS_LD
+#undef VS_ST
+#undef VS_SET1
+#undef VS_ZERO
+#undef VS_ADD
+#undef VS_SUB
+#undef VS_MUL
+#undef VS_DIV
+#undef VS_SQRT
+#undef VS_VD
+#undef VS_ZERO_D
+#undef VS_ADD_D
+#undef VS_MUL_D
+#undef VS_CVT_LO_D
+#undef VS_CVT_HI_D
+#undef VS_ND
+#undef VS_ST_D
+#undef VS_I
+#undef VS_CAST_I
+#undef VS_CAST_F
+#undef VS_SRLI
+#undef VS_SLLI
+#undef VS_AND_I
+#undef VS_OR_I
+#undef VS_ADD_I
+#undef VS_SUB_I
+#undef VS_SET1_I
+#undef VS_CVT_IF
+#undef VS_CVT_FI
+#undef VS_SELECT_LT
+#undef VS_ALL_IN
+#undef VS_SRAI
+#undef VS_CVTT_FI
+#undef VS_LD_I
+#undef VS_ST_I
+#undef VS_LD_S16
+#undef VS_ST_S16
+#undef VS_LD_24
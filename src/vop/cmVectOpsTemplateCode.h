@@ -535,26 +535,33 @@ unsigned      VECT_OP_FUNC(ZeroCrossCount)( const VECT_OP_TYPE* bp, unsigned bn,
 
 VECT_OP_TYPE VECT_OP_FUNC(SquaredSum)( const VECT_OP_TYPE* bp, unsigned bn )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(SquaredSum)(bp,bn);
+#else
   VECT_OP_TYPE        sum = 0;
   const VECT_OP_TYPE* ep  = bp + bn;
 
   for(; bp < ep; ++bp )
     sum += *bp * *bp;
   return sum;
+#endif
 }
 
 VECT_OP_TYPE  VECT_OP_FUNC(RMS)( const VECT_OP_TYPE* bp, unsigned bn, unsigned wndSmpCnt )
 {
-  const VECT_OP_TYPE* ep = bp + bn;
-
   if( bn==0 )
     return 0;
 
   assert( bn <= wndSmpCnt );
 
+#ifdef VECT_OP_SIMD
+  double sum = VECT_OP_SIMD(SquaredSumD)(bp,bn);
+#else
+  const VECT_OP_TYPE* ep = bp + bn;
   double sum = 0;
   for(; bp < ep; ++bp )
     sum += *bp * *bp;
+#endif
 
   return (VECT_OP_TYPE)sqrt(sum/wndSmpCnt);
 }
@@ -866,6 +873,11 @@ void VECT_OP_FUNC(SelectMaxAvgDist)( VECT_OP_TYPE *dM, unsigned* selIdxV, unsign
 VECT_OP_TYPE VECT_OP_FUNC(MultSumVV)( const VECT_OP_TYPE* s0p,  const VECT_OP_TYPE* s1p, unsigned sn )
 { return VECT_OP_BLAS_FUNC(dot)(sn, s0p, 1, s1p, 1); }
 
+#elif defined(VECT_OP_SIMD)
+
+VECT_OP_TYPE VECT_OP_FUNC(MultSumVV)( const VECT_OP_TYPE* s0p,  const VECT_OP_TYPE* s1p, unsigned sn )
+{ return VECT_OP_SIMD(MultSumVV)(s0p,s1p,sn); }
+
 #else
 
 VECT_OP_TYPE VECT_OP_FUNC(MultSumVV)( const VECT_OP_TYPE* s0p,  const VECT_OP_TYPE* s1p, unsigned sn )
@@ -1045,7 +1057,13 @@ VECT_OP_TYPE* VECT_OP_FUNC(MultMMM1)(VECT_OP_TYPE* dbp, unsigned drn, unsigned d
 }
 #else
 
-// Not implemented.
+VECT_OP_TYPE* VECT_OP_FUNC(MultMMM1)(VECT_OP_TYPE* dbp, unsigned drn, unsigned dcn, VECT_OP_TYPE alpha, const VECT_OP_TYPE* m0, const VECT_OP_TYPE* m1, unsigned n, VECT_OP_TYPE beta, unsigned flags )
+{
+  bool t0fl = cmIsFlag(flags,kTransposeM0Fl);
+  bool t1fl = cmIsFlag(flags,kTransposeM1Fl);
+
+  return VECT_OP_FUNC(MultMMM2)(dbp,drn,dcn,alpha,m0,m1,n,beta,flags,drn, t0fl ? n : drn, t1fl ? dcn : n );
+}
 
 #endif
 
@@ -1068,7 +1086,27 @@ VECT_OP_TYPE* VECT_OP_FUNC(MultMMM2)(VECT_OP_TYPE* dbp, unsigned drn, unsigned d
 }
 #else
 
-// Not implemented.
+VECT_OP_TYPE* VECT_OP_FUNC(MultMMM2)(VECT_OP_TYPE* dbp, unsigned drn, unsigned dcn, VECT_OP_TYPE alpha, const VECT_OP_TYPE* m0, const VECT_OP_TYPE* m1, unsigned n, VECT_OP_TYPE beta, unsigned flags, unsigned dprn, unsigned m0prn, unsigned m1prn )
+{
+  bool     t0fl = cmIsFlag(flags,kTransposeM0Fl);
+  bool     t1fl = cmIsFlag(flags,kTransposeM1Fl);
+  unsigned i,j,k;
+
+  for(j=0; j<dcn; ++j)
+    for(i=0; i<drn; ++i)
+    {
+      VECT_OP_TYPE  sum = 0;
+      VECT_OP_TYPE* dp  = dbp + j*dprn + i;
+
+      for(k=0; k<n; ++k)
+        sum += (t0fl ? m0[ i*m0prn + k ] : m0[ k*m0prn + i ]) * (t1fl ? m1[ k*m1prn + j ] : m1[ j*m1prn + k ]);
+
+      // as with gemm() d[] is not read when beta is zero
+      *dp = alpha * sum + (beta == 0 ? 0 : beta * *dp);
+    }
+
+  return dbp;
+}
 
 #endif
 
@@ -2050,52 +2088,72 @@ VECT_OP_TYPE VECT_OP_FUNC(SynthPinkNoise)( VECT_OP_TYPE* dbp, unsigned n, VECT_O
 VECT_OP_TYPE* VECT_OP_FUNC(AmplToDbVV)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sbp, VECT_OP_TYPE minDb )
 {
   VECT_OP_TYPE  minVal = pow(10.0,minDb/20.0);
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(Log10VV)(dbp,dn,sbp,0,20,minVal,minDb);
+#else
   VECT_OP_TYPE* dp     = dbp;
   VECT_OP_TYPE* ep     = dp + dn;
 
   for(; dp<ep; ++dp,++sbp)
     *dp = *sbp<minVal ? minDb : 20.0 * log10(*sbp);
   return dbp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(DbToAmplVV)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sbp)
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(Exp10VV)(dbp,dn,sbp,20.0);
+#else
   VECT_OP_TYPE* dp = dbp;
   VECT_OP_TYPE* ep = dp + dn;
   for(; dp<ep; ++dp,++sbp)
     *dp = pow(10.0,*sbp/20.0);
   return dbp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(PowToDbVV)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sbp, VECT_OP_TYPE minDb )
 {
   VECT_OP_TYPE  minVal = pow(10.0,minDb/10.0);
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(Log10VV)(dbp,dn,sbp,0,10,minVal,minDb);
+#else
   VECT_OP_TYPE* dp     = dbp;
   VECT_OP_TYPE* ep     = dp + dn;
 
   for(; dp<ep; ++dp,++sbp)
     *dp = *sbp<minVal ? minDb : 10.0 * log10(*sbp);
   return dbp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(DbToPowVV)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sbp)
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(Exp10VV)(dbp,dn,sbp,10.0);
+#else
   VECT_OP_TYPE* dp = dbp;
   VECT_OP_TYPE* ep = dp + dn;
   for(; dp<ep; ++dp,++sbp)
     *dp = pow(10.0,*sbp/10.0);
   return dbp;
+#endif
 }
 
 
 
 VECT_OP_TYPE* VECT_OP_FUNC(LinearToDb)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sp, VECT_OP_TYPE mult )
 {
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(Log10VV)(dbp,dn,sp,VECT_OP_EPSILON,mult,-INFINITY,0);
+#else
   const VECT_OP_TYPE* dep = dbp + dn;
   VECT_OP_TYPE* rp = dbp;
   while( dbp < dep )
     *dbp++ = (VECT_OP_TYPE)(mult * log10( VECT_OP_EPSILON +  *sp++ ));
   return rp;
+#endif
 }
 
 VECT_OP_TYPE* VECT_OP_FUNC(dBToLinear)( VECT_OP_TYPE* dbp, unsigned dn, const VECT_OP_TYPE* sp, VECT_OP_TYPE mult )
@@ -2290,6 +2348,35 @@ VECT_OP_TYPE*	VECT_OP_FUNC(GaussWin)( VECT_OP_TYPE* dbp, unsigned dn, double arg
 }
 
 
+VECT_OP_TYPE* VECT_OP_FUNC(FirVV)( VECT_OP_TYPE* y, unsigned yn, const VECT_OP_TYPE* x, const VECT_OP_TYPE* hr, unsigned hn )
+{
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(FirVV)(y,yn,x,hr,hn);
+#else
+  unsigned i,k;
+  for(i=0; i<yn; ++i)
+  {
+    VECT_OP_TYPE sum = 0;
+    for(k=0; k<hn; ++k)
+      sum += hr[k] * x[i+k];
+    y[i] = sum;
+  }
+  return y;
+#endif
+}
+
+VECT_OP_TYPE* VECT_OP_FUNC(FirMC)( VECT_OP_TYPE* y, unsigned yn, unsigned yStride, const VECT_OP_TYPE* x, unsigned xStride, unsigned chCnt, const VECT_OP_TYPE* hr, unsigned hn )
+{
+#ifdef VECT_OP_SIMD
+  return VECT_OP_SIMD(FirMC)(y,yn,yStride,x,xStride,chCnt,hr,hn);
+#else
+  unsigned c;
+  for(c=0; c<chCnt; ++c)
+    VECT_OP_FUNC(FirVV)(y + c*yStride, yn, x + c*xStride, hr, hn);
+  return y;
+#endif
+}
+
 VECT_OP_TYPE* VECT_OP_FUNC(Filter)( 
   VECT_OP_TYPE*       y, 
   unsigned            yn, 
@@ -2967,6 +3054,458 @@ unsigned VECT_OP_FUNC(Kmeans2)(
   return iterCnt;
 }
 
+// Kmeans3() assignment state for one partition of the data points. 
+// The partitions are run as tasks on a cmThreadPool.
+typedef struct
+{
+  const VECT_OP_TYPE* (*srcFunc)(void* userPtr, unsigned frmIdx );
+  void*               userSrcPtr;
+  const VECT_OP_TYPE* centroidM;  // centroidM[D,K] current centroids
+  const double*       sV;         // sV[K] half the distance from each centroid to the nearest other centroid
+  const double*       pV;         // pV[K] distance each centroid moved on the last update
+  double              pMax;       // max(pV[])
+  double              p2nd;       // second largest value in pV[]
+  unsigned            pMaxIdx;    // index of pMax in pV[]
+  unsigned            D;
+  unsigned            K;
+  bool                boundsFl;   // false if uV[] and lV[] are not yet valid
+  unsigned*           classIdxV;  // classIdxV[N] 
+  double*             uV;         // uV[N] upper bound on the distance to the assigned centroid
+  double*             lV;         // lV[N] lower bound on the distance to any other centroid
+  unsigned            begIdx;     // first data point in this partition
+  unsigned            cnt;        // count of data points in this partition
+  unsigned            changeCnt;  // count of data points which changed class on the last pass
+  unsigned            distCnt;    // count of point-to-centroid distances calculated 
+} VECT_OP_FUNC(_KmPart_t);
+
+// Assign the data points in partition 't' to the nearest centroid. 
+// A data point is only compared to every centroid when Hamerly's bounds cannot
+// prove that its current centroid is still the nearest. The bounds are given
+// a small relative slack so that a pruned point is always assigned to the 
+// same centroid that the exhaustive search (DistVMM()) would select.
+void VECT_OP_FUNC(_KmAssign)( VECT_OP_FUNC(_KmPart_t)* t )
+{
+  const double slack  = sqrt(VECT_OP_EPSILON);
+  unsigned     endIdx = t->begIdx + t->cnt;
+  unsigned     i,j;
+
+  t->changeCnt = 0;
+  t->distCnt   = 0;
+
+  for(i=t->begIdx; i<endIdx; ++i)
+  {
+    const VECT_OP_TYPE* xV = t->srcFunc(t->userSrcPtr,i);
+    unsigned            a  = t->classIdxV[i];
+
+    if( xV == NULL )
+    {
+      t->classIdxV[i] = cmInvalidIdx;
+      continue;
+    }
+
+    if( t->boundsFl )
+    {
+      // update the bounds to account for the last centroid update
+      t->uV[i] += t->pV[a];
+      t->lV[i] -= a == t->pMaxIdx ? t->p2nd : t->pMax;
+
+      double m = cmMax(t->sV[a],t->lV[i]);
+
+      if( t->uV[i] * (1.0+slack) < m * (1.0-slack) )
+        continue;
+
+      // tighten the upper bound and test again
+      t->uV[i] = VECT_OP_FUNC(EuclidDistance)( t->centroidM + a*t->D, xV, t->D );
+      t->distCnt += 1;
+
+      if( t->uV[i] * (1.0+slack) < m * (1.0-slack) )
+        continue;
+    }
+
+    // find the closest (d0) and second closest (d1) centroid
+    VECT_OP_TYPE d0 = VECT_OP_MAX;
+    VECT_OP_TYPE d1 = VECT_OP_MAX;
+    unsigned     ki = cmInvalidIdx;
+
+    for(j=0; j<t->K; ++j)
+    {
+      VECT_OP_TYPE d = VECT_OP_FUNC(EuclidDistance)( t->centroidM + j*t->D, xV, t->D );
+
+      if( d < d0 || ki==cmInvalidIdx )
+      {
+        d1 = d0;
+        d0 = d;
+        ki = j;
+      }
+      else
+        if( d < d1 )
+          d1 = d;
+    }
+
+    t->distCnt     += t->K;
+    t->changeCnt   += ki != a;
+    t->classIdxV[i] = ki;
+    t->uV[i]        = d0;
+    t->lV[i]        = d1;
+  }
+}
+
+void VECT_OP_FUNC(_KmAssignTask)( void* arg, unsigned taskIdx )
+{
+  VECT_OP_FUNC(_KmAssign)( ((VECT_OP_FUNC(_KmPart_t)*)arg) + taskIdx );
+}
+
+// Select the initial centroids with the k-means++ algorithm.
+void VECT_OP_FUNC(_KmPlusPlusSeed)( VECT_OP_TYPE* centroidM, unsigned K, const VECT_OP_TYPE* (*srcFunc)(void* userPtr, unsigned frmIdx ), unsigned D, void* userSrcPtr, const unsigned* idxV, unsigned idxN )
+{
+  double*  dV = cmMemAlloc(double,idxN);  // dV[idxN] squared distance to the closest selected centroid
+  unsigned i,k;
+
+  // select the first centroid uniformly at random
+  VECT_OP_FUNC(Copy)( centroidM, D, srcFunc(userSrcPtr, idxV[ rand() % idxN ]) );
+
+  for(i=0; i<idxN; ++i)
+    dV[i] = DBL_MAX;
+
+  for(k=1; k<K; ++k)
+  {
+    double sum = 0;
+    double r;
+
+    // update the distance to the closest centroid with centroid k-1
+    for(i=0; i<idxN; ++i)
+    {
+      double d = VECT_OP_FUNC(EuclidDistance)( centroidM + (k-1)*D, srcFunc(userSrcPtr,idxV[i]), D );
+      dV[i] = cmMin(dV[i],d*d);
+      sum  += dV[i];
+    }
+
+    // select the next centroid with probability proportional to dV[]
+    r = sum * rand() / ((double)RAND_MAX + 1.0);
+
+    for(i=0; i<idxN-1; ++i)
+      if( (r -= dV[i]) < 0 )
+        break;
+
+    VECT_OP_FUNC(Copy)( centroidM + k*D, D, srcFunc(userSrcPtr,idxV[i]) );
+  }
+
+  cmMemFree(dV);
+}
+
+unsigned VECT_OP_FUNC(Kmeans3)( 
+  unsigned*           classIdxV,        
+  VECT_OP_TYPE*       centroidM,         
+  unsigned            K,                 
+  const VECT_OP_TYPE* (*srcFunc)(void* userPtr, unsigned frmIdx ),
+  unsigned            srn,              
+  unsigned            scn,               
+  void*               userSrcPtr,        
+  const bool*         roFlV,
+  int                 maxIterCnt,
+  int                 deltaStopCnt,
+  unsigned            flags,
+  unsigned            thCnt,
+  cmRpt_t*            rpt
+) 
+{
+  unsigned                 D       = srn;   // data dimensionality
+  unsigned                 N       = scn;   // count of data points to cluster
+  unsigned                 iterCnt = 0;
+  unsigned                 idxN    = 0;     // count of data points which are included in the clustering
+  unsigned*                idxV    = cmMemAlloc(unsigned,N);
+  VECT_OP_TYPE*            newM    = cmMemAlloc(VECT_OP_TYPE,D*K);
+  double*                  bV      = cmMemAlloc(double,2*N + 2*K);
+  double*                  uV      = bV;
+  double*                  lV      = uV + N;
+  double*                  sV      = lV + N;
+  double*                  pV      = sV + K;
+  unsigned*                nV      = cmMemAllocZ(unsigned,K);
+  VECT_OP_FUNC(_KmPart_t)* thV     = NULL;
+  cmThreadPoolH_t          poolH   = cmThreadPoolNullHandle;
+  unsigned                 begIdx  = 0;
+  unsigned                 i,j,k,ki;
+  const VECT_OP_TYPE*      sp;
+
+  deltaStopCnt = cmMax(0,deltaStopCnt);
+
+  // locate the data points which are included in the clustering
+  for(i=0; i<N; ++i)
+    if( srcFunc(userSrcPtr,i) != NULL )
+      idxV[idxN++] = i;
+
+  assert( K<=idxN );
+
+  if( cmIsFlag(flags,kRandSeedKmFl) )
+  {
+    // if the number of datapoints and the number of clusters is the same
+    // make the datapoints the centroids and return
+    if( K == idxN )
+    {
+      for(i=0,ki=0; i<N; ++i)
+        if((sp = srcFunc(userSrcPtr,i)) == NULL )
+          classIdxV[i] = cmInvalidIdx;
+        else
+        {
+          VECT_OP_FUNC(Copy)(centroidM+(ki*D),D,sp);
+          classIdxV[i] = ki++;
+        }
+      goto errLabel;
+    }
+
+    // select K unique datapoints at random as the initial centroids 
+    // (this selection is the same as Kmeans())
+    unsigned* kiV = cmMemAlloc( unsigned, N );
+
+    cmVOU_RandomSeq(kiV,N);
+  
+    for(i=0,ki=0; i<N && ki<K; ++i)
+      if((sp = srcFunc(userSrcPtr,kiV[i])) != NULL )
+        VECT_OP_FUNC(Copy)( centroidM + (ki++ * D), D, sp );
+  
+    cmMemPtrFree(&kiV);
+  }
+  else
+  {
+    if( cmIsFlag(flags,kPlusPlusSeedKmFl) )
+      VECT_OP_FUNC(_KmPlusPlusSeed)( centroidM, K, srcFunc, D, userSrcPtr, idxV, idxN );
+  }
+
+  // partition the data points between the threads
+  thCnt = cmMax(1,cmMin(thCnt,N));
+  thV   = cmMemAllocZ(VECT_OP_FUNC(_KmPart_t),thCnt);
+
+  for(i=0; i<thCnt; ++i)
+  {
+    VECT_OP_FUNC(_KmPart_t)* t = thV + i;
+
+    t->srcFunc    = srcFunc;
+    t->userSrcPtr = userSrcPtr;
+    t->centroidM  = centroidM;
+    t->sV         = sV;
+    t->pV         = pV;
+    t->D          = D;
+    t->K          = K;
+    t->classIdxV  = classIdxV;
+    t->uV         = uV;
+    t->lV         = lV;
+    t->begIdx     = begIdx;
+    t->cnt        = (N - begIdx) / (thCnt - i);
+    begIdx       += t->cnt;
+  }
+
+  // if the pool cannot be created the partitions are run on the calling thread
+  if( thCnt > 1 )
+    cmThreadPoolCreate(&poolH,thCnt-1,rpt);
+
+  while(1)
+  {
+    unsigned changeCnt = 0;
+
+    // sV[k] = half the distance from centroid k to the closest other centroid
+    for(k=0; k<K; ++k)
+      sV[k] = DBL_MAX;
+
+    for(k=0; k<K; ++k)
+      for(j=k+1; j<K; ++j)
+      {
+        double d = VECT_OP_FUNC(EuclidDistance)( centroidM + k*D, centroidM + j*D, D ) / 2;
+        sV[k] = cmMin(sV[k],d);
+        sV[j] = cmMin(sV[j],d);
+      }
+
+    // assign each data point to a cluster
+    if( cmThreadPoolIsValid(poolH) )
+      cmThreadPoolRun(poolH,VECT_OP_FUNC(_KmAssignTask),thV,thCnt);
+    else
+      for(i=0; i<thCnt; ++i)
+        VECT_OP_FUNC(_KmAssign)(thV + i);
+
+    for(i=0; i<thCnt; ++i)
+      changeCnt += thV[i].changeCnt;
+
+    // if the count of data points which changed classes is less than deltaStopCnt 
+    // then the centroids have converged
+    if( changeCnt <= deltaStopCnt )
+      break;
+
+    if( maxIterCnt!=-1 && iterCnt>=maxIterCnt )
+      break;
+
+    // track the number of interations required to converge
+    ++iterCnt;
+
+    // sum the all datapoints belonging to each class
+    // (in the same order as Kmeans() and Kmeans2() to produce identical centroids)
+    VECT_OP_FUNC(Zero)(newM,D*K);
+    cmVOU_Zero(nV,K);
+
+    for(i=0; i<idxN; ++i)
+    {
+      ki = classIdxV[ idxV[i] ];
+      
+      if( roFlV==NULL || roFlV[ki]==false )
+      {
+        VECT_OP_FUNC(AddVV)(newM + (ki*D), D, srcFunc(userSrcPtr,idxV[i]) );
+        ++nV[ki];
+      }
+    }
+
+    // update the centroids and track the distance each centroid moved 
+    for(k=0; k<K; ++k)
+    {
+      pV[k] = 0;
+
+      if( roFlV==NULL || roFlV[k]==false )
+      {
+        // convert the sum to a mean to form the centroid 
+        // (as in Kmeans() an empty cluster is moved to the origin)
+        if( nV[k] > 0 )
+          VECT_OP_FUNC(DivVS)(newM + (k*D), D, nV[k] );      
+
+        pV[k] = VECT_OP_FUNC(EuclidDistance)( centroidM + k*D, newM + k*D, D );
+
+        VECT_OP_FUNC(Copy)(centroidM + k*D, D, newM + k*D );
+      }
+    }
+
+    // the lower bounds are reduced by the largest movement of any other centroid
+    double   pMax    = 0;
+    double   p2nd    = 0;
+    unsigned pMaxIdx = cmInvalidIdx;
+
+    for(k=0; k<K; ++k)
+      if( pV[k] > pMax )
+      {
+        p2nd    = pMax;
+        pMax    = pV[k];
+        pMaxIdx = k;
+      }
+      else
+        if( pV[k] > p2nd )
+          p2nd = pV[k];
+
+    for(i=0; i<thCnt; ++i)
+    {
+      thV[i].boundsFl = true;
+      thV[i].pMax     = pMax;
+      thV[i].p2nd     = p2nd;
+      thV[i].pMaxIdx  = pMaxIdx;
+    }
+  } 
+
+ errLabel:
+  if( cmThreadPoolIsValid(poolH) )
+    cmThreadPoolDestroy(&poolH);
+
+  cmMemPtrFree(&thV);
+  cmMemPtrFree(&nV);
+  cmMemPtrFree(&bV);
+  cmMemPtrFree(&newM);
+  cmMemPtrFree(&idxV);
+
+  return iterCnt;
+}
+
+typedef struct
+{
+  const VECT_OP_TYPE* sM;      // sM[D,N]
+  unsigned            D;
+  const unsigned*     selIdxV; // selIdxV[N] (optional) 
+  unsigned            selKey;
+} VECT_OP_FUNC(_KmTestSrc_t);
+
+const VECT_OP_TYPE* VECT_OP_FUNC(_KmTestSrcFunc)( void* userPtr, unsigned frmIdx )
+{
+  const VECT_OP_FUNC(_KmTestSrc_t)* r = (const VECT_OP_FUNC(_KmTestSrc_t)*)userPtr;
+  return r->selIdxV==NULL || r->selIdxV[frmIdx]==r->selKey ? r->sM + frmIdx*r->D : NULL;
+}
+
+VECT_OP_TYPE VECT_OP_FUNC(_KmTestDistFunc)( void* userPtr, const VECT_OP_TYPE* s0V, const VECT_OP_TYPE* s1V, unsigned sn )
+{ return VECT_OP_FUNC(EuclidDistance)(s0V,s1V,sn); }
+
+void VECT_OP_FUNC(KmeansTest)( cmRpt_t* rpt )
+{
+  unsigned      D        = 20;    // feature vector dimensionality
+  unsigned      N        = 30000; // count of feature vectors (~6 minutes at 86 frames/sec)
+  unsigned      K        = 32;
+  unsigned      thCntV[] = { 1, 2, 4 };
+  unsigned      thN      = sizeof(thCntV)/sizeof(thCntV[0]);
+  VECT_OP_TYPE* sM       = cmMemAlloc(VECT_OP_TYPE,D*N);
+  VECT_OP_TYPE* c0M      = cmMemAlloc(VECT_OP_TYPE,D*K);
+  VECT_OP_TYPE* c1M      = cmMemAlloc(VECT_OP_TYPE,D*K);
+  VECT_OP_TYPE* initM    = cmMemAlloc(VECT_OP_TYPE,D*K);
+  unsigned*     c0V      = cmMemAlloc(unsigned,N);
+  unsigned*     c1V      = cmMemAlloc(unsigned,N);
+  unsigned      i,j,it0,it1;
+  cmTimeSpec_t  t0,t1;
+  unsigned      us0,us1;
+  VECT_OP_FUNC(_KmTestSrc_t) r = { sM, D, NULL, 0 };
+
+  // generate N points around K randomly located, overlapping, clusters
+  srand(1);
+  VECT_OP_FUNC(Random)(initM,D*K,-1,1);
+  for(i=0; i<N; ++i)
+  {
+    const VECT_OP_TYPE* cV = initM + (rand() % K)*D;
+    for(j=0; j<D; ++j)
+      sM[i*D+j] = cV[j] + (VECT_OP_TYPE)(2.0 * rand() / RAND_MAX - 1.0);
+  }
+
+  // Kmeans() vs Kmeans3() from the same random seed
+  srand(2);
+  cmVOU_Fill(c0V,N,cmInvalidIdx);
+  cmTimeGetMonotonic(&t0);
+  it0 = VECT_OP_FUNC(Kmeans)(c0V,c0M,K,sM,D,N,NULL,0,false,VECT_OP_FUNC(_KmTestDistFunc),NULL);
+  cmTimeGetMonotonic(&t1);
+  us0 = cmTimeElapsedMicros(&t0,&t1);
+
+  for(i=0; i<thN; ++i)
+  {
+    srand(2);
+    cmVOU_Fill(c1V,N,cmInvalidIdx);
+    cmTimeGetMonotonic(&t0);
+    it1 = VECT_OP_FUNC(Kmeans3)(c1V,c1M,K,VECT_OP_FUNC(_KmTestSrcFunc),D,N,&r,NULL,-1,0,kRandSeedKmFl,thCntV[i],rpt);
+    cmTimeGetMonotonic(&t1);
+    us1 = cmTimeElapsedMicros(&t0,&t1);
+
+    cmRptPrintf(rpt,"Kmeans  N:%i D:%i K:%i threads:%i iter:%i/%i %8i us %8i us identical:%s\n",N,D,K,thCntV[i],it1,it0,us1,us0,
+      memcmp(c0V,c1V,N*sizeof(unsigned))==0 && memcmp(c0M,c1M,D*K*sizeof(VECT_OP_TYPE))==0 ? "yes" : "no");
+  }
+
+  // Kmeans2() vs Kmeans3() from the same starting centroids
+  VECT_OP_FUNC(Copy)(c0M,D*K,initM);
+  cmVOU_Zero(c0V,N);
+  cmTimeGetMonotonic(&t0);
+  it0 = VECT_OP_FUNC(Kmeans2)(c0V,c0M,K,VECT_OP_FUNC(_KmTestSrcFunc),D,N,&r,VECT_OP_FUNC(_KmTestDistFunc),NULL,-1,0);
+  cmTimeGetMonotonic(&t1);
+  us0 = cmTimeElapsedMicros(&t0,&t1);
+
+  VECT_OP_FUNC(Copy)(c1M,D*K,initM);
+  cmVOU_Zero(c1V,N);
+  cmTimeGetMonotonic(&t0);
+  it1 = VECT_OP_FUNC(Kmeans3)(c1V,c1M,K,VECT_OP_FUNC(_KmTestSrcFunc),D,N,&r,NULL,-1,0,0,1,rpt);
+  cmTimeGetMonotonic(&t1);
+  us1 = cmTimeElapsedMicros(&t0,&t1);
+
+  cmRptPrintf(rpt,"Kmeans2 N:%i D:%i K:%i threads:1 iter:%i/%i %8i us %8i us identical:%s\n",N,D,K,it1,it0,us1,us0,
+    memcmp(c0V,c1V,N*sizeof(unsigned))==0 && memcmp(c0M,c1M,D*K*sizeof(VECT_OP_TYPE))==0 ? "yes" : "no");
+
+  // k-means++ seeding
+  srand(2);
+  cmTimeGetMonotonic(&t0);
+  it1 = VECT_OP_FUNC(Kmeans3)(c1V,c1M,K,VECT_OP_FUNC(_KmTestSrcFunc),D,N,&r,NULL,-1,0,kPlusPlusSeedKmFl,1,rpt);
+  cmTimeGetMonotonic(&t1);
+  cmRptPrintf(rpt,"Kmeans++ iter:%i %8i us\n",it1,cmTimeElapsedMicros(&t0,&t1));
+
+  cmMemFree(sM);
+  cmMemFree(c0M);
+  cmMemFree(c1M);
+  cmMemFree(initM);
+  cmMemFree(c0V);
+  cmMemFree(c1V);
+}
+
 /// stateV[timeN]
 /// a[stateN,stateN], 
 /// b[stateN,timeN]
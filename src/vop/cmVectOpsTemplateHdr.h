@@ -545,6 +545,16 @@ VECT_OP_TYPE*	VECT_OP_FUNC(GaussWin)( VECT_OP_TYPE* dbp, unsigned dn, double arg
 // 
 VECT_OP_TYPE* VECT_OP_FUNC(Filter)( VECT_OP_TYPE* y, unsigned yn, const VECT_OP_TYPE* x, unsigned xn, cmReal_t b0, const cmReal_t* b, const cmReal_t* a,  cmReal_t* d, unsigned dn );
 
+// Block FIR filter: y[i] = sum(hr[k] * x[i+k]) for k=0:hn-1  i=0:yn-1
+// x[yn+hn-1] is the input signal preceded by hn-1 samples of history.
+// hr[hn] is the time reversed impulse response.
+// The float and double versions use the SIMD kernels (cmVectOpsSimd.h).
+VECT_OP_TYPE* VECT_OP_FUNC(FirVV)( VECT_OP_TYPE* y, unsigned yn, const VECT_OP_TYPE* x, const VECT_OP_TYPE* hr, unsigned hn );
+
+// Apply FirVV() to chCnt channels with a single pass over the coefficients. 
+// Channel c reads x[c*xStride:c*xStride+yn+hn-1] and writes y[c*yStride:c*yStride+yn].
+VECT_OP_TYPE* VECT_OP_FUNC(FirMC)( VECT_OP_TYPE* y, unsigned yn, unsigned yStride, const VECT_OP_TYPE* x, unsigned xStride, unsigned chCnt, const VECT_OP_TYPE* hr, unsigned hn );
+
 struct cmFilter_str;
 //typedef cmRC_t (*VECT_OP_FUNC(FiltExecFunc_t))( struct acFilter_str* f,  const VECT_OP_TYPE* x, unsigned xn, VECT_OP_TYPE* y, unsigned yn );
 VECT_OP_TYPE* VECT_OP_FUNC(FilterFilter)(struct cmFilter_str* f, cmRC_t (*func)( struct cmFilter_str* f,  const VECT_OP_TYPE* x, unsigned xn, VECT_OP_TYPE* y, unsigned yn ), const cmReal_t bb[], unsigned bn, const cmReal_t aa[], unsigned an, const VECT_OP_TYPE* x, unsigned xn, VECT_OP_TYPE* y, unsigned yn );
@@ -653,6 +663,40 @@ unsigned VECT_OP_FUNC(Kmeans2)(
   int                iterCnt,            // max. number of iterations (-1 to ignore)
   int                deltaStopCnt);      // if less than deltaStopCnt data points change classes on a given iteration then convergence occurs.
 
+// Accelerated version of Kmeans2() for the Euclidean distance.
+// Hamerly's bounds (an upper bound on the distance to the assigned centroid and a lower
+// bound on the distance to every other centroid) allow most data points to skip the 
+// search over all K centroids once the clustering starts to settle. The assignment
+// step may be divided between 'thCnt' threads. The centroids are updated on the 
+// calling thread in data point order. Given the same starting centroids the result 
+// is identical to Kmeans2() and, with kRandSeedKmFl set and the same random seed, 
+// identical to Kmeans(). 
+// On input classIdxV[] holds the previous assignment. It is only used to count the
+// changes on the first iteration. On output the points for which srcFunc() returns 
+// NULL are assigned cmInvalidIdx.
+// Centroids flagged in roFlV[K] (optional) are not updated. 
+// If kRandSeedKmFl is set K random data points are selected as the starting centroids 
+// (as in Kmeans()), if kPlusPlusSeedKmFl is set the k-means++ algorithm is used to select 
+// the starting centroids otherwise the starting centroids are taken from centroidM[].
+// Returns the count of iterations.
+unsigned VECT_OP_FUNC(Kmeans3)( 
+  unsigned*           classIdxV,         // classIdxV[scn] - data point class assignments
+  VECT_OP_TYPE*       centroidM,         // centroidM[srn,K] - cluster centroids
+  unsigned            K,                 // count of clusters
+  const VECT_OP_TYPE* (*srcFunc)(void* userPtr, unsigned frmIdx ),
+  unsigned            srn,               // dimensionality of each data point
+  unsigned            scn,               // count of data points
+  void*               userSrcPtr,        // callback data for srcFunc (must be thread-safe if thCnt > 1)
+  const bool*         roFlV,             // roFlV[K] read-only centroid flags (optional)
+  int                 maxIterCnt,        // max. number of iterations (-1 to ignore)
+  int                 deltaStopCnt,      // if less than deltaStopCnt data points change classes on a given iteration then convergence occurs.
+  unsigned            flags,             // See kXXXKmFl
+  unsigned            thCnt,             // count of threads used for the assignment step
+  cmRpt_t*            rpt );             // report thread pool errors (optional)
+
+// Compare Kmeans3() to Kmeans() and Kmeans2() and time them on feature-file-sized data.
+void VECT_OP_FUNC(KmeansTest)( cmRpt_t* rpt );
+
 // Determine the most likely state sequece stateV[timeN] given a 
 // transition matrix a[stateN,stateN], 
 // observation probability matrix b[stateN,timeN] and 
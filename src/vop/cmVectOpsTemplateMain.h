@@ -10,6 +10,7 @@
 #define VECT_OP_MIN        FLT_MIN
 #define VECT_OP_LAP_FUNC(F)        s##F
 #define VECT_OP_BLAS_FUNC(F) cblas_s##F
+#define VECT_OP_SIMD(F)      cmVsF_##F
 
 #include "cmVectOpsTemplateHdr.h"
 #include "cmVectOpsTemplateCode.h"
@@ -26,6 +27,7 @@
 #define VECT_OP_MIN     DBL_MIN
 #define VECT_OP_LAP_FUNC(F)        d##F
 #define VECT_OP_BLAS_FUNC(F) cblas_d##F
+#define VECT_OP_SIMD(F)      cmVsD_##F
 
 #include "cmVectOpsTemplateHdr.h"
 #include "cmVectOpsTemplateCode.h"
@@ -44,9 +46,11 @@
 #if CM_FLOAT_SMP == 1
 #define VECT_OP_LAP_FUNC(F)        s##F
 #define VECT_OP_BLAS_FUNC(F) cblas_s##F
+#define VECT_OP_SIMD(F)      cmVsF_##F
 #else
 #define VECT_OP_LAP_FUNC(F)        d##F
 #define VECT_OP_BLAS_FUNC(F) cblas_d##F
+#define VECT_OP_SIMD(F)      cmVsD_##F
 #endif
 
 #include "cmVectOpsTemplateHdr.h"
@@ -65,9 +69,11 @@
 #if CM_FLOAT_REAL == 1
 #define VECT_OP_LAP_FUNC(F)        s##F
 #define VECT_OP_BLAS_FUNC(F) cblas_s##F
+#define VECT_OP_SIMD(F)      cmVsF_##F
 #else
 #define VECT_OP_LAP_FUNC(F)        d##F
 #define VECT_OP_BLAS_FUNC(F) cblas_d##F
+#define VECT_OP_SIMD(F)      cmVsD_##F
 #endif
 
 #include "cmVectOpsTemplateHdr.h"
@@ -38,3 +38,7 @@
 #ifdef VECT_OP_BLAS_FUNC
 #undef VECT_OP_BLAS_FUNC
 #endif
+
+#ifdef VECT_OP_SIMD
+#undef VECT_OP_SIMD
+#endif